@@ -108,6 +108,7 @@
 * @property {module:qm~StreamAggrVecDiff} vec-diff - The difference of two vectors (e.g. online histograms) type.
 * @property {module:qm~StreamAggrSimpleLinearRegression} lin-reg - The linear regressor type.
 * @property {module:qm~StreamAggrAnomalyDetectorNN} detector-nn - The anomaly detector type. Detects anomalies using the k nearest neighbour algorithm.
+* @property {module:qm~StreamAggrOnlineKMeans} online-kmeans - The online KMeans type. Clusters the incoming vectors with the mini-batch KMeans algorithm.
 * @property {module:qm~StreamAggrThreshold} treshold - The threshold indicator type.
 * @property {module:qm~StreamAggrTDigest} tdigest - The quantile estimator type. It estimates the quantiles of the given data using {@link module:analytics.TDigest TDigest}.
 * @property {module:qm~StreamAggrRecordSwitch} record-switch-aggr - The record switch type.
@@ -1224,6 +1225,61 @@
 * base.close();
 */
 /**
+* @typedef {module:qm.StreamAggr} StreamAggrOnlineKMeans
+* This stream aggregator clusters the incoming vectors with the mini-batch KMeans algorithm (see {@link module:analytics.KMeans#partialFit}).
+* Each new vector moves its closest centroid towards itself, so the centroids follow the stream without refitting. The first `k` vectors
+* become the initial centroids. It connects to a {@link module:qm~StreamAggrFeatureSpace} or to a buffer of sparse vectors, such as the
+* `'timeSeriesWinBufFeatureSpace'` aggregator, where all the vectors that entered the window are used as one batch.
+* It implements the following methods:
+* <br>1. {@link module:qm.StreamAggr#getInteger} returns the cluster of the last vector, or -1 before the first vector.
+* <br>2. {@link module:qm.StreamAggr#saveJson} returns the Json with the centroids, their (decayed) sizes and the last cluster.
+* @property {string} name - The given name for the stream aggregator.
+* @property {string} type - The type of the stream aggregator. <b>Important:</b> It must be equal to `'onlineKMeans'`.
+* @property {string} inAggr - The name of the stream aggregator to which it connects and gets the vectors.
+* @property {number} [k=2] - The number of centroids.
+* @property {number} [decay=1] - The factor the cluster sizes are multiplied with before each update. Values below 1 forget the old vectors.
+* @property {string} [distanceType="Euclid"] - The distance type. Possible options are `'Euclid'` and `'Cos'`.
+* @example
+* // import the qm module
+* var qm = require('qminer');
+* // create a base with a simple store named Points with 2 fields
+* var base = new qm.Base({
+*     mode: 'createClean',
+*     schema: [{
+*         name: 'Points',
+*         fields: [
+*             { name: 'X', type: 'float' },
+*             { name: 'Y', type: 'float' }
+*         ]
+*     }]
+* });
+* // define a feature space aggregator on the Points store
+* var ftrSpaceAggr = base.store('Points').addStreamAggr({
+*     name: 'ftrSpaceAggr',
+*     type: 'featureSpace',
+*     update: false,
+*     featureSpace: [
+*         { type: 'numeric', source: 'Points', field: 'X' },
+*         { type: 'numeric', source: 'Points', field: 'Y' }
+*     ]
+* });
+* // cluster the feature vectors into two clusters and slowly forget the old points
+* var kmeans = base.store('Points').addStreamAggr({
+*     name: 'kmeansAggr',
+*     type: 'onlineKMeans',
+*     inAggr: 'ftrSpaceAggr',
+*     k: 2,
+*     decay: 0.99
+* });
+* // add some records
+* base.store('Points').push({ X: 0, Y: 0 });
+* base.store('Points').push({ X: 10, Y: 10 });
+* base.store('Points').push({ X: 9, Y: 11 });
+* // get the cluster of the last record
+* var cluster = kmeans.getInteger();
+* base.close();
+*/
+/**
 * @typedef {module:qm.StreamAggr} StreamAggrHistogram
 * This stream aggregator represents an online histogram. It can connect to a buffered aggregate (such as {@link module:qm~StreamAggrTimeSeriesWindow})
 * or a time series (such as {@link module:qm~StreamAggregateEMA}).
@@ -95,6 +95,7 @@
 * <br>2. `'createClean'` - Cleans db folder and then sets it up,
 * <br>3. `'open'` - Opens the db with read/write permissions,
 * <br>4. `'openReadOnly'` - Opens the db in read only mode.
+* <br>5. `'restore'` - Opens the db after it was not closed, for example after a crash. Stores with `write_log` option get back the changes from their log and can be updated, the rest is as it was when the db was last closed.
 * @property  {number} [indexCache=1024] - The ammount of memory reserved for indexing (in MB).
 * @property  {number} [storeCache=1024] - The ammount of memory reserved for store cache (in MB).
 * @property  {string} [schemaPath=''] - The path to schema definition file.
@@ -275,6 +275,9 @@ TGBlobBs::TGBlobBs(
     GetFFreeBlobPtV(FBlobBs, FFreeBlobPtV);
   }
   FirstBlobPt=TBlobPt(FBlobBs->GetFPos());
+  // free lists are saved only when closing, so they are stale after a crash
+  if (Access==faRestore){
+    RestoreFFreeBlobPtV();}
   FBlobBs->Flush();
 }
 
@@ -291,6 +294,34 @@ TGBlobBs::~TGBlobBs(){
   FBlobBs=NULL;
 }
 
+void TGBlobBs::RestoreFFreeBlobPtV(){
+  GenFFreeBlobPtV(BlockLenV, FFreeBlobPtV);
+  // BLOB states are written in place, so walk over all BLOBs and link free ones
+  const uint FLen=uint(FBlobBs->GetFLen());
+  uint BlobAddr=FirstBlobPt.GetAddr();
+  forever {
+    // begin tag, buffer length, state and content length or next free BLOB
+    const uint HdLen=sizeof(uint)+sizeof(int)+sizeof(char)+sizeof(uint);
+    if (BlobAddr+HdLen>FLen){break;}
+    FBlobBs->SetFPos(BlobAddr);
+    if (FBlobBs->GetUInt()!=GetBeginBlobTag()){break;}
+    const int MxBfL=FBlobBs->GetInt();
+    const TBlobState BlobState=GetBlobState(FBlobBs);
+    // last BLOB can be only partially written
+    const uint BlobLen=HdLen+uint(MxBfL)+sizeof(TCs)+sizeof(uint);
+    if ((MxBfL<0)||(BlobAddr+BlobLen>FLen)){break;}
+    if (BlobState==bsFree){
+      int _MxBfL; int FFreeBlobPtN;
+      GetAllocInfo(MxBfL, BlockLenV, _MxBfL, FFreeBlobPtN);
+      FFreeBlobPtV[FFreeBlobPtN].SaveAddr(FBlobBs);
+      FFreeBlobPtV[FFreeBlobPtN]=TBlobPt(BlobAddr);
+    } else if (BlobState!=bsActive){
+      break;
+    }
+    BlobAddr+=BlobLen;
+  }
+}
+
 TBlobPt TGBlobBs::PutBlob(const PSIn& SIn){
   EAssert((Access==faCreate)||(Access==faUpdate)||(Access==faRestore));
   int BfL=SIn->Len();
@@ -183,6 +183,8 @@ private:
   TBlobPt FirstBlobPt;
   static TStr GetNrBlobBsFNm(const TStr& BlobBsFNm);
   TBlobBsStats Stats;
+  /// rebuild list of free blob pointers from the states of BLOBs
+  void RestoreFFreeBlobPtV();
 public:
   TGBlobBs(const TStr& BlobBsFNm, const TFAccess& _Access=faRdOnly,
    const int& _MxSegLen=-1);
@@ -587,15 +587,15 @@ public:
   TIter GetI(const TSizeTy& ValN) const {return ValT+ValN;}
 
   /// Adds a new element at the end of the vector, after its current last element. ##TVec::Add
-  TSizeTy Add(){ AssertR(MxVals!=-1, "This vector was obtained from TVecPool. Such a vector cannot change its size!");
+  TSizeTy Add(){ EAssertR(MxVals!=-1, "This vector was obtained from TVecPool. Such a vector cannot change its size!");
     if (Vals==MxVals){Resize();} return Vals++;}
   /// Adds a new element at the end of the vector, after its current last element. ##TVec::Add1
-  TSizeTy Add(const TVal& Val){ AssertR(MxVals!=-1, "This vector was obtained from TVecPool. Such a vector cannot change its size!");
+  TSizeTy Add(const TVal& Val){ EAssertR(MxVals!=-1, "This vector was obtained from TVecPool. Such a vector cannot change its size!");
     if (Vals==MxVals){Resize();} ValT[Vals]=Val; return Vals++;}
-  TSizeTy Add(TVal& Val){ AssertR(MxVals!=-1, "This vector was obtained from TVecPool. Such a vector cannot change its size!");
+  TSizeTy Add(TVal& Val){ EAssertR(MxVals!=-1, "This vector was obtained from TVecPool. Such a vector cannot change its size!");
     if (Vals==MxVals){Resize();} ValT[Vals]=Val; return Vals++;}
   /// Adds element \c Val at the end of the vector. #TVec::Add2
-  TSizeTy Add(const TVal& Val, const TSizeTy& ResizeLen){ AssertR(MxVals!=-1, "This vector was obtained from TVecPool. Such a vector cannot change its size!");
+  TSizeTy Add(const TVal& Val, const TSizeTy& ResizeLen){ EAssertR(MxVals!=-1, "This vector was obtained from TVecPool. Such a vector cannot change its size!");
     if (Vals==MxVals){Resize(MxVals+ResizeLen);} ValT[Vals]=Val; return Vals++;}
   /// Adds the elements of the vector \c ValV to the to end of the vector.
   TSizeTy AddV(const TVec<TVal, TSizeTy>& ValV);
@@ -1407,6 +1407,10 @@ public:
         VVec.XDim = (RowEnd - RowStart + 1);
         VVec.YDim = YDim;
     }
+    /// Uses external memory of XDim*YDim values (not freed by the matrix)
+    void GenExt(TVal *_ValT, const TSizeTy& _XDim, const TSizeTy& _YDim){
+        XDim = _XDim; YDim = _YDim; ValV.GenExt(_ValT, XDim*YDim); ColMajor = colmajor;
+    }
     explicit TVVec(TSIn& SIn) { Load(SIn); }
     void Load(TSIn& SIn){
         SIn.Load(XDim);
@@ -32,6 +32,22 @@ public:
     /// Is Item1 <= Item2?
     virtual bool IsLtE(const TItem& Item1, const TItem& Item2) const = 0;
 
+    /// Are child vectors stored in a packed (compressed) encoding? When true, item sets
+    /// keep only the packed bytes of children that are needed for reading and decode
+    /// them directly into the query result.
+    virtual bool IsPacked() const { return false; }
+    /// Serialize child vector. Default is plain vector serialization.
+    virtual void SaveItemV(const TVec<TItem>& ItemV, TSOut& SOut) const { ItemV.Save(SOut); }
+    /// Deserialize child vector and append its items to ItemV
+    virtual void LoadItemV(TSIn& SIn, TVec<TItem>& ItemV) const {
+        if (ItemV.Empty()) { ItemV.Load(SIn); } else { TVec<TItem> _ItemV(SIn); ItemV.AddV(_ItemV); } }
+
+    /// Do items carry weights? When true, item sets keep the largest weight of each
+    /// child vector in the item-set header, which can be used for bounding scores.
+    virtual bool IsWgt() const { return false; }
+    /// Weight of the item (e.g. frequency), only called when IsWgt() is true
+    virtual int GetItemWgt(const TItem& Item) const { return 0; }
+
     /// Memory footprint
     virtual uint64 GetMemUsed() const = 0;
 };
@@ -89,22 +105,28 @@ private:
         TItem MaxItem;
         /// Number of elements in the vector
         TInt Len;
+        /// Upper bound on item weights in the vector (TInt::Mx when items have no weights).
+        /// Serialized by the item set, and only when item handler has weights.
+        TInt MxWgt;
         /// Pointer to the vector in the blob base
         TBlobPt Pt;
         /// Did we load the vector from blob base to memory?
         TBool LoadedP;
         /// Is the version of vector in the memory different to the one in blob base?
         TBool DirtyP;
+        /// Packed content of the vector, kept instead of the decoded vector when only
+        /// reading from packed gix. Not serialized, always empty when LoadedP is true.
+        TMem PackMem;
 
     public:
         /// Empty child vector info
-        TChildInfo(): Len(0), LoadedP(false), DirtyP(false) {}
+        TChildInfo(): Len(0), MxWgt(TInt::Mx), LoadedP(false), DirtyP(false) {}
         /// Create non-emtpy child vector info
         TChildInfo(const TItem& _MinItem, const TItem& _MaxItem, const TInt& _Len, const TBlobPt& _Pt):
-            MinItem(_MinItem), MaxItem(_MaxItem), Len(_Len), Pt(_Pt), LoadedP(false), DirtyP(false) {}
+            MinItem(_MinItem), MaxItem(_MaxItem), Len(_Len), MxWgt(TInt::Mx), Pt(_Pt), LoadedP(false), DirtyP(false) {}
 
         /// Load child info from stream
-        TChildInfo(TSIn& SIn): LoadedP(false), DirtyP(false) { Load(SIn); }
+        TChildInfo(TSIn& SIn): MxWgt(TInt::Mx), LoadedP(false), DirtyP(false) { Load(SIn); }
         /// Save child info to stream
         void Load(TSIn& SIn);
         /// serialize to stream
@@ -145,6 +167,8 @@ private:
     void LoadChildVector(const int& ChildN) const;
     /// Load all child vectors into memory and get pointers to them
     void LoadChildVectors() const;
+    /// Get largest item weight in the vector, or TInt::Mx when items have no weights
+    int GetMxWgt(const TVec<TItem>& _ItemV) const;
     /// Refresh total count
     void RecalcTotalCnt();
     /// Check if there are any dirty child vectors with size outside the tolerance
@@ -160,6 +184,8 @@ private:
     void PushMergedDataBackToChildren(const int& FirstChildToMerge, const TVec<TItem>& MergedItems);
     /// Process any pending "delete" commands
     void ProcessDeletes();
+    /// Check if items are sorted and all come after the items already in the itemset
+    bool IsAppendV(const TVec<TItem>& NewItemV) const;
 
     /// Ask child vectors about their memory usage
     uint64 GetChildMemUsed() const { return TMemUtils::GetExtraMemberSize(ChildV); }
@@ -192,8 +218,10 @@ public:
     /// Add new item to the item set. When NotifyCacheOnlyDelta is set to true,
     /// only item set memory footprint differences are sent to gix.
     void AddItem(const TItem& NewItem, const bool& NotifyCacheOnlyDelta = true);
-    /// Add a set of items at once
-    void AddItemV(const TVec<TItem>& NewItemV);
+    /// Add a set of items at once. NotifyCacheOnlyDelta has the same meaning as in AddItem.
+    /// Sorted items that come after all existing ones are appended without merging,
+    /// and full child vectors are written out straight away.
+    void AddItemV(const TVec<TItem>& NewItemV, const bool& NotifyCacheOnlyDelta = true);
 
     /// Check if this itemset is empty
     bool Empty() const { return GetItems() == 0; }
@@ -205,6 +233,21 @@ public:
     void GetItemV(TVec<TItem>& _ItemV);
     /// Go over all children and working buffer and pass it to HandleItemV function
     template <typename THandler> void GetItemV(THandler& Handler);
+    /// Get items into vector, but only from child vectors for which ChildFilter(MinItem, MaxItem)
+    /// returns true. Other child vectors are skipped without loading them from disk.
+    template <typename TChildFilter> void GetItemV(TVec<TItem>& _ItemV, TChildFilter& ChildFilter);
+    /// Get number of child vectors
+    int GetChildVecs() const { return ChildInfoV.Len(); }
+    /// Get the largest item from a child vector, without loading it
+    const TItem& GetChildMaxItem(const int& ChildN) const { return ChildInfoV[ChildN].MaxItem; }
+    /// Get upper bound on item weights in a child vector, without loading it
+    int GetChildMxWgt(const int& ChildN) const { return ChildInfoV[ChildN].MxWgt; }
+    /// Append items of a child vector to ItemV. For packed item handlers the child is decoded
+    /// straight from its packed content, without keeping the decoded vector in memory.
+    void GetChildItemV(const int& ChildN, TVec<TItem>& _ItemV) const;
+    /// Get items from working buffer, which follow all the items from child vectors.
+    /// Only valid after the itemset is merged (see Def).
+    const TVec<TItem>& GetWorkItemV() const { return ItemV; }
     /// Delete specified item from this itemset
     void DelItem(const TItem& Item);
     /// Clear all items from this itemset
@@ -337,6 +380,8 @@ private:
 
     /// Load child vector for given blob pointer from disk
     void GetChildVector(const TBlobPt& Pt, TVec<TItem>& Dest) const;
+    /// Load serialized child vector for given blob pointer from disk, without decoding it
+    void GetChildPack(const TBlobPt& Pt, TMem& Dest) const;
     /// Store child vectors to disk and get back pointer to where it was stored.
     TBlobPt StoreChildVector(const TBlobPt& ExistingKeyId, const TVec<TItem>& Data) const;
     /// Delete child vectors from cache and disk
@@ -385,6 +430,8 @@ public:
     PGixItemSet GetItemSet(const TBlobPt& Pt) const;
     /// Get items for given key
     void GetItemV(const TKey& Key, TVec<TItem>& ItemV) const;
+    /// Get number of items for given key
+    int GetItems(const TKey& Key) const { return IsKey(Key) ? GetItemSet(Key)->GetItems() : 0; }
     /// Go over all children and working buffer and pass it to HandleItemV function
     template <typename THandler> void GetItemV(const TKey& Key, THandler& Handler) const;
     /// for storing item sets from cache to blob
@@ -400,6 +447,8 @@ public:
     void AddItemV(const TKey& Key, const TVec<TItem>& ItemV);
     // delete one item
     void DelItem(const TKey& Key, const TItem& Item);
+    // delete a set of items, loading the itemset only once
+    void DelItemV(const TKey& Key, const TVec<TItem>& ItemV);
     /// clears items
     void Clr(const TKey& Key);
     /// flush all data from cache to disk
@@ -473,6 +522,12 @@ public:
     /// Initialize vector of items for given key.
     virtual void Def(const TKey& Key, TVec<TItem>& MainV, TVec<TResItem>& ResV) const = 0;
 
+    /// Is Item before ResItem in the result ordering? Used to skip child vectors that cannot
+    /// intersect with already computed results. Default never skips.
+    virtual bool IsLtRes(const TItem& Item, const TResItem& ResItem) const { return false; }
+    /// Is ResItem before Item in the result ordering? Default never skips.
+    virtual bool IsResLt(const TResItem& ResItem, const TItem& Item) const { return false; }
+
     /// Memory footprint
     virtual uint64 GetMemUsed() const = 0;
 };
@@ -527,6 +582,10 @@ private:
     void PutAnd(const PGixExpItem& _LeftExpItem, const PGixExpItem& _RightExpItem);
     /// Convert expression item to OR
     void PutOr(const PGixExpItem& _LeftExpItem, const PGixExpItem& _RightExpItem);
+    /// Evaluate key expression item, reading only child vectors that can
+    /// contain items from FilterItemV. Result still needs to be intersected.
+    void EvalKey(const PGix& Gix, TVec<TResItem>& ResItemV,
+        const TGixMerger<TKey, TItem, TResItem>* Merger, const TVec<TResItem>& FilterItemV);
 
     TGixExpItem(const TGixExpType& _ExpType, const PGixExpItem& _LeftExpItem,
         const PGixExpItem& _RightExpItem) : ExpType(_ExpType),
@@ -567,6 +626,9 @@ public:
     TKey GetKey() const { return Key; }
     /// Clone expression item
     PGixExpItem Clone() const { return new TGixExpItem(*this); }
+    /// Estimate number of items matched by the expression, used to order evaluation
+    /// of AND operands. Negations match almost everything and estimate to TInt::Mx.
+    int GetItems(const PGix& Gix) const;
 
     /// Evaluate expression item using given merger and return mathed items
     bool Eval(const PGix& Gix, TVec<TResItem>& ResItemV, const TGixMerger<TKey, TItem, TResItem>* Merger);
@@ -22,16 +22,26 @@ uint64 TGixItemSet<TKey, TItem>::TChildInfo::GetMemUsed() const {
         TMemUtils::GetExtraMemberSize(MinItem) +
         TMemUtils::GetExtraMemberSize(MaxItem) +
         TMemUtils::GetExtraMemberSize(Len) +
+        TMemUtils::GetExtraMemberSize(MxWgt) +
         TMemUtils::GetExtraMemberSize(Pt) +
         TMemUtils::GetExtraMemberSize(LoadedP) +
-        TMemUtils::GetExtraMemberSize(DirtyP);
+        TMemUtils::GetExtraMemberSize(DirtyP) +
+        (uint64)PackMem.Len();
 }
 
 template <class TKey, class TItem>
 void TGixItemSet<TKey, TItem>::LoadChildVector(const int& ChildN) const {
     if (!ChildInfoV[ChildN].LoadedP) {
-        // load child vector from disk
-        Gix->GetChildVector(ChildInfoV[ChildN].Pt, ChildV[ChildN]);
+        if (ChildInfoV[ChildN].PackMem.Len() > 0) {
+            // decode child vector from packed content we already have in memory
+            TThinMIn PackSIn(ChildInfoV[ChildN].PackMem);
+            ChildV[ChildN].Clr();
+            Gix->GetItemHandler()->LoadItemV(PackSIn, ChildV[ChildN]);
+            ChildInfoV[ChildN].PackMem.Clr();
+        } else {
+            // load child vector from disk
+            Gix->GetChildVector(ChildInfoV[ChildN].Pt, ChildV[ChildN]);
+        }
         // mark that it is freshly loaded
         ChildInfoV[ChildN].LoadedP = true;
         ChildInfoV[ChildN].DirtyP = false;
@@ -45,6 +55,31 @@ void TGixItemSet<TKey, TItem>::LoadChildVectors() const {
     }
 }
 
+template <class TKey, class TItem>
+void TGixItemSet<TKey, TItem>::GetChildItemV(const int& ChildN, TVec<TItem>& _ItemV) const {
+    TChildInfo& ChildInfo = ChildInfoV[ChildN];
+    if (ChildInfo.LoadedP || !Gix->GetItemHandler()->IsPacked()) {
+        // plain child vectors are kept decoded in memory
+        LoadChildVector(ChildN);
+        _ItemV.AddV(ChildV[ChildN]);
+    } else {
+        // keep only packed content in memory and decode it directly into the result
+        if (ChildInfo.PackMem.Len() == 0) { Gix->GetChildPack(ChildInfo.Pt, ChildInfo.PackMem); }
+        TThinMIn PackSIn(ChildInfo.PackMem);
+        Gix->GetItemHandler()->LoadItemV(PackSIn, _ItemV);
+    }
+}
+
+template <class TKey, class TItem>
+int TGixItemSet<TKey, TItem>::GetMxWgt(const TVec<TItem>& _ItemV) const {
+    if (!Gix->GetItemHandler()->IsWgt()) { return TInt::Mx; }
+    int MxWgt = 0;
+    for (const TItem& Item : _ItemV) {
+        MxWgt = TInt::GetMx(MxWgt, Gix->GetItemHandler()->GetItemWgt(Item));
+    }
+    return MxWgt;
+}
+
 template <class TKey, class TItem>
 void TGixItemSet<TKey, TItem>::RecalcTotalCnt() {
     TotalCnt = ItemV.Len();
@@ -100,6 +135,7 @@ void TGixItemSet<TKey, TItem>::PushWorkBufferToChildren() {
         ItemV.GetSubValV(0, SplitLen - 1, SplitItemV);
         // create the child info for the vector and also push the vector to a blob
         TChildInfo ChildInfo(SplitItemV[0], SplitItemV.Last(), SplitLen, Gix->EnlistChildVector(SplitItemV));
+        ChildInfo.MxWgt = GetMxWgt(SplitItemV);
         ChildInfo.LoadedP = false;
         ChildInfo.DirtyP = false;
         ChildInfoV.Add(ChildInfo);
@@ -166,6 +202,7 @@ void TGixItemSet<TKey, TItem>::InjectWorkBufferToChildren() {
             if (cd.Len() > 0) {
                 ChildInfoV[ind].MinItem = cd[0];
                 ChildInfoV[ind].MaxItem = cd.Last();
+                ChildInfoV[ind].MxWgt = GetMxWgt(cd);
             }
         }
     }
@@ -185,8 +222,10 @@ void TGixItemSet<TKey, TItem>::PushMergedDataBackToChildren(
             ChildInfoV[ChildN].Len = ChildV[ChildN].Len();
             ChildInfoV[ChildN].MinItem = ChildV[ChildN][0];
             ChildInfoV[ChildN].MaxItem = ChildV[ChildN].Last();
+            ChildInfoV[ChildN].MxWgt = GetMxWgt(ChildV[ChildN]);
             ChildInfoV[ChildN].DirtyP = true;
             ChildInfoV[ChildN].LoadedP = true;
+            ChildInfoV[ChildN].PackMem.Clr();
             MergedItemN += ChildInfoV[ChildN].Len;
             Remaining = MergedItems.Len() - MergedItemN;
             ChildN++;
@@ -262,6 +301,13 @@ template <class TKey, class TItem>
 TGixItemSet<TKey, TItem>::TGixItemSet(TSIn& SIn, const TGix<TKey, TItem>* _Gix):
     ItemSetKey(SIn), ItemV(SIn), ChildInfoV(SIn), MergedP(true), DirtyP(false), Gix(_Gix) {
 
+    // weight bounds of child vectors follow child info, when items have weights
+    if (Gix->GetItemHandler()->IsWgt()) {
+        TIntV MxWgtV(SIn); EAssert(MxWgtV.Len() == ChildInfoV.Len());
+        for (int ChildN = 0; ChildN < ChildInfoV.Len(); ChildN++) {
+            ChildInfoV[ChildN].MxWgt = MxWgtV[ChildN];
+        }
+    }
     for (int ChildN = 0; ChildN < ChildInfoV.Len(); ChildN++) {
         ChildV.Add(TVec<TItem>());
     };
@@ -285,6 +331,11 @@ void TGixItemSet<TKey, TItem>::Save(TMOut& SOut) {
     //ItemV.SaveMemCpy(SOut);
     ItemV.Save(SOut);
     ChildInfoV.Save(SOut);
+    if (Gix->GetItemHandler()->IsWgt()) {
+        TIntV MxWgtV(ChildInfoV.Len(), 0);
+        for (const TChildInfo& ChildInfo : ChildInfoV) { MxWgtV.Add(ChildInfo.MxWgt); }
+        MxWgtV.Save(SOut);
+    }
     DirtyP = false;
 }
 
@@ -310,6 +361,22 @@ void TGixItemSet<TKey, TItem>::OnDelFromCache(const TBlobPt& BlobPt, void* Gix)
     }
 }
 
+template <class TKey, class TItem>
+bool TGixItemSet<TKey, TItem>::IsAppendV(const TVec<TItem>& NewItemV) const {
+    // start with the last item of the itemset, if we have one
+    const TItem* LastItem = NULL;
+    if (!ItemV.Empty()) {
+        LastItem = &ItemV.Last();
+    } else if (!ChildInfoV.Empty()) {
+        LastItem = &ChildInfoV.Last().MaxItem;
+    }
+    for (int ItemN = 0; ItemN < NewItemV.Len(); ItemN++) {
+        if (LastItem != NULL && !Gix->GetItemHandler()->IsLt(*LastItem, NewItemV[ItemN])) { return false; }
+        LastItem = &NewItemV[ItemN];
+    }
+    return true;
+}
+
 template <class TKey, class TItem>
 void TGixItemSet<TKey, TItem>::AddItem(const TItem& NewItem, const bool& NotifyCacheOnlyDelta) {
     // if NotifyCacheOnlyDelta is false we have just added a new itemset and we have to report to gix
@@ -360,9 +427,23 @@ void TGixItemSet<TKey, TItem>::AddItem(const TItem& NewItem, const bool& NotifyC
 }
 
 template <class TKey, class TItem>
-void TGixItemSet<TKey, TItem>::AddItemV(const TVec<TItem>& NewItemV) {
+void TGixItemSet<TKey, TItem>::AddItemV(const TVec<TItem>& NewItemV, const bool& NotifyCacheOnlyDelta) {
+    if (MergedP && ItemVDel.Empty() && IsAppendV(NewItemV)) {
+        // itemset stays merged, so we can skip merging and write full child vectors directly
+        if (NotifyCacheOnlyDelta == false) {
+            Gix->AddToNewCacheSizeInc(GetMemUsed());
+        }
+        const uint64 OldSize = GetMemUsed();
+        ItemV.AddV(NewItemV);
+        PushWorkBufferToChildren();
+        TotalCnt += NewItemV.Len();
+        DirtyP = true;
+        Gix->AddToNewCacheSizeInc(OldSize, GetMemUsed());
+        return;
+    }
     for (int i = 0; i < NewItemV.Len(); i++) {
-        AddItem(NewItemV[i]);
+        // base size of a new itemset is reported only once
+        AddItem(NewItemV[i], NotifyCacheOnlyDelta || i > 0);
     }
 }
 
@@ -386,12 +467,9 @@ void TGixItemSet<TKey, TItem>::GetItemV(TVec<TItem>& _ItemV) {
     // reserve place for all the elements
     _ItemV.Gen(TotalCnt, 0);
     // load items
-    if (ChildInfoV.Len() > 0) {
-        // collect data from child itemsets
-        LoadChildVectors();
-        for (int i = 0; i < ChildInfoV.Len(); i++) {
-            _ItemV.AddV(ChildV[i]);
-        }
+    // collect data from child itemsets
+    for (int i = 0; i < ChildInfoV.Len(); i++) {
+        GetChildItemV(i, _ItemV);
     }
     _ItemV.AddV(ItemV);
 }
@@ -399,7 +477,15 @@ void TGixItemSet<TKey, TItem>::GetItemV(TVec<TItem>& _ItemV) {
 template <class TKey, class TItem>
 template <typename THandler>
 void TGixItemSet<TKey, TItem>::GetItemV(THandler& Handler) {
-    if (ChildInfoV.Len() > 0) {
+    if (ChildInfoV.Len() > 0 && Gix->GetItemHandler()->IsPacked()) {
+        // decode packed children one by one into a shared buffer
+        TVec<TItem> ChildItemV;
+        for (int i = 0; i < ChildInfoV.Len(); i++) {
+            ChildItemV.Clr(false);
+            GetChildItemV(i, ChildItemV);
+            Handler(ChildItemV);
+        }
+    } else if (ChildInfoV.Len() > 0) {
         // collect data from child itemsets
         LoadChildVectors();
         for (int i = 0; i < ChildInfoV.Len(); i++) {
@@ -409,6 +495,20 @@ void TGixItemSet<TKey, TItem>::GetItemV(THandler& Handler) {
     Handler(ItemV);
 }
 
+template <class TKey, class TItem>
+template <typename TChildFilter>
+void TGixItemSet<TKey, TItem>::GetItemV(TVec<TItem>& _ItemV, TChildFilter& ChildFilter) {
+    _ItemV.Clr(false);
+    // collect data only from child itemsets that pass the filter, using
+    // min and max items from child info to decide without loading them
+    for (int i = 0; i < ChildInfoV.Len(); i++) {
+        if (ChildFilter(ChildInfoV[i].MinItem, ChildInfoV[i].MaxItem)) {
+            GetChildItemV(i, _ItemV);
+        }
+    }
+    _ItemV.AddV(ItemV);
+}
+
 template <class TKey, class TItem>
 void TGixItemSet<TKey, TItem>::DelItem(const TItem& Item) {
     if (IsFull()) {
@@ -577,7 +677,16 @@ template <class TKey, class TItem>
 void TGix<TKey, TItem>::GetChildVector(const TBlobPt& KeyId, TVec<TItem>& Dest) const {
     if (KeyId.Empty()) { return; }
     PSIn ItemSetSIn = ItemSetBlobBs->GetBlob(KeyId);
-    Dest.Load(*ItemSetSIn);
+    Dest.Clr();
+    ItemHandler->LoadItemV(*ItemSetSIn, Dest);
+}
+
+template <class TKey, class TItem>
+void TGix<TKey, TItem>::GetChildPack(const TBlobPt& KeyId, TMem& Dest) const {
+    Dest.Clr();
+    if (KeyId.Empty()) { return; }
+    PSIn ItemSetSIn = ItemSetBlobBs->GetBlob(KeyId);
+    Dest += ItemSetSIn;
 }
 
 template <class TKey, class TItem>
@@ -587,7 +696,7 @@ TBlobPt TGix<TKey, TItem>::StoreChildVector(const TBlobPt& ExistingKeyId, const
     // store the current version to the blob
     TMOut MOut;
     //Data.SaveMemCpy(MOut);
-    Data.Save(MOut);
+    ItemHandler->SaveItemV(Data, MOut);
     int ReleasedSize;
     return ItemSetBlobBs->PutBlob(ExistingKeyId, MOut.GetSIn(), ReleasedSize);
 }
@@ -602,7 +711,7 @@ template <class TKey, class TItem>
 TBlobPt TGix<TKey, TItem>::EnlistChildVector(const TVec<TItem>& Data) const {
     AssertReadOnly(); // check if we are allowed to write
     TMOut MOut;
-    Data.Save(MOut);
+    ItemHandler->SaveItemV(Data, MOut);
     TBlobPt res = ItemSetBlobBs->PutBlob(MOut.GetSIn());
     return res;
 }
@@ -796,9 +905,10 @@ void TGix<TKey, TItem>::AddItemV(const TKey& Key, const TVec<TItem>& ItemV) {
     } else {
         // we don't have this key, create a new itemset and add new item immidiatelly
         PGixItemSet ItemSet = TGixItemSet<TKey, TItem>::New(Key, this);
-        ItemSet->AddItemV(ItemV);
+        ItemSet->AddItemV(ItemV, false);
         TBlobPt KeyId = EnlistItemSet(ItemSet); // now store this itemset to disk
         KeyIdH.AddDat(Key, KeyId); // remember the new key and its Id
+        ItemSetCache.Put(KeyId, ItemSet); // add it to cache
     }
     // check if we have to drop anything from the cache
     RefreshMemUsed();
@@ -818,6 +928,22 @@ void TGix<TKey, TItem>::DelItem(const TKey& Key, const TItem& Item) {
     }
 }
 
+template <class TKey, class TItem>
+void TGix<TKey, TItem>::DelItemV(const TKey& Key, const TVec<TItem>& ItemV) {
+    AssertReadOnly(); // check if we are allowed to write
+    if (IsKey(Key)) { // check if this key exists
+        // load the current item set
+        PGixItemSet ItemSet = GetItemSet(Key);
+        // clear the items from the ItemSet
+        for (int ItemN = 0; ItemN < ItemV.Len(); ItemN++) {
+            ItemSet->DelItem(ItemV[ItemN]);
+        }
+        if (ItemSet->Empty()) {
+            DeleteItemSet(Key);
+        }
+    }
+}
+
 template <class TKey, class TItem>
 void TGix<TKey, TItem>::Clr(const TKey& Key) {
     AssertReadOnly(); // check if we are allowed to write
@@ -980,6 +1106,51 @@ void TGixExpItem<TKey, TItem, TResItem>::PutOr(const TPt<TGixExpItem<TKey, TItem
     RightExpItem = _RightExpItem;
 }
 
+template <class TKey, class TItem, class TResItem>
+void TGixExpItem<TKey, TItem, TResItem>::EvalKey(const TPt<TGix<TKey, TItem> >& Gix,
+        TVec<TResItem>& ResItemV, const TGixMerger<TKey, TItem, TResItem>* Merger,
+        const TVec<TResItem>& FilterItemV) {
+
+    PGixItemSet ItemSet = Gix->GetItemSet(Key);
+    if (!ItemSet.Empty()) {
+        ItemSet->Def();
+        // child vectors are sorted and do not overlap, so we can move through filter
+        // items only forward, galloping over the ones smaller than the child vector
+        int FilterItemN = 0;
+        auto ChildFilter = [&](const TItem& MinItem, const TItem& MaxItem) {
+            int Step = 1;
+            while (FilterItemN < FilterItemV.Len() && Merger->IsResLt(FilterItemV[FilterItemN], MinItem)) {
+                // find first filter item that is not smaller than the child vector
+                const int NextItemN = FilterItemN + Step;
+                if (NextItemN < FilterItemV.Len() && Merger->IsResLt(FilterItemV[NextItemN], MinItem)) {
+                    FilterItemN = NextItemN; Step *= 2;
+                } else {
+                    FilterItemN++; Step = 1;
+                }
+            }
+            // child vector is needed only when it contains the next filter item
+            return FilterItemN < FilterItemV.Len() && !Merger->IsLtRes(MaxItem, FilterItemV[FilterItemN]);
+        };
+        TVec<TItem> ItemV; ItemSet->GetItemV(ItemV, ChildFilter);
+        Merger->Def(ItemSet->GetKey(), ItemV, ResItemV);
+    }
+}
+
+template <class TKey, class TItem, class TResItem>
+int TGixExpItem<TKey, TItem, TResItem>::GetItems(const TPt<TGix<TKey, TItem> >& Gix) const {
+    if (ExpType == getOr) {
+        const int64 Items = (int64)LeftExpItem->GetItems(Gix) + (int64)RightExpItem->GetItems(Gix);
+        return (Items > (int64)TInt::Mx) ? TInt::Mx : (int)Items;
+    } else if (ExpType == getAnd) {
+        return TInt::GetMn(LeftExpItem->GetItems(Gix), RightExpItem->GetItems(Gix));
+    } else if (ExpType == getKey) {
+        return Gix->GetItems(Key);
+    } else if (ExpType == getEmpty) {
+        return 0;
+    }
+    return TInt::Mx;
+}
+
 template <class TKey, class TItem, class TResItem>
 TPt<TGixExpItem<TKey, TItem, TResItem> > TGixExpItem<TKey, TItem, TResItem>::NewAndV(
     const TVec<TPt<TGixExpItem<TKey, TItem, TResItem> > >& ExpItemV) {
@@ -1081,23 +1252,35 @@ bool TGixExpItem<TKey, TItem, TResItem>::Eval(const TPt<TGix<TKey, TItem> >& Gix
         return (NotLeft || NotRight);
     } else if (ExpType == getAnd) {
         EAssert(!LeftExpItem.Empty() && !RightExpItem.Empty());
-        TVec<TResItem> RightItemV;
-        const bool NotLeft = LeftExpItem->Eval(Gix, ResItemV, Merger);
-        const bool NotRight = RightExpItem->Eval(Gix, RightItemV, Merger);
-        if (NotLeft && NotRight) {
-            Merger->Union(ResItemV, RightItemV);
-        } else if (!NotLeft && !NotRight) {
-            Merger->Intrs(ResItemV, RightItemV);
+        // evaluate operand with fewer items first, so the other one can skip
+        // child vectors which cannot intersect with it
+        const bool LeftFirstP = LeftExpItem->GetItems(Gix) <= RightExpItem->GetItems(Gix);
+        const PGixExpItem& FirstExpItem = LeftFirstP ? LeftExpItem : RightExpItem;
+        const PGixExpItem& SecondExpItem = LeftFirstP ? RightExpItem : LeftExpItem;
+        TVec<TResItem> SecondItemV;
+        const bool NotFirst = FirstExpItem->Eval(Gix, ResItemV, Merger);
+        // nothing can intersect with empty set
+        if (!NotFirst && ResItemV.Empty()) { return false; }
+        bool NotSecond = false;
+        if (!NotFirst && SecondExpItem->GetExpType() == getKey) {
+            SecondExpItem->EvalKey(Gix, SecondItemV, Merger, ResItemV);
+        } else {
+            NotSecond = SecondExpItem->Eval(Gix, SecondItemV, Merger);
+        }
+        if (NotFirst && NotSecond) {
+            Merger->Union(ResItemV, SecondItemV);
+        } else if (!NotFirst && !NotSecond) {
+            Merger->Intrs(ResItemV, SecondItemV);
         } else {
             TVec<TResItem> MinusItemV;
-            if (NotLeft) {
-                Merger->Minus(RightItemV, ResItemV, MinusItemV);
+            if (NotFirst) {
+                Merger->Minus(SecondItemV, ResItemV, MinusItemV);
             } else {
-                Merger->Minus(ResItemV, RightItemV, MinusItemV);
+                Merger->Minus(ResItemV, SecondItemV, MinusItemV);
             }
             ResItemV = MinusItemV;
         }
-        return (NotLeft && NotRight);
+        return (NotFirst && NotSecond);
     } else if (ExpType == getKey) {
         PGixItemSet ItemSet = Gix->GetItemSet(Key);
         if (!ItemSet.Empty()) {
@@ -145,7 +145,7 @@ TTm TJsonVal::GetTm() const {
 void TJsonVal::GetArrNumV(TFltV& FltV) const {
     EAssert(IsArr());
     for (int FltN = 0; FltN < GetArrVals(); FltN++) {
-        PJsonVal ArrVal = GetArrVal(FltN);
+        const PJsonVal& ArrVal = ValV[FltN];
         EAssert(ArrVal->IsNum());
         FltV.Add(ArrVal->GetNum());
     }
@@ -154,7 +154,7 @@ void TJsonVal::GetArrNumV(TFltV& FltV) const {
 void TJsonVal::GetArrNumSpV(TIntFltKdV& NumSpV) const {
     EAssert(IsArr());
     for (int ElN = 0; ElN < GetArrVals(); ElN++) {
-        PJsonVal ArrVal = GetArrVal(ElN);
+        const PJsonVal& ArrVal = ValV[ElN];
         EAssert(ArrVal->IsArr());
         EAssert(ArrVal->GetArrVals() ==  2);
         int Idx = ArrVal->GetArrVal(0)->GetInt();
@@ -167,7 +167,7 @@ void TJsonVal::GetArrNumSpV(TIntFltKdV& NumSpV) const {
 void TJsonVal::GetArrIntV(TIntV& IntV) const {
     EAssert(IsArr());
     for (int IntN = 0; IntN < GetArrVals(); IntN++) {
-        PJsonVal ArrVal = GetArrVal(IntN);
+        const PJsonVal& ArrVal = ValV[IntN];
         EAssert(ArrVal->IsNum());
         IntV.Add(ArrVal->GetInt());
     }
@@ -176,7 +176,7 @@ void TJsonVal::GetArrIntV(TIntV& IntV) const {
 void TJsonVal::GetArrUInt64V(TUInt64V& UInt64V) const {
     EAssert(IsArr());
     for (int IntN = 0; IntN < GetArrVals(); IntN++) {
-        PJsonVal ArrVal = GetArrVal(IntN);
+        const PJsonVal& ArrVal = ValV[IntN];
         EAssert(ArrVal->IsNum());
         UInt64V.Add(ArrVal->GetUInt64());
     }
@@ -185,7 +185,7 @@ void TJsonVal::GetArrUInt64V(TUInt64V& UInt64V) const {
 void TJsonVal::GetArrStrV(TStrV& StrV) const {
     EAssert(IsArr());
     for (int StrN = 0; StrN < GetArrVals(); StrN++) {
-        PJsonVal ArrVal = GetArrVal(StrN);
+        const PJsonVal& ArrVal = ValV[StrN];
         EAssert(ArrVal->IsStr());
         StrV.Add(ArrVal->GetStr());
     }
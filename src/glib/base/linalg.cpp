@@ -762,6 +762,424 @@ bool TLinAlgCheck::IsOrthonormal(const TFltVV& Vecs, const double& Threshold) {
 	return TLinAlg::Frob(R) < Threshold;
 }
 
+////////////////////////////////////////////////////////////////////////
+//// Vectorized kernels over contiguous arrays of doubles
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define GLIB_LINALG_X86
+	#define GLIB_LINALG_SSE2 __attribute__((target("sse2")))
+	#define GLIB_LINALG_AVX2 __attribute__((target("avx2,fma")))
+	#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#define GLIB_LINALG_X86
+	#define GLIB_LINALG_SSE2
+	#define GLIB_LINALG_AVX2
+	#include <intrin.h>
+	#include <immintrin.h>
+#endif
+
+// picks the fastest kernels the CPU supports when the library is loaded
+TLinAlgKernel::TKernelType TLinAlgKernel::KernelType = TLinAlgKernel::GetBestKernelType();
+
+TLinAlgKernel::TKernelType TLinAlgKernel::GetBestKernelType() {
+#if defined(GLIB_LINALG_X86) && defined(__GNUC__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) { return lkAvx2; }
+	if (__builtin_cpu_supports("sse2")) { return lkSse2; }
+#elif defined(GLIB_LINALG_X86)
+	int CpuInfo[4]; __cpuid(CpuInfo, 0);
+	const int MxLeaf = CpuInfo[0];
+	__cpuid(CpuInfo, 1);
+	const bool Sse2P = (CpuInfo[3] & (1 << 26)) != 0;
+	const bool FmaP = (CpuInfo[2] & (1 << 12)) != 0;
+	// the operating system must save the AVX registers on context switch
+	const bool OsAvxP = (CpuInfo[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+	if (MxLeaf >= 7 && FmaP && OsAvxP) {
+		__cpuidex(CpuInfo, 7, 0);
+		if ((CpuInfo[1] & (1 << 5)) != 0) { return lkAvx2; }
+	}
+	if (Sse2P) { return lkSse2; }
+#endif
+	return lkScalar;
+}
+
+void TLinAlgKernel::SetKernelType(const TKernelType& _KernelType) {
+	EAssertR(_KernelType <= GetBestKernelType(), "TLinAlgKernel: " +
+		GetKernelTypeStr(_KernelType) + " is not supported by the CPU");
+	KernelType = _KernelType;
+}
+
+TStr TLinAlgKernel::GetKernelTypeStr(const TKernelType& _KernelType) {
+	switch (_KernelType) {
+		case lkAvx2: return "AVX2";
+		case lkSse2: return "SSE2";
+		default: return "scalar";
+	}
+}
+
+namespace TLinAlgKernelImpl {
+	// Gemm works on blocks of KC x NC from op(B) and MC x KC from op(A), packed
+	// into panels of MR rows and NR columns, which the inner kernel multiplies
+	const int64 GemmMC = 64, GemmNC = 512, GemmKC = 256;
+	const int GemmMR = 4, GemmNR = 8;
+	// AB := Ap * Bp for a panel of MR rows of op(A) and NR columns of op(B)
+	typedef void(*TGemmKernel)(const int64& Depth, const double* Ap, const double* Bp, double* AB);
+
+	double DotProductScalar(const double* x, const double* y, const int64& Len) {
+		double Sum0 = 0.0, Sum1 = 0.0, Sum2 = 0.0, Sum3 = 0.0; int64 ValN = 0;
+		for (; ValN + 4 <= Len; ValN += 4) {
+			Sum0 += x[ValN] * y[ValN]; Sum1 += x[ValN + 1] * y[ValN + 1];
+			Sum2 += x[ValN + 2] * y[ValN + 2]; Sum3 += x[ValN + 3] * y[ValN + 3];
+		}
+		for (; ValN < Len; ValN++) { Sum0 += x[ValN] * y[ValN]; }
+		return (Sum0 + Sum1) + (Sum2 + Sum3);
+	}
+
+	double EuclDist2Scalar(const double* x, const double* y, const int64& Len) {
+		double Sum0 = 0.0, Sum1 = 0.0, Sum2 = 0.0, Sum3 = 0.0; int64 ValN = 0;
+		for (; ValN + 4 <= Len; ValN += 4) {
+			const double Diff0 = x[ValN] - y[ValN], Diff1 = x[ValN + 1] - y[ValN + 1];
+			const double Diff2 = x[ValN + 2] - y[ValN + 2], Diff3 = x[ValN + 3] - y[ValN + 3];
+			Sum0 += Diff0 * Diff0; Sum1 += Diff1 * Diff1; Sum2 += Diff2 * Diff2; Sum3 += Diff3 * Diff3;
+		}
+		for (; ValN < Len; ValN++) { const double Diff = x[ValN] - y[ValN]; Sum0 += Diff * Diff; }
+		return (Sum0 + Sum1) + (Sum2 + Sum3);
+	}
+
+	void LinCombScalar(const double& p, const double* x, const double& q, const double* y,
+			double* z, const int64& Len) {
+		for (int64 ValN = 0; ValN < Len; ValN++) { z[ValN] = p * x[ValN] + q * y[ValN]; }
+	}
+
+	void AddVecScalar(const double& k, const double* x, double* y, const int64& Len) {
+		for (int64 ValN = 0; ValN < Len; ValN++) { y[ValN] += k * x[ValN]; }
+	}
+
+	void MultiplyScalarScalar(const double& k, const double* x, double* y, const int64& Len) {
+		for (int64 ValN = 0; ValN < Len; ValN++) { y[ValN] = k * x[ValN]; }
+	}
+
+	void GemmKernelScalar(const int64& Depth, const double* Ap, const double* Bp, double* AB) {
+		for (int ValN = 0; ValN < GemmMR * GemmNR; ValN++) { AB[ValN] = 0.0; }
+		for (int64 DepthN = 0; DepthN < Depth; DepthN++) {
+			for (int RowN = 0; RowN < GemmMR; RowN++) {
+				const double Val = Ap[RowN]; double* ABRow = AB + RowN * GemmNR;
+				for (int ColN = 0; ColN < GemmNR; ColN++) { ABRow[ColN] += Val * Bp[ColN]; }
+			}
+			Ap += GemmMR; Bp += GemmNR;
+		}
+	}
+
+#ifdef GLIB_LINALG_X86
+	GLIB_LINALG_SSE2 double DotProductSse2(const double* x, const double* y, const int64& Len) {
+		__m128d Sum0 = _mm_setzero_pd(), Sum1 = _mm_setzero_pd(); int64 ValN = 0;
+		for (; ValN + 4 <= Len; ValN += 4) {
+			Sum0 = _mm_add_pd(Sum0, _mm_mul_pd(_mm_loadu_pd(x + ValN), _mm_loadu_pd(y + ValN)));
+			Sum1 = _mm_add_pd(Sum1, _mm_mul_pd(_mm_loadu_pd(x + ValN + 2), _mm_loadu_pd(y + ValN + 2)));
+		}
+		double SumV[2]; _mm_storeu_pd(SumV, _mm_add_pd(Sum0, Sum1));
+		double Sum = SumV[0] + SumV[1];
+		for (; ValN < Len; ValN++) { Sum += x[ValN] * y[ValN]; }
+		return Sum;
+	}
+
+	GLIB_LINALG_SSE2 double EuclDist2Sse2(const double* x, const double* y, const int64& Len) {
+		__m128d Sum0 = _mm_setzero_pd(), Sum1 = _mm_setzero_pd(); int64 ValN = 0;
+		for (; ValN + 4 <= Len; ValN += 4) {
+			const __m128d Diff0 = _mm_sub_pd(_mm_loadu_pd(x + ValN), _mm_loadu_pd(y + ValN));
+			const __m128d Diff1 = _mm_sub_pd(_mm_loadu_pd(x + ValN + 2), _mm_loadu_pd(y + ValN + 2));
+			Sum0 = _mm_add_pd(Sum0, _mm_mul_pd(Diff0, Diff0));
+			Sum1 = _mm_add_pd(Sum1, _mm_mul_pd(Diff1, Diff1));
+		}
+		double SumV[2]; _mm_storeu_pd(SumV, _mm_add_pd(Sum0, Sum1));
+		double Sum = SumV[0] + SumV[1];
+		for (; ValN < Len; ValN++) { const double Diff = x[ValN] - y[ValN]; Sum += Diff * Diff; }
+		return Sum;
+	}
+
+	GLIB_LINALG_SSE2 void LinCombSse2(const double& p, const double* x, const double& q,
+			const double* y, double* z, const int64& Len) {
+		const __m128d P = _mm_set1_pd(p), Q = _mm_set1_pd(q); int64 ValN = 0;
+		for (; ValN + 2 <= Len; ValN += 2) {
+			_mm_storeu_pd(z + ValN, _mm_add_pd(_mm_mul_pd(P, _mm_loadu_pd(x + ValN)),
+				_mm_mul_pd(Q, _mm_loadu_pd(y + ValN))));
+		}
+		for (; ValN < Len; ValN++) { z[ValN] = p * x[ValN] + q * y[ValN]; }
+	}
+
+	GLIB_LINALG_SSE2 void AddVecSse2(const double& k, const double* x, double* y, const int64& Len) {
+		const __m128d K = _mm_set1_pd(k); int64 ValN = 0;
+		for (; ValN + 2 <= Len; ValN += 2) {
+			_mm_storeu_pd(y + ValN, _mm_add_pd(_mm_loadu_pd(y + ValN), _mm_mul_pd(K, _mm_loadu_pd(x + ValN))));
+		}
+		for (; ValN < Len; ValN++) { y[ValN] += k * x[ValN]; }
+	}
+
+	GLIB_LINALG_SSE2 void MultiplyScalarSse2(const double& k, const double* x, double* y, const int64& Len) {
+		const __m128d K = _mm_set1_pd(k); int64 ValN = 0;
+		for (; ValN + 2 <= Len; ValN += 2) {
+			_mm_storeu_pd(y + ValN, _mm_mul_pd(K, _mm_loadu_pd(x + ValN)));
+		}
+		for (; ValN < Len; ValN++) { y[ValN] = k * x[ValN]; }
+	}
+
+	GLIB_LINALG_SSE2 void GemmKernelSse2(const int64& Depth, const double* Ap, const double* Bp, double* AB) {
+		// 4 x 8 block of AB in 16 registers
+		__m128d AB0[4], AB1[4], AB2[4], AB3[4];
+		for (int ColN = 0; ColN < 4; ColN++) {
+			AB0[ColN] = _mm_setzero_pd(); AB1[ColN] = _mm_setzero_pd();
+			AB2[ColN] = _mm_setzero_pd(); AB3[ColN] = _mm_setzero_pd();
+		}
+		for (int64 DepthN = 0; DepthN < Depth; DepthN++) {
+			const __m128d B0 = _mm_loadu_pd(Bp), B1 = _mm_loadu_pd(Bp + 2);
+			const __m128d B2 = _mm_loadu_pd(Bp + 4), B3 = _mm_loadu_pd(Bp + 6);
+			const __m128d A0 = _mm_set1_pd(Ap[0]), A1 = _mm_set1_pd(Ap[1]);
+			const __m128d A2 = _mm_set1_pd(Ap[2]), A3 = _mm_set1_pd(Ap[3]);
+			AB0[0] = _mm_add_pd(AB0[0], _mm_mul_pd(A0, B0)); AB0[1] = _mm_add_pd(AB0[1], _mm_mul_pd(A0, B1));
+			AB0[2] = _mm_add_pd(AB0[2], _mm_mul_pd(A0, B2)); AB0[3] = _mm_add_pd(AB0[3], _mm_mul_pd(A0, B3));
+			AB1[0] = _mm_add_pd(AB1[0], _mm_mul_pd(A1, B0)); AB1[1] = _mm_add_pd(AB1[1], _mm_mul_pd(A1, B1));
+			AB1[2] = _mm_add_pd(AB1[2], _mm_mul_pd(A1, B2)); AB1[3] = _mm_add_pd(AB1[3], _mm_mul_pd(A1, B3));
+			AB2[0] = _mm_add_pd(AB2[0], _mm_mul_pd(A2, B0)); AB2[1] = _mm_add_pd(AB2[1], _mm_mul_pd(A2, B1));
+			AB2[2] = _mm_add_pd(AB2[2], _mm_mul_pd(A2, B2)); AB2[3] = _mm_add_pd(AB2[3], _mm_mul_pd(A2, B3));
+			AB3[0] = _mm_add_pd(AB3[0], _mm_mul_pd(A3, B0)); AB3[1] = _mm_add_pd(AB3[1], _mm_mul_pd(A3, B1));
+			AB3[2] = _mm_add_pd(AB3[2], _mm_mul_pd(A3, B2)); AB3[3] = _mm_add_pd(AB3[3], _mm_mul_pd(A3, B3));
+			Ap += GemmMR; Bp += GemmNR;
+		}
+		for (int ColN = 0; ColN < 4; ColN++) {
+			_mm_storeu_pd(AB + 2 * ColN, AB0[ColN]); _mm_storeu_pd(AB + GemmNR + 2 * ColN, AB1[ColN]);
+			_mm_storeu_pd(AB + 2 * GemmNR + 2 * ColN, AB2[ColN]); _mm_storeu_pd(AB + 3 * GemmNR + 2 * ColN, AB3[ColN]);
+		}
+	}
+
+	GLIB_LINALG_AVX2 double DotProductAvx2(const double* x, const double* y, const int64& Len) {
+		__m256d Sum0 = _mm256_setzero_pd(), Sum1 = _mm256_setzero_pd();
+		__m256d Sum2 = _mm256_setzero_pd(), Sum3 = _mm256_setzero_pd(); int64 ValN = 0;
+		for (; ValN + 16 <= Len; ValN += 16) {
+			Sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + ValN), _mm256_loadu_pd(y + ValN), Sum0);
+			Sum1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + ValN + 4), _mm256_loadu_pd(y + ValN + 4), Sum1);
+			Sum2 = _mm256_fmadd_pd(_mm256_loadu_pd(x + ValN + 8), _mm256_loadu_pd(y + ValN + 8), Sum2);
+			Sum3 = _mm256_fmadd_pd(_mm256_loadu_pd(x + ValN + 12), _mm256_loadu_pd(y + ValN + 12), Sum3);
+		}
+		for (; ValN + 4 <= Len; ValN += 4) {
+			Sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + ValN), _mm256_loadu_pd(y + ValN), Sum0);
+		}
+		double SumV[4]; _mm256_storeu_pd(SumV, _mm256_add_pd(_mm256_add_pd(Sum0, Sum1), _mm256_add_pd(Sum2, Sum3)));
+		double Sum = (SumV[0] + SumV[1]) + (SumV[2] + SumV[3]);
+		for (; ValN < Len; ValN++) { Sum += x[ValN] * y[ValN]; }
+		return Sum;
+	}
+
+	GLIB_LINALG_AVX2 double EuclDist2Avx2(const double* x, const double* y, const int64& Len) {
+		__m256d Sum0 = _mm256_setzero_pd(), Sum1 = _mm256_setzero_pd(); int64 ValN = 0;
+		for (; ValN + 8 <= Len; ValN += 8) {
+			const __m256d Diff0 = _mm256_sub_pd(_mm256_loadu_pd(x + ValN), _mm256_loadu_pd(y + ValN));
+			const __m256d Diff1 = _mm256_sub_pd(_mm256_loadu_pd(x + ValN + 4), _mm256_loadu_pd(y + ValN + 4));
+			Sum0 = _mm256_fmadd_pd(Diff0, Diff0, Sum0);
+			Sum1 = _mm256_fmadd_pd(Diff1, Diff1, Sum1);
+		}
+		for (; ValN + 4 <= Len; ValN += 4) {
+			const __m256d Diff = _mm256_sub_pd(_mm256_loadu_pd(x + ValN), _mm256_loadu_pd(y + ValN));
+			Sum0 = _mm256_fmadd_pd(Diff, Diff, Sum0);
+		}
+		double SumV[4]; _mm256_storeu_pd(SumV, _mm256_add_pd(Sum0, Sum1));
+		double Sum = (SumV[0] + SumV[1]) + (SumV[2] + SumV[3]);
+		for (; ValN < Len; ValN++) { const double Diff = x[ValN] - y[ValN]; Sum += Diff * Diff; }
+		return Sum;
+	}
+
+	GLIB_LINALG_AVX2 void LinCombAvx2(const double& p, const double* x, const double& q,
+			const double* y, double* z, const int64& Len) {
+		const __m256d P = _mm256_set1_pd(p), Q = _mm256_set1_pd(q); int64 ValN = 0;
+		for (; ValN + 4 <= Len; ValN += 4) {
+			_mm256_storeu_pd(z + ValN, _mm256_fmadd_pd(P, _mm256_loadu_pd(x + ValN),
+				_mm256_mul_pd(Q, _mm256_loadu_pd(y + ValN))));
+		}
+		for (; ValN < Len; ValN++) { z[ValN] = p * x[ValN] + q * y[ValN]; }
+	}
+
+	GLIB_LINALG_AVX2 void AddVecAvx2(const double& k, const double* x, double* y, const int64& Len) {
+		const __m256d K = _mm256_set1_pd(k); int64 ValN = 0;
+		for (; ValN + 8 <= Len; ValN += 8) {
+			_mm256_storeu_pd(y + ValN, _mm256_fmadd_pd(K, _mm256_loadu_pd(x + ValN), _mm256_loadu_pd(y + ValN)));
+			_mm256_storeu_pd(y + ValN + 4, _mm256_fmadd_pd(K, _mm256_loadu_pd(x + ValN + 4), _mm256_loadu_pd(y + ValN + 4)));
+		}
+		for (; ValN + 4 <= Len; ValN += 4) {
+			_mm256_storeu_pd(y + ValN, _mm256_fmadd_pd(K, _mm256_loadu_pd(x + ValN), _mm256_loadu_pd(y + ValN)));
+		}
+		for (; ValN < Len; ValN++) { y[ValN] += k * x[ValN]; }
+	}
+
+	GLIB_LINALG_AVX2 void MultiplyScalarAvx2(const double& k, const double* x, double* y, const int64& Len) {
+		const __m256d K = _mm256_set1_pd(k); int64 ValN = 0;
+		for (; ValN + 4 <= Len; ValN += 4) {
+			_mm256_storeu_pd(y + ValN, _mm256_mul_pd(K, _mm256_loadu_pd(x + ValN)));
+		}
+		for (; ValN < Len; ValN++) { y[ValN] = k * x[ValN]; }
+	}
+
+	GLIB_LINALG_AVX2 void GemmKernelAvx2(const int64& Depth, const double* Ap, const double* Bp, double* AB) {
+		// 4 x 8 block of AB in 8 registers
+		__m256d AB00 = _mm256_setzero_pd(), AB01 = _mm256_setzero_pd();
+		__m256d AB10 = _mm256_setzero_pd(), AB11 = _mm256_setzero_pd();
+		__m256d AB20 = _mm256_setzero_pd(), AB21 = _mm256_setzero_pd();
+		__m256d AB30 = _mm256_setzero_pd(), AB31 = _mm256_setzero_pd();
+		for (int64 DepthN = 0; DepthN < Depth; DepthN++) {
+			const __m256d B0 = _mm256_loadu_pd(Bp), B1 = _mm256_loadu_pd(Bp + 4);
+			__m256d A = _mm256_broadcast_sd(Ap);
+			AB00 = _mm256_fmadd_pd(A, B0, AB00); AB01 = _mm256_fmadd_pd(A, B1, AB01);
+			A = _mm256_broadcast_sd(Ap + 1);
+			AB10 = _mm256_fmadd_pd(A, B0, AB10); AB11 = _mm256_fmadd_pd(A, B1, AB11);
+			A = _mm256_broadcast_sd(Ap + 2);
+			AB20 = _mm256_fmadd_pd(A, B0, AB20); AB21 = _mm256_fmadd_pd(A, B1, AB21);
+			A = _mm256_broadcast_sd(Ap + 3);
+			AB30 = _mm256_fmadd_pd(A, B0, AB30); AB31 = _mm256_fmadd_pd(A, B1, AB31);
+			Ap += GemmMR; Bp += GemmNR;
+		}
+		_mm256_storeu_pd(AB, AB00); _mm256_storeu_pd(AB + 4, AB01);
+		_mm256_storeu_pd(AB + GemmNR, AB10); _mm256_storeu_pd(AB + GemmNR + 4, AB11);
+		_mm256_storeu_pd(AB + 2 * GemmNR, AB20); _mm256_storeu_pd(AB + 2 * GemmNR + 4, AB21);
+		_mm256_storeu_pd(AB + 3 * GemmNR, AB30); _mm256_storeu_pd(AB + 3 * GemmNR + 4, AB31);
+	}
+#endif
+}
+
+double TLinAlgKernel::DotProduct(const double* x, const double* y, const int64& Len) {
+#ifdef GLIB_LINALG_X86
+	if (KernelType == lkAvx2) { return TLinAlgKernelImpl::DotProductAvx2(x, y, Len); }
+	if (KernelType == lkSse2) { return TLinAlgKernelImpl::DotProductSse2(x, y, Len); }
+#endif
+	return TLinAlgKernelImpl::DotProductScalar(x, y, Len);
+}
+
+double TLinAlgKernel::EuclDist2(const double* x, const double* y, const int64& Len) {
+#ifdef GLIB_LINALG_X86
+	if (KernelType == lkAvx2) { return TLinAlgKernelImpl::EuclDist2Avx2(x, y, Len); }
+	if (KernelType == lkSse2) { return TLinAlgKernelImpl::EuclDist2Sse2(x, y, Len); }
+#endif
+	return TLinAlgKernelImpl::EuclDist2Scalar(x, y, Len);
+}
+
+void TLinAlgKernel::AddVec(const double& k, const double* x, double* y, const int64& Len) {
+#ifdef GLIB_LINALG_X86
+	if (KernelType == lkAvx2) { TLinAlgKernelImpl::AddVecAvx2(k, x, y, Len); return; }
+	if (KernelType == lkSse2) { TLinAlgKernelImpl::AddVecSse2(k, x, y, Len); return; }
+#endif
+	TLinAlgKernelImpl::AddVecScalar(k, x, y, Len);
+}
+
+void TLinAlgKernel::LinComb(const double& p, const double* x, const double& q, const double* y,
+		double* z, const int64& Len) {
+#ifdef GLIB_LINALG_X86
+	if (KernelType == lkAvx2) { TLinAlgKernelImpl::LinCombAvx2(p, x, q, y, z, Len); return; }
+	if (KernelType == lkSse2) { TLinAlgKernelImpl::LinCombSse2(p, x, q, y, z, Len); return; }
+#endif
+	TLinAlgKernelImpl::LinCombScalar(p, x, q, y, z, Len);
+}
+
+void TLinAlgKernel::MultiplyScalar(const double& k, const double* x, double* y, const int64& Len) {
+#ifdef GLIB_LINALG_X86
+	if (KernelType == lkAvx2) { TLinAlgKernelImpl::MultiplyScalarAvx2(k, x, y, Len); return; }
+	if (KernelType == lkSse2) { TLinAlgKernelImpl::MultiplyScalarSse2(k, x, y, Len); return; }
+#endif
+	TLinAlgKernelImpl::MultiplyScalarScalar(k, x, y, Len);
+}
+
+void TLinAlgKernel::Gemv(const bool& TransA, const int64& Rows, const int64& Cols, const double& Alpha,
+		const double* A, const double* x, const double& Beta, double* y) {
+	if (!TransA) {
+		// y(i) is the dot product with the i-th row
+		for (int64 RowN = 0; RowN < Rows; RowN++) {
+			const double Val = Alpha * DotProduct(A + RowN * Cols, x, Cols);
+			y[RowN] = (Beta == 0.0) ? Val : Val + Beta * y[RowN];
+		}
+	} else {
+		// y is a linear combination of the rows
+		if (Beta == 0.0) {
+			for (int64 ColN = 0; ColN < Cols; ColN++) { y[ColN] = 0.0; }
+		} else if (Beta != 1.0) {
+			MultiplyScalar(Beta, y, y, Cols);
+		}
+		for (int64 RowN = 0; RowN < Rows; RowN++) {
+			AddVec(Alpha * x[RowN], A + RowN * Cols, y, Cols);
+		}
+	}
+}
+
+void TLinAlgKernel::Gemm(const bool& TransA, const bool& TransB, const int64& M, const int64& N,
+		const int64& K, const double& Alpha, const double* A, const int64& LdA, const double* B,
+		const int64& LdB, const double& Beta, double* C, const int64& LdC) {
+
+	using namespace TLinAlgKernelImpl;
+	// C := Beta * C
+	for (int64 RowN = 0; RowN < M; RowN++) {
+		double* CRow = C + RowN * LdC;
+		if (Beta == 0.0) {
+			for (int64 ColN = 0; ColN < N; ColN++) { CRow[ColN] = 0.0; }
+		} else if (Beta != 1.0) {
+			MultiplyScalar(Beta, CRow, CRow, N);
+		}
+	}
+	if (M == 0 || N == 0 || K == 0) { return; }
+
+	TGemmKernel GemmKernel = GemmKernelScalar;
+#ifdef GLIB_LINALG_X86
+	if (KernelType == lkAvx2) { GemmKernel = GemmKernelAvx2; }
+	else if (KernelType == lkSse2) { GemmKernel = GemmKernelSse2; }
+#endif
+
+	// packed blocks, padded with zeros to whole panels
+	const int64 MxKC = TMath::Mn<int64>(GemmKC, K);
+	const int64 MxMC = (TMath::Mn<int64>(GemmMC, M) + GemmMR - 1) / GemmMR * GemmMR;
+	const int64 MxNC = (TMath::Mn<int64>(GemmNC, N) + GemmNR - 1) / GemmNR * GemmNR;
+	TVec<TFlt, int64> ApV(MxMC * MxKC), BpV(MxKC * MxNC);
+	double* Ap = (double*)ApV.BegI(); double* Bp = (double*)BpV.BegI();
+	double AB[GemmMR * GemmNR];
+
+	for (int64 ColC = 0; ColC < N; ColC += GemmNC) {
+		const int64 NC = TMath::Mn<int64>(GemmNC, N - ColC);
+		for (int64 DepthC = 0; DepthC < K; DepthC += GemmKC) {
+			const int64 KC = TMath::Mn<int64>(GemmKC, K - DepthC);
+			// pack op(B)(DepthC:DepthC+KC, ColC:ColC+NC) into panels of NR columns
+			for (int64 ColR = 0; ColR < NC; ColR += GemmNR) {
+				double* BpPanel = Bp + ColR * KC;
+				for (int64 DepthN = 0; DepthN < KC; DepthN++) {
+					for (int ColN = 0; ColN < GemmNR; ColN++) {
+						const int64 RowB = DepthC + DepthN, ColB = ColC + ColR + ColN;
+						*BpPanel++ = (ColR + ColN >= NC) ? 0.0 :
+							(TransB ? B[ColB * LdB + RowB] : B[RowB * LdB + ColB]);
+					}
+				}
+			}
+			for (int64 RowC = 0; RowC < M; RowC += GemmMC) {
+				const int64 MC = TMath::Mn<int64>(GemmMC, M - RowC);
+				// pack op(A)(RowC:RowC+MC, DepthC:DepthC+KC) into panels of MR rows
+				for (int64 RowR = 0; RowR < MC; RowR += GemmMR) {
+					double* ApPanel = Ap + RowR * KC;
+					for (int64 DepthN = 0; DepthN < KC; DepthN++) {
+						for (int RowN = 0; RowN < GemmMR; RowN++) {
+							const int64 RowA = RowC + RowR + RowN, ColA = DepthC + DepthN;
+							*ApPanel++ = (RowR + RowN >= MC) ? 0.0 :
+								(TransA ? A[ColA * LdA + RowA] : A[RowA * LdA + ColA]);
+						}
+					}
+				}
+				// multiply the panels and add the blocks to C
+				for (int64 ColR = 0; ColR < NC; ColR += GemmNR) {
+					const int64 NR = TMath::Mn<int64>((int64)GemmNR, NC - ColR);
+					for (int64 RowR = 0; RowR < MC; RowR += GemmMR) {
+						const int64 MR = TMath::Mn<int64>((int64)GemmMR, MC - RowR);
+						GemmKernel(KC, Ap + RowR * KC, Bp + ColR * KC, AB);
+						for (int64 RowN = 0; RowN < MR; RowN++) {
+							double* CRow = C + (RowC + RowR + RowN) * LdC + ColC + ColR;
+							const double* ABRow = AB + RowN * GemmNR;
+							for (int64 ColN = 0; ColN < NR; ColN++) { CRow[ColN] += Alpha * ABRow[ColN]; }
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////
 //// Basic Linear Algebra Operations
 void TLinAlg::LinComb(const double& p, const TIntFltKdV& x, const double& q, const TIntFltKdV& y, TIntFltKdV& z) {
@@ -898,12 +1316,14 @@ void TLinAlg::Multiply(const TVec<TIntFltKdV>& A, const TFltVV& B, TFltVV& C, co
 	}
 	int RowsB = B.GetRows();
 	C.PutAll(0.0);
-	for (int ColN = 0; ColN < ColsB; ColN++) {
-		for (int RowN = 0; RowN < RowsB; RowN++) {
-			int Els = A[RowN].Len();
-			for (int ElN = 0; ElN < Els; ElN++) {
-				C.At(A[RowN][ElN].Key, ColN) += A[RowN][ElN].Dat * B.At(RowN, ColN);
-			}
+	// row Key of C gets the row RowN of B for each element A(Key,RowN)
+	const double* BPtr = (const double*)const_cast<TFltVV&>(B).Get1DVec().BegI();
+	double* CPtr = (double*)C.Get1DVec().BegI();
+	for (int RowN = 0; RowN < RowsB; RowN++) {
+		int Els = A[RowN].Len();
+		for (int ElN = 0; ElN < Els; ElN++) {
+			TLinAlgKernel::AddVec(A[RowN][ElN].Dat, BPtr + (int64)RowN * ColsB,
+				CPtr + (int64)A[RowN][ElN].Key * ColsB, ColsB);
 		}
 	}
 }
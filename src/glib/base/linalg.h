@@ -580,6 +580,71 @@ public:
 	TEMP_LA	static void GetColMinIdxV(const TDenseVV& X, TVec<TNum<TSizeTy>, TSizeTy>& IdxV);
 };
 
+///////////////////////////////////////////////////////////////////////
+/// Vectorized kernels over contiguous arrays of doubles, used by TLinAlg for
+/// vectors of doubles and row major matrices when BLAS is not linked. The
+/// instruction set is selected once at startup from what the CPU supports.
+class TLinAlgKernel {
+public:
+    /// Instruction sets, ordered from the most portable
+    typedef enum { lkScalar = 0, lkSse2 = 1, lkAvx2 = 2 } TKernelType;
+
+private:
+    /// Instruction set used by the kernels
+    static TKernelType KernelType;
+
+public:
+    /// Best instruction set supported by the CPU and the compiler
+    static TKernelType GetBestKernelType();
+    /// Instruction set currently used by the kernels
+    static TKernelType GetKernelType() { return KernelType; }
+    /// Switches to another instruction set, must be supported by the CPU
+    static void SetKernelType(const TKernelType& _KernelType);
+    /// Name of the instruction set, for logging
+    static TStr GetKernelTypeStr(const TKernelType& _KernelType);
+
+    /// Result = <x, y>
+    static double DotProduct(const double* x, const double* y, const int64& Len);
+    /// Result = ||x - y||^2
+    static double EuclDist2(const double* x, const double* y, const int64& Len);
+    /// y := k * x + y
+    static void AddVec(const double& k, const double* x, double* y, const int64& Len);
+    /// z := p * x + q * y, z can be one of x and y
+    static void LinComb(const double& p, const double* x, const double& q, const double* y,
+        double* z, const int64& Len);
+    /// y := k * x, y can be x
+    static void MultiplyScalar(const double& k, const double* x, double* y, const int64& Len);
+
+    /// y := Alpha * op(A) * x + Beta * y, where A is a Rows x Cols row major matrix;
+    /// y is not read when Beta is zero
+    static void Gemv(const bool& TransA, const int64& Rows, const int64& Cols, const double& Alpha,
+        const double* A, const double* x, const double& Beta, double* y);
+    /// C := Alpha * op(A) * op(B) + Beta * C on row major matrices, where op(A) is M x K
+    /// and op(B) is K x N; cache blocked, C is not read when Beta is zero
+    static void Gemm(const bool& TransA, const bool& TransB, const int64& M, const int64& N,
+        const int64& K, const double& Alpha, const double* A, const int64& LdA, const double* B,
+        const int64& LdB, const double& Beta, double* C, const int64& LdC);
+
+    /// Result = <x, y> where y is sparse, elements of y past the length of x are ignored
+    template <class TSizeTy>
+    static double DotProduct(const double* x, const TSizeTy& xLen,
+        const TKeyDat<TNum<TSizeTy>, TFlt>* y, const TSizeTy& yLen);
+};
+
+template <class TSizeTy>
+double TLinAlgKernel::DotProduct(const double* x, const TSizeTy& xLen,
+        const TKeyDat<TNum<TSizeTy>, TFlt>* y, const TSizeTy& yLen) {
+    // two independent sums hide the latency of the gathered loads
+    double Sum0 = 0.0, Sum1 = 0.0; TSizeTy ElN = 0;
+    for (; ElN + 1 < yLen; ElN += 2) {
+        const TSizeTy Key0 = y[ElN].Key, Key1 = y[ElN + 1].Key;
+        if (Key0 < xLen) { Sum0 += y[ElN].Dat * x[Key0]; }
+        if (Key1 < xLen) { Sum1 += y[ElN + 1].Dat * x[Key1]; }
+    }
+    if (ElN < yLen && y[ElN].Key < xLen) { Sum0 += y[ElN].Dat * x[y[ElN].Key]; }
+    return Sum0 + Sum1;
+}
+
 ///////////////////////////////////////////////////////////////////////
 // Basic Linear Algebra operations
 class TLinAlg {
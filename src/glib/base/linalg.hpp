@@ -587,6 +587,11 @@ template <class TType, class TSizeTy, bool ColMajor>
 TType TLinAlg::DotProduct(const TVec<TNum<TType>, TSizeTy>& x,
         const TVec<TNum<TType>, TSizeTy>& y) {
     EAssertR(x.Len() == y.Len(), TStr::Fmt("%d != %d", x.Len(), y.Len()));
+    if (TypeCheck::is_double<TType>::value == true) {
+        typedef double Loc;
+        const Loc Res = TLinAlgKernel::DotProduct((const Loc*)x.BegI(), (const Loc*)y.BegI(), x.Len());
+        return *((const TType*)&Res);
+    }
     TType result = 0.0; const  TSizeTy Len = x.Len();
     for (TSizeTy i = 0; i < Len; i++)
         result += x[i] * y[i];
@@ -645,6 +650,12 @@ TType TLinAlg::DotProduct(const TVec<TKeyDat<TNum<TSizeTy>, TNum<TType>>, TSizeT
 template <class TType, class TSizeTy, bool ColMajor>
 TType TLinAlg::DotProduct(const TVec<TNum<TType>, TSizeTy>& x,
         const TVec<TKeyDat<TNum<TSizeTy>, TNum<TType>>, TSizeTy>& y) {
+    if (TypeCheck::is_double<TType>::value == true) {
+        typedef double Loc;
+        const Loc Res = TLinAlgKernel::DotProduct((const Loc*)x.BegI(), x.Len(),
+            (const TKeyDat<TNum<TSizeTy>, TFlt>*)y.BegI(), y.Len());
+        return *((const TType*)&Res);
+    }
     TType Res = 0.0; const TSizeTy xLen = x.Len(), yLen = y.Len();
     for (TSizeTy i = 0; i < yLen; i++) {
         const TSizeTy key = y[i].Key;
@@ -795,6 +806,11 @@ void TLinAlg::LinComb(const double& p, const TVec<TNum<TType>, TSizeTy>& x,
     } else {
         EAssert(x.Len() == y.Len() && y.Len() == z.Len());
     }
+    if (TypeCheck::is_double<TType>::value == true) {
+        typedef double Loc;
+        TLinAlgKernel::LinComb(p, (const Loc*)x.BegI(), q, (const Loc*)y.BegI(), (Loc*)z.BegI(), x.Len());
+        return;
+    }
     const TSizeTy Len = x.Len();
     for (TSizeTy i = 0; i < Len; i++) {
         z[i] = p * x[i] + q * y[i];
@@ -905,6 +921,11 @@ void TLinAlg::AddVec(const TType& k, const TVec<TNum<TType>, TSizeTy>& x, TVec<T
 
     EAssert(y.Len() == Size);
 
+    if (TypeCheck::is_double<TType>::value == true) {
+        typedef double Loc;
+        TLinAlgKernel::AddVec(*((const Loc*)&k), (const Loc*)x.BegI(), (Loc*)y.BegI(), Size);
+        return;
+    }
     for (int ValN = 0; ValN < Size; ValN++) {
         y[ValN] = k*x[ValN] + y[ValN];
     }
@@ -1016,6 +1037,11 @@ template <class TType, class TSizeTy, bool ColMajor>
 TType TLinAlg::EuclDist2(const TVec<TNum<TType>, TSizeTy>& x,
         const TVec<TNum<TType>, TSizeTy>& y) {
     EAssert(x.Len() == y.Len());
+    if (TypeCheck::is_double<TType>::value == true) {
+        typedef double Loc;
+        const Loc Res = TLinAlgKernel::EuclDist2((const Loc*)x.BegI(), (const Loc*)y.BegI(), x.Len());
+        return *((const TType*)&Res);
+    }
     const TSizeTy len = x.Len();
     TType Res = 0.0;
     for (TSizeTy i = 0; i < len; i++) {
@@ -1483,6 +1509,11 @@ void TLinAlg::Sign(const TVec<TVec<TKeyDat<TNum<TSizeTy>, TNum<TType>>, TSizeTy>
 template <class TType, class TSizeTy, bool ColMajor>
 void TLinAlg::MultiplyScalar(const double& k, TVec<TNum<TType>, TSizeTy>& x) {
     TSizeTy Len = x.Len();
+    if (TypeCheck::is_double<TType>::value == true) {
+        typedef double Loc;
+        TLinAlgKernel::MultiplyScalar(k, (const Loc*)x.BegI(), (Loc*)x.BegI(), Len);
+        return;
+    }
     for (TSizeTy i = 0; i < Len; i++)
         x[i] = k * x[i];
 }
@@ -1498,6 +1529,11 @@ void TLinAlg::MultiplyScalar(const double& k, const TVec<TNum<TType>, TSizeTy>&
     if (y.Empty()) { y.Gen(Len, Len); }
     EAssert(x.Len() == y.Len());
 
+    if (TypeCheck::is_double<TType>::value == true) {
+        typedef double Loc;
+        TLinAlgKernel::MultiplyScalar(k, (const Loc*)x.BegI(), (Loc*)y.BegI(), Len);
+        return;
+    }
     for (TSizeTy i = 0; i < Len; i++) {
         y[i] = k * x[i];
     }
@@ -1525,6 +1561,14 @@ void TLinAlg::MultiplyScalar(const double& k,
     if (Y.Empty()) { Y.Gen(Rows, Cols); }
     EAssert(X.GetRows() == Y.GetRows() && X.GetCols() == Y.GetCols());
 
+    if (TypeCheck::is_double<TType>::value == true) {
+        // both matrices have the same layout, so the values can be scaled as one array
+        typedef double Loc;
+        const TVec<TNum<TType>, TSizeTy>& XValV =
+            const_cast<TVVec<TNum<TType>, TSizeTy, ColMajor>&>(X).Get1DVec();
+        TLinAlgKernel::MultiplyScalar(k, (const Loc*)XValV.BegI(), (Loc*)Y.Get1DVec().BegI(), XValV.Len());
+        return;
+    }
     for (TSizeTy i = 0; i < Rows; i++) {
         for (TSizeTy j = 0; j < Cols; j++) {
             Y(i, j) = k*X(i, j);
@@ -1557,6 +1601,12 @@ void TLinAlg::Multiply(const TVVec<TNum<TType>, TSizeTy, ColMajor>& A,
     TLinAlg::Multiply(A, x, y, TLinAlgBlasTranspose::NOTRANS, 1.0, 0.0);
 #else
     TSizeTy n = A.GetRows(), m = A.GetCols();
+    if (TypeCheck::is_double<TType>::value == true && !ColMajor) {
+        typedef double Loc;
+        const Loc* APtr = (const Loc*)const_cast<TVVec<TNum<TType>, TSizeTy, ColMajor>&>(A).Get1DVec().BegI();
+        TLinAlgKernel::Gemv(false, n, m, 1.0, APtr, (const Loc*)x.BegI(), 0.0, (Loc*)y.BegI());
+        return;
+    }
     for (TSizeTy i = 0; i < n; i++) {
         y[i] = 0.0;
         for (TSizeTy j = 0; j < m; j++) {
@@ -2030,6 +2080,13 @@ void TLinAlg::MultiplyT(const TVVec<TNum<TType>, TSizeTy, ColMajor>& A, const TV
     if (y.Empty()) y.Gen(A.GetCols());
     EAssert(A.GetRows() == x.Len() && A.GetCols() == y.Len());
     TSizeTy n = A.GetCols(), m = A.GetRows();
+    if (TypeCheck::is_double<TType>::value == true && !ColMajor) {
+        // accumulates the rows of A, which are contiguous
+        typedef double Loc;
+        const Loc* APtr = (const Loc*)const_cast<TVVec<TNum<TType>, TSizeTy, ColMajor>&>(A).Get1DVec().BegI();
+        TLinAlgKernel::Gemv(true, m, n, 1.0, APtr, (const Loc*)x.BegI(), 0.0, (Loc*)y.BegI());
+        return;
+    }
     for (TSizeTy i = 0; i < n; i++) {
         y[i] = 0.0;
         for (TSizeTy j = 0; j < m; j++)
@@ -2126,7 +2183,32 @@ template <class TType, class TSizeTy, bool ColMajor>
 inline void TLinAlg::Multiply(const TVVec<TNum<TType>, TSizeTy, ColMajor>& A,
     const TVVec<TNum<TType>, TSizeTy, ColMajor>& B, TVVec<TNum<TType>,
     TSizeTy, ColMajor>& C, const int& BlasTransposeFlagA, const int& BlasTransposeFlagB) {
-    throw TExcept::New("TLinAlg::Multiply(const TVVec<TNum<TType>, TSizeTy, ColMajor>& A, const TVVec<TNum<TType>, TSizeTy, ColMajor>& B, TVVec<TNum<TType>, TSizeTy, ColMajor>& C, const int& BlasTransposeFlagA, const int& BlasTransposeFlagB) not implemented yet!");
+    const bool TransA = BlasTransposeFlagA == TLinAlg::TLinAlgBlasTranspose::TRANS;
+    const bool TransB = BlasTransposeFlagB == TLinAlg::TLinAlgBlasTranspose::TRANS;
+    // op(A) is m x k, op(B) is k x n
+    const TSizeTy m = TransA ? A.GetCols() : A.GetRows();
+    const TSizeTy k = TransA ? A.GetRows() : A.GetCols();
+    const TSizeTy n = TransB ? B.GetRows() : B.GetCols();
+    EAssert(k == (TransB ? B.GetCols() : B.GetRows()));
+    EAssert(m == C.GetRows() && n == C.GetCols());
+
+    if (TypeCheck::is_double<TType>::value == true && !ColMajor) {
+        typedef double Loc;
+        const Loc* APtr = (const Loc*)const_cast<TVVec<TNum<TType>, TSizeTy, ColMajor>&>(A).Get1DVec().BegI();
+        const Loc* BPtr = (const Loc*)const_cast<TVVec<TNum<TType>, TSizeTy, ColMajor>&>(B).Get1DVec().BegI();
+        TLinAlgKernel::Gemm(TransA, TransB, m, n, k, 1.0, APtr, A.GetCols(), BPtr, B.GetCols(),
+            0.0, (Loc*)C.Get1DVec().BegI(), C.GetCols());
+        return;
+    }
+    for (TSizeTy RowN = 0; RowN < m; RowN++) {
+        for (TSizeTy ColN = 0; ColN < n; ColN++) {
+            TType Sum = 0.0;
+            for (TSizeTy ValN = 0; ValN < k; ValN++) {
+                Sum += (TransA ? A(ValN, RowN) : A(RowN, ValN)) * (TransB ? B(ColN, ValN) : B(ValN, ColN));
+            }
+            C(RowN, ColN) = Sum;
+        }
+    }
 }
 
 #endif
@@ -2199,7 +2281,32 @@ void TLinAlg::Multiply(const TVVec<TNum<TType>, TSizeTy, ColMajor>& A, const TVe
 //Andrej ToDo In the future replace TType with TNum<type> and change double to type
 template <class TType, class TSizeTy, bool ColMajor>
 void TLinAlg::Multiply(const TVVec<TNum<TType>, TSizeTy, ColMajor>& A, const TVec<TNum<TType>, TSizeTy>& x, TVec<TNum<TType>, TSizeTy>& y, const int& BlasTransposeFlagA, TType alpha, TType beta) {
-    throw TExcept::New("TLinAlg::Multiply(const TVVec<TNum<TType>, TSizeTy, ColMajor>& A, const TVec<TNum<TType>, TSizeTy>& x, TVec<TNum<TType>, TSizeTy>& y, const int& BlasTransposeFlagA, TType alpha, TType beta) not implemented yet!");
+    TSizeTy m = A.GetRows();
+    TSizeTy n = A.GetCols();
+    const bool TransA = BlasTransposeFlagA == TLinAlg::TLinAlgBlasTranspose::TRANS;
+    if (TransA) {//A'*x n*m x m -> n
+        EAssertR(x.Len() == m, "TLinAlg::Multiply: Invalid dimension of input vector!");
+        if (y.Reserved() != n) { y.Gen(n, n); }
+    } else {//A*x  m x n * n -> m
+        EAssertR(x.Len() == n, "TLinAlg::Multiply: Invalid dimension of input vector!");
+        if (y.Reserved() != m) { y.Gen(m, m); }
+    }
+
+    if (TypeCheck::is_double<TType>::value == true && !ColMajor) {
+        typedef double Loc;
+        const Loc* APtr = (const Loc*)const_cast<TVVec<TNum<TType>, TSizeTy, ColMajor>&>(A).Get1DVec().BegI();
+        TLinAlgKernel::Gemv(TransA, m, n, *((const Loc*)&alpha), APtr, (const Loc*)x.BegI(),
+            *((const Loc*)&beta), (Loc*)y.BegI());
+        return;
+    }
+    const TSizeTy OutLen = TransA ? n : m, InLen = TransA ? m : n;
+    for (TSizeTy OutN = 0; OutN < OutLen; OutN++) {
+        TType Sum = 0.0;
+        for (TSizeTy InN = 0; InN < InLen; InN++) {
+            Sum += (TransA ? A(InN, OutN) : A(OutN, InN)) * x[InN];
+        }
+        y[OutN] = alpha * Sum + beta * y[OutN];
+    }
 }
 
 #endif
@@ -2214,6 +2321,10 @@ void TLinAlg::Multiply(const TVVec<TNum<TType>, TSizeTy, ColMajor>& A,
 #ifdef BLAS
     TLinAlg::Multiply(A, B, C, TLinAlgBlasTranspose::NOTRANS, TLinAlgBlasTranspose::NOTRANS);
 #else
+    if (TypeCheck::is_double<TType>::value == true && !ColMajor) {
+        TLinAlg::Multiply(A, B, C, TLinAlgBlasTranspose::NOTRANS, TLinAlgBlasTranspose::NOTRANS);
+        return;
+    }
     TSizeTy RowsA = A.GetRows();
     TSizeTy ColsA = A.GetCols();
     TSizeTy ColsB = B.GetCols();
@@ -2238,6 +2349,10 @@ void TLinAlg::MultiplyT(const TVVec<TNum<TType>, TSizeTy, ColMajor>& A,
 #ifdef BLAS
     TLinAlg::Multiply(A, B, C, TLinAlgBlasTranspose::TRANS, TLinAlgBlasTranspose::NOTRANS);
 #else
+    if (TypeCheck::is_double<TType>::value == true && !ColMajor) {
+        TLinAlg::Multiply(A, B, C, TLinAlgBlasTranspose::TRANS, TLinAlgBlasTranspose::NOTRANS);
+        return;
+    }
     TSizeTy n = C.GetRows(), m = C.GetCols(), l = A.GetRows(); TType sum;
     for (TSizeTy i = 0; i < n; i++) {
         for (TSizeTy j = 0; j < m; j++) {
@@ -2367,13 +2482,12 @@ void TLinAlg::Multiply(const TFltVV& A, const TVec<TIntFltKdV>& B, TFltVV& C) {
     EAssert(TLinAlgSearch::GetMaxDimIdx(B) + 1 <= A.GetCols());
     int Cols = B.Len();
     int Rows = A.GetRows();
-    C.PutAll(0.0);
+    const int ColsA = A.GetCols();
+    const double* APtr = (const double*)const_cast<TFltVV&>(A).Get1DVec().BegI();
     for (int RowN = 0; RowN < Rows; RowN++) {
         for (int ColN = 0; ColN < Cols; ColN++) {
-            int Els = B[ColN].Len();
-            for (int ElN = 0; ElN < Els; ElN++) {
-                C.At(RowN, ColN) += A.At(RowN, B[ColN][ElN].Key) * B[ColN][ElN].Dat;
-            }
+            C.At(RowN, ColN) = TLinAlgKernel::DotProduct(APtr + (int64)RowN * ColsA, ColsA,
+                B[ColN].BegI(), B[ColN].Len());
         }
     }
 }
@@ -2407,6 +2521,23 @@ void TLinAlg::MultiplyT(const TVVec<TNum<TType>, TSizeTy, ColMajor>& A,
     EAssert(TLinAlgSearch::GetMaxDimIdx(B) + 1 <= A.GetRows());
     TSizeTy Cols = B.Len();
     TSizeTy Rows = A.GetCols();
+    if (TypeCheck::is_double<TType>::value == true && !ColMajor) {
+        // column ColN of C is a combination of the rows of A selected by B(:,ColN)
+        typedef double Loc;
+        const Loc* APtr = (const Loc*)const_cast<TVVec<TNum<TType>, TSizeTy, ColMajor>&>(A).Get1DVec().BegI();
+        TVec<TNum<TType>, TSizeTy> ColV(Rows);
+        for (TSizeTy ColN = 0; ColN < Cols; ColN++) {
+            ColV.PutAll(0.0);
+            const TSizeTy Els = B[ColN].Len();
+            for (TSizeTy ElN = 0; ElN < Els; ElN++) {
+                const TKeyDat<TNum<TSizeTy>, TNum<TType>>& El = B[ColN][ElN];
+                TLinAlgKernel::AddVec(*((const Loc*)&El.Dat.Val), APtr + (int64)El.Key * Rows,
+                    (Loc*)ColV.BegI(), Rows);
+            }
+            for (TSizeTy RowN = 0; RowN < Rows; RowN++) { C.At(RowN, ColN) = ColV[RowN]; }
+        }
+        return;
+    }
     C.PutAll(0.0);
     for (TSizeTy RowN = 0; RowN < Rows; RowN++) {
         for (TSizeTy ColN = 0; ColN < Cols; ColN++) {
@@ -2435,6 +2566,21 @@ void TLinAlg::MultiplyT(const TVec<TVec<TKeyDat<TNum<TSizeTy>, TNum<TType>>, TSi
         EAssert(C.GetRows() == ColsA && C.GetCols() == ColsB);
     }
     C.PutAll(0.0);
+    if (TypeCheck::is_double<TType>::value == true && !ColMajor) {
+        // row RowN of C is a combination of the rows of B selected by A(:,RowN)
+        typedef double Loc;
+        const Loc* BPtr = (const Loc*)const_cast<TVVec<TNum<TType>, TSizeTy, ColMajor>&>(B).Get1DVec().BegI();
+        Loc* CPtr = (Loc*)C.Get1DVec().BegI();
+        for (TSizeTy RowN = 0; RowN < ColsA; RowN++) {
+            const TSizeTy Els = A[RowN].Len();
+            for (TSizeTy ElN = 0; ElN < Els; ElN++) {
+                const TKeyDat<TNum<TSizeTy>, TNum<TType>>& El = A[RowN][ElN];
+                TLinAlgKernel::AddVec(*((const Loc*)&El.Dat.Val), BPtr + (int64)El.Key * ColsB,
+                    CPtr + (int64)RowN * ColsB, ColsB);
+            }
+        }
+        return;
+    }
     for (TSizeTy RowN = 0; RowN < ColsA; RowN++) {
         for (TSizeTy ColN = 0; ColN < ColsB; ColN++) {
             TSizeTy Els = A[RowN].Len();
@@ -2522,6 +2668,17 @@ void TLinAlg::MultiplyT(const TVVec<TNum<TType>, TSizeTy, ColMajor>& A,
         EAssert(ColsA == c.Len());
     }
     c.PutAll(0.0);
+    if (TypeCheck::is_double<TType>::value == true && !ColMajor) {
+        // c is a combination of the rows of A selected by b
+        typedef double Loc;
+        const Loc* APtr = (const Loc*)const_cast<TVVec<TNum<TType>, TSizeTy, ColMajor>&>(A).Get1DVec().BegI();
+        const TSizeTy Els = b.Len();
+        for (TSizeTy ElN = 0; ElN < Els; ElN++) {
+            TLinAlgKernel::AddVec(*((const Loc*)&b[ElN].Dat.Val), APtr + (int64)b[ElN].Key * ColsA,
+                (Loc*)c.BegI(), ColsA);
+        }
+        return;
+    }
     for (TSizeTy ColN = 0; ColN < ColsA; ColN++) {
         int Els = b.Len();
         for (TSizeTy ElN = 0; ElN < Els; ElN++) {
@@ -2585,6 +2742,23 @@ void TLinAlg::Gemm(const double& Alpha, const TVVec<TNum<TType>, TSizeTy, ColMaj
     // assertions for dimensions
     EAssert(a_j == c_j && b_i == c_i && a_i == b_j && c_i == d_i && c_j == d_j);
 
+    if (TypeCheck::is_double<TType>::value == true && !ColMajor && !tC) {
+        // D := C, then D := Alpha * op(A) * op(B) + Beta * D
+        typedef double Loc;
+        Loc* DPtr = (Loc*)D.Get1DVec().BegI();
+        if (&C != &D && Beta != 0.0) {
+            const TVec<TNum<TType>, TSizeTy>& CValV =
+                const_cast<TVVec<TNum<TType>, TSizeTy, ColMajor>&>(C).Get1DVec();
+            const Loc* CPtr = (const Loc*)CValV.BegI();
+            for (TSizeTy ValN = 0; ValN < CValV.Len(); ValN++) { DPtr[ValN] = CPtr[ValN]; }
+        }
+        const Loc* APtr = (const Loc*)const_cast<TVVec<TNum<TType>, TSizeTy, ColMajor>&>(A).Get1DVec().BegI();
+        const Loc* BPtr = (const Loc*)const_cast<TVVec<TNum<TType>, TSizeTy, ColMajor>&>(B).Get1DVec().BegI();
+        TLinAlgKernel::Gemm(tA, tB, a_j, b_i, a_i, Alpha, APtr, A.GetCols(), BPtr, B.GetCols(),
+            Beta, DPtr, D.GetCols());
+        return;
+    }
+
     double Aij, Bij, Cij;
 
     // rows of D
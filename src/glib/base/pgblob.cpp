@@ -6,6 +6,10 @@
 * LICENSE file in the root directory of this source tree.
 */
 
+#ifdef GLib_UNIX
+#include <sys/mman.h>
+#endif
+
 ///////////////////////////////////////////////////////////////////////////
 
 /// Assignment operator
@@ -99,8 +103,8 @@ int TPgBlobPt::GetSecHashCd() const {
 char* TPgBlobFile::EmptyPage = NULL;
 
 /// Private constructor
-TPgBlobFile::TPgBlobFile(
-    const TStr& _FNm, const TFAccess& _Access, const uint32& _MxSegLen) {
+TPgBlobFile::TPgBlobFile(const TStr& _FNm, const TFAccess& _Access,
+    const uint32& _MxSegLen, const bool& MMapP) : MapBf(NULL), MapLen(0) {
 
     // initialize the array used as the empty page - it is stored to disk when new page is allocated
     if (EmptyPage == NULL) {
@@ -133,17 +137,61 @@ TPgBlobFile::TPgBlobFile(
         break;
     }
     PgCnt = (long) (TFile::GetSize(FNm) / PG_PAGE_SIZE);
+    if (MMapP) { MMap(); }
 }
 
 /// Destructor
 TPgBlobFile::~TPgBlobFile() {
+    MUnmap();
     EAssertR(
         fclose(FileId) == 0,
         "Can not close file '" + TStr(FNm.CStr()) + "'.");
 }
 
+/// Map the file into memory
+void TPgBlobFile::MMap() {
+#ifdef GLib_UNIX
+    EAssertR(FileId != NULL, "Can not open file '" + FNm + "'.");
+    // reserve address space for the largest file, so that pages do not move
+    MapLen = (size_t)(MxFileLen > 0 ? MxFileLen : TInt::Mx) + PG_PAGE_SIZE;
+    const int Prot = (Access == faRdOnly) ? PROT_READ : (PROT_READ | PROT_WRITE);
+    void* Bf = mmap(NULL, MapLen, Prot, MAP_SHARED, fileno(FileId), 0);
+    EAssertR(Bf != MAP_FAILED, "Can not memory-map file '" + FNm + "' - " + TStr::Fmt("%d", errno));
+    MapBf = (char*)Bf;
+#endif
+}
+
+/// Flush and unmap the file
+void TPgBlobFile::MUnmap() {
+#ifdef GLib_UNIX
+    if (MapBf == NULL) { return; }
+    if (Access != faRdOnly) { msync(MapBf, PgCnt * PG_PAGE_SIZE, MS_SYNC); }
+    munmap(MapBf, MapLen);
+    MapBf = NULL;
+#endif
+}
+
+/// Address of page inside memory-mapped file
+char* TPgBlobFile::GetMapPageBf(const uint32& Page) const {
+    AssertR((long)Page < PgCnt, "Page outside of memory-mapped file '" + FNm + "'.");
+    return MapBf + (size_t)Page * PG_PAGE_SIZE;
+}
+
+/// Write page of memory-mapped file to disk
+void TPgBlobFile::FlushMapPage(const uint32& Page, const bool& SyncP) {
+#ifdef GLib_UNIX
+    EAssertR(
+        msync(GetMapPageBf(Page), PG_PAGE_SIZE, SyncP ? MS_SYNC : MS_ASYNC) == 0,
+        "Error flushing file '" + TStr(FNm) + "'.");
+#endif
+}
+
 /// Load page with given index from the file into buffer
 int TPgBlobFile::LoadPage(const uint32& Page, void* Bf) {
+    if (IsMMap()) {
+        memcpy(Bf, GetMapPageBf(Page), PG_PAGE_SIZE);
+        return 0;
+    }
     SetFPos(Page * PG_PAGE_SIZE);
     EAssertR(
         fread(Bf, 1, PG_PAGE_SIZE, FileId) == PG_PAGE_SIZE,
@@ -153,8 +201,14 @@ int TPgBlobFile::LoadPage(const uint32& Page, void* Bf) {
 
 /// Save buffer to page within the file
 int TPgBlobFile::SavePage(const uint32& Page, const void* Bf, int Len) {
-    SetFPos(Page * PG_PAGE_SIZE);
     Len = (Len <= 0 ? PG_PAGE_SIZE : Len);
+    if (IsMMap()) {
+        EAssertR(Access != TFAccess::faRdOnly, "Error writing file '" + TStr(FNm) + "'.");
+        char* PageBf = GetMapPageBf(Page);
+        if (PageBf != Bf) { memcpy(PageBf, Bf, Len); }
+        return 0;
+    }
+    SetFPos(Page * PG_PAGE_SIZE);
     EAssertR(
         (Access != TFAccess::faRdOnly) && (int)fwrite(Bf, 1, Len, FileId) == Len,
         "Error writing file '" + TStr(FNm) + "'.");
@@ -186,6 +240,8 @@ long TPgBlobFile::CreateNewPage() {
     }
     size_t written = fwrite(EmptyPage, PG_PAGE_SIZE, 1, FileId);
     EAssertR(written == 1, "Error writing file '" + TStr(FNm) + "'.");
+    // memory-mapped page must be in the file before it is accessed
+    if (IsMMap()) { EAssertR(fflush(FileId) == 0, "Error writing file '" + TStr(FNm) + "'."); }
     PgCnt++;
     return len / PG_PAGE_SIZE;
 }
@@ -294,11 +350,16 @@ TPgBlob::TPgBlobPageItem* TPgBlob::GetItemRec(
 
 /// Private constructor
 TPgBlob::TPgBlob(const TStr& _FNm, const TFAccess& _Access,
-    const uint64& CacheSize) {
+    const uint64& CacheSize, const bool& _MMapP) {
     EAssertR(CacheSize >= PG_PAGE_SIZE, "Invalid cache size for TPgBlob.");
 
     FNm = _FNm;
     Access = _Access;
+    MMapP = _MMapP;
+#ifndef GLib_UNIX
+    // memory-mapping not supported, pages are copied into cache
+    MMapP = false;
+#endif
 
     switch (Access) {
     case faCreate:
@@ -325,7 +386,12 @@ TPgBlob::~TPgBlob() {
         for (int i = 0; i < LoadedPages.Len(); i++) {
             if (ShouldSavePage(i)) {
                 LoadedPage& a = LoadedPages[i];
-                Files[a.Pt.GetFIx()]->SavePage(a.Pt.GetPg(), GetPageBf(i));
+                if (MMapP) {
+                    // memory-mapped pages are written when files are unmapped
+                    ((TPgHeader*)GetPageBf(i))->SetDirty(false);
+                } else {
+                    Files[a.Pt.GetFIx()]->SavePage(a.Pt.GetPg(), GetPageBf(i));
+                }
             }
         }
         SaveMain();
@@ -339,6 +405,7 @@ void TPgBlob::SaveMain() {
     TInt children_cnt(Files.Len());
     children_cnt.Save(SOut);
     Fsm.Save(SOut);
+    TBool(MMapP).Save(SOut);
 }
 
 /// Load main file
@@ -347,10 +414,18 @@ void TPgBlob::LoadMain() {
     TInt children_cnt;
     children_cnt.Load(SIn);
     Fsm.Load(SIn);
+    // storage created before memory-mapping was supported does not have the flag
+    TBool MMapB(false);
+    if (!SIn.Eof()) { MMapB.Load(SIn); }
+    MMapP = MMapB;
+#ifndef GLib_UNIX
+    // memory-mapping not supported, pages are copied into cache
+    MMapP = false;
+#endif
     Files.Clr();
     for (int i = 0; i < children_cnt; i++) {
         TStr FNmChild = FNm + ".bin" + TStr::GetNrNumFExt(i);
-        Files.Add(TPgBlobFile::New(FNmChild, Access, MxBlobFLen));
+        Files.Add(TPgBlobFile::New(FNmChild, Access, MxBlobFLen, MMapP));
     }
 }
 
@@ -440,7 +515,13 @@ int TPgBlob::Evict() {
     UnlistFromLru(Pg);
     LoadedPagesH.DelKey(a.Pt);
     char* PgPt = GetPageBf(Pg);
-    if (ShouldSavePageP(PgPt)) {
+    if (MMapP) {
+        // data is already in the mapped file, just start writing it out
+        if (Access != TFAccess::faRdOnly && ShouldSavePageP(PgPt)) {
+            ((TPgHeader*)PgPt)->SetDirty(false);
+            Files[a.Pt.GetFIx()]->FlushMapPage(a.Pt.GetPg(), false);
+        }
+    } else if (ShouldSavePageP(PgPt)) {
         int Len = (((TPgHeader*)PgPt)->ItemCount > 0 ? -1 : sizeof(TPgHeader));
         Files[a.Pt.GetFIx()]->SavePage(a.Pt.GetPg(), PgPt, Len);
     } else {
@@ -459,31 +540,34 @@ char* TPgBlob::LoadPage(const TPgBlobPgPt& Pt, const bool& LoadData) {
         // evict last page + load new page
         Pg = Evict();
         LoadedPage& a = LoadedPages[Pg];
-        if (LoadData) {
+        a.Pt = Pt;
+        if (LoadData && !MMapP) {
             Files[Pt.GetFIx()]->LoadPage(Pt.GetPg(), GetPageBf(Pg));
         }
-        a.Pt = Pt;
         EnlistToStartLru(Pg);
         LoadedPagesH.AddDat(Pt, Pg);
     } else {
         // simply load the page
-        LastExtentCnt++;
-        if (LastExtentCnt >= PG_EXTENT_PCOUNT) {
-            Extents.Add();
-            Extents.Last() = TMemBase(PG_EXTENT_SIZE);
-            LastExtentCnt = 0;
+        if (!MMapP) {
+            LastExtentCnt++;
+            if (LastExtentCnt >= PG_EXTENT_PCOUNT) {
+                Extents.Add();
+                Extents.Last() = TMemBase(PG_EXTENT_SIZE);
+                LastExtentCnt = 0;
+            }
         }
         Pg = LoadedPages.Add();
         LoadedPage& a = LoadedPages[Pg];
-        if (LoadData) {
+        a.Pt = Pt;
+        if (LoadData && !MMapP) {
             Files[Pt.GetFIx()]->LoadPage(Pt.GetPg(), GetPageBf(Pg));
         }
-        a.Pt = Pt;
         EnlistToStartLru(Pg);
         LoadedPagesH.AddDat(Pt, Pg);
     }
     char* PgPt = GetPageBf(Pg);
-    ((TPgHeader*)PgPt)->SetDirty(false);
+    // mapped page keeps its dirty flag until it is flushed
+    if (!MMapP) { ((TPgHeader*)PgPt)->SetDirty(false); }
     return PgPt;
 }
 
@@ -501,7 +585,7 @@ void TPgBlob::CreateNewPage(TPgBlobPgPt& Pt, char** Bf) {
         }
     }
     TStr NewFNm = FNm + ".bin" + TStr::GetNrNumFExt(Files.Len());
-    Files.Add(TPgBlobFile::New(NewFNm, TFAccess::faCreate, MxBlobFLen));
+    Files.Add(TPgBlobFile::New(NewFNm, TFAccess::faCreate, MxBlobFLen, MMapP));
     long Pg = Files.Last()->CreateNewPage();
     EAssert(Pg >= 0);
     Pt.Set(Files.Len() - 1, (uint32)Pg);
@@ -510,8 +594,8 @@ void TPgBlob::CreateNewPage(TPgBlobPgPt& Pt, char** Bf) {
 }
 
 /// Factory method for creating new BLOB storage
-PPgBlob TPgBlob::Create(const TStr& FNm, const uint64& CacheSize) {
-    return PPgBlob(new TPgBlob(FNm, TFAccess::faCreate, CacheSize));
+PPgBlob TPgBlob::Create(const TStr& FNm, const uint64& CacheSize, const bool& MMapP) {
+    return PPgBlob(new TPgBlob(FNm, TFAccess::faCreate, CacheSize, MMapP));
 }
 
 /// Factory method for opening existing BLOB storage
@@ -684,7 +768,13 @@ void TPgBlob::PartialFlush(int WndInMsec) {
     for (int i = 0; i < LoadedPages.Len(); i++) {
         if (ShouldSavePage(i)) {
             LoadedPage& a = LoadedPages[i];
-            Files[a.Pt.GetFIx()]->SavePage(a.Pt.GetPg(), GetPageBf(i));
+            if (MMapP) {
+                // clear the flag first, so the flushed page is clean on disk
+                ((TPgHeader*)GetPageBf(i))->SetDirty(false);
+                Files[a.Pt.GetFIx()]->FlushMapPage(a.Pt.GetPg());
+            } else {
+                Files[a.Pt.GetFIx()]->SavePage(a.Pt.GetPg(), GetPageBf(i));
+            }
             if (sw.GetMSec() > WndInMsec)
                 break;
         }
@@ -713,6 +803,7 @@ PJsonVal TPgBlob::GetStats() {
     res->AddToObj("dirty_pages", dirty);
     res->AddToObj("loaded_extents", Extents.Len());
     res->AddToObj("cache_size", PG_EXTENT_SIZE * Extents.Len());
+    res->AddToObj("mmap", MMapP);
     return res;
 }
 
@@ -216,7 +216,9 @@ public:
 };
 
 ///////////////////////////////////////////////////////////////////////
-/// Single Paged-Blob-storage file
+/// Single Paged-Blob-storage file.
+/// When memory-mapped, the whole address range up to the maximal file
+/// length is reserved at open, so page addresses stay valid as file grows.
 class TPgBlobFile {
 private:
 
@@ -230,16 +232,24 @@ private:
     TFAccess Access;
     /// Random-access file - BLOB storage
     FILE* FileId;
+    /// Start of memory-mapped file, NULL when not mapped
+    char* MapBf;
+    /// Length of reserved memory-mapped range
+    size_t MapLen;
     static char* EmptyPage;
 
     /// Private constructor
     TPgBlobFile(const TStr& _FNm, const TFAccess& _Access = faRdOnly,
-        const uint32& _MxSegLen = -1);
+        const uint32& _MxSegLen = -1, const bool& MMapP = false);
 
     /// Refresh the position - internal check
     void RefreshFPos();
     /// Set position in the file
     void SetFPos(const int& FPos);
+    /// Map the file into memory
+    void MMap();
+    /// Flush and unmap the file
+    void MUnmap();
 
 public:
     /// Reference count for smart pointers
@@ -250,10 +260,17 @@ public:
 
     /// Factory method
     static PPgBlobFile New(const TStr& FNm, const TFAccess& Access = faRdOnly,
-        const uint32& MxSegLen = -1) {
-        return PPgBlobFile(new TPgBlobFile(FNm, Access, MxSegLen));
+        const uint32& MxSegLen = -1, const bool& MMapP = false) {
+        return PPgBlobFile(new TPgBlobFile(FNm, Access, MxSegLen, MMapP));
     }
 
+    /// Is file memory-mapped
+    bool IsMMap() const { return MapBf != NULL; }
+    /// Address of page inside memory-mapped file
+    char* GetMapPageBf(const uint32& Page) const;
+    /// Write page of memory-mapped file to disk
+    void FlushMapPage(const uint32& Page, const bool& SyncP = true);
+
     /// Load page with given index from the file into buffer
     int LoadPage(const uint32& Page, void* Bf);
     /// Save buffer to page within the file
@@ -362,9 +379,16 @@ protected:
     ///// Memory buffer - cache
     /// Maximal number of loaded pages
     uint64 MxLoadedPages;
+    /// Are files memory-mapped. Loaded pages then point directly into mapped
+    /// files and the cache only keeps track of recently used and dirty pages.
+    bool MMapP;
 
     /// Returns starting address of page in Bf
     char* GetPageBf(int Pg) {
+        if (MMapP) {
+            const TPgBlobPgPt& Pt = LoadedPages[Pg].Pt;
+            return Files[Pt.GetFIx()]->GetMapPageBf(Pt.GetPg());
+        }
         return
             Extents[Pg / PG_EXTENT_PCOUNT].GetBf() +
             PG_PAGE_SIZE *(Pg % PG_EXTENT_PCOUNT);
@@ -431,13 +455,16 @@ public:
     /// Reference count for smart pointers
     TCRef CRef;
 
-    /// Constructor
-    TPgBlob(const TStr& _FNm, const TFAccess& _Access, const uint64& CacheSize);
+    /// Constructor. MMapP is used only when creating new storage,
+    /// existing storage is opened with the backend it was created with.
+    TPgBlob(const TStr& _FNm, const TFAccess& _Access, const uint64& CacheSize,
+        const bool& _MMapP = false);
     /// Destructor
     ~TPgBlob();
 
     /// Factory method for creating new BLOB storage
-    static PPgBlob Create(const TStr& FNm, const uint64& CacheSize = 10 * TNum<int>::Mega);
+    static PPgBlob Create(const TStr& FNm, const uint64& CacheSize = 10 * TNum<int>::Mega,
+        const bool& MMapP = false);
     /// Factory method for opening existing BLOB storage
     static PPgBlob Open(const TStr& FNm, const uint64& CacheSize = 10 * TNum<int>::Mega);
 
@@ -460,6 +487,8 @@ public:
 
     /// Save part of the data, given time-window
     void PartialFlush(int WndInMsec = 500);
+    /// Are files memory-mapped
+    bool IsMMap() const { return MMapP; }
     /// Retrieve statistics for this object
     PJsonVal GetStats();
 
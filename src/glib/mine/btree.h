@@ -110,6 +110,7 @@ public:
 // Interface:
 // - void         Clr()
 // - TKeyLocation Add(TKey, TDat)  -- adds the key to the tree; duplicate keys are allowed, but might confuse some of the other functions
+// - void         BulkLoad(TKdV)   -- builds an empty tree bottom-up from (key, dat) pairs sorted by key, with leaves filled to full capacity
 // - bool         Del(TKey)        -- if the key exists, deletes it and returns true; otherwise returns false; if multiple copies of the key exist, an arbitrary one is deleted
 // - bool         Del(TKey, TDat&) -- same as above, but also returns the corresponding dat (if the key was found)
 // - void         Dump(FILE *f)    -- generated a text dump of the tree
@@ -117,6 +118,7 @@ public:
 // - int          RangeQuery_(minKey, maxKey, includeMin, includeMax, TSink&)  -- calls sink(key, dat) for each key from the range minKey <= key <= maxKey [or < if includeMin/includeMax is false]; returns # of calls made
 // - int          RangeQuery(minKey, maxKey, TKeyV&) -- puts all keys in the range 'minKey <= key <= maxKey' into the destination vector
 // - int          RangeQuery(minKey, maxKey, TKeyDatV&) -- puts (key, dat) for all keys in the range 'minKey <= key <= maxKey' into the destination vector
+// - int          RangeCount(minKey, maxKey, maxCount) -- number of keys in the range 'minKey <= key <= maxKey', counting stops at maxCount
 // - bool         IsKey(key)       -- returns true iff the given key is present in the tree
 // - bool         IsKeyGetDat(key, TDat&) -- like IsKey(), but also returns the corresponding dat if the key is found
 //
@@ -428,6 +430,82 @@ public:
 		return retVal;
 	}
 
+//----------------------------------------------------------------------------
+// Bulk loading
+//----------------------------------------------------------------------------
+
+protected:
+
+	// Splits 'n' entries into nodes of at most '2 * capacity - 1' entries.  All the nodes are full,
+	// except that the last two nodes share their entries evenly if the last one would otherwise
+	// end up with fewer than 'capacity' entries.  Stores the number of entries of each node into 'lenV'.
+	static void BulkLoad_NodeLens(int n, int capacity, TIntV &lenV)
+	{
+		lenV.Clr(); const int full = 2 * capacity - 1;
+		while (n > 0) { int len = (n < full) ? n : full; lenV.Add(len); n -= len; }
+		int nNodes = lenV.Len();
+		if (nNodes >= 2 && lenV[nNodes - 1] < capacity) {
+			int total = lenV[nNodes - 2] + lenV[nNodes - 1];
+			lenV[nNodes - 2] = total - total / 2; lenV[nNodes - 1] = total / 2; }
+	}
+
+	// Builds one level of the tree from the given sorted entries, linking the new nodes with their
+	// 'prev' and 'next' pointers.  For each new node, a (maxKey, nodeId) entry is added to 'parentV',
+	// which is then used to build the level above.
+	template <typename TStore_, typename TNodeKdV>
+	void BulkLoad_Level(const TPt<TStore_> &store, const TNodeKdV &kdV, int capacity,
+		typename TInternalNode::TKdV &parentV, TNodeId &levelFirst, TNodeId &levelLast)
+	{
+		TIntV lenV; BulkLoad_NodeLens(kdV.Len(), capacity, lenV);
+		parentV.Gen(lenV.Len(), 0);
+		TNodeAutoPtr<TStore_> pPrev;
+		for (int nodeN = 0, kdN = 0; nodeN < lenV.Len(); nodeN++)
+		{
+			TNodeId node = store->AllocNode();
+			TNodeAutoPtr<TStore_> pNode(store, node, true);
+			pNode->Clr(); pNode->v.Gen(lenV[nodeN], 0);
+			for (int i = 0; i < lenV[nodeN]; i++, kdN++) {
+				IAssert(kdN == 0 || cmp(kdV[kdN - 1].Key, kdV[kdN].Key) <= 0);
+				pNode->v.Add(kdV[kdN]); }
+			if (pPrev.Empty()) levelFirst = node;
+			else { pPrev->next = node; pNode->prev = pPrev.GetNodeId(); }
+			parentV.Add(typename TInternalNode::TKd(pNode->v.Last().Key, node));
+			levelLast = node;
+			pPrev = pNode;
+		}
+	}
+
+public:
+
+	// Builds the tree bottom-up from (key, dat) pairs which are sorted by key.  The tree must be
+	// empty.  Leaves are filled to their full capacity in a single pass over the pairs, and each
+	// level of internal nodes is then built from the nodes of the level below, so that no node
+	// needs to be split.  Adding keys to such a tree afterwards works as usual.
+	void BulkLoad(const TKdV& kdV)
+	{
+		IAssert(nLevels == 1);
+		if (kdV.Empty()) return;
+		// Build the leaves, and then the internal levels until the top one fits into the root.
+		TNodeIdV levelFirstV, levelLastV; TNodeId levelFirst = -1, levelLast = -1;
+		typename TInternalNode::TKdV levelV, parentV;
+		BulkLoad_Level(leafStore, kdV, leafCapacity, levelV, levelFirst, levelLast);
+		levelFirstV.Add(levelFirst); levelLastV.Add(levelLast);
+		while (levelV.Len() > 2 * internalCapacity - 1) {
+			BulkLoad_Level(internalStore, levelV, internalCapacity, parentV, levelFirst, levelLast);
+			levelFirstV.Add(levelFirst); levelLastV.Add(levelLast);
+			levelV.Swap(parentV); }
+		{
+			PInternalNode pRoot(internalStore, root, true);
+			pRoot->v = levelV;
+		}
+		// Levels were built from the leaves upwards, while 'first' and 'last' go from the root down.
+		nLevels = levelFirstV.Len() + 1;
+		first.Gen(nLevels, 0); last.Gen(nLevels, 0);
+		first.Add(root); last.Add(root);
+		for (int level = levelFirstV.Len() - 1; level >= 0; level--) {
+			first.Add(levelFirstV[level]); last.Add(levelLastV[level]); }
+	}
+
 //----------------------------------------------------------------------------
 // Deletion of keys
 //----------------------------------------------------------------------------
@@ -728,6 +806,11 @@ public:
 		TFindSink(TDat *dat_ = 0) : found(false), dat(dat_) { }
 		bool operator()(const TKey &key, const TDat &dat_) { found = true; if (dat) *dat =dat_; return false; } };
 
+	struct TCountSink {
+		int count, maxCount;
+		TCountSink(int maxCount_) : count(0), maxCount(maxCount_) { }
+		bool operator()(const TKey &key, const TDat &dat) { count++; return count < maxCount; } };
+
 public:
 
 	int RangeQuery(const TKey& minKey, const TKey& maxKey, TKeyV& dest, bool ClrDest = true) const {
@@ -738,6 +821,11 @@ public:
 		if (ClrDest) dest.Clr();
 		TKeyDatSink sink(dest); return RangeQuery_(minKey, maxKey, true, true, sink); }
 
+	// Counts the keys in the range 'minKey <= key <= maxKey', but stops once maxCount keys are found.
+	int RangeCount(const TKey& minKey, const TKey& maxKey, int maxCount) const {
+		if (maxCount <= 0) return 0;
+		TCountSink sink(maxCount); return RangeQuery_(minKey, maxKey, true, true, sink); }
+
 	bool IsKey(const TKey& key) const {
 		TFindSink sink; RangeQuery_(key, key, true, true, sink); return sink.found; }
 
@@ -1096,6 +1184,172 @@ public:
 			IAssert(nodes[node]->checkedOut == 0); }}
 };
 
+//----------------------------------------------------------------------------
+// TBtreeNodePgStore
+//----------------------------------------------------------------------------
+//
+// This store keeps the nodes serialized in a paged blob (TPgBlob) on disk, so the
+// tree does not have to fit in memory.  Nodes are deserialized when checked out and
+// kept in an LRU cache of limited size; dirty nodes are written back to the blob when
+// they are evicted from the cache, flushed or when the store is saved.  A checked out
+// node remains valid even if it gets evicted from the cache before it is checked in.
+// The blob is opened on the first node access, so loading a large tree is cheap.
+// Only the mapping from node IDs to blob pointers is serialized with the store,
+// the location of the blob has to be given with Open() after loading.
+
+template <typename TKey_, typename TDat_, typename TNodeId_>
+class TBtreeNodePgStore
+{
+public:
+	TCRef CRef;
+	typedef TKey_ TKey;
+	typedef TDat_ TDat;
+	typedef TNodeId_ TNodeId;
+	typedef TBtreeNode<TKey, TDat, TNodeId> TNode;
+	typedef TVec<TNodeId> TNodeIdV;
+
+protected:
+	class TNodeWrapper;
+	typedef TPt<TNodeWrapper> PNodeWrapper;
+	class TNodeWrapper
+	{
+	private:
+		TCRef CRef;
+		friend class TPt<TNodeWrapper>;
+	public:
+		TNode node;
+		// true when the node was modified since it was last written to the blob
+		bool dirty;
+
+		TNodeWrapper() : dirty(false) { }
+		uint64 GetMemUsed() const { return sizeof(TNodeWrapper) + node.v.Reserved() * sizeof(typename TNode::TKd); }
+		// called by the cache on eviction and flush
+		void OnDelFromCache(const TNodeId& nodeId, void* RefToBs) {
+			if (dirty) { ((TBtreeNodePgStore*)RefToBs)->SaveNode(nodeId, node); dirty = false; } }
+	};
+
+	// blob location and parameters, not serialized
+	TStr FNm;
+	TFAccess Access;
+	uint64 BlobCacheSize;
+	PPgBlob Blob;
+	// location of each node in the blob, empty for free nodes and nodes not yet written
+	TVec<TPgBlobPt> NodePtV;
+	TNodeIdV freeNodes;
+	// deserialized nodes, least recently used ones are evicted first
+	TCache<TNodeId, PNodeWrapper> NodeCache;
+	// nodes currently checked out, kept alive here even when evicted from the cache
+	THash<TNodeId, PNodeWrapper> CheckOutH;
+
+	TPgBlob* GetBlob() {
+		if (Blob.Empty()) {
+			IAssertR(!FNm.Empty(), "Paged b-tree node store not opened");
+			Blob = new TPgBlob(FNm, Access, BlobCacheSize); }
+		return Blob(); }
+
+	void SaveNode(const TNodeId& nodeId, const TNode& node) {
+		TMOut MOut; node.Save(MOut);
+		TPgBlob* PgBlob = GetBlob();
+		IAssertR(MOut.Len() <= PgBlob->GetMxBlobLen(), "B-tree node does not fit in a blob page");
+		TPgBlobPt& Pt = NodePtV[nodeId];
+		Pt = Pt.Empty() ? PgBlob->Put(MOut.GetBfAddr(), MOut.Len()) : PgBlob->Put(MOut.GetBfAddr(), MOut.Len(), Pt); }
+
+	PNodeWrapper LoadNode(const TNodeId& nodeId) {
+		IAssert(!NodePtV[nodeId].Empty());
+		TThinMIn MIn = GetBlob()->Get(NodePtV[nodeId]);
+		PNodeWrapper w = new TNodeWrapper();
+		w->node.Load(MIn);
+		return w; }
+
+public:
+
+	TBtreeNodePgStore(const int64& CacheSize = 16 * TInt::Mega, const uint64& _BlobCacheSize = 16 * TInt::Mega) :
+		Access(faCreate), BlobCacheSize(_BlobCacheSize), NodeCache(CacheSize, 1024, this) { }
+	TBtreeNodePgStore(TSIn& SIn, const int64& CacheSize = 16 * TInt::Mega, const uint64& _BlobCacheSize = 16 * TInt::Mega) :
+		Access(faUpdate), BlobCacheSize(_BlobCacheSize), NodePtV(SIn), freeNodes(SIn), NodeCache(CacheSize, 1024, this) { }
+	static TPt<TBtreeNodePgStore> Load(TSIn &SIn) { return new TBtreeNodePgStore(SIn); }
+	// Writes all dirty nodes to the blob and saves the node locations.
+	void Save(TSOut &SOut) { Flush(); NodePtV.Save(SOut); freeNodes.Save(SOut); }
+
+	// Sets the blob location; the blob is created or opened on first use.
+	void Open(const TStr& _FNm, const TFAccess& _Access) {
+		IAssert(Blob.Empty()); FNm = _FNm; Access = _Access; }
+
+	TNodeId AllocNode() {
+		TNodeId node;
+		if (freeNodes.Empty()) node = NodePtV.Add();
+		else { node = freeNodes.Last(); freeNodes.DelLast(); Assert(node >= 0); Assert(node < NodePtV.Len()); Assert(NodePtV[node].Empty()); }
+		// new node only exists in the cache until it is written
+		PNodeWrapper w = new TNodeWrapper(); w->dirty = true;
+		NodeCache.Put(node, w);
+		return node; }
+
+	void FreeNode(const TNodeId& nodeId) {
+		Assert(nodeId >= 0); IAssert(nodeId < NodePtV.Len());
+		Assert(! CheckOutH.IsKey(nodeId));
+		NodeCache.Del(nodeId, false);
+		if (! NodePtV[nodeId].Empty()) { GetBlob()->Del(NodePtV[nodeId]); NodePtV[nodeId].Clr(); }
+		freeNodes.Add(nodeId); }
+
+	TNode *CheckOutNode(const TNodeId& nodeId)
+	{
+		Assert(nodeId >= 0); IAssert(nodeId < NodePtV.Len());
+		Assert(! CheckOutH.IsKey(nodeId));
+		PNodeWrapper w;
+		if (! NodeCache.Get(nodeId, w)) w = LoadNode(nodeId);
+		// moves the node to the front of the LRU list
+		NodeCache.Put(nodeId, w);
+		CheckOutH.AddDat(nodeId, w);
+		return &w->node;
+	}
+
+	void CheckInNode(const TNodeId& nodeId, TNode *node, bool dirty)
+	{
+		Assert(nodeId >= 0); Assert(nodeId < NodePtV.Len());
+		PNodeWrapper w = CheckOutH.GetDat(nodeId);
+		Assert(node == &w->node);
+		CheckOutH.DelKey(nodeId);
+		if (dirty) {
+			// re-add to the cache, so the memory footprint of the changed node is updated
+			w->dirty = true;
+			NodeCache.Del(nodeId, false); NodeCache.Put(nodeId, w); }
+		else if (! NodeCache.IsKey(nodeId)) {
+			// node got evicted while checked out
+			NodeCache.Put(nodeId, w); }
+	}
+
+	void Clr() {
+		IAssert(CheckOutH.Empty());
+		TNodeIdV nodeIdV; void* KeyDatP = NodeCache.FFirstKeyDat();
+		TNodeId nodeId; PNodeWrapper w;
+		while (NodeCache.FNextKeyDat(KeyDatP, nodeId, w)) nodeIdV.Add(nodeId);
+		for (int i = 0; i < nodeIdV.Len(); i++) NodeCache.Del(nodeIdV[i], false);
+		if (! NodePtV.Empty()) GetBlob()->Clr();
+		NodePtV.Clr(); freeNodes.Clr(); }
+
+	// Writes all dirty nodes from the cache to the blob.
+	void Flush() {
+		IAssert(CheckOutH.Empty());
+		NodeCache.Flush(); }
+
+	// Writes dirty nodes to the blob, starting with the least recently used ones,
+	// and flushes the blob pages, until the time window runs out.  Returns the number
+	// of nodes written.
+	int PartialFlush(const int& WndInMsec) {
+		IAssert(CheckOutH.Empty());
+		TTmStopWatch StopWatch(true); int nSaved = 0;
+		void* KeyDatP = NodeCache.FLastKeyDat();
+		TNodeId nodeId; PNodeWrapper w;
+		while (NodeCache.FPrevKeyDat(KeyDatP, nodeId, w) && StopWatch.GetMSecInt() < WndInMsec) {
+			if (w->dirty) { SaveNode(nodeId, w->node); w->dirty = false; nSaved++; }}
+		const int RestMSecs = WndInMsec - StopWatch.GetMSecInt();
+		if (! Blob.Empty() && RestMSecs > 0) Blob->PartialFlush(RestMSecs);
+		return nSaved; }
+
+	// Dummy method for compatibility with TBtreeNodeMemStore_Paranoid.
+	void IAssertNoCheckouts() { IAssert(CheckOutH.Empty()); }
+};
+
 }
 
 #endif // ____BTREE_H_INCLUDED____
@@ -25,6 +25,117 @@ PDist TDist::Load(TSIn& SIn) {
 const TStr TEuclDist::TYPE = "euclidean";
 const TStr TCosDist::TYPE = "cos";
 
+///////////////////////////////////////////
+// K-Means iteration
+TKMeansIter::TKMeansIter(const int& _Threads, const PDist& Dist, const bool& _BoundsP):
+		Threads(_Threads),
+		EuclP(Dist->GetType() == TEuclDist::TYPE),
+		BoundsP(_BoundsP && EuclP),
+		BoundsValidP(false) {
+	EAssertR(Threads > 0, "Number of threads must be positive!");
+	EAssertR(IsDist(Dist), "Unsupported distance: " + Dist->GetType());
+}
+
+bool TKMeansIter::IsDist(const PDist& Dist) {
+	return Dist->GetType() == TEuclDist::TYPE || Dist->GetType() == TCosDist::TYPE;
+}
+
+void TKMeansIter::SetCentroids(const TFltVV& CentroidVV) {
+	CentKxDVV.Gen(CentroidVV.GetCols(), CentroidVV.GetRows());
+	TLinAlg::Transpose(CentroidVV, CentKxDVV);
+	UpdateCentroidDists();
+	BoundsValidP = false;
+}
+
+void TKMeansIter::InitData(const TFltVV& FtrVV) {
+	EAssertR(FtrVV.GetRows() == GetDim(), "Dimension of the instances doesn't match the centroids!");
+	TLinAlg::GetColNorm2V(FtrVV, NormX2V);
+	BoundsValidP = false;
+}
+
+void TKMeansIter::InitData(const TVec<TIntFltKdV>& FtrVV) {
+	EAssertR(TLinAlgSearch::GetMaxDimIdx(FtrVV) < GetDim(), "Dimension of the instances doesn't match the centroids!");
+	TLinAlg::GetColNorm2V(FtrVV, NormX2V);
+	BoundsValidP = false;
+}
+
+void TKMeansIter::GetCountV(const TIntV& AssignV, const int& K, TIntV& CountV) const {
+	CountV.Gen(K);
+	for (int InstN = 0; InstN < AssignV.Len(); InstN++) {
+		CountV[AssignV[InstN]]++;
+	}
+}
+
+double TKMeansIter::GetQuasiDist(const TFltV& InstV, const int& InstN, const int& ClustN) const {
+	const double* InstP = &InstV[0].Val;
+	const double* CentP = &CentKxDVV(ClustN, 0).Val;
+	if (EuclP) {
+		return TLinAlgKernel::EuclDist2(InstP, CentP, InstV.Len());
+	}
+	const double Dot = TLinAlgKernel::DotProduct(InstP, CentP, InstV.Len());
+	return 1 - Dot / TMath::Sqrt(NormC2V[ClustN]) / TMath::Sqrt(NormX2V[InstN]);
+}
+
+double TKMeansIter::GetQuasiDist(const TIntFltKdV& InstV, const int& InstN, const int& ClustN) const {
+	const double Dot = InstV.Empty() ? 0.0 : TLinAlgKernel::DotProduct(&CentKxDVV(ClustN, 0).Val,
+		GetDim(), InstV.BegI(), InstV.Len());
+	if (EuclP) {
+		// cancellation can make the distance slightly negative
+		return TMath::Mx(NormX2V[InstN] - 2*Dot + NormC2V[ClustN], 0.0);
+	}
+	return 1 - Dot / TMath::Sqrt(NormC2V[ClustN]) / TMath::Sqrt(NormX2V[InstN]);
+}
+
+void TKMeansIter::AddInsts(const TFltVV& FtrVV, const TIntV& AssignV, const int& StartN,
+		const int& EndN, TFltVV& SumKxDVV) {
+	const int Dim = FtrVV.GetRows();
+	// go over the rows, so the instances are read in the order they are stored
+	for (int DimN = 0; DimN < Dim; DimN++) {
+		for (int InstN = StartN; InstN < EndN; InstN++) {
+			SumKxDVV(AssignV[InstN], DimN) += FtrVV(DimN, InstN);
+		}
+	}
+}
+
+void TKMeansIter::AddInsts(const TVec<TIntFltKdV>& FtrVV, const TIntV& AssignV, const int& StartN,
+		const int& EndN, TFltVV& SumKxDVV) {
+	for (int InstN = StartN; InstN < EndN; InstN++) {
+		const TIntFltKdV& InstV = FtrVV[InstN];
+		double* SumP = &SumKxDVV(AssignV[InstN], 0).Val;
+		for (int ElN = 0; ElN < InstV.Len(); ElN++) {
+			SumP[InstV[ElN].Key] += InstV[ElN].Dat;
+		}
+	}
+}
+
+void TKMeansIter::UpdateCentroidDists() {
+	const int K = GetClusts();
+	const int Dim = GetDim();
+
+	NormC2V.Gen(K);
+	for (int ClustN = 0; ClustN < K; ClustN++) {
+		const double* CentP = &CentKxDVV(ClustN, 0).Val;
+		NormC2V[ClustN] = TLinAlgKernel::DotProduct(CentP, CentP, Dim);
+	}
+
+	if (!BoundsP) { return; }
+
+	// an instance closer to its centroid than half the distance to the
+	// nearest other centroid can't change its assignment
+	HalfSepV.Gen(K);
+	#pragma omp parallel for schedule(dynamic, 1) num_threads(Threads)
+	for (int ClustN = 0; ClustN < K; ClustN++) {
+		double MnDist2 = TFlt::Mx;
+		for (int OthClustN = 0; OthClustN < K; OthClustN++) {
+			if (OthClustN == ClustN) { continue; }
+			const double Dist2 = TLinAlgKernel::EuclDist2(&CentKxDVV(ClustN, 0).Val,
+				&CentKxDVV(OthClustN, 0).Val, Dim);
+			if (Dist2 < MnDist2) { MnDist2 = Dist2; }
+		}
+		HalfSepV[ClustN] = 0.5 * TMath::Sqrt(MnDist2);
+	}
+}
+
 ///////////////////////////////////////////
 // TAbsKMeans
 
@@ -196,6 +196,86 @@ private:
 // CLUSTERING METHODS - CLASS DECLARATIONS
 //============================================================
 
+///////////////////////////////////////////
+// Assignment and centroid update over dense centroids, split among threads.
+// Each thread takes a continuous block of instances and sums them into its own
+// accumulator, the accumulators are merged once per iteration. With Euclidean
+// distance each instance also keeps Hamerly's bounds on the distance to its
+// centroid and to the second closest one, so instances whose bounds don't cross
+// skip the distance computation when the centroids barely move.
+class TKMeansIter {
+private:
+    /// number of threads used for assignment and centroid update
+    const int Threads;
+    /// true for Euclidean distance, false for cosine distance
+    const bool EuclP;
+    /// prune the assignment with Hamerly's bounds (only for Euclidean distance)
+    const bool BoundsP;
+
+    /// centroids in the rows (dimension k x d)
+    TFltVV CentKxDVV;
+    /// squared norms of the centroids and of the instances
+    TFltV NormC2V;
+    TFltV NormX2V;
+    /// upper bound of the distance to the assigned centroid and lower bound
+    /// of the distance to all other centroids (dimension n)
+    TFltV UpperV;
+    TFltV LowerV;
+    /// half of the distance to the closest other centroid (dimension k)
+    TFltV HalfSepV;
+    /// bounds are only valid after a full assignment with the current centroids
+    bool BoundsValidP;
+
+public:
+    /// BoundsP is ignored for distances other than Euclidean
+    TKMeansIter(const int& Threads, const PDist& Dist, const bool& BoundsP=true);
+
+    /// returns true if the iteration supports the distance
+    static bool IsDist(const PDist& Dist);
+
+    /// copies the centroids (columns of CentroidVV), the bounds are recomputed
+    /// on the next assignment
+    void SetCentroids(const TFltVV& CentroidVV);
+    /// prepares the norms of the instances, call after SetCentroids
+    void InitData(const TFltVV& FtrVV);
+    void InitData(const TVec<TIntFltKdV>& FtrVV);
+
+    /// assigns each instance to the closest centroid and returns the number of
+    /// instances which changed their assignment. If MinDistV is given, it gets the
+    /// quasi distance to the closest centroid and the bounds are not used
+    template <class TDataType>
+    int Assign(const TDataType& FtrVV, TIntV& AssignV, TFltV* MinDistV=nullptr);
+    /// returns the number of instances assigned to each centroid
+    void GetCountV(const TIntV& AssignV, const int& K, TIntV& CountV) const;
+    /// moves each centroid to (sum of its instances + centroid) / (count + 1), same
+    /// as the serial update, and moves the bounds by the distance the centroids moved
+    template <class TDataType>
+    void UpdateCentroids(const TDataType& FtrVV, const TIntV& AssignV, TFltVV& CentroidVV);
+
+private:
+    int GetClusts() const { return CentKxDVV.GetRows(); }
+    int GetDim() const { return CentKxDVV.GetCols(); }
+    /// first instance of the block processed by the thread
+    int GetBlockStart(const int& Insts, const int& ThreadN) const {
+        return (int)((int64)Insts * ThreadN / Threads); }
+
+    /// returns the instance as a vector, dense columns are copied into TmpV
+    static const TFltV& GetInstV(const TFltVV& FtrVV, const int& InstN, TFltV& TmpV) {
+        FtrVV.GetCol(InstN, TmpV); return TmpV; }
+    static const TIntFltKdV& GetInstV(const TVec<TIntFltKdV>& FtrVV, const int& InstN, TFltV& TmpV) {
+        return FtrVV[InstN]; }
+    /// quasi distance between the instance and the centroid (squared for Euclidean)
+    double GetQuasiDist(const TFltV& InstV, const int& InstN, const int& ClustN) const;
+    double GetQuasiDist(const TIntFltKdV& InstV, const int& InstN, const int& ClustN) const;
+    /// adds the instances in [StartN, EndN) to the rows of their centroids in SumKxDVV
+    static void AddInsts(const TFltVV& FtrVV, const TIntV& AssignV, const int& StartN,
+        const int& EndN, TFltVV& SumKxDVV);
+    static void AddInsts(const TVec<TIntFltKdV>& FtrVV, const TIntV& AssignV, const int& StartN,
+        const int& EndN, TFltVV& SumKxDVV);
+    /// updates the norms and the separation of the centroids from CentKxDVV
+    void UpdateCentroidDists();
+};
+
 ///////////////////////////////////////////
 // Abstract class that has methods needed be KMeans
 template<class TCentroidType>
@@ -212,6 +292,8 @@ protected:
 
     TBool CalcDistQualP;
     TFlt RelMeanCentroidDist {TFlt::NInf};
+    /// number of threads used for fitting, not saved with the model
+    TInt Threads {1};
 public:
 
     TAbsKMeans(const TRnd& Rnd, const PDist& Dist=TEuclDist::New(),
@@ -231,6 +313,8 @@ public:
 
     /// returns the centroid (column) matrix
     const TCentroidType& GetCentroidVV() const { return CentroidVV; }
+    /// returns the distance used to assign the instances
+    const PDist& GetDist() const { return Dist; }
     /// permutates the centroid matrix
     inline void PermutateCentroids(const TIntV& Mapping);
     /// returns the n-th centroid
@@ -273,6 +357,11 @@ public:
     /// returns the class used to calculate distances
     const PDist& GetDistMetric() const { return Dist; }
 
+    /// sets the number of threads used for assignment and centroid update
+    void SetThreads(const int& _Threads) { EAssertR(_Threads > 0, "Number of threads must be positive!"); Threads = _Threads; }
+    /// returns the number of threads used for assignment and centroid update
+    int GetThreads() const { return Threads; }
+
     inline void RemoveCentroids(const TIntV& CentroidIdV);
 
 protected:
@@ -321,9 +410,19 @@ protected:
     static void GetCol(const TFltVV& FtrVV, const int& ColN, TFltV& Col);
     static void GetCol(const TVec<TIntFltKdV>& FtrVV, const int& ColN, TIntFltKdV& Col);
 
-private:
     inline void SelectRndCentroid(const TFltVV& FtrVV, const int& CentroidN);
     inline void SelectRndCentroid(const TVec<TIntFltKdV>& FtrVV, const int& CentroidN);
+    /// copies the instance into the centroid
+    inline void SetCentroidInst(const TFltVV& FtrVV, const int& InstN, const int& CentroidN);
+    inline void SetCentroidInst(const TVec<TIntFltKdV>& FtrVV, const int& InstN, const int& CentroidN);
+
+    /// replaces empty centroids with random instances and reassigns, as in UpdateCentroids,
+    /// then moves the centroids with Iter
+    template<class TDataType>
+    void UpdateCentroids(const TDataType& FtrVV, TKMeansIter& Iter, TIntV& AssignV,
+            const bool& AllowEmptyP);
+
+private:
 
     void InitCentroids(TFltVV& CentroidVV, const TFltVV& FtrVV, const TIntV& CentroidNV, const int& K);
     void InitCentroids(TFltVV& CentroidVV, const TVec<TIntFltKdV>& FtrVV, const TIntV& CentroidNV, const int& K);
@@ -378,6 +477,14 @@ private:
     void VirtApply(const TDataType& FtrVV, const TInitCentroidType& InitCentVV,
             const int& NInst, const int& Dim, const bool& AllowEmptyP, const int& MaxIter,
             const TWPt<TNotify>& Notify);
+    /// fits dense centroids with TKMeansIter, returns false if the model
+    /// has to fall back to the serial version
+    template<class TDataType>
+    bool ApplyIter(const TDataType& FtrVV, TFltVV& CentroidVV, const int& NInst,
+            const bool& AllowEmptyP, const int& MaxIter, const TWPt<TNotify>& Notify);
+    template<class TDataType>
+    bool ApplyIter(const TDataType& FtrVV, TVec<TIntFltKdV>& CentroidVV, const int& NInst,
+            const bool& AllowEmptyP, const int& MaxIter, const TWPt<TNotify>& Notify) { return false; }
 
     const TInt K;
 };
@@ -424,14 +531,126 @@ private:
             const int& NInst, const int& Dim, const bool& AllowEmptyP, const int& MaxIter,
             const TWPt<TNotify>& Notify);
 
+    /// fits dense centroids with TKMeansIter, returns false if the model
+    /// has to fall back to the serial version
+    template<class TDataType>
+    bool ApplyIter(const TDataType& FtrVV, TFltVV& CentroidVV, const int& NInst,
+            const bool& AllowEmptyP, const int& MaxIter, const TWPt<TNotify>& Notify);
+    template<class TDataType>
+    bool ApplyIter(const TDataType& FtrVV, TVec<TIntFltKdV>& CentroidVV, const int& NInst,
+            const bool& AllowEmptyP, const int& MaxIter, const TWPt<TNotify>& Notify) { return false; }
+
     template <class TDataType>
     inline void AddCentroid(const TDataType& FtrVV, TFltVV& ClustDistVV, TFltV& NormC2,
         TFltV& TempK, TCentroidType& TempDxK, TCentroidType& TempDxK2, const int& InstN);
 };
 
+///////////////////////////////////////////
+// Mini-batch K-Means
+// Online K-Means for data that arrives in batches or one instance at a time
+// (Sculley, Web-Scale K-Means Clustering). Each instance moves its closest centroid
+// towards itself by 1/n, where n is the number of instances the centroid has seen,
+// so a centroid is the running mean of its instances. With Decay < 1 the counts
+// shrink before each batch, the older instances are forgotten and the centroids
+// follow a drifting stream. The first K instances become the initial centroids.
+template<class TCentroidType>
+class TMiniBatchKMeans : public TAbsKMeans<TCentroidType> {
+    using TBase = TAbsKMeans<TCentroidType>;
+private:
+    const TInt K;
+    /// factor the counts are multiplied with before each batch
+    const TFlt Decay;
+    /// number of instances sampled per iteration when fitting on a full dataset
+    const TInt BatchSize;
+    /// (decayed) number of instances seen by each centroid
+    TFltV CountV;
+
+public:
+    TMiniBatchKMeans(const int& K, const double& Decay=1, const int& BatchSize=100,
+            const TRnd& Rnd=TRnd(0), const PDist& Dist=TEuclDist::New(),
+            const bool& CalcDistQualP=false);
+    TMiniBatchKMeans(TSIn& SIn);
+
+    // saves the model to the output stream
+    void Save(TSOut& SOut) const;
+
+    /// updates the centroids with a batch of instances (in the columns), the whole
+    /// batch is assigned before any of the centroids moves
+    void PartialFit(const TFltVV& FtrVV) { TIntV AssignV; PartialFit(FtrVV, AssignV); }
+    void PartialFit(const TVec<TIntFltKdV>& FtrVV) { TIntV AssignV; PartialFit(FtrVV, AssignV); }
+    /// same as above, AssignV gets the centroid each instance was assigned to
+    void PartialFit(const TFltVV& FtrVV, TIntV& AssignV) { PartialFitBatch(FtrVV, AssignV); }
+    void PartialFit(const TVec<TIntFltKdV>& FtrVV, TIntV& AssignV) { PartialFitBatch(FtrVV, AssignV); }
+    /// updates the closest centroid with a single instance and returns its index
+    int PartialFit(const TFltV& FtrV);
+    int PartialFit(const TIntFltKdV& FtrV);
+
+    /// returns true once all K centroids are initialized
+    bool IsInit() const { return TBase::GetClusts() == K; }
+    /// returns the number of centroids
+    int GetK() const { return K; }
+    /// returns the factor the counts are multiplied with before each batch
+    double GetDecay() const { return Decay; }
+    /// returns the (decayed) number of instances seen by each centroid
+    const TFltV& GetCountV() const { return CountV; }
+    /// forgets the centroids
+    void Reset();
+
+protected:
+    // Fits the model on a full dataset by running MaxIter mini-batches of randomly
+    // sampled instances. The initial centroids count as one instance each, empty
+    // clusters are kept
+    void VirtApply(const TFltVV& FtrVV, const TFltVV& InitCentVV,
+            const bool& AllowEmptyP=true, const int& MaxIter=10000,
+            const TWPt<TNotify>& Notify=TNotify::NullNotify());
+    void VirtApply(const TFltVV& FtrVV, const TVec<TIntFltKdV>& InitCentVV,
+            const bool& AllowEmptyP=true, const int& MaxIter=10000,
+            const TWPt<TNotify>& Notify=TNotify::NullNotify());
+    void VirtApply(const TVec<TIntFltKdV>& FtrVV, const TFltVV& InitCentVV,
+            const bool& AllowEmptyP=true, const int& MaxIter=10000,
+            const TWPt<TNotify>& Notify = TNotify::NullNotify());
+    void VirtApply(const TVec<TIntFltKdV>& FtrVV, const TVec<TIntFltKdV>& InitCentVV,
+            const bool& AllowEmptyP=true, const int& MaxIter=10000,
+            const TWPt<TNotify>& Notify = TNotify::NullNotify());
+
+    const TStr GetType() const { return "minibatch"; }
+
+private:
+    template<class TDataType, class TInitCentVV>
+    void VirtApply(const TDataType& FtrVV, const TInitCentVV& InitCentVV,
+            const int& MaxIter, const TWPt<TNotify>& Notify);
+
+    template<class TDataType>
+    void PartialFitBatch(const TDataType& FtrVV, TIntV& AssignV);
+
+    /// shrinks the counts before a new batch
+    void DecayCounts();
+    /// makes room for instances with Dim dimensions
+    static void ExtendDim(TFltVV& CentroidVV, const int& Dim);
+    static void ExtendDim(TVec<TIntFltKdV>& CentroidVV, const int& Dim) {}
+    /// appends an empty centroid
+    static void AppendCentroid(TFltVV& CentroidVV) { CentroidVV.AddYDim(); }
+    static void AppendCentroid(TVec<TIntFltKdV>& CentroidVV) { CentroidVV.Add(); }
+    /// moves the centroid towards the instance: c := (1 - Eta)*c + Eta*x
+    static void MoveCentroid(TFltVV& CentroidVV, const int& ClustN, const double& Eta,
+            const TFltVV& FtrVV, const int& InstN);
+    static void MoveCentroid(TFltVV& CentroidVV, const int& ClustN, const double& Eta,
+            const TVec<TIntFltKdV>& FtrVV, const int& InstN);
+    static void MoveCentroid(TVec<TIntFltKdV>& CentroidVV, const int& ClustN,
+            const double& Eta, const TFltVV& FtrVV, const int& InstN);
+    static void MoveCentroid(TVec<TIntFltKdV>& CentroidVV, const int& ClustN,
+            const double& Eta, const TVec<TIntFltKdV>& FtrVV, const int& InstN);
+    /// copies the instances into a batch
+    static void GetBatch(const TFltVV& FtrVV, const TIntV& InstNV, TFltVV& BatchVV);
+    static void GetBatch(const TVec<TIntFltKdV>& FtrVV, const TIntV& InstNV,
+            TVec<TIntFltKdV>& BatchVV);
+};
+
 // typedefs
 typedef TDnsKMeans<TFltVV> TDenseKMeans;
 typedef TDnsKMeans<TVec<TIntFltKdV>> TSparseKMeans;
+typedef TMiniBatchKMeans<TFltVV> TDenseMiniBatchKMeans;
+typedef TMiniBatchKMeans<TVec<TIntFltKdV>> TSparseMiniBatchKMeans;
 
 typedef TPt<TAbsKMeans<TFltVV>> PDenseKMeans;
 typedef TPt<TAbsKMeans<TFltVV>> PSparseKMeans;
@@ -113,6 +113,136 @@ namespace TClustering {
         TLinAlg::GetColNormV(CentroidVV, NormC2);
     }
 
+    ////////////////////////////////////////
+    /// K-Means iteration
+    template <class TDataType>
+    int TKMeansIter::Assign(const TDataType& FtrVV, TIntV& AssignV, TFltV* MinDistV) {
+        const int Insts = NormX2V.Len();
+        const int K = GetClusts();
+        const bool UseBoundsP = BoundsP && MinDistV == nullptr;
+
+        EAssertR(AssignV.Len() == Insts, "Assignment vector has the wrong dimension!");
+        if (MinDistV != nullptr && MinDistV->Len() != Insts) { MinDistV->Gen(Insts); }
+        if (UseBoundsP && UpperV.Len() != Insts) {
+            UpperV.Gen(Insts);
+            LowerV.Gen(Insts);
+            BoundsValidP = false;
+        }
+        const bool PruneP = UseBoundsP && BoundsValidP;
+
+        int Changes = 0;
+        #pragma omp parallel for schedule(static, 1) num_threads(Threads) reduction(+:Changes)
+        for (int ThreadN = 0; ThreadN < Threads; ThreadN++) {
+            TFltV TmpV;
+            const int EndN = GetBlockStart(Insts, ThreadN + 1);
+            for (int InstN = GetBlockStart(Insts, ThreadN); InstN < EndN; InstN++) {
+                const int OldClustN = AssignV[InstN];
+                const double Bound = PruneP ? TMath::Mx(HalfSepV[OldClustN].Val, LowerV[InstN].Val) : 0.0;
+                if (PruneP && UpperV[InstN] <= Bound) { continue; }
+
+                const auto& InstV = GetInstV(FtrVV, InstN, TmpV);
+                if (PruneP) {
+                    // tighten the upper bound and check again
+                    UpperV[InstN] = TMath::Sqrt(GetQuasiDist(InstV, InstN, OldClustN));
+                    if (UpperV[InstN] <= Bound) { continue; }
+                }
+
+                // find the closest and the second closest centroid,
+                // ties go to the first centroid as in the serial version
+                int MnClustN = 0;
+                double MnDist = TFlt::Mx;
+                double MnDist2nd = TFlt::Mx;
+                for (int ClustN = 0; ClustN < K; ClustN++) {
+                    const double Dist = GetQuasiDist(InstV, InstN, ClustN);
+                    if (Dist < MnDist) {
+                        MnDist2nd = MnDist;
+                        MnDist = Dist;
+                        MnClustN = ClustN;
+                    } else if (Dist < MnDist2nd) {
+                        MnDist2nd = Dist;
+                    }
+                }
+
+                if (UseBoundsP) {
+                    UpperV[InstN] = TMath::Sqrt(MnDist);
+                    LowerV[InstN] = TMath::Sqrt(MnDist2nd);
+                }
+                if (MinDistV != nullptr) { (*MinDistV)[InstN] = MnDist; }
+                if (MnClustN != OldClustN) {
+                    AssignV[InstN] = MnClustN;
+                    Changes++;
+                }
+            }
+        }
+
+        if (UseBoundsP) { BoundsValidP = true; }
+        return Changes;
+    }
+
+    template <class TDataType>
+    void TKMeansIter::UpdateCentroids(const TDataType& FtrVV, const TIntV& AssignV,
+            TFltVV& CentroidVV) {
+        const int Insts = AssignV.Len();
+        const int K = GetClusts();
+        const int Dim = GetDim();
+
+        // I. each thread sums its block of instances into its own accumulator
+        TVec<TFltVV> SumKxDVV(Threads);
+        #pragma omp parallel for schedule(static, 1) num_threads(Threads)
+        for (int ThreadN = 0; ThreadN < Threads; ThreadN++) {
+            SumKxDVV[ThreadN].Gen(K, Dim);
+            AddInsts(FtrVV, AssignV, GetBlockStart(Insts, ThreadN),
+                GetBlockStart(Insts, ThreadN + 1), SumKxDVV[ThreadN]);
+        }
+
+        TIntV CountV;   GetCountV(AssignV, K, CountV);
+
+        // II. merge the accumulators in thread order and move the centroids
+        TFltV MoveV(K);
+        #pragma omp parallel for schedule(static) num_threads(Threads)
+        for (int ClustN = 0; ClustN < K; ClustN++) {
+            double* SumP = &SumKxDVV[0](ClustN, 0).Val;
+            for (int ThreadN = 1; ThreadN < Threads; ThreadN++) {
+                TLinAlgKernel::AddVec(1.0, &SumKxDVV[ThreadN](ClustN, 0).Val, SumP, Dim);
+            }
+
+            const double Scale = 1.0 / (CountV[ClustN] + 1.0);
+            double* CentP = &CentKxDVV(ClustN, 0).Val;
+            double Move2 = 0;
+            for (int DimN = 0; DimN < Dim; DimN++) {
+                const double Val = (SumP[DimN] + CentP[DimN]) * Scale;
+                Move2 += TMath::Sqr(Val - CentP[DimN]);
+                CentP[DimN] = Val;
+                CentroidVV(DimN, ClustN) = Val;
+            }
+            MoveV[ClustN] = TMath::Sqrt(Move2);
+        }
+
+        UpdateCentroidDists();
+
+        // III. the bounds move by at most as much as the centroids
+        if (BoundsP && BoundsValidP) {
+            int MxMoveN = 0;
+            double MxMove2nd = 0;
+            for (int ClustN = 1; ClustN < K; ClustN++) {
+                if (MoveV[ClustN] > MoveV[MxMoveN]) {
+                    MxMove2nd = MoveV[MxMoveN];
+                    MxMoveN = ClustN;
+                } else if (MoveV[ClustN] > MxMove2nd) {
+                    MxMove2nd = MoveV[ClustN];
+                }
+            }
+            const double MxMove = MoveV[MxMoveN];
+
+            #pragma omp parallel for schedule(static) num_threads(Threads)
+            for (int InstN = 0; InstN < Insts; InstN++) {
+                const int ClustN = AssignV[InstN];
+                UpperV[InstN] += MoveV[ClustN];
+                LowerV[InstN] -= ClustN == MxMoveN ? MxMove2nd : MxMove;
+            }
+        }
+    }
+
     ////////////////////////////////////////
     /// K-Means - base class
     template<class TCentroidType>
@@ -151,6 +281,9 @@ namespace TClustering {
         else if (Type == "dpmeans") {
             return new TDpMeans<TCentroidType>(SIn);
         }
+        else if (Type == "minibatch") {
+            return new TMiniBatchKMeans<TCentroidType>(SIn);
+        }
         else {
             throw TExcept::New("Invalid clustering type: " + Type);
         }
@@ -278,15 +411,27 @@ namespace TClustering {
     template<class TCentroidType>
     inline void TAbsKMeans<TCentroidType>::SelectRndCentroid(const TFltVV& FtrVV, const int& CentroidN) {
         const int RndRecN = Rnd.GetUniDevInt(GetDataCount(FtrVV));
-        TFltV RndRecFtrV;	GetCol(FtrVV, RndRecN, RndRecFtrV);
-        SetCol(CentroidVV, CentroidN, RndRecFtrV);
+        SetCentroidInst(FtrVV, RndRecN, CentroidN);
     }
 
     template<class TCentroidType>
     inline void TAbsKMeans<TCentroidType>::SelectRndCentroid(const TVec<TIntFltKdV>& FtrVV, const int& CentroidN) {
         const int RndRecN = Rnd.GetUniDevInt(GetDataCount(FtrVV));
-        TIntFltKdV RndRecFtrV;	GetCol(FtrVV, RndRecN, RndRecFtrV);
-        SetCol(CentroidVV, CentroidN, RndRecFtrV);
+        SetCentroidInst(FtrVV, RndRecN, CentroidN);
+    }
+
+    template<class TCentroidType>
+    inline void TAbsKMeans<TCentroidType>::SetCentroidInst(const TFltVV& FtrVV, const int& InstN,
+            const int& CentroidN) {
+        TFltV FtrV;	GetCol(FtrVV, InstN, FtrV);
+        SetCol(CentroidVV, CentroidN, FtrV);
+    }
+
+    template<class TCentroidType>
+    inline void TAbsKMeans<TCentroidType>::SetCentroidInst(const TVec<TIntFltKdV>& FtrVV,
+            const int& InstN, const int& CentroidN) {
+        TIntFltKdV FtrV;	GetCol(FtrVV, InstN, FtrV);
+        SetCol(CentroidVV, CentroidN, FtrV);
     }
 
     template<class TCentroidType>
@@ -339,6 +484,35 @@ namespace TClustering {
         TLinAlg::Multiply(TempDxKV2, TempKxKSpVV, CentroidVV);
     }
 
+    template<class TCentroidType>
+    template<class TDataType>
+    void TAbsKMeans<TCentroidType>::UpdateCentroids(const TDataType& FtrVV, TKMeansIter& Iter,
+            TIntV& AssignV, const bool& AllowEmptyP) {
+        const int K = GetDataCount(CentroidVV);
+
+        if (!AllowEmptyP) {
+            TIntV CountV;
+            bool ExistsEmpty;
+            int LoopN = 0;
+            do {
+                ExistsEmpty = false;
+                Iter.GetCountV(AssignV, K, CountV);
+                for (int ClustN = 0; ClustN < K; ClustN++) {
+                    if (CountV[ClustN] == 0) {
+                        // select a random point and create a new centroid from it
+                        SelectRndCentroid(FtrVV, ClustN);
+                        Iter.SetCentroids(CentroidVV);
+                        Iter.Assign(FtrVV, AssignV);
+                        ExistsEmpty = true;
+                        break;
+                    }
+                }
+            } while (ExistsEmpty && ++LoopN < 10);
+        }
+
+        Iter.UpdateCentroids(FtrVV, AssignV, CentroidVV);
+    }
+
     template<class TCentroidType>
     void TAbsKMeans<TCentroidType>::InitCentroids(TFltVV& CentroidVV, const TFltVV& FtrVV, const TIntV& CentroidNV, const int& K) {
         const int Dim = GetDataDim(FtrVV);
@@ -585,6 +759,21 @@ namespace TClustering {
 
         Notify->OnNotify(TNotifyType::ntInfo, "Executing KMeans ...");
 
+        // select initial centroids
+        if (InitCentroidVV.Empty()) {
+            TBase::SelectInitCentroids(FtrVV, K, NInst);
+        }
+        else {
+            EAssertR(TBase::GetDataCount(InitCentroidVV) == K, "Number of columns must be equal to K!");
+            TBase::SelectInitCentroids(InitCentroidVV);
+        }
+
+        // dense centroids are fitted in parallel, without the k x n distance matrix
+        if (ApplyIter(FtrVV, TBase::CentroidVV, NInst, AllowEmptyP, MaxIter, Notify)) {
+            EAssertR(!TLinAlgCheck::ContainsNan(TBase::CentroidVV), "TDnsKMeans<TCentroidType>::Apply: Found NaN in the centroids!");
+            return;
+        }
+
         // assignment vectors
         TIntV AssignIdxV(NInst), OldAssignIdxV(NInst);
         TIntV* AssignIdxVPtr = &AssignIdxV;
@@ -604,15 +793,6 @@ namespace TClustering {
         TCentroidType TempDxK2;				// (dimension d x k)
         TVec<TIntFltKdV> TempKxKSpVV(K);	// (dimension k x k)
 
-        // select initial centroids
-        if (InitCentroidVV.Empty()) {
-            TBase::SelectInitCentroids(FtrVV, K, NInst);
-        }
-        else {
-            EAssertR(TBase::GetDataCount(InitCentroidVV) == K, "Number of columns must be equal to K!");
-            TBase::SelectInitCentroids(InitCentroidVV);
-        }
-
         // do the work
         for (int IterN = 0; IterN < MaxIter; IterN++) {
             if (IterN % 100 == 0) { Notify->OnNotifyFmt(TNotifyType::ntInfo, "%d", IterN); }
@@ -655,6 +835,35 @@ namespace TClustering {
         EAssertR(!TLinAlgCheck::ContainsNan(TBase::CentroidVV), "TDnsKMeans<TCentroidType>::Apply: Found NaN in the centroids!");
     }
 
+    template<class TCentroidType>
+    template<class TDataType>
+    bool TDnsKMeans<TCentroidType>::ApplyIter(const TDataType& FtrVV, TFltVV& CentroidVV,
+            const int& NInst, const bool& AllowEmptyP, const int& MaxIter,
+            const TWPt<TNotify>& Notify) {
+        if (!TKMeansIter::IsDist(TBase::Dist)) { return false; }
+
+        TKMeansIter Iter(TBase::Threads, TBase::Dist);
+        Iter.SetCentroids(CentroidVV);
+        Iter.InitData(FtrVV);
+
+        // all instances start in the first cluster, same as the serial version
+        TIntV AssignV(NInst);
+        for (int IterN = 0; IterN < MaxIter; IterN++) {
+            if (IterN % 100 == 0) { Notify->OnNotifyFmt(TNotifyType::ntInfo, "%d", IterN); }
+
+            // if the assignment hasn't changed then terminate the loop
+            if (Iter.Assign(FtrVV, AssignV) == 0) {
+                Notify->OnNotifyFmt(TNotifyType::ntInfo, "Converged at iteration: %d", IterN);
+                break;
+            }
+
+            // recompute the means
+            TBase::UpdateCentroids(FtrVV, Iter, AssignV, AllowEmptyP);
+        }
+
+        return true;
+    }
+
     ////////////////////////////////////////
     /// DP-Means
     template<class TCentroidType>
@@ -742,6 +951,12 @@ namespace TClustering {
             TBase::SelectInitCentroids(InitCentVV);
         }
 
+        // dense centroids are fitted in parallel, without the k x n distance matrix
+        if (ApplyIter(FtrVV, TBase::CentroidVV, NInst, AllowEmptyP, MaxIter, Notify)) {
+            EAssertR(!TLinAlgCheck::ContainsNan(TBase::CentroidVV), "TDpMeans<TCentroidType>::Apply: Found NaN in the centroids!");
+            return;
+        }
+
         int K = TBase::GetDataCount(TBase::CentroidVV);
 
         // const variables, reused throughtout the procedure
@@ -814,6 +1029,59 @@ namespace TClustering {
         EAssertR(!TLinAlgCheck::ContainsNan(TBase::CentroidVV), "TDpMeans<TCentroidType>::Apply: Found NaN in the centroids!");
     }
 
+    template<class TCentroidType>
+    template<class TDataType>
+    bool TDpMeans<TCentroidType>::ApplyIter(const TDataType& FtrVV, TFltVV& CentroidVV,
+            const int& NInst, const bool& AllowEmptyP, const int& MaxIter,
+            const TWPt<TNotify>& Notify) {
+        if (!TKMeansIter::IsDist(TBase::Dist)) { return false; }
+
+        const double LambdaSq = Lambda*Lambda;
+        int K = TBase::GetDataCount(CentroidVV);
+
+        // new centroids are added every iteration, so the bounds wouldn't pay off
+        TKMeansIter Iter(TBase::Threads, TBase::Dist, false);
+        Iter.SetCentroids(CentroidVV);
+        Iter.InitData(FtrVV);
+
+        TIntV AssignV(NInst);
+        TFltV MinClustDistV(NInst);		// (dimension n)
+
+        int IterN = 0;
+        while (IterN++ < MaxIter) {
+            if (IterN % 100 == 0) { Notify->OnNotifyFmt(TNotifyType::ntInfo, "%d", IterN); }
+
+            int Changes = Iter.Assign(FtrVV, AssignV, &MinClustDistV);
+
+            // check if we need to increase the number of centroids
+            if (K < MxClusts) {
+                const int NewCentroidN = TLinAlgSearch::GetMaxIdx(MinClustDistV);
+                const double MxDist = MinClustDistV[NewCentroidN];
+
+                if (MxDist > LambdaSq) {
+                    K++;
+                    CentroidVV.AddYDim();
+                    TBase::SetCentroidInst(FtrVV, NewCentroidN, K - 1);
+                    Iter.SetCentroids(CentroidVV);
+                    AssignV[NewCentroidN] = K - 1;
+                    Changes++;
+                    Notify->OnNotifyFmt(TNotifyType::ntInfo, "Max distance to centroid: %.3f, number of clusters: %d ...", TMath::Sqrt(MxDist), K);
+                }
+            }
+
+            // check if converged, the first assignment always counts as a change
+            if (Changes == 0 && IterN > 1) {
+                Notify->OnNotifyFmt(TNotifyType::ntInfo, "Converged at iteration: %d", IterN);
+                break;
+            }
+
+            // recompute the centroids
+            TBase::UpdateCentroids(FtrVV, Iter, AssignV, AllowEmptyP);
+        }
+
+        return true;
+    }
+
     template<>
     template<>
     inline void TDpMeans<TFltVV>::AddCentroid(const TFltVV& FtrVV, TFltVV& ClustDistVV, TFltV& NormC2,
@@ -869,4 +1137,222 @@ namespace TClustering {
         TempDxK.Add(TIntFltKdV());
         TempDxK2.Add(TIntFltKdV());
     }
+
+    ////////////////////////////////////////
+    /// Mini-batch K-Means
+    template<class TCentroidType>
+    TMiniBatchKMeans<TCentroidType>::TMiniBatchKMeans(const int& _K, const double& _Decay,
+            const int& _BatchSize, const TRnd& Rnd, const PDist& Dist, const bool& CalcDistQualP) :
+        TBase(Rnd, Dist, CalcDistQualP),
+        K(_K),
+        Decay(_Decay),
+        BatchSize(_BatchSize) {
+
+        EAssertR(K > 0, "TMiniBatchKMeans::TMiniBatchKMeans: The number of clusters should be greater than 0!");
+        EAssertR(0 < Decay && Decay <= 1, "TMiniBatchKMeans::TMiniBatchKMeans: The decay should be in (0, 1]!");
+        EAssertR(BatchSize > 0, "TMiniBatchKMeans::TMiniBatchKMeans: The batch size should be greater than 0!");
+    }
+
+    template<class TCentroidType>
+    TMiniBatchKMeans<TCentroidType>::TMiniBatchKMeans(TSIn& SIn) :
+            TBase(SIn),
+            K(SIn),
+            Decay(SIn),
+            BatchSize(SIn),
+            CountV(SIn) {}
+
+    template<class TCentroidType>
+    void TMiniBatchKMeans<TCentroidType>::Save(TSOut& SOut) const {
+        TBase::Save(SOut);
+        K.Save(SOut);
+        Decay.Save(SOut);
+        BatchSize.Save(SOut);
+        CountV.Save(SOut);
+    }
+
+    template<class TCentroidType>
+    int TMiniBatchKMeans<TCentroidType>::PartialFit(const TFltV& FtrV) {
+        TFltVV FtrVV(FtrV.Len(), 1);    FtrVV.SetCol(0, FtrV);
+        TIntV AssignV;  PartialFitBatch(FtrVV, AssignV);
+        return AssignV[0];
+    }
+
+    template<class TCentroidType>
+    int TMiniBatchKMeans<TCentroidType>::PartialFit(const TIntFltKdV& FtrV) {
+        TVec<TIntFltKdV> FtrVV(1);  FtrVV[0] = FtrV;
+        TIntV AssignV;  PartialFitBatch(FtrVV, AssignV);
+        return AssignV[0];
+    }
+
+    template<class TCentroidType>
+    void TMiniBatchKMeans<TCentroidType>::Reset() {
+        TBase::CentroidVV = TCentroidType();
+        CountV.Clr();
+    }
+
+    template <class TCentroidType>
+    void TMiniBatchKMeans<TCentroidType>::VirtApply(const TFltVV& FtrVV, const TFltVV& InitCentVV,
+            const bool& AllowEmptyP, const int& MaxIter, const TWPt<TNotify>& Notify) {
+        VirtApply(FtrVV, InitCentVV, MaxIter, Notify);
+    }
+
+    template <class TCentroidType>
+    void TMiniBatchKMeans<TCentroidType>::VirtApply(const TFltVV& FtrVV, const TVec<TIntFltKdV>& InitCentVV,
+            const bool& AllowEmptyP, const int& MaxIter, const TWPt<TNotify>& Notify) {
+        VirtApply(FtrVV, InitCentVV, MaxIter, Notify);
+    }
+
+    template <class TCentroidType>
+    void TMiniBatchKMeans<TCentroidType>::VirtApply(const TVec<TIntFltKdV>& FtrVV, const TFltVV& InitCentVV,
+            const bool& AllowEmptyP, const int& MaxIter, const TWPt<TNotify>& Notify) {
+        VirtApply(FtrVV, InitCentVV, MaxIter, Notify);
+    }
+
+    template <class TCentroidType>
+    void TMiniBatchKMeans<TCentroidType>::VirtApply(const TVec<TIntFltKdV>& FtrVV, const TVec<TIntFltKdV>& InitCentVV,
+            const bool& AllowEmptyP, const int& MaxIter, const TWPt<TNotify>& Notify) {
+        VirtApply(FtrVV, InitCentVV, MaxIter, Notify);
+    }
+
+    template<class TCentroidType>
+    template<class TDataType, class TInitCentVV>
+    void TMiniBatchKMeans<TCentroidType>::VirtApply(const TDataType& FtrVV,
+            const TInitCentVV& InitCentVV, const int& MaxIter, const TWPt<TNotify>& Notify) {
+        const int NInst = TBase::GetDataCount(FtrVV);
+        EAssertR(K <= NInst, "Matrix should have more columns than K!");
+        EAssertR(TBase::GetDataDim(FtrVV) > 0, "The input matrix doesn't have any features!");
+
+        Notify->OnNotifyFmt(TNotifyType::ntInfo, "Executing mini-batch KMeans with batch size %d ...", BatchSize.Val);
+
+        // select initial centroids, each of them counts as one instance
+        if (InitCentVV.Empty()) {
+            TBase::SelectInitCentroids(FtrVV, K, NInst);
+        } else {
+            EAssertR(TBase::GetDataCount(InitCentVV) == K, "Number of columns must be equal to K!");
+            TBase::SelectInitCentroids(InitCentVV);
+        }
+        CountV.Gen(K);  CountV.PutAll(1);
+
+        TIntV InstNV(BatchSize);
+        TDataType BatchVV;
+        for (int IterN = 0; IterN < MaxIter; IterN++) {
+            if (IterN % 100 == 0) { Notify->OnNotifyFmt(TNotifyType::ntInfo, "%d", IterN); }
+
+            // sample the batch
+            for (int SampleN = 0; SampleN < BatchSize; SampleN++) {
+                InstNV[SampleN] = TBase::Rnd.GetUniDevInt(NInst);
+            }
+            GetBatch(FtrVV, InstNV, BatchVV);
+
+            TIntV AssignV;  PartialFitBatch(BatchVV, AssignV);
+        }
+
+        EAssertR(!TLinAlgCheck::ContainsNan(TBase::CentroidVV), "TMiniBatchKMeans<TCentroidType>::Apply: Found NaN in the centroids!");
+    }
+
+    template<class TCentroidType>
+    template<class TDataType>
+    void TMiniBatchKMeans<TCentroidType>::PartialFitBatch(const TDataType& FtrVV, TIntV& AssignV) {
+        const int NInst = TBase::GetDataCount(FtrVV);
+        AssignV.Gen(NInst);
+        if (NInst == 0) { return; }
+
+        ExtendDim(TBase::CentroidVV, TBase::GetDataDim(FtrVV));
+        DecayCounts();
+
+        // the first instances become the initial centroids
+        int InstN = 0;
+        while (!IsInit() && InstN < NInst) {
+            AppendCentroid(TBase::CentroidVV);
+            TBase::SetCentroidInst(FtrVV, InstN, TBase::GetClusts() - 1);
+            CountV.Add(1);
+            AssignV[InstN++] = TBase::GetClusts() - 1;
+        }
+        if (InstN == NInst) { return; }
+
+        // assign the whole batch first, then move the centroids
+        TIntV BatchAssignV;  TBase::Assign(FtrVV, BatchAssignV);
+        for (; InstN < NInst; InstN++) {
+            const int ClustN = BatchAssignV[InstN];
+            CountV[ClustN]++;
+            MoveCentroid(TBase::CentroidVV, ClustN, 1.0 / CountV[ClustN], FtrVV, InstN);
+            AssignV[InstN] = ClustN;
+        }
+    }
+
+    template<class TCentroidType>
+    void TMiniBatchKMeans<TCentroidType>::DecayCounts() {
+        if (Decay == 1) { return; }
+        for (int ClustN = 0; ClustN < CountV.Len(); ClustN++) {
+            CountV[ClustN] *= Decay;
+        }
+    }
+
+    template<class TCentroidType>
+    void TMiniBatchKMeans<TCentroidType>::ExtendDim(TFltVV& CentroidVV, const int& Dim) {
+        if (Dim <= CentroidVV.GetRows()) { return; }
+        // new dimensions are zero in the existing centroids
+        TFltVV NewCentroidVV(Dim, CentroidVV.GetCols());
+        NewCentroidVV.CopyFrom(CentroidVV);
+        CentroidVV = NewCentroidVV;
+    }
+
+    template<class TCentroidType>
+    void TMiniBatchKMeans<TCentroidType>::MoveCentroid(TFltVV& CentroidVV, const int& ClustN,
+            const double& Eta, const TFltVV& FtrVV, const int& InstN) {
+        EAssertR(FtrVV.GetRows() == CentroidVV.GetRows(), "Dimension of the instances doesn't match the centroids!");
+        for (int DimN = 0; DimN < CentroidVV.GetRows(); DimN++) {
+            CentroidVV(DimN, ClustN) += Eta * (FtrVV(DimN, InstN) - CentroidVV(DimN, ClustN));
+        }
+    }
+
+    template<class TCentroidType>
+    void TMiniBatchKMeans<TCentroidType>::MoveCentroid(TFltVV& CentroidVV, const int& ClustN,
+            const double& Eta, const TVec<TIntFltKdV>& FtrVV, const int& InstN) {
+        for (int DimN = 0; DimN < CentroidVV.GetRows(); DimN++) {
+            CentroidVV(DimN, ClustN) *= 1 - Eta;
+        }
+        const TIntFltKdV& FtrV = FtrVV[InstN];
+        for (int ElN = 0; ElN < FtrV.Len(); ElN++) {
+            CentroidVV(FtrV[ElN].Key, ClustN) += Eta * FtrV[ElN].Dat;
+        }
+    }
+
+    template<class TCentroidType>
+    void TMiniBatchKMeans<TCentroidType>::MoveCentroid(TVec<TIntFltKdV>& CentroidVV,
+            const int& ClustN, const double& Eta, const TFltVV& FtrVV, const int& InstN) {
+        TFltV FtrV;     FtrVV.GetCol(InstN, FtrV);
+        TIntFltKdV SpFtrV;  TLinAlgTransform::ToSpVec(FtrV, SpFtrV);
+        TIntFltKdV NewCentroidV;    TLinAlg::LinComb(1 - Eta, CentroidVV[ClustN], Eta, SpFtrV, NewCentroidV);
+        CentroidVV[ClustN] = NewCentroidV;
+    }
+
+    template<class TCentroidType>
+    void TMiniBatchKMeans<TCentroidType>::MoveCentroid(TVec<TIntFltKdV>& CentroidVV,
+            const int& ClustN, const double& Eta, const TVec<TIntFltKdV>& FtrVV, const int& InstN) {
+        TIntFltKdV NewCentroidV;    TLinAlg::LinComb(1 - Eta, CentroidVV[ClustN], Eta, FtrVV[InstN], NewCentroidV);
+        CentroidVV[ClustN] = NewCentroidV;
+    }
+
+    template<class TCentroidType>
+    void TMiniBatchKMeans<TCentroidType>::GetBatch(const TFltVV& FtrVV, const TIntV& InstNV,
+            TFltVV& BatchVV) {
+        if (BatchVV.GetRows() != FtrVV.GetRows() || BatchVV.GetCols() != InstNV.Len()) {
+            BatchVV.Gen(FtrVV.GetRows(), InstNV.Len());
+        }
+        for (int DimN = 0; DimN < FtrVV.GetRows(); DimN++) {
+            for (int SampleN = 0; SampleN < InstNV.Len(); SampleN++) {
+                BatchVV(DimN, SampleN) = FtrVV(DimN, InstNV[SampleN]);
+            }
+        }
+    }
+
+    template<class TCentroidType>
+    void TMiniBatchKMeans<TCentroidType>::GetBatch(const TVec<TIntFltKdV>& FtrVV,
+            const TIntV& InstNV, TVec<TIntFltKdV>& BatchVV) {
+        BatchVV.Gen(InstNV.Len());
+        for (int SampleN = 0; SampleN < InstNV.Len(); SampleN++) {
+            BatchVV[SampleN] = FtrVV[InstNV[SampleN]];
+        }
+    }
 }
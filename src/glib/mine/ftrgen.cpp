@@ -308,7 +308,7 @@ void TBagOfWords::Clr() {
         // if hashing, allocate the document counts and set to zero
         DocFqV.Gen(HashDim); DocFqV.PutAll(0);
         OldDocFqV.Gen(HashDim); OldDocFqV.PutAll(0.0);
-        if (IsStoreHashWords()) { HashWordV.Clr(); }
+        if (IsStoreHashWords()) { HashWordV.Gen(HashDim); }
     } else {
         // if normal vector space, just forget the existing tokens and document counts
         TokenSet.Clr(); DocFqV.Clr(); OldDocFqV.Clr();
@@ -530,6 +530,51 @@ void TBagOfWords::Forget(const double& Factor) {
     }
 }
 
+TBagOfWords TBagOfWords::GetEmpty() const {
+    TBagOfWords EmptyBow;
+    EmptyBow.Type = Type; EmptyBow.Tokenizer = Tokenizer;
+    EmptyBow.SwSet = SwSet; EmptyBow.Stemmer = Stemmer;
+    EmptyBow.HashDim = HashDim; EmptyBow.NStart = NStart; EmptyBow.NEnd = NEnd;
+    EmptyBow.Clr();
+    return EmptyBow;
+}
+
+bool TBagOfWords::Merge(const TBagOfWords& PartBow) {
+    EAssertR(Type == PartBow.Type && HashDim == PartBow.HashDim,
+        "Merging bags of words with different settings");
+    bool UpdateP = false;
+    if (IsHashing()) {
+        // add document counts and tokens seen for each hash
+        for (int TokenId = 0; TokenId < HashDim; TokenId++) {
+            DocFqV[TokenId] += PartBow.DocFqV[TokenId];
+            if (IsStoreHashWords()) {
+                const TStrSet& PartWordSet = PartBow.HashWordV[TokenId];
+                int KeyId = PartWordSet.FFirstKeyId();
+                while (PartWordSet.FNextKeyId(KeyId)) {
+                    HashWordV[TokenId].AddKey(PartWordSet.GetKey(KeyId));
+                }
+            }
+        }
+    } else {
+        // add new tokens to vocabulary in order of their first appearance
+        int PartTokenId = PartBow.TokenSet.FFirstKeyId();
+        while (PartBow.TokenSet.FNextKeyId(PartTokenId)) {
+            const TStr& TokenStr = PartBow.TokenSet.GetKey(PartTokenId);
+            int TokenId = TokenSet.GetKeyId(TokenStr);
+            if (TokenId == -1) {
+                UpdateP = true;
+                TokenId = TokenSet.AddKey(TokenStr);
+                DocFqV.Add(0); OldDocFqV.Add(0.0);
+                IAssert(TokenId == DocFqV.Len() - 1);
+            }
+            DocFqV[TokenId] += PartBow.DocFqV[PartTokenId];
+        }
+    }
+    // update document count
+    Docs += PartBow.Docs;
+    return UpdateP;
+}
+
 ///////////////////////////////////////
 // Sparse-Numeric-Feature-Generator
 
@@ -201,6 +201,17 @@ public:
     /// Forgetting, assumes calling on equally spaced time interval.
     void Forget(const double& Factor);
 
+    /// Bag of words with the same settings and without any documents. Used to collect
+    /// statistics from a part of documents, which are later added back using Merge.
+    TBagOfWords GetEmpty() const;
+    /// Adds documents and vocabulary of a bag of words with the same settings.
+    /// New tokens are added in their order from the given bag of words, so merging
+    /// consecutive parts in order gives the same vocabulary as updating with all
+    /// documents. Returns true if dimension changed.
+    bool Merge(const TBagOfWords& PartBow);
+    /// True when features can be computed from several threads at the same time
+    bool IsConcurrent() const { return !Tokenizer.Empty() && Tokenizer->IsConcurrent(); }
+
     /// Hashing Related Functions
     int GetDim() const { return IsHashing() ? HashDim.Val : TokenSet.Len(); }
     TStr GetVal(const int& ValN) const { return IsHashing() ? TInt::GetStr(ValN) : TokenSet.GetKey(ValN); }
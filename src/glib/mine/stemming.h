@@ -46,6 +46,8 @@ public:
 
   TStemmerType GetStemmerType(){
     return (TStemmerType)(int)StemmerType;}
+  // real-word stemmer remembers stems seen so far
+  bool IsRealWord() const {return RealWordP;}
 
   // stemmer creators
   static void GetStemmerTypeNmV(TStrV& StemmerTypeNmV, TStrV& StemmerTypeDNmV);
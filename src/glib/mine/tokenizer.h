@@ -42,6 +42,10 @@ public:
 	virtual void GetTokens(const PSIn& SIn, TStrV& TokenV) const = 0;
 	void GetTokens(const TStr& Text, TStrV& TokenV) const;
 	void GetTokens(const TStrV& TextV, TVec<TStrV>& TokenVV) const;
+
+	/// True when GetTokens can be called from several threads at the same time.
+	/// Feature extractors and the record indexer tokenize serially otherwise.
+	virtual bool IsConcurrent() const { return false; }
 };
 
 namespace TTokenizers {
@@ -67,6 +71,8 @@ public:
 	void Save(TSOut& SOut) const;
 
 	void GetTokens(const PSIn& SIn, TStrV& TokenV) const;
+	/// Only stemmer mapping stems to real words keeps state between calls
+	bool IsConcurrent() const { return Stemmer.Empty() || !Stemmer->IsRealWord(); }
     
     static TStr GetType() { return "simple"; }
 };
@@ -74,7 +80,7 @@ public:
 ///////////////////////////////
 // Tokenizer-Html
 //   HTML-aware tough tokenizer with stopwords and stemming.
-//   WARNING - NOT THREAD SAFE. WILL SEGFAULT
+//   WARNING - NOT THREAD SAFE WHEN STEMMER MAPS TO REAL WORDS (see IsConcurrent)
 class THtml : public TTokenizer {
 protected:
 	PSwSet SwSet;
@@ -94,6 +100,8 @@ public:
     void Save(TSOut& SOut) const { Save(SOut, true); }
 
 	void GetTokens(const PSIn& SIn, TStrV& TokenV) const;
+	/// Only stemmer mapping stems to real words keeps state between calls
+	bool IsConcurrent() const { return Stemmer.Empty() || !Stemmer->IsRealWord(); }
     
     static TStr GetType() { return "html"; }
 };
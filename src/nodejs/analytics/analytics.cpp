@@ -2184,6 +2184,14 @@ TNodeJsKMeans::TNodeJsKMeans(TSIn& SIn) :
     } else {
         throw TExcept::New("KMeans load constructor: loading invalid KMeans model!");
     }
+    // the mini-batch model keeps its own forgetting factor
+    if (CentType == TCentroidType::ctDense) {
+        const auto* MiniBatch = dynamic_cast<TClustering::TDenseMiniBatchKMeans*>((TClustering::TAbsKMeans<TFltVV>*)Model);
+        if (MiniBatch != nullptr) { Decay = MiniBatch->GetDecay(); }
+    } else {
+        const auto* MiniBatch = dynamic_cast<TClustering::TSparseMiniBatchKMeans*>((TClustering::TAbsKMeans<TVec<TIntFltKdV>>*)Model);
+        if (MiniBatch != nullptr) { Decay = MiniBatch->GetDecay(); }
+    }
 
     Notify = Verbose ? TQm::TEnv::Debug() : TNotify::NullNotify();
 }
@@ -2200,6 +2208,16 @@ void TNodeJsKMeans::UpdateParams(const PJsonVal& ParamVal) {
     if (ParamVal->IsObjKey("fitIdx")) { ParamVal->GetObjIntV("fitIdx", FitIdx); }
     if (ParamVal->IsObjKey("allowEmpty")) { AllowEmptyP = ParamVal->GetObjBool("allowEmpty"); }
     if (ParamVal->IsObjKey("calcDistQual")) { CalcDistQualP = ParamVal->GetObjBool("calcDistQual"); }
+    if (ParamVal->IsObjKey("threads")) {
+        const int NewThreads = ParamVal->GetObjInt("threads");
+        EAssertR(NewThreads > 0, "Number of threads must be positive!");
+        Threads = NewThreads;
+    }
+    if (ParamVal->IsObjKey("decay")) {
+        const double NewDecay = ParamVal->GetObjNum("decay");
+        EAssertR(0 < NewDecay && NewDecay <= 1, "Decay must be in (0, 1]!");
+        Decay = NewDecay;
+    }
     if (ParamVal->IsObjKey("distanceType")) {
         TStr dist = ParamVal->GetObjStr("distanceType");
         if (dist == "Euclid") {
@@ -2249,23 +2267,24 @@ void TNodeJsKMeans::Save(TSOut& SOut) const {
     SaveEnum<TCentroidType>(SOut, CentType);
     TBool(Verbose).Save(SOut);
     if (CentType == TCentroidType::ctDense) {
-        ((TClustering::TDnsKMeans<TFltVV>*)Model)->Save(SOut);
+        ((TClustering::TAbsKMeans<TFltVV>*)Model)->Save(SOut);
     } else if (CentType == TCentroidType::ctSparse) {
-        ((TClustering::TDnsKMeans<TVec<TIntFltKdV>>*)Model)->Save(SOut);
+        ((TClustering::TAbsKMeans<TVec<TIntFltKdV>>*)Model)->Save(SOut);
     }
 }
 
 void TNodeJsKMeans::CleanUp() {
     if (Model != nullptr) {
         if (CentType == TCentroidType::ctDense) {
-            delete (TClustering::TDnsKMeans<TFltVV>*) Model;
+            delete (TClustering::TAbsKMeans<TFltVV>*) Model;
         }
         else if (CentType == TCentroidType::ctSparse) {
-            delete (TClustering::TDnsKMeans<TVec<TIntFltKdV>>*) Model;
+            delete (TClustering::TAbsKMeans<TVec<TIntFltKdV>>*) Model;
         }
         else {
             throw TExcept::New("KMeans.fit: CentroidType not recognized!");
         }
+        Model = nullptr;
     }
 }
 
@@ -2283,6 +2302,7 @@ void TNodeJsKMeans::Init(v8::Local<v8::Object> exports) {
     NODE_SET_PROTOTYPE_METHOD(tpl, "setParams", _setParams);
     NODE_SET_PROTOTYPE_METHOD(tpl, "fit", _fit);
     NODE_SET_PROTOTYPE_METHOD(tpl, "fitAsync", _fitAsync);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "partialFit", _partialFit);
     NODE_SET_PROTOTYPE_METHOD(tpl, "predict", _predict);
     NODE_SET_PROTOTYPE_METHOD(tpl, "transform", _transform);
     NODE_SET_PROTOTYPE_METHOD(tpl, "permuteCentroids", _permuteCentroids);
@@ -2367,6 +2387,8 @@ void TNodeJsKMeans::getParams(const v8::FunctionCallbackInfo<v8::Value>& Args) {
         JsObj->Set(v8::Local<v8::String>(v8::String::NewFromUtf8(Isolate, "verbose")), v8::Boolean::New(Isolate, JsKMeans->Verbose));
         JsObj->Set(v8::Local<v8::String>(v8::String::NewFromUtf8(Isolate, "allowEmpty")), v8::Boolean::New(Isolate, JsKMeans->AllowEmptyP));
         JsObj->Set(v8::Local<v8::String>(v8::String::NewFromUtf8(Isolate, "calcDistQual")), v8::Boolean::New(Isolate, JsKMeans->CalcDistQualP));
+        JsObj->Set(v8::Local<v8::String>(v8::String::NewFromUtf8(Isolate, "threads")), v8::Integer::New(Isolate, JsKMeans->Threads));
+        JsObj->Set(v8::Local<v8::String>(v8::String::NewFromUtf8(Isolate, "decay")), v8::Number::New(Isolate, JsKMeans->Decay));
 
         if (!JsKMeans->FitIdx.Empty()) {
             v8::Local<v8::Array> FitIdx = v8::Array::New(Isolate, JsKMeans->FitIdx.Len());
@@ -2504,8 +2526,9 @@ void TNodeJsKMeans::TFitTask::Run() {
        // create a new model
        if (JsKMeans->CentType == TCentroidType::ctDense) {
            TClustering::TDenseKMeans* KMeans = new TClustering::TDenseKMeans(JsKMeans->K, TRnd(0), JsKMeans->Dist, CalcDistQualP);
+           KMeans->SetThreads(JsKMeans->Threads);
 
-           JsKMeans->Model = (void*) KMeans;
+           JsKMeans->Model = (void*) static_cast<TClustering::TAbsKMeans<TFltVV>*>(KMeans);
 
            // input dense matrix
            if (JsFltVV != nullptr) {
@@ -2611,7 +2634,8 @@ void TNodeJsKMeans::TFitTask::Run() {
        }
        else if (JsKMeans->CentType == TCentroidType::ctSparse) {
            TClustering::TSparseKMeans* KMeans = new TClustering::TSparseKMeans(JsKMeans->K, TRnd(0), JsKMeans->Dist, CalcDistQualP);
-           JsKMeans->Model = (void*) KMeans;
+           KMeans->SetThreads(JsKMeans->Threads);
+           JsKMeans->Model = (void*) static_cast<TClustering::TAbsKMeans<TVec<TIntFltKdV>>*>(KMeans);
 
            // input dense matrix
            if (JsFltVV != nullptr) {
@@ -2733,6 +2757,63 @@ void TNodeJsKMeans::TFitTask::Run() {
     }
 }
 
+void TNodeJsKMeans::partialFit(const v8::FunctionCallbackInfo<v8::Value>& Args) {
+    v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope HandleScope(Isolate);
+
+    EAssertR(Args.Length() == 1, "KMeans.partialFit: expects 1 argument!");
+    TNodeJsKMeans* JsKMeans = ObjectWrap::Unwrap<TNodeJsKMeans>(Args.Holder());
+
+    try {
+        const bool IsDenseArg = TNodeJsUtil::IsArgWrapObj<TNodeJsFltVV>(Args, 0);
+        EAssertR(IsDenseArg || TNodeJsUtil::IsArgWrapObj<TNodeJsSpMat>(Args, 0),
+            "KMeans.partialFit: expects a dense or sparse matrix!");
+
+        if (JsKMeans->CentType == TCentroidType::ctDense) {
+            TClustering::TDenseMiniBatchKMeans* MiniBatch = dynamic_cast<TClustering::TDenseMiniBatchKMeans*>(
+                (TClustering::TAbsKMeans<TFltVV>*)JsKMeans->Model);
+            // models created by fit are replaced
+            if (MiniBatch == nullptr) {
+                JsKMeans->CleanUp();
+                MiniBatch = new TClustering::TDenseMiniBatchKMeans(JsKMeans->K, JsKMeans->Decay,
+                    100, TRnd(0), JsKMeans->Dist, JsKMeans->CalcDistQualP);
+                JsKMeans->Model = (void*) static_cast<TClustering::TAbsKMeans<TFltVV>*>(MiniBatch);
+            }
+            if (IsDenseArg) {
+                MiniBatch->PartialFit(TNodeJsUtil::GetArgUnwrapObj<TNodeJsFltVV>(Args, 0)->Mat, JsKMeans->AssignV);
+            } else {
+                MiniBatch->PartialFit(TNodeJsUtil::GetArgUnwrapObj<TNodeJsSpMat>(Args, 0)->Mat, JsKMeans->AssignV);
+            }
+        }
+        else if (JsKMeans->CentType == TCentroidType::ctSparse) {
+            TClustering::TSparseMiniBatchKMeans* MiniBatch = dynamic_cast<TClustering::TSparseMiniBatchKMeans*>(
+                (TClustering::TAbsKMeans<TVec<TIntFltKdV>>*)JsKMeans->Model);
+            // models created by fit are replaced
+            if (MiniBatch == nullptr) {
+                JsKMeans->CleanUp();
+                MiniBatch = new TClustering::TSparseMiniBatchKMeans(JsKMeans->K, JsKMeans->Decay,
+                    100, TRnd(0), JsKMeans->Dist, JsKMeans->CalcDistQualP);
+                JsKMeans->Model = (void*) static_cast<TClustering::TAbsKMeans<TVec<TIntFltKdV>>*>(MiniBatch);
+            }
+            if (IsDenseArg) {
+                MiniBatch->PartialFit(TNodeJsUtil::GetArgUnwrapObj<TNodeJsFltVV>(Args, 0)->Mat, JsKMeans->AssignV);
+            } else {
+                MiniBatch->PartialFit(TNodeJsUtil::GetArgUnwrapObj<TNodeJsSpMat>(Args, 0)->Mat, JsKMeans->AssignV);
+            }
+        }
+        else {
+            throw TExcept::New("KMeans.partialFit: invalid centroid type " + TInt::GetStr((int)JsKMeans->CentType));
+        }
+        // medoids are only computed by fit
+        JsKMeans->Medoids.Clr();
+
+        Args.GetReturnValue().Set(Args.Holder());
+    }
+    catch (const PExcept& Except) {
+        throw TExcept::New(Except->GetMsgStr(), "KMeans::partialFit");
+    }
+}
+
 void TNodeJsKMeans::predict(const v8::FunctionCallbackInfo<v8::Value>& Args) {
     v8::Isolate* Isolate = v8::Isolate::GetCurrent();
     v8::HandleScope HandleScope(Isolate);
@@ -2748,10 +2829,10 @@ void TNodeJsKMeans::predict(const v8::FunctionCallbackInfo<v8::Value>& Args) {
     if (TNodeJsUtil::IsArgWrapObj<TNodeJsFltVV>(Args, 0)) {
         const TFltVV& Mat = TNodeJsUtil::GetArgUnwrapObj<TNodeJsFltVV>(Args, 0)->Mat;
         if (JsKMeans->CentType == TCentroidType::ctDense) {
-            ((TClustering::TDnsKMeans<TFltVV>*)JsKMeans->Model)->Assign(Mat, AssignV);
+            ((TClustering::TAbsKMeans<TFltVV>*)JsKMeans->Model)->Assign(Mat, AssignV);
         }
         else if (JsKMeans->CentType == TCentroidType::ctSparse) {
-            ((TClustering::TDnsKMeans<TVec<TIntFltKdV>>*)JsKMeans->Model)->Assign(Mat, AssignV);
+            ((TClustering::TAbsKMeans<TVec<TIntFltKdV>>*)JsKMeans->Model)->Assign(Mat, AssignV);
         }
         else {
             throw TExcept::New("KMeans.predict: invalid centroid type " + TInt::GetStr((int)JsKMeans->CentType));
@@ -2760,10 +2841,10 @@ void TNodeJsKMeans::predict(const v8::FunctionCallbackInfo<v8::Value>& Args) {
     else if (TNodeJsUtil::IsArgWrapObj<TNodeJsSpMat>(Args, 0)) {
         const TVec<TIntFltKdV>& Mat = TNodeJsUtil::GetArgUnwrapObj<TNodeJsSpMat>(Args, 0)->Mat;
         if (JsKMeans->CentType == TCentroidType::ctDense) {
-            ((TClustering::TDnsKMeans<TFltVV>*)JsKMeans->Model)->Assign(Mat, AssignV);
+            ((TClustering::TAbsKMeans<TFltVV>*)JsKMeans->Model)->Assign(Mat, AssignV);
         }
         else if (JsKMeans->CentType == TCentroidType::ctSparse) {
-            ((TClustering::TDnsKMeans<TVec<TIntFltKdV>>*)JsKMeans->Model)->Assign(Mat, AssignV);
+            ((TClustering::TAbsKMeans<TVec<TIntFltKdV>>*)JsKMeans->Model)->Assign(Mat, AssignV);
         }
         else {
             throw TExcept::New("KMeans.predict: invalid centroid type " + TInt::GetStr((int)JsKMeans->CentType));
@@ -2793,11 +2874,11 @@ void TNodeJsKMeans::transform(const v8::FunctionCallbackInfo<v8::Value>& Args) {
         TFltVV& Mat = TNodeJsUtil::GetArgUnwrapObj<TNodeJsFltVV>(Args, 0)->Mat;
         // if centroids are dense
         if (JsKMeans->CentType == TCentroidType::ctDense) {
-            JsKMeans->Dist->GetDistVV(((TClustering::TDnsKMeans<TFltVV>*)JsKMeans->Model)->GetCentroidVV(), Mat, D);
+            JsKMeans->Dist->GetDistVV(((TClustering::TAbsKMeans<TFltVV>*)JsKMeans->Model)->GetCentroidVV(), Mat, D);
         }
         // if centroids are sparse
         else if (JsKMeans->CentType == TCentroidType::ctSparse) {
-            JsKMeans->Dist->GetDistVV(((TClustering::TDnsKMeans<TVec<TIntFltKdV>>*)JsKMeans->Model)->GetCentroidVV(), Mat, D);
+            JsKMeans->Dist->GetDistVV(((TClustering::TAbsKMeans<TVec<TIntFltKdV>>*)JsKMeans->Model)->GetCentroidVV(), Mat, D);
         }
         else {
             throw TExcept::New("KMeans.explain: centroid type invalid " + TInt::GetStr((int) JsKMeans->CentType));
@@ -2808,11 +2889,11 @@ void TNodeJsKMeans::transform(const v8::FunctionCallbackInfo<v8::Value>& Args) {
         TVec<TIntFltKdV>& Mat = TNodeJsUtil::GetArgUnwrapObj<TNodeJsSpMat>(Args, 0)->Mat;
         // if centroids are dense
         if (JsKMeans->CentType == TCentroidType::ctDense) {
-            JsKMeans->Dist->GetDistVV(((TClustering::TDnsKMeans<TFltVV>*)JsKMeans->Model)->GetCentroidVV(), Mat, D);
+            JsKMeans->Dist->GetDistVV(((TClustering::TAbsKMeans<TFltVV>*)JsKMeans->Model)->GetCentroidVV(), Mat, D);
         }
         // if centroids are sparse
         else if (JsKMeans->CentType == TCentroidType::ctSparse) {
-            JsKMeans->Dist->GetDistVV(((TClustering::TDnsKMeans<TVec<TIntFltKdV>>*)JsKMeans->Model)->GetCentroidVV(), Mat, D);
+            JsKMeans->Dist->GetDistVV(((TClustering::TAbsKMeans<TVec<TIntFltKdV>>*)JsKMeans->Model)->GetCentroidVV(), Mat, D);
         }
         else {
             throw TExcept::New("KMeans.explain: centroid type invalid " + TInt::GetStr((int) JsKMeans->CentType));
@@ -2843,10 +2924,10 @@ void TNodeJsKMeans::permuteCentroids(const v8::FunctionCallbackInfo<v8::Value>&
         EAssertR(TLinAlgSearch::GetMaxVal(Mapping) + 1 == JsKMeans->K, "KMeans.permuteCentroids: maximum index of parameter must be equal to number of centroids!");
 
         if (JsKMeans->CentType == TCentroidType::ctDense) {
-            ((TClustering::TDnsKMeans<TFltVV>*)JsKMeans->Model)->PermutateCentroids(Mapping);
+            ((TClustering::TAbsKMeans<TFltVV>*)JsKMeans->Model)->PermutateCentroids(Mapping);
         }
         else if (JsKMeans->CentType == TCentroidType::ctSparse) {
-            ((TClustering::TDnsKMeans<TVec<TIntFltKdV>>*)JsKMeans->Model)->PermutateCentroids(Mapping);
+            ((TClustering::TAbsKMeans<TVec<TIntFltKdV>>*)JsKMeans->Model)->PermutateCentroids(Mapping);
         }
         else {
             throw TExcept::New("KMeans.permuteCentroids: centroid type invalid " + TInt::GetStr((int)JsKMeans->CentType));
@@ -2897,10 +2978,10 @@ void TNodeJsKMeans::centroids(v8::Local<v8::Name> Name, const v8::PropertyCallba
         Info.GetReturnValue();
     } else {
         if (JsKMeans->CentType == TCentroidType::ctDense) {
-            Info.GetReturnValue().Set(TNodeJsFltVV::New(((TClustering::TDnsKMeans<TFltVV>*)JsKMeans->Model)->GetCentroidVV()));
+            Info.GetReturnValue().Set(TNodeJsFltVV::New(((TClustering::TAbsKMeans<TFltVV>*)JsKMeans->Model)->GetCentroidVV()));
         }
         else if (JsKMeans->CentType == TCentroidType::ctSparse) {
-            Info.GetReturnValue().Set(TNodeJsSpMat::New(((TClustering::TDnsKMeans<TVec<TIntFltKdV>>*)JsKMeans->Model)->GetCentroidVV()));
+            Info.GetReturnValue().Set(TNodeJsSpMat::New(((TClustering::TAbsKMeans<TVec<TIntFltKdV>>*)JsKMeans->Model)->GetCentroidVV()));
         }
         else {
             throw TExcept::New("KMeans.centroids: Centroid type not valid " + TInt::GetStr((int)JsKMeans->CentType));
@@ -2948,13 +3029,13 @@ void TNodeJsKMeans::relMeanCentroidDist(v8::Local<v8::Name> Name, const v8::Prop
     else {
         switch (JsKMeans->CentType) {
             case ctDense: {
-                const TClustering::TDenseKMeans* KMeans = static_cast<TClustering::TDenseKMeans*>(JsKMeans->Model);
+                const TClustering::TAbsKMeans<TFltVV>* KMeans = static_cast<TClustering::TAbsKMeans<TFltVV>*>(JsKMeans->Model);
                 const double RelMeanDist = KMeans->GetRelMeanCentroidDist();
                 Info.GetReturnValue().Set(v8::Number::New(Isolate, RelMeanDist));
                 break;
             }
             case ctSparse: {
-                const TClustering::TSparseKMeans* KMeans = static_cast<TClustering::TSparseKMeans*>(JsKMeans->Model);
+                const TClustering::TAbsKMeans<TVec<TIntFltKdV>>* KMeans = static_cast<TClustering::TAbsKMeans<TVec<TIntFltKdV>>*>(JsKMeans->Model);
                 const double RelMeanDist = KMeans->GetRelMeanCentroidDist();
                 Info.GetReturnValue().Set(v8::Number::New(Isolate, RelMeanDist));
                 break;
@@ -3065,6 +3146,11 @@ void TNodeJsDpMeans::UpdateParams(const PJsonVal& ParamVal) {
     if (ParamVal->IsObjKey("fitIdx")) { ParamVal->GetObjIntV("fitIdx", FitIdx); }
     if (ParamVal->IsObjKey("allowEmpty")) { AllowEmptyP = ParamVal->GetObjBool("allowEmpty"); }
     if (ParamVal->IsObjKey("calcDistQual")) { CalcDistQualP = ParamVal->GetObjBool("calcDistQual"); }
+    if (ParamVal->IsObjKey("threads")) {
+        const int NewThreads = ParamVal->GetObjInt("threads");
+        EAssertR(NewThreads > 0, "Number of threads must be positive!");
+        Threads = NewThreads;
+    }
     if (ParamVal->IsObjKey("distanceType")) {
         TStr dist = ParamVal->GetObjStr("distanceType");
         if (dist == "Euclid") {
@@ -3238,6 +3324,7 @@ void TNodeJsDpMeans::getParams(const v8::FunctionCallbackInfo<v8::Value>& Args)
         JsObj->Set(v8::Local<v8::String>(v8::String::NewFromUtf8(Isolate, "verbose")), v8::Boolean::New(Isolate, JsDpMeans->Verbose));
         JsObj->Set(v8::Local<v8::String>(v8::String::NewFromUtf8(Isolate, "allowEmpty")), v8::Boolean::New(Isolate, JsDpMeans->AllowEmptyP));
         JsObj->Set(v8::Local<v8::String>(v8::String::NewFromUtf8(Isolate, "calcDistQual")), v8::Boolean::New(Isolate, JsDpMeans->CalcDistQualP));
+        JsObj->Set(v8::Local<v8::String>(v8::String::NewFromUtf8(Isolate, "threads")), v8::Integer::New(Isolate, JsDpMeans->Threads));
 
         if (!JsDpMeans->FitIdx.Empty()) {
             v8::Local<v8::Array> FitIdx = v8::Array::New(Isolate, JsDpMeans->FitIdx.Len());
@@ -3370,6 +3457,7 @@ void TNodeJsDpMeans::TFitTask::Run() {
        // create a new model
        if (JsDpMeans->CentType == TCentroidType::ctDense) {
            TDenseModel* DpMeans = new TDenseModel(JsDpMeans->Lambda, JsDpMeans->MnClusts, JsDpMeans->MxClusts, TRnd(0), JsDpMeans->Dist, CalcDistQualP);
+           DpMeans->SetThreads(JsDpMeans->Threads);
            JsDpMeans->DpMeansModel = (void*) DpMeans;
 
            // input dense matrix
@@ -3476,6 +3564,7 @@ void TNodeJsDpMeans::TFitTask::Run() {
        }
        else if (JsDpMeans->CentType == TCentroidType::ctSparse) {
            TSparseModel* DpMeans = new TSparseModel(JsDpMeans->Lambda, JsDpMeans->MnClusts, JsDpMeans->MxClusts, TRnd(0), JsDpMeans->Dist, CalcDistQualP);
+           DpMeans->SetThreads(JsDpMeans->Threads);
            JsDpMeans->DpMeansModel = (void*) DpMeans;
 
            // input dense matrix
@@ -1677,6 +1677,8 @@ exports = {}; require.modules.qminer_analytics = exports;
 * @property {number} [k=2] - The number of centroids.
 * @property {boolean} [allowEmpty=true] - Whether to allow empty clusters to be generated.
 * @property {boolean} [calcDistQual=false] - Whether to calculate the quality measure based on distance, if false relMeanCentroidDist will return 'undefined'
+* @property {number} [threads=1] - The number of threads used for assignment and centroid update. Only used with dense centroids and is not saved with the model.
+* @property {number} [decay=1] - Used by {@link module:analytics.KMeans#partialFit}. The factor the cluster sizes are multiplied with before each batch, values below 1 let the centroids follow a drifting stream.
 * @property {string} [centroidType="Dense"] - The type of centroids. Possible options are `'Dense'` and `'Sparse'`.
 * @property {string} [distanceType="Euclid"] - The distance type used at the calculations. Possible options are `'Euclid'` and `'Cos'`.
 * @property {boolean} [verbose=false] - If `false`, the console output is supressed.
@@ -1760,6 +1762,26 @@ exports = {}; require.modules.qminer_analytics = exports;
      * KMeans.fit(X);
      */
  exports.KMeans.prototype.fit = function (X) { return Object.create(require('qminer').analytics.KMeans.prototype); }
+/**
+     * Updates the centroids with a batch of examples (mini-batch KMeans). The first call
+     * starts a new model whose centroids are the first `k` examples, each following example
+     * moves its closest centroid towards itself. Calling {@link module:analytics.KMeans#fit}
+     * replaces the model and the next call starts over.
+     * @param {module:la.Matrix | module:la.SparseMatrix} X - Matrix whose columns correspond to examples.
+     * @returns {module:analytics.KMeans} Self. The model has been updated and {@link module:analytics.KMeans#idxv} holds the assignments of the batch.
+     * @example
+     * // import analytics module
+     * var analytics = require('qminer').analytics;
+     * var la = require('qminer').la;
+     * // create a new KMeans object
+     * var KMeans = new analytics.KMeans({ k: 2, decay: 0.9 });
+     * // update the model with two batches
+     * KMeans.partialFit(new la.Matrix([[1, -2, -1], [1, 1, -3]]));
+     * KMeans.partialFit(new la.Matrix([[2, -1], [0, 1]]));
+     * // predict the cluster of a new example
+     * var prediction = KMeans.predict(new la.Matrix([[1], [1]]));
+     */
+ exports.KMeans.prototype.partialFit = function (X) { return Object.create(require('qminer').analytics.KMeans.prototype); }
 /**
      * Returns an vector of cluster id assignments.
      * @param {module:la.Matrix | module:la.SparseMatrix} A - Matrix whose columns correspond to examples.
@@ -1912,6 +1934,7 @@ exports = {}; require.modules.qminer_analytics = exports;
 * @property {number} [maxClusters=inf] - Maximum number of clusters
 * @property {boolean} [allowEmpty=true] - Whether to allow empty clusters to be generated.
 * @property {boolean} [calcDistQual=false] - Whether to calculate the quality measure based on distance, if false relMeanCentroidDist will return 'undefined'
+* @property {number} [threads=1] - The number of threads used for assignment and centroid update. Only used with dense centroids and is not saved with the model.
 * @property {string} [centroidType="Dense"] - The type of centroids. Possible options are `'Dense'` and `'Sparse'`.
 * @property {string} [distanceType="Euclid"] - The distance type used at the calculations. Possible options are `'Euclid'` and `'Cos'`.
 * @property {boolean} [verbose=false] - If `false`, the console output is supressed.
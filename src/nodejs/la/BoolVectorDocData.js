@@ -42,8 +42,10 @@ exports.view = {
     "skipNorm": "skip.",
     "skipSparse": "skip.",
     "skipToMat": "skip.",
+    "skipFloat64Array": "skip.",
     "skipSave": "",
     "skipLoad": "",
     
+    "float64ArrayCons": " (values are copied)",
     "defaultVal": "false",
 }
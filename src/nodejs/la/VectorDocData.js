@@ -41,8 +41,10 @@ exports.view = {
 	"skipNorm": "",
 	"skipSparse": "",
 	"skipToMat": "",
+	"skipFloat64Array": "",
 	"skipSave": "",
     "skipLoad": "",
     
+    "float64ArrayCons": ", which shares its memory with the vector (no copying)",
     "defaultVal": "0.0",
 }
\ No newline at end of file
@@ -67,6 +67,7 @@ void TNodeJsFltVV::Init(v8::Local<v8::Object> exports) {
     NODE_SET_PROTOTYPE_METHOD(Tpl, "load", _load);
     NODE_SET_PROTOTYPE_METHOD(Tpl, "saveascii", _saveascii);
     NODE_SET_PROTOTYPE_METHOD(Tpl, "loadascii", _loadascii);
+    NODE_SET_PROTOTYPE_METHOD(Tpl, "asFloat64Array", _asFloat64Array);
 
     // Properties
     Tpl->InstanceTemplate()->SetAccessor(v8::String::NewFromUtf8(Isolate, "rows"), _rows);
@@ -109,9 +110,21 @@ TNodeJsFltVV* TNodeJsFltVV::NewFromArgs(const v8::FunctionCallbackInfo<v8::Value
             return new TNodeJsFltVV(Mat);
         } else {
             if (Args[0]->IsObject()) {
+                v8::Local<v8::Value> DataVal = Args[0]->ToObject()->Get(v8::String::NewFromUtf8(Isolate, "data"));
                 if (TNodeJsUtil::IsArgWrapObj<TNodeJsFltVV>(Args, 0)) {
                     TNodeJsFltVV* FltVV = TNodeJsUtil::GetArgUnwrapObj<TNodeJsFltVV>(Args, 0);
                     Mat = FltVV->Mat;
+                } else if (DataVal->IsFloat64Array()) {
+                    const int Cols = TNodeJsUtil::GetArgInt32(Args, 0, "cols");
+                    const int Rows = TNodeJsUtil::GetArgInt32(Args, 0, "rows");
+                    EAssert(Cols >= 0 && Rows >= 0);
+                    v8::Local<v8::Float64Array> Data = v8::Local<v8::Float64Array>::Cast(DataVal);
+                    EAssertR((int)Data->Length() == Rows * Cols, "Expected data of length rows * cols");
+                    // adopt memory of the typed array instead of copying it
+                    TNodeJsFltVV* JsMat = new TNodeJsFltVV();
+                    JsMat->SharedBuf.Adopt(Data, JsMat->Mat.Get1DVec());
+                    JsMat->Mat.GenExt(JsMat->Mat.Get1DVec().BegI(), Rows, Cols);
+                    return JsMat;
                 } else {
                     const bool GenRandom = TNodeJsUtil::GetArgBool(Args, 0, "random", false);
                     const int Cols = TNodeJsUtil::GetArgInt32(Args, 0, "cols");
@@ -661,6 +674,7 @@ void TNodeJsFltVV::load(const v8::FunctionCallbackInfo<v8::Value>& Args) {
     PSIn SIn = JsFIn->SIn;
     // Load from stream
     JsFltVV->Mat.Load(*SIn);
+    JsFltVV->SharedBuf.Reset();
 
     Args.GetReturnValue().Set(v8::Undefined(Isolate));
 }
@@ -690,10 +704,19 @@ void TNodeJsFltVV::loadascii(const v8::FunctionCallbackInfo<v8::Value>& Args) {
     TNodeJsFIn* JsFIn = ObjectWrap::Unwrap<TNodeJsFIn>(Args[0]->ToObject());
     PSIn SIn = JsFIn->SIn;
     TLinAlgIO::LoadMatlabTFltVV(JsFltVV->Mat, *SIn);
+    JsFltVV->SharedBuf.Reset();
 
     Args.GetReturnValue().Set(v8::Undefined(Isolate));
 }
 
+void TNodeJsFltVV::asFloat64Array(const v8::FunctionCallbackInfo<v8::Value>& Args) {
+    v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope HandleScope(Isolate);
+
+    TNodeJsFltVV* JsFltVV = ObjectWrap::Unwrap<TNodeJsFltVV>(Args.Holder());
+    Args.GetReturnValue().Set(JsFltVV->SharedBuf.GetFloat64Array(JsFltVV->Mat.Get1DVec()));
+}
+
 void TNodeJsFltVV::cols(v8::Local<v8::Name> Name, const v8::PropertyCallbackInfo<v8::Value>& Info) {
     v8::Isolate* Isolate = v8::Isolate::GetCurrent();
     v8::HandleScope HandleScope(Isolate);
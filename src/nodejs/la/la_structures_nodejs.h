@@ -14,6 +14,111 @@
 #include "../nodeutil.h"
 #include "../fs/fs_nodejs.h"
 
+///////////////////////////////
+// NodeJs-Linalg-Shared-Buffer
+// Shares values of a vector of doubles with a JavaScript array buffer. Values live
+// in the buffer's memory, so typed arrays viewing them stay valid for as long as
+// they are referenced, also after the vector itself is gone. Vector changing its
+// length first gets its own copy of values and stops sharing them.
+class TNodeJsFltBuf {
+private:
+    // values moved out of a vector, freed when their array buffer is garbage collected
+    class TOwner {
+    public:
+        v8::Persistent<v8::ArrayBuffer> Buffer;
+        TFltV ValV;
+        static void OnGc(const v8::WeakCallbackInfo<TOwner>& Info) {
+            TOwner* Owner = Info.GetParameter();
+            Info.GetIsolate()->AdjustAmountOfExternalAllocatedMemory(
+                -(int64_t)(Owner->ValV.Len() * sizeof(double)));
+            Owner->Buffer.Reset(); delete Owner;
+        }
+    };
+    // memory allocated by V8 for an adopted array buffer, freed when the buffer
+    // is garbage collected
+    class TV8Owner {
+    public:
+        v8::Persistent<v8::ArrayBuffer> Buffer;
+        void* Data;
+        static void OnGc(const v8::WeakCallbackInfo<TV8Owner>& Info) {
+            TV8Owner* Owner = Info.GetParameter();
+            free(Owner->Data); Owner->Buffer.Reset(); delete Owner;
+        }
+    };
+
+    // array buffer holding the vector's values, empty when not shared
+    v8::Global<v8::ArrayBuffer> Buffer;
+    // position of the first value in the array buffer
+    size_t ByteOffset;
+
+public:
+    TNodeJsFltBuf(): ByteOffset(0) { }
+    ~TNodeJsFltBuf() { Buffer.Reset(); }
+
+    // true when ValV still uses memory of the array buffer (a detached buffer
+    // has no contents, so it no longer matches)
+    bool IsShared(const TFltV& ValV) const {
+        if (Buffer.IsEmpty() || !ValV.IsExt()) { return false; }
+        v8::Local<v8::ArrayBuffer> ArrayBuffer = v8::Local<v8::ArrayBuffer>::New(
+            v8::Isolate::GetCurrent(), Buffer);
+        v8::ArrayBuffer::Contents Contents = ArrayBuffer->GetContents();
+        return ((char*)Contents.Data() + ByteOffset == (char*)ValV.BegI()) &&
+            (ByteOffset + ValV.Len() * sizeof(double) <= Contents.ByteLength());
+    }
+
+    // typed array viewing values of ValV; on first call the values are moved
+    // (not copied) to memory owned by a new array buffer
+    v8::Local<v8::Float64Array> GetFloat64Array(TFltV& ValV) {
+        static_assert(sizeof(TFlt) == sizeof(double), "TFlt must be laid out as double");
+        v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+        v8::EscapableHandleScope HandleScope(Isolate);
+        if (!IsShared(ValV)) {
+            TOwner* Owner = new TOwner;
+            // vectors over external memory do not own it, so we can only copy them
+            if (ValV.IsExt()) { Owner->ValV = ValV; } else { Owner->ValV.MoveFrom(ValV); }
+            const size_t ByteLength = Owner->ValV.Len() * sizeof(double);
+            v8::Local<v8::ArrayBuffer> ArrayBuffer = v8::ArrayBuffer::New(Isolate,
+                (void*)Owner->ValV.BegI(), ByteLength, v8::ArrayBufferCreationMode::kExternalized);
+            Owner->Buffer.Reset(Isolate, ArrayBuffer);
+            Owner->Buffer.SetWeak(Owner, TOwner::OnGc, v8::WeakCallbackType::kParameter);
+            Isolate->AdjustAmountOfExternalAllocatedMemory((int64_t)ByteLength);
+            ValV.GenExt(Owner->ValV.BegI(), Owner->ValV.Len());
+            Buffer.Reset(Isolate, ArrayBuffer); ByteOffset = 0;
+        }
+        v8::Local<v8::ArrayBuffer> ArrayBuffer = v8::Local<v8::ArrayBuffer>::New(Isolate, Buffer);
+        return HandleScope.Escape(v8::Float64Array::New(ArrayBuffer, ByteOffset, ValV.Len()));
+    }
+
+    // makes ValV use memory of the typed array, without copying it
+    void Adopt(const v8::Local<v8::Float64Array>& Array, TFltV& ValV) {
+        v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+        v8::HandleScope HandleScope(Isolate);
+        // asking for the buffer moves values of small arrays out of the heap
+        v8::Local<v8::ArrayBuffer> ArrayBuffer = Array->Buffer();
+        if (!ArrayBuffer->IsExternal()) {
+            // take over memory of the buffer, so it stays valid even if the buffer
+            // gets detached (external buffers are copied, not moved, to workers)
+            TV8Owner* Owner = new TV8Owner;
+            Owner->Data = ArrayBuffer->Externalize().Data();
+            Owner->Buffer.Reset(Isolate, ArrayBuffer);
+            Owner->Buffer.SetWeak(Owner, TV8Owner::OnGc, v8::WeakCallbackType::kParameter);
+        }
+        char* Data = (char*)ArrayBuffer->GetContents().Data();
+        Buffer.Reset(Isolate, ArrayBuffer); ByteOffset = Array->ByteOffset();
+        ValV.GenExt((TFlt*)(Data + ByteOffset), (int)Array->Length());
+    }
+
+    // gives ValV its own copy of shared values, so its length can change
+    template <class TVal>
+    void Release(TVec<TVal>& ValV) {
+        if (ValV.IsExt()) { TVec<TVal> OwnValV(ValV); ValV.Swap(OwnValV); }
+        Reset();
+    }
+
+    // forgets the array buffer, once the values no longer use its memory
+    void Reset() { Buffer.Reset(); ByteOffset = 0; }
+};
+
 ///////////////////////////////
 // NodeJs-Linalg-FltVV
 
@@ -23,6 +128,7 @@
 * @property {number} rows - Number of rows.
 * @property {number} cols - Number of columns.
 * @property {boolean} [random=false] - Generate a random matrix with entries sampled from a uniform [0,1] distribution. If set to false, a zero matrix is created.
+* @property {Float64Array} [data] - Matrix elements in row major order, of length `rows * cols`. The matrix shares its memory with the array (no copying), see {@link module:la.Matrix#asFloat64Array}.
 */
 
 /**
@@ -507,12 +613,35 @@ private:
     //# exports.Matrix.prototype.load = function (FIn) { return Object.create(require('qminer').la.Matrix.prototype); }
     JsDeclareFunction(load);
 
+    /**
+    * Returns a `Float64Array` view of the matrix elements in row major order, without copying them.
+    * Writes through the view change the matrix and vice versa. The view stays valid also after the
+    * matrix is garbage collected, but no longer reflects its changes once the matrix is loaded anew.
+    * @returns {Float64Array} The view of the matrix elements, of length `rows * cols`.
+    * @example
+    * // import la module
+    * var la = require('qminer').la;
+    * // create a new matrix
+    * var mat = new la.Matrix([[1, 2], [3, 4]]);
+    * // get the view of the matrix elements
+    * var arr = mat.asFloat64Array(); // arr is [1, 2, 3, 4]
+    * // changes are visible in the matrix
+    * arr[1] = 5; // mat.at(0, 1) is now 5
+    * // create a matrix over an existing array
+    * var mat2 = new la.Matrix({ rows: 2, cols: 2, data: new Float64Array([1, 2, 3, 4]) });
+    */
+    //# exports.Matrix.prototype.asFloat64Array = function () { return new Float64Array(0); }
+    JsDeclareFunction(asFloat64Array);
+
     //!- `fout = mat.saveascii(fout)` -- save `mat` (full matrix) to output stream `fout`. Returns `fout`.
     JsDeclareFunction(saveascii);
     //!- `mat = mat.loadascii(fin)` -- replace `mat` (full matrix) by loading from input steam `fin`. `mat` has to be initialized first, for example using `mat = la.newMat()`. Returns self.
     JsDeclareFunction(loadascii);
 public:
     TFltVV Mat;
+private:
+    // array buffer sharing elements of Mat, see asFloat64Array
+    TNodeJsFltBuf SharedBuf;
 };
 
 
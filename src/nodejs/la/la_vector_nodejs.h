@@ -154,9 +154,10 @@ public:
 * <% title %>
 * @classdesc The <% elementType %> vector representation. Wraps a C++ array.
 * @class
-* @param {(Array.<<% elementType %>> | module:la.<% className %>)} [arg] - Constructor arguments. There are two ways of constructing:
+* @param {(Array.<<% elementType %>> | module:la.<% className %> | Float64Array)} [arg] - Constructor arguments. There are three ways of constructing:
 * <br>1. using an array of vector elements. Example: using `<% example1 %>` creates a vector of length 3,
-* <br>2. using a vector (copy constructor).
+* <br>2. using a vector (copy constructor),
+* <br>3. using a `Float64Array`<% float64ArrayCons %>.
 * @example
 * var la = require('qminer').la;
 * // create a new empty vector
@@ -647,6 +648,25 @@ private:
     //# <% skipToMat %>exports.Vector.prototype.toMat = function () { return Object.create(require('qminer').la.Matrix.prototype); }
     JsDeclareSpecializedFunction(toMat);
 
+    /**
+    * Returns a `Float64Array` view of the vector's values, without copying them. Writes through
+    * the view change the vector and vice versa. The view stays valid also after the vector is
+    * garbage collected. Once the vector changes its length (e.g. with `push` or `trunc`), it gets
+    * its own copy of values and the view no longer reflects its changes. A vector constructed
+    * from a `Float64Array` shares its values with that array in the same way.
+    * @returns {Float64Array} The view of the vector's values.
+    * @example
+    * var la = require('qminer').la;
+    * // create a new vector
+    * var vec = new la.Vector([4, 5, -1]);
+    * // get the view of the vector's values
+    * var arr = vec.asFloat64Array();
+    * // changes are visible in the vector
+    * arr[0] = 3; // vec[0] is now 3
+    */
+    //# <% skipFloat64Array %>exports.Vector.prototype.asFloat64Array = function () { return new Float64Array(0); }
+    JsDeclareSpecializedFunction(asFloat64Array);
+
     /**
     * Saves the vector as output stream (binary serialization).
     * @param {module:fs.FOut} fout - Output stream.
@@ -722,6 +742,13 @@ private:
 public:
     TVec<TVal> Vec;
 private:
+    // array buffer sharing values of Vec, see asFloat64Array
+    TNodeJsFltBuf SharedBuf;
+    // fills Vec with values of the typed array
+    void SetFloat64Array(const v8::Local<v8::Float64Array>& Array);
+    // called before Vec changes its length
+    void ReleaseShared() { SharedBuf.Release(Vec); }
+
     static v8::Persistent<v8::Function> Constructor;
 };
 
@@ -800,6 +827,7 @@ void TNodeJsVec<TVal, TAux>::Init(v8::Local<v8::Object> exports) {
     NODE_SET_PROTOTYPE_METHOD(tpl, "norm", _norm);
     NODE_SET_PROTOTYPE_METHOD(tpl, "sparse", _sparse);
     NODE_SET_PROTOTYPE_METHOD(tpl, "toMat", _toMat);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "asFloat64Array", _asFloat64Array);
     NODE_SET_PROTOTYPE_METHOD(tpl, "save", _save);
     NODE_SET_PROTOTYPE_METHOD(tpl, "load", _load);
     NODE_SET_PROTOTYPE_METHOD(tpl, "saveascii", _saveascii);
@@ -1064,8 +1092,33 @@ inline void TNodeJsVec<TFlt, TAuxFltV>::toMat(const v8::FunctionCallbackInfo<v8:
     Args.GetReturnValue().Set(TNodeJsFltVV::New(Res));
 }
 
+template<>
+inline void TNodeJsVec<TFlt, TAuxFltV>::asFloat64Array(const v8::FunctionCallbackInfo<v8::Value>& Args) {
+    v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope HandleScope(Isolate);
+
+    TNodeJsVec<TFlt, TAuxFltV>* JsVec =
+        ObjectWrap::Unwrap<TNodeJsVec<TFlt, TAuxFltV> >(Args.This());
+
+    Args.GetReturnValue().Set(JsVec->SharedBuf.GetFloat64Array(JsVec->Vec));
+}
+
 //////
 
+template <typename TVal, typename TAux>
+void TNodeJsVec<TVal, TAux>::SetFloat64Array(const v8::Local<v8::Float64Array>& Array) {
+    v8::Local<v8::Context> Context = v8::Isolate::GetCurrent()->GetCurrentContext();
+    const int Len = Array->Length();
+    Vec.Gen(Len, 0);
+    for (int ElN = 0; ElN < Len; ++ElN) { Vec.Add(TAux::CastVal(Context, Array->Get(ElN))); }
+}
+
+// vector of doubles adopts memory of the typed array instead of copying it
+template <>
+inline void TNodeJsVec<TFlt, TAuxFltV>::SetFloat64Array(const v8::Local<v8::Float64Array>& Array) {
+    SharedBuf.Adopt(Array, Vec);
+}
+
 template <typename TVal, typename TAux>
 void TNodeJsVec<TVal, TAux>::New(const v8::FunctionCallbackInfo<v8::Value>& Args) {
     v8::Isolate* Isolate = v8::Isolate::GetCurrent();
@@ -1080,8 +1133,12 @@ void TNodeJsVec<TVal, TAux>::New(const v8::FunctionCallbackInfo<v8::Value>& Args
         v8::Local<v8::String> Value = v8::String::NewFromUtf8(Isolate, TAux::ClassId.CStr());
         v8::Local<v8::Object> Instance = Args.This();
 
+        // If we got Float64Array on the input: vector.new(new Float64Array([1,2,3]))
+        if (Args[0]->IsFloat64Array()) {
+            JsVec->SetFloat64Array(v8::Local<v8::Float64Array>::Cast(Args[0]));
+        }
         // If we got Javascript array on the input: vector.new([1,2,3]) 
-        if (Args[0]->IsArray()) {
+        else if (Args[0]->IsArray()) {
             //printf("vector construct call, class = %s, input array\n", TAux::ClassId.CStr());
             v8::Local<v8::Array> Arr = v8::Local<v8::Array>::Cast(Args[0]);
             const int Len = Arr->Length();
@@ -1286,7 +1343,7 @@ void TNodeJsVec<TVal, TAux>::push(const v8::FunctionCallbackInfo<v8::Value>& Arg
             v8::String::NewFromUtf8(Isolate, "Expected number, string or boolean")));
     }
     else {
-        
+        JsVec->ReleaseShared();
         JsVec->Vec.Add(TAux::CastVal(Context, Args[0]));
         Args.GetReturnValue().Set(v8::Number::New(Isolate, JsVec->Vec.Len()));
     }
@@ -1314,6 +1371,8 @@ void TNodeJsVec<TVal, TAux>::splice(const v8::FunctionCallbackInfo<v8::Value>& A
     const int InsCount = Args.Length() - 2;
 
     EAssert(StartIdx + DelCount <= Vec.Len());
+    // shared values cannot change length
+    if (DelCount != InsCount) { JsVec->ReleaseShared(); }
 
     const int NOverride = TMath::Mn(DelCount, InsCount);
     const int NDel = TMath::Mx(DelCount - InsCount, 0);
@@ -1358,6 +1417,7 @@ void TNodeJsVec<TVal, TAux>::unshift(const v8::FunctionCallbackInfo<v8::Value>&
         Temp[ArgN] = TAux::CastVal(Context, Args[ArgN]);
     }
     Temp.AddV(JsVec->Vec);
+    JsVec->ReleaseShared();
     JsVec->Vec = Temp;
     Args.GetReturnValue().Set(v8::Number::New(Isolate, JsVec->Vec.Len()));
 }
@@ -1373,6 +1433,7 @@ void TNodeJsVec<TVal, TAux>::pushV(const v8::FunctionCallbackInfo<v8::Value>& Ar
     TNodeJsVec<TVal, TAux>* JsVec = ObjectWrap::Unwrap<TNodeJsVec<TVal, TAux> >(Args.Holder());
     TNodeJsVec<TVal, TAux>* OthVec = ObjectWrap::Unwrap<TNodeJsVec<TVal, TAux> >(Args[0]->ToObject());
 
+    JsVec->ReleaseShared();
     JsVec->Vec.AddV(OthVec->Vec);
 
     Args.GetReturnValue().Set(v8::Number::New(Isolate, JsVec->Vec.Len()));
@@ -1425,6 +1486,7 @@ void TNodeJsVec<TVal, TAux>::trunc(const v8::FunctionCallbackInfo<v8::Value>& Ar
     TNodeJsVec<TVal, TAux>* JsVec =
         ObjectWrap::Unwrap<TNodeJsVec<TVal, TAux> >(Args.Holder());
     const int NewLen = Args[0]->Int32Value();
+    JsVec->ReleaseShared();
     JsVec->Vec.Trunc(NewLen);
 
     Args.GetReturnValue().Set(Args.Holder());
@@ -1509,6 +1571,7 @@ void TNodeJsVec<TVal, TAux>::load(const v8::FunctionCallbackInfo<v8::Value>& Arg
     TNodeJsFIn* JsFIn = ObjectWrap::Unwrap<TNodeJsFIn>(Args[0]->ToObject());
     PSIn SIn = JsFIn->SIn;
     JsVec->Vec.Load(*SIn);
+    JsVec->SharedBuf.Reset();
 
     Args.GetReturnValue().Set(v8::Undefined(Isolate));
 }
@@ -1564,6 +1627,7 @@ void TNodeJsVec<TVal, TAux>::loadascii(const v8::FunctionCallbackInfo<v8::Value>
     TNodeJsFIn* JsFIn = ObjectWrap::Unwrap<TNodeJsFIn>(Args[0]->ToObject());
     PSIn SIn = JsFIn->SIn;
     TStr Line;
+    JsVec->ReleaseShared();
     while (SIn->GetNextLn(Line)) {
         JsVec->Vec.Add(TAux::Parse(Line));
     }
@@ -1101,10 +1101,8 @@ void TNodeJsAsyncUtil::ExecuteOnMain(TMainThreadTask* Task, uv_async_t* UvAsync,
     TAsyncHandleType HandleType = GetHandleType(UvAsync);
     switch (HandleType) {
     case ahtAsync: {
-        if (!DelTask) {
-            delete Task;
-            EAssertR(false, "Non-blocking tasks must be automatically deleted!");
-        }
+        // the task belongs to the caller, so it is not ours to delete
+        EAssertR(DelTask, "Non-blocking tasks must be automatically deleted!");
         SetAsyncData(UvAsync, new TMainTaskWrapper(Task, DelTask));
         // uv_async_send is thread safe
         uv_async_send(UvAsync);
@@ -1112,14 +1110,16 @@ void TNodeJsAsyncUtil::ExecuteOnMain(TMainThreadTask* Task, uv_async_t* UvAsync,
     }
     case ahtBlocking: {
         TMainBlockTaskWrapper* TaskWrapper = new TMainBlockTaskWrapper(Task, DelTask);
-        SetAsyncData(UvAsync, TaskWrapper);
-        // initialize the semaphore
+        // initialize the semaphore before the wrapper is handed over
         int Err = uv_sem_init(&TaskWrapper->Semaphore, 0);
 
         if (Err != 0) { // check if we succeeded initializing the semaphore
-            delete Task;
+            // the wrapper only deletes the task when we own it (DelTask),
+            // blocking tasks are often allocated on the caller's stack
+            delete TaskWrapper;
             throw TExcept::New("Failed to create a semaphore, code: " + TInt::GetStr(Err) + "!");
         } else {
+            SetAsyncData(UvAsync, TaskWrapper);
             // uv_async_send is thread safe
             uv_async_send(UvAsync);
             uv_sem_wait(&TaskWrapper->Semaphore);
@@ -368,9 +368,14 @@ void TNodeJsBase::Init(v8::Local<v8::Object> exports) {
     NODE_SET_PROTOTYPE_METHOD(tpl, "createJsStore", _createJsStore);
     NODE_SET_PROTOTYPE_METHOD(tpl, "addJsStoreCallback", _addJsStoreCallback);
     NODE_SET_PROTOTYPE_METHOD(tpl, "search", _search);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "searchAsync", _searchAsync);
     NODE_SET_PROTOTYPE_METHOD(tpl, "garbageCollect", _garbageCollect);
     NODE_SET_PROTOTYPE_METHOD(tpl, "partialFlush", _partialFlush);
     NODE_SET_PROTOTYPE_METHOD(tpl, "getStats", _getStats);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "setQueryCache", _setQueryCache);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "getQueryCacheStats", _getQueryCacheStats);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "setQueryThreads", _setQueryThreads);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "explain", _explain);
     NODE_SET_PROTOTYPE_METHOD(tpl, "getStreamAggr", _getStreamAggr);
     NODE_SET_PROTOTYPE_METHOD(tpl, "getStreamAggrNames", _getStreamAggrNames);
     NODE_SET_PROTOTYPE_METHOD(tpl, "getStreamAggrStats", _getStreamAggrStats);
@@ -385,8 +390,8 @@ void TNodeJsBase::Init(v8::Local<v8::Object> exports) {
 }
 
 TNodeJsBase::TNodeJsBase(const TStr& DbFPath_, const TStr& SchemaFNm, const PJsonVal& Schema,
-        const bool& Create, const bool& ForceCreate, const bool& RdOnlyP, const bool& StrictNmP,
-        const uint64& IndexCacheSize, const uint64& StoreCacheSize) {
+        const bool& Create, const bool& ForceCreate, const bool& RdOnlyP, const bool& RestoreP,
+        const bool& StrictNmP, const uint64& IndexCacheSize, const uint64& StoreCacheSize) {
 
     Watcher = TNodeJsBaseWatcher::New();
 
@@ -473,7 +478,7 @@ TNodeJsBase::TNodeJsBase(const TStr& DbFPath_, const TStr& SchemaFNm, const PJso
         // load database and start the server
         {
             // resolve access type
-            TFAccess FAccess = RdOnlyP ? faRdOnly : faUpdate;
+            TFAccess FAccess = RdOnlyP ? faRdOnly : (RestoreP ? faRestore : faUpdate);
             // load base
             Base = TQm::TStorage::LoadBase(DbFPath, FAccess, IndexCacheSize, StoreCacheSize);
             // once the base is open we need to setup the custom record templates for each store
@@ -497,10 +502,11 @@ TNodeJsBase* TNodeJsBase::NewFromArgs(const v8::FunctionCallbackInfo<v8::Value>&
     PJsonVal Val = TNodeJsUtil::GetArgJson(Args, 0);
 
     TStr DbPath = Val->GetObjStr("dbPath", "./db/");
-    // mode: create, createClean, open, openReadOnly
+    // mode: create, createClean, open, openReadOnly, restore
     TStr Mode = Val->GetObjStr("mode", "openReadOnly");
 
-    EAssertR(Mode == "create" || Mode == "createClean" || Mode == "openReadOnly" || Mode == "open", "Base.create: Unrecognized mode " + Mode);
+    EAssertR(Mode == "create" || Mode == "createClean" || Mode == "openReadOnly" || Mode == "open" ||
+        Mode == "restore", "Base.create: Unrecognized mode " + Mode);
     const bool StrictNmP = Val->GetObjBool("strictNames", true);
 
     TStr SchemaFNm = Val->GetObjStr("schemaPath", "");
@@ -512,6 +518,7 @@ TNodeJsBase* TNodeJsBase::NewFromArgs(const v8::FunctionCallbackInfo<v8::Value>&
     bool Create = ((Mode == "create") || (Mode == "createClean"));
     bool ForceCreate = (Mode == "createClean");
     bool ReadOnly = (Mode == "openReadOnly");
+    bool Restore = (Mode == "restore");
     uint64 IndexCache = (uint64)Val->GetObjInt("indexCache", 1024) * (uint64)TInt::Mega;
     uint64 StoreCache = (uint64)Val->GetObjInt("storeCache", 1024) * (uint64)TInt::Mega;
 
@@ -519,7 +526,7 @@ TNodeJsBase* TNodeJsBase::NewFromArgs(const v8::FunctionCallbackInfo<v8::Value>&
     TStr StopWordsPath = Val->GetObjStr("stopwords", TQm::TEnv::QMinerFPath + "resources/stopwords/");
     TSwSet::LoadSwDir(StopWordsPath);
 
-    return new TNodeJsBase(DbPath, SchemaFNm, Schema, Create, ForceCreate, ReadOnly, StrictNmP, IndexCache, StoreCache);
+    return new TNodeJsBase(DbPath, SchemaFNm, Schema, Create, ForceCreate, ReadOnly, Restore, StrictNmP, IndexCache, StoreCache);
 }
 
 void TNodeJsBase::close(const v8::FunctionCallbackInfo<v8::Value>& Args) {
@@ -719,6 +726,34 @@ void TNodeJsBase::search(const v8::FunctionCallbackInfo<v8::Value>& Args) {
     Args.GetReturnValue().Set(TNodeJsUtil::NewInstance<TNodeJsRecSet>(new TNodeJsRecSet(RecSet, JsBase->Watcher)));
 }
 
+TNodeJsBase::TSearchTask::TSearchTask(const v8::FunctionCallbackInfo<v8::Value>& Args, const bool& IsAsync):
+        TNodeTask(Args, IsAsync) {
+    v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope HandleScope(Isolate);
+
+    QmAssertR(Args.Length() == 2, "searchAsync: should have 2 arguments!");
+    JsBase = TNodeJsUtil::UnwrapCheckWatcher<TNodeJsBase>(Args.Holder());
+    // the main thread can not change the base while workers are reading it
+    QmAssertR(JsBase->Base->IsRdOnly(), "searchAsync: base must be opened in read-only mode!");
+    QueryVal = TNodeJsUtil::GetArgJson(Args, 0);
+}
+
+v8::Local<v8::Function> TNodeJsBase::TSearchTask::GetCallback(const v8::FunctionCallbackInfo<v8::Value>& Args) {
+    return TNodeJsUtil::GetArgFun(Args, 1);
+}
+
+void TNodeJsBase::TSearchTask::Run() {
+    try {
+        RecSet = JsBase->Base->Search(QueryVal);
+    } catch (const PExcept& _Except) {
+        SetExcept(_Except);
+    }
+}
+
+v8::Local<v8::Value> TNodeJsBase::TSearchTask::WrapResult() {
+    return TNodeJsUtil::NewInstance<TNodeJsRecSet>(new TNodeJsRecSet(RecSet, JsBase->Watcher));
+}
+
 void TNodeJsBase::garbageCollect(const v8::FunctionCallbackInfo<v8::Value>& Args) {
     v8::Isolate* Isolate = v8::Isolate::GetCurrent();
     v8::HandleScope HandleScope(Isolate);
@@ -758,6 +793,55 @@ void TNodeJsBase::getStats(const v8::FunctionCallbackInfo<v8::Value>& Args) {
     Args.GetReturnValue().Set(TNodeJsUtil::ParseJson(Isolate, res));
 }
 
+void TNodeJsBase::setQueryCache(const v8::FunctionCallbackInfo<v8::Value>& Args) {
+    v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope HandleScope(Isolate);
+    // unwrap
+    TNodeJsBase* JsBase = TNodeJsUtil::UnwrapCheckWatcher<TNodeJsBase>(Args.Holder());
+    TWPt<TQm::TBase> Base = JsBase->Base;
+
+    const double MxMemUsed = TNodeJsUtil::GetArgFlt(Args, 0);
+    Base->SetQueryCache((int64)MxMemUsed);
+
+    Args.GetReturnValue().Set(Args.Holder());
+}
+
+void TNodeJsBase::getQueryCacheStats(const v8::FunctionCallbackInfo<v8::Value>& Args) {
+    v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope HandleScope(Isolate);
+    // unwrap
+    TNodeJsBase* JsBase = TNodeJsUtil::UnwrapCheckWatcher<TNodeJsBase>(Args.Holder());
+    TWPt<TQm::TBase> Base = JsBase->Base;
+
+    PJsonVal res = Base->GetQueryCacheStats();
+    Args.GetReturnValue().Set(TNodeJsUtil::ParseJson(Isolate, res));
+}
+
+void TNodeJsBase::setQueryThreads(const v8::FunctionCallbackInfo<v8::Value>& Args) {
+    v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope HandleScope(Isolate);
+    // unwrap
+    TNodeJsBase* JsBase = TNodeJsUtil::UnwrapCheckWatcher<TNodeJsBase>(Args.Holder());
+    TWPt<TQm::TBase> Base = JsBase->Base;
+
+    const int Threads = TNodeJsUtil::GetArgInt32(Args, 0);
+    Base->SetQueryThreads(Threads);
+
+    Args.GetReturnValue().Set(Args.Holder());
+}
+
+void TNodeJsBase::explain(const v8::FunctionCallbackInfo<v8::Value>& Args) {
+    v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope HandleScope(Isolate);
+    // unwrap
+    TNodeJsBase* JsBase = TNodeJsUtil::UnwrapCheckWatcher<TNodeJsBase>(Args.Holder());
+    TWPt<TQm::TBase> Base = JsBase->Base;
+
+    PJsonVal QueryVal = TNodeJsUtil::GetArgJson(Args, 0);
+    PJsonVal ExplainVal = Base->Explain(TQm::TQuery::New(Base, QueryVal));
+    Args.GetReturnValue().Set(TNodeJsUtil::ParseJson(Isolate, ExplainVal));
+}
+
 void TNodeJsBase::getStreamAggr(const v8::FunctionCallbackInfo<v8::Value>& Args) {
     v8::Isolate* Isolate = v8::Isolate::GetCurrent();
     v8::HandleScope HandleScope(Isolate);
@@ -814,6 +898,10 @@ void TNodeJsStore::Init(v8::Local<v8::Object> exports) {
     NODE_SET_PROTOTYPE_METHOD(tpl, "each", _each);
     NODE_SET_PROTOTYPE_METHOD(tpl, "map", _map);
     NODE_SET_PROTOTYPE_METHOD(tpl, "push", _push);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "pushBatch", _pushBatch);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "setIndexingDeferred", _setIndexingDeferred);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "load", _load);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "loadAsync", _loadAsync);
     NODE_SET_PROTOTYPE_METHOD(tpl, "newRecord", _newRecord);
     NODE_SET_PROTOTYPE_METHOD(tpl, "newRecordSet", _newRecordSet);
     NODE_SET_PROTOTYPE_METHOD(tpl, "sample", _sample);
@@ -824,6 +912,7 @@ void TNodeJsStore::Init(v8::Local<v8::Object> exports) {
     NODE_SET_PROTOTYPE_METHOD(tpl, "key", _key);
     NODE_SET_PROTOTYPE_METHOD(tpl, "resetStreamAggregates", _resetStreamAggregates);
     NODE_SET_PROTOTYPE_METHOD(tpl, "getStreamAggrNames", _getStreamAggrNames);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "setParallelStreamAggregates", _setParallelStreamAggregates);
     NODE_SET_PROTOTYPE_METHOD(tpl, "toJSON", _toJSON);
     NODE_SET_PROTOTYPE_METHOD(tpl, "clear", _clear);
     NODE_SET_PROTOTYPE_METHOD(tpl, "getVector", _getVector);
@@ -1102,6 +1191,136 @@ void TNodeJsStore::push(const v8::FunctionCallbackInfo<v8::Value>& Args) {
     }
 }
 
+void TNodeJsStore::pushBatch(const v8::FunctionCallbackInfo<v8::Value>& Args) {
+    v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope HandleScope(Isolate);
+
+    try {
+        TNodeJsStore* JsStore = TNodeJsUtil::UnwrapCheckWatcher<TNodeJsStore>(Args.Holder());
+        TWPt<TQm::TStore> Store = JsStore->Store;
+        TWPt<TQm::TBase> Base = JsStore->Store->GetBase();
+
+        // check we can write
+        QmAssertR(!Base->IsRdOnly(), "Base opened as read-only");
+
+        const PJsonVal RecArrVal = TNodeJsUtil::GetArgJson(Args, 0);
+        QmAssertR(RecArrVal->IsArr(), "Store.pushBatch: expecting array of records");
+        const bool TriggerEvents = TNodeJsUtil::GetArgBool(Args, 1, true);
+
+        TVec<PJsonVal> RecValV(RecArrVal->GetArrVals(), 0);
+        for (int RecN = 0; RecN < RecArrVal->GetArrVals(); RecN++) {
+            RecValV.Add(RecArrVal->GetArrVal(RecN));
+        }
+        TUInt64V RecIdV; Store->AddRecs(RecValV, RecIdV, TriggerEvents);
+
+        v8::Local<v8::Array> RecIdArr = v8::Array::New(Isolate, RecIdV.Len());
+        for (int RecN = 0; RecN < RecIdV.Len(); RecN++) {
+            RecIdArr->Set(RecN, v8::Integer::NewFromUnsigned(Isolate, (uint32_t)RecIdV[RecN]));
+        }
+        Args.GetReturnValue().Set(RecIdArr);
+    }
+    catch (const PExcept& Except) {
+        throw TQm::TQmExcept::New("[except] " + Except->GetMsgStr());
+    }
+}
+
+void TNodeJsStore::setIndexingDeferred(const v8::FunctionCallbackInfo<v8::Value>& Args) {
+    v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope HandleScope(Isolate);
+
+    try {
+        TNodeJsStore* JsStore = TNodeJsUtil::UnwrapCheckWatcher<TNodeJsStore>(Args.Holder());
+        TWPt<TQm::TStore> Store = JsStore->Store;
+        TWPt<TQm::TBase> Base = JsStore->Store->GetBase();
+
+        // check we can write
+        QmAssertR(!Base->IsRdOnly(), "Base opened as read-only");
+
+        const bool DeferredP = TNodeJsUtil::GetArgBool(Args, 0);
+        Store->SetIndexingDeferred(DeferredP);
+        Args.GetReturnValue().Set(Args.Holder());
+    }
+    catch (const PExcept& Except) {
+        throw TQm::TQmExcept::New("[except] " + Except->GetMsgStr());
+    }
+}
+
+void TNodeJsStore::TAddBatchTask::Run() {
+    v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope HandleScope(Isolate);
+
+    try {
+        Watcher->AssertOpen();
+        Loader->AddBatch(RecValV);
+        if (!OnProgress->IsEmpty()) {
+            v8::Local<v8::Function> Callback = v8::Local<v8::Function>::New(Isolate, *OnProgress);
+            TNodeJsUtil::ExecuteVoid(Callback,
+                v8::Number::New(Isolate, (double)Loader->GetRecs()),
+                v8::Number::New(Isolate, (double)Loader->GetBytes()));
+        }
+    } catch (const PExcept& _Except) {
+        Except = _Except;
+    }
+}
+
+TNodeJsStore::TLoadTask::TLoadTask(const v8::FunctionCallbackInfo<v8::Value>& Args, const bool& IsAsync):
+        TNodeTask(Args, IsAsync),
+        Loader(nullptr),
+        AddBatchHandle(nullptr) {
+
+    v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope HandleScope(Isolate);
+
+    TNodeJsStore* JsStore = TNodeJsUtil::UnwrapCheckWatcher<TNodeJsStore>(Args.Holder());
+    Watcher = JsStore->Watcher;
+    // check we can write
+    QmAssertR(!JsStore->Store->GetBase()->IsRdOnly(), "Base opened as read-only");
+
+    QmAssertR(Args.Length() > 0 && Args[0]->IsObject(), "Store.load: expecting options object");
+    v8::Local<v8::Object> OptsObj = Args[0]->ToObject();
+    if (TNodeJsUtil::IsFldFun(OptsObj, "onProgress")) {
+        OnProgress.Reset(Isolate, TNodeJsUtil::GetFldFun(OptsObj, "onProgress"));
+    }
+    PJsonVal ParamVal = TNodeJsUtil::GetArgJson(Args, 0, true);
+    QmAssertR(ParamVal->IsObjKey("file"), "Store.load: missing parameter file");
+    Loader = new TQm::TStoreLoader(JsStore->Store, ParamVal->GetObjStr("file"), ParamVal);
+
+    if (IsAsync) { AddBatchHandle = TNodeJsAsyncUtil::NewBlockingHandle(); }
+}
+
+TNodeJsStore::TLoadTask::~TLoadTask() {
+    OnProgress.Reset();
+    if (AddBatchHandle != nullptr) { TNodeJsAsyncUtil::DelHandle(AddBatchHandle); }
+    delete Loader;
+}
+
+v8::Local<v8::Function> TNodeJsStore::TLoadTask::GetCallback(const v8::FunctionCallbackInfo<v8::Value>& Args) {
+    return TNodeJsUtil::GetArgFun(Args, 1);
+}
+
+void TNodeJsStore::TLoadTask::Run() {
+    try {
+        TAddBatchTask AddBatchTask(Loader, Watcher, &OnProgress);
+        while (Loader->ReadBatch(AddBatchTask.RecValV)) {
+            // records are added on the main thread, which owns the base
+            if (IsAsync()) {
+                TNodeJsAsyncUtil::ExecuteOnMain(&AddBatchTask, AddBatchHandle, false);
+            } else {
+                AddBatchTask.Run();
+            }
+            if (!AddBatchTask.GetExcept().Empty()) { throw AddBatchTask.GetExcept(); }
+        }
+    } catch (const PExcept& Except) {
+        SetExcept(Except);
+    }
+}
+
+v8::Local<v8::Value> TNodeJsStore::TLoadTask::WrapResult() {
+    v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+    v8::EscapableHandleScope HandleScope(Isolate);
+    return HandleScope.Escape(v8::Number::New(Isolate, (double)Loader->GetRecs()));
+}
+
 void TNodeJsStore::newRecord(const v8::FunctionCallbackInfo<v8::Value>& Args) {
     v8::Isolate* Isolate = v8::Isolate::GetCurrent();
     v8::HandleScope HandleScope(Isolate);
@@ -1299,6 +1518,18 @@ void TNodeJsStore::resetStreamAggregates(const v8::FunctionCallbackInfo<v8::Valu
     Base->GetStreamAggrSet(Store->GetStoreId())->Reset();
 }
 
+void TNodeJsStore::setParallelStreamAggregates(const v8::FunctionCallbackInfo<v8::Value>& Args) {
+    v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope HandleScope(Isolate);
+
+    TNodeJsStore* JsStore = TNodeJsUtil::UnwrapCheckWatcher<TNodeJsStore>(Args.Holder());
+    TWPt<TQm::TStore>& Store = JsStore->Store;
+    const TWPt<TQm::TBase>& Base = JsStore->Store->GetBase();
+
+    const bool ParallelP = TNodeJsUtil::GetArgBool(Args, 0);
+    Base->GetStreamAggrSet(Store->GetStoreId())->SetParallel(ParallelP);
+}
+
 void TNodeJsStore::getStreamAggrNames(const v8::FunctionCallbackInfo<v8::Value>& Args) {
     v8::Isolate* Isolate = v8::Isolate::GetCurrent();
     v8::HandleScope HandleScope(Isolate);
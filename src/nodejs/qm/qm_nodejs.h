@@ -139,6 +139,7 @@ private:
 * <br>2. `'createClean'` - Cleans db folder and then sets it up,
 * <br>3. `'open'` - Opens the db with read/write permissions,
 * <br>4. `'openReadOnly'` - Opens the db in read only mode.
+* <br>5. `'restore'` - Opens the db after it was not closed, for example after a crash. Stores with `write_log` option get back the changes from their log and can be updated, the rest is as it was when the db was last closed.
 * @property  {number} [indexCache=1024] - The ammount of memory reserved for indexing (in MB).
 * @property  {number} [storeCache=1024] - The ammount of memory reserved for store cache (in MB).
 * @property  {string} [schemaPath=''] - The path to schema definition file.
@@ -190,6 +191,7 @@ private:
 * @property {string} [store='memory'] - Defines where to store the field. Possible options
 * <br>1. `'memory'` - Stores the values in RAM.
 * <br>2 `'cache'` - Stores the values on disk, with a layer of FIFO cache in RAM, storing the most recently used values.
+* <br>3 `'column'` - Stores the values in RAM in a separate array for each field. Faster filtering, sorting and feature extraction over the field. Only for non-primary, non-indexed fields of types `byte`, `bool`, `int`, `int64`, `uint64`, `float`, `sfloat` and `datetime`.
 * @property {Object} [default] - Default value for field when not given for a new record.
 * @property {boolean} [codebook=false] - Useful when many records have only few different values of this field. If set to true, then a separate table of all values is kept, and records only point to this table (replacing variable string field in record serialisation with fixed-length integer). Useful to decrease memory footprint, and faster to update. (STRING FIELD TYPE SPECIFIC).
 * @property {boolean} [shortstring=false] - Useful for string shorter then 127 characters (STRING FIELD TYPE SPECIFIC).
@@ -292,6 +294,11 @@ private:
 *  The key type supports `'string'`, `'string_v'` and `'datetime'` fields types.
 * <br>2. `'text'` - Indexes string fields by using a tokenizer and text processing. Supported by `'string'` fields.
 * <br>3. `'location'`- Indexes records as points on a sphere and enables nearest-neighbour queries. Supported by `'float_pair'` type fields.
+* <br>4. `'linear'` - Indexes numeric and `'datetime'` fields in a b-tree and enables range queries.
+* @property {string} [storage='full'] - Storage of the index. Value and text keys support `'full'`, `'small'`, `'tiny'` and `'packed'` inverted index.
+*  Linear keys keep the b-tree in memory by default, or on disk with only recently used nodes cached in memory when set to `'paged'`.
+*  Location keys set to `'paged'` index the cell ids of locations in such a b-tree instead of loading the whole index into memory.
+*  Location keys support `$location` queries with `$radius` and `$limit`, and `$box: [[minLat, minLon], [maxLat, maxLon]]` and `$polygon: [[lat, lon], ...]` area queries.
 * @property {string} [name] - Allows using a different name for the key in search queries. This allows for multiple keys to be put against the same field. Default value is the name of the field.
 * @property {string} [vocabulary] - Defines the name of the vocabulary used to store the tokens or values. This can be used indicate to several keys to use the same vocabulary, to save on memory. Supported by `'value'` and `'text'` keys.
 * @property {string} [tokenize] - Defines the tokenizer that is used for tokenizing the values stored in indexed fields. Tokenizer uses same parameters as in bag-of-words feature extractor. Default is english stopword list and no stemmer. Supported by `'text'` keys.
@@ -331,6 +338,8 @@ private:
 * @property {number} duration - The size of the time window (in number of units).
 * @property {string} unit - Defines in which units the window size is specified. Possible options are `'second'`, `'minute'`, `'hour'`, `'day'`, `'week'` or `'month'`.
 * @property {string} [field] - Name of the datetime field, which defines the time of the record. In case it is not given, the insert time is used in its place.
+* @property {Object} [segment] - Partitions records into time segments of given `duration` and `unit` (defaults to window unit), e.g. `{ duration: 1, unit: 'hour' }`.
+* Segments keep time range of their records, so garbage collector expires whole segments and time filters skip segments without reading their records.
 * @example <caption>Define window by number of records</caption>
 * var qm = require('qminer');
 * // create base
@@ -442,12 +451,27 @@ public:
     TNodeJsBase(const TWPt<TQm::TBase>& Base_) : Base(Base_) { Watcher = TNodeJsBaseWatcher::New(); }
     TNodeJsBase(const TStr& DbPath, const TStr& SchemaFNm, const PJsonVal& Schema,
         const bool& Create, const bool& ForceCreate, const bool& ReadOnly,
-        const bool& UseStrictFldNames, const uint64& IndexCache, const uint64& StoreCache);
+        const bool& Restore, const bool& UseStrictFldNames, const uint64& IndexCache, const uint64& StoreCache);
     // Object that knows if Base is valid
     PNodeJsBaseWatcher Watcher;
 private:
     // parses arguments, called by javascript constructor
     static TNodeJsBase* NewFromArgs(const v8::FunctionCallbackInfo<v8::Value>& Args);
+
+    class TSearchTask: public TNodeTask {
+    private:
+        TNodeJsBase* JsBase;
+        PJsonVal QueryVal;
+        TQm::PRecSet RecSet;
+
+    public:
+        TSearchTask(const v8::FunctionCallbackInfo<v8::Value>& Args, const bool& IsAsync);
+
+        v8::Local<v8::Function> GetCallback(const v8::FunctionCallbackInfo<v8::Value>& Args);
+        void Run();
+        v8::Local<v8::Value> WrapResult();
+    };
+
 private:
     /**
     * Closes the database.
@@ -661,6 +685,15 @@ private:
 
     JsDeclareFunction(search);
 
+    /**
+    * Executes the query on a worker thread and passes the resulting record set to the callback.
+    * Several queries can run at the same time. Only available when base is opened in `'openReadOnly'` mode.
+    * @param {module:qm~QueryObject} query - Query language JSON object.
+    * @param {function} callback - Called with `(err, recSet)` when the query finishes.
+    */
+    //# exports.Base.prototype.searchAsync = function (query, callback) { }
+    JsDeclareAsyncFunction(searchAsync, TSearchTask);
+
     /**
     * Calls qminer garbage collector to remove records outside time windows. For application example see {@link module:qm~SchemaTimeWindowDef}.
     * @param {number} [max_time=-1] - Maximal number of time each store can spend on cleaning backlog in milisecons. If -1 then no limit is applied.
@@ -776,6 +809,122 @@ private:
     //# exports.Base.prototype.getStats = function () { }
     JsDeclareFunction(getStats);
 
+    /**
+    * @typedef {object} QueryCacheStat
+    * The query cache statistics that are returned by {@link module:qm.Base#getQueryCacheStats}.
+    * @property {number} hits - Number of query items answered from the cache.
+    * @property {number} misses - Number of query items which had to be executed.
+    * @property {number} items - Number of cached results.
+    * @property {number} memUsed - Memory used by cached results in bytes.
+    * @property {number} maxMemUsed - Maximal memory the cache can use in bytes.
+    */
+
+    /**
+    * Enables caching of query results. Results of query items (keys, ranges, joins, and/or
+    * combinations) are kept in a least-recently-used cache and reused by later searches until
+    * one of the stores they depend on changes.
+    * @param {number} size - Maximal memory used by the cache in bytes. Zero disables the cache.
+    * @returns {module:qm.Base} Self.
+    * @example
+    * // import qm module
+    * var qm = require('qminer');
+    * // create a base with a store
+    * var base = new qm.Base({
+    *    mode: "createClean",
+    *    schema: [{
+    *        name: "People",
+    *        fields: [{ name: "Name", type: "string" }, { name: "Gender", type: "string" }],
+    *        keys: [{ field: "Gender", type: "value" }]
+    *    }]
+    * });
+    * base.store("People").push({ Name: "Carolina Fortuna", Gender: "Female" });
+    * // use at most 64MB for cached results
+    * base.setQueryCache(64 * 1024 * 1024);
+    * // the second search is answered from the cache
+    * base.search({ $from: "People", Gender: "Female" });
+    * base.search({ $from: "People", Gender: "Female" });
+    * var stats = base.getQueryCacheStats(); // stats.hits === 1
+    * base.close();
+    */
+    //# exports.Base.prototype.setQueryCache = function (size) { return Object.create(require('qminer').Base.prototype); }
+    JsDeclareFunction(setQueryCache);
+
+    /**
+    * Retrieves query cache statistics, useful for sizing the cache.
+    * @returns {module:qm~QueryCacheStat} The query cache statistics.
+    * @example
+    * // import qm module
+    * var qm = require('qminer');
+    * // create a base and enable the query cache
+    * var base = new qm.Base({ mode: "createClean" });
+    * base.setQueryCache(1024 * 1024);
+    * var stats = base.getQueryCacheStats();
+    * base.close();
+    */
+    //# exports.Base.prototype.getQueryCacheStats = function () { return { hits: 0, misses: 0, items: 0, memUsed: 0, maxMemUsed: 0 }; }
+    JsDeclareFunction(getQueryCacheStats);
+
+    /**
+    * Sets the default number of threads used to evaluate a search. Independent parts of
+    * a query (branches of `$or` and `$and`, joins over many records) are evaluated in parallel.
+    * A single query can override it with the `$parallel` parameter. Queries reading from
+    * stores implemented in JavaScript are always evaluated on one thread. Feature spaces use
+    * the same number of threads to update and extract features from larger record sets,
+    * unless they contain feature extractors implemented in JavaScript.
+    * @param {number} threads - Number of threads, must be positive. Default is 1.
+    * @returns {module:qm.Base} Self.
+    * @example
+    * // import qm module
+    * var qm = require('qminer');
+    * // create a base with a store
+    * var base = new qm.Base({
+    *    mode: "createClean",
+    *    schema: [{
+    *        name: "People",
+    *        fields: [{ name: "Name", type: "string" }, { name: "Gender", type: "string" }],
+    *        keys: [{ field: "Gender", type: "value" }]
+    *    }]
+    * });
+    * base.store("People").push({ Name: "Carolina Fortuna", Gender: "Female" });
+    * // use four threads for all searches
+    * base.setQueryThreads(4);
+    * base.search({ $or: [{ $from: "People", Gender: "Female" }, { $from: "People", Gender: "Male" }] });
+    * // or only for one search
+    * base.search({ $from: "People", Gender: "Female", $parallel: 2 });
+    * base.close();
+    */
+    //# exports.Base.prototype.setQueryThreads = function (threads) { return Object.create(require('qminer').Base.prototype); }
+    JsDeclareFunction(setQueryThreads);
+
+    /**
+    * Executes a query and describes how it was evaluated. Returns the tree of executed
+    * steps, each with the estimated and actual number of records, the strategy used
+    * (`index`, `probe`, `merge` or `cache`) and the time in milliseconds. Range conditions
+    * much wider than the records already selected are evaluated as a `probe`, by checking
+    * field values of the selected records instead of reading the index.
+    * @param {module:qm~QueryObject} query - Query language JSON object.
+    * @returns {Object} Object with properties `records` (number of results), `time`
+    * (milliseconds) and `plan` (root step of the query).
+    * @example
+    * // import qm module
+    * var qm = require('qminer');
+    * // create a base with a store
+    * var base = new qm.Base({
+    *    mode: "createClean",
+    *    schema: [{
+    *        name: "People",
+    *        fields: [{ name: "Name", type: "string" }, { name: "Gender", type: "string" }, { name: "Age", type: "int" }],
+    *        keys: [{ field: "Gender", type: "value" }, { field: "Age", type: "linear" }]
+    *    }]
+    * });
+    * base.store("People").push({ Name: "Carolina Fortuna", Gender: "Female", Age: 32 });
+    * // see which condition was evaluated first
+    * var explain = base.explain({ $from: "People", Gender: "Female", Age: { $gt: 30 } });
+    * base.close();
+    */
+    //# exports.Base.prototype.explain = function (query) { return { records: 0, time: 0, plan: {} }; }
+    JsDeclareFunction(explain);
+
     /**
     * Gets the stream aggregate of the given name.
     * @param {string} saName - The name of the stream aggregate.
@@ -971,6 +1120,40 @@ public:
     static v8::Local<v8::Value> Field(const TQm::TRec& Rec, const int FieldId);
     static v8::Local<v8::Value> Field(const TWPt<TQm::TStore>& Store, const uint64& RecId, const int FieldId);
 private:
+    /// Adds batch of parsed records to the store on the main thread
+    class TAddBatchTask : public TMainThreadTask {
+    private:
+        TQm::TStoreLoader* Loader;
+        PNodeJsBaseWatcher Watcher;
+        v8::Persistent<v8::Function>* OnProgress;
+        PExcept Except;
+    public:
+        TVec<PJsonVal> RecValV;
+
+        TAddBatchTask(TQm::TStoreLoader* _Loader, const PNodeJsBaseWatcher& _Watcher,
+            v8::Persistent<v8::Function>* _OnProgress) : Loader(_Loader), Watcher(_Watcher),
+            OnProgress(_OnProgress), Except() { }
+        void Run();
+        PExcept GetExcept() const { return Except; }
+    };
+
+    /// Loads records from file, parsing is done on a worker thread in async mode
+    class TLoadTask : public TNodeTask {
+    private:
+        TQm::TStoreLoader* Loader;
+        PNodeJsBaseWatcher Watcher;
+        v8::Persistent<v8::Function> OnProgress;
+        TMainThreadHandle* AddBatchHandle;
+
+    public:
+        TLoadTask(const v8::FunctionCallbackInfo<v8::Value>& Args, const bool& IsAsync);
+        ~TLoadTask();
+
+        v8::Local<v8::Function> GetCallback(const v8::FunctionCallbackInfo<v8::Value>& Args);
+        void Run();
+        v8::Local<v8::Value> WrapResult();
+    };
+
 
     /**
     * Returns a record from the store.
@@ -1102,6 +1285,155 @@ private:
     //# exports.Store.prototype.push = function (rec, triggerEvents) { return 0; }
     JsDeclareFunction(push);
 
+    /**
+    * Adds an array of records to the store. Records are serialized and indexed in parallel,
+    * which makes it faster than calling {@link module:qm.Store#push} for each record.
+    * @param {Array<object>} recs - The added records. Each record must be a object corresponding to store schema created at store creation using {@link module:qm~SchemaDef}.
+    * @param {boolean} [triggerEvents=true] - If true, all stream aggregate callbacks `onAdd` will be called after the records are inserted. If false, no stream aggregate will be updated.
+    * @returns {Array<number>} The IDs of the added records, in the same order as `recs`.
+    * @example
+    * // import qm module
+    * var qm = require('qminer');
+    * // create a new base containing one store
+    * var base = new qm.Base({
+    *    mode: "createClean",
+    *    schema: [{
+    *        name: "Superheroes",
+    *        fields: [
+    *            { name: "Name", type: "string" },
+    *            { name: "Superpowers", type: "string_v" }
+    *        ]
+    *    }]
+    * });
+    * // add two superheroes to the Superheroes store
+    * base.store("Superheroes").pushBatch([
+    *    { Name: "Superman", Superpowers: ["flight", "heat vision", "bulletproof"] },
+    *    { Name: "Batman", Superpowers: ["money"] }
+    * ]); // returns [0, 1]
+    * base.close();
+    */
+    //# exports.Store.prototype.pushBatch = function (recs, triggerEvents) { return [0]; }
+    JsDeclareFunction(pushBatch);
+
+    /**
+    * Defers or resumes indexing of new records. While indexing is deferred, added records are
+    * stored but not indexed, so searches do not return them. When indexing is resumed, all the
+    * records added in the meantime are indexed at once: linear (b-tree) indexes are built from
+    * sorted values and inverted index gets sorted items for each word. This is much faster than
+    * indexing records one by one when importing large amounts of data. Deferred records are also
+    * indexed when the base is closed.
+    * @param {boolean} deferred - True to defer indexing, false to index deferred records and resume indexing.
+    * @returns {module:qm.Store} Self.
+    * @example
+    * // import qm module
+    * var qm = require('qminer');
+    * // create a new base containing one store
+    * var base = new qm.Base({
+    *    mode: "createClean",
+    *    schema: [{
+    *        name: "Superheroes",
+    *        fields: [
+    *            { name: "Name", type: "string" },
+    *            { name: "Strength", type: "int" }
+    *        ],
+    *        keys: [
+    *            { field: "Name", type: "value" },
+    *            { field: "Strength", type: "linear" }
+    *        ]
+    *    }]
+    * });
+    * var store = base.store("Superheroes");
+    * // import records without indexing them one by one
+    * store.setIndexingDeferred(true);
+    * store.push({ Name: "Superman", Strength: 100 });
+    * store.push({ Name: "Batman", Strength: 20 });
+    * // index both records at once
+    * store.setIndexingDeferred(false);
+    * base.search({ $from: "Superheroes", Strength: { $gt: 50 } }); // returns record set with Superman
+    * base.close();
+    */
+    //# exports.Store.prototype.setIndexingDeferred = function (deferred) { return Object.create(require('qminer').Store.prototype); }
+    JsDeclareFunction(setIndexingDeferred);
+
+    /**
+    * @typedef {object} StoreLoadParam
+    * The parameter given to {@link module:qm.Store#load} and {@link module:qm.Store#loadAsync}.
+    * @property {string} file - The name of the input file.
+    * @property {string} [format = 'json'] - File format. Possible options:
+    * <br>1. `'json'` - Each line is a JSON object describing one record,
+    * <br>2. `'csv'` - Each line holds values of one record, separated by `delimiter`.
+    * @property {number} [limit] - Maximal number of records to load from file.
+    * @property {number} [batchSize = 10000] - Number of lines parsed and added to the store at once.
+    * @property {boolean} [triggerEvents = true] - If true, stream aggregates are updated with the loaded records.
+    * @property {string} [delimiter = ','] - CSV cell delimiter.
+    * @property {string} [quote = '"'] - CSV quote character.
+    * @property {boolean} [header = true] - Does the CSV file start with a header line.
+    * @property {Array<string>} [columns] - Field names for CSV columns, `null` skips the column.
+    * When not given, the header line provides field names and columns not in the store are skipped.
+    * @property {function} [onProgress] - Called after each batch with the number of loaded records and read bytes.
+    */
+
+    /**
+    * Loads records from a CSV or line-delimited JSON file. The file is parsed in C++ in batches,
+    * CSV values are converted to the types of the store fields.
+    * @param {module:qm~StoreLoadParam} opts - Options object.
+    * @returns {number} Number of records loaded from the file.
+    * @example
+    * // import qm module
+    * var qm = require('qminer');
+    * // create a new base containing one store
+    * var base = new qm.Base({
+    *    mode: "createClean",
+    *    schema: [{
+    *        name: "Movies",
+    *        fields: [
+    *            { name: "Title", type: "string" },
+    *            { name: "Year", type: "int" }
+    *        ]
+    *    }]
+    * });
+    * // write a CSV file and load it
+    * var fout = qm.fs.openWrite("movies.csv");
+    * fout.writeLine("Title,Year");
+    * fout.writeLine("\"Apocalypse Now\",1979");
+    * fout.close();
+    * base.store("Movies").load({ file: "movies.csv", format: "csv" }); // returns 1
+    * base.close();
+    */
+    //# exports.Store.prototype.load = function (opts) { return 0; }
+
+    /**
+    * Asynchronously loads records from a CSV or line-delimited JSON file. Records are parsed on
+    * a worker thread and added to the store in batches on the main thread. The store should not be
+    * modified until the callback is called.
+    * @param {module:qm~StoreLoadParam} opts - Options object.
+    * @param {function} callback - Called with an error or with the number of loaded records.
+    * @example
+    * // import qm module
+    * var qm = require('qminer');
+    * // create a new base containing one store
+    * var base = new qm.Base({
+    *    mode: "createClean",
+    *    schema: [{
+    *        name: "Movies",
+    *        fields: [
+    *            { name: "Title", type: "string" },
+    *            { name: "Year", type: "int" }
+    *        ]
+    *    }]
+    * });
+    * // write a JSON file and load it
+    * var fout = qm.fs.openWrite("movies.json");
+    * fout.writeLine(JSON.stringify({ Title: "Apocalypse Now", Year: 1979 }));
+    * fout.close();
+    * base.store("Movies").loadAsync({ file: "movies.json" }, function (err, recs) {
+    *     if (err) { console.log(err); }
+    *     base.close();
+    * });
+    */
+    //# exports.Store.prototype.loadAsync = function (opts, callback) {}
+    JsDeclareSyncAsync(load, loadAsync, TLoadTask);
+
     /**
     * Creates a new record of given store. The record is not added to the store.
     * @param {object} obj - An object describing the record.
@@ -1419,6 +1751,33 @@ private:
     //# exports.Store.prototype.getStreamAggrNames = function () { return [""]; }
     JsDeclareFunction(getStreamAggrNames);
 
+    /**
+    * Enables or disables parallel updates of the stream aggregates connected to the store.
+    * When enabled, aggregates which do not depend on each other (through their input aggregates)
+    * are updated on worker threads. Each update still finishes before `push` returns, and each
+    * aggregate sees the records in the order in which they were added. JavaScript aggregates and
+    * aggregates that forward records to other aggregates or stores always run on the main thread.
+    * @param {boolean} enable - True to update independent aggregates in parallel.
+    * @example
+    * // import qm module
+    * var qm = require('qminer');
+    * // create a simple base containing one store
+    * var base = new qm.Base({
+    *    mode: "createClean",
+    *    schema: [{
+    *        name: "Laser",
+    *        fields: [
+    *            { name: "Time", type: "datetime" },
+    *            { name: "WaveLength", type: "float" }
+    *        ]
+    *    }]
+    * });
+    * base.store("Laser").setParallelStreamAggregates(true);
+    * base.close();
+    */
+    //# exports.Store.prototype.setParallelStreamAggregates = function (enable) { }
+    JsDeclareFunction(setParallelStreamAggregates);
+
    /**
     * Returns the store as a JSON.
     * @returns {Object} The store as a JSON.
@@ -30,7 +30,8 @@ module.exports = exports = function (pathQmBinary) {
     */
 
     /**
-     * Loads the store from a CSV file.
+     * Loads the store from a CSV file. Field types are inferred from the first lines of the file,
+     * records are then loaded by {@link module:qm.Store#load}.
      * @param {module:qm~BaseLoadCSVParam} opts - Options object.
      * @param {function} [callback] - Callback function, called on errors and when the procedure finishes.
      */
@@ -57,38 +58,21 @@ module.exports = exports = function (pathQmBinary) {
 			var storeName = opts.store;
 
 			var fieldTypes = null;
-			var store = null;
-			var buff = [];
 
 			var ignoreFields = {};
 			for (var i = 0; i < opts.ignoreFields.length; i++)
-				ignoreFields[opts.ignoreFields] = null;
+				ignoreFields[opts.ignoreFields[i]] = null;
 
-			// read the CSV file and fill the store
+			// read the header and infer field types from the first lines
 			var headers = null;
 
-			function transformLine(line) {
-				var transformed = {};
-
-				for (var i = 0; i < line.length; i++) {
-					var header = headers[i];
-					var value = line[i];
-
-					if (fieldTypes != null && fieldTypes[header] != null) {
-						transformed[header] = fieldTypes[header] == 'float' ? parseFloat(value) : value;
-					} else {
-						transformed[header] = (isNaN(value) || value.length == 0) ? value : parseFloat(value);
-					}
-				}
-
-				return transformed;
-			}
-
-    		function initFieldTypes(data) {
+			function initFieldTypes(lineArr) {
     			if (fieldTypes == null) fieldTypes = {};
 
-    			for (var key in data) {
-    				var val = data[key];
+    			for (var i = 0; i < lineArr.length; i++) {
+    				var key = headers[i];
+    				var val = lineArr[i];
+    				if (key in ignoreFields) continue;
     				if (fieldTypes[key] == null) {
     					if (val.length == 0)
     						fieldTypes[key] = null;
@@ -96,13 +80,8 @@ module.exports = exports = function (pathQmBinary) {
     						fieldTypes[key] = 'string';
     					else
     						fieldTypes[key] = 'float';
-
     				}
     			}
-
-    			if (fieldTypesInitialized()) {
-    				// console.log('Fields initialized: ' + JSON.stringify(fieldTypes));
-                }
     		}
 
     		function fieldTypesInitialized() {
@@ -127,93 +106,74 @@ module.exports = exports = function (pathQmBinary) {
     			return result;
     		}
 
-			function createStore(rec) {
-    			try {
-	    			var storeDef = {
-	    				name: storeName,
-	    				fields: []
-	    			};
-
-	    			for (var fieldName in rec) {
-	    				storeDef.fields.push({
-							name: fieldName,
-							type: fieldTypes[fieldName],
-							"null": true,
-	    				});
-	    			}
-
-	    			// console.log('Creating store with definition ' + JSON.stringify(storeDef) + ' ...');
+			function createStore() {
+    			var storeDef = {
+    				name: storeName,
+    				fields: []
+    			};
+
+    			for (var fieldName in fieldTypes) {
+    				storeDef.fields.push({
+						name: fieldName,
+						type: fieldTypes[fieldName],
+						"null": true,
+    				});
+    			}
 
-	    			base.createStore(storeDef);
-	    			store = base.store(storeName);
+    			// console.log('Creating store with definition ' + JSON.stringify(storeDef) + ' ...');
 
-	    			// insert all the record in the buffer into the store
-	    			buff.forEach(function (data) {
-	    				store.push(data);
-	    			});
-    			} catch (e) {
-					callback(e);
-    			}
+    			base.createStore(storeDef);
+    			return base.store(storeName);
     		}
 
-			var storeCreated = false;
 			var line = 0;
-			// console.log('Saving CSV to store ' + storeName + ' ' + fname + ' ...');
-
-			var fin = new fs.FIn(fname);
-			fs.readCsvLines(fin, {
+			var inferError = null;
+			var csvOpts = {
+				delimiter: opts.delimiter,
+				quote: opts.quote,
 				onLine: function (lineArr) {
-					try {
-						if (line++ == 0) {	// the first line are the headers
-							headers = [];
-							for (var i = 0; i < lineArr.length; i++) {
-								headers.push(lineArr[i].replace(/\s+/g, '_').replace(/\.|%|\(|\)|\/|-|\+/g, '')) 	// remove invalid characters
-							}
-							// console.log('Headers initialized: ' + JSON.stringify(headers));
+					if (line++ == 0) {	// the first line are the headers
+						headers = [];
+						for (var i = 0; i < lineArr.length; i++) {
+							headers.push(lineArr[i].replace(/\s+/g, '_').replace(/\.|%|\(|\)|\/|-|\+/g, '')) 	// remove invalid characters
 						}
-						else {
-							if (line % 1000 == 0) {
-								// console.log(line + '');
-                            }
-                            
-							var data = transformLine(lineArr);
-
-							if (fieldTypes == null)
-								initFieldTypes(data);
-
-							if (store == null && fieldTypesInitialized())
-								createStore(data);
-							else if (!fieldTypesInitialized())
-								initFieldTypes(data);
-
-							if (store != null) {
-								store.push(data);
-							} else
-								buff.push(data);
-						}
-					} catch (e) {
-						// console.log('Exception while reading CSV lines: ' + e.stack);
-						callback(e);
+						// console.log('Headers initialized: ' + JSON.stringify(headers));
+					} else {
+						initFieldTypes(lineArr);
+						// stop reading once all the types are known
+						if (fieldTypesInitialized()) { csvOpts.lineLimit = 0; }
 					}
 				},
-				onEnd: function () {
-					// finished
-					// console.log('Finished!');
-
-					if (callback != null) {
-			   			if (!fieldTypesInitialized()) {
-				   			var fieldNames = getUninitializedFlds();
-				   			callback(new Error('Finished with uninitialized fields: ' +
-								JSON.stringify(fieldNames)) + ', add them to ignore list!');
-				   			return;
-				   		} else {
-				   			callback(undefined, store);
-				   		}
-			   		}
+				onEnd: function (e) {
+					if (e != null) { inferError = e; }
 				}
-			});
+			};
 
+			var fin = new fs.FIn(fname);
+			fs.readCsvLines(fin, csvOpts);
 			fin.close();
+
+			if (inferError != null) {
+				callback(inferError);
+				return;
+			}
+			if (!fieldTypesInitialized()) {
+				var fieldNames = getUninitializedFlds();
+				callback(new Error('Finished with uninitialized fields: ' +
+					JSON.stringify(fieldNames)) + ', add them to ignore list!');
+				return;
+			}
+
+			// console.log('Saving CSV to store ' + storeName + ' ' + fname + ' ...');
+			var store = createStore();
+			store.load({
+				file: fname,
+				format: 'csv',
+				delimiter: opts.delimiter,
+				quote: opts.quote,
+				columns: headers.map(function (header) { return (header in fieldTypes) ? header : null; })
+			});
+			callback(undefined, store);
     	} catch (e) {
 			callback(e);
     	}
@@ -262,27 +222,15 @@ module.exports = exports = function (pathQmBinary) {
 
     /**
      * Load given file line by line, parse each line to JSON and push it to the store.
+     * Parsing is done by {@link module:qm.Store#load}.
      * @param {String} file - Name of the JSON line file.
      * @param {Number} [limit] - Maximal number of records to load from file.
      * @returns {number} Number of records loaded from file.
      */
     exports.Store.prototype.loadJson = function (file, limit) {
-        var fin = fs.openRead(file);
-        var count = 0;
-        while (!fin.eof) {
-            var line = fin.readLine();
-            if (line == "") { continue; }
-            try {
-                var rec = JSON.parse(line);
-                this.push(rec);
-                // count, GC and report
-                count++;
-                if (limit != undefined && count == limit) { break; }
-            } catch (err) {
-                throw new Error("Error parsing line number: " + count + ", line content:[" + line + "]: " + err);                
-            }
-        }
-        return count;
+        var opts = { file: file, format: 'json' };
+        if (limit != undefined) { opts.limit = limit; }
+        return this.load(opts);
     }
 
     //==================================================================
@@ -2056,6 +2056,111 @@ PJsonVal TNNAnomalyAggr::SaveJson(const int& Limit) const {
     return Val;
 }
 
+///////////////////////////////
+/// Online KMeans stream aggregate
+TClustering::TDenseMiniBatchKMeans* TOnlineKMeans::NewModel(const PJsonVal& ParamVal) {
+    const int K = ParamVal->GetObjInt("k", 2);
+    const double Decay = ParamVal->GetObjNum("decay", 1.0);
+    QmAssertR(K > 0, "onlineKMeans: k must be positive");
+    QmAssertR(0 < Decay && Decay <= 1, "onlineKMeans: decay must be in (0, 1]");
+    // parse distance
+    const TStr DistNm = ParamVal->GetObjStr("distanceType", "Euclid");
+    TClustering::PDist Dist;
+    if (DistNm == "Euclid") {
+        Dist = TClustering::TEuclDist::New();
+    } else if (DistNm == "Cos") {
+        Dist = TClustering::TCosDist::New();
+    } else {
+        throw TQmExcept::New("onlineKMeans: distanceType must be Euclid or Cos");
+    }
+    return new TClustering::TDenseMiniBatchKMeans(K, Decay, 100, TRnd(0), Dist);
+}
+
+void TOnlineKMeans::OnStep(const TWPt<TStreamAggr>& CallerAggr) {
+    TScopeStopWatch StopWatch(ExeTm);
+    if (!InAggr->IsInit()) { return; }
+    if (!InAggrSparseVecIO.Empty()) {
+        // all vectors that entered the window form one batch
+        TVec<TIntFltKdV> BatchVV; InAggrSparseVecIO->GetInValV(BatchVV);
+        if (BatchVV.Empty()) { return; }
+        TIntV AssignV; GetModel().PartialFit(BatchVV, AssignV);
+        LastClustN = AssignV.Last();
+    } else if (InAggrSparseVec.Empty() || (InAggrSparseVec->GetSparseVecLen() == 0 &&
+            !InAggrFltVec.Empty() && InAggrFltVec->GetVals() > 0)) {
+        // dense input, or a feature space aggregate that only extracts full vectors
+        TFltV FltV; InAggrFltVec->GetValV(FltV);
+        LastClustN = GetModel().PartialFit(FltV);
+    } else {
+        TIntFltKdV SpV; InAggrSparseVec->GetSparseVec(SpV);
+        LastClustN = GetModel().PartialFit(SpV);
+    }
+}
+
+TOnlineKMeans::TOnlineKMeans(const TWPt<TBase>& Base, const PJsonVal& ParamVal):
+        TStreamAggr(Base, ParamVal), Model(NewModel(ParamVal)), LastClustN(-1) {
+
+    // parse input aggregate
+    InAggr = ParseAggr(ParamVal, "inAggr");
+    InAggrSparseVecIO = Cast<TStreamAggrOut::IValIO<TIntFltKdV>>(InAggr, false);
+    InAggrSparseVec = Cast<TStreamAggrOut::ISparseVec>(InAggr, false);
+    InAggrFltVec = Cast<TStreamAggrOut::IFltVec>(InAggr, false);
+    if (InAggrSparseVecIO.Empty() && InAggrSparseVec.Empty() && InAggrFltVec.Empty()) {
+        throw TQmExcept::New("Stream aggregate does not implement IValIO<TIntFltKdV>, ISparseVec or IFltVec interface: " + InAggr->GetAggrNm());
+    }
+}
+
+PJsonVal TOnlineKMeans::GetParams() const {
+    PJsonVal ParamVal = TJsonVal::NewObj();
+    ParamVal->AddToObj("inAggr", InAggr->GetAggrNm());
+    ParamVal->AddToObj("k", GetModel().GetK());
+    ParamVal->AddToObj("decay", GetModel().GetDecay());
+    const bool EuclP = Model->GetDist()->GetType() == TClustering::TEuclDist::TYPE;
+    ParamVal->AddToObj("distanceType", EuclP ? "Euclid" : "Cos");
+    return ParamVal;
+}
+
+void TOnlineKMeans::Reset() {
+    GetModel().Reset();
+    LastClustN = -1;
+}
+
+void TOnlineKMeans::LoadState(TSIn& SIn) {
+    TClustering::TAbsKMeans<TFltVV>* KMeans = TClustering::TAbsKMeans<TFltVV>::LoadPtr(SIn);
+    if (dynamic_cast<TClustering::TDenseMiniBatchKMeans*>(KMeans) == nullptr) {
+        delete KMeans;
+        throw TQmExcept::New("onlineKMeans: loaded model is not a mini-batch KMeans");
+    }
+    Model = KMeans;
+    LastClustN.Load(SIn);
+}
+
+void TOnlineKMeans::SaveState(TSOut& SOut) const {
+    Model->Save(SOut);
+    LastClustN.Save(SOut);
+}
+
+PJsonVal TOnlineKMeans::SaveJson(const int& Limit) const {
+    PJsonVal CentroidsVal = TJsonVal::NewArr();
+    const TFltVV& CentroidVV = Model->GetCentroidVV();
+    for (int ClustN = 0; ClustN < Model->GetClusts(); ClustN++) {
+        TFltV CentroidV; CentroidVV.GetCol(ClustN, CentroidV);
+        CentroidsVal->AddToArr(TJsonVal::NewArr(CentroidV));
+    }
+    PJsonVal Val = TJsonVal::NewObj();
+    Val->AddToObj("centroids", CentroidsVal);
+    Val->AddToObj("counts", TJsonVal::NewArr(GetModel().GetCountV()));
+    Val->AddToObj("cluster", LastClustN);
+    return Val;
+}
+
+uint64 TOnlineKMeans::GetMemUsed() const {
+    return sizeof(TOnlineKMeans) +
+           (TStreamAggr::GetMemUsed() - sizeof(TStreamAggr)) +
+           sizeof(TClustering::TDenseMiniBatchKMeans) +
+           (uint64)Model->GetClusts() * Model->GetDim() * sizeof(TFlt) +
+           TMemUtils::GetExtraMemberSize(GetModel().GetCountV());
+}
+
 ///////////////////////////////
 /// Histogram stream aggregate
 void TOnlineHistogram::OnStep(const TWPt<TStreamAggr>& CallerAggr) {
@@ -2695,7 +2800,8 @@ THistogramAD::THistogramAD(const TWPt<TBase>& Base, const PJsonVal& ParamVal) :
     Reset();
     AutoBandwidthSkip = (int)ParamVal->GetObjNum("skip", 1);
     // parse out input aggregate
-    InAggrVal = Cast<TStreamAggrOut::IFlt>(ParseAggr(ParamVal, "inAggr"));
+    InAggr = ParseAggr(ParamVal, "inAggr");
+    InAggrVal = Cast<TStreamAggrOut::IFlt>(InAggr);
     HistAggr = Cast<TOnlineHistogram>(ParseAggr(ParamVal, "inHistogram"));
 }
 
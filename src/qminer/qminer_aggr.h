@@ -247,6 +247,8 @@ public:
     /// Serilization to JSon
     PJsonVal SaveJson(const int& Limit) const;
 
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// Stream aggregator type name
     static TStr GetType() { return "recordBuffer"; }
     /// Stream aggregator type name
@@ -304,6 +306,8 @@ public:
     // serialization to JSon
     PJsonVal SaveJson(const int& Limit) const;
 
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// Stream aggregator type name
     static TStr GetType() { return "timeSeriesTick"; }
     /// Stream aggregator type name
@@ -366,6 +370,8 @@ public:
     // serialization to JSon
     PJsonVal SaveJson(const int& Limit) const;
 
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// Stream aggregator type name
     static TStr GetType() { return "timeSeriesSparseVectorTick"; }
     /// Stream aggregator type name
@@ -483,6 +489,10 @@ public:
 
     /// serialization to JSon
     PJsonVal SaveJson(const int& Limit) const;
+    /// Input aggregate names
+    void GetInAggrNmV(TStrV& InAggrNmV) const { InAggrNmV.Add(InAggr->GetAggrNm()); }
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
 };
 
 ///////////////////////////////
@@ -663,6 +673,9 @@ public:
     bool TestValid() const;
     /// print state for debugging
     void Print(const bool& PrintState = false);
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
+
 private:
     /// Extract timestamp from the given record
     uint64 Time(const uint64& RecId) const { return Store->GetFieldTmMSecs(RecId, TimeFieldId); }
@@ -794,6 +807,8 @@ public:
     /// Serialization to json
     PJsonVal SaveJson(const int& Limit) const;
 
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// Stream aggregator type name
     static TStr GetType();
     /// Stream aggregator type name
@@ -880,6 +895,8 @@ public:
     /// Serialization to JSon
     PJsonVal SaveJson(const int& Limit) const;
 
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// Stream aggregator type name
     static TStr GetType();
     /// Stream aggregator type name
@@ -936,6 +953,8 @@ public:
     /// Serialization to JSon
     PJsonVal SaveJson(const int& Limit) const;
 
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// Stream aggregator type name
     static TStr GetType() { return "ema"; }
     /// Stream aggregator type name
@@ -991,6 +1010,8 @@ public:
     /// Serialization to JSon
     PJsonVal SaveJson(const int& Limit) const;
 
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// Stream aggregator type name
     static TStr GetType() { return "emaSpVec"; }
     /// Stream aggregator type name
@@ -1045,6 +1066,8 @@ public:
     /// Serialization to JSon
     PJsonVal SaveJson(const int& Limit) const;
 
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// Stream aggregator type name
     static TStr GetType() { return "threshold"; }
     /// Stream aggregator type name
@@ -1103,6 +1126,8 @@ public:
     /// Serialization to JSon
     PJsonVal SaveJson(const int& Limit) const;
 
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// Stream aggregator type name
     static TStr GetType() { return "covariance"; }
     /// Stream aggregator type name
@@ -1166,6 +1191,8 @@ public:
     /// Serialization to JSon
     PJsonVal SaveJson(const int& Limit) const;
 
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// Stream aggregator type name
     static TStr GetType() { return "correlation"; }
     /// Stream aggregator type name
@@ -1248,6 +1275,8 @@ public:
     /// Save state of stream aggregate to stream
     void SaveState(TSOut& SOut) const;
 
+    /// Adds merged records to the output store, so it is not updated on worker threads
+    bool IsThreadSafe() const { return false; }
     /// Stream aggregator type name
     static TStr GetType() { return "merger"; }
     /// Stream aggregator type name
@@ -1342,6 +1371,10 @@ public:
 
     PJsonVal SaveJson(const int& Limit) const;
 
+    /// Adds resampled records to the output store, so it is not updated on worker threads
+    bool IsThreadSafe() const { return false; }
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// Stream aggregator type name
     static TStr GetType() { return "resampler"; }
     /// Stream aggregator type name
@@ -1395,6 +1428,12 @@ public:
     uint64 GetTmMSecs() const { return InterpPointMSecs; }
     double GetFlt() const { return InterpPointVal; }
 
+    /// Pushes interpolated values to the output aggregate, so it is not updated on worker threads
+    bool IsThreadSafe() const { return false; }
+    /// Input aggregate names
+    void GetInAggrNmV(TStrV& InAggrNmV) const { if (!InAggr.Empty()) { InAggrNmV.Add(InAggr->GetAggrNm()); } }
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// Stream aggregator type name
     static TStr GetType() { return "resample"; }
     /// Stream aggregator type name
@@ -1450,6 +1489,12 @@ public:
     uint64 GetTmMSecs() const { return Resampler.GetTmMSecs(); }
     /// Returns the value of the last aggregated interval
     double GetFlt() const { return Resampler.GetFlt(); }
+    /// Pushes aggregated intervals to the output aggregate, so it is not updated on worker threads
+    bool IsThreadSafe() const { return false; }
+    /// Input aggregate names
+    void GetInAggrNmV(TStrV& InAggrNmV) const { if (!InAggr.Empty()) { InAggrNmV.Add(InAggr->GetAggrNm()); } }
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// Stream aggregator type name
     static TStr GetType() { return "aggrResample"; }
     /// Stream aggregator type name
@@ -1536,6 +1581,8 @@ public:
     // serialization to JSon
     PJsonVal SaveJson(const int& Limit) const;
 
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// Stream aggregator type name
     static TStr GetType() { return "featureSpace"; }
     /// Stream aggregator type name
@@ -1596,12 +1643,87 @@ public:
 
     /// Returns the memory footprint of the object
     uint64 GetMemUsed() const;
+    /// Input aggregate names
+    void GetInAggrNmV(TStrV& InAggrNmV) const {
+        InAggrNmV.Add(InAggrTm->GetAggrNm()); InAggrNmV.Add(InAggrSparseVec->GetAggrNm()); }
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// Stream aggregator type name
     static TStr GetType() { return "nnAnomalyDetector"; }
     /// Stream aggregator type name
     TStr Type() const { return GetType(); }
 };
 
+///////////////////////////////
+/// Online KMeans stream aggregate.
+/// Updates a mini-batch KMeans model with each new vector, so the centroids follow
+/// the stream without refitting. Connects to a buffer of sparse vectors (e.g.
+/// timeSeriesWinBufFeatureSpace), where all the vectors that entered the window
+/// are used as one batch, or to an aggregate that implements
+/// TStreamAggrOut::ISparseVec or TStreamAggrOut::IFltVec (e.g. featureSpace),
+/// where sparse vectors are preferred. Returns the cluster of the last vector.
+class TOnlineKMeans : public TStreamAggr, public TStreamAggrOut::IInt {
+private:
+    /// Input aggregate
+    TWPt<TStreamAggr> InAggr;
+    /// Input buffer of sparse vectors (can be NULL)
+    TWPt<TStreamAggrOut::IValIO<TIntFltKdV>> InAggrSparseVecIO;
+    /// Input sparse vector (can be NULL)
+    TWPt<TStreamAggrOut::ISparseVec> InAggrSparseVec;
+    /// Input dense vector (can be NULL)
+    TWPt<TStreamAggrOut::IFltVec> InAggrFltVec;
+
+    /// Mini-batch KMeans model with dense centroids
+    TClustering::PDenseKMeans Model;
+    /// Cluster of the last vector, -1 before the first one
+    TInt LastClustN;
+
+    /// Creates an empty model from the parameters
+    static TClustering::TDenseMiniBatchKMeans* NewModel(const PJsonVal& ParamVal);
+    /// Model is always a mini-batch KMeans
+    TClustering::TDenseMiniBatchKMeans& GetModel() const {
+        return static_cast<TClustering::TDenseMiniBatchKMeans&>(*Model); }
+
+protected:
+    /// Update the model
+    void OnStep(const TWPt<TStreamAggr>& CallerAggr);
+
+    /// JSON constructor
+    TOnlineKMeans(const TWPt<TBase>& Base, const PJsonVal& ParamVal);
+public:
+    /// JSON constructor
+    static PStreamAggr New(const TWPt<TBase>& Base, const PJsonVal& ParamVal) {
+        return new TOnlineKMeans(Base, ParamVal); }
+
+    /// Parameters of the aggregate
+    PJsonVal GetParams() const;
+
+    /// Did we initialize all the centroids
+    bool IsInit() const { return GetModel().IsInit(); }
+    /// Forgets the centroids
+    void Reset();
+    /// Load from stream
+    void LoadState(TSIn& SIn);
+    /// Store state into stream
+    void SaveState(TSOut& SOut) const;
+    /// Centroids, their (decayed) sizes and the last cluster
+    PJsonVal SaveJson(const int& Limit) const;
+
+    /// Cluster of the last vector
+    int GetInt() const { return LastClustN; }
+    /// Input aggregate name
+    void GetInAggrNmV(TStrV& InAggrNmV) const { InAggrNmV.Add(InAggr->GetAggrNm()); }
+
+    /// Returns the memory footprint of the object
+    uint64 GetMemUsed() const;
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
+    /// Stream aggregator type name
+    static TStr GetType() { return "onlineKMeans"; }
+    /// Stream aggregator type name
+    TStr Type() const { return GetType(); }
+};
+
 ///////////////////////////////
 /// Histogram stream aggregate.
 /// Updates a histogram model, connects to a time series stream aggregate (such as TEma)
@@ -1657,6 +1779,10 @@ public:
     /// returns the vector of frequencies
     void GetValV(TFltV& ValV) const { Model.GetCountV(ValV); }
 
+    /// Input aggregate names
+    void GetInAggrNmV(TStrV& InAggrNmV) const { InAggrNmV.Add(InAggr->GetAggrNm()); }
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// stream aggregator type name
     static TStr GetType() { return "onlineHistogram"; }
     /// stream aggregator type name
@@ -1717,6 +1843,8 @@ public:
     /// Serialization to JSon
     PJsonVal SaveJson(const int& Limit) const;
 
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// Stream aggregator type name
     static TStr GetType() { return "tdigest"; }
     /// Stream aggregator type name
@@ -1760,6 +1888,10 @@ public:
     bool IsInit() const;
     /// resets the model
     void Reset();
+    /// Input aggregate names
+    void GetInAggrNmV(TStrV& InAggrNmV) const { InAggrNmV.Add(InAggr->GetAggrNm()); }
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// Stream aggregator type name
     static TStr GetType() { return "windowQuantiles"; }
     /// Stream aggregator type name
@@ -1835,6 +1967,8 @@ public:
     // serialization to JSon
     PJsonVal SaveJson(const int& Limit) const;
     // stream aggregator type name
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     static TStr GetType() { return "chiSquare"; }
     TStr Type() const { return GetType(); }
 };
@@ -1904,6 +2038,10 @@ public:
     /// serilization to JSon
     PJsonVal SaveJson(const int& Limit) const;
 
+    /// Input aggregate names
+    void GetInAggrNmV(TStrV& InAggrNmV) const { InAggrNmV.Add(InAggr->GetAggrNm()); }
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// stream aggregator type name
     static TStr GetType() { return "onlineSlottedHistogram"; }
     /// stream aggregator type name
@@ -1960,6 +2098,11 @@ public:
     /// serialization to JSon
     PJsonVal SaveJson(const int& Limit) const;
 
+    /// Input aggregate names
+    void GetInAggrNmV(TStrV& InAggrNmV) const {
+        InAggrNmV.Add(InAggrX->GetAggrNm()); InAggrNmV.Add(InAggrY->GetAggrNm()); }
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// stream aggregator type name
     static TStr GetType() { return "onlineVecDiff"; }
     /// stream aggregator type name
@@ -2029,6 +2172,11 @@ public:
     /// JSON serialization
     PJsonVal SaveJson(const int& Limit) const { return Result; }
 
+    /// Input aggregate names
+    void GetInAggrNmV(TStrV& InAggrNmV) const {
+        InAggrNmV.Add(InAggrX->GetAggrNm()); InAggrNmV.Add(InAggrY->GetAggrNm()); }
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// Stream aggregator type name
     static TStr GetType() { return "simpleLinearRegression"; }
     /// Stream aggregator type name
@@ -2071,6 +2219,10 @@ public:
     PJsonVal SaveJson(const int& Limit) const { return TJsonVal::NewObj(); }
     /// Returns the memory footprint
     uint64 GetMemUsed() const;
+    /// Forwards records to the filtered aggregate, so it is not updated on worker threads
+    bool IsThreadSafe() const { return false; }
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// Stream aggregator type name
     static TStr GetType() { return "recordFilterAggr"; }
     /// Stream aggregator type name
@@ -2123,6 +2275,10 @@ public:
     void Reset() {}
     /// JSON serialization
     PJsonVal SaveJson(const int& Limit) const { return TJsonVal::NewObj(); }
+    /// Forwards records to the aggregate selected by the key, so it is not updated on worker threads
+    bool IsThreadSafe() const { return false; }
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// Stream aggregator type name
     static TStr GetType() { return "recordSwitchAggr"; }
     /// Stream aggregator type name
@@ -2146,6 +2302,8 @@ public:
 ///      - exposes the PMF and severities through SaveJson
 class THistogramAD : public TStreamAggr, public TStreamAggrOut::INmInt, public TStreamAggrOut::INmFlt {
 private:
+    /// Input aggregate for prediction
+    TWPt<TStreamAggr> InAggr;
     /// Input for prediction
     TWPt<TStreamAggrOut::IFlt> InAggrVal;
     /// Bandwidth will be recomputed every time Count is divisible with AutoBandwidthSkip
@@ -2193,6 +2351,13 @@ public:
     void Reset();
     /// JSON serialization
     PJsonVal SaveJson(const int& Limit) const;
+    /// Input aggregate names
+    void GetInAggrNmV(TStrV& InAggrNmV) const {
+        InAggrNmV.Add(InAggr->GetAggrNm()); InAggrNmV.Add(HistAggr->GetAggrNm()); }
+    /// Updates the input histogram, so it cannot run next to its readers
+    bool IsThreadSafe() const { return false; }
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
     /// Stream aggregator type name
     static TStr GetType() { return "histogramAD"; }
     /// Stream aggregator type name
@@ -166,6 +166,44 @@ void TStoreWndDesc::Load(TSIn& SIn) {
     TimeFieldNm.Load(SIn);
 }
 
+///////////////////////////////
+// QMiner-Store-Segment
+void TStoreSegment::Save(TSOut& SOut) const {
+    StartMSecs.Save(SOut);
+    FirstRecId.Save(SOut);
+    LastRecId.Save(SOut);
+    MinMSecs.Save(SOut);
+    MaxMSecs.Save(SOut);
+}
+
+void TStoreSegment::Load(TSIn& SIn) {
+    StartMSecs.Load(SIn);
+    FirstRecId.Load(SIn);
+    LastRecId.Load(SIn);
+    MinMSecs.Load(SIn);
+    MaxMSecs.Load(SIn);
+}
+
+void TStoreSegment::AddTm(const uint64& TmMSecs) {
+    if (TmMSecs < MinMSecs) { MinMSecs = TmMSecs; }
+    if (TmMSecs > MaxMSecs) { MaxMSecs = TmMSecs; }
+}
+
+int TStoreSegment::GetSegmentN(const TVec<TStoreSegment>& SegmentV, const uint64& RecId) {
+    if (SegmentV.Empty()) { return -1; }
+    // binary search for the last segment starting at or before the record
+    int MnSegmentN = 0, MxSegmentN = SegmentV.Len() - 1;
+    while (MnSegmentN < MxSegmentN) {
+        const int MidSegmentN = (MnSegmentN + MxSegmentN + 1) / 2;
+        if (SegmentV[MidSegmentN].FirstRecId <= RecId) {
+            MnSegmentN = MidSegmentN;
+        } else {
+            MxSegmentN = MidSegmentN - 1;
+        }
+    }
+    return SegmentV[MnSegmentN].IsRecId(RecId) ? MnSegmentN : -1;
+}
+
 ///////////////////////////////
 // QMiner-Join-Description
 TJoinDesc::TJoinDesc(const TWPt<TBase>& Base, const TStr& _JoinNm, const uint& _JoinStoreId,
@@ -358,6 +396,298 @@ TStr TFieldDesc::GetFieldTypeStr() const {
     Fail; return "";
 }
 
+///////////////////////////////
+// QMiner-Field-Column
+namespace {
+
+/// Check that a record is stored in the column, elements [FirstValN, Vals) are
+/// valid. Record sets can hold IDs of deleted records, which the row path rejects
+/// when reading the record, so the column path has to reject them as well.
+inline void AssertColumnValN(const uint64& ValN, const uint64& FirstRecId,
+        const int64& FirstValN, const int64& Vals) {
+
+    // one unsigned compare, IDs before the start wrap around to large values
+    QmAssertR(ValN - (uint64)FirstValN < (uint64)(Vals - FirstValN),
+        "TFieldColumn: record ID " + TUInt64::GetStr(FirstRecId + ValN) + " out of range");
+}
+
+/// Keep records with values within [MinVal, MaxVal] and not null. Apart from
+/// the range check the loop is branch-free: each record is written to the output
+/// position and the position only advances when the record passes the filter.
+template <class TVal, class TNum>
+void FilterColumnRange(TUInt64IntKdV& RecIdFqV, const TVec<TVal, int64>& ValV,
+        const TVec<TUInt64, int64>& NullV, const uint64& FirstRecId,
+        const int64& FirstValN, const int64& Vals, const TNum& MinVal, const TNum& MaxVal) {
+
+    const int Recs = RecIdFqV.Len();
+    if (Recs == 0) { return; }
+    TUInt64IntKd* RecIdFqBf = RecIdFqV.BegI();
+    const TVal* ValBf = ValV.BegI();
+    const TUInt64* NullBf = NullV.BegI();
+    int KeepRecs = 0;
+    for (int RecN = 0; RecN < Recs; RecN++) {
+        const TUInt64IntKd RecIdFq = RecIdFqBf[RecN];
+        const uint64 ValN = RecIdFq.Key.Val - FirstRecId;
+        AssertColumnValN(ValN, FirstRecId, FirstValN, Vals);
+        const TNum Val = ValBf[ValN].Val;
+        const uint64 NullP = (NullBf[ValN >> 6].Val >> (ValN & 63)) & 1;
+        const int KeepP = (int)((MinVal <= Val) & (Val <= MaxVal) & (NullP == 0));
+        RecIdFqBf[KeepRecs] = RecIdFq;
+        KeepRecs += KeepP;
+    }
+    RecIdFqV.Trunc(KeepRecs);
+}
+
+/// Gather values of given records as doubles, null values are returned as 0.
+template <class TVal>
+void GetColumnNumV(const TUInt64IntKdV& RecIdFqV, const TVec<TVal, int64>& ValV,
+        const TVec<TUInt64, int64>& NullV, const uint64& FirstRecId,
+        const int64& FirstValN, const int64& Vals, TFltV& NumV) {
+
+    const int Recs = RecIdFqV.Len();
+    NumV.Gen(Recs);
+    for (int RecN = 0; RecN < Recs; RecN++) {
+        const uint64 ValN = RecIdFqV[RecN].Key.Val - FirstRecId;
+        AssertColumnValN(ValN, FirstRecId, FirstValN, Vals);
+        const uint64 NullP = (NullV[ValN >> 6].Val >> (ValN & 63)) & 1;
+        NumV[RecN] = NullP ? 0.0 : (double)ValV[ValN].Val;
+    }
+}
+
+}
+
+TFieldColumn::TFieldColumn(const TFieldDesc& FieldDesc, const PJsonVal& _DefaultVal):
+        FieldId(FieldDesc.GetFieldId()), FieldType(FieldDesc.GetFieldType()),
+        DefaultVal(_DefaultVal) {
+
+    QmAssertR(IsFieldType(FieldType), "Field " + FieldDesc.GetFieldNm() +
+        " of type " + FieldDesc.GetFieldTypeStr() + " cannot be stored in a column");
+}
+
+TFieldColumn::TFieldColumn(TSIn& SIn): FieldId(SIn), FieldType(TFieldType(TInt(SIn).Val)),
+    FirstRecId(SIn), FirstValN(SIn), Vals(SIn), DefaultVal(SIn), ByteV(SIn), IntV(SIn), Int64V(SIn),
+    UInt64V(SIn), FltV(SIn), SFltV(SIn), NullV(SIn) { }
+
+void TFieldColumn::Save(TSOut& SOut) const {
+    FieldId.Save(SOut);
+    TInt(FieldType).Save(SOut);
+    FirstRecId.Save(SOut);
+    FirstValN.Save(SOut);
+    Vals.Save(SOut);
+    DefaultVal.Save(SOut);
+    ByteV.Save(SOut);
+    IntV.Save(SOut);
+    Int64V.Save(SOut);
+    UInt64V.Save(SOut);
+    FltV.Save(SOut);
+    SFltV.Save(SOut);
+    NullV.Save(SOut);
+}
+
+bool TFieldColumn::IsFieldType(const TFieldType& FieldType) {
+    return FieldType == oftByte || FieldType == oftBool || FieldType == oftInt ||
+        FieldType == oftInt64 || FieldType == oftUInt64 || FieldType == oftFlt ||
+        FieldType == oftSFlt || FieldType == oftTm;
+}
+
+void TFieldColumn::Compact() {
+    // only compact once deleted elements take at least half of the vectors,
+    // and always in multiples of 64 so null bitmap words can be dropped as they are
+    if (FirstValN < 1024 || 2 * FirstValN < Vals) { return; }
+    const int64 DelVals = (FirstValN / 64) * 64;
+    switch (FieldType) {
+        case oftByte: case oftBool: ByteV.Del(0, DelVals - 1); break;
+        case oftInt: IntV.Del(0, DelVals - 1); break;
+        case oftInt64: Int64V.Del(0, DelVals - 1); break;
+        case oftUInt64: case oftTm: UInt64V.Del(0, DelVals - 1); break;
+        case oftFlt: FltV.Del(0, DelVals - 1); break;
+        case oftSFlt: SFltV.Del(0, DelVals - 1); break;
+        default: Fail;
+    }
+    NullV.Del(0, DelVals / 64 - 1);
+    FirstRecId += (uint64)DelVals;
+    FirstValN -= DelVals;
+    Vals -= DelVals;
+}
+
+void TFieldColumn::AddRec(const uint64& RecId) {
+    // first record after column was emptied defines new start
+    if (GetRecs() == 0) { Clr(); FirstRecId = RecId; }
+    QmAssertR(RecId == FirstRecId + (uint64)Vals, "TFieldColumn: record IDs must be consecutive");
+    switch (FieldType) {
+        case oftByte: case oftBool: ByteV.Add(0); break;
+        case oftInt: IntV.Add(0); break;
+        case oftInt64: Int64V.Add(0); break;
+        case oftUInt64: case oftTm: UInt64V.Add(0); break;
+        case oftFlt: FltV.Add(0.0); break;
+        case oftSFlt: SFltV.Add(0.0f); break;
+        default: Fail;
+    }
+    if ((Vals & 63) == 0) { NullV.Add(0); }
+    NullV.Last().Val |= (uint64)1 << (Vals & 63);
+    Vals++;
+}
+
+void TFieldColumn::DelRecs(const uint64& Recs) {
+    FirstValN += (int64)MIN(Recs, GetRecs());
+    Compact();
+}
+
+void TFieldColumn::Clr() {
+    FirstValN = 0; Vals = 0;
+    ByteV.Clr(); IntV.Clr(); Int64V.Clr(); UInt64V.Clr();
+    FltV.Clr(); SFltV.Clr(); NullV.Clr();
+}
+
+void TFieldColumn::SetNull(const uint64& RecId) {
+    const int64 ValN = GetValN(RecId);
+    NullV[ValN >> 6].Val |= (uint64)1 << (ValN & 63);
+}
+
+double TFieldColumn::GetNum(const uint64& RecId) const {
+    if (IsNull(RecId)) { return 0.0; }
+    const int64 ValN = GetValN(RecId);
+    switch (FieldType) {
+        case oftByte: case oftBool: return (double)ByteV[ValN].Val;
+        case oftInt: return (double)IntV[ValN].Val;
+        case oftInt64: return (double)Int64V[ValN].Val;
+        case oftUInt64: case oftTm: return (double)UInt64V[ValN].Val;
+        case oftFlt: return FltV[ValN].Val;
+        case oftSFlt: return (double)SFltV[ValN].Val;
+        default: Fail; return 0.0;
+    }
+}
+
+void TFieldColumn::SetByte(const uint64& RecId, const uchar& Byte) {
+    const int64 ValN = GetValN(RecId);
+    ByteV[ValN] = Byte;
+    NullV[ValN >> 6].Val &= ~((uint64)1 << (ValN & 63));
+}
+
+void TFieldColumn::SetBool(const uint64& RecId, const bool& Bool) {
+    const int64 ValN = GetValN(RecId);
+    ByteV[ValN] = Bool ? 1 : 0;
+    NullV[ValN >> 6].Val &= ~((uint64)1 << (ValN & 63));
+}
+
+void TFieldColumn::SetInt(const uint64& RecId, const int& Int) {
+    const int64 ValN = GetValN(RecId);
+    IntV[ValN] = Int;
+    NullV[ValN >> 6].Val &= ~((uint64)1 << (ValN & 63));
+}
+
+void TFieldColumn::SetInt64(const uint64& RecId, const int64& Int64) {
+    const int64 ValN = GetValN(RecId);
+    Int64V[ValN] = Int64;
+    NullV[ValN >> 6].Val &= ~((uint64)1 << (ValN & 63));
+}
+
+void TFieldColumn::SetUInt64(const uint64& RecId, const uint64& UInt64) {
+    const int64 ValN = GetValN(RecId);
+    UInt64V[ValN] = UInt64;
+    NullV[ValN >> 6].Val &= ~((uint64)1 << (ValN & 63));
+}
+
+void TFieldColumn::SetFlt(const uint64& RecId, const double& Flt) {
+    const int64 ValN = GetValN(RecId);
+    FltV[ValN] = Flt;
+    NullV[ValN >> 6].Val &= ~((uint64)1 << (ValN & 63));
+}
+
+void TFieldColumn::SetSFlt(const uint64& RecId, const float& SFlt) {
+    const int64 ValN = GetValN(RecId);
+    SFltV[ValN] = SFlt;
+    NullV[ValN >> 6].Val &= ~((uint64)1 << (ValN & 63));
+}
+
+void TFieldColumn::SetTmMSecs(const uint64& RecId, const uint64& TmMSecs) {
+    const int64 ValN = GetValN(RecId);
+    UInt64V[ValN] = TmMSecs;
+    NullV[ValN >> 6].Val &= ~((uint64)1 << (ValN & 63));
+}
+
+void TFieldColumn::SetJsonVal(const uint64& RecId, const TStr& FieldNm, const PJsonVal& JsonVal) {
+    if (JsonVal->IsNull()) { SetNull(RecId); return; }
+    switch (FieldType) {
+    case oftByte:
+        QmAssertR(JsonVal->IsNum(), "Provided JSon data field " + FieldNm + " is not numeric.");
+        SetByte(RecId, (uchar)JsonVal->GetUInt64());
+        break;
+    case oftBool:
+        QmAssertR(JsonVal->IsBool(), "Provided JSon data field " + FieldNm + " is not boolean.");
+        SetBool(RecId, JsonVal->GetBool());
+        break;
+    case oftInt:
+        QmAssertR(JsonVal->IsNum(), "Provided JSon data field " + FieldNm + " is not numeric.");
+        SetInt(RecId, JsonVal->GetInt());
+        break;
+    case oftInt64:
+        QmAssertR(JsonVal->IsNum(), "Provided JSon data field " + FieldNm + " is not numeric.");
+        SetInt64(RecId, (int64)JsonVal->GetNum());
+        break;
+    case oftUInt64:
+        QmAssertR(JsonVal->IsNum(), "Provided JSon data field " + FieldNm + " is not numeric.");
+        SetUInt64(RecId, JsonVal->GetUInt64());
+        break;
+    case oftFlt:
+        QmAssertR(JsonVal->IsNum(), "Provided JSon data field " + FieldNm + " is not numeric.");
+        SetFlt(RecId, JsonVal->GetNum());
+        break;
+    case oftSFlt:
+        QmAssertR(JsonVal->IsNum(), "Provided JSon data field " + FieldNm + " is not numeric.");
+        SetSFlt(RecId, (float)JsonVal->GetNum());
+        break;
+    case oftTm: {
+        QmAssertR(JsonVal->IsStr() || JsonVal->IsNum(), "Provided JSon data field " + FieldNm + " is not a number or a string that represents DateTime.");
+        if (JsonVal->IsStr()) {
+            TTm Tm = TTm::GetTmFromWebLogDateTimeStr(JsonVal->GetStr(), '-', ':', '.', 'T');
+            SetTmMSecs(RecId, TTm::GetMSecsFromTm(Tm));
+        } else {
+            SetTmMSecs(RecId, TTm::GetWinMSecsFromUnixMSecs(JsonVal->GetInt64()));
+        }
+        break;
+    }
+    default:
+        throw TQmExcept::New("TFieldColumn::SetJsonVal: unsupported field type");
+    }
+}
+
+void TFieldColumn::FilterByte(TUInt64IntKdV& RecIdFqV, const uchar& MinVal, const uchar& MaxVal) const {
+    FilterColumnRange(RecIdFqV, ByteV, NullV, FirstRecId, FirstValN, Vals, MinVal, MaxVal);
+}
+
+void TFieldColumn::FilterInt(TUInt64IntKdV& RecIdFqV, const int& MinVal, const int& MaxVal) const {
+    FilterColumnRange(RecIdFqV, IntV, NullV, FirstRecId, FirstValN, Vals, MinVal, MaxVal);
+}
+
+void TFieldColumn::FilterInt64(TUInt64IntKdV& RecIdFqV, const int64& MinVal, const int64& MaxVal) const {
+    FilterColumnRange(RecIdFqV, Int64V, NullV, FirstRecId, FirstValN, Vals, MinVal, MaxVal);
+}
+
+void TFieldColumn::FilterUInt64(TUInt64IntKdV& RecIdFqV, const uint64& MinVal, const uint64& MaxVal) const {
+    FilterColumnRange(RecIdFqV, UInt64V, NullV, FirstRecId, FirstValN, Vals, MinVal, MaxVal);
+}
+
+void TFieldColumn::FilterFlt(TUInt64IntKdV& RecIdFqV, const double& MinVal, const double& MaxVal) const {
+    FilterColumnRange(RecIdFqV, FltV, NullV, FirstRecId, FirstValN, Vals, MinVal, MaxVal);
+}
+
+void TFieldColumn::FilterSFlt(TUInt64IntKdV& RecIdFqV, const float& MinVal, const float& MaxVal) const {
+    FilterColumnRange(RecIdFqV, SFltV, NullV, FirstRecId, FirstValN, Vals, MinVal, MaxVal);
+}
+
+void TFieldColumn::GetNumV(const TUInt64IntKdV& RecIdFqV, TFltV& NumV) const {
+    switch (FieldType) {
+        case oftByte: case oftBool: GetColumnNumV(RecIdFqV, ByteV, NullV, FirstRecId, FirstValN, Vals, NumV); break;
+        case oftInt: GetColumnNumV(RecIdFqV, IntV, NullV, FirstRecId, FirstValN, Vals, NumV); break;
+        case oftInt64: GetColumnNumV(RecIdFqV, Int64V, NullV, FirstRecId, FirstValN, Vals, NumV); break;
+        case oftUInt64: case oftTm: GetColumnNumV(RecIdFqV, UInt64V, NullV, FirstRecId, FirstValN, Vals, NumV); break;
+        case oftFlt: GetColumnNumV(RecIdFqV, FltV, NullV, FirstRecId, FirstValN, Vals, NumV); break;
+        case oftSFlt: GetColumnNumV(RecIdFqV, SFltV, NullV, FirstRecId, FirstValN, Vals, NumV); break;
+        default: Fail;
+    }
+}
+
 ///////////////////////////////
 // QMiner-Store-Iterators
 TStoreIterVec::TStoreIterVec() :
@@ -456,6 +786,7 @@ void TStore::OnAdd(const uint64& RecId) {
 }
 
 void TStore::OnAdd(const TRec& Rec) {
+    IncVersion();
     for (int TriggerN = 0; TriggerN < TriggerV.Len(); TriggerN++) {
         TriggerV[TriggerN]->OnAdd(Rec);
     }
@@ -466,6 +797,7 @@ void TStore::OnUpdate(const uint64& RecId) {
 }
 
 void TStore::OnUpdate(const TRec& Rec) {
+    IncVersion();
     for (int TriggerN = 0; TriggerN < TriggerV.Len(); TriggerN++) {
         TriggerV[TriggerN]->OnUpdate(Rec);
     }
@@ -476,6 +808,7 @@ void TStore::OnDelete(const uint64& RecId) {
 }
 
 void TStore::OnDelete(const TRec& Rec) {
+    IncVersion();
     for (int TriggerN = 0; TriggerN < TriggerV.Len(); TriggerN++) {
         TriggerV[TriggerN]->OnDelete(Rec);
     }
@@ -650,8 +983,17 @@ PRecSet TStore::GetRndRecs(const uint64& SampleSize) {
     return GetAllRecs()->GetSampleRecSet((int)SampleSize);
 }
 
+void TStore::AddRecs(const TVec<PJsonVal>& RecValV, TUInt64V& RecIdV, const bool& TriggerEvents) {
+    RecIdV.Gen(RecValV.Len(), 0);
+    for (int RecN = 0; RecN < RecValV.Len(); RecN++) {
+        RecIdV.Add(AddRec(RecValV[RecN], TriggerEvents));
+    }
+}
+
 void TStore::AddJoin(const int& JoinId, const uint64& RecId, const uint64 JoinRecId, const int& JoinFq) {
     const TJoinDesc& JoinDesc = GetJoinDesc(JoinId);
+    // joins change query results of both stores
+    IncVersion(); JoinDesc.GetJoinStore(Base)->IncVersion();
     // different handling for field and index joins
     if (JoinDesc.IsIndexJoin()) {
         Index->IndexJoin(this, JoinId, RecId, JoinRecId, JoinFq);
@@ -711,6 +1053,8 @@ void TStore::AddJoin(const TStr& JoinNm, const uint64& RecId, const uint64 JoinR
 
 void TStore::DelJoin(const int& JoinId, const uint64& RecId, const uint64 JoinRecId, const int& JoinFq) {
     const TJoinDesc& JoinDesc = GetJoinDesc(JoinId);
+    // joins change query results of both stores
+    IncVersion(); JoinDesc.GetJoinStore(Base)->IncVersion();
     // different handling for field and index joins
     if (JoinDesc.IsIndexJoin()) {
         Index->DeleteJoin(this, JoinId, RecId, JoinRecId, JoinFq);
@@ -1438,6 +1782,189 @@ void TStore::PrintAllAsJson(const TWPt<TBase>& Base, const TStr& FNm) {
     TFOut FOut(FNm); PrintAllAsJson(Base, FOut);
 }
 
+///////////////////////////////
+// QMiner-Store-Loader
+void TStoreLoader::SplitCsvLn(const TChA& LnChA, TStrV& CellV) const {
+    CellV.Clr(false);
+    TChA CellChA; bool QuoteP = false;
+    for (int ChN = 0; ChN < LnChA.Len(); ChN++) {
+        const char Ch = LnChA[ChN];
+        if (QuoteP) {
+            if (Ch != Quote) { CellChA += Ch; }
+            else if (ChN + 1 < LnChA.Len() && LnChA[ChN + 1] == Quote) { CellChA += Quote; ChN++; }
+            else { QuoteP = false; }
+        } else if (Ch == Quote) {
+            QuoteP = true;
+        } else if (Ch == Delimiter) {
+            CellV.Add(CellChA); CellChA.Clr();
+        } else if (Ch != '\r') {
+            CellChA += Ch;
+        }
+    }
+    CellV.Add(CellChA);
+}
+
+PJsonVal TStoreLoader::ParseCsvCell(const int& FieldId, const TStr& CellStr) const {
+    const TFieldDesc& FieldDesc = Store->GetFieldDesc(FieldId);
+    const TFieldType FieldType = FieldDesc.GetFieldType();
+    // strings are the only type where empty cell is a value
+    if (FieldType == oftStr) { return TJsonVal::NewStr(CellStr); }
+    if (CellStr.Empty()) { return PJsonVal(); }
+    switch (FieldType) {
+        case oftByte: case oftInt: case oftInt16: case oftInt64:
+        case oftUInt: case oftUInt16: case oftUInt64:
+        case oftFlt: case oftSFlt: {
+            double Val;
+            QmAssertR(CellStr.IsFlt(Val), "Field " + FieldDesc.GetFieldNm() + " expects a number, got '" + CellStr + "'");
+            return TJsonVal::NewNum(Val);
+        }
+        case oftBool: {
+            const TStr LcStr = CellStr.GetLc();
+            QmAssertR(LcStr == "true" || LcStr == "false" || LcStr == "1" || LcStr == "0",
+                "Field " + FieldDesc.GetFieldNm() + " expects a boolean, got '" + CellStr + "'");
+            return TJsonVal::NewBool(LcStr == "true" || LcStr == "1");
+        }
+        case oftTm: {
+            // numbers are unix timestamps in milliseconds, strings are parsed by the store
+            double Val;
+            if (CellStr.IsFlt(Val)) { return TJsonVal::NewNum(Val); }
+            return TJsonVal::NewStr(CellStr);
+        }
+        default: {
+            // vectors, pairs and JSon fields are given in JSon notation
+            bool Ok; TStr MsgStr;
+            PJsonVal CellVal = TJsonVal::GetValFromStr(CellStr, Ok, MsgStr);
+            QmAssertR(Ok, "Field " + FieldDesc.GetFieldNm() + " expects JSon value, got '" + CellStr + "': " + MsgStr);
+            return CellVal;
+        }
+    }
+}
+
+PJsonVal TStoreLoader::ParseLn(const TChA& LnChA) const {
+    if (Format == slfJson) {
+        bool Ok; TStr MsgStr;
+        PJsonVal RecVal = TJsonVal::GetValFromStr(LnChA, Ok, MsgStr);
+        QmAssertR(Ok && RecVal->IsObj(), "Expected JSon object: " + MsgStr);
+        return RecVal;
+    }
+    TStrV CellV; SplitCsvLn(LnChA, CellV);
+    QmAssertR(CellV.Len() <= ColFieldIdV.Len(), TStr::Fmt(
+        "Expected %d columns, got %d", ColFieldIdV.Len(), CellV.Len()));
+    PJsonVal RecVal = TJsonVal::NewObj();
+    for (int ColN = 0; ColN < CellV.Len(); ColN++) {
+        const int FieldId = ColFieldIdV[ColN];
+        if (FieldId == -1) { continue; }
+        PJsonVal CellVal = ParseCsvCell(FieldId, CellV[ColN]);
+        if (!CellVal.Empty()) { RecVal->AddToObj(Store->GetFieldNm(FieldId), CellVal); }
+    }
+    return RecVal;
+}
+
+TStoreLoader::TStoreLoader(const TWPt<TStore>& _Store, const TStr& FNm, const PJsonVal& ParamVal):
+        Store(_Store), Lines(0), Bytes(0), Recs(0) {
+
+    QmAssertR(TFile::Exists(FNm), "File does not exist: " + FNm);
+    SIn = TFIn::New(FNm);
+    // parse parameters
+    const TStr FormatStr = ParamVal->GetObjStr("format", "json");
+    if (FormatStr == "json") {
+        Format = slfJson;
+    } else if (FormatStr == "csv") {
+        Format = slfCsv;
+    } else {
+        throw TQmExcept::New("Unsupported file format: " + FormatStr);
+    }
+    const TStr DelimiterStr = ParamVal->GetObjStr("delimiter", ",");
+    const TStr QuoteStr = ParamVal->GetObjStr("quote", "\"");
+    QmAssertR(DelimiterStr.Len() == 1 && QuoteStr.Len() == 1, "Delimiter and quote must be single characters");
+    Delimiter = DelimiterStr[0]; Quote = QuoteStr[0];
+    const double LimitFlt = ParamVal->GetObjNum("limit", -1.0);
+    Limit = (LimitFlt < 0.0) ? TUInt64::Mx : (uint64)LimitFlt;
+    BatchSize = TInt::GetMx(1, ParamVal->GetObjInt("batchSize", 10000));
+    TriggerEvents = ParamVal->GetObjBool("triggerEvents", true);
+    // prepare mapping from CSV columns to fields
+    if (Format == slfCsv) {
+        TStrV ColNmV;
+        if (ParamVal->IsObjKey("columns")) {
+            PJsonVal ColsVal = ParamVal->GetObjKey("columns");
+            QmAssertR(ColsVal->IsArr(), "Columns must be an array of field names");
+            for (int ColN = 0; ColN < ColsVal->GetArrVals(); ColN++) {
+                const PJsonVal& ColVal = ColsVal->GetArrVal(ColN);
+                ColNmV.Add(ColVal->IsStr() ? ColVal->GetStr() : TStr());
+                QmAssertR(ColNmV.Last().Empty() || Store->IsFieldNm(ColNmV.Last()), "Unknown field: " + ColNmV.Last());
+            }
+        }
+        // header line
+        if (ParamVal->GetObjBool("header", true)) {
+            TChA LnChA;
+            QmAssertR(SIn->GetNextLnBf(LnChA), "Missing header line in " + FNm);
+            Lines++; Bytes += LnChA.Len() + 1;
+            if (ColNmV.Empty()) { SplitCsvLn(LnChA, ColNmV); }
+        }
+        QmAssertR(!ColNmV.Empty(), "Missing column names for " + FNm);
+        for (int ColN = 0; ColN < ColNmV.Len(); ColN++) {
+            ColFieldIdV.Add(Store->IsFieldNm(ColNmV[ColN]) ? Store->GetFieldId(ColNmV[ColN]) : -1);
+        }
+    }
+}
+
+bool TStoreLoader::ReadBatch(TVec<PJsonVal>& RecValV) {
+    RecValV.Clr(false);
+    // read lines
+    LnChAV.Clr(false); LnNV.Clr(false);
+    TChA LnChA;
+    while (Recs + LnChAV.Len() < Limit && LnChAV.Len() < BatchSize && SIn->GetNextLnBf(LnChA)) {
+        Lines++; Bytes += LnChA.Len() + 1;
+        const uint64 LnN = Lines;
+        // skip empty lines
+        if (LnChA.Empty() || (LnChA.Len() == 1 && LnChA[0] == '\r')) { continue; }
+        // quoted CSV cells can span over several lines
+        if (Format == slfCsv) {
+            int Quotes = LnChA.CountCh(Quote); TChA NextLnChA;
+            while (Quotes % 2 == 1 && SIn->GetNextLnBf(NextLnChA)) {
+                Lines++; Bytes += NextLnChA.Len() + 1;
+                LnChA += '\n'; LnChA += NextLnChA;
+                Quotes += NextLnChA.CountCh(Quote);
+            }
+        }
+        LnChAV.Add(LnChA); LnNV.Add(LnN);
+    }
+    if (LnChAV.Empty()) { return false; }
+    // parse lines in parallel
+    const int Lns = LnChAV.Len();
+    RecValV.Gen(Lns);
+    int ErrorLnN = Lns; TStr ErrorMsgStr;
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (int LnN = 0; LnN < Lns; LnN++) {
+        try {
+            RecValV[LnN] = ParseLn(LnChAV[LnN]);
+        } catch (const PExcept& Except) {
+            #pragma omp critical
+            {
+                // remember the first failed line
+                if (LnN < ErrorLnN) { ErrorLnN = LnN; ErrorMsgStr = Except->GetMsgStr(); }
+            }
+        }
+    }
+    if (ErrorLnN < Lns) {
+        throw TQmExcept::New("Error parsing line " + TUInt64::GetStr(LnNV[ErrorLnN]) + ": " +
+            ErrorMsgStr + ", line content: [" + LnChAV[ErrorLnN] + "]");
+    }
+    return true;
+}
+
+void TStoreLoader::AddBatch(const TVec<PJsonVal>& RecValV) {
+    TUInt64V RecIdV; Store->AddRecs(RecValV, RecIdV, TriggerEvents);
+    Recs += RecIdV.Len();
+}
+
+uint64 TStoreLoader::Load() {
+    const uint64 StartRecs = Recs;
+    TVec<PJsonVal> RecValV;
+    while (ReadBatch(RecValV)) { AddBatch(RecValV); }
+    return Recs - StartRecs;
+}
+
 ///////////////////////////////
 // QMiner-Record
 PExcept TRec::FieldError(const int& FieldId, const TStr& TypeStr) const {
@@ -3520,6 +4047,268 @@ TStrV TFieldReader::GetDateRange() {
     return ValV;
 }
 
+///////////////////////////////
+// QMiner-Record-Id-Bitmap
+const int TRecIdBitmap::MxArrLen = 4096;
+const int TRecIdBitmap::BitsetWords = 1024;
+const int TRecIdBitmap::MnDenseRecs = 65536;
+
+bool TRecIdBitmap::TBlock::IsIn(const uint16& Low) const {
+    if (IsBitset()) { return ((BitV[Low >> 6].Val >> (Low & 63)) & 1) != 0; }
+    return ArrV.SearchBin(TUInt16(Low)) != -1;
+}
+
+void TRecIdBitmap::TBlock::ToBitset() {
+    if (IsBitset()) { return; }
+    BitV.Gen(BitsetWords); BitV.PutAll(0);
+    for (const TUInt16& Low : ArrV) {
+        BitV[Low.Val >> 6].Val |= ((uint64)1 << (Low.Val & 63));
+    }
+    ArrV.Clr();
+}
+
+void TRecIdBitmap::TBlock::Optimize() {
+    if (!IsBitset() || Cnt > MxArrLen) { return; }
+    ArrV.Gen(Cnt, 0);
+    for (int WordN = 0; WordN < BitsetWords; WordN++) {
+        uint64 Word = BitV[WordN];
+        while (Word != 0) {
+            const int BitN = GetBits((Word & (~Word + 1)) - 1);
+            ArrV.Add(TUInt16((uint16)(WordN * 64 + BitN)));
+            Word &= Word - 1;
+        }
+    }
+    BitV.Clr();
+}
+
+void TRecIdBitmap::TBlock::And(const TBlock& Block) {
+    if (!IsBitset() && !Block.IsBitset()) {
+        TVec<TUInt16> _ArrV; ArrV.Intrs(Block.ArrV, _ArrV);
+        ArrV = _ArrV; Cnt = ArrV.Len();
+    } else if (!IsBitset()) {
+        // keep only our elements present in the other bitset
+        TVec<TUInt16> _ArrV(ArrV.Len(), 0);
+        for (const TUInt16& Low : ArrV) {
+            if (Block.IsIn(Low)) { _ArrV.Add(Low); }
+        }
+        ArrV = _ArrV; Cnt = ArrV.Len();
+    } else if (!Block.IsBitset()) {
+        // result is subset of the other array
+        TVec<TUInt16> _ArrV(Block.ArrV.Len(), 0);
+        for (const TUInt16& Low : Block.ArrV) {
+            if (IsIn(Low)) { _ArrV.Add(Low); }
+        }
+        BitV.Clr(); ArrV = _ArrV; Cnt = ArrV.Len();
+    } else {
+        Cnt = 0;
+        for (int WordN = 0; WordN < BitsetWords; WordN++) {
+            BitV[WordN].Val &= Block.BitV[WordN].Val;
+            Cnt += GetBits(BitV[WordN]);
+        }
+        Optimize();
+    }
+}
+
+void TRecIdBitmap::TBlock::Or(const TBlock& Block) {
+    if (!IsBitset() && !Block.IsBitset() && (ArrV.Len() + Block.ArrV.Len() <= MxArrLen)) {
+        ArrV.Union(Block.ArrV); Cnt = ArrV.Len();
+    } else {
+        ToBitset(); Cnt = 0;
+        if (Block.IsBitset()) {
+            for (int WordN = 0; WordN < BitsetWords; WordN++) {
+                BitV[WordN].Val |= Block.BitV[WordN].Val;
+            }
+        } else {
+            for (const TUInt16& Low : Block.ArrV) {
+                BitV[Low.Val >> 6].Val |= ((uint64)1 << (Low.Val & 63));
+            }
+        }
+        for (int WordN = 0; WordN < BitsetWords; WordN++) { Cnt += GetBits(BitV[WordN]); }
+        Optimize();
+    }
+}
+
+void TRecIdBitmap::TBlock::AndNot(const TBlock& Block) {
+    if (!IsBitset()) {
+        TVec<TUInt16> _ArrV(ArrV.Len(), 0);
+        if (Block.IsBitset()) {
+            for (const TUInt16& Low : ArrV) {
+                if (!Block.IsIn(Low)) { _ArrV.Add(Low); }
+            }
+        } else {
+            ArrV.Diff(Block.ArrV, _ArrV);
+        }
+        ArrV = _ArrV; Cnt = ArrV.Len();
+    } else {
+        if (Block.IsBitset()) {
+            Cnt = 0;
+            for (int WordN = 0; WordN < BitsetWords; WordN++) {
+                BitV[WordN].Val &= ~Block.BitV[WordN].Val;
+                Cnt += GetBits(BitV[WordN]);
+            }
+        } else {
+            for (const TUInt16& Low : Block.ArrV) {
+                const uint64 Mask = (uint64)1 << (Low.Val & 63);
+                if ((BitV[Low.Val >> 6].Val & Mask) != 0) {
+                    BitV[Low.Val >> 6].Val &= ~Mask; Cnt--;
+                }
+            }
+        }
+        Optimize();
+    }
+}
+
+void TRecIdBitmap::TBlock::GetRecIdFqV(const uint64& High, TUInt64IntKdV& RecIdFqV) const {
+    const uint64 Base = High << 16;
+    if (IsBitset()) {
+        for (int WordN = 0; WordN < BitsetWords; WordN++) {
+            uint64 Word = BitV[WordN];
+            while (Word != 0) {
+                const int BitN = GetBits((Word & (~Word + 1)) - 1);
+                RecIdFqV.Add(TUInt64IntKd(Base + (uint64)(WordN * 64 + BitN), 1));
+                Word &= Word - 1;
+            }
+        }
+    } else {
+        for (const TUInt16& Low : ArrV) {
+            RecIdFqV.Add(TUInt64IntKd(Base + (uint64)Low.Val, 1));
+        }
+    }
+}
+
+uint64 TRecIdBitmap::TBlock::GetMemUsed() const {
+    return sizeof(TBlock) + (uint64)ArrV.Reserved() * sizeof(TUInt16) +
+        (uint64)BitV.Reserved() * sizeof(TUInt64);
+}
+
+int TRecIdBitmap::GetBits(const uint64& Word) {
+    // portable population count
+    uint64 X = Word - ((Word >> 1) & 0x5555555555555555ULL);
+    X = (X & 0x3333333333333333ULL) + ((X >> 2) & 0x3333333333333333ULL);
+    X = (X + (X >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((X * 0x0101010101010101ULL) >> 56);
+}
+
+void TRecIdBitmap::DelEmpty() {
+    int GoodN = 0;
+    for (int BlockN = 0; BlockN < BlockV.Len(); BlockN++) {
+        if (BlockV[BlockN].Cnt == 0) { continue; }
+        if (GoodN != BlockN) {
+            HighV[GoodN] = HighV[BlockN];
+            BlockV[GoodN] = BlockV[BlockN];
+        }
+        GoodN++;
+    }
+    HighV.Trunc(GoodN); BlockV.Trunc(GoodN);
+}
+
+TRecIdBitmap::TRecIdBitmap(const TUInt64IntKdV& RecIdFqV) {
+    const int Recs = RecIdFqV.Len();
+    int RecN = 0;
+    while (RecN < Recs) {
+        // collect all ids with the same upper bits
+        const uint64 High = RecIdFqV[RecN].Key.Val >> 16;
+        int EndN = RecN + 1;
+        while (EndN < Recs && (RecIdFqV[EndN].Key.Val >> 16) == High) { EndN++; }
+        HighV.Add(High);
+        TBlock& Block = BlockV[BlockV.Add()];
+        Block.Cnt = EndN - RecN;
+        if (Block.Cnt > MxArrLen) {
+            Block.BitV.Gen(BitsetWords); Block.BitV.PutAll(0);
+            for (int _RecN = RecN; _RecN < EndN; _RecN++) {
+                const uint64 Low = RecIdFqV[_RecN].Key.Val & 0xFFFF;
+                Block.BitV[(int)(Low >> 6)].Val |= ((uint64)1 << (Low & 63));
+            }
+        } else {
+            Block.ArrV.Gen(Block.Cnt, 0);
+            for (int _RecN = RecN; _RecN < EndN; _RecN++) {
+                Block.ArrV.Add(TUInt16((uint16)(RecIdFqV[_RecN].Key.Val & 0xFFFF)));
+            }
+        }
+        RecN = EndN;
+    }
+}
+
+bool TRecIdBitmap::IsDense(const TUInt64IntKdV& RecIdFqV) {
+    if (RecIdFqV.Len() < MnDenseRecs) { return false; }
+    // on average at least one record in 64 ids, so bitsets are not mostly empty
+    const uint64 Span = RecIdFqV.Last().Key - RecIdFqV[0].Key + 1;
+    return (uint64)RecIdFqV.Len() * 64 >= Span;
+}
+
+uint64 TRecIdBitmap::GetRecs() const {
+    uint64 Recs = 0;
+    for (const TBlock& Block : BlockV) { Recs += (uint64)Block.Cnt.Val; }
+    return Recs;
+}
+
+bool TRecIdBitmap::IsRecId(const uint64& RecId) const {
+    const int BlockN = HighV.SearchBin(RecId >> 16);
+    return (BlockN != -1) && BlockV[BlockN].IsIn((uint16)(RecId & 0xFFFF));
+}
+
+void TRecIdBitmap::And(const TRecIdBitmap& Bitmap) {
+    int BlockN = 0, _BlockN = 0;
+    while (BlockN < BlockV.Len()) {
+        // skip blocks from the other set which we do not have
+        while (_BlockN < Bitmap.BlockV.Len() && Bitmap.HighV[_BlockN] < HighV[BlockN]) { _BlockN++; }
+        if (_BlockN < Bitmap.BlockV.Len() && Bitmap.HighV[_BlockN] == HighV[BlockN]) {
+            BlockV[BlockN].And(Bitmap.BlockV[_BlockN]);
+        } else {
+            // no such block in the other set, nothing remains
+            BlockV[BlockN] = TBlock();
+        }
+        BlockN++;
+    }
+    DelEmpty();
+}
+
+void TRecIdBitmap::Or(const TRecIdBitmap& Bitmap) {
+    TUInt64V _HighV(HighV.Len() + Bitmap.HighV.Len(), 0);
+    TVec<TBlock> _BlockV(BlockV.Len() + Bitmap.BlockV.Len(), 0);
+    int BlockN = 0, _BlockN = 0;
+    while (BlockN < BlockV.Len() || _BlockN < Bitmap.BlockV.Len()) {
+        if (_BlockN == Bitmap.BlockV.Len() || (BlockN < BlockV.Len() && HighV[BlockN] < Bitmap.HighV[_BlockN])) {
+            _HighV.Add(HighV[BlockN]); _BlockV.Add(BlockV[BlockN]); BlockN++;
+        } else if (BlockN == BlockV.Len() || Bitmap.HighV[_BlockN] < HighV[BlockN]) {
+            _HighV.Add(Bitmap.HighV[_BlockN]); _BlockV.Add(Bitmap.BlockV[_BlockN]); _BlockN++;
+        } else {
+            _HighV.Add(HighV[BlockN]); _BlockV.Add(BlockV[BlockN]);
+            _BlockV.Last().Or(Bitmap.BlockV[_BlockN]);
+            BlockN++; _BlockN++;
+        }
+    }
+    HighV.Swap(_HighV); BlockV.Swap(_BlockV);
+}
+
+void TRecIdBitmap::AndNot(const TRecIdBitmap& Bitmap) {
+    int BlockN = 0, _BlockN = 0;
+    while (BlockN < BlockV.Len() && _BlockN < Bitmap.BlockV.Len()) {
+        if (Bitmap.HighV[_BlockN] < HighV[BlockN]) {
+            _BlockN++;
+        } else if (HighV[BlockN] < Bitmap.HighV[_BlockN]) {
+            BlockN++;
+        } else {
+            BlockV[BlockN].AndNot(Bitmap.BlockV[_BlockN]);
+            BlockN++; _BlockN++;
+        }
+    }
+    DelEmpty();
+}
+
+void TRecIdBitmap::GetRecIdFqV(TUInt64IntKdV& RecIdFqV) const {
+    RecIdFqV.Gen((int)GetRecs(), 0);
+    for (int BlockN = 0; BlockN < BlockV.Len(); BlockN++) {
+        BlockV[BlockN].GetRecIdFqV(HighV[BlockN], RecIdFqV);
+    }
+}
+
+uint64 TRecIdBitmap::GetMemUsed() const {
+    uint64 MemUsed = sizeof(TRecIdBitmap) + HighV.GetMemUsed();
+    for (const TBlock& Block : BlockV) { MemUsed += Block.GetMemUsed(); }
+    return MemUsed;
+}
+
 ///////////////////////////////
 // QMiner-ResultSet
 void TRecSet::GetSampleRecIdV(const int& SampleSize,
@@ -3708,74 +4497,155 @@ void TRecSet::SortByFq(const bool& Asc) {
 void TRecSet::SortByField(const bool& Asc, const int& SortFieldId) {
     // get store and field type
     const TFieldDesc& Desc = Store->GetFieldDesc(SortFieldId);
-    // apply appropriate comparator
-    if (Desc.IsInt()) {
-        typedef TKeyDat<TInt, TUInt64IntKd> TItem;
-        TVec<TItem> TItemV(RecIdFqV.Len());
-        for (int N = 0; N < RecIdFqV.Len(); N++) {
-            TItemV.SetVal(N, TItem(Store->GetFieldInt(RecIdFqV[N].Key, SortFieldId), RecIdFqV[N]));
-        }
-        TItemV.Sort(Asc);
-        for (int N = 0; N < TItemV.Len(); N++) {
-            RecIdFqV.SetVal(N, TItemV[N].Dat);
-        }
-    } else if (Desc.IsFlt()) {
-        typedef TKeyDat<TFlt, TUInt64IntKd> TItem;
+    // read sort keys directly from the column when field is kept in columnar layout
+    const TFieldColumn* Column = Store->GetFieldColumn(SortFieldId);
+    // values are read in order of record ids
+    TIntV RecNV; GetRecIdOrderV(RecNV);
+    if (Desc.IsStr()) {
+        // strings are compared directly, pairs also compare record ids of equal strings
+        TStrV ValV;
+        GetFieldValV(SortFieldId, RecNV, [&](const uint64& RecId) {
+            return Store->GetFieldStr(RecId, SortFieldId); }, ValV, NULL);
+        typedef TPair<TStr, TUInt64IntKd> TItem;
         TVec<TItem> TItemV(RecIdFqV.Len());
         for (int N = 0; N < RecIdFqV.Len(); N++) {
-            TItemV.SetVal(N, TItem(Store->GetFieldFlt(RecIdFqV[N].Key, SortFieldId), RecIdFqV[N]));
+            TItemV.SetVal(N, TItem(ValV[N], RecIdFqV[N]));
         }
         TItemV.Sort(Asc);
         for (int N = 0; N < TItemV.Len(); N++) {
-            RecIdFqV.SetVal(N, TItemV[N].Dat);
+            RecIdFqV.SetVal(N, TItemV[N].Val2);
         }
+        return;
+    }
+    // other values are mapped to unsigned integers with the same order
+    TUInt64V SortKeyV;
+    if (Desc.IsInt()) {
+        GetFieldValV(SortFieldId, RecNV, [&](const uint64& RecId) { return GetIntSortKey((Column != NULL) ?
+            Column->GetInt(RecId) : Store->GetFieldInt(RecId, SortFieldId)); }, SortKeyV, NULL);
+    } else if (Desc.IsInt16()) {
+        GetFieldValV(SortFieldId, RecNV, [&](const uint64& RecId) {
+            return GetIntSortKey(Store->GetFieldInt16(RecId, SortFieldId)); }, SortKeyV, NULL);
+    } else if (Desc.IsInt64()) {
+        GetFieldValV(SortFieldId, RecNV, [&](const uint64& RecId) { return GetIntSortKey((Column != NULL) ?
+            Column->GetInt64(RecId) : Store->GetFieldInt64(RecId, SortFieldId)); }, SortKeyV, NULL);
     } else if (Desc.IsByte()) {
-        typedef TKeyDat<TUCh, TUInt64IntKd> TItem;
-        TVec<TItem> TItemV(RecIdFqV.Len());
-        for (int N = 0; N < RecIdFqV.Len(); N++) {
-            TItemV.SetVal(N, TItem(Store->GetFieldByte(RecIdFqV[N].Key, SortFieldId), RecIdFqV[N]));
-        }
-        TItemV.Sort(Asc);
-        for (int N = 0; N < TItemV.Len(); N++) {
-            RecIdFqV.SetVal(N, TItemV[N].Dat);
-        }
-    } else if (Desc.IsStr()) {
-        typedef TKeyDat<TStr, TUInt64IntKd> TItem;
-        TVec<TItem> TItemV(RecIdFqV.Len());
-        for (int N = 0; N < RecIdFqV.Len(); N++) {
-            TItemV.SetVal(N, TItem(Store->GetFieldStr(RecIdFqV[N].Key, SortFieldId), RecIdFqV[N]));
-        }
-        TItemV.Sort(Asc);
-        for (int N = 0; N < TItemV.Len(); N++) {
-            RecIdFqV.SetVal(N, TItemV[N].Dat);
-        }
+        GetFieldValV(SortFieldId, RecNV, [&](const uint64& RecId) { return (uint64)((Column != NULL) ?
+            Column->GetByte(RecId) : Store->GetFieldByte(RecId, SortFieldId)); }, SortKeyV, NULL);
+    } else if (Desc.IsUInt()) {
+        GetFieldValV(SortFieldId, RecNV, [&](const uint64& RecId) {
+            return (uint64)Store->GetFieldUInt(RecId, SortFieldId); }, SortKeyV, NULL);
+    } else if (Desc.IsUInt16()) {
+        GetFieldValV(SortFieldId, RecNV, [&](const uint64& RecId) {
+            return (uint64)Store->GetFieldUInt16(RecId, SortFieldId); }, SortKeyV, NULL);
+    } else if (Desc.IsUInt64()) {
+        GetFieldValV(SortFieldId, RecNV, [&](const uint64& RecId) { return (Column != NULL) ?
+            Column->GetUInt64(RecId) : Store->GetFieldUInt64(RecId, SortFieldId); }, SortKeyV, NULL);
+    } else if (Desc.IsFlt()) {
+        GetFieldValV(SortFieldId, RecNV, [&](const uint64& RecId) { return GetFltSortKey((Column != NULL) ?
+            Column->GetFlt(RecId) : Store->GetFieldFlt(RecId, SortFieldId)); }, SortKeyV, NULL);
+    } else if (Desc.IsSFlt()) {
+        GetFieldValV(SortFieldId, RecNV, [&](const uint64& RecId) { return GetFltSortKey((Column != NULL) ?
+            Column->GetSFlt(RecId) : Store->GetFieldSFlt(RecId, SortFieldId)); }, SortKeyV, NULL);
     } else if (Desc.IsTm()) {
-        typedef TKeyDat<TUInt64, TUInt64IntKd> TItem;
-        TVec<TItem> TItemV(RecIdFqV.Len());
-        for (int N = 0; N < RecIdFqV.Len(); N++) {
-            TItemV.SetVal(N, TItem(Store->GetFieldTmMSecs(RecIdFqV[N].Key, SortFieldId), RecIdFqV[N]));
-        }
-        TItemV.Sort(Asc);
-        for (int N = 0; N < TItemV.Len(); N++) {
-            RecIdFqV.SetVal(N, TItemV[N].Dat);
-        }
+        GetFieldValV(SortFieldId, RecNV, [&](const uint64& RecId) { return (Column != NULL) ?
+            Column->GetTmMSecs(RecId) : Store->GetFieldTmMSecs(RecId, SortFieldId); }, SortKeyV, NULL);
     } else {
         throw TQmExcept::New("Unsupported sort field type!");
     }
+    SortBySortKeyV(RecNV, SortKeyV, Asc);
 }
 
-void TRecSet::FilterByExists() {
-    // apply filter
-    FilterBy<TRecFilterByExists>(TRecFilterByExists(Store->GetBase(), Store));
+int TRecSet::GetReadThreads() const {
+    // small sets are not worth starting the threads
+    const int MnThreadRecs = 8 * 1024;
+    if (GetRecs() < 2 * MnThreadRecs || !Store->IsConcurrentRead()) { return 1; }
+    return TInt::GetMx(TInt::GetMn(Store->GetBase()->GetQueryThreads(), GetRecs() / MnThreadRecs), 1);
 }
 
-void TRecSet::FilterByRecId(const uint64& MinRecId, const uint64& MaxRecId) {
-    // apply filter
-    FilterBy<TRecFilterByRecId>(TRecFilterByRecId(Store->GetBase(), MinRecId, MaxRecId));
+void TRecSet::GetRecIdOrderV(TIntV& RecNV) const {
+    RecNV.Clr();
+    // most record sets come from the index and are already sorted by id
+    const int Recs = GetRecs(); bool SortedP = true;
+    for (int RecN = 1; RecN < Recs && SortedP; RecN++) {
+        SortedP = (RecIdFqV[RecN - 1].Key <= RecIdFqV[RecN].Key);
+    }
+    if (SortedP) { return; }
+    TUInt64IntKdV RecIdRecNV(Recs);
+    for (int RecN = 0; RecN < Recs; RecN++) {
+        RecIdRecNV[RecN] = TUInt64IntKd(RecIdFqV[RecN].Key, RecN);
+    }
+    RadixSort(RecIdRecNV);
+    RecNV.Gen(Recs);
+    for (int N = 0; N < Recs; N++) { RecNV[N] = RecIdRecNV[N].Dat; }
 }
 
-void TRecSet::FilterByRecIdSet(const TUInt64Set& RecIdSet) {
-    // apply filter
+void TRecSet::SortBySortKeyV(const TIntV& RecNV, const TUInt64V& SortKeyV, const bool& Asc) {
+    const int Recs = GetRecs();
+    // start with records ordered by id, so stable sort keeps records with equal keys in that order
+    TUInt64IntKdV SortKeyRecNV(Recs);
+    for (int N = 0; N < Recs; N++) {
+        const int RecN = RecNV.Empty() ? N : RecNV[N].Val;
+        SortKeyRecNV[N] = TUInt64IntKd(SortKeyV[RecN], RecN);
+    }
+    RadixSort(SortKeyRecNV);
+    // descending order is the reverse of the ascending one, including records with equal keys
+    TUInt64IntKdV NewRecIdFqV(Recs);
+    for (int N = 0; N < Recs; N++) {
+        NewRecIdFqV[Asc ? N : (Recs - N - 1)] = RecIdFqV[SortKeyRecNV[N].Dat];
+    }
+    RecIdFqV = NewRecIdFqV;
+}
+
+void TRecSet::RadixSort(TUInt64IntKdV& SortKeyPosV) {
+    const int Vals = SortKeyPosV.Len();
+    if (Vals < 2) { return; }
+    // count values of all eight bytes in one pass
+    TIntV CountV(8 * 256);
+    for (const TUInt64IntKd& SortKeyPos : SortKeyPosV) {
+        const uint64 SortKey = SortKeyPos.Key.Val;
+        for (int ByteN = 0; ByteN < 8; ByteN++) {
+            CountV[ByteN * 256 + (int)((SortKey >> (8 * ByteN)) & 0xFF)].Val++;
+        }
+    }
+    // sort by one byte at a time, starting with the lowest
+    TUInt64IntKdV TmpV(Vals);
+    for (int ByteN = 0; ByteN < 8; ByteN++) {
+        const int Shift = 8 * ByteN;
+        TInt* PosV = CountV.BegI() + ByteN * 256;
+        // skip the byte when it is the same for all keys, common with small values
+        if (PosV[(int)((SortKeyPosV[0].Key.Val >> Shift) & 0xFF)] == Vals) { continue; }
+        // turn counts into positions of the first element with each value
+        int Pos = 0;
+        for (int Val = 0; Val < 256; Val++) {
+            const int Count = PosV[Val]; PosV[Val] = Pos; Pos += Count;
+        }
+        for (const TUInt64IntKd& SortKeyPos : SortKeyPosV) {
+            TmpV[PosV[(int)((SortKeyPos.Key.Val >> Shift) & 0xFF)].Val++] = SortKeyPos;
+        }
+        SortKeyPosV.Swap(TmpV);
+    }
+}
+
+uint64 TRecSet::GetFltSortKey(const double& Val) {
+    // zeros with both signs are equal
+    const double NormVal = (Val == 0.0) ? 0.0 : Val;
+    uint64 Bits; memcpy(&Bits, &NormVal, sizeof(uint64));
+    // negative numbers are ordered in reverse, so we flip all their bits
+    return ((Bits >> 63) != 0) ? ~Bits : (Bits | ((uint64)1 << 63));
+}
+
+void TRecSet::FilterByExists() {
+    // apply filter
+    FilterBy<TRecFilterByExists>(TRecFilterByExists(Store->GetBase(), Store));
+}
+
+void TRecSet::FilterByRecId(const uint64& MinRecId, const uint64& MaxRecId) {
+    // apply filter
+    FilterBy<TRecFilterByRecId>(TRecFilterByRecId(Store->GetBase(), MinRecId, MaxRecId));
+}
+
+void TRecSet::FilterByRecIdSet(const TUInt64Set& RecIdSet) {
+    // apply filter
     FilterBy<TRecFilterByRecId>(TRecFilterByRecId(Store->GetBase(), RecIdSet, true));
 }
 
@@ -3804,32 +4674,41 @@ void TRecSet::FilterByFieldInt(const int& FieldId, const int& MinVal, const int&
     // get store and field type
     const TFieldDesc& Desc = Store->GetFieldDesc(FieldId);
     QmAssertR(Desc.IsInt() || (Desc.IsStr() && Desc.IsCodebook()), "Wrong field type, integer or codebook string expected");
-    // apply the filter
-    FilterBy<TRecFilterByFieldInt>(TRecFilterByFieldInt(Store->GetBase(), FieldId, MinVal, MaxVal));
+    // scan the column directly when field is kept in columnar layout
+    const TFieldColumn* Column = Store->GetFieldColumn(FieldId);
+    if (Column != NULL) { Column->FilterInt(RecIdFqV, MinVal, MaxVal); return; }
+    // read values of all records once and check them together
+    FilterByFieldVal<int>(FieldId, [&](const uint64& RecId) { return Store->GetFieldInt(RecId, FieldId); }, MinVal, MaxVal);
 }
 
 void TRecSet::FilterByFieldInt16(const int& FieldId, const int16& MinVal, const int16& MaxVal) {
     // get store and field type
     const TFieldDesc& Desc = Store->GetFieldDesc(FieldId);
     QmAssertR(Desc.IsInt16(), "Wrong field type, 16bit integer expected");
-    // apply the filter
-    FilterBy<TRecFilterByFieldInt16>(TRecFilterByFieldInt16(Store->GetBase(), FieldId, MinVal, MaxVal));
+    // read values of all records once and check them together
+    FilterByFieldVal<int16>(FieldId, [&](const uint64& RecId) { return Store->GetFieldInt16(RecId, FieldId); }, MinVal, MaxVal);
 }
 
 void TRecSet::FilterByFieldInt64(const int& FieldId, const int64& MinVal, const int64& MaxVal) {
     // get store and field type
     const TFieldDesc& Desc = Store->GetFieldDesc(FieldId);
     QmAssertR(Desc.IsInt64(), "Wrong field type, 64bit integer expected");
-    // apply the filter
-    FilterBy<TRecFilterByFieldInt64>(TRecFilterByFieldInt64(Store->GetBase(), FieldId, MinVal, MaxVal));
+    // scan the column directly when field is kept in columnar layout
+    const TFieldColumn* Column = Store->GetFieldColumn(FieldId);
+    if (Column != NULL) { Column->FilterInt64(RecIdFqV, MinVal, MaxVal); return; }
+    // read values of all records once and check them together
+    FilterByFieldVal<int64>(FieldId, [&](const uint64& RecId) { return Store->GetFieldInt64(RecId, FieldId); }, MinVal, MaxVal);
 }
 
 void TRecSet::FilterByFieldByte(const int& FieldId, const uchar& MinVal, const uchar& MaxVal) {
     // get store and field type
     const TFieldDesc& Desc = Store->GetFieldDesc(FieldId);
     QmAssertR(Desc.IsByte(), "Wrong field type, byte expected");
-    // apply the filter
-    FilterBy<TRecFilterByFieldByte>(TRecFilterByFieldByte(Store->GetBase(), FieldId, MinVal, MaxVal));
+    // scan the column directly when field is kept in columnar layout
+    const TFieldColumn* Column = Store->GetFieldColumn(FieldId);
+    if (Column != NULL) { Column->FilterByte(RecIdFqV, MinVal, MaxVal); return; }
+    // read values of all records once and check them together
+    FilterByFieldVal<uchar>(FieldId, [&](const uint64& RecId) { return Store->GetFieldByte(RecId, FieldId); }, MinVal, MaxVal);
 }
 
 void TRecSet::FilterByFieldByteSet(const int& FieldId, const TUChSet& ValSet) {
@@ -3844,8 +4723,8 @@ void TRecSet::FilterByFieldUInt(const int& FieldId, const uint& MinVal, const ui
     // get store and field type
     const TFieldDesc& Desc = Store->GetFieldDesc(FieldId);
     QmAssertR(Desc.IsUInt(), "Wrong field type, unsigned integer expected");
-    // apply the filter
-    FilterBy<TRecFilterByFieldUInt>(TRecFilterByFieldUInt(Store->GetBase(), FieldId, MinVal, MaxVal));
+    // read values of all records once and check them together
+    FilterByFieldVal<uint>(FieldId, [&](const uint64& RecId) { return Store->GetFieldUInt(RecId, FieldId); }, MinVal, MaxVal);
 }
 
 void TRecSet::FilterByFieldUIntSet(const int& FieldId, const TUIntSet& ValSet) {
@@ -3860,32 +4739,41 @@ void TRecSet::FilterByFieldUInt16(const int& FieldId, const uint16& MinVal, cons
     // get store and field type
     const TFieldDesc& Desc = Store->GetFieldDesc(FieldId);
     QmAssertR(Desc.IsUInt16(), "Wrong field type, unsigned 16bit integer expected");
-    // apply the filter
-    FilterBy<TRecFilterByFieldUInt16>(TRecFilterByFieldUInt16(Store->GetBase(), FieldId, MinVal, MaxVal));
+    // read values of all records once and check them together
+    FilterByFieldVal<uint16>(FieldId, [&](const uint64& RecId) { return Store->GetFieldUInt16(RecId, FieldId); }, MinVal, MaxVal);
 }
 
 void TRecSet::FilterByFieldFlt(const int& FieldId, const double& MinVal, const double& MaxVal) {
     // get store and field type
     const TFieldDesc& Desc = Store->GetFieldDesc(FieldId);
     QmAssertR(Desc.IsFlt(), "Wrong field type, numeric expected");
-    // apply the filter
-    FilterBy<TRecFilterByFieldFlt>(TRecFilterByFieldFlt(Store->GetBase(), FieldId, MinVal, MaxVal));
+    // scan the column directly when field is kept in columnar layout
+    const TFieldColumn* Column = Store->GetFieldColumn(FieldId);
+    if (Column != NULL) { Column->FilterFlt(RecIdFqV, MinVal, MaxVal); return; }
+    // read values of all records once and check them together
+    FilterByFieldVal<double>(FieldId, [&](const uint64& RecId) { return Store->GetFieldFlt(RecId, FieldId); }, MinVal, MaxVal);
 }
 
 void TRecSet::FilterByFieldSFlt(const int& FieldId, const float& MinVal, const float& MaxVal) {
     // get store and field type
     const TFieldDesc& Desc = Store->GetFieldDesc(FieldId);
-    QmAssertR(Desc.IsFlt(), "Wrong field type, numeric expected");
-    // apply the filter
-    FilterBy<TRecFilterByFieldSFlt>(TRecFilterByFieldSFlt(Store->GetBase(), FieldId, MinVal, MaxVal));
+    QmAssertR(Desc.IsSFlt(), "Wrong field type, single precision number expected");
+    // scan the column directly when field is kept in columnar layout
+    const TFieldColumn* Column = Store->GetFieldColumn(FieldId);
+    if (Column != NULL) { Column->FilterSFlt(RecIdFqV, MinVal, MaxVal); return; }
+    // read values of all records once and check them together
+    FilterByFieldVal<float>(FieldId, [&](const uint64& RecId) { return Store->GetFieldSFlt(RecId, FieldId); }, MinVal, MaxVal);
 }
 
 void TRecSet::FilterByFieldUInt64(const int& FieldId, const uint64& MinVal, const uint64& MaxVal) {
     // get store and field type
     const TFieldDesc& Desc = Store->GetFieldDesc(FieldId);
     QmAssertR(Desc.IsUInt64(), "Wrong field type, unsigned 64bit integer expected");
-    // apply the filter
-    FilterBy<TRecFilterByFieldUInt64>(TRecFilterByFieldUInt64(Store->GetBase(), FieldId, MinVal, MaxVal));
+    // scan the column directly when field is kept in columnar layout
+    const TFieldColumn* Column = Store->GetFieldColumn(FieldId);
+    if (Column != NULL) { Column->FilterUInt64(RecIdFqV, MinVal, MaxVal); return; }
+    // read values of all records once and check them together
+    FilterByFieldVal<uint64>(FieldId, [&](const uint64& RecId) { return Store->GetFieldUInt64(RecId, FieldId); }, MinVal, MaxVal);
 }
 
 void TRecSet::FilterByFieldUInt64Set(const int& FieldId, const TUInt64Set& ValSet) {
@@ -3928,16 +4816,50 @@ void TRecSet::FilterByFieldTm(const int& FieldId, const uint64& MinVal, const ui
     // get store and field type
     const TFieldDesc& Desc = Store->GetFieldDesc(FieldId);
     QmAssertR(Desc.IsTm() || Desc.IsUInt64(), "Wrong field type, time expected");
-    // apply the filter
-    FilterBy<TRecFilterByFieldTm>(TRecFilterByFieldTm(Store->GetBase(), FieldId, MinVal, MaxVal));
+    // use time segments when store is partitioned over the field
+    TStoreSegmentV SegmentV;
+    if (Store->GetSegmentV(FieldId, SegmentV)) { FilterByFieldTmSegmentV(FieldId, SegmentV, MinVal, MaxVal); return; }
+    // scan the column directly when field is kept in columnar layout
+    const TFieldColumn* Column = Store->GetFieldColumn(FieldId);
+    if (Column != NULL) { Column->FilterUInt64(RecIdFqV, MinVal, MaxVal); return; }
+    // read values of all records once and check them together
+    FilterByFieldVal<uint64>(FieldId, [&](const uint64& RecId) { return Store->GetFieldTmMSecs(RecId, FieldId); }, MinVal, MaxVal);
+}
+
+void TRecSet::FilterByFieldTmSegmentV(const int& FieldId, const TStoreSegmentV& SegmentV,
+        const uint64& MinVal, const uint64& MaxVal) {
+
+    // segment time ranges do not tell if there are null values in them
+    const bool NullableP = Store->GetFieldDesc(FieldId).IsNullable();
+    const int Recs = GetRecs();
+    TUInt64IntKdV NewRecIdFqV(Recs, 0);
+    for (int RecN = 0; RecN < Recs; RecN++) {
+        const uint64 RecId = RecIdFqV[RecN].Key;
+        const int SegmentN = TStoreSegment::GetSegmentN(SegmentV, RecId);
+        if (SegmentN != -1) {
+            const TStoreSegment& Segment = SegmentV[SegmentN];
+            // segment entirely out of the range
+            if (Segment.MaxMSecs < MinVal || MaxVal < Segment.MinMSecs) { continue; }
+            // segment entirely within the range
+            if (!NullableP && MinVal <= Segment.MinMSecs && Segment.MaxMSecs <= MaxVal) {
+                NewRecIdFqV.Add(RecIdFqV[RecN]); continue;
+            }
+        }
+        // segment overlaps range boundary, check the value
+        if (Store->IsFieldNull(RecId, FieldId)) { continue; }
+        const uint64 RecVal = Store->GetFieldTmMSecs(RecId, FieldId);
+        if (MinVal <= RecVal && RecVal <= MaxVal) { NewRecIdFqV.Add(RecIdFqV[RecN]); }
+    }
+    RecIdFqV = NewRecIdFqV;
 }
 
 void TRecSet::FilterByFieldTm(const int& FieldId, const TTm& MinVal, const TTm& MaxVal) {
     // get store and field type
     const TFieldDesc& Desc = Store->GetFieldDesc(FieldId);
     QmAssertR(Desc.IsTm(), "Wrong field type, time expected");
-    // apply the filter
-    FilterBy<TRecFilterByFieldTm>(TRecFilterByFieldTm(Store->GetBase(), FieldId, MinVal, MaxVal));
+    // undefined time means no limit
+    FilterByFieldTm(FieldId, MinVal.IsDef() ? TTm::GetMSecsFromTm(MinVal) : (uint64)TUInt64::Mn,
+        MaxVal.IsDef() ? TTm::GetMSecsFromTm(MaxVal) : (uint64)TUInt64::Mx);
 }
 
 void TRecSet::FilterByFieldSafe(const int& FieldId, const uint64& MinVal, const uint64& MaxVal) {
@@ -4041,7 +4963,8 @@ PRecSet TRecSet::GetIntersect(const PRecSet& RecSet) {
     return new TRecSet(GetStore(), ResultRecIdFqV, false);
 }
 
-PRecSet TRecSet::DoJoin(const TWPt<TBase>& Base, const int& JoinId, const int& SampleSize, const bool& IgnoreFqP) const {
+PRecSet TRecSet::DoJoin(const TWPt<TBase>& Base, const int& JoinId,
+        const int& SampleSize, const bool& IgnoreFqP, const int& Threads) const {
     // get join info
     AssertR(Store->IsJoinId(JoinId), "Wrong Join ID");
     const TJoinDesc& JoinDesc = Store->GetJoinDesc(JoinId);
@@ -4062,26 +4985,43 @@ PRecSet TRecSet::DoJoin(const TWPt<TBase>& Base, const int& JoinId, const int& S
             RecIdV.Add(RecId);
         }
         // execute join query
-        Base->GetIndex()->SearchGixJoin(JoinKeyId, RecIdV, JoinRecIdFqV);
+        Base->GetIndex()->SearchGixJoin(JoinKeyId, RecIdV, JoinRecIdFqV, Threads);
     } else if (JoinDesc.IsFieldJoin()) {
-        // do join using store field
-        TUInt64H JoinRecIdFqH;
+        // do join using store field, each part reads every Parts-th record
         const int JoinRecFieldId = JoinDesc.GetJoinRecFieldId();
         const int JoinFqFieldId = JoinDesc.GetJoinFqFieldId();
-        for (int RecN = 0; RecN < SampleRecs; RecN++) {
-            const uint64 RecId = SampleRecIdKdV[RecN].Key;
-            if (!Store->IsFieldNull(RecId, JoinRecFieldId)) {
-                const uint64 JoinRecId = Store->GetFieldUInt64Safe(RecId, JoinRecFieldId);
-                int JoinRecFq = 1;
-                if (JoinFqFieldId >= 0) {
-                    JoinRecFq = (int) Store->GetFieldInt64Safe(RecId, JoinFqFieldId);
+        const int Parts = Store->IsConcurrentRead() ? TInt::GetMx(TInt::GetMn(Threads, SampleRecs), 1) : 1;
+        TVec<TUInt64IntKdV> PartRecIdFqVV(Parts);
+        int ErrorPartN = Parts; PExcept ErrorExcept;
+        #pragma omp parallel for schedule(static, 1) num_threads(Parts) if (Parts > 1)
+        for (int PartN = 0; PartN < Parts; PartN++) {
+            try {
+                TUInt64H JoinRecIdFqH;
+                for (int RecN = PartN; RecN < SampleRecs; RecN += Parts) {
+                    const uint64 RecId = SampleRecIdKdV[RecN].Key;
+                    if (!Store->IsFieldNull(RecId, JoinRecFieldId)) {
+                        const uint64 JoinRecId = Store->GetFieldUInt64Safe(RecId, JoinRecFieldId);
+                        int JoinRecFq = 1;
+                        if (JoinFqFieldId >= 0) {
+                            JoinRecFq = (int) Store->GetFieldInt64Safe(RecId, JoinFqFieldId);
+                        }
+                        JoinRecIdFqH.AddDat(JoinRecId) += JoinRecFq;
+                    }
+                }
+                JoinRecIdFqH.GetKeyDatKdV(PartRecIdFqVV[PartN]);
+                PartRecIdFqVV[PartN].Sort();
+            } catch (const PExcept& Except) {
+                #pragma omp critical
+                {
+                    if (PartN < ErrorPartN) { ErrorPartN = PartN; ErrorExcept = Except; }
                 }
-                JoinRecIdFqH.AddDat(JoinRecId) += JoinRecFq;
             }
         }
-        JoinRecIdFqH.GetKeyDatKdV(JoinRecIdFqV);
-        // make sure we are sorted so we are consistent with index join
-        JoinRecIdFqV.Sort();
+        if (!ErrorExcept.Empty()) { throw ErrorExcept; }
+        // sum counts from all parts, result is sorted so we are consistent with index join
+        for (const TUInt64IntKdV& PartRecIdFqV : PartRecIdFqVV) {
+            Base->GetIndex()->GetSumMerger()->Union(JoinRecIdFqV, PartRecIdFqV);
+        }
     } else {
         // unknown join type
         throw TQmExcept::New("Unsupported join type for join " + JoinDesc.GetJoinNm() + "!");
@@ -4221,85 +5161,201 @@ uint64 TIndexWordVoc::AddWordStr(const TStr& WordStr) {
     return (uint64)WordId;
 }
 
+const int TIndexWordVoc::MxSortTailLen = 1024;
+
+/// Compares word IDs by their string value
+class TIndexWordStrCmp {
+private:
+    const TStrHash<TInt>& WordH;
+public:
+    TIndexWordStrCmp(const TStrHash<TInt>& _WordH): WordH(_WordH) { }
+    bool operator()(const TInt& WordId1, const TInt& WordId2) const {
+        return strcmp(WordH.GetKey(WordId1), WordH.GetKey(WordId2)) < 0; }
+};
+
+void TIndexWordVoc::UpdateStrSortV() {
+    // new words since the last merge have IDs from StrSortWords on
+    const int Words = WordH.Len();
+    if (Words - StrSortWords <= MxSortTailLen) { return; }
+    TIndexWordStrCmp Cmp(WordH);
+    TIntV TailWordIdV(Words - StrSortWords, 0);
+    for (int WordId = StrSortWords; WordId < Words; WordId++) { TailWordIdV.Add(WordId); }
+    TailWordIdV.SortCmp(Cmp);
+    // merge sorted tail with already sorted words
+    TIntV NewSortWordIdV(Words, 0);
+    int SortN = 0, TailN = 0;
+    while (SortN < StrSortWordIdV.Len() && TailN < TailWordIdV.Len()) {
+        if (Cmp(TailWordIdV[TailN], StrSortWordIdV[SortN])) {
+            NewSortWordIdV.Add(TailWordIdV[TailN++]);
+        } else {
+            NewSortWordIdV.Add(StrSortWordIdV[SortN++]);
+        }
+    }
+    while (SortN < StrSortWordIdV.Len()) { NewSortWordIdV.Add(StrSortWordIdV[SortN++]); }
+    while (TailN < TailWordIdV.Len()) { NewSortWordIdV.Add(TailWordIdV[TailN++]); }
+    StrSortWordIdV = NewSortWordIdV;
+    StrSortWords = Words;
+}
+
+void TIndexWordVoc::UpdateFltSortV() {
+    const int Words = WordH.Len();
+    if (Words - FltSortWords <= MxSortTailLen) { return; }
+    TFltIntPrV TailWordV(Words - FltSortWords, 0);
+    for (int WordId = FltSortWords; WordId < Words; WordId++) {
+        TailWordV.Add(TFltIntPr(TStr(WordH.GetKey(WordId)).GetFlt(), WordId));
+    }
+    TailWordV.Sort();
+    // merge sorted tail with already sorted words
+    TFltIntPrV NewSortWordV(Words, 0);
+    int SortN = 0, TailN = 0;
+    while (SortN < FltSortWordIdV.Len() && TailN < TailWordV.Len()) {
+        if (TailWordV[TailN] < FltSortWordIdV[SortN]) {
+            NewSortWordV.Add(TailWordV[TailN++]);
+        } else {
+            NewSortWordV.Add(FltSortWordIdV[SortN++]);
+        }
+    }
+    while (SortN < FltSortWordIdV.Len()) { NewSortWordV.Add(FltSortWordIdV[SortN++]); }
+    while (TailN < TailWordV.Len()) { NewSortWordV.Add(TailWordV[TailN++]); }
+    FltSortWordIdV = NewSortWordV;
+    FltSortWords = Words;
+}
+
+int TIndexWordVoc::GetStrSortN(const char* CStr, const bool& UpperP) const {
+    int LeftN = 0, RightN = StrSortWordIdV.Len();
+    while (LeftN < RightN) {
+        const int MidN = (LeftN + RightN) / 2;
+        const int Cmp = strcmp(WordH.GetKey(StrSortWordIdV[MidN]), CStr);
+        if (Cmp < 0 || (UpperP && Cmp == 0)) { LeftN = MidN + 1; } else { RightN = MidN; }
+    }
+    return LeftN;
+}
+
+int TIndexWordVoc::GetFltSortN(const double& Flt, const bool& UpperP) const {
+    int LeftN = 0, RightN = FltSortWordIdV.Len();
+    while (LeftN < RightN) {
+        const int MidN = (LeftN + RightN) / 2;
+        const double MidFlt = FltSortWordIdV[MidN].Val1;
+        if (MidFlt < Flt || (UpperP && MidFlt == Flt)) { LeftN = MidN + 1; } else { RightN = MidN; }
+    }
+    return LeftN;
+}
+
 void TIndexWordVoc::GetWcWordIdV(const TStr& WcStr, TUInt64V& WcWordIdV) {
     WcWordIdV.Clr();
-    int WordId = WordH.FFirstKeyId();
-    while (WordH.FNextKeyId(WordId)) {
-        TStr WordStr = WordH.GetKey(WordId);
-        if (WordStr.IsWcMatch(WcStr, '*', '?')) {
+    // literal prefix in front of the first wildcard
+    int PrefixLen = 0;
+    while (PrefixLen < WcStr.Len() && WcStr[PrefixLen] != '*' && WcStr[PrefixLen] != '?') { PrefixLen++; }
+    if (PrefixLen == 0) {
+        // no prefix to narrow down the search, check all the words
+        int WordId = WordH.FFirstKeyId();
+        while (WordH.FNextKeyId(WordId)) {
+            TStr WordStr = WordH.GetKey(WordId);
+            if (WordStr.IsWcMatch(WcStr, '*', '?')) {
+                WcWordIdV.Add((uint64)WordId);
+            }
+        }
+        return;
+    }
+    const TStr PrefixStr = WcStr.GetSubStr(0, PrefixLen - 1);
+    TLock Lock(SortSection);
+    UpdateStrSortV();
+    // words with the prefix form a continuous block in sorted vector
+    for (int SortN = GetStrSortN(PrefixStr.CStr(), false); SortN < StrSortWordIdV.Len(); SortN++) {
+        const int WordId = StrSortWordIdV[SortN];
+        const char* WordCStr = WordH.GetKey(WordId);
+        if (strncmp(WordCStr, PrefixStr.CStr(), PrefixLen) != 0) { break; }
+        if (TStr(WordCStr).IsWcMatch(WcStr, '*', '?')) {
             WcWordIdV.Add((uint64)WordId);
         }
     }
+    // words not yet in sorted vector
+    for (int WordId = StrSortWords; WordId < WordH.Len(); WordId++) {
+        const char* WordCStr = WordH.GetKey(WordId);
+        if (strncmp(WordCStr, PrefixStr.CStr(), PrefixLen) == 0 && TStr(WordCStr).IsWcMatch(WcStr, '*', '?')) {
+            WcWordIdV.Add((uint64)WordId);
+        }
+    }
+    WcWordIdV.Sort();
 }
 
 void TIndexWordVoc::GetAllGreaterById(const uint64& StartWordId, TUInt64V& AllGreaterV) {
     AllGreaterV.Clr();
-    int WordId = WordH.FFirstKeyId();
-    while (WordH.FNextKeyId(WordId)) {
-        if ((uint64)WordId > StartWordId) {
-            AllGreaterV.Add((uint64)WordId);
-        }
+    for (uint64 WordId = StartWordId + 1; WordId < GetWords(); WordId++) {
+        AllGreaterV.Add(WordId);
     }
 }
 
 void TIndexWordVoc::GetAllGreaterByStr(const uint64& StartWordId, TUInt64V& AllGreaterV) {
     AllGreaterV.Clr();
-    TStr StartWordStr = WordH.GetKey((int)StartWordId);
-    int WordId = WordH.FFirstKeyId();
-    while (WordH.FNextKeyId(WordId)) {
-        TStr WordStr = WordH.GetKey(WordId);
-        if (WordStr > StartWordStr) {
+    const char* StartWordCStr = WordH.GetKey((int)StartWordId);
+    TLock Lock(SortSection);
+    UpdateStrSortV();
+    for (int SortN = GetStrSortN(StartWordCStr, true); SortN < StrSortWordIdV.Len(); SortN++) {
+        AllGreaterV.Add((uint64)StrSortWordIdV[SortN]);
+    }
+    for (int WordId = StrSortWords; WordId < WordH.Len(); WordId++) {
+        if (strcmp(WordH.GetKey(WordId), StartWordCStr) > 0) {
             AllGreaterV.Add((uint64)WordId);
         }
     }
+    AllGreaterV.Sort();
 }
 
 void TIndexWordVoc::GetAllGreaterByFlt(const uint64& StartWordId, TUInt64V& AllGreaterV) {
     AllGreaterV.Clr();
-    TStr StartWordStr = WordH.GetKey((int)StartWordId);
-    TFlt StartWordFlt = StartWordStr.GetFlt();
-    int WordId = WordH.FFirstKeyId();
-    while (WordH.FNextKeyId(WordId)) {
-        TStr WordStr = WordH.GetKey(WordId);
-        TFlt WordFlt = WordStr.GetFlt();
-        if (WordFlt > StartWordFlt) {
+    const double StartWordFlt = TStr(WordH.GetKey((int)StartWordId)).GetFlt();
+    TLock Lock(SortSection);
+    UpdateFltSortV();
+    for (int SortN = GetFltSortN(StartWordFlt, true); SortN < FltSortWordIdV.Len(); SortN++) {
+        AllGreaterV.Add((uint64)FltSortWordIdV[SortN].Val2);
+    }
+    for (int WordId = FltSortWords; WordId < WordH.Len(); WordId++) {
+        if (TStr(WordH.GetKey(WordId)).GetFlt() > StartWordFlt) {
             AllGreaterV.Add((uint64)WordId);
         }
     }
+    AllGreaterV.Sort();
 }
 
-
 void TIndexWordVoc::GetAllLessById(const uint64& StartWordId, TUInt64V& AllLessV) {
-    int WordId = WordH.FFirstKeyId();
-    while (WordH.FNextKeyId(WordId)) {
-        if ((uint64)WordId < StartWordId) {
-            AllLessV.Add((uint64)WordId);
-        }
+    for (uint64 WordId = 0; WordId < StartWordId && WordId < GetWords(); WordId++) {
+        AllLessV.Add(WordId);
     }
 }
 
 void TIndexWordVoc::GetAllLessByStr(const uint64& StartWordId, TUInt64V& AllLessV) {
-    TStr StartWordStr = WordH.GetKey((int)StartWordId);
-    int WordId = WordH.FFirstKeyId();
-    while (WordH.FNextKeyId(WordId)) {
-        TStr WordStr = WordH.GetKey(WordId);
-        if (WordStr < StartWordStr) {
-            AllLessV.Add((uint64)WordId);
+    const char* StartWordCStr = WordH.GetKey((int)StartWordId);
+    TUInt64V LessV;
+    TLock Lock(SortSection);
+    UpdateStrSortV();
+    const int EndSortN = GetStrSortN(StartWordCStr, false);
+    for (int SortN = 0; SortN < EndSortN; SortN++) {
+        LessV.Add((uint64)StrSortWordIdV[SortN]);
+    }
+    for (int WordId = StrSortWords; WordId < WordH.Len(); WordId++) {
+        if (strcmp(WordH.GetKey(WordId), StartWordCStr) < 0) {
+            LessV.Add((uint64)WordId);
         }
     }
+    LessV.Sort(); AllLessV.AddV(LessV);
 }
 
 void TIndexWordVoc::GetAllLessByFlt(const uint64& StartWordId, TUInt64V& AllLessV) {
-    TStr StartWordStr = WordH.GetKey((int)StartWordId);
-    TFlt StartWordFlt = StartWordStr.GetFlt();
-    int WordId = WordH.FFirstKeyId();
-    while (WordH.FNextKeyId(WordId)) {
-        TStr WordStr = WordH.GetKey(WordId);
-        TFlt WordFlt = WordStr.GetFlt();
-        if (WordFlt < StartWordFlt) {
-            AllLessV.Add((uint64)WordId);
+    const double StartWordFlt = TStr(WordH.GetKey((int)StartWordId)).GetFlt();
+    TUInt64V LessV;
+    TLock Lock(SortSection);
+    UpdateFltSortV();
+    const int EndSortN = GetFltSortN(StartWordFlt, false);
+    for (int SortN = 0; SortN < EndSortN; SortN++) {
+        LessV.Add((uint64)FltSortWordIdV[SortN].Val2);
+    }
+    for (int WordId = FltSortWords; WordId < WordH.Len(); WordId++) {
+        if (TStr(WordH.GetKey(WordId)).GetFlt() < StartWordFlt) {
+            LessV.Add((uint64)WordId);
         }
     }
+    LessV.Sort(); AllLessV.AddV(LessV);
 }
 
 ///////////////////////////////
@@ -4595,6 +5651,12 @@ void TIndexVoc::SaveTxt(const TWPt<TBase>& Base, const TStr& FNm) const {
 
 ///////////////////////////////
 // QMiner-Query-Item
+TFltPr TQueryItem::ParseLoc(const PJsonVal& LocVal, const TStr& OpNm) {
+    QmAssertR(LocVal->IsArr(), OpNm + " requires array with two coordinates");
+    QmAssertR(LocVal->GetArrVals() == 2, OpNm + " requires array with two coordinates");
+    return TFltPr(LocVal->GetArrVal(0)->GetNum(), LocVal->GetArrVal(1)->GetNum());
+}
+
 void TQueryItem::ParseWordStr(const TStr& WordStr, const TWPt<TIndexVoc>& IndexVoc) {
     // if text key, tokenize the word string
     if (IndexVoc->GetKey(KeyId).IsText() || IndexVoc->GetKey(KeyId).IsTextPos()) {
@@ -4755,6 +5817,7 @@ void TQueryItem::ParseKeys(const TWPt<TBase>& Base, const TWPt<TStore>& Store,
             } else if (KeyNm == "$sort") {
             } else if (KeyNm == "$limit") {
             } else if (KeyNm == "$offset") {
+            } else if (KeyNm == "$parallel") {
             } else {
                 throw TQmExcept::New("Query: unknown parameter " + KeyNm);
             }
@@ -4931,10 +5994,7 @@ TQueryItem::TQueryItem(const TWPt<TBase>& Base, const TWPt<TStore>& Store, const
             // we are hiting location index
             Type = oqitGeo;
             // we have a location query, parse out location
-            PJsonVal LocVal = KeyVal->GetObjKey("$location");
-            QmAssertR(LocVal->IsArr(), "$location requires array with two coordinates");
-            QmAssertR(LocVal->GetArrVals() == 2, "$location requires array with two coordinates");
-            Loc.Val1 = LocVal->GetArrVal(0)->GetNum(); Loc.Val2 = LocVal->GetArrVal(1)->GetNum();
+            Loc = ParseLoc(KeyVal->GetObjKey("$location"), "$location");
             // default values for parameters
             LocRadius = -1.0; LocLimit = 100;
             // parase out additional parameters
@@ -4947,6 +6007,34 @@ TQueryItem::TQueryItem(const TWPt<TBase>& Base, const TWPt<TStore>& Store, const
                 LocLimit = TFlt::Round(RadiusVal->GetNum());
                 if (LocLimit <= 0) { throw TQmExcept::New("Query: $limit must be greater then zero"); }
             }
+        } else if (KeyVal->IsObj() && (KeyVal->IsObjKey("$box") || KeyVal->IsObjKey("$polygon"))) {
+            // we are hiting location index with an area query
+            Type = oqitGeo;
+            if (KeyVal->IsObjKey("$box")) {
+                // box is given by south-west and north-east corner
+                PJsonVal BoxVal = KeyVal->GetObjKey("$box");
+                QmAssertR(BoxVal->IsArr() && BoxVal->GetArrVals() == 2,
+                    "$box requires array with south-west and north-east corner");
+                LocAreaV.Add(ParseLoc(BoxVal->GetArrVal(0), "$box"));
+                LocAreaV.Add(ParseLoc(BoxVal->GetArrVal(1), "$box"));
+                QmAssertR(LocAreaV[0].Val1 <= LocAreaV[1].Val1 && LocAreaV[0].Val2 <= LocAreaV[1].Val2,
+                    "$box requires south-west corner before north-east corner");
+            } else {
+                PJsonVal PolygonVal = KeyVal->GetObjKey("$polygon");
+                QmAssertR(PolygonVal->IsArr() && PolygonVal->GetArrVals() >= 3,
+                    "$polygon requires array with at least three vertices");
+                for (int LocN = 0; LocN < PolygonVal->GetArrVals(); LocN++) {
+                    LocAreaV.Add(ParseLoc(PolygonVal->GetArrVal(LocN), "$polygon"));
+                }
+            }
+            // when limited, we keep records nearest to the center of the area
+            TFltPr MinLoc, MaxLoc; TGeoIndex::GetAreaBox(LocAreaV, MinLoc, MaxLoc);
+            Loc = TFltPr((MinLoc.Val1 + MaxLoc.Val1) / 2.0, (MinLoc.Val2 + MaxLoc.Val2) / 2.0);
+            LocRadius = -1.0; LocLimit = TInt::Mx;
+            if (KeyVal->IsObjKey("$limit")) {
+                LocLimit = TFlt::Round(KeyVal->GetObjKey("$limit")->GetNum());
+                if (LocLimit <= 0) { throw TQmExcept::New("Query: $limit must be greater then zero"); }
+            }
         } else {
             throw TQmExcept::New("Query: invalid value for location key: '" + TJsonVal::GetStrFromVal(KeyVal) + "'");
         }
@@ -5254,6 +6342,102 @@ void TQueryItem::GetKeyWordV(TKeyWordV& KeyWordPrV) const {
     }
 }
 
+bool TQueryItem::IsCacheable() const {
+    // records given by value have no store version to check against
+    if (!IsDef() || IsRec() || IsRecSet()) { return false; }
+    // sampled joins draw a new sample every time
+    if (IsJoin() && SampleSize != -1) { return false; }
+    for (const TQueryItem& Item : ItemV) {
+        if (!Item.IsCacheable()) { return false; }
+    }
+    return true;
+}
+
+TStr TQueryItem::GetTypeStr() const {
+    if (IsGix()) { return "gix"; }
+    if (IsTextPos()) { return "textPos"; }
+    if (IsGeo()) { return "geo"; }
+    if (IsRange()) { return "range"; }
+    if (IsAnd()) { return "and"; }
+    if (IsOr()) { return "or"; }
+    if (IsNot()) { return "not"; }
+    if (IsJoin()) { return "join"; }
+    if (IsRecSet()) { return "recSet"; }
+    if (IsRec()) { return "rec"; }
+    if (IsStore()) { return "store"; }
+    return "undef";
+}
+
+bool TQueryItem::IsConcurrent(const TWPt<TBase>& Base) const {
+    // record sets given by value can be shared between items
+    if (IsRecSet()) { return false; }
+    // store items read all records, joins read source records, ranges can be probed on records
+    if (IsStore() && !Base->GetStoreByStoreId(StoreId)->IsConcurrentRead()) { return false; }
+    if (IsRange() && !GetStore(Base)->IsConcurrentRead()) { return false; }
+    if (IsJoin() && !ItemV[0].GetStore(Base)->IsConcurrentRead()) { return false; }
+    for (const TQueryItem& Item : ItemV) {
+        if (!Item.IsConcurrent(Base)) { return false; }
+    }
+    return true;
+}
+
+TStr TQueryItem::GetCacheKey(const TWPt<TBase>& Base, TUIntSet& StoreIdSet) const {
+    // parameters of the item
+    TMem KeyMem;
+    KeyMem.AddBf(&Type, sizeof(Type));
+    if (IsGix() || IsTextPos() || IsGeo() || IsRange()) {
+        KeyMem.AddBf(&KeyId, sizeof(KeyId));
+        StoreIdSet.AddKey(Base->GetIndexVoc()->GetKey(KeyId).GetStoreId());
+    }
+    if (IsGix() || IsTextPos()) {
+        const int Words = WordIdV.Len();
+        KeyMem.AddBf(&Words, sizeof(Words));
+        KeyMem.AddBf(WordIdV.BegI(), Words * sizeof(TUInt64));
+        KeyMem.AddBf(&CmpType, sizeof(CmpType));
+        KeyMem.AddBf(&MaxPosDiff, sizeof(MaxPosDiff));
+    } else if (IsGeo()) {
+        KeyMem.AddBf(&Loc, sizeof(Loc));
+        KeyMem.AddBf(&LocRadius, sizeof(LocRadius));
+        KeyMem.AddBf(&LocLimit, sizeof(LocLimit));
+        const int AreaLocs = LocAreaV.Len();
+        KeyMem.AddBf(&AreaLocs, sizeof(AreaLocs));
+        KeyMem.AddBf(LocAreaV.BegI(), AreaLocs * sizeof(TFltPr));
+    } else if (IsRange()) {
+        KeyMem.AddBf(&RangeIntMnMx, sizeof(RangeIntMnMx));
+        KeyMem.AddBf(&RangeInt16MnMx, sizeof(RangeInt16MnMx));
+        KeyMem.AddBf(&RangeInt64MnMx, sizeof(RangeInt64MnMx));
+        KeyMem.AddBf(&RangeUChMnMx, sizeof(RangeUChMnMx));
+        KeyMem.AddBf(&RangeUIntMnMx, sizeof(RangeUIntMnMx));
+        KeyMem.AddBf(&RangeUInt16MnMx, sizeof(RangeUInt16MnMx));
+        KeyMem.AddBf(&RangeUInt64MnMx, sizeof(RangeUInt64MnMx));
+        KeyMem.AddBf(&RangeFltMnMx, sizeof(RangeFltMnMx));
+        KeyMem.AddBf(&RangeSFltMnMx, sizeof(RangeSFltMnMx));
+    } else if (IsStore()) {
+        KeyMem.AddBf(&StoreId, sizeof(StoreId));
+        StoreIdSet.AddKey(StoreId);
+    } else if (IsJoin()) {
+        KeyMem.AddBf(&JoinId, sizeof(JoinId));
+        KeyMem.AddBf(&SampleSize, sizeof(SampleSize));
+        StoreIdSet.AddKey(GetStoreId(Base));
+    }
+    // subordinate items; order of AND and OR operands does not change the result
+    TStrV ItemKeyV;
+    for (const TQueryItem& Item : ItemV) {
+        ItemKeyV.Add(Item.GetCacheKey(Base, StoreIdSet));
+    }
+    if (IsAnd() || IsOr()) { ItemKeyV.Sort(); }
+    TChA KeyChA = KeyMem.GetHexStr();
+    if (!ItemKeyV.Empty()) {
+        KeyChA += '(';
+        for (int ItemN = 0; ItemN < ItemKeyV.Len(); ItemN++) {
+            if (ItemN > 0) { KeyChA += ','; }
+            KeyChA += ItemKeyV[ItemN];
+        }
+        KeyChA += ')';
+    }
+    return KeyChA;
+}
+
 void TQueryItem::Optimize() {
     for (TQueryItem& Child : ItemV) {
         // optimize down the tree
@@ -5314,7 +6498,7 @@ void TQueryAggr::LoadJson(const TWPt<TBase>& Base, const TWPt<TStore>& Store,
 TQuery::TQuery(const TWPt<TBase>& Base, const TQueryItem& _QueryItem,
     const int& _SortFieldId, const bool& _SortAscP, const int& _Limit,
     const int& _Offset) : QueryItem(_QueryItem), SortFieldId(_SortFieldId),
-    SortAscP(_SortAscP), Limit(_Limit), Offset(_Offset) {}
+    SortAscP(_SortAscP), SortRelevanceP(false), Limit(_Limit), Offset(_Offset), Threads(-1) {}
 
 PQuery TQuery::New(const TWPt<TBase>& Base, const TQueryItem& QueryItem,
     const int& SortFieldId, const bool& SortAscP, const int& Limit, const int& Offset) {
@@ -5332,15 +6516,21 @@ PQuery TQuery::New(const TWPt<TBase>& Base, const PJsonVal& JsonVal) {
     // check if we have any sorting
     if (JsonVal->IsObjKey("$sort")) {
         PJsonVal SortVal = JsonVal->GetObjKey("$sort");
-        QmAssert(SortVal->IsObj() && SortVal->GetObjKeys() == 1);
-        // parse field id
-        TStr FieldNm; PJsonVal AscVal; SortVal->GetObjKeyVal(0, FieldNm, AscVal);
-        TWPt<TStore> Store = Query->GetStore(Base);
-        QmAssert(Store->IsFieldNm(FieldNm));
-        Query->SortFieldId = Store->GetFieldId(FieldNm);
-        // parse sort direction
-        QmAssert(AscVal->IsNum());
-        Query->SortAscP = (AscVal->GetNum() > 0.0);
+        if (SortVal->IsStr()) {
+            // sort by relevance, allows top-k search when combined with $limit
+            QmAssertR(SortVal->GetStr() == "relevance", "Query: unsupported $sort '" + SortVal->GetStr() + "'");
+            Query->SortRelevanceP = true;
+        } else {
+            QmAssert(SortVal->IsObj() && SortVal->GetObjKeys() == 1);
+            // parse field id
+            TStr FieldNm; PJsonVal AscVal; SortVal->GetObjKeyVal(0, FieldNm, AscVal);
+            TWPt<TStore> Store = Query->GetStore(Base);
+            QmAssert(Store->IsFieldNm(FieldNm));
+            Query->SortFieldId = Store->GetFieldId(FieldNm);
+            // parse sort direction
+            QmAssert(AscVal->IsNum());
+            Query->SortAscP = (AscVal->GetNum() > 0.0);
+        }
     }
     // check if ther is any limit
     if (JsonVal->IsObjKey("$limit")) {
@@ -5350,6 +6540,12 @@ PQuery TQuery::New(const TWPt<TBase>& Base, const PJsonVal& JsonVal) {
     if (JsonVal->IsObjKey("$offset")) {
         Query->Offset = TFlt::Round(JsonVal->GetObjNum("$offset"));
     }
+    // check if number of threads is given
+    if (JsonVal->IsObjKey("$parallel")) {
+        const int Threads = TFlt::Round(JsonVal->GetObjNum("$parallel"));
+        QmAssertR(Threads > 0, "Query: $parallel must be a positive number of threads");
+        Query->Threads = Threads;
+    }
     Query->Optimize();
     return Query;
 }
@@ -5370,7 +6566,12 @@ TWPt<TStore> TQuery::GetStore(const TWPt<TBase>& Base) {
 }
 
 void TQuery::Sort(const TWPt<TBase>& Base, const PRecSet& RecSet) {
-    RecSet->SortByField(SortAscP, SortFieldId);
+    if (SortRelevanceP) {
+        // most relevant records first
+        RecSet->SortByFq(false);
+    } else {
+        RecSet->SortByField(SortAscP, SortFieldId);
+    }
 }
 
 PRecSet TQuery::GetLimit(const PRecSet& RecSet) {
@@ -5387,6 +6588,73 @@ bool TQuery::IsOk(const TWPt<TBase>& Base, TStr& MsgStr) const {
     }
 }
 
+///////////////////////////////
+// Query-Cache
+uint64 TQueryCache::TItem::GetMemUsed() const {
+    return sizeof(TItem) + sizeof(TRecSet) +
+        (uint64)RecSet->GetRecIdFqV().Reserved() * sizeof(TUInt64IntKd) +
+        (uint64)StoreVerV.Reserved() * sizeof(TUIntUInt64Pr);
+}
+
+void TQueryCache::TItem::OnDelFromCache(const TStr& Key, void* QueryCache) {
+    ((TQueryCache*)QueryCache)->MemUsed -= Key.GetMemUsed() + GetMemUsed();
+}
+
+TQueryCache::TQueryCache(const int64& MxMemUsed): Cache(MxMemUsed, 1024, NULL) {
+    Cache.PutRefToBs(this);
+}
+
+bool TQueryCache::Get(const TWPt<TBase>& Base, const TStr& Key, TPair<TBool, PRecSet>& NotRecSet) {
+    TLock Lock(CacheSection);
+    PItem Item;
+    if (!Cache.Get(Key, Item)) { Misses++; return false; }
+    // check if any of the stores changed since the result was computed
+    for (const TUIntUInt64Pr& StoreVer : Item->StoreVerV) {
+        if (Base->GetStoreByStoreId(StoreVer.Val1)->GetVersion() != StoreVer.Val2) {
+            Cache.Del(Key); Misses++; return false;
+        }
+    }
+    // move to the front of the LRU list
+    Cache.Put(Key, Item); Hits++;
+    NotRecSet = TPair<TBool, PRecSet>(Item->NotP, Item->RecSet->Clone());
+    return true;
+}
+
+void TQueryCache::Put(const TWPt<TBase>& Base, const TStr& Key, const TUIntSet& StoreIdSet,
+        const TPair<TBool, PRecSet>& NotRecSet) {
+
+    TLock Lock(CacheSection);
+    PItem Item = new TItem(NotRecSet.Val1, NotRecSet.Val2->Clone());
+    int KeyId = StoreIdSet.FFirstKeyId();
+    while (StoreIdSet.FNextKeyId(KeyId)) {
+        const uint StoreId = StoreIdSet.GetKey(KeyId);
+        Item->StoreVerV.Add(TUIntUInt64Pr(StoreId, Base->GetStoreByStoreId(StoreId)->GetVersion()));
+    }
+    // results larger than the whole cache would only flush it
+    const uint64 ItemMemUsed = Key.GetMemUsed() + Item->GetMemUsed();
+    if ((int64)ItemMemUsed > Cache.GetMxMemUsed()) { return; }
+    // replace existing stale item
+    Cache.Del(Key);
+    Cache.Put(Key, Item);
+    MemUsed += ItemMemUsed;
+}
+
+void TQueryCache::Clr() {
+    TLock Lock(CacheSection);
+    Cache.FlushAndClr(); MemUsed = 0;
+}
+
+PJsonVal TQueryCache::GetStats() const {
+    TLock Lock(CacheSection);
+    PJsonVal StatsVal = TJsonVal::NewObj();
+    StatsVal->AddToObj("hits", (double)Hits.Val);
+    StatsVal->AddToObj("misses", (double)Misses.Val);
+    StatsVal->AddToObj("items", Cache.Len());
+    StatsVal->AddToObj("memUsed", (double)MemUsed.Val);
+    StatsVal->AddToObj("maxMemUsed", (double)Cache.GetMxMemUsed());
+    return StatsVal;
+}
+
 ///////////////////////////////
 // GeoIndex
 TIntPr TGeoIndex::GetLocId(const TFltPr& Loc) const {
@@ -5458,11 +6726,268 @@ void TGeoIndex::SearchNn(const TFltPr& Loc, const int& Limit, TUInt64V& RecIdV)
     LocKeyIdToRecId(LocKeyIdV, Limit, RecIdV);
 }
 
+void TGeoIndex::SearchArea(const TFltPrV& AreaV, const TFltPr& Loc,
+        const int& Limit, TUInt64V& RecIdV) const {
+
+    TFltPr MinLoc, MaxLoc; GetAreaBox(AreaV, MinLoc, MaxLoc);
+    // circle around box center through its farthest corner contains the whole
+    // box, unless it spans more than half of the longitudes
+    const TFltPr CenterLoc((MinLoc.Val1 + MaxLoc.Val1) / 2.0, (MinLoc.Val2 + MaxLoc.Val2) / 2.0);
+    double Radius = TMath::Pi * TSphereNn<TInt, double>::EarthRadiusKm() * 1000.0;
+    if (MaxLoc.Val2 - MinLoc.Val2 <= 180.0) {
+        Radius = TFlt::GetMx(
+            TFlt::GetMx(GetDist(CenterLoc, MinLoc), GetDist(CenterLoc, MaxLoc)),
+            TFlt::GetMx(GetDist(CenterLoc, TFltPr(MinLoc.Val1, MaxLoc.Val2)),
+                GetDist(CenterLoc, TFltPr(MaxLoc.Val1, MinLoc.Val2)))) + 1.0;
+    }
+    TIntV LocKeyIdV; SphereNn.RangeQuery(CenterLoc.Val1, CenterLoc.Val2, Radius, LocKeyIdV);
+    // keep records from locations inside the area
+    TVec<TPair<TFltPr, TUInt64> > LocRecIdV;
+    for (int LocKeyIdN = 0; LocKeyIdN < LocKeyIdV.Len(); LocKeyIdN++) {
+        const int LocKeyId = LocKeyIdV[LocKeyIdN];
+        TFltPr KeyLoc; SphereNn.GetKeyCoords(LocKeyId, KeyLoc.Val1.Val, KeyLoc.Val2.Val);
+        if (!IsInArea(AreaV, KeyLoc)) { continue; }
+        const TUInt64V& KeyRecIdV = LocRecIdH[LocKeyId];
+        for (int RecN = 0; RecN < KeyRecIdV.Len(); RecN++) {
+            LocRecIdV.Add(TPair<TFltPr, TUInt64>(KeyLoc, KeyRecIdV[RecN]));
+        }
+    }
+    GetNearestRecIdV(Loc, LocRecIdV, Limit, RecIdV);
+}
+
 bool TGeoIndex::LocEquals(const TFltPr& Loc1, const TFltPr& Loc2) const {
     TIntPr LocId1 = GetLocId(Loc1), LocId2 = GetLocId(Loc2);
     return (LocId1 == LocId2);
 }
 
+double TGeoIndex::GetDist(const TFltPr& Loc1, const TFltPr& Loc2) {
+    // haversine formula, TSphereNn::GetDist rounds distances below few kilometers to zero
+    const double DegToRad = TMath::Pi / 180.0;
+    const double SinDLat = sin((Loc2.Val1 - Loc1.Val1) * DegToRad / 2.0);
+    const double SinDLon = sin((Loc2.Val2 - Loc1.Val2) * DegToRad / 2.0);
+    const double Hav = SinDLat * SinDLat +
+        cos(Loc1.Val1 * DegToRad) * cos(Loc2.Val1 * DegToRad) * SinDLon * SinDLon;
+    return 2.0 * TSphereNn<TInt, double>::EarthRadiusKm() * 1000.0 * asin(sqrt(TFlt::GetMn(Hav, 1.0)));
+}
+
+void TGeoIndex::GetAreaBox(const TFltPrV& AreaV, TFltPr& MinLoc, TFltPr& MaxLoc) {
+    QmAssert(!AreaV.Empty());
+    MinLoc = AreaV[0]; MaxLoc = AreaV[0];
+    for (int LocN = 1; LocN < AreaV.Len(); LocN++) {
+        MinLoc.Val1 = TFlt::GetMn(MinLoc.Val1, AreaV[LocN].Val1);
+        MinLoc.Val2 = TFlt::GetMn(MinLoc.Val2, AreaV[LocN].Val2);
+        MaxLoc.Val1 = TFlt::GetMx(MaxLoc.Val1, AreaV[LocN].Val1);
+        MaxLoc.Val2 = TFlt::GetMx(MaxLoc.Val2, AreaV[LocN].Val2);
+    }
+}
+
+bool TGeoIndex::IsInArea(const TFltPrV& AreaV, const TFltPr& Loc) {
+    // two corners define a box, including its edges
+    if (AreaV.Len() == 2) {
+        return AreaV[0].Val1 <= Loc.Val1 && Loc.Val1 <= AreaV[1].Val1 &&
+            AreaV[0].Val2 <= Loc.Val2 && Loc.Val2 <= AreaV[1].Val2;
+    }
+    // count polygon edges crossed by a ray going east from the location
+    bool InP = false;
+    for (int LocN = 0, PrevLocN = AreaV.Len() - 1; LocN < AreaV.Len(); PrevLocN = LocN++) {
+        const TFltPr& Loc1 = AreaV[LocN];
+        const TFltPr& Loc2 = AreaV[PrevLocN];
+        if ((Loc1.Val1 > Loc.Val1) != (Loc2.Val1 > Loc.Val1)) {
+            const double CrossLon = Loc1.Val2 + (Loc.Val1 - Loc1.Val1) *
+                (Loc2.Val2 - Loc1.Val2) / (Loc2.Val1 - Loc1.Val1);
+            if (Loc.Val2 < CrossLon) { InP = !InP; }
+        }
+    }
+    return InP;
+}
+
+void TGeoIndex::GetNearestRecIdV(const TFltPr& Loc, const TVec<TPair<TFltPr, TUInt64> >& LocRecIdV,
+        const int& Limit, TUInt64V& RecIdV) {
+
+    RecIdV.Gen(TInt::GetMn(LocRecIdV.Len(), Limit), 0);
+    if (LocRecIdV.Len() <= Limit) {
+        for (int RecN = 0; RecN < LocRecIdV.Len(); RecN++) { RecIdV.Add(LocRecIdV[RecN].Val2); }
+    } else {
+        // keep the nearest records, ties are broken by record id
+        TFltUInt64PrV DistRecIdV(LocRecIdV.Len(), 0);
+        for (int RecN = 0; RecN < LocRecIdV.Len(); RecN++) {
+            DistRecIdV.Add(TFltUInt64Pr(GetDist(Loc, LocRecIdV[RecN].Val1), LocRecIdV[RecN].Val2));
+        }
+        DistRecIdV.Sort();
+        for (int RecN = 0; RecN < Limit; RecN++) { RecIdV.Add(DistRecIdV[RecN].Val2); }
+    }
+    RecIdV.Sort();
+}
+
+///////////////////////////////
+// Geo Cell Index
+const int TGeoCellIndex::Levels = 30;
+const int TGeoCellIndex::MxCoverCells = 8;
+const double TGeoCellIndex::NnStartRadius = 100.0;
+
+uint64 TGeoCellIndex::SpreadBits(uint64 X) {
+    X &= 0x00000000FFFFFFFFULL;
+    X = (X | (X << 16)) & 0x0000FFFF0000FFFFULL;
+    X = (X | (X << 8)) & 0x00FF00FF00FF00FFULL;
+    X = (X | (X << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    X = (X | (X << 2)) & 0x3333333333333333ULL;
+    X = (X | (X << 1)) & 0x5555555555555555ULL;
+    return X;
+}
+
+uint64 TGeoCellIndex::CompactBits(uint64 X) {
+    X &= 0x5555555555555555ULL;
+    X = (X | (X >> 1)) & 0x3333333333333333ULL;
+    X = (X | (X >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+    X = (X | (X >> 4)) & 0x00FF00FF00FF00FFULL;
+    X = (X | (X >> 8)) & 0x0000FFFF0000FFFFULL;
+    X = (X | (X >> 16)) & 0x00000000FFFFFFFFULL;
+    return X;
+}
+
+uint64 TGeoCellIndex::GetCellCoord(const double& Deg, const double& MxDeg) {
+    const uint64 Cells = (uint64)1 << Levels;
+    const double Coord = floor((Deg + MxDeg) / (2.0 * MxDeg) * (double)Cells);
+    // locations on the edge of the range belong to the border cells
+    if (Coord < 0.0) { return 0; }
+    if (Coord >= (double)Cells) { return Cells - 1; }
+    return (uint64)Coord;
+}
+
+uint64 TGeoCellIndex::GetCellId(const TFltPr& Loc) {
+    // latitude takes odd and longitude even bits, so children of
+    // a cell take four consecutive ids on the next level
+    return (SpreadBits(GetCellCoord(Loc.Val1, 90.0)) << 1) | SpreadBits(GetCellCoord(Loc.Val2, 180.0));
+}
+
+TFltPr TGeoCellIndex::GetCellLoc(const uint64& CellId) {
+    const double Cells = (double)((uint64)1 << Levels);
+    const double LatCoord = (double)CompactBits(CellId >> 1);
+    const double LonCoord = (double)CompactBits(CellId);
+    return TFltPr((LatCoord + 0.5) / Cells * 180.0 - 90.0, (LonCoord + 0.5) / Cells * 360.0 - 180.0);
+}
+
+void TGeoCellIndex::GetCoverRangeV(const TFltPr& MinLoc, const TFltPr& MaxLoc, TVec<TUInt64Pr>& CellIdRangeV) {
+    uint64 MnLat = GetCellCoord(MinLoc.Val1, 90.0), MxLat = GetCellCoord(MaxLoc.Val1, 90.0);
+    uint64 MnLon = GetCellCoord(MinLoc.Val2, 180.0), MxLon = GetCellCoord(MaxLoc.Val2, 180.0);
+    // go up the tree until few cells along each axis cover the box
+    int Shift = 0;
+    while (MxLat - MnLat >= (uint64)MxCoverCells || MxLon - MnLon >= (uint64)MxCoverCells) {
+        MnLat >>= 1; MxLat >>= 1; MnLon >>= 1; MxLon >>= 1; Shift++;
+    }
+    // leaves below each covering cell form a continuous range of ids
+    const uint64 Leaves = (uint64)1 << (2 * Shift);
+    TVec<TUInt64Pr> RangeV;
+    for (uint64 Lat = MnLat; Lat <= MxLat; Lat++) {
+        for (uint64 Lon = MnLon; Lon <= MxLon; Lon++) {
+            const uint64 FirstCellId = ((SpreadBits(Lat) << 1) | SpreadBits(Lon)) << (2 * Shift);
+            RangeV.Add(TUInt64Pr(FirstCellId, FirstCellId + (Leaves - 1)));
+        }
+    }
+    // merge ranges of neighbouring cells
+    RangeV.Sort();
+    CellIdRangeV.Clr();
+    for (int RangeN = 0; RangeN < RangeV.Len(); RangeN++) {
+        if (!CellIdRangeV.Empty() && CellIdRangeV.Last().Val2 + 1 == RangeV[RangeN].Val1) {
+            CellIdRangeV.Last().Val2 = RangeV[RangeN].Val2;
+        } else {
+            CellIdRangeV.Add(RangeV[RangeN]);
+        }
+    }
+}
+
+void TGeoCellIndex::GetCircleBoxV(const TFltPr& Loc, const double& Radius, TVec<TBox>& BoxV) {
+    BoxV.Clr();
+    // angular radius
+    const double Angle = Radius / (TSphereNn<TInt, double>::EarthRadiusKm() * 1000.0);
+    const double DeltaLat = Angle * 180.0 / TMath::Pi;
+    const double MnLat = Loc.Val1 - DeltaLat, MxLat = Loc.Val1 + DeltaLat;
+    if (MnLat <= -90.0 || MxLat >= 90.0) {
+        // circle contains a pole and all longitudes
+        BoxV.Add(TBox(TFltPr(TFlt::GetMx(MnLat, -90.0), -180.0), TFltPr(TFlt::GetMn(MxLat, 90.0), 180.0)));
+        return;
+    }
+    const double DeltaLon = asin(sin(Angle) / cos(Loc.Val1 * TMath::Pi / 180.0)) * 180.0 / TMath::Pi;
+    const double MnLon = Loc.Val2 - DeltaLon, MxLon = Loc.Val2 + DeltaLon;
+    if (MnLon < -180.0) {
+        // crosses the antimeridian, one box on each side
+        BoxV.Add(TBox(TFltPr(MnLat, MnLon + 360.0), TFltPr(MxLat, 180.0)));
+        BoxV.Add(TBox(TFltPr(MnLat, -180.0), TFltPr(MxLat, MxLon)));
+    } else if (MxLon > 180.0) {
+        BoxV.Add(TBox(TFltPr(MnLat, MnLon), TFltPr(MxLat, 180.0)));
+        BoxV.Add(TBox(TFltPr(MnLat, -180.0), TFltPr(MxLat, MxLon - 360.0)));
+    } else {
+        BoxV.Add(TBox(TFltPr(MnLat, MnLon), TFltPr(MxLat, MxLon)));
+    }
+}
+
+void TGeoCellIndex::SearchBox(const TFltPr& MinLoc, const TFltPr& MaxLoc, TVec<TLocRecId>& LocRecIdV) const {
+    TVec<TUInt64Pr> CellIdRangeV; GetCoverRangeV(MinLoc, MaxLoc, CellIdRangeV);
+    TVec<TUInt64Pr> CellIdRecIdV;
+    for (int RangeN = 0; RangeN < CellIdRangeV.Len(); RangeN++) {
+        CellIndex->SearchRange(CellIdRangeV[RangeN], CellIdRecIdV);
+    }
+    // covering cells reach outside of the box, keep leaves inside
+    const uint64 MnLat = GetCellCoord(MinLoc.Val1, 90.0), MxLat = GetCellCoord(MaxLoc.Val1, 90.0);
+    const uint64 MnLon = GetCellCoord(MinLoc.Val2, 180.0), MxLon = GetCellCoord(MaxLoc.Val2, 180.0);
+    for (int RecN = 0; RecN < CellIdRecIdV.Len(); RecN++) {
+        const uint64 CellId = CellIdRecIdV[RecN].Val1;
+        const uint64 Lat = CompactBits(CellId >> 1), Lon = CompactBits(CellId);
+        if (MnLat <= Lat && Lat <= MxLat && MnLon <= Lon && Lon <= MxLon) {
+            LocRecIdV.Add(TLocRecId(GetCellLoc(CellId), CellIdRecIdV[RecN].Val2));
+        }
+    }
+}
+
+void TGeoCellIndex::SearchCircle(const TFltPr& Loc, const double& Radius, TVec<TLocRecId>& LocRecIdV) const {
+    TVec<TBox> BoxV; GetCircleBoxV(Loc, Radius, BoxV);
+    TVec<TLocRecId> BoxLocRecIdV;
+    for (int BoxN = 0; BoxN < BoxV.Len(); BoxN++) {
+        SearchBox(BoxV[BoxN].Val1, BoxV[BoxN].Val2, BoxLocRecIdV);
+    }
+    LocRecIdV.Gen(BoxLocRecIdV.Len(), 0);
+    for (int RecN = 0; RecN < BoxLocRecIdV.Len(); RecN++) {
+        if (TGeoIndex::GetDist(Loc, BoxLocRecIdV[RecN].Val1) <= Radius) { LocRecIdV.Add(BoxLocRecIdV[RecN]); }
+    }
+}
+
+void TGeoCellIndex::SearchRange(const TFltPr& Loc, const double& Radius,
+        const int& Limit, TUInt64V& RecIdV) const {
+
+    TVec<TLocRecId> LocRecIdV; SearchCircle(Loc, Radius, LocRecIdV);
+    TGeoIndex::GetNearestRecIdV(Loc, LocRecIdV, Limit, RecIdV);
+}
+
+void TGeoCellIndex::SearchNn(const TFltPr& Loc, const int& Limit, TUInt64V& RecIdV) const {
+    // grow the circle until it holds enough records or covers everything
+    const double MxRadius = TMath::Pi * TSphereNn<TInt, double>::EarthRadiusKm() * 1000.0;
+    double Radius = NnStartRadius;
+    TVec<TLocRecId> LocRecIdV;
+    forever {
+        SearchCircle(Loc, Radius, LocRecIdV);
+        if (LocRecIdV.Len() >= Limit || Radius >= MxRadius) { break; }
+        Radius = TFlt::GetMn(4.0 * Radius, MxRadius);
+    }
+    TGeoIndex::GetNearestRecIdV(Loc, LocRecIdV, Limit, RecIdV);
+}
+
+void TGeoCellIndex::SearchArea(const TFltPrV& AreaV, const TFltPr& Loc,
+        const int& Limit, TUInt64V& RecIdV) const {
+
+    TFltPr MinLoc, MaxLoc; TGeoIndex::GetAreaBox(AreaV, MinLoc, MaxLoc);
+    TVec<TLocRecId> BoxLocRecIdV; SearchBox(MinLoc, MaxLoc, BoxLocRecIdV);
+    // box search is already exact for box areas
+    if (AreaV.Len() == 2) {
+        TGeoIndex::GetNearestRecIdV(Loc, BoxLocRecIdV, Limit, RecIdV);
+        return;
+    }
+    TVec<TLocRecId> LocRecIdV;
+    for (int RecN = 0; RecN < BoxLocRecIdV.Len(); RecN++) {
+        if (TGeoIndex::IsInArea(AreaV, BoxLocRecIdV[RecN].Val1)) { LocRecIdV.Add(BoxLocRecIdV[RecN]); }
+    }
+    TGeoIndex::GetNearestRecIdV(Loc, LocRecIdV, Limit, RecIdV);
+}
+
 ///////////////////////////////
 // QMiner-Index
 TIndex::TQmGixKeyStr::TQmGixKeyStr(const TWPt<TBase>& _Base,
@@ -5493,6 +7018,69 @@ TStr TIndex::TQmGixKeyStr::GetKeyNm(const TQmGixKey& Key) const {
     return KeyChA;
 }
 
+void TIndex::TQmGixPackedItemHandler::PutVarInt(const int64& Val, TVec<uchar>& BfV) {
+    // zig-zag encode so small negative values also take few bytes
+    uint64 ZigZag = ((uint64)Val << 1) ^ (uint64)(Val >> 63);
+    // 7 bits per byte, highest bit marks that more bytes follow
+    while (ZigZag >= 0x80) {
+        BfV.Add((uchar)(ZigZag | 0x80));
+        ZigZag >>= 7;
+    }
+    BfV.Add((uchar)ZigZag);
+}
+
+int64 TIndex::TQmGixPackedItemHandler::GetVarInt(const uchar*& Bf) {
+    uint64 ZigZag = 0; int Shift = 0;
+    while ((*Bf & 0x80) != 0) {
+        ZigZag |= (uint64)(*Bf & 0x7F) << Shift;
+        Shift += 7; Bf++;
+    }
+    ZigZag |= (uint64)(*Bf) << Shift; Bf++;
+    return (int64)(ZigZag >> 1) ^ -(int64)(ZigZag & 1);
+}
+
+void TIndex::TQmGixPackedItemHandler::SaveItemV(const TVec<TQmGixItemFull>& ItemV, TSOut& SOut) const {
+    // record ids go first as deltas, followed by frequencies, so the decoder
+    // can run over each of them in a tight loop
+    TVec<uchar> BfV(3 * ItemV.Len(), 0);
+    uint64 PrevRecId = 0;
+    for (const TQmGixItemFull& Item : ItemV) {
+        PutVarInt((int64)(Item.Key.Val - PrevRecId), BfV);
+        PrevRecId = Item.Key.Val;
+    }
+    for (const TQmGixItemFull& Item : ItemV) {
+        PutVarInt(Item.Dat.Val, BfV);
+    }
+    // save number of items and packed buffer
+    SOut.Save(ItemV.Len());
+    SOut.Save(BfV.Len());
+    SOut.SaveBf(BfV.BegI(), BfV.Len());
+}
+
+void TIndex::TQmGixPackedItemHandler::LoadItemV(TSIn& SIn, TVec<TQmGixItemFull>& ItemV) const {
+    int Items = 0; SIn.Load(Items);
+    int BfL = 0; SIn.Load(BfL);
+    TVec<uchar> BfV(BfL); SIn.LoadBf(BfV.BegI(), BfL);
+    // make space for new items
+    const int FirstItemN = ItemV.Len();
+    if (ItemV.Reserved() < FirstItemN + Items) { ItemV.Reserve(FirstItemN + Items); }
+    // decode record ids
+    const uchar* Bf = BfV.BegI();
+    uint64 RecId = 0;
+    for (int ItemN = 0; ItemN < Items; ItemN++) {
+        RecId += (uint64)GetVarInt(Bf);
+        ItemV.Add(TQmGixItemFull(RecId, 0));
+    }
+    // decode frequencies
+    for (int ItemN = 0; ItemN < Items; ItemN++) {
+        ItemV[FirstItemN + ItemN].Dat = (int)GetVarInt(Bf);
+    }
+    Assert(Bf == BfV.EndI());
+}
+
+// standard choice of BM25 term frequency saturation
+const double TIndex::TopKBm25K1 = 1.2;
+
 // we use 2^10-1 as the modulo. 10 because we use 10 bits to store the position in the text
 // and we remove 1 since we reserve one value (in our case 0) as representing "empty" value
 const int TIndex::TQmGixItemPos::Modulo = 1023;
@@ -5593,10 +7181,21 @@ TIndex::TQmGixItemPos TIndex::TQmGixItemPos::Intersect(const TQmGixItemPos& Item
     return _Item;
 }
 
+TCriticalSection& TIndex::GetGixSection(const TIndexKeyGixType& GixType) const {
+    switch (GixType) {
+    case oikgtFull: return GixFullSection;
+    case oikgtSmall: return GixSmallSection;
+    case oikgtTiny: return GixTinySection;
+    case oikgtPacked: return GixPackedSection;
+    default: throw TQmExcept::New("[TIndex::GetGixSection] Unsupported gix type!");
+    }
+}
+
 bool TIndex::DoQueryFull(const TPt<TQmGixExpItemFull>& ExpItem, TVec<TQmGixItemFull>& RecIdFqV) const {
     // clean if there is anything on the input
     RecIdFqV.Clr();
     // execute query
+    TLock Lock(GixFullSection);
     const bool Not = ExpItem->Eval(GixFull, RecIdFqV, SumMergerFull);
     // make sure we are sorted
     Assert(RecIdFqV.IsSorted());
@@ -5606,6 +7205,7 @@ bool TIndex::DoQueryFull(const TPt<TQmGixExpItemFull>& ExpItem, TVec<TQmGixItemF
 
 bool TIndex::DoQuerySmall(const TPt<TQmGixExpItemSmall>& ExpItem, TVec<TQmGixItemFull>& RecIdFqV) const {
     // execute query
+    TLock Lock(GixSmallSection);
     TVec<TQmGixItemSmall> SmallRecIdFqV;
     const bool Not = ExpItem->Eval(GixSmall, SmallRecIdFqV, SumMergerSmall);
     // upgrade to full
@@ -5622,6 +7222,7 @@ bool TIndex::DoQuerySmall(const TPt<TQmGixExpItemSmall>& ExpItem, TVec<TQmGixIte
 bool TIndex::DoQueryTiny(const TPt<TQmGixExpItemTiny>& ExpItem, TVec<TQmGixItemFull>& RecIdFqV) const {
     // clean if there is anything on the input
     RecIdFqV.Clr();
+    TLock Lock(GixTinySection);
     const bool Not = ExpItem->Eval(GixTiny, RecIdFqV, MergerTiny);
     // make sure we are sorted
     Assert(RecIdFqV.IsSorted());
@@ -5629,55 +7230,18 @@ bool TIndex::DoQueryTiny(const TPt<TQmGixExpItemTiny>& ExpItem, TVec<TQmGixItemF
     return Not;
 }
 
-void TIndex::DoJoinQueryFull(const int& KeyId, const TUInt64V& RecIdV, TUInt64IntKdV& RecIdFqV) const {
-    // temporary story for joined records
-    THash<TUInt64, TInt> RecIdFqH;
-    // lambda that goes over child vectors and updates the hash table with counts
-    auto Handler = [&RecIdFqH](TVec<TQmGixItemFull> ItemV) {
-        for (const TQmGixItemFull& RecIdFq : ItemV) {
-            RecIdFqH.AddDat(RecIdFq.Key) += RecIdFq.Dat;
-        }
-    };
-    // go over all records we want to join
-    for (uint64 RecId : RecIdV) {
-        GixFull->GetItemV(TQmGixKey(KeyId, RecId), Handler);
-    }
-    // convert to vector
-    RecIdFqH.GetKeyDatKdV(RecIdFqV);
-}
-
-void TIndex::DoJoinQuerySmall(const int& KeyId, const TUInt64V& RecIdV, TUInt64IntKdV& RecIdFqV) const {
-    // temporary story for joined records
-    THash<TUInt64, TInt> RecIdFqH;
-    // lambda that goes over child vectors and updates the hash table with counts
-    auto Handler = [&RecIdFqH](TVec<TQmGixItemSmall> ItemV) {
-        for (const TQmGixItemSmall& RecIdFq : ItemV) {
-            RecIdFqH.AddDat((uint64)RecIdFq.Key) += (int)RecIdFq.Dat;
-        }
-    };
-    // go over all records we want to join
-    for (uint64 RecId : RecIdV) {
-        GixSmall->GetItemV(TQmGixKey(KeyId, RecId), Handler);
-    }
-    // convert to vector
-    RecIdFqH.GetKeyDatKdV(RecIdFqV);
-}
-
-void TIndex::DoJoinQueryTiny(const int& KeyId, const TUInt64V& RecIdV, TUInt64IntKdV& RecIdFqV) const {
-    // temporary story for joined records
-    THash<TUInt64, TInt> RecIdFqH;
-    // lambda that goes over child vectors and updates the hash table with counts
-    auto Handler = [&RecIdFqH](TVec<TQmGixItemTiny> ItemV) {
-        for (const TQmGixItemTiny& RecId : ItemV) {
-            RecIdFqH.AddDat((uint64)RecId) += 1;
-        }
-    };
-    // go over all records we want to join
-    for (uint64 RecId : RecIdV) {
-        GixTiny->GetItemV(TQmGixKey(KeyId, RecId), Handler);
-    }
-    // convert to vector
-    RecIdFqH.GetKeyDatKdV(RecIdFqV);
+bool TIndex::DoQueryPacked(const TPt<TQmGixExpItemFull>& ExpItem, TVec<TQmGixItemFull>& RecIdFqV) const {
+    // clean if there is anything on the input
+    RecIdFqV.Clr();
+    // read-only base from before packed index has no packed keys
+    if (!HasGixPacked()) { return false; }
+    // execute query, packed child vectors are decoded directly into the results
+    TLock Lock(GixPackedSection);
+    const bool Not = ExpItem->Eval(GixPacked, RecIdFqV, SumMergerFull);
+    // make sure we are sorted
+    Assert(RecIdFqV.IsSorted());
+    // pass forward return result
+    return Not;
 }
 
 void TIndex::DoQueryPos(const int& KeyId, const TUInt64V& WordIdV,
@@ -5692,7 +7256,10 @@ void TIndex::DoQueryPos(const int& KeyId, const TUInt64V& WordIdV,
     // get records for the first word from the index and
     // store it into the running result candidate vector
     TVec<TQmGixItemPos> CurrentItemV;
-    GixPos->GetItemV(TQmGixKey(KeyId, WordIdV[0]), CurrentItemV);
+    {
+        TLock Lock(GixPosSection);
+        GixPos->GetItemV(TQmGixKey(KeyId, WordIdV[0]), CurrentItemV);
+    }
     Assert(CurrentItemV.IsSorted());
     // now filter down the results by intersecting with subsequent words
     for (int WordN = 1; WordN < WordIdV.Len(); WordN++) {
@@ -5700,7 +7267,10 @@ void TIndex::DoQueryPos(const int& KeyId, const TUInt64V& WordIdV,
         if (CurrentItemV.Empty()) { break; }
         // get new word items
         TVec<TQmGixItemPos> WordItemV;
-        GixPos->GetItemV(TQmGixKey(KeyId, WordIdV[WordN]), WordItemV);
+        {
+            TLock Lock(GixPosSection);
+            GixPos->GetItemV(TQmGixKey(KeyId, WordIdV[WordN]), WordItemV);
+        }
         Assert(WordItemV.IsSorted());
         // intersect the lists
         TVec<TQmGixItemPos> _ItemV; int CurrentItemN = 0;
@@ -5759,7 +7329,7 @@ void TIndex::DoQueryPos(const int& KeyId, const TUInt64V& WordIdV,
 
 TIndex::TIndex(const TStr& _IndexFPath, const TFAccess& _Access, const PIndexVoc& _IndexVoc,
     const int64& CacheSizeFull, const int64& CacheSizeSmall, const uint64& CacheSizeTiny,
-    const int64& CacheSizePos, const int& SplitLen) {
+    const int64& CacheSizePos, const int64& CacheSizePacked, const int& SplitLen) {
 
     IndexFPath = _IndexFPath;
     Access = _Access;
@@ -5778,6 +7348,17 @@ TIndex::TIndex(const TStr& _IndexFPath, const TFAccess& _Access, const PIndexVoc
     GixTiny = TGix<TQmGixKey, TQmGixItemTiny>::New("Index.GixTiny",
         IndexFPath, Access, ItemHandlerTiny, CacheSizeTiny, SplitLen);
     MergerTiny = new TQmGixSumWithoutFqMerger<TQmGixItemTiny, TQmGixItemFull>;
+    // initialize packed inverted index, bases created before packed
+    // index was introduced get an empty one when opened for writing;
+    // read-only opens must not create files, so they go without it
+    ItemHandlerPacked = new TQmGixPackedItemHandler;
+    if (TFile::Exists(IndexFPath + "Index.GixPacked.Gix")) {
+        GixPacked = TGix<TQmGixKey, TQmGixItemFull>::New("Index.GixPacked",
+            IndexFPath, Access, ItemHandlerPacked, CacheSizePacked, SplitLen);
+    } else if (Access != faRdOnly) {
+        GixPacked = TGix<TQmGixKey, TQmGixItemFull>::New("Index.GixPacked",
+            IndexFPath, faCreate, ItemHandlerPacked, CacheSizePacked, SplitLen);
+    }
     // initialize position inverted index
     ItemHandlerPos = new TGixDefItemHandler<TQmGixKey, TQmGixItemPos>;
     GixPos = TGix<TQmGixKey, TQmGixItemPos>::New("Index.GixPos",
@@ -5789,6 +7370,14 @@ TIndex::TIndex(const TStr& _IndexFPath, const TFAccess& _Access, const PIndexVoc
         TFIn SphereFIn(SphereFNm);
         GeoIndexH.Load(SphereFIn);
     }
+    // initialize paged location index
+    TStr GeoCellFNm = IndexFPath + "Index.GeoCell";
+    if (TFile::Exists(GeoCellFNm) && Access != faCreate) {
+        TFIn GeoCellFIn(GeoCellFNm);
+        GeoCellIndexH.Load(GeoCellFIn);
+        int KeyId = GeoCellIndexH.FFirstKeyId();
+        while (GeoCellIndexH.FNextKeyId(KeyId)) { GeoCellIndexH[KeyId]->Open(IndexFPath, Access); }
+    }
     // initialize btree index
     TStr BTreeFNm = IndexFPath + "Index.BTree";
     if (TFile::Exists(BTreeFNm) && Access != faCreate) {
@@ -5802,6 +7391,16 @@ TIndex::TIndex(const TStr& _IndexFPath, const TFAccess& _Access, const PIndexVoc
         BTreeIndexUInt64H.Load(BTreeFIn);
         BTreeIndexFltH.Load(BTreeFIn);
         BTreeIndexSFltH.Load(BTreeFIn);
+        // paged indexes open their files on first use
+        OpenBTreeIndexH(BTreeIndexByteH);
+        OpenBTreeIndexH(BTreeIndexIntH);
+        OpenBTreeIndexH(BTreeIndexInt16H);
+        OpenBTreeIndexH(BTreeIndexInt64H);
+        OpenBTreeIndexH(BTreeIndexUIntH);
+        OpenBTreeIndexH(BTreeIndexUInt16H);
+        OpenBTreeIndexH(BTreeIndexUInt64H);
+        OpenBTreeIndexH(BTreeIndexFltH);
+        OpenBTreeIndexH(BTreeIndexSFltH);
     }
     // initialize vocabularies
     IndexVoc = _IndexVoc;
@@ -5809,10 +7408,10 @@ TIndex::TIndex(const TStr& _IndexFPath, const TFAccess& _Access, const PIndexVoc
 
 PIndex TIndex::New(const TStr& IndexFPath, const TFAccess& Access, const PIndexVoc& IndexVoc,
     const int64& CacheSizeFull, const int64& CacheSizeSmall, const uint64& CacheSizeTiny,
-    const int64& CacheSizePos, const int& SplitLen) {
+    const int64& CacheSizePos, const int64& CacheSizePacked, const int& SplitLen) {
 
     return new TIndex(IndexFPath, Access, IndexVoc, CacheSizeFull,
-         CacheSizeSmall, CacheSizeTiny, CacheSizePos, SplitLen);
+         CacheSizeSmall, CacheSizeTiny, CacheSizePos, CacheSizePacked, SplitLen);
 }
 
 TIndex::~TIndex() {
@@ -5830,6 +7429,9 @@ TIndex::~TIndex() {
             GixTiny.Clr();
             delete ItemHandlerTiny;
             delete MergerTiny;
+            TEnv::Logger->OnStatus("Saving and closing inverted index - packed");
+            GixPacked.Clr();
+            delete ItemHandlerPacked;
             TEnv::Logger->OnStatus("Saving and closing inverted index - position");
             GixPos.Clr();
             delete ItemHandlerPos;
@@ -5839,6 +7441,8 @@ TIndex::~TIndex() {
             TEnv::Logger->OnStatus("Saving and closing location index");
             TFOut SphereFOut(IndexFPath + "Index.Geo");
             GeoIndexH.Save(SphereFOut);
+            TFOut GeoCellFOut(IndexFPath + "Index.GeoCell");
+            GeoCellIndexH.Save(GeoCellFOut);
         }
         {
             TEnv::Logger->OnStatus("Saving and closing btree index");
@@ -5917,6 +7521,7 @@ void TIndex::IndexGix(const int& KeyId, const uint64& WordId, const uint64& RecI
     QmAssertR(!IsReadOnly(), "Cannot edit read-only index!");
     // check which Gix to use
     const TIndexKeyGixType GixType = GetGixType(KeyId);
+    TLock Lock(GetGixSection(GixType));
     // send to appropriate index
     switch (GixType) {
     case oikgtFull:
@@ -5925,11 +7530,59 @@ void TIndex::IndexGix(const int& KeyId, const uint64& WordId, const uint64& RecI
         GixSmall->AddItem(TKeyWord(KeyId, WordId), TQmGixItemSmall((uint)RecId, (int16)RecFq)); break;
     case oikgtTiny:
         GixTiny->AddItem(TKeyWord(KeyId, WordId), TQmGixItemTiny((uint)RecId)); break;
+    case oikgtPacked:
+        GixPacked->AddItem(TKeyWord(KeyId, WordId), TQmGixItemFull(RecId, RecFq)); break;
     default:
         throw TQmExcept::New("[TIndex::Index] Unsupported gix type!");
     }
 }
 
+void TIndex::IndexGixV(const int& KeyId, const uint64& WordId, const TUInt64IntPrV& RecIdFqV) {
+    // -1 should never come to here
+    Assert(KeyId != -1);
+    // we shouldn't modify read-only index
+    QmAssertR(!IsReadOnly(), "Cannot edit read-only index!");
+    // check which Gix to use
+    const TIndexKeyGixType GixType = GetGixType(KeyId);
+    TLock Lock(GetGixSection(GixType));
+    // prepare items and send them to appropriate index
+    const TKeyWord KeyWord(KeyId, WordId);
+    const int Items = RecIdFqV.Len();
+    switch (GixType) {
+    case oikgtFull:
+    case oikgtPacked: {
+        TVec<TQmGixItemFull> ItemV(Items, 0);
+        for (int ItemN = 0; ItemN < Items; ItemN++) {
+            ItemV.Add(TQmGixItemFull(RecIdFqV[ItemN].Val1, RecIdFqV[ItemN].Val2));
+        }
+        if (GixType == oikgtFull) {
+            GixFull->AddItemV(KeyWord, ItemV);
+        } else {
+            GixPacked->AddItemV(KeyWord, ItemV);
+        }
+        break;
+    }
+    case oikgtSmall: {
+        TVec<TQmGixItemSmall> ItemV(Items, 0);
+        for (int ItemN = 0; ItemN < Items; ItemN++) {
+            ItemV.Add(TQmGixItemSmall((uint)RecIdFqV[ItemN].Val1, (int16)RecIdFqV[ItemN].Val2));
+        }
+        GixSmall->AddItemV(KeyWord, ItemV);
+        break;
+    }
+    case oikgtTiny: {
+        TVec<TQmGixItemTiny> ItemV(Items, 0);
+        for (int ItemN = 0; ItemN < Items; ItemN++) {
+            ItemV.Add(TQmGixItemTiny((uint)RecIdFqV[ItemN].Val1));
+        }
+        GixTiny->AddItemV(KeyWord, ItemV);
+        break;
+    }
+    default:
+        throw TQmExcept::New("[TIndex::IndexGixV] Unsupported gix type!");
+    }
+}
+
 void TIndex::DeleteValue(const int& KeyId, const TStr& WordStr, const uint64& RecId) {
     const uint64 WordId = IndexVoc->AddWordStr(KeyId, WordStr);
     DeleteGix(KeyId, WordId, RecId, 1);
@@ -5979,6 +7632,7 @@ void TIndex::DeleteGix(const int& KeyId, const uint64& WordId, const uint64& Rec
     QmAssertR(!IsReadOnly(), "Cannot edit read-only index!");
     // check which Gix to use
     const TIndexKeyGixType GixType = GetGixType(KeyId);
+    TLock Lock(GetGixSection(GixType));
     // are we deleting all items or just few occurences?
     if (RecFq == TInt::Mx) {
         // full delete from index
@@ -5989,6 +7643,8 @@ void TIndex::DeleteGix(const int& KeyId, const uint64& WordId, const uint64& Rec
             GixSmall->DelItem(TKeyWord(KeyId, WordId), TQmGixItemSmall((uint)RecId, 0)); break;
         case oikgtTiny:
             GixTiny->DelItem(TKeyWord(KeyId, WordId), TQmGixItemTiny((uint)RecId)); break;
+        case oikgtPacked:
+            GixPacked->DelItem(TKeyWord(KeyId, WordId), TQmGixItemFull(RecId, 0)); break;
         default: throw TQmExcept::New("[TIndex::Delete] Unsupported gix type!");
         }
     } else {
@@ -5999,11 +7655,60 @@ void TIndex::DeleteGix(const int& KeyId, const uint64& WordId, const uint64& Rec
             GixSmall->AddItem(TKeyWord(KeyId, WordId), TQmGixItemSmall((uint)RecId, (int16)-RecFq)); break;
         case oikgtTiny:
             GixTiny->DelItem(TKeyWord(KeyId, WordId), TQmGixItemTiny((uint)RecId)); break;
+        case oikgtPacked:
+            GixPacked->AddItem(TKeyWord(KeyId, WordId), TQmGixItemFull(RecId, -RecFq)); break;
         default: throw TQmExcept::New("[TIndex::Delete] Unsupported gix type!");
         }
     }
 }
 
+void TIndex::DeleteGixV(const int& KeyId, const uint64& WordId, const TUInt64IntPrV& RecIdFqV) {
+    // -1 should never come to here
+    Assert(KeyId != -1);
+    // we shouldn't modify read-only index
+    QmAssertR(!IsReadOnly(), "Cannot edit read-only index!");
+    // check which Gix to use
+    const TIndexKeyGixType GixType = GetGixType(KeyId);
+    TLock Lock(GetGixSection(GixType));
+    // prepare items and send them to appropriate index, occurrences
+    // are removed by adding items with negative frequency
+    const TKeyWord KeyWord(KeyId, WordId);
+    const int Items = RecIdFqV.Len();
+    switch (GixType) {
+    case oikgtFull:
+    case oikgtPacked: {
+        TVec<TQmGixItemFull> ItemV(Items, 0);
+        for (int ItemN = 0; ItemN < Items; ItemN++) {
+            ItemV.Add(TQmGixItemFull(RecIdFqV[ItemN].Val1, -RecIdFqV[ItemN].Val2));
+        }
+        if (GixType == oikgtFull) {
+            GixFull->AddItemV(KeyWord, ItemV);
+        } else {
+            GixPacked->AddItemV(KeyWord, ItemV);
+        }
+        break;
+    }
+    case oikgtSmall: {
+        TVec<TQmGixItemSmall> ItemV(Items, 0);
+        for (int ItemN = 0; ItemN < Items; ItemN++) {
+            ItemV.Add(TQmGixItemSmall((uint)RecIdFqV[ItemN].Val1, (int16)-RecIdFqV[ItemN].Val2));
+        }
+        GixSmall->AddItemV(KeyWord, ItemV);
+        break;
+    }
+    case oikgtTiny: {
+        TVec<TQmGixItemTiny> ItemV(Items, 0);
+        for (int ItemN = 0; ItemN < Items; ItemN++) {
+            ItemV.Add(TQmGixItemTiny((uint)RecIdFqV[ItemN].Val1));
+        }
+        GixTiny->DelItemV(KeyWord, ItemV);
+        break;
+    }
+    default:
+        throw TQmExcept::New("[TIndex::DeleteGixV] Unsupported gix type!");
+    }
+}
+
 void TIndex::ComputeWordItemPos(const int& KeyId, const TUInt64V& WordIdV, const uint64& RecId, TVec<TPair<TUInt64, TQmGixItemPos>>& WordIdPosPrV) {
     // create a vector of positions computed by modulo
     typedef TPair<TInt, TUInt64> TPosWordIdPr;
@@ -6062,6 +7767,7 @@ void TIndex::IndexTextPos(const int& KeyId, const TUInt64V& WordIdV, const uint6
     // compute the gix items to be added to gix
     TVec<TPair<TUInt64, TQmGixItemPos>> WordIdPosPrV;
     ComputeWordItemPos(KeyId, WordIdV, RecId, WordIdPosPrV);
+    TLock Lock(GixPosSection);
     for (int N = 0; N < WordIdPosPrV.Len(); N++) {
         GixPos->AddItem(TKeyWord(KeyId, WordIdPosPrV[N].Val1), WordIdPosPrV[N].Val2);
     }
@@ -6080,6 +7786,7 @@ void TIndex::DeleteTextPos(const int& KeyId, const TUInt64V& WordIdV, const uint
     // compute the gix items to be removed from gix
     TVec<TPair<TUInt64, TQmGixItemPos>> WordIdPosPrV;
     ComputeWordItemPos(KeyId, WordIdV, RecId, WordIdPosPrV);
+    TLock Lock(GixPosSection);
     for (int N = 0; N < WordIdPosPrV.Len(); N++) {
         GixPos->DelItem(TKeyWord(KeyId, WordIdPosPrV[N].Val1), WordIdPosPrV[N].Val2);
     }
@@ -6088,6 +7795,14 @@ void TIndex::DeleteTextPos(const int& KeyId, const TUInt64V& WordIdV, const uint
 void TIndex::IndexGeo(const int& KeyId, const TFltPr& Loc, const uint64& RecId) {
     // we shouldn't modify read-only index
     QmAssertR(!IsReadOnly(), "Cannot edit read-only index!");
+    if (IndexVoc->GetKey(KeyId).IsPaged()) {
+        // if new key, create paged cell index first
+        if (!GeoCellIndexH.IsKey(KeyId)) {
+            GeoCellIndexH.AddDat(KeyId, TGeoCellIndex::New(IndexFPath, "Index.GeoCell." + TInt::GetStr(KeyId)));
+        }
+        GeoCellIndexH.GetDat(KeyId)->AddKey(Loc, RecId);
+        return;
+    }
     // if new key, create sphere first
     if (!GeoIndexH.IsKey(KeyId)) { GeoIndexH.AddDat(KeyId, TGeoIndex::New()); }
     // index new location
@@ -6099,9 +7814,11 @@ void TIndex::DeleteGeo(const int& KeyId, const TFltPr& Loc, const uint64& RecId)
     QmAssertR(!IsReadOnly(), "Cannot edit read-only index!");
     // delete only if index exist
     if (GeoIndexH.IsKey(KeyId)) { GeoIndexH.GetDat(KeyId)->DelKey(Loc, RecId); }
+    if (GeoCellIndexH.IsKey(KeyId)) { GeoCellIndexH.GetDat(KeyId)->DelKey(Loc, RecId); }
 }
 
 bool TIndex::LocEquals(const int& KeyId, const TFltPr& Loc1, const TFltPr& Loc2) const {
+    if (GeoCellIndexH.IsKey(KeyId)) { return GeoCellIndexH.GetDat(KeyId)->LocEquals(Loc1, Loc2); }
     return GeoIndexH.IsKey(KeyId) ? GeoIndexH.GetDat(KeyId)->LocEquals(Loc1, Loc2) : false;
 }
 
@@ -6109,7 +7826,7 @@ void TIndex::IndexLinear(const int& KeyId, const uchar& Val, const uint64& RecId
     // we shouldn't modify read-only index
     QmAssertR(!IsReadOnly(), "Cannot edit read-only index!");
     // if new key, create sphere first
-    if (!BTreeIndexByteH.IsKey(KeyId)) { BTreeIndexByteH.AddDat(KeyId, PBTreeIndexUCh::New()); }
+    if (!BTreeIndexByteH.IsKey(KeyId)) { BTreeIndexByteH.AddDat(KeyId, NewBTreeIndex<TUCh>(KeyId)); }
     // index new location
     BTreeIndexByteH.GetDat(KeyId)->AddKey(Val, RecId);
 }
@@ -6118,7 +7835,7 @@ void TIndex::IndexLinear(const int& KeyId, const int& Val, const uint64& RecId)
     // we shouldn't modify read-only index
     QmAssertR(!IsReadOnly(), "Cannot edit read-only index!");
     // if new key, create sphere first
-    if (!BTreeIndexIntH.IsKey(KeyId)) { BTreeIndexIntH.AddDat(KeyId, PBTreeIndexInt::New()); }
+    if (!BTreeIndexIntH.IsKey(KeyId)) { BTreeIndexIntH.AddDat(KeyId, NewBTreeIndex<TInt>(KeyId)); }
     // index new location
     BTreeIndexIntH.GetDat(KeyId)->AddKey(Val, RecId);
 }
@@ -6127,7 +7844,7 @@ void TIndex::IndexLinear(const int& KeyId, const int16& Val, const uint64& RecId
     // we shouldn't modify read-only index
     QmAssertR(!IsReadOnly(), "Cannot edit read-only index!");
     // if new key, create sphere first
-    if (!BTreeIndexInt16H.IsKey(KeyId)) { BTreeIndexInt16H.AddDat(KeyId, PBTreeIndexInt16::New()); }
+    if (!BTreeIndexInt16H.IsKey(KeyId)) { BTreeIndexInt16H.AddDat(KeyId, NewBTreeIndex<TInt16>(KeyId)); }
     // index new location
     BTreeIndexInt16H.GetDat(KeyId)->AddKey(Val, RecId);
 }
@@ -6136,7 +7853,7 @@ void TIndex::IndexLinear(const int& KeyId, const int64& Val, const uint64& RecId
     // we shouldn't modify read-only index
     QmAssertR(!IsReadOnly(), "Cannot edit read-only index!");
     // if new key, create sphere first
-    if (!BTreeIndexInt64H.IsKey(KeyId)) { BTreeIndexInt64H.AddDat(KeyId, PBTreeIndexInt64::New()); }
+    if (!BTreeIndexInt64H.IsKey(KeyId)) { BTreeIndexInt64H.AddDat(KeyId, NewBTreeIndex<TInt64>(KeyId)); }
     // index new location
     BTreeIndexInt64H.GetDat(KeyId)->AddKey(Val, RecId);
 }
@@ -6145,7 +7862,7 @@ void TIndex::IndexLinear(const int& KeyId, const uint& Val, const uint64& RecId)
     // we shouldn't modify read-only index
     QmAssertR(!IsReadOnly(), "Cannot edit read-only index!");
     // if new key, create sphere first
-    if (!BTreeIndexUIntH.IsKey(KeyId)) { BTreeIndexUIntH.AddDat(KeyId, PBTreeIndexUInt::New()); }
+    if (!BTreeIndexUIntH.IsKey(KeyId)) { BTreeIndexUIntH.AddDat(KeyId, NewBTreeIndex<TUInt>(KeyId)); }
     // index new location
     BTreeIndexUIntH.GetDat(KeyId)->AddKey(Val, RecId);
 }
@@ -6154,7 +7871,7 @@ void TIndex::IndexLinear(const int& KeyId, const uint16& Val, const uint64& RecI
     // we shouldn't modify read-only index
     QmAssertR(!IsReadOnly(), "Cannot edit read-only index!");
     // if new key, create sphere first
-    if (!BTreeIndexUInt16H.IsKey(KeyId)) { BTreeIndexUInt16H.AddDat(KeyId, PBTreeIndexUInt16::New()); }
+    if (!BTreeIndexUInt16H.IsKey(KeyId)) { BTreeIndexUInt16H.AddDat(KeyId, NewBTreeIndex<TUInt16>(KeyId)); }
     // index new location
     BTreeIndexUInt16H.GetDat(KeyId)->AddKey(Val, RecId);
 }
@@ -6163,7 +7880,7 @@ void TIndex::IndexLinear(const int& KeyId, const uint64& Val, const uint64& RecI
     // we shouldn't modify read-only index
     QmAssertR(!IsReadOnly(), "Cannot edit read-only index!");
     // if new key, create sphere first
-    if (!BTreeIndexUInt64H.IsKey(KeyId)) { BTreeIndexUInt64H.AddDat(KeyId, PBTreeIndexUInt64::New()); }
+    if (!BTreeIndexUInt64H.IsKey(KeyId)) { BTreeIndexUInt64H.AddDat(KeyId, NewBTreeIndex<TUInt64>(KeyId)); }
     // index new location
     BTreeIndexUInt64H.GetDat(KeyId)->AddKey(Val, RecId);
 }
@@ -6173,7 +7890,7 @@ void TIndex::IndexLinear(const int& KeyId, const double& Val, const uint64& RecI
     // we shouldn't modify read-only index
     QmAssertR(!IsReadOnly(), "Cannot edit read-only index!");
     // if new key, create sphere first
-    if (!BTreeIndexFltH.IsKey(KeyId)) { BTreeIndexFltH.AddDat(KeyId, PBTreeIndexFlt::New()); }
+    if (!BTreeIndexFltH.IsKey(KeyId)) { BTreeIndexFltH.AddDat(KeyId, NewBTreeIndex<TFlt>(KeyId)); }
     // index new location
     BTreeIndexFltH.GetDat(KeyId)->AddKey(Val, RecId);
 }
@@ -6182,7 +7899,7 @@ void TIndex::IndexLinear(const int& KeyId, const float& Val, const uint64& RecId
     // we shouldn't modify read-only index
     QmAssertR(!IsReadOnly(), "Cannot edit read-only index!");
     // if new key, create sphere first
-    if (!BTreeIndexSFltH.IsKey(KeyId)) { BTreeIndexSFltH.AddDat(KeyId, PBTreeIndexSFlt::New()); }
+    if (!BTreeIndexSFltH.IsKey(KeyId)) { BTreeIndexSFltH.AddDat(KeyId, NewBTreeIndex<TSFlt>(KeyId)); }
     // index new location
     BTreeIndexSFltH.GetDat(KeyId)->AddKey(Val, RecId);
 }
@@ -6265,6 +7982,8 @@ PRecSet TIndex::SearchGix(const TWPt<TBase>& Base, const int& KeyId, const uint6
         DoQuerySmall(TQmGixExpItemSmall::NewItem(KeyWord), RecIdFqV); break;
     case oikgtTiny:
         DoQueryTiny(TQmGixExpItemTiny::NewItem(KeyWord), RecIdFqV); break;
+    case oikgtPacked:
+        DoQueryPacked(TQmGixExpItemFull::NewItem(KeyWord), RecIdFqV); break;
     default:
         throw TQmExcept::New("[TIndex::SearchGixOr] Unsupported gix type!");
     }
@@ -6291,6 +8010,8 @@ PRecSet TIndex::SearchGixAnd(const TWPt<TBase>& Base, const int& KeyId, const TU
         DoQuerySmall(TQmGixExpItemSmall::NewAndV(KeyWordV), RecIdFqV); break;
     case oikgtTiny:
         DoQueryTiny(TQmGixExpItemTiny::NewAndV(KeyWordV), RecIdFqV); break;
+    case oikgtPacked:
+        DoQueryPacked(TQmGixExpItemFull::NewAndV(KeyWordV), RecIdFqV); break;
     default:
         throw TQmExcept::New("[TIndex::SearchGixAnd] Unsupported gix type!");
     }
@@ -6317,6 +8038,8 @@ PRecSet TIndex::SearchGixOr(const TWPt<TBase>& Base, const int& KeyId, const TUI
         DoQuerySmall(TQmGixExpItemSmall::NewOrV(KeyWordV), RecIdFqV); break;
     case oikgtTiny:
         DoQueryTiny(TQmGixExpItemTiny::NewOrV(KeyWordV), RecIdFqV); break;
+    case oikgtPacked:
+        DoQueryPacked(TQmGixExpItemFull::NewOrV(KeyWordV), RecIdFqV); break;
     default:
         throw TQmExcept::New("[TIndex::SearchGixOr] Unsupported gix type!");
     }
@@ -6325,6 +8048,54 @@ PRecSet TIndex::SearchGixOr(const TWPt<TBase>& Base, const int& KeyId, const TUI
     return TRecSet::New(Base->GetStoreByStoreId(StoreId), RecIdFqV);
 }
 
+PRecSet TIndex::SearchGixTopK(const TWPt<TBase>& Base, const int& KeyId,
+        const TUInt64V& WordIdV, const bool& AllP, const int& Limit) const {
+
+    // prepare keys for gix, each word only once
+    TKeyWordV KeyWordV(WordIdV.Len(), 0);
+    for (const uint64 WordId : WordIdV) {
+        KeyWordV.Add(TKeyWord(KeyId, WordId));
+    }
+    KeyWordV.Merge();
+    // number of records for computing inverse document frequencies
+    const uint StoreId = IndexVoc->GetKey(KeyId).GetStoreId();
+    const TWPt<TStore> Store = Base->GetStoreByStoreId(StoreId);
+    const uint64 Recs = Store->GetRecs();
+    // check which Gix to use
+    const TIndexKeyGixType GixType = GetGixType(KeyId);
+    TUInt64IntKdV RecIdFqV;
+    {
+        TLock Lock(GetGixSection(GixType));
+        switch (GixType) {
+        case oikgtFull: DoQueryTopK(GixFull, KeyWordV, AllP, Recs, Limit, RecIdFqV); break;
+        case oikgtSmall: DoQueryTopK(GixSmall, KeyWordV, AllP, Recs, Limit, RecIdFqV); break;
+        case oikgtTiny: DoQueryTopK(GixTiny, KeyWordV, AllP, Recs, Limit, RecIdFqV); break;
+        case oikgtPacked:
+            if (HasGixPacked()) { DoQueryTopK(GixPacked, KeyWordV, AllP, Recs, Limit, RecIdFqV); }
+            break;
+        default:
+            throw TQmExcept::New("[TIndex::SearchGixTopK] Unsupported gix type!");
+        }
+    }
+    // records are ordered by score
+    return TRecSet::New(Store, RecIdFqV, true);
+}
+
+int TIndex::GetGixItems(const int& KeyId, const uint64& WordId) const {
+    // prepare key for gix
+    TKeyWord KeyWord(KeyId, WordId);
+    // check which Gix to use
+    const TIndexKeyGixType GixType = GetGixType(KeyId);
+    TLock Lock(GetGixSection(GixType));
+    switch (GixType) {
+    case oikgtFull: return GixFull->GetItems(KeyWord);
+    case oikgtSmall: return GixSmall->GetItems(KeyWord);
+    case oikgtTiny: return GixTiny->GetItems(KeyWord);
+    case oikgtPacked: return HasGixPacked() ? GixPacked->GetItems(KeyWord) : 0;
+    default: throw TQmExcept::New("[TIndex::GetGixItems] Unsupported gix type!");
+    }
+}
+
 void TIndex::SearchGixJoin(const int& KeyId, const uint64& RecId, TUInt64IntKdV& JoinRecIdFqV) const {
     // prepare key for gix
     TKeyWord KeyWord(KeyId, RecId);
@@ -6341,22 +8112,33 @@ void TIndex::SearchGixJoin(const int& KeyId, const uint64& RecId, TUInt64IntKdV&
     case oikgtTiny:
         DoQueryTiny(TQmGixExpItemTiny::NewItem(KeyWord), JoinRecIdFqV);
         break;
+    case oikgtPacked:
+        DoQueryPacked(TQmGixExpItemFull::NewItem(KeyWord), JoinRecIdFqV);
+        break;
     default:
         throw TQmExcept::New("[TIndex::SearchGixJoin] Unsupported gix type!");
     }
 }
 
-void TIndex::SearchGixJoin(const int& KeyId, const TUInt64V& RecIdV, TUInt64IntKdV& JoinRecIdFqV) const {
+void TIndex::SearchGixJoin(const int& KeyId, const TUInt64V& RecIdV,
+        TUInt64IntKdV& JoinRecIdFqV, const int& Threads) const {
     // check which Gix to use
     const TIndexKeyGixType GixType = GetGixType(KeyId);
     // go to appropriate gix and always first check if we have the key at all
     switch (GixType) {
     case oikgtFull:
-        DoJoinQueryFull(KeyId, RecIdV, JoinRecIdFqV); break;
+        DoJoinQuery(GixFull, GixFullSection, KeyId, RecIdV, Threads, JoinRecIdFqV); break;
     case oikgtSmall:
-        DoJoinQuerySmall(KeyId, RecIdV, JoinRecIdFqV); break;
+        DoJoinQuery(GixSmall, GixSmallSection, KeyId, RecIdV, Threads, JoinRecIdFqV); break;
     case oikgtTiny:
-        DoJoinQueryTiny(KeyId, RecIdV, JoinRecIdFqV); break;
+        DoJoinQuery(GixTiny, GixTinySection, KeyId, RecIdV, Threads, JoinRecIdFqV); break;
+    case oikgtPacked:
+        if (HasGixPacked()) {
+            DoJoinQuery(GixPacked, GixPackedSection, KeyId, RecIdV, Threads, JoinRecIdFqV);
+        } else {
+            JoinRecIdFqV.Clr();
+        }
+        break;
     default:
         throw TQmExcept::New("[TIndex::SearchGixJoin] Unsupported gix type!");
     }
@@ -6378,6 +8160,7 @@ PRecSet TIndex::SearchGeoRange(const TWPt<TBase>& Base, const int& KeyId,
     TUInt64V RecIdV;
     const uint StoreId = IndexVoc->GetKey(KeyId).GetStoreId();
     if (GeoIndexH.IsKey(KeyId)) { GeoIndexH.GetDat(KeyId)->SearchRange(Loc, Radius, Limit, RecIdV); }
+    if (GeoCellIndexH.IsKey(KeyId)) { GeoCellIndexH.GetDat(KeyId)->SearchRange(Loc, Radius, Limit, RecIdV); }
     return TRecSet::New(Base->GetStoreByStoreId(StoreId), RecIdV);
 }
 
@@ -6387,6 +8170,17 @@ PRecSet TIndex::SearchGeoNn(const TWPt<TBase>& Base, const int& KeyId,
     TUInt64V RecIdV;
     const uint StoreId = IndexVoc->GetKey(KeyId).GetStoreId();
     if (GeoIndexH.IsKey(KeyId)) { GeoIndexH.GetDat(KeyId)->SearchNn(Loc, Limit, RecIdV); }
+    if (GeoCellIndexH.IsKey(KeyId)) { GeoCellIndexH.GetDat(KeyId)->SearchNn(Loc, Limit, RecIdV); }
+    return TRecSet::New(Base->GetStoreByStoreId(StoreId), RecIdV);
+}
+
+PRecSet TIndex::SearchGeoArea(const TWPt<TBase>& Base, const int& KeyId,
+        const TFltPrV& AreaV, const TFltPr& Loc, const int& Limit) const {
+
+    TUInt64V RecIdV;
+    const uint StoreId = IndexVoc->GetKey(KeyId).GetStoreId();
+    if (GeoIndexH.IsKey(KeyId)) { GeoIndexH.GetDat(KeyId)->SearchArea(AreaV, Loc, Limit, RecIdV); }
+    if (GeoCellIndexH.IsKey(KeyId)) { GeoCellIndexH.GetDat(KeyId)->SearchArea(AreaV, Loc, Limit, RecIdV); }
     return TRecSet::New(Base->GetStoreByStoreId(StoreId), RecIdV);
 }
 
@@ -6501,6 +8295,8 @@ bool TIndex::HasJoin(const int& JoinKeyId, const uint64& RecId) const
         return GixSmall->IsKey(KeyWord);
     case oikgtTiny:
         return GixTiny->IsKey(KeyWord);
+    case oikgtPacked:
+        return HasGixPacked() && GixPacked->IsKey(KeyWord);
     default:
         throw TQmExcept::New("[TIndex::HasJoin] Unsupported gix type!");
     }
@@ -6510,19 +8306,23 @@ void TIndex::SaveTxt(const TWPt<TBase>& Base, const TStr& FNm) {
     GixFull->SaveTxt(FNm + ".full", TQmGixKeyStr::New(Base, IndexVoc));
     GixSmall->SaveTxt(FNm + ".small", TQmGixKeyStr::New(Base, IndexVoc));
     GixTiny->SaveTxt(FNm + ".tiny", TQmGixKeyStr::New(Base, IndexVoc));
+    if (HasGixPacked()) { GixPacked->SaveTxt(FNm + ".packed", TQmGixKeyStr::New(Base, IndexVoc)); }
 }
 
 TBlobBsStats TIndex::GetBlobStats() const {
     TBlobBsStats Stats = GixFull->GetBlobStats();
     Stats.Add(GixSmall->GetBlobStats());
     Stats.Add(GixTiny->GetBlobStats());
+    if (HasGixPacked()) { Stats.Add(GixPacked->GetBlobStats()); }
     return Stats;
 }
 
 TGixStats TIndex::GetGixStats(const bool& RefreshP) const {
-    TGixStats Stats = GixFull->GetGixStats(RefreshP);
-    Stats.Add(GixSmall->GetGixStats(RefreshP));
-    Stats.Add(GixTiny->GetGixStats(RefreshP));
+    TGixStats Stats;
+    { TLock Lock(GixFullSection); Stats = GixFull->GetGixStats(RefreshP); }
+    { TLock Lock(GixSmallSection); Stats.Add(GixSmall->GetGixStats(RefreshP)); }
+    { TLock Lock(GixTinySection); Stats.Add(GixTiny->GetGixStats(RefreshP)); }
+    if (HasGixPacked()) { TLock Lock(GixPackedSection); Stats.Add(GixPacked->GetGixStats(RefreshP)); }
     return Stats;
 }
 
@@ -6530,6 +8330,7 @@ int TIndex::GetSplitLen() const {
     // make sure small and full have same settings
     EAssert(GixFull->GetSplitLen() == GixSmall->GetSplitLen());
     EAssert(GixFull->GetSplitLen() == GixTiny->GetSplitLen());
+    EAssert(!HasGixPacked() || GixFull->GetSplitLen() == GixPacked->GetSplitLen());
     // return
     return GixFull->GetSplitLen();
 }
@@ -6538,14 +8339,63 @@ void TIndex::ResetStats() {
     GixFull->ResetStats();
     GixSmall->ResetStats();
     GixTiny->ResetStats();
+    if (HasGixPacked()) { GixPacked->ResetStats(); }
+}
+
+int TIndex::PartialFlushBTree(const int& WndInMsec) {
+    // each paged index gets at most the whole window
+    int Res = 0;
+    Res += PartialFlushBTreeIndexH(BTreeIndexByteH, WndInMsec);
+    Res += PartialFlushBTreeIndexH(BTreeIndexIntH, WndInMsec);
+    Res += PartialFlushBTreeIndexH(BTreeIndexInt16H, WndInMsec);
+    Res += PartialFlushBTreeIndexH(BTreeIndexInt64H, WndInMsec);
+    Res += PartialFlushBTreeIndexH(BTreeIndexUIntH, WndInMsec);
+    Res += PartialFlushBTreeIndexH(BTreeIndexUInt16H, WndInMsec);
+    Res += PartialFlushBTreeIndexH(BTreeIndexUInt64H, WndInMsec);
+    Res += PartialFlushBTreeIndexH(BTreeIndexFltH, WndInMsec);
+    Res += PartialFlushBTreeIndexH(BTreeIndexSFltH, WndInMsec);
+    // paged location indexes are b-trees as well
+    int KeyId = GeoCellIndexH.FFirstKeyId();
+    while (GeoCellIndexH.FNextKeyId(KeyId)) { Res += GeoCellIndexH[KeyId]->PartialFlush(WndInMsec); }
+    return Res;
+}
+
+void TIndex::StartLinearBulk(const int& KeyId) {
+    QmAssertR(!IsReadOnly(), "Cannot edit read-only index!");
+    BulkLinearKeyIdSet.AddKey(KeyId);
+    // b-tree index of the key is created with the first value, unless we already have it
+    if (BTreeIndexByteH.IsKey(KeyId)) { BTreeIndexByteH.GetDat(KeyId)->StartBulk(); }
+    if (BTreeIndexIntH.IsKey(KeyId)) { BTreeIndexIntH.GetDat(KeyId)->StartBulk(); }
+    if (BTreeIndexInt16H.IsKey(KeyId)) { BTreeIndexInt16H.GetDat(KeyId)->StartBulk(); }
+    if (BTreeIndexInt64H.IsKey(KeyId)) { BTreeIndexInt64H.GetDat(KeyId)->StartBulk(); }
+    if (BTreeIndexUIntH.IsKey(KeyId)) { BTreeIndexUIntH.GetDat(KeyId)->StartBulk(); }
+    if (BTreeIndexUInt16H.IsKey(KeyId)) { BTreeIndexUInt16H.GetDat(KeyId)->StartBulk(); }
+    if (BTreeIndexUInt64H.IsKey(KeyId)) { BTreeIndexUInt64H.GetDat(KeyId)->StartBulk(); }
+    if (BTreeIndexFltH.IsKey(KeyId)) { BTreeIndexFltH.GetDat(KeyId)->StartBulk(); }
+    if (BTreeIndexSFltH.IsKey(KeyId)) { BTreeIndexSFltH.GetDat(KeyId)->StartBulk(); }
+}
+
+void TIndex::EndLinearBulk(const int& KeyId) {
+    BulkLinearKeyIdSet.DelIfKey(KeyId);
+    EndBTreeIndexBulkH(BTreeIndexByteH, KeyId);
+    EndBTreeIndexBulkH(BTreeIndexIntH, KeyId);
+    EndBTreeIndexBulkH(BTreeIndexInt16H, KeyId);
+    EndBTreeIndexBulkH(BTreeIndexInt64H, KeyId);
+    EndBTreeIndexBulkH(BTreeIndexUIntH, KeyId);
+    EndBTreeIndexBulkH(BTreeIndexUInt16H, KeyId);
+    EndBTreeIndexBulkH(BTreeIndexUInt64H, KeyId);
+    EndBTreeIndexBulkH(BTreeIndexFltH, KeyId);
+    EndBTreeIndexBulkH(BTreeIndexSFltH, KeyId);
 }
 
 int TIndex::PartialFlush(const int& WndInMsec) {
-    const int WndInMsecPerGix = WndInMsec / 3;
+    const int WndInMsecPerGix = WndInMsec / 5;
     int Res = 0;
-    Res += GixFull->PartialFlush(WndInMsecPerGix);
-    Res += GixSmall->PartialFlush(WndInMsecPerGix);
-    Res += GixTiny->PartialFlush(WndInMsecPerGix);
+    { TLock Lock(GixFullSection); Res += GixFull->PartialFlush(WndInMsecPerGix); }
+    { TLock Lock(GixSmallSection); Res += GixSmall->PartialFlush(WndInMsecPerGix); }
+    { TLock Lock(GixTinySection); Res += GixTiny->PartialFlush(WndInMsecPerGix); }
+    if (HasGixPacked()) { TLock Lock(GixPackedSection); Res += GixPacked->PartialFlush(WndInMsecPerGix); }
+    Res += PartialFlushBTree(WndInMsecPerGix);
     return Res;
 }
 
@@ -6598,6 +8448,7 @@ void TStreamAggr::Init() {
     Register<TStreamAggrs::TAggrResampler>();
     Register<TStreamAggrs::TFtrExtAggr>();
     Register<TStreamAggrs::TNNAnomalyAggr>();
+    Register<TStreamAggrs::TOnlineKMeans>();
     Register<TStreamAggrs::TOnlineHistogram>();
     Register<TStreamAggrs::TTDigest>();
     Register<TStreamAggrs::TChiSquare>();
@@ -6683,6 +8534,8 @@ TStreamAggrSet::TStreamAggrSet(const TWPt<TBase>& _Base, const PJsonVal& ParamVa
         // get it and add it to the set
         AddStreamAggr(GetBase()->GetStreamAggr(SubAggrNm));
     }
+    // update independent aggregates in parallel
+    ParallelP = ParamVal->GetObjBool("parallel", false);
 }
 
 PStreamAggr TStreamAggrSet::New(const TWPt<TBase>& Base) {
@@ -6710,6 +8563,8 @@ void TStreamAggrSet::AddStreamAggr(const PStreamAggr& StreamAggr) {
     QmAssertR(GetBase()->IsStreamAggr(StreamAggr->GetAggrNm()),
         "[TStreamAggrSet] Unregistered stream aggregate " + StreamAggr->GetAggrNm());
     StreamAggrV.Add(StreamAggr());
+    // waves are recomputed on next update
+    WaveV.Clr();
 }
 
 const TWPt<TStreamAggr>& TStreamAggrSet::GetStreamAggr(const int& StreamAggrN) const {
@@ -6724,6 +8579,69 @@ TStrV TStreamAggrSet::GetStreamAggrNmV() const {
     return StreamAggrNmV;
 }
 
+void TStreamAggrSet::InitWaves() {
+    // get inputs of all aggregates
+    TVec<TStrV> InAggrNmVV(StreamAggrV.Len());
+    for (int AggrN = 0; AggrN < StreamAggrV.Len(); AggrN++) {
+        StreamAggrV[AggrN]->GetInAggrNmV(InAggrNmVV[AggrN]);
+    }
+    // assign waves so each aggregate is updated after the aggregates it reads from and
+    // after the aggregates that come before it in the set and read from it
+    TIntV AggrWaveV(StreamAggrV.Len());
+    int MnWaveN = 0, MxWaveN = -1;
+    for (int AggrN = 0; AggrN < StreamAggrV.Len(); AggrN++) {
+        const TStr& AggrNm = StreamAggrV[AggrN]->GetAggrNm();
+        int WaveN = MnWaveN;
+        for (int PrevAggrN = 0; PrevAggrN < AggrN; PrevAggrN++) {
+            const TStr& PrevAggrNm = StreamAggrV[PrevAggrN]->GetAggrNm();
+            if (PrevAggrNm == AggrNm || InAggrNmVV[AggrN].IsIn(PrevAggrNm) || InAggrNmVV[PrevAggrN].IsIn(AggrNm)) {
+                WaveN = TInt::GetMx(WaveN, AggrWaveV[PrevAggrN] + 1);
+            }
+        }
+        if (!StreamAggrV[AggrN]->IsThreadSafe() || !StreamAggrV[AggrN]->IsInAggrNmVDeclared()) {
+            // updated alone, after all preceding and before all following aggregates
+            WaveN = MxWaveN + 1; MnWaveN = WaveN + 1;
+        }
+        AggrWaveV[AggrN] = WaveN;
+        MxWaveN = TInt::GetMx(MxWaveN, WaveN);
+    }
+    WaveV.Gen(MxWaveN + 1);
+    for (int AggrN = 0; AggrN < StreamAggrV.Len(); AggrN++) {
+        WaveV[AggrWaveV[AggrN]].Add(AggrN);
+    }
+}
+
+template <class TOnAggr>
+void TStreamAggrSet::ExecAggrs(const TOnAggr& OnAggr) {
+    if (!ParallelP) {
+        for (TWPt<TStreamAggr>& StreamAggr : StreamAggrV) {
+            OnAggr(StreamAggr);
+        }
+        return;
+    }
+    if (WaveV.Empty()) { InitWaves(); }
+    for (const TIntV& AggrNV : WaveV) {
+        if (AggrNV.Len() == 1) {
+            OnAggr(StreamAggrV[AggrNV[0]]);
+            continue;
+        }
+        int ErrorN = AggrNV.Len(); PExcept ErrorExcept;
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (int AggrNN = 0; AggrNN < AggrNV.Len(); AggrNN++) {
+            try {
+                OnAggr(StreamAggrV[AggrNV[AggrNN]]);
+            } catch (const PExcept& Except) {
+                #pragma omp critical
+                {
+                    // report error of the first failed aggregate
+                    if (AggrNN < ErrorN) { ErrorN = AggrNN; ErrorExcept = Except; }
+                }
+            }
+        }
+        if (!ErrorExcept.Empty()) { throw ErrorExcept; }
+    }
+}
+
 void TStreamAggrSet::Reset() {
     for (TWPt<TStreamAggr>& StreamAggr : StreamAggrV) {
         StreamAggr->Reset();
@@ -6732,37 +8650,27 @@ void TStreamAggrSet::Reset() {
 
 void TStreamAggrSet::OnStep(const TWPt<TStreamAggr>& CallerAggr) {
     TScopeStopWatch StopWatch(ExeTm);
-    for (TWPt<TStreamAggr>& StreamAggr : StreamAggrV) {
-        StreamAggr->OnStep(this);
-    }
+    ExecAggrs([this](TWPt<TStreamAggr>& StreamAggr) { StreamAggr->OnStep(this); });
 }
 
 void TStreamAggrSet::OnTime(const uint64& TmMsec, const TWPt<TStreamAggr>& CallerAggr) {
     TScopeStopWatch StopWatch(ExeTm);
-    for (TWPt<TStreamAggr>& StreamAggr : StreamAggrV) {
-        StreamAggr->OnTime(TmMsec, this);
-    }
+    ExecAggrs([this, &TmMsec](TWPt<TStreamAggr>& StreamAggr) { StreamAggr->OnTime(TmMsec, this); });
 }
 
 void TStreamAggrSet::OnAddRec(const TRec& Rec, const TWPt<TStreamAggr>& CallerAggr) {
     TScopeStopWatch StopWatch(ExeTm);
-    for (TWPt<TStreamAggr>& StreamAggr : StreamAggrV) {
-        StreamAggr->OnAddRec(Rec, this);
-    }
+    ExecAggrs([this, &Rec](TWPt<TStreamAggr>& StreamAggr) { StreamAggr->OnAddRec(Rec, this); });
 }
 
 void TStreamAggrSet::OnUpdateRec(const TRec& Rec, const TWPt<TStreamAggr>& CallerAggr) {
     TScopeStopWatch StopWatch(ExeTm);
-    for (TWPt<TStreamAggr>& StreamAggr : StreamAggrV) {
-        StreamAggr->OnUpdateRec(Rec, this);
-    }
+    ExecAggrs([this, &Rec](TWPt<TStreamAggr>& StreamAggr) { StreamAggr->OnUpdateRec(Rec, this); });
 }
 
 void TStreamAggrSet::OnDeleteRec(const TRec& Rec, const TWPt<TStreamAggr>& CallerAggr) {
     TScopeStopWatch StopWatch(ExeTm);
-    for (TWPt<TStreamAggr>& StreamAggr : StreamAggrV) {
-        StreamAggr->OnDeleteRec(Rec, this);
-    }
+    ExecAggrs([this, &Rec](TWPt<TStreamAggr>& StreamAggr) { StreamAggr->OnDeleteRec(Rec, this); });
 }
 
 void TStreamAggrSet::PrintStat() const {
@@ -6800,23 +8708,245 @@ void TStreamAggrTrigger::OnDelete(const TRec& Rec) {
 
 ///////////////////////////////
 // QMiner-Base
-PRecSet TBase::Invert(const PRecSet& RecSet) {
-    // prepare sorted list of all records from the store
-    TUInt64IntKdV AllResIdV;
+PRecSet TBase::Invert(const PRecSet& RecSet, const int& MxRecs) {
     const TWPt<TStore>& Store = RecSet->GetStore();
-    PStoreIter Iter = Store->GetIter();
-    while (Iter->Next()) {
-        AllResIdV.Add(TUInt64IntKd(Iter->GetRecId(), 1));
-    }
-    if (!AllResIdV.IsSorted()) { AllResIdV.Sort(); }
-    // remove retrieved items
+    // records which should be left out, sorted
+    TUInt64IntKdV SortRecIdFqV;
+    if (!RecSet->GetRecIdFqV().IsSorted()) {
+        SortRecIdFqV = RecSet->GetRecIdFqV(); SortRecIdFqV.Sort();
+    }
+    const TUInt64IntKdV& RecIdFqV = SortRecIdFqV.Empty() ? RecSet->GetRecIdFqV() : SortRecIdFqV;
+    // upper bound on the number of records in the result
+    uint64 ResRecs = Store->GetRecs() - TMath::Mn(Store->GetRecs(), (uint64)RecIdFqV.Len());
+    if (MxRecs != -1) { ResRecs = TMath::Mn(ResRecs, (uint64)MxRecs); }
     TUInt64IntKdV ResIdFqV;
-    AllResIdV.Diff(RecSet->GetRecIdFqV(), ResIdFqV);
+    if (Store->HasFirstRecId() && Store->HasLastRecId()) {
+        // walk over record ids in order and skip the retrieved ones, without
+        // materializing the list of all records from the store
+        ResIdFqV.Gen((int)ResRecs, 0);
+        if (!Store->Empty()) {
+            const uint64 LastRecId = Store->GetLastRecId();
+            int RecN = 0;
+            for (uint64 RecId = Store->GetFirstRecId(); RecId <= LastRecId; RecId++) {
+                if (MxRecs != -1 && ResIdFqV.Len() >= MxRecs) { break; }
+                while (RecN < RecIdFqV.Len() && RecIdFqV[RecN].Key < RecId) { RecN++; }
+                if (RecN < RecIdFqV.Len() && RecIdFqV[RecN].Key == RecId) { continue; }
+                if (!Store->IsRecId(RecId)) { continue; }
+                ResIdFqV.Add(TUInt64IntKd(RecId, 1));
+            }
+        }
+    } else {
+        // prepare sorted list of all records from the store
+        TUInt64IntKdV AllResIdV;
+        PStoreIter Iter = Store->GetIter();
+        while (Iter->Next()) {
+            AllResIdV.Add(TUInt64IntKd(Iter->GetRecId(), 1));
+        }
+        if (!AllResIdV.IsSorted()) { AllResIdV.Sort(); }
+        // remove retrieved items
+        AllResIdV.Diff(RecIdFqV, ResIdFqV);
+        if (MxRecs != -1 && ResIdFqV.Len() > MxRecs) { ResIdFqV.Trunc(MxRecs); }
+    }
     // return new record set
     return TRecSet::New(Store, ResIdFqV, false);
 }
 
-TPair<TBool, PRecSet> TBase::_Search(const TQueryItem& QueryItem) {
+int TBase::GetQueryItemRecs(const TQueryItem& QueryItem, const int& MxRecs) const {
+    if (QueryItem.IsGix()) {
+        if (QueryItem.IsEqual()) {
+            // all words must match, so we can not get more than the rarest one
+            int MnRecs = TInt::Mx;
+            for (const TUInt64& WordId : QueryItem.GetWordIdV()) {
+                MnRecs = TInt::GetMn(MnRecs, Index->GetGixItems(QueryItem.GetKeyId(), WordId));
+            }
+            return MnRecs;
+        } else if (QueryItem.IsGreater() || QueryItem.IsLess() || QueryItem.IsWildChar()) {
+            // any word can match
+            int64 SumRecs = 0;
+            for (const TUInt64& WordId : QueryItem.GetWordIdV()) {
+                SumRecs += Index->GetGixItems(QueryItem.GetKeyId(), WordId);
+            }
+            return (int)TMath::Mn(SumRecs, (int64)TInt::Mx);
+        }
+    } else if (QueryItem.IsTextPos()) {
+        // all words must appear in the record
+        int MnRecs = TInt::Mx;
+        for (const TUInt64& WordId : QueryItem.GetWordIdV()) {
+            MnRecs = TInt::GetMn(MnRecs, Index->GetGixItems(QueryItem.GetKeyId(), WordId));
+        }
+        return MnRecs;
+    } else if (QueryItem.IsGeo()) {
+        // geo queries always have a limit
+        return QueryItem.GetLocLimit();
+    } else if (QueryItem.IsRange()) {
+        // count records in the b-tree, but only as far as needed
+        const int KeyId = QueryItem.GetKeyId();
+        if (QueryItem.IsRangeInt()) {
+            return Index->CountLinear(KeyId, QueryItem.GetRangeIntMinMax(), MxRecs);
+        } else if (QueryItem.IsRangeInt16()) {
+            return Index->CountLinear(KeyId, QueryItem.GetRangeInt16MinMax(), MxRecs);
+        } else if (QueryItem.IsRangeInt64()) {
+            return Index->CountLinear(KeyId, QueryItem.GetRangeInt64MinMax(), MxRecs);
+        } else if (QueryItem.IsRangeByte()) {
+            return Index->CountLinear(KeyId, QueryItem.GetRangeByteMinMax(), MxRecs);
+        } else if (QueryItem.IsRangeUInt()) {
+            return Index->CountLinear(KeyId, QueryItem.GetRangeUIntMinMax(), MxRecs);
+        } else if (QueryItem.IsRangeUInt16()) {
+            return Index->CountLinear(KeyId, QueryItem.GetRangeUInt16MinMax(), MxRecs);
+        } else if (QueryItem.IsRangeUInt64() || QueryItem.IsRangeTm()) {
+            return Index->CountLinear(KeyId, QueryItem.GetRangeUInt64MinMax(), MxRecs);
+        } else if (QueryItem.IsRangeFlt()) {
+            return Index->CountLinear(KeyId, QueryItem.GetRangeFltMinMax(), MxRecs);
+        } else if (QueryItem.IsRangeSFlt()) {
+            return Index->CountLinear(KeyId, QueryItem.GetRangeSFltMinMax(), MxRecs);
+        }
+    } else if (QueryItem.IsRec()) {
+        return 1;
+    } else if (QueryItem.IsRecSet()) {
+        return QueryItem.GetRecSet()->GetRecs();
+    } else if (QueryItem.IsStore()) {
+        return (int)TMath::Mn(GetStoreByStoreId(QueryItem.GetStoreId())->GetRecs(), (uint64)TInt::Mx);
+    } else if (QueryItem.IsAnd()) {
+        int MnRecs = TInt::Mx;
+        for (int ItemN = 0; ItemN < QueryItem.GetItems(); ItemN++) {
+            MnRecs = TInt::GetMn(MnRecs, GetQueryItemRecs(QueryItem.GetItem(ItemN), TInt::GetMn(MnRecs, MxRecs)));
+        }
+        return MnRecs;
+    } else if (QueryItem.IsOr()) {
+        int64 SumRecs = 0;
+        for (int ItemN = 0; ItemN < QueryItem.GetItems(); ItemN++) {
+            SumRecs += GetQueryItemRecs(QueryItem.GetItem(ItemN), MxRecs);
+        }
+        return (int)TMath::Mn(SumRecs, (int64)TInt::Mx);
+    }
+    // negations and everything else we can not estimate cheaply
+    return TInt::Mx;
+}
+
+bool TBase::IsQueryItemProbe(const TQueryItem& QueryItem) const {
+    if (!QueryItem.IsRange()) { return false; }
+    // linear keys index exactly one field
+    const TIndexKey& Key = IndexVoc->GetKey(QueryItem.GetKeyId());
+    if (!Key.IsLinear() || Key.GetFields() != 1) { return false; }
+    // records waiting to be indexed are not returned by index, so they must not be probed either
+    return !GetStoreByStoreId(Key.GetStoreId())->IsIndexingDeferred();
+}
+
+void TBase::ProbeQueryItem(const TQueryItem& QueryItem, TUInt64IntKdV& RecIdFqV) const {
+    const TIndexKey& Key = IndexVoc->GetKey(QueryItem.GetKeyId());
+    const int FieldId = Key.GetFieldId(0);
+    // filters drop records with null values, same as they are not in the index
+    PRecSet RecSet = TRecSet::New(GetStoreByStoreId(Key.GetStoreId()), RecIdFqV, true);
+    if (QueryItem.IsRangeInt()) {
+        const TIntPr MinMax = QueryItem.GetRangeIntMinMax();
+        RecSet->FilterByFieldInt(FieldId, MinMax.Val1, MinMax.Val2);
+    } else if (QueryItem.IsRangeInt16()) {
+        const TInt16Pr MinMax = QueryItem.GetRangeInt16MinMax();
+        RecSet->FilterByFieldInt16(FieldId, MinMax.Val1, MinMax.Val2);
+    } else if (QueryItem.IsRangeInt64()) {
+        const TInt64Pr MinMax = QueryItem.GetRangeInt64MinMax();
+        RecSet->FilterByFieldInt64(FieldId, MinMax.Val1, MinMax.Val2);
+    } else if (QueryItem.IsRangeByte()) {
+        const TUChPr MinMax = QueryItem.GetRangeByteMinMax();
+        RecSet->FilterByFieldByte(FieldId, MinMax.Val1, MinMax.Val2);
+    } else if (QueryItem.IsRangeUInt()) {
+        const TUIntUIntPr MinMax = QueryItem.GetRangeUIntMinMax();
+        RecSet->FilterByFieldUInt(FieldId, MinMax.Val1, MinMax.Val2);
+    } else if (QueryItem.IsRangeUInt16()) {
+        const TUInt16Pr MinMax = QueryItem.GetRangeUInt16MinMax();
+        RecSet->FilterByFieldUInt16(FieldId, MinMax.Val1, MinMax.Val2);
+    } else if (QueryItem.IsRangeUInt64()) {
+        const TUInt64Pr MinMax = QueryItem.GetRangeUInt64MinMax();
+        RecSet->FilterByFieldUInt64(FieldId, MinMax.Val1, MinMax.Val2);
+    } else if (QueryItem.IsRangeTm()) {
+        const TUInt64Pr MinMax = QueryItem.GetRangeUInt64MinMax();
+        RecSet->FilterByFieldTm(FieldId, MinMax.Val1.Val, MinMax.Val2.Val);
+    } else if (QueryItem.IsRangeFlt()) {
+        const TFltPr MinMax = QueryItem.GetRangeFltMinMax();
+        RecSet->FilterByFieldFlt(FieldId, MinMax.Val1, MinMax.Val2);
+    } else if (QueryItem.IsRangeSFlt()) {
+        const TSFltPr MinMax = QueryItem.GetRangeSFltMinMax();
+        RecSet->FilterByFieldSFlt(FieldId, MinMax.Val1, MinMax.Val2);
+    } else {
+        throw TQmExcept::New("Unsupported range query item");
+    }
+    RecIdFqV = RecSet->GetRecIdFqV();
+}
+
+PJsonVal TBase::GetQueryStep(const TQueryItem& QueryItem, const TStr& StrategyStr,
+        const int& Recs, const bool& NotP, const double& MSecs) const {
+    PJsonVal StepVal = TJsonVal::NewObj();
+    StepVal->AddToObj("type", QueryItem.GetTypeStr());
+    if (QueryItem.IsGix() || QueryItem.IsTextPos() || QueryItem.IsGeo() || QueryItem.IsRange()) {
+        StepVal->AddToObj("key", IndexVoc->GetKey(QueryItem.GetKeyId()).GetKeyNm());
+    }
+    const int EstRecs = GetQueryItemRecs(QueryItem);
+    StepVal->AddToObj("estimate", (EstRecs == TInt::Mx) ? -1 : EstRecs);
+    StepVal->AddToObj("strategy", StrategyStr);
+    StepVal->AddToObj("records", Recs);
+    StepVal->AddToObj("negated", NotP);
+    StepVal->AddToObj("time", MSecs);
+    return StepVal;
+}
+
+TPair<TBool, PRecSet> TBase::_Search(const TQueryItem& QueryItem, const int& Threads, const PJsonVal& PlanVal) {
+    // when explaining the query, sub-steps are collected for the step of this item
+    PJsonVal ItemsVal = PlanVal.Empty() ? PJsonVal() : TJsonVal::NewArr();
+    TTmStopWatch StopWatch(true);
+    TPair<TBool, PRecSet> NotRecSet; bool CacheP = false;
+    if (QueryCache.Empty() || !QueryItem.IsCacheable() || QueryItem.IsNot()) {
+        // records given by value are returned directly and negation only flips the flag
+        NotRecSet = _SearchItem(QueryItem, Threads, ItemsVal);
+    } else {
+        TUIntSet StoreIdSet;
+        const TStr CacheKey = QueryItem.GetCacheKey(this, StoreIdSet);
+        CacheP = QueryCache->Get(this, CacheKey, NotRecSet);
+        if (!CacheP) {
+            NotRecSet = _SearchItem(QueryItem, Threads, ItemsVal);
+            QueryCache->Put(this, CacheKey, StoreIdSet, NotRecSet);
+        }
+    }
+    if (!PlanVal.Empty()) {
+        const TStr StrategyStr = CacheP ? "cache" : (QueryItem.IsItems() ? "merge" : "index");
+        PJsonVal StepVal = GetQueryStep(QueryItem, StrategyStr, NotRecSet.Val2->GetRecs(),
+            NotRecSet.Val1, StopWatch.GetMSec());
+        if (ItemsVal->GetArrVals() > 0) { StepVal->AddToObj("items", ItemsVal); }
+        PlanVal->AddToArr(StepVal);
+    }
+    return NotRecSet;
+}
+
+void TBase::_SearchItems(const TQueryItem& QueryItem, const TIntV& ItemNV, const int& Threads,
+        const PJsonVal& PlanVal, TVec<TPair<TBool, PRecSet> >& NotRecSetV) {
+
+    const int Items = ItemNV.Len();
+    NotRecSetV.Gen(Items);
+    if (Threads <= 1 || Items <= 1) {
+        for (int ItemN = 0; ItemN < Items; ItemN++) {
+            NotRecSetV[ItemN] = _Search(QueryItem.GetItem(ItemNV[ItemN]), Threads, PlanVal);
+        }
+        return;
+    }
+    // query plan is only collected when evaluating on one thread
+    QmAssert(PlanVal.Empty());
+    // items are independent, evaluate each in its own thread
+    int ErrorItemN = Items; PExcept ErrorExcept;
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(TInt::GetMn(Threads, Items))
+    for (int ItemN = 0; ItemN < Items; ItemN++) {
+        try {
+            NotRecSetV[ItemN] = _Search(QueryItem.GetItem(ItemNV[ItemN]), Threads, PJsonVal());
+        } catch (const PExcept& Except) {
+            #pragma omp critical
+            {
+                // remember the first failed item
+                if (ItemN < ErrorItemN) { ErrorItemN = ItemN; ErrorExcept = Except; }
+            }
+        }
+    }
+    if (!ErrorExcept.Empty()) { throw ErrorExcept; }
+}
+
+TPair<TBool, PRecSet> TBase::_SearchItem(const TQueryItem& QueryItem, const int& Threads, const PJsonVal& PlanVal) {
     if (QueryItem.IsGix()) {
         // we have gix query, check what is the comparison operator
         if (QueryItem.IsEqual() || QueryItem.IsNotEqual()) {
@@ -6844,7 +8974,12 @@ TPair<TBool, PRecSet> TBase::_Search(const TQueryItem& QueryItem) {
         // return the pair
         return TPair<TBool, PRecSet>(false, RecSet);
     } else if (QueryItem.IsGeo()) {
-        if (QueryItem.IsLocRadius()) {
+        if (QueryItem.IsLocArea()) {
+            // must be handled by geo index
+            PRecSet RecSet = Index->SearchGeoArea(this, QueryItem.GetKeyId(),
+                QueryItem.GetLocAreaV(), QueryItem.GetLoc(), QueryItem.GetLocLimit());
+            return TPair<TBool, PRecSet>(false, RecSet);
+        } else if (QueryItem.IsLocRadius()) {
             // must be handled by geo index
             PRecSet RecSet = Index->SearchGeoRange(this, QueryItem.GetKeyId(),
                 QueryItem.GetLoc(), QueryItem.GetLocRadius(), QueryItem.GetLocLimit());
@@ -6905,11 +9040,12 @@ TPair<TBool, PRecSet> TBase::_Search(const TQueryItem& QueryItem) {
             return TPair<TBool, PRecSet>(false, JoinRecSet);
         } else {
             // do the subordinate queries
-            TPair<TBool, PRecSet> NotRecSet = _Search(QueryItem.GetItem(0));
+            TPair<TBool, PRecSet> NotRecSet = _Search(QueryItem.GetItem(0), Threads, PlanVal);
             // in case it's negated, we must invert it
             if (NotRecSet.Val1) { NotRecSet.Val2 = Invert(NotRecSet.Val2); }
             // do the join
-            PRecSet JoinRecSet = NotRecSet.Val2->DoJoin(this, QueryItem.GetJoinId(), QueryItem.GetSampleSize());
+            PRecSet JoinRecSet = NotRecSet.Val2->DoJoin(this, QueryItem.GetJoinId(),
+                QueryItem.GetSampleSize(), false, Threads);
             // return joined record set
             return TPair<TBool, PRecSet>(false, JoinRecSet);
         }
@@ -6929,38 +9065,117 @@ TPair<TBool, PRecSet> TBase::_Search(const TQueryItem& QueryItem) {
     } else {
         // we have an operator, make sure it is so!
         QmAssert(QueryItem.IsAnd() || QueryItem.IsOr() || QueryItem.IsNot());
-        // exeucte all interal query items
-        TBoolV NotV; TRecSetV RecSetV;
-        for (int ItemN = 0; ItemN < QueryItem.GetItems(); ItemN++) {
-            // do subsequent search
-            TPair<TBool, PRecSet> NotRecSet = _Search(QueryItem.GetItem(ItemN));
-            NotV.Add(NotRecSet.Val1); RecSetV.Add(NotRecSet.Val2);
-        }
         // merge the results according to the operator
         if (QueryItem.IsAnd()) {
+            // probing one candidate record costs about as much as reading this many b-tree entries
+            const int ProbeCost = 8;
+            // order operands by estimated number of matching records, so we start with
+            // the most selective ones and keep the intermediate results small; ranges are
+            // counted last and only as far as needed to decide if they are worth probing
+            TIntPrV EstItemNV(QueryItem.GetItems(), 0); int MnRecs = TInt::Mx;
+            for (int ItemN = 0; ItemN < QueryItem.GetItems(); ItemN++) {
+                if (QueryItem.GetItem(ItemN).IsRange()) { continue; }
+                EstItemNV.Add(TIntPr(GetQueryItemRecs(QueryItem.GetItem(ItemN)), ItemN));
+                MnRecs = TInt::GetMn(MnRecs, EstItemNV.Last().Val1);
+            }
+            for (int ItemN = 0; ItemN < QueryItem.GetItems(); ItemN++) {
+                if (!QueryItem.GetItem(ItemN).IsRange()) { continue; }
+                const int MxRecs = (int)TMath::Mn((int64)MnRecs * ProbeCost + 1, (int64)TInt::Mx);
+                EstItemNV.Add(TIntPr(GetQueryItemRecs(QueryItem.GetItem(ItemN), MxRecs), ItemN));
+                MnRecs = TInt::GetMn(MnRecs, EstItemNV.Last().Val1);
+            }
+            EstItemNV.Sort();
+            // execute the first query item
+            TPair<TBool, PRecSet> FirstNotRecSet = _Search(QueryItem.GetItem(EstItemNV[0].Val2), Threads, PlanVal);
+            TWPt<TStore> Store = FirstNotRecSet.Val2->GetStore();
             // prepare working vectors with the first records set
-            TUInt64IntKdV ResRecIdFqV = RecSetV[0]->GetRecIdFqV();
+            TUInt64IntKdV ResRecIdFqV = FirstNotRecSet.Val2->GetRecIdFqV();
             QmAssert(ResRecIdFqV.IsSorted());
             // current negation status
-            bool NotP = NotV[0];
+            bool NotP = FirstNotRecSet.Val1;
+            // large unweighted results are combined as bitmaps
+            TRecIdBitmap ResBitmap; bool BitmapP = false;
+            // ranges much larger than the candidate set are not read from the index,
+            // instead we check field values of the candidates
+            auto IsProbe = [&](const int& EstItemN) {
+                return !NotP && !BitmapP && IsQueryItemProbe(QueryItem.GetItem(EstItemNV[EstItemN].Val2)) &&
+                    (int64)ResRecIdFqV.Len() * ProbeCost < (int64)EstItemNV[EstItemN].Val1;
+            };
+            // with more threads the remaining items are evaluated in parallel up front,
+            // otherwise one by one so we can stop as soon as the result is empty
+            TVec<TPair<TBool, PRecSet> > RestNotRecSetV; TBoolV RestProbeV;
+            if (Threads > 1 && (NotP || !ResRecIdFqV.Empty())) {
+                TIntV RestItemNV(EstItemNV.Len() - 1, 0);
+                for (int EstItemN = 1; EstItemN < EstItemNV.Len(); EstItemN++) {
+                    RestProbeV.Add(IsProbe(EstItemN));
+                    if (!RestProbeV.Last()) { RestItemNV.Add(EstItemNV[EstItemN].Val2); }
+                }
+                TVec<TPair<TBool, PRecSet> > EvalNotRecSetV;
+                _SearchItems(QueryItem, RestItemNV, Threads, PlanVal, EvalNotRecSetV);
+                // probed items have no results of their own
+                RestNotRecSetV.Gen(RestProbeV.Len()); int EvalN = 0;
+                for (int RestN = 0; RestN < RestProbeV.Len(); RestN++) {
+                    if (!RestProbeV[RestN]) { RestNotRecSetV[RestN] = EvalNotRecSetV[EvalN++]; }
+                }
+            }
             // than handle the rest here
-            for (int ItemN = 1; ItemN < RecSetV.Len(); ItemN++) {
+            for (int EstItemN = 1; EstItemN < EstItemNV.Len(); EstItemN++) {
+                // nothing can be added back by the remaining intersections
+                if (!NotP && (BitmapP ? ResBitmap.Empty() : ResRecIdFqV.Empty())) { break; }
+                const TQueryItem& Item = QueryItem.GetItem(EstItemNV[EstItemN].Val2);
+                // check the candidates directly when cheaper than reading the range
+                const bool ProbeP = RestProbeV.Empty() ? IsProbe(EstItemN) : RestProbeV[EstItemN - 1].Val;
+                if (ProbeP && !NotP && !BitmapP) {
+                    TTmStopWatch StopWatch(true);
+                    const int CandRecs = ResRecIdFqV.Len();
+                    ProbeQueryItem(Item, ResRecIdFqV);
+                    if (!PlanVal.Empty()) {
+                        PJsonVal StepVal = GetQueryStep(Item, "probe", ResRecIdFqV.Len(), false, StopWatch.GetMSec());
+                        StepVal->AddToObj("candidates", CandRecs);
+                        PlanVal->AddToArr(StepVal);
+                    }
+                    continue;
+                }
+                // do subsequent search
+                TPair<TBool, PRecSet> NotRecSet = (RestNotRecSetV.Empty() || ProbeP) ?
+                    _Search(Item, Threads, PlanVal) : RestNotRecSetV[EstItemN - 1];
+                const bool ItemNotP = NotRecSet.Val1;
                 // get the vector
-                const TUInt64IntKdV& RecIdFqV = RecSetV[ItemN]->GetRecIdFqV();
+                const TUInt64IntKdV& RecIdFqV = NotRecSet.Val2->GetRecIdFqV();
+                // switch to bitmaps once both sides are dense, weights are not needed
+                if (!BitmapP && !QueryItem.IsFq() && TRecIdBitmap::IsDense(ResRecIdFqV) &&
+                        TRecIdBitmap::IsDense(RecIdFqV)) {
+                    TRecIdBitmap(ResRecIdFqV).Swap(ResBitmap);
+                    ResRecIdFqV.Clr(); BitmapP = true;
+                }
                 // decide for the operation based on not status
-                if (!NotP && !NotV[ItemN]) {
+                if (BitmapP) {
+                    TRecIdBitmap Bitmap(RecIdFqV);
+                    if (!NotP && !ItemNotP) {
+                        ResBitmap.And(Bitmap);
+                    } else if (NotP && ItemNotP) {
+                        ResBitmap.Or(Bitmap);
+                    } else if (NotP && !ItemNotP) {
+                        Bitmap.AndNot(ResBitmap);
+                        ResBitmap.Swap(Bitmap);
+                        NotP = false;
+                    } else if (!NotP && ItemNotP) {
+                        ResBitmap.AndNot(Bitmap);
+                        NotP = false;
+                    }
+                } else if (!NotP && !ItemNotP) {
                     // life is easy, just do the intersect
                     Index->GetSumMerger()->Intrs(ResRecIdFqV, RecIdFqV);
-                } else if (NotP && NotV[ItemN]) {
+                } else if (NotP && ItemNotP) {
                     // all negation, do the union
                     Index->GetSumMerger()->Union(ResRecIdFqV, RecIdFqV);
-                } else if (NotP && !NotV[ItemN]) {
+                } else if (NotP && !ItemNotP) {
                     // records from RecIdFqV should not be in the main
                     TUInt64IntKdV _ResRecIdFqV;
                     Index->GetSumMerger()->Minus(RecIdFqV, ResRecIdFqV, _ResRecIdFqV);
                     ResRecIdFqV = _ResRecIdFqV;
                     NotP = false;
-                } else if (!NotP && NotV[ItemN]) {
+                } else if (!NotP && ItemNotP) {
                     // records from main should not be in the RecIdFqV
                     TUInt64IntKdV _ResRecIdFqV;
                     Index->GetSumMerger()->Minus(ResRecIdFqV, RecIdFqV, _ResRecIdFqV);
@@ -6968,21 +9183,55 @@ TPair<TBool, PRecSet> TBase::_Search(const TQueryItem& QueryItem) {
                     NotP = false;
                 }
             }
+            // convert back to vector only at the end
+            if (BitmapP) { ResBitmap.GetRecIdFqV(ResRecIdFqV); }
             // prepare resulting record set
-            PRecSet RecSet = TRecSet::New(RecSetV[0]->GetStore(), ResRecIdFqV, QueryItem.IsFq());
+            PRecSet RecSet = TRecSet::New(Store, ResRecIdFqV, QueryItem.IsFq());
             return TPair<TBool, PRecSet>(NotP, RecSet);
-        } else if (QueryItem.IsOr()) {
+        }
+        // exeucte all interal query items
+        TIntV ItemNV(QueryItem.GetItems(), 0);
+        for (int ItemN = 0; ItemN < QueryItem.GetItems(); ItemN++) { ItemNV.Add(ItemN); }
+        TVec<TPair<TBool, PRecSet> > NotRecSetV;
+        _SearchItems(QueryItem, ItemNV, Threads, PlanVal, NotRecSetV);
+        TBoolV NotV; TRecSetV RecSetV;
+        for (const TPair<TBool, PRecSet>& NotRecSet : NotRecSetV) {
+            NotV.Add(NotRecSet.Val1); RecSetV.Add(NotRecSet.Val2);
+        }
+        if (QueryItem.IsOr()) {
             // prepare working vectors with the first records set
             TUInt64IntKdV ResRecIdFqV = RecSetV[0]->GetRecIdFqV();
             QmAssert(ResRecIdFqV.IsSorted());
             // current negation status
             bool NotP = NotV[0];
+            // large unweighted results are combined as bitmaps
+            TRecIdBitmap ResBitmap; bool BitmapP = false;
             // than handle the rest here
             for (int ItemN = 1; ItemN < RecSetV.Len(); ItemN++) {
                 // get the vector
                 const TUInt64IntKdV& RecIdFqV = RecSetV[ItemN]->GetRecIdFqV();
+                // switch to bitmaps once both sides are dense, weights are not needed
+                if (!BitmapP && !QueryItem.IsFq() && TRecIdBitmap::IsDense(ResRecIdFqV) &&
+                        TRecIdBitmap::IsDense(RecIdFqV)) {
+                    TRecIdBitmap(ResRecIdFqV).Swap(ResBitmap);
+                    ResRecIdFqV.Clr(); BitmapP = true;
+                }
                 // decide for the operation based on not status
-                if (!NotP && !NotV[ItemN]) {
+                if (BitmapP) {
+                    TRecIdBitmap Bitmap(RecIdFqV);
+                    if (!NotP && !NotV[ItemN]) {
+                        ResBitmap.Or(Bitmap);
+                    } else if (NotP && NotV[ItemN]) {
+                        ResBitmap.And(Bitmap);
+                    } else if (NotP && !NotV[ItemN]) {
+                        ResBitmap.AndNot(Bitmap);
+                        NotP = true;
+                    } else if (!NotP && NotV[ItemN]) {
+                        Bitmap.AndNot(ResBitmap);
+                        ResBitmap.Swap(Bitmap);
+                        NotP = true;
+                    }
+                } else if (!NotP && !NotV[ItemN]) {
                     Index->GetSumMerger()->Union(ResRecIdFqV, RecIdFqV);
                 } else if (NotP && NotV[ItemN]) {
                     // all negation, do the intersect
@@ -7001,6 +9250,8 @@ TPair<TBool, PRecSet> TBase::_Search(const TQueryItem& QueryItem) {
                     NotP = true;
                 }
             }
+            // convert back to vector only at the end
+            if (BitmapP) { ResBitmap.GetRecIdFqV(ResRecIdFqV); }
             // prepare resulting record set
             PRecSet RecSet = TRecSet::New(RecSetV[0]->GetStore(), ResRecIdFqV, QueryItem.IsFq());
             return TPair<TBool, PRecSet>(NotP, RecSet);
@@ -7040,7 +9291,7 @@ void TBase::SaveBaseConf(const TStr& FPath) const {
 }
 
 TBase::TBase(const TStr& _FPath, const int64& IndexCacheSize, const TStrUInt64H& IndexTypeCacheSizeH,
-        const int& SplitLen, const bool& StrictNmP): InitP(false), NmValidator(StrictNmP) {
+        const int& SplitLen, const bool& StrictNmP): InitP(false), NmValidator(StrictNmP), QueryThreads(1) {
 
     IAssertR(TEnv::IsInit(), "QMiner environment (TQm::TEnv) is not initialized");
     // open as create
@@ -7053,6 +9304,7 @@ TBase::TBase(const TStr& _FPath, const int64& IndexCacheSize, const TStrUInt64H&
         IndexTypeCacheSizeH.GetDatOrDef("small", IndexCacheSize),
         IndexTypeCacheSizeH.GetDatOrDef("tiny", IndexCacheSize),
         IndexTypeCacheSizeH.GetDatOrDef("pos", IndexCacheSize),
+        IndexTypeCacheSizeH.GetDatOrDef("packed", IndexCacheSize),
         SplitLen);
     // initialize store blob base
     StoreBlobBs = TMBlobBs::New(FPath + "StoreBlob", FAccess);
@@ -7063,7 +9315,8 @@ TBase::TBase(const TStr& _FPath, const int64& IndexCacheSize, const TStrUInt64H&
 }
 
 TBase::TBase(const TStr& _FPath, const TFAccess& _FAccess, const int64& IndexCacheSize,
-        const TStrUInt64H& IndexTypeCacheSizeH, const int& SplitLen): InitP(false), NmValidator(true) {
+        const TStrUInt64H& IndexTypeCacheSizeH, const int& SplitLen): InitP(false), NmValidator(true),
+        QueryThreads(1) {
 
     IAssertR(TEnv::IsInit(), "QMiner environment (TQm::TEnv) is not initialized");
     // assert open type and remember location
@@ -7087,6 +9340,7 @@ TBase::TBase(const TStr& _FPath, const TFAccess& _FAccess, const int64& IndexCac
         IndexTypeCacheSizeH.GetDatOrDef("small", IndexCacheSize),
         IndexTypeCacheSizeH.GetDatOrDef("tiny", IndexCacheSize),
         IndexTypeCacheSizeH.GetDatOrDef("pos", IndexCacheSize),
+        IndexTypeCacheSizeH.GetDatOrDef("packed", IndexCacheSize),
         SplitLen);
     // load shared store blob base
     StoreBlobBs = TMBlobBs::New(FPath + "StoreBlob", FAccess);
@@ -7141,6 +9395,8 @@ void TBase::AddStore(const PStore& NewStore) {
     NewStore->AddTrigger(TStreamAggrTrigger::New(StreamAggrSet));
     // remember the aggregate base for the store
     StreamAggrSetV[StoreId] = dynamic_cast<TStreamAggrSet*>(StreamAggrSet());
+    // new store can reuse id of an old one
+    ClrQueryCache();
 }
 
 const TWPt<TStore> TBase::GetStoreByStoreN(const int& StoreN) const {
@@ -7235,13 +9491,37 @@ uint64 TBase::AddRec(const uint& StoreId, const PJsonVal& RecVal) {
 }
 
 PRecSet TBase::Search(const PQuery& Query) {
+    // relevance over one inverted index condition is ranked by BM25; when we only need
+    // top records, we can avoid computing all of them, otherwise all are ranked the same way
+    const TQueryItem& QueryItem = Query->GetQueryItem();
+    // queries parsed from JSon wrap a single condition in an AND item
+    const TQueryItem& GixItem = (QueryItem.IsAnd() && QueryItem.GetItems() == 1) ? QueryItem.GetItem(0) : QueryItem;
+    if (Query->IsSortRelevance() && GixItem.IsGix() && (GixItem.IsEqual() || GixItem.IsGreater() ||
+            GixItem.IsLess() || GixItem.IsWildChar())) {
+        // equality requires all words, other operators match any of them
+        PRecSet RecSet = Index->SearchGixTopK(this, GixItem.GetKeyId(), GixItem.GetWordIdV(),
+            GixItem.IsEqual(), Query->IsTopK() ? Query->GetTopK() : -1);
+        if (!RecSet->Empty() && !Query->GetAggrItemV().Empty()) {
+            // aggregates see records in order of IDs, same as for other queries
+            PRecSet AggrRecSet = RecSet->Clone(); AggrRecSet->SortById(true);
+            for (const TQueryAggr& QueryAggr : Query->GetAggrItemV()) {
+                RecSet->AddAggr(TAggr::New(this, AggrRecSet, QueryAggr));
+            }
+        }
+        return Query->IsLimit() ? Query->GetLimit(RecSet) : RecSet;
+    }
+    // independent parts of the query are evaluated in parallel only
+    // when all the stores it reads from allow it
+    const int Threads = Query->IsThreads() ? Query->GetThreads() : QueryThreads.Val;
+    const int SearchThreads = (Threads > 1 && QueryItem.IsConcurrent(this)) ? Threads : 1;
     // do the search
-    TPair<TBool, PRecSet> NotRecSet = _Search(Query->GetQueryItem());
+    TPair<TBool, PRecSet> NotRecSet = _Search(QueryItem, SearchThreads, PJsonVal());
     // take the resulting record set
     PRecSet RecSet = NotRecSet.Val2;
     Assert(!RecSet.Empty());
-    // if result should be negated, do the invert
-    if (NotRecSet.Val1) { RecSet = Invert(RecSet); }
+    // if result should be negated, do the invert; when only the first records
+    // are returned, we do not need to compute the rest of the complement
+    if (NotRecSet.Val1) { RecSet = Invert(RecSet, Query->IsPrefix() ? Query->GetTopK() : -1); }
     // get the aggregates
     Aggr(RecSet, Query->GetAggrItemV());
     // sort if necessary
@@ -7252,6 +9532,23 @@ PRecSet TBase::Search(const PQuery& Query) {
     return RecSet;
 }
 
+PJsonVal TBase::Explain(const PQuery& Query) {
+    TTmStopWatch StopWatch(true);
+    // collect executed steps of the query
+    PJsonVal PlanVal = TJsonVal::NewArr();
+    TPair<TBool, PRecSet> NotRecSet = _Search(Query->GetQueryItem(), 1, PlanVal);
+    PRecSet RecSet = NotRecSet.Val2;
+    if (NotRecSet.Val1) { RecSet = Invert(RecSet, Query->IsPrefix() ? Query->GetTopK() : -1); }
+    if (Query->IsSort()) { Query->Sort(this, RecSet); }
+    if (Query->IsLimit()) { RecSet = Query->GetLimit(RecSet); }
+    // describe the results
+    PJsonVal ExplainVal = TJsonVal::NewObj();
+    ExplainVal->AddToObj("records", RecSet->GetRecs());
+    ExplainVal->AddToObj("time", StopWatch.GetMSec());
+    ExplainVal->AddToObj("plan", PlanVal->GetArrVal(0));
+    return ExplainVal;
+}
+
 PRecSet TBase::Search(const TQueryItem& QueryItem) {
     return Search(TQuery::New(this, QueryItem));
 }
@@ -7264,6 +9561,29 @@ PRecSet TBase::Search(const PJsonVal& QueryVal) {
     return Search(TQuery::New(this, QueryVal));
 }
 
+void TBase::SetQueryThreads(const int& Threads) {
+    QmAssertR(Threads > 0, "Number of query threads must be positive");
+    QueryThreads = Threads;
+}
+
+void TBase::SetQueryCache(const int64& MxMemUsed) {
+    QmAssertR(MxMemUsed >= 0, "Query cache size must be non-negative");
+    QueryCache = (MxMemUsed > 0) ? TQueryCache::New(MxMemUsed) : PQueryCache();
+}
+
+PJsonVal TBase::GetQueryCacheStats() const {
+    if (QueryCache.Empty()) {
+        PJsonVal StatsVal = TJsonVal::NewObj();
+        StatsVal->AddToObj("hits", 0);
+        StatsVal->AddToObj("misses", 0);
+        StatsVal->AddToObj("items", 0);
+        StatsVal->AddToObj("memUsed", 0);
+        StatsVal->AddToObj("maxMemUsed", 0);
+        return StatsVal;
+    }
+    return QueryCache->GetStats();
+}
+
 void TBase::GarbageCollect(const int& MxTimeMSecs) {
     int StoreKeyId = StoreH.FFirstKeyId();
     while (StoreH.FNextKeyId(StoreKeyId)) {
@@ -11,6 +11,7 @@
 
 #include <base.h>
 #include <mine.h>
+#include <thread.h>
 
 namespace TQm {
 
@@ -106,7 +107,9 @@ typedef enum {
     oikgtUndef = 0,
     oikgtFull  = 1, ///< uint64 for recId and int for frequency
     oikgtSmall = 2, ///< uint for recid and short for frequency
-    oikgtTiny  = 3  ///< uint for recid and no frequency
+    oikgtTiny  = 3, ///< uint for recid and no frequency
+    oikgtPacked = 4, ///< uint64 for recid and int for frequency, child vectors delta and varint encoded
+    oikgtPaged = 5 ///< b-tree nodes of linear or location key kept on disk in paged blob
 } TIndexKeyGixType;
 
 ///////////////////////////////
@@ -296,6 +299,46 @@ public:
     void Load(TSIn& SIn);
 };
 
+///////////////////////////////
+/// Store time segment. Stores with time window can be partitioned into segments
+/// of consecutive records covering a fixed period of the window time field. Each
+/// segment keeps its record id range and the range of its time values, so whole
+/// segments can be expired or skipped by time filters without reading records.
+class TStoreSegment {
+public:
+    /// Start of the period covered by the segment
+    TUInt64 StartMSecs;
+    /// First record in the segment
+    TUInt64 FirstRecId;
+    /// Last record in the segment
+    TUInt64 LastRecId;
+    /// Smallest time value of records in the segment
+    TUInt64 MinMSecs;
+    /// Largest time value of records in the segment
+    TUInt64 MaxMSecs;
+
+public:
+    TStoreSegment() { }
+    TStoreSegment(const uint64& _StartMSecs, const uint64& RecId, const uint64& TmMSecs):
+        StartMSecs(_StartMSecs), FirstRecId(RecId), LastRecId(RecId),
+        MinMSecs(TmMSecs), MaxMSecs(TmMSecs) { }
+    TStoreSegment(TSIn& SIn) { Load(SIn); }
+
+    void Save(TSOut& SOut) const;
+    void Load(TSIn& SIn);
+
+    /// Number of records in the segment
+    uint64 GetRecs() const { return LastRecId - FirstRecId + 1; }
+    /// Is record in the segment
+    bool IsRecId(const uint64& RecId) const { return FirstRecId <= RecId && RecId <= LastRecId; }
+    /// Extend range of time values with a given value
+    void AddTm(const uint64& TmMSecs);
+
+    /// Find position of the segment with a given record, -1 when not found
+    static int GetSegmentN(const TVec<TStoreSegment>& SegmentV, const uint64& RecId);
+};
+typedef TVec<TStoreSegment> TStoreSegmentV;
+
 ///////////////////////////////
 /// Join Description
 class TJoinDesc {
@@ -479,6 +522,127 @@ public:
 };
 typedef TVec<TFieldDesc> TFieldDescV;
 
+///////////////////////////////
+/// Field Column.
+/// Keeps values of one fixed-width field for consecutive record IDs in a contiguous
+/// vector of the field's native type, with a separate null bitmap. Used by stores
+/// with columnar storage location, so scans over a field do not need to deserialize
+/// whole records. Records can only be appended at the end and removed from the front.
+class TFieldColumn {
+private:
+    /// Field ID
+    TInt FieldId;
+    /// Field type
+    TFieldType FieldType;
+    /// Record ID of the first element in the value vector
+    TUInt64 FirstRecId;
+    /// Number of deleted elements at the front of the value vector
+    TInt64 FirstValN;
+    /// Number of elements in the value vector (including deleted ones)
+    TInt64 Vals;
+    /// Default value used when record is added without the field (can be NULL)
+    PJsonVal DefaultVal;
+
+    /// Values for byte and bool fields
+    TVec<TUCh, int64> ByteV;
+    /// Values for integer fields
+    TVec<TInt, int64> IntV;
+    /// Values for 64bit integer fields
+    TVec<TInt64, int64> Int64V;
+    /// Values for unsigned 64bit integer and datetime (milliseconds) fields
+    TVec<TUInt64, int64> UInt64V;
+    /// Values for float fields
+    TVec<TFlt, int64> FltV;
+    /// Values for small float fields
+    TVec<TSFlt, int64> SFltV;
+    /// Null flags, one bit per element
+    TVec<TUInt64, int64> NullV;
+
+    /// Position of the given record in the value vector, fails for records not in the column
+    int64 GetValN(const uint64& RecId) const {
+        QmAssertR(IsRecId(RecId), "TFieldColumn: record ID " + TUInt64::GetStr(RecId) + " out of range");
+        return (int64)(RecId - FirstRecId.Val); }
+    /// Remove deleted elements from the front when they take too much space
+    void Compact();
+
+public:
+    TFieldColumn(): FieldId(-1), FieldType(oftUndef) { }
+    /// Create empty column for the given field
+    TFieldColumn(const TFieldDesc& FieldDesc, const PJsonVal& _DefaultVal = NULL);
+
+    TFieldColumn(TSIn& SIn);
+    void Save(TSOut& SOut) const;
+
+    /// Can fields of the given type be stored in a column
+    static bool IsFieldType(const TFieldType& FieldType);
+
+    /// True when column is initialized for a field
+    bool IsDef() const { return FieldType != oftUndef; }
+    /// Field ID
+    int GetFieldId() const { return FieldId; }
+    /// Field type
+    TFieldType GetFieldType() const { return FieldType; }
+    /// Default value for records added without the field (NULL when none)
+    const PJsonVal& GetDefaultVal() const { return DefaultVal; }
+    /// Number of records in the column
+    uint64 GetRecs() const { return (uint64)(Vals - FirstValN); }
+    /// Check if record is stored in the column
+    bool IsRecId(const uint64& RecId) const {
+        return (FirstRecId + (uint64)FirstValN <= RecId) && (RecId < FirstRecId + (uint64)Vals); }
+
+    /// Append a record with null value. Record IDs must be consecutive.
+    void AddRec(const uint64& RecId);
+    /// Remove given number of records from the front
+    void DelRecs(const uint64& Recs);
+    /// Remove all records
+    void Clr();
+
+    /// Check if the value of the record is null
+    bool IsNull(const uint64& RecId) const { const int64 ValN = GetValN(RecId);
+        return ((NullV[ValN >> 6].Val >> (ValN & 63)) & 1) != 0; }
+    /// Set record value to null
+    void SetNull(const uint64& RecId);
+
+    uchar GetByte(const uint64& RecId) const { return ByteV[GetValN(RecId)]; }
+    bool GetBool(const uint64& RecId) const { return ByteV[GetValN(RecId)] != 0; }
+    int GetInt(const uint64& RecId) const { return IntV[GetValN(RecId)]; }
+    int64 GetInt64(const uint64& RecId) const { return Int64V[GetValN(RecId)]; }
+    uint64 GetUInt64(const uint64& RecId) const { return UInt64V[GetValN(RecId)]; }
+    double GetFlt(const uint64& RecId) const { return FltV[GetValN(RecId)]; }
+    float GetSFlt(const uint64& RecId) const { return SFltV[GetValN(RecId)]; }
+    uint64 GetTmMSecs(const uint64& RecId) const { return UInt64V[GetValN(RecId)]; }
+    /// Get value of any numeric field as double (null values are returned as 0)
+    double GetNum(const uint64& RecId) const;
+
+    void SetByte(const uint64& RecId, const uchar& Byte);
+    void SetBool(const uint64& RecId, const bool& Bool);
+    void SetInt(const uint64& RecId, const int& Int);
+    void SetInt64(const uint64& RecId, const int64& Int64);
+    void SetUInt64(const uint64& RecId, const uint64& UInt64);
+    void SetFlt(const uint64& RecId, const double& Flt);
+    void SetSFlt(const uint64& RecId, const float& SFlt);
+    void SetTmMSecs(const uint64& RecId, const uint64& TmMSecs);
+    /// Parse value from JSon and set it to the record (null JSon sets null value)
+    void SetJsonVal(const uint64& RecId, const TStr& FieldNm, const PJsonVal& JsonVal);
+
+    /// Keep only records with byte value within given range. Records with null value are removed.
+    void FilterByte(TUInt64IntKdV& RecIdFqV, const uchar& MinVal, const uchar& MaxVal) const;
+    /// Keep only records with integer value within given range. Records with null value are removed.
+    void FilterInt(TUInt64IntKdV& RecIdFqV, const int& MinVal, const int& MaxVal) const;
+    /// Keep only records with 64bit integer value within given range. Records with null value are removed.
+    void FilterInt64(TUInt64IntKdV& RecIdFqV, const int64& MinVal, const int64& MaxVal) const;
+    /// Keep only records with unsigned 64bit integer or datetime value within given range.
+    /// Records with null value are removed.
+    void FilterUInt64(TUInt64IntKdV& RecIdFqV, const uint64& MinVal, const uint64& MaxVal) const;
+    /// Keep only records with float value within given range. Records with null value are removed.
+    void FilterFlt(TUInt64IntKdV& RecIdFqV, const double& MinVal, const double& MaxVal) const;
+    /// Keep only records with small float value within given range. Records with null value are removed.
+    void FilterSFlt(TUInt64IntKdV& RecIdFqV, const float& MinVal, const float& MaxVal) const;
+    /// Gather values of given records as doubles (null values are returned as 0)
+    void GetNumV(const TUInt64IntKdV& RecIdFqV, TFltV& NumV) const;
+};
+typedef TVec<TFieldColumn> TFieldColumnV;
+
 ///////////////////////////////
 /// Store iterator
 class TStoreIter {
@@ -631,6 +795,8 @@ private:
     TStrH FieldNmToIdH;
     /// List of active triggers
     TStoreTriggerV TriggerV;
+    /// Counter of changes to the store, used to invalidate cached query results
+    TUInt64 Version;
 
     /// Load store from stream (to be called only by base class!)
     void LoadStore(TSIn& SIn);
@@ -679,6 +845,12 @@ public:
     /// Should be called before record Rec deleted; executes OnDelete event in all registered triggers
     void OnDelete(const TRec& Rec);
 
+    /// Mark the store as changed. Called from OnAdd, OnUpdate and OnDelete, and
+    /// by implementations when records or indexes change without triggers.
+    void IncVersion() { Version++; }
+    /// Number of changes to the store since it was opened
+    uint64 GetVersion() const { return Version; }
+
 protected:
     /// Helper function for handling string and vector pools
     void StrVToIntV(const TStrV& StrV, TStrHash<TInt, TBigStrPool>& WordH, TIntV& IntV);
@@ -754,6 +926,9 @@ public:
 
     /// True when records have names (default is false)
     virtual bool HasRecNm() const { return false; }
+    /// True when records can be read from several threads at once, as long as
+    /// nobody is writing to the store (default is false)
+    virtual bool IsConcurrentRead() const { return false; }
     /// Check if record with given ID exists
     virtual bool IsRecId(const uint64& RecId) const = 0;
     /// check if record with given name exists
@@ -800,8 +975,17 @@ public:
 
     /// Add new record provided as JSon
     virtual uint64 AddRec(const PJsonVal& RecVal, const bool& TriggerEvents = true) = 0;
+    /// Add new records provided as JSon array, record ids are returned in RecIdV.
+    /// Default implementation adds records one by one.
+    virtual void AddRecs(const TVec<PJsonVal>& RecValV, TUInt64V& RecIdV, const bool& TriggerEvents = true);
     /// Update existing record with updates in provided JSon
     virtual void UpdateRec(const uint64& RecId, const PJsonVal& RecVal) = 0;
+    /// Defer indexing of new records. When indexing is resumed, all records added in the
+    /// meantime are indexed at once, which is much faster for large imports. Records are
+    /// not returned by index queries until then. Default implementation throws exception.
+    virtual void SetIndexingDeferred(const bool& DeferredP) { throw TQmExcept::New("Not implemented"); }
+    /// Is indexing of new records deferred
+    virtual bool IsIndexingDeferred() const { return false; }
 
     /// Add join
     void AddJoin(const int& JoinId, const uint64& RecId, const uint64 JoinRecId, const int& JoinFq = 1);
@@ -818,6 +1002,9 @@ public:
 
     /// Signal to purge any old stuff, e.g. records that fall out of time window when store has one
     virtual void GarbageCollect(const int& MxTimeMSecs = -1) { }
+    /// Get time segments of records, ordered by record ids. Returns false when
+    /// the store is not partitioned into segments over the given time field.
+    virtual bool GetSegmentV(const int& TmFieldId, TStoreSegmentV& SegmentV) const { return false; }
     /// Deletes all records
     virtual void DeleteAllRecs() = 0;
     /// Delete the first DelRecs records (the records that were inserted first)
@@ -1056,12 +1243,92 @@ public:
     virtual int PartialFlush(int WndInMsec = 500) { throw TQmExcept::New("Not implemented"); }
     /// Retrieve performance statistics for this store
     virtual PJsonVal GetStats() { return TJsonVal::NewObj(); }
+    /// Get column with field values when store keeps field in columnar layout,
+    /// otherwise returns NULL (default implementation)
+    virtual const TFieldColumn* GetFieldColumn(const int& FieldId) const { return NULL; }
     /// Run verification for whole store
     virtual void RunVerification() { };
     /// Run verification for single record
     virtual void RunVerificationForRecord(const uint64& RecId) { };
 };
 
+///////////////////////////////
+/// Store loader.
+/// Bulk loads records from CSV or line-delimited JSon files. Lines are read
+/// in batches, parsed in parallel and pushed to the store with TStore::AddRecs.
+/// Reading and adding are separate steps, so that records can be parsed on
+/// a worker thread and added to the store from the thread owning the base.
+class TStoreLoader {
+public:
+    /// Supported file formats
+    typedef enum {
+        slfJson, ///< One JSon object per line
+        slfCsv   ///< Comma separated values, first line is header
+    } TFormat;
+
+private:
+    /// Store into which we load the records
+    TWPt<TStore> Store;
+    /// Input file
+    PSIn SIn;
+    /// Format of the input file
+    TFormat Format;
+    /// Cell delimiter for CSV
+    char Delimiter;
+    /// Quote character for CSV
+    char Quote;
+    /// Field ID for each CSV column, -1 for columns that are not loaded
+    TIntV ColFieldIdV;
+    /// Maximal number of records to load
+    uint64 Limit;
+    /// Number of lines parsed and added in one batch
+    int BatchSize;
+    /// Trigger store events when adding records
+    bool TriggerEvents;
+    /// Number of lines read so far
+    uint64 Lines;
+    /// Number of bytes read so far
+    uint64 Bytes;
+    /// Number of records added so far
+    uint64 Recs;
+    /// Lines of the current batch
+    TChAV LnChAV;
+    /// Line numbers of the current batch
+    TUInt64V LnNV;
+
+    /// Split CSV line into cells
+    void SplitCsvLn(const TChA& LnChA, TStrV& CellV) const;
+    /// Parse CSV cell into JSon value of the field type
+    PJsonVal ParseCsvCell(const int& FieldId, const TStr& CellStr) const;
+    /// Parse one line into record JSon
+    PJsonVal ParseLn(const TChA& LnChA) const;
+
+public:
+    /// Open file for loading. Parameters:
+    ///  - format: "json" (default) or "csv"
+    ///  - limit: maximal number of records to load
+    ///  - batchSize: number of lines parsed and added at once (default 10000)
+    ///  - triggerEvents: trigger store events for new records (default true)
+    ///  - delimiter, quote: CSV delimiter (default ',') and quote (default '"')
+    ///  - columns: CSV field names for columns, null to skip a column; when
+    ///    not given, header line provides the names and unknown columns are skipped
+    TStoreLoader(const TWPt<TStore>& _Store, const TStr& FNm, const PJsonVal& ParamVal);
+
+    /// Read and parse next batch of records, returns false when done
+    bool ReadBatch(TVec<PJsonVal>& RecValV);
+    /// Add parsed batch of records to the store
+    void AddBatch(const TVec<PJsonVal>& RecValV);
+    /// Load all remaining records, returns number of records added
+    uint64 Load();
+
+    /// Number of lines read so far
+    uint64 GetLines() const { return Lines; }
+    /// Number of bytes read so far
+    uint64 GetBytes() const { return Bytes; }
+    /// Number of records added so far
+    uint64 GetRecs() const { return Recs; }
+};
+
 ///////////////////////////////
 /// Record.
 /// Holds record by reference (store ID and record ID) or by value (store ID and all field values).
@@ -1996,6 +2263,97 @@ public:
     static TStrV GetDateRange();
 };
 
+///////////////////////////////
+/// Record Id Bitmap.
+/// Compressed set of record ids used by TBase when combining large unweighted
+/// results. Ids are split into blocks by their upper bits. Sparse blocks keep
+/// a sorted array of lower 16 bits, dense blocks keep a bitset of 2^16 bits.
+/// Set operations work block by block and never touch ids outside of the sets.
+class TRecIdBitmap {
+private:
+    /// Array blocks with more elements are converted to bitsets
+    static const int MxArrLen;
+    /// Number of 64-bit words in a bitset block
+    static const int BitsetWords;
+    /// Minimal number of records before bitmap pays off
+    static const int MnDenseRecs;
+
+    /// Block of record ids sharing the same upper bits
+    class TBlock {
+    public:
+        /// Sorted lower bits of ids, used when block is sparse
+        TVec<TUInt16> ArrV;
+        /// Bitset of lower bits of ids, used when block is dense (empty otherwise)
+        TUInt64V BitV;
+        /// Number of ids in the block
+        TInt Cnt;
+
+    public:
+        TBlock() { }
+
+        /// Is block stored as bitset
+        bool IsBitset() const { return !BitV.Empty(); }
+        /// Check if lower bits are in the block
+        bool IsIn(const uint16& Low) const;
+        /// Store block as bitset
+        void ToBitset();
+        /// Store block as array when it got sparse enough
+        void Optimize();
+
+        /// Intersect with given block
+        void And(const TBlock& Block);
+        /// Union with given block
+        void Or(const TBlock& Block);
+        /// Remove all ids from given block
+        void AndNot(const TBlock& Block);
+
+        /// Append ids from the block to the vector
+        void GetRecIdFqV(const uint64& High, TUInt64IntKdV& RecIdFqV) const;
+        /// Memory footprint
+        uint64 GetMemUsed() const;
+    };
+
+    /// Sorted upper bits of ids, one for each block
+    TUInt64V HighV;
+    /// Blocks, aligned with HighV
+    TVec<TBlock> BlockV;
+
+    /// Number of set bits in a 64-bit word
+    static int GetBits(const uint64& Word);
+    /// Remove empty blocks
+    void DelEmpty();
+
+public:
+    /// Empty set
+    TRecIdBitmap() { }
+    /// Set with ids from a sorted vector of record ids
+    TRecIdBitmap(const TUInt64IntKdV& RecIdFqV);
+
+    /// Is the vector of record ids large and dense enough to benefit from bitmap
+    static bool IsDense(const TUInt64IntKdV& RecIdFqV);
+
+    /// Number of ids in the set
+    uint64 GetRecs() const;
+    /// Is the set empty
+    bool Empty() const { return BlockV.Empty(); }
+    /// Check if record id is in the set
+    bool IsRecId(const uint64& RecId) const;
+
+    /// Keep only ids also in the given set
+    void And(const TRecIdBitmap& Bitmap);
+    /// Add all ids from the given set
+    void Or(const TRecIdBitmap& Bitmap);
+    /// Remove all ids from the given set
+    void AndNot(const TRecIdBitmap& Bitmap);
+    /// Exchange contents with given set
+    void Swap(TRecIdBitmap& Bitmap) { HighV.Swap(Bitmap.HighV); BlockV.Swap(Bitmap.BlockV); }
+
+    /// Sorted vector of record ids, all with weight 1
+    void GetRecIdFqV(TUInt64IntKdV& RecIdFqV) const;
+    /// Memory footprint
+    uint64 GetMemUsed() const;
+};
+
 ///////////////////////////////
 /// Record Set.
 /// Holds a collection of record IDs from one store.
@@ -2027,6 +2385,36 @@ private:
     /// Removes records from this result set that are not part of the provided
     void LimitToSampleRecIdV(const TUInt64IntKdV& SampleRecIdFqV);
 
+    /// Number of threads used to read field values of all records. Larger sets
+    /// from stores allowing concurrent reads are read using query threads of the base.
+    int GetReadThreads() const;
+    /// Positions of records ordered by their ids, empty when records are already in that order
+    void GetRecIdOrderV(TIntV& RecNV) const;
+    /// Read field values of all records into a dense vector aligned with the records.
+    /// Records are visited in order of positions in RecNV (when not empty), so store
+    /// is read sequentially. Null flags are read only when NullV is given.
+    template <class TVal, class TGetVal>
+    void GetFieldValV(const int& FieldId, const TIntV& RecNV, const TGetVal& GetVal,
+        TVec<TVal>& ValV, TBoolV* NullV) const;
+    /// Keep only records with non-null field value within given range. Values are read
+    /// once for all records and checked in one pass.
+    template <class TVal, class TGetVal>
+    void FilterByFieldVal(const int& FieldId, const TGetVal& GetVal, const TVal& MinVal, const TVal& MaxVal);
+    /// Keep only records with non-null time field value within given range, using time
+    /// segments of the store to skip reading values of records in segments, which are
+    /// entirely within or entirely out of the range.
+    void FilterByFieldTmSegmentV(const int& FieldId, const TStoreSegmentV& SegmentV,
+        const uint64& MinVal, const uint64& MaxVal);
+    /// Order records by sort keys (aligned with records), RecNV gives positions of records
+    /// ordered by their ids. Records with equal keys are ordered by record id in the same direction.
+    void SortBySortKeyV(const TIntV& RecNV, const TUInt64V& SortKeyV, const bool& Asc);
+    /// Stable radix sort of pairs (sort key, position) by sort key
+    static void RadixSort(TUInt64IntKdV& SortKeyPosV);
+    /// Order preserving mapping of signed integers to sort keys
+    static uint64 GetIntSortKey(const int64& Val) { return (uint64)Val ^ ((uint64)1 << 63); }
+    /// Order preserving mapping of floating point numbers to sort keys
+    static uint64 GetFltSortKey(const double& Val);
+
     TRecSet() { }
     TRecSet(const TWPt<TStore>& Store, const uint64& RecId, const int& Fq);
     TRecSet(const TWPt<TStore>& Store, const TUInt64V& RecIdV);
@@ -2109,7 +2497,9 @@ public:
     /// Sort records by their weight
     /// @param Asc True for sorting in increasing order
     void SortByFq(const bool& Asc = true);
-    /// Sort records according to filed with id `SortFieldId'
+    /// Sort records according to filed with id `SortFieldId'. Field values are read
+    /// once for all records; numeric fields are sorted using radix sort. Records with
+    /// equal values are ordered by record id.
     /// @param Asc True for sorting in increasing order
     void SortByField(const bool& Asc, const int& SortFieldId);
     /// Sort records according to given comparator
@@ -2204,7 +2594,10 @@ public:
     /// Execute join with the given id
     /// @param SampleSize Sample size used to do the join. When set to -1, all the records are used.
     /// @param IgnoreFqP Ignores record frequency when available during sampling
-    PRecSet DoJoin(const TWPt<TBase>& Base, const int& JoinId, const int& SampleSize = -1, const bool& IgnoreFqP = false) const;
+    /// @param Threads Number of threads used to expand the records. Field joins are
+    ///   only expanded in parallel when the store supports concurrent reads.
+    PRecSet DoJoin(const TWPt<TBase>& Base, const int& JoinId, const int& SampleSize = -1,
+        const bool& IgnoreFqP = false, const int& Threads = 1) const;
     /// Execute join with the given name
     /// @param SampleSize Sample size used to do the join. When set to -1, all the records are used.
     /// @param IgnoreFqP Ignores record frequency when available during sampling
@@ -2317,6 +2710,10 @@ public:
     bool IsGixSmall() const { return GixType == oikgtSmall; }
     /// Get flag that instructs index to use tiny gix
     bool IsGixTiny() const { return GixType == oikgtTiny; }
+    /// Get flag that instructs index to use packed gix
+    bool IsGixPacked() const { return GixType == oikgtPacked; }
+    /// Get flag that instructs index to keep b-tree of linear key on disk
+    bool IsPaged() const { return GixType == oikgtPaged; }
 
     /// Get key sort type
     TIndexKeySortType GetSortType() const { return SortType; }
@@ -2390,8 +2787,32 @@ private:
     /// Hash table with all the words
     TStrHash<TInt> WordH;
 
+    /// Maximal number of new words scanned linearly before they are merged into sorted vectors
+    static const int MxSortTailLen;
+    /// Word IDs sorted by string value, built on first range or wildcard query
+    TIntV StrSortWordIdV;
+    /// Number of words (IDs from 0 on) included in StrSortWordIdV
+    TInt StrSortWords;
+    /// Numeric value and word ID pairs sorted by value, built on first numeric range query
+    TFltIntPrV FltSortWordIdV;
+    /// Number of words (IDs from 0 on) included in FltSortWordIdV
+    TInt FltSortWords;
+    /// Guards lazy updates of sorted vectors from concurrent queries
+    TCriticalSection SortSection;
+
     TIndexWordVoc() { }
     TIndexWordVoc(TSIn& SIn): WordVocNm(SIn), WordH(SIn) { }
+
+    /// Merge new words into StrSortWordIdV when there are too many to scan
+    void UpdateStrSortV();
+    /// Merge new words into FltSortWordIdV when there are too many to scan
+    void UpdateFltSortV();
+    /// Position of the first word in StrSortWordIdV not smaller (or greater when
+    /// UpperP is set) than the given string
+    int GetStrSortN(const char* CStr, const bool& UpperP) const;
+    /// Position of the first word in FltSortWordIdV not smaller (or greater when
+    /// UpperP is set) than the given value
+    int GetFltSortN(const double& Flt, const bool& UpperP) const;
 public:
     /// Create new empty vocabulary
     static TPt<TIndexWordVoc> New() { return new TIndexWordVoc; }
@@ -2583,6 +3004,8 @@ private:
     TFlt LocRadius;
     /// Number of nearest neighbors of search space (for location query)
     TInt LocLimit;
+    /// Polygon, or box given by two corners, of search space (for location area query)
+    TFltPrV LocAreaV;
 
     /// Edge parameters for range integer query
     TIntPr RangeIntMnMx;
@@ -2622,6 +3045,8 @@ private:
 
     /// Parse Value for leaf nodes (result stored in WordIdV)
     void ParseWordStr(const TStr& WordStr, const TWPt<TIndexVoc>& IndexVoc);
+    /// Parse [lat, lon] coordinates given to location query operator OpNm
+    static TFltPr ParseLoc(const PJsonVal& LocVal, const TStr& OpNm);
 
     /// Parse join query from json (can be one or an array of joins)
     TWPt<TStore> ParseJoins(const TWPt<TBase>& Base, const PJsonVal& JsonVal);
@@ -2754,6 +3179,17 @@ public:
     bool Empty() const { return !IsItems() && !IsWordIds(); }
     /// Check if result is weighted (only or-items)
     bool IsFq() const;
+    /// Check if result can be cached (no records or record sets given by value,
+    /// no sampled joins)
+    bool IsCacheable() const;
+    /// Name of the item type, as used in query plans
+    TStr GetTypeStr() const;
+    /// Check if subordinate items can be evaluated from several threads at once
+    /// (all stores read during evaluation support concurrent reads)
+    bool IsConcurrent(const TWPt<TBase>& Base) const;
+    /// Normalized key identifying the result of the query item. Adds ids of all
+    /// stores which can influence the result to StoreIdSet.
+    TStr GetCacheKey(const TWPt<TBase>& Base, TUIntSet& StoreIdSet) const;
 
     /// Get Index key
     int GetKeyId() const { return KeyId; }
@@ -2789,6 +3225,10 @@ public:
     double GetLocRadius() const { return LocRadius; }
     /// Get location query maximal number of neighbors (for location queries)
     int GetLocLimit() const { return LocLimit; }
+    /// Check if location query searches inside an area (for location queries)
+    bool IsLocArea() const { return !LocAreaV.Empty(); }
+    /// Get polygon, or box given by south-west and north-east corner (for location area queries)
+    const TFltPrV& GetLocAreaV() const { return LocAreaV; }
 
     /// Get integer range
     TIntPr GetRangeIntMinMax() const { return RangeIntMnMx; }
@@ -2883,10 +3323,14 @@ private:
     TInt SortFieldId;
     /// In which order to sort (true for ascending)
     TBool SortAscP;
+    /// Sort by relevance (record weight) instead of field
+    TBool SortRelevanceP;
     /// Limit number of records to return in the query
     TInt Limit;
     /// Return only records after (and including the) Offset-th record
     TInt Offset;
+    /// Number of threads used to evaluate the query (-1 for base default)
+    TInt Threads;
 
     /// Internal method that traverses through the query tree and removes unneeded nodes
     void Optimize();
@@ -2912,13 +3356,27 @@ public:
     /// Get the result store
     TWPt<TStore> GetStore(const TWPt<TBase>& Base);
     /// Is there any sorting specified
-    bool IsSort() const { return SortFieldId != -1; }
+    bool IsSort() const { return (SortFieldId != -1) || SortRelevanceP; }
+    /// Are results sorted by relevance
+    bool IsSortRelevance() const { return SortRelevanceP; }
+    /// Are results sorted by relevance and limited, so we only need top records
+    bool IsTopK() const { return SortRelevanceP && (Limit != -1) && QueryAggrV.Empty(); }
+    /// Number of top records needed to satisfy limit and offset
+    int GetTopK() const { return Limit + Offset; }
+    /// Are results only trimmed to the first records, so we need only GetTopK() of them
+    bool IsPrefix() const { return (Limit != -1) && !IsSort() && QueryAggrV.Empty(); }
     /// Do the sort
     void Sort(const TWPt<TBase>& Base, const PRecSet& RecSet);
     /// Is there any limit restriction
     bool IsLimit() const { return (Limit != -1) || (Offset != 0); }
     /// Do the range limit, when specified
     PRecSet GetLimit(const PRecSet& RecSet);
+    /// Is number of threads specified for the query
+    bool IsThreads() const { return Threads != -1; }
+    /// Number of threads used to evaluate independent parts of the query
+    int GetThreads() const { return Threads; }
+    /// Set number of threads used to evaluate independent parts of the query
+    void SetThreads(const int& _Threads) { QmAssert(_Threads > 0); Threads = _Threads; }
 
     /// Check if query is valid
     bool IsOk(const TWPt<TBase>& Base, TStr& MsgStr) const;
@@ -2930,6 +3388,68 @@ public:
 };
 typedef TPt<TQuery> PQuery;
 
+///////////////////////////////
+/// Query Cache.
+/// LRU cache of query item results, bounded by memory. Each result remembers
+/// the versions of the stores it depends on and is dropped when any of them changes.
+class TQueryCache {
+private:
+    // smart-pointer
+    TCRef CRef;
+    friend class TPt<TQueryCache>;
+
+    /// Cached result of one query item
+    class TItem {
+    private:
+        // smart-pointer
+        TCRef CRef;
+        friend class TPt<TItem>;
+    public:
+        /// True when result should be negated
+        TBool NotP;
+        /// Result
+        PRecSet RecSet;
+        /// Versions of stores at the time result was computed
+        TVec<TUIntUInt64Pr> StoreVerV;
+
+        TItem(const bool& _NotP, const PRecSet& _RecSet): NotP(_NotP), RecSet(_RecSet) { }
+
+        /// Memory footprint used for bounding the cache
+        uint64 GetMemUsed() const;
+        /// Called by the cache when the item is evicted
+        void OnDelFromCache(const TStr& Key, void* QueryCache);
+    };
+    typedef TPt<TItem> PItem;
+
+    /// Items indexed by query item key
+    TCache<TStr, PItem> Cache;
+    /// Memory used by cached items
+    TUInt64 MemUsed;
+    /// Number of lookups answered from the cache
+    TUInt64 Hits;
+    /// Number of lookups not answered from the cache
+    TUInt64 Misses;
+    /// Serializes access from concurrent searches. Record sets never leave the
+    /// cache shared, since their reference counting is not thread safe.
+    mutable TCriticalSection CacheSection;
+
+    TQueryCache(const int64& MxMemUsed);
+public:
+    /// Create new cache using at most MxMemUsed bytes
+    static TPt<TQueryCache> New(const int64& MxMemUsed) { return new TQueryCache(MxMemUsed); }
+
+    /// Get copy of the result for the key, if it is cached and all stores it depends on are unchanged
+    bool Get(const TWPt<TBase>& Base, const TStr& Key, TPair<TBool, PRecSet>& NotRecSet);
+    /// Remember copy of the result for the key, which depends on stores from StoreIdSet
+    void Put(const TWPt<TBase>& Base, const TStr& Key, const TUIntSet& StoreIdSet,
+        const TPair<TBool, PRecSet>& NotRecSet);
+    /// Remove all items
+    void Clr();
+    /// Statistics about cache usage (hits, misses, items, memory)
+    PJsonVal GetStats() const;
+};
+typedef TPt<TQueryCache> PQueryCache;
+
 ///////////////////////////////
 // GeoIndex
 class TGeoIndex; typedef TPt<TGeoIndex> PGeoIndex;
@@ -2974,9 +3494,21 @@ public:
         const int& Limit, TUInt64V& RecIdV) const;
     /// Nearest neighbour query
     void SearchNn(const TFltPr& Loc, const int& Limit, TUInt64V& RecIdV) const;
+    /// Area query, returns at most Limit records inside polygon AreaV which are nearest to Loc
+    void SearchArea(const TFltPrV& AreaV, const TFltPr& Loc, const int& Limit, TUInt64V& RecIdV) const;
 
     /// Tells if two locations identical based on Precision
     bool LocEquals(const TFltPr& Loc1, const TFltPr& Loc2) const;
+
+    /// Distance between locations in meters
+    static double GetDist(const TFltPr& Loc1, const TFltPr& Loc2);
+    /// Bounding box (south-west and north-east corner) of polygon
+    static void GetAreaBox(const TFltPrV& AreaV, TFltPr& MinLoc, TFltPr& MaxLoc);
+    /// Check if location is inside polygon. Edges are straight lines in (lat, lon) plane.
+    static bool IsInArea(const TFltPrV& AreaV, const TFltPr& Loc);
+    /// Sorted records of at most Limit (location, record id) pairs nearest to Loc
+    static void GetNearestRecIdV(const TFltPr& Loc, const TVec<TPair<TFltPr, TUInt64> >& LocRecIdV,
+        const int& Limit, TUInt64V& RecIdV);
 };
 
 ///////////////////////////////
@@ -2988,9 +3520,72 @@ private:
     TCRef CRef;
     friend class TPt<TBTreeIndex>;
 
+protected:
     /// We store values as (val, rec) pairs, which are sorted lexigraphically.
     /// That ensures that values are sorted primarly by value, and for same value by record id
     typedef TPair<TVal, TUInt64> TTreeVal;
+    /// Tree entry, leaves carry no data besides the value
+    typedef TKeyDat<TTreeVal, TVoid> TTreeKd;
+
+    /// Values collected during bulk load and not yet added to the tree
+    TVec<TTreeKd> BulkKdV;
+    /// Are added values collected for bulk load
+    TBool BulkP;
+
+    /// Parse out record ids from range query result
+    static void GetRecIdV(const TVec<TTreeVal>& ValRecIdV, TUInt64V& RecIdV);
+    /// Add sorted entries to the tree. Empty tree is built from them bottom-up.
+    virtual void AddKdV(const TVec<TTreeKd>& KdV) = 0;
+    /// Sort values collected so far during bulk load and add them to the tree
+    void FlushBulk();
+
+public:
+    virtual ~TBTreeIndex() { }
+
+    /// Create new empty index with nodes kept in memory
+    static TPt<TBTreeIndex> New();
+    /// Create new empty index with nodes kept in paged blob files
+    /// named `FNm' inside directory `FPath'
+    static TPt<TBTreeIndex> New(const TStr& FPath, const TStr& FNm);
+    /// Load existing index from stream. Paged index must be opened before use.
+    static TPt<TBTreeIndex> Load(TSIn& SIn);
+    /// Save index to stream
+    virtual void Save(TSOut& SOut) = 0;
+
+    /// True when index nodes are kept in paged blob files
+    virtual bool IsPaged() const { return false; }
+    /// Set directory and access mode of paged blob files after load
+    virtual void Open(const TStr& FPath, const TFAccess& Access) { }
+    /// Write modified nodes to disk within given time window, returns number of written nodes
+    virtual int PartialFlush(const int& WndInMsec) { return 0; }
+
+    /// Add new record
+    virtual void AddKey(const TVal& Val, const uint64& RecId) = 0;
+    /// Delete record
+    virtual void DelKey(const TVal& Val, const uint64& RecId) = 0;
+    /// Range query
+    virtual void SearchRange(const TPair<TVal, TVal>& RangeMinMax, TUInt64V& RecIdV) const = 0;
+    /// Range query, appends (value, record id) pairs sorted by value
+    virtual void SearchRange(const TPair<TVal, TVal>& RangeMinMax, TVec<TPair<TVal, TUInt64> >& ValRecIdV) const = 0;
+    /// Number of records in the range, counting stops at MxRecs
+    virtual int CountRange(const TPair<TVal, TVal>& RangeMinMax, const int& MxRecs) const = 0;
+
+    /// Start bulk load. Added values are only collected until the bulk load
+    /// ends and are not returned by range queries in the meantime.
+    void StartBulk() { BulkP = true; }
+    /// End bulk load and add collected values to the tree at once
+    void EndBulk() { FlushBulk(); BulkP = false; }
+    /// Are we in the middle of bulk load
+    bool IsBulk() const { return BulkP; }
+};
+
+///////////////////////////////
+// B-Tree Index with nodes in memory
+template <class TVal>
+class TBTreeMemIndex: public TBTreeIndex<TVal> {
+private:
+    typedef typename TBTreeIndex<TVal>::TTreeVal TTreeVal;
+    typedef typename TBTreeIndex<TVal>::TTreeKd TTreeKd;
     /// Define store for internal nodes
     typedef TBtree::TBtreeNodeMemStore<TTreeVal, TInt, TInt> TInternalStore;
     /// Define store for external nodes
@@ -3005,18 +3600,17 @@ private:
     /// BTree instance
     TBtreeOps BTree;
 
+    void AddKdV(const TVec<TTreeKd>& KdV);
+
 public:
     /// Create new empty index
-    TBTreeIndex(): InternalStore(new TInternalStore), LeafStore(new TLeafStore),
+    TBTreeMemIndex(): InternalStore(new TInternalStore), LeafStore(new TLeafStore),
         BTree(InternalStore, LeafStore, 8, 64, false, false) { }
-    /// Create new empty index
-    static TPt<TBTreeIndex> New() { return new TBTreeIndex; }
-    /// Load existing index from stream
-    TBTreeIndex(TSIn& SIn): InternalStore(SIn), LeafStore(SIn), BTree(SIn, InternalStore, LeafStore) {  }
-    /// Load existing index from stream
-    static TPt<TBTreeIndex> Load(TSIn& SIn) { return new TBTreeIndex(SIn); }
+    /// Load existing index from stream, which is positioned after the internal store null flag
+    TBTreeMemIndex(TSIn& SIn): InternalStore(TInternalStore::Load(SIn)), LeafStore(SIn),
+        BTree(SIn, InternalStore, LeafStore) { }
     /// Save index to stream
-    void Save(TSOut& SOut) { InternalStore.Save(SOut); LeafStore.Save(SOut); BTree.Save(SOut); }
+    void Save(TSOut& SOut);
 
     /// Add new record
     void AddKey(const TVal& Val, const uint64& RecId);
@@ -3024,6 +3618,146 @@ public:
     void DelKey(const TVal& Val, const uint64& RecId);
     /// Range query
     void SearchRange(const TPair<TVal, TVal>& RangeMinMax, TUInt64V& RecIdV) const;
+    /// Range query, appends (value, record id) pairs sorted by value
+    void SearchRange(const TPair<TVal, TVal>& RangeMinMax, TVec<TTreeVal>& ValRecIdV) const;
+    /// Number of records in the range, counting stops at MxRecs
+    int CountRange(const TPair<TVal, TVal>& RangeMinMax, const int& MxRecs) const;
+};
+
+///////////////////////////////
+// B-Tree Index with nodes in paged blob files. Only recently used nodes are
+// kept in memory, so index can be larger than available memory.
+template <class TVal>
+class TBTreePgIndex: public TBTreeIndex<TVal> {
+private:
+    typedef typename TBTreeIndex<TVal>::TTreeVal TTreeVal;
+    typedef typename TBTreeIndex<TVal>::TTreeKd TTreeKd;
+    /// Define store for internal nodes
+    typedef TBtree::TBtreeNodePgStore<TTreeVal, TInt, TInt> TInternalStore;
+    /// Define store for external nodes
+    typedef TBtree::TBtreeNodePgStore<TTreeVal, TVoid, TInt> TLeafStore;
+    /// Define btree with given stores and value type
+    typedef TBtree::TBtreeOps<TTreeVal, TVoid, TCmp<TTreeVal>, TInt, TInternalStore, TLeafStore> TBtreeOps;
+
+    /// Name of paged blob files, relative to index directory
+    TStr FNm;
+    /// Internal store instance
+    TPt<TInternalStore> InternalStore;
+    /// Leaf store instance
+    TPt<TLeafStore> LeafStore;
+    /// BTree instance, with larger nodes than in-memory one to make better use of pages
+    TBtreeOps BTree;
+    /// Node stores update their cache also when reading, so access is serialized
+    mutable TCriticalSection NodeSection;
+
+    void AddKdV(const TVec<TTreeKd>& KdV);
+
+public:
+    /// Create new empty index
+    TBTreePgIndex(const TStr& FPath, const TStr& _FNm): FNm(_FNm), InternalStore(new TInternalStore),
+        LeafStore(new TLeafStore), BTree(InternalStore, LeafStore, 64, 128, false, false) {
+            Open(FPath, faCreate); }
+    /// Load existing index from stream, which is positioned after the paged flag
+    TBTreePgIndex(TSIn& SIn): FNm(SIn), InternalStore(SIn), LeafStore(SIn),
+        BTree(SIn, InternalStore, LeafStore) { }
+    /// Save index to stream. Paged index is marked with a leading true flag,
+    /// which comes in place of the never-null internal store in memory index.
+    void Save(TSOut& SOut);
+
+    bool IsPaged() const { return true; }
+    void Open(const TStr& FPath, const TFAccess& Access);
+    int PartialFlush(const int& WndInMsec);
+
+    /// Add new record
+    void AddKey(const TVal& Val, const uint64& RecId);
+    /// Delete record
+    void DelKey(const TVal& Val, const uint64& RecId);
+    /// Range query
+    void SearchRange(const TPair<TVal, TVal>& RangeMinMax, TUInt64V& RecIdV) const;
+    /// Range query, appends (value, record id) pairs sorted by value
+    void SearchRange(const TPair<TVal, TVal>& RangeMinMax, TVec<TTreeVal>& ValRecIdV) const;
+    /// Number of records in the range, counting stops at MxRecs
+    int CountRange(const TPair<TVal, TVal>& RangeMinMax, const int& MxRecs) const;
+};
+
+///////////////////////////////
+/// Geo index on hierarchical cells. Surface is split into a quad-tree of
+/// latitude-longitude cells and each record is indexed under the id of the leaf
+/// cell holding its location. Ids are stored in a paged b-tree, so the index is
+/// not loaded into memory when opened. Ids of leaves below any cell form a
+/// continuous range, so queries scan the ranges of cells covering the query area
+/// and check exact condition on locations decoded from leaf ids.
+class TGeoCellIndex; typedef TPt<TGeoCellIndex> PGeoCellIndex;
+class TGeoCellIndex {
+private:
+    // smart-pointer
+    TCRef CRef;
+    friend class TPt<TGeoCellIndex>;
+
+    /// Location and record id of a candidate from the covering cells
+    typedef TPair<TFltPr, TUInt64> TLocRecId;
+    /// Box given by south-west and north-east corner
+    typedef TPair<TFltPr, TFltPr> TBox;
+
+    /// Depth of the quad-tree, leaf cells are around two centimeters high
+    static const int Levels;
+    /// Maximal number of cells along each axis used to cover the query box
+    static const int MxCoverCells;
+    /// Radius of the first nearest neighbour query, grows until enough records are found
+    static const double NnStartRadius;
+
+    /// Leaf cell ids of records
+    TPt<TBTreeIndex<TUInt64> > CellIndex;
+
+    /// Spread lower 32 bits of X to even bits of the result
+    static uint64 SpreadBits(uint64 X);
+    /// Inverse of SpreadBits
+    static uint64 CompactBits(uint64 X);
+    /// Leaf cell coordinate along one axis for coordinate Deg from [-MxDeg, MxDeg]
+    static uint64 GetCellCoord(const double& Deg, const double& MxDeg);
+    /// Leaf cell id, interleaved bits of latitude and longitude leaf cell coordinates
+    static uint64 GetCellId(const TFltPr& Loc);
+    /// Location of the leaf cell center
+    static TFltPr GetCellLoc(const uint64& CellId);
+    /// Ranges of leaf cell ids covering the box (south-west and north-east corner)
+    static void GetCoverRangeV(const TFltPr& MinLoc, const TFltPr& MaxLoc, TVec<TUInt64Pr>& CellIdRangeV);
+    /// Boxes covering circle around location, two when it crosses the antimeridian
+    static void GetCircleBoxV(const TFltPr& Loc, const double& Radius, TVec<TBox>& BoxV);
+
+    /// Append records with location inside the box
+    void SearchBox(const TFltPr& MinLoc, const TFltPr& MaxLoc, TVec<TLocRecId>& LocRecIdV) const;
+    /// Records with location within radius (in meters) around Loc
+    void SearchCircle(const TFltPr& Loc, const double& Radius, TVec<TLocRecId>& LocRecIdV) const;
+
+    TGeoCellIndex(const TStr& FPath, const TStr& FNm): CellIndex(TBTreeIndex<TUInt64>::New(FPath, FNm)) { }
+    TGeoCellIndex(TSIn& SIn): CellIndex(TBTreeIndex<TUInt64>::Load(SIn)) { }
+
+public:
+    /// Create new empty index with b-tree in paged blob files named `FNm' inside directory `FPath'
+    static PGeoCellIndex New(const TStr& FPath, const TStr& FNm) { return new TGeoCellIndex(FPath, FNm); }
+    /// Load existing index from stream, must be opened before use
+    static PGeoCellIndex Load(TSIn& SIn) { return new TGeoCellIndex(SIn); }
+    /// Save index to stream
+    void Save(TSOut& SOut) { CellIndex->Save(SOut); }
+
+    /// Set directory and access mode of paged blob files after load
+    void Open(const TStr& FPath, const TFAccess& Access) { CellIndex->Open(FPath, Access); }
+    /// Write modified nodes to disk within given time window, returns number of written nodes
+    int PartialFlush(const int& WndInMsec) { return CellIndex->PartialFlush(WndInMsec); }
+
+    /// Add new record
+    void AddKey(const TFltPr& Loc, const uint64& RecId) { CellIndex->AddKey(GetCellId(Loc), RecId); }
+    /// Delete record
+    void DelKey(const TFltPr& Loc, const uint64& RecId) { CellIndex->DelKey(GetCellId(Loc), RecId); }
+    /// Range query (in meters), returns at most Limit nearest records
+    void SearchRange(const TFltPr& Loc, const double& Radius, const int& Limit, TUInt64V& RecIdV) const;
+    /// Nearest neighbour query
+    void SearchNn(const TFltPr& Loc, const int& Limit, TUInt64V& RecIdV) const;
+    /// Area query, returns at most Limit records inside polygon AreaV which are nearest to Loc
+    void SearchArea(const TFltPrV& AreaV, const TFltPr& Loc, const int& Limit, TUInt64V& RecIdV) const;
+
+    /// Tells if two locations fall into the same leaf cell
+    bool LocEquals(const TFltPr& Loc1, const TFltPr& Loc2) const { return GetCellId(Loc1) == GetCellId(Loc2); }
 };
 
 ///////////////////////////////
@@ -3063,7 +3797,8 @@ private:
     public:
         /// Union sums up frequencies of overlapping items
         void Union(TVec<TQmGixResItem>& MainV, const TVec<TQmGixResItem>& JoinV) const;
-        /// Intersection sums up frequencies of overlapping items
+        /// Intersection sums up frequencies of overlapping items. When one of the vectors
+        /// is much shorter, the longer one is searched using galloping (exponential) search.
         void Intrs(TVec<TQmGixResItem>& MainV, const TVec<TQmGixResItem>& JoinV) const;
         /// Minus does not deal with frequencies
         void Minus(const TVec<TQmGixResItem>& MainV, const TVec<TQmGixResItem>& JoinV, TVec<TQmGixResItem>& ResV) const;
@@ -3075,6 +3810,10 @@ private:
     public:
         /// Move MainV to ResV since no changes needed
         void Def(const TQmGixKey& Key, TVec<TQmGixItem>& MainV, TVec<TQmGixItem>& ResV) const;
+        /// Items and results are of same type and ordered by record id
+        bool IsLtRes(const TQmGixItem& Item, const TQmGixItem& ResItem) const { return Item < ResItem; }
+        /// Items and results are of same type and ordered by record id
+        bool IsResLt(const TQmGixItem& ResItem, const TQmGixItem& Item) const { return ResItem < Item; }
 
         /// Memory footprint
         uint64 GetMemUsed() const { return sizeof(TQmGixSumWithFqMerger<TQmGixItem>); }
@@ -3086,6 +3825,10 @@ private:
     public:
         /// Copy MainV to ResV and init frequency to 1
         void Def(const TQmGixKey& Key, TVec<TQmGixItem>& MainV, TVec<TQmGixResItem>& ResV) const;
+        /// Compare record id of item with the one of result
+        bool IsLtRes(const TQmGixItem& Item, const TQmGixResItem& ResItem) const { return (uint64)Item.Val < (uint64)ResItem.Key; }
+        /// Compare record id of result with the one of item
+        bool IsResLt(const TQmGixResItem& ResItem, const TQmGixItem& Item) const { return (uint64)ResItem.Key < (uint64)Item.Val; }
 
         /// Memory footprint
         uint64 GetMemUsed() const { return sizeof(TQmGixSumWithoutFqMerger<TQmGixItem, TQmGixResItem>); }
@@ -3106,6 +3849,117 @@ private:
     /// Expression for executing gix queries for tiny records
     typedef TGixExpItem<TQmGixKey, TQmGixItemTiny, TQmGixItemFull> TQmGixExpItemTiny;
 
+    /// ItemHandler for packed version of inverted index. Items are the same as for the full
+    /// index, but child vectors are stored and cached packed: record ids as varint encoded
+    /// deltas, followed by varint encoded frequencies. Packed children are decoded directly
+    /// into the query result, so cache holds several times more keys for the same size.
+    class TQmGixPackedItemHandler : public TQmGixSumItemHandler<TQmGixItemFull> {
+    private:
+        /// Append zig-zag varint encoding of Val to BfV
+        static void PutVarInt(const int64& Val, TVec<uchar>& BfV);
+        /// Decode zig-zag varint from Bf and move Bf after it
+        static int64 GetVarInt(const uchar*& Bf);
+
+    public:
+        /// Child vectors are packed
+        bool IsPacked() const { return true; }
+        /// Encode child vector
+        void SaveItemV(const TVec<TQmGixItemFull>& ItemV, TSOut& SOut) const;
+        /// Decode child vector and append its items to ItemV
+        void LoadItemV(TSIn& SIn, TVec<TQmGixItemFull>& ItemV) const;
+        /// Items are weighted by frequency, so child vectors keep frequency upper bounds
+        bool IsWgt() const { return true; }
+        /// Weight of an item is its frequency
+        int GetItemWgt(const TQmGixItemFull& Item) const { return Item.Dat; }
+
+        /// Memory footprint
+        uint64 GetMemUsed() const { return sizeof(TQmGixPackedItemHandler); }
+    };
+
+    /// Record ID of full item
+    static uint64 GetItemRecId(const TQmGixItemFull& Item) { return Item.Key; }
+    /// Record ID of small item
+    static uint64 GetItemRecId(const TQmGixItemSmall& Item) { return (uint64)Item.Key; }
+    /// Record ID of tiny item
+    static uint64 GetItemRecId(const TQmGixItemTiny& Item) { return (uint64)Item.Val; }
+    /// Frequency of full item
+    static int GetItemFq(const TQmGixItemFull& Item) { return Item.Dat; }
+    /// Frequency of small item
+    static int GetItemFq(const TQmGixItemSmall& Item) { return (int)Item.Dat; }
+    /// Tiny items have implied frequency of 1
+    static int GetItemFq(const TQmGixItemTiny& Item) { return 1; }
+
+    /// BM25 saturation parameter used for scoring top-k queries
+    static const double TopKBm25K1;
+    /// BM25 score of a word with given inverse document frequency and frequency in
+    /// record. We do not keep record lengths, so there is no length normalization.
+    static double GetBm25(const double& Idf, const int& Fq) {
+        return (Fq > 0) ? Idf * Fq * (TopKBm25K1 + 1.0) / (Fq + TopKBm25K1) : 0.0; }
+
+    /// Scored record of top-k search (score, record ID, summed frequency)
+    typedef TTriple<TFlt, TUInt64, TInt> TQmGixTopKItem;
+    /// Ranks scored records: higher score first, equal scores by lower record ID.
+    /// Limited and unlimited relevance search both use it, so the top-k records
+    /// are always a prefix of the full ranking.
+    class TQmGixTopKCmp {
+    public:
+        bool operator()(const TQmGixTopKItem& Item1, const TQmGixTopKItem& Item2) const {
+            return (Item1.Val1 == Item2.Val1) ? (Item1.Val2 < Item2.Val2) : (Item1.Val1 > Item2.Val1); }
+    };
+
+    /// Forward-only cursor over records of one word, used by top-k search. Child vectors
+    /// are loaded only when cursor has to look inside them, all other decisions are
+    /// done using child vector summaries (largest record id, largest frequency).
+    template <class TQmGixItem>
+    class TQmGixTopKCursor {
+    private:
+        typedef TPt<TGixItemSet<TQmGixKey, TQmGixItem> > PQmGixItemSet;
+        /// Item set of the word
+        PQmGixItemSet ItemSet;
+        /// Inverse document frequency of the word
+        double Idf;
+        /// Current child vector, GetChildVecs() for working buffer, larger when done
+        int ChildN;
+        /// Items of the current child vector
+        TVec<TQmGixItem> ItemV;
+        /// Current position in ItemV
+        int ItemN;
+        /// Upper bound on score from working buffer
+        double WorkMxScore;
+        /// Upper bound on score over all records of the word
+        double MxScore;
+
+        /// Load child vector and move to its first item, skipping empty ones
+        void LoadChild(const int& _ChildN);
+
+    public:
+        TQmGixTopKCursor(): Idf(0.0), ChildN(0), ItemN(0), WorkMxScore(0.0), MxScore(0.0) { }
+        TQmGixTopKCursor(const PQmGixItemSet& _ItemSet, const double& _Idf);
+
+        /// Did we pass all the records
+        bool IsEnd() const { return ChildN > ItemSet->GetChildVecs(); }
+        /// Current record id
+        uint64 GetRecId() const { return GetItemRecId(ItemV[ItemN]); }
+        /// Frequency of the word in the current record
+        int GetFq() const { return GetItemFq(ItemV[ItemN]); }
+        /// Score of the current record
+        double GetScore() const { return GetBm25(Idf, GetFq()); }
+        /// Upper bound on score of any record
+        double GetMxScore() const { return MxScore; }
+
+        /// First child vector (from current on) that can contain RecId, without loading it
+        int FindChildN(const uint64& RecId) const;
+        /// Largest record id of a child vector
+        uint64 GetChildMxRecId(const int& _ChildN) const;
+        /// Upper bound on score of records in a child vector
+        double GetChildMxScore(const int& _ChildN) const;
+
+        /// Move to next record
+        void Next();
+        /// Move to first record with id greater or equal to RecId
+        void NextGEq(const uint64& RecId);
+    };
+
     /// Giving pretty names to GIX keys when printing debug statistics
     class TQmGixKeyStr : public TGixKeyStr<TQmGixKey> {
     private:
@@ -3232,12 +4086,29 @@ private:
     mutable TPt<TGix<TQmGixKey, TQmGixItemSmall> > GixSmall;
     /// Tiny inverted index (supports records with id < 2^32)
     mutable TPt<TGix<TQmGixKey, TQmGixItemTiny> > GixTiny;
+    /// Packed inverted index (same items as full index, packed child vectors).
+    /// Not set when a base from before packed index is opened read-only.
+    mutable TPt<TGix<TQmGixKey, TQmGixItemFull> > GixPacked;
 
     /// Position inverted index
     mutable TPt<TGix<TQmGixKey, TQmGixItemPos> > GixPos;
 
+    /// Guards full inverted index. Gix item-set cache is updated on every lookup,
+    /// so each gix has its own lock and queries over different gix types do not contend.
+    mutable TCriticalSection GixFullSection;
+    /// Guards small inverted index
+    mutable TCriticalSection GixSmallSection;
+    /// Guards tiny inverted index
+    mutable TCriticalSection GixTinySection;
+    /// Guards packed inverted index
+    mutable TCriticalSection GixPackedSection;
+    /// Guards position inverted index
+    mutable TCriticalSection GixPosSection;
+
     /// Location index (one for each key)
     THash<TInt, PGeoIndex> GeoIndexH;
+    /// Paged location cell index (one for each location key with paged storage)
+    THash<TInt, PGeoCellIndex> GeoCellIndexH;
 
     /// BTree index for bytes (one for each key)
     THash<TInt, PBTreeIndexUCh> BTreeIndexByteH;
@@ -3257,6 +4128,8 @@ private:
     THash<TInt, PBTreeIndexFlt> BTreeIndexFltH;
     /// BTree index for floats (one for each key)
     THash<TInt, PBTreeIndexSFlt> BTreeIndexSFltH;
+    /// Linear keys in the middle of bulk load
+    TIntSet BulkLinearKeyIdSet;
 
     /// Index Vocabulary
     PIndexVoc IndexVoc;
@@ -3267,6 +4140,8 @@ private:
     const TGixItemHandler<TQmGixKey, TQmGixItemSmall>* SumItemHandlerSmall;
     /// Inverted Index Default ItemHandler Tiny
     const TGixItemHandler<TQmGixKey, TQmGixItemTiny>* ItemHandlerTiny;
+    /// Inverted Index ItemHandler Packed
+    const TGixItemHandler<TQmGixKey, TQmGixItemFull>* ItemHandlerPacked;
     /// Inverted Index Default ItemHandler Position
     const TGixItemHandler<TQmGixKey, TQmGixItemPos>* ItemHandlerPos;
 
@@ -3281,41 +4156,75 @@ private:
 
     /// Determines which Gix should be used for given KeyId
     TIndexKeyGixType GetGixType(const int& KeyId) const { return IndexVoc->GetKey(KeyId).GetGixType(); }
+    /// Get lock guarding the inverted index of given type
+    TCriticalSection& GetGixSection(const TIndexKeyGixType& GixType) const;
     /// Executes GIX query expression against the full index
     bool DoQueryFull(const TPt<TQmGixExpItemFull>& ExpItem, TVec<TQmGixItemFull>& RecIdFqV) const;
     /// Executes GIX query expression against the small index
     bool DoQuerySmall(const TPt<TQmGixExpItemSmall>& ExpItem, TVec<TQmGixItemFull>& RecIdFqV) const;
     /// Executes GIX query expression against the tiny index
     bool DoQueryTiny(const TPt<TQmGixExpItemTiny>& ExpItem, TVec<TQmGixItemFull>& RecIdFqV) const;
+    /// Is packed index available
+    bool HasGixPacked() const { return !GixPacked.Empty(); }
+    /// Executes GIX query expression against the packed index
+    bool DoQueryPacked(const TPt<TQmGixExpItemFull>& ExpItem, TVec<TQmGixItemFull>& RecIdFqV) const;
 
-    /// Executes GIX join query against the full index
-    void DoJoinQueryFull(const int& KeyId, const TUInt64V& RecIdV, TUInt64IntKdV& RecIdFqV) const;
-    /// Executes GIX join query against the small index
-    void DoJoinQuerySmall(const int& KeyId, const TUInt64V& RecIdV, TUInt64IntKdV& RecIdFqV) const;
-    /// Executes GIX join query against the tiny index
-    void DoJoinQueryTiny(const int& KeyId, const TUInt64V& RecIdV, TUInt64IntKdV& RecIdFqV) const;
+    /// Executes top-k query against given gix, Limit of -1 ranks all the matching records.
+    /// Requires the gix section to be locked.
+    template <class TQmGixItem>
+    void DoQueryTopK(const TPt<TGix<TQmGixKey, TQmGixItem> >& Gix, const TKeyWordV& KeyWordV,
+        const bool& AllP, const uint64& Recs, const int& Limit, TUInt64IntKdV& RecIdFqV) const;
+
+    /// Executes GIX join query against given gix. With more than one thread the records
+    /// are split between threads; child vectors are copied under the gix lock and counted
+    /// outside of it, so only the gix lookups are serialized.
+    template <class TQmGixItem>
+    void DoJoinQuery(const TPt<TGix<TQmGixKey, TQmGixItem> >& Gix, TCriticalSection& GixSection,
+        const int& KeyId, const TUInt64V& RecIdV, const int& Threads, TUInt64IntKdV& RecIdFqV) const;
 
     /// Execute Position query. Result is vector of record ids and frequency of phrase occurences.
     void DoQueryPos(const int& KeyId, const TUInt64V& WordIdV, const int& MaxDiff, TUInt64IntKdV& RecIdFqV) const;
 
+    /// Create b-tree index for linear key, paged when required by the key
+    template <class TVal>
+    TPt<TBTreeIndex<TVal> > NewBTreeIndex(const int& KeyId) const;
+    /// Tell loaded paged b-tree indexes where their files are
+    template <class TVal>
+    void OpenBTreeIndexH(const THash<TInt, TPt<TBTreeIndex<TVal> > >& BTreeIndexH) const;
+    /// Flush modified nodes of paged b-tree indexes, returns number of written nodes
+    template <class TVal>
+    int PartialFlushBTreeIndexH(const THash<TInt, TPt<TBTreeIndex<TVal> > >& BTreeIndexH,
+        const int& WndInMsec) const;
+    /// Flush modified nodes of all paged b-tree indexes
+    int PartialFlushBTree(const int& WndInMsec);
+    /// End bulk load of b-tree index for given key, if key has one
+    template <class TVal>
+    void EndBTreeIndexBulkH(const THash<TInt, TPt<TBTreeIndex<TVal> > >& BTreeIndexH, const int& KeyId);
+    /// Count records in the range of b-tree index for given key, counting stops at MxRecs
+    template <class TVal>
+    int CountBTreeIndexH(const THash<TInt, TPt<TBTreeIndex<TVal> > >& BTreeIndexH, const int& KeyId,
+            const TPair<TVal, TVal>& RangeMinMax, const int& MxRecs) const {
+        return BTreeIndexH.IsKey(KeyId) ? BTreeIndexH.GetDat(KeyId)->CountRange(RangeMinMax, MxRecs) : 0; }
+
     /// method that computes the GixItemPos items for the provided list of words
     void ComputeWordItemPos(const int& KeyId, const TUInt64V& WordIdV, const uint64& RecId, TVec<TPair<TUInt64, TQmGixItemPos>>& WordIdPosPrV);
 
     /// Constructor
     TIndex(const TStr& _IndexFPath, const TFAccess& _Access, const PIndexVoc& IndexVoc,
         const int64& CacheSizeFull, const int64& CacheSizeSmall, const uint64& CacheSizeTiny,
-        const int64& CacheSizePos, const int& SplitLen);
+        const int64& CacheSizePos, const int64& CacheSizePacked, const int& SplitLen);
 public:
     /// Create (Access==faCreate) or open existing index
     static PIndex New(const TStr& IndexFPath, const TFAccess& Access, const PIndexVoc& IndexVoc,
         const int64& CacheSizeFull, const int64& CacheSizeSmall, const uint64& CacheSizeTiny,
-        const int64& CacheSizePos, const int& SplitLen);
+        const int64& CacheSizePos, const int64& CacheSizePacked, const int& SplitLen);
     /// Checks if there is an existing index at the given path
     static bool Exists(const TStr& IndexFPath) {
         return TFile::Exists(IndexFPath + "Index.GixFull.Gix") ||
             TFile::Exists(IndexFPath + "Index.GixPos.Gix") ||
             TFile::Exists(IndexFPath + "Index.GixSmall.Gix") ||
-            TFile::Exists(IndexFPath + "Index.GixTiny.Gix"); }
+            TFile::Exists(IndexFPath + "Index.GixTiny.Gix") ||
+            TFile::Exists(IndexFPath + "Index.GixPacked.Gix"); }
 
     /// Close the query
     ~TIndex();
@@ -3339,6 +4248,9 @@ public:
         const uint64& RecId, const uint64& JoinRecId, const int& JoinFq = 1);
     /// Add to inverted index (RecId, RecFq) under key (KeyId, WordId).
     void IndexGix(const int& KeyId, const uint64& WordId, const uint64& RecId, const int& RecFq);
+    /// Add to inverted index a batch of (RecId, RecFq) pairs under key (KeyId, WordId).
+    /// Item set is loaded and gix section locked only once for the whole batch.
+    void IndexGixV(const int& KeyId, const uint64& WordId, const TUInt64IntPrV& RecIdFqV);
 
     /// Delete index for RecId under (Key, Word). WordStr is sent through index vocabulary.
     void DeleteValue(const int& KeyId, const TStr& WordStr, const uint64& RecId);
@@ -3352,6 +4264,9 @@ public:
         const uint64& RecId, const uint64& JoinRecId, const int& JoinFq = TInt::Mx);
     // Delete record from inverted index
     void DeleteGix(const int& KeyId, const uint64& WordId, const uint64& RecId, const int& RecFq);
+    /// Delete from inverted index a batch of (RecId, RecFq) pairs under key (KeyId, WordId).
+    /// Item set is loaded and gix section locked only once for the whole batch.
+    void DeleteGixV(const int& KeyId, const uint64& WordId, const TUInt64IntPrV& RecIdFqV);
 
     /// Index RecId using given keys and words. Words are extracted by tokenizing the given string.
     void IndexTextPos(const int& KeyId, const TStr& TextStr, const uint64& RecId);
@@ -3407,6 +4322,12 @@ public:
     void DeleteLinear(const int& KeyId, const double& Val, const uint64& RecId);
     /// Delete RecId from linear index under (Key, Val)
     void DeleteLinear(const int& KeyId, const float& Val, const uint64& RecId);
+    /// Start bulk load of linear index. Values added with IndexLinear are only
+    /// collected until EndLinearBulk, which sorts them and builds an empty b-tree
+    /// bottom-up instead of inserting values one by one.
+    void StartLinearBulk(const int& KeyId);
+    /// End bulk load of linear index and add collected values to the b-tree
+    void EndLinearBulk(const int& KeyId);
 
     /// Check if index opened in read-only mode
     bool IsReadOnly() const { return Access == faRdOnly; }
@@ -3418,10 +4339,23 @@ public:
     /// Search inverted index for records matching at least one word from the same key
     PRecSet SearchGixOr(const TWPt<TBase>& Base, const int& KeyId, const TUInt64V& WordIdV) const;
 
+    /// Top-k search ranked by relevance. Returns at most Limit records, which contain all
+    /// (AllP) or any of the given words, ordered by BM25 score and then by record ID. Uses
+    /// per-child bounds to skip records (WAND), so only a small part of the posting lists is
+    /// scored for common words. Limit of -1 returns all matching records in the same order.
+    /// Weights of the returned records are summed frequencies, same as for SearchGixAnd.
+    PRecSet SearchGixTopK(const TWPt<TBase>& Base, const int& KeyId,
+        const TUInt64V& WordIdV, const bool& AllP, const int& Limit) const;
+
+    /// Number of records indexed under (Key, Word), used for estimating query selectivity
+    int GetGixItems(const int& KeyId, const uint64& WordId) const;
+
     /// Low-level access to Gix search used for joining
     void SearchGixJoin(const int& KeyId, const uint64& RecId, TUInt64IntKdV& JoinRecIdFqV) const;
-    /// Low-level access to Gix search used for joining
-    void SearchGixJoin(const int& KeyId, const TUInt64V& RecIdV, TUInt64IntKdV& JoinRecIdFqV) const;
+    /// Low-level access to Gix search used for joining. Records from RecIdV are
+    /// joined using up to Threads threads.
+    void SearchGixJoin(const int& KeyId, const TUInt64V& RecIdV,
+        TUInt64IntKdV& JoinRecIdFqV, const int& Threads = 1) const;
 
     /// Search text position inverted index where given words are MaxDiff appart.
     PRecSet SearchTextPos(const TWPt<TBase>& Base, const int& KeyId,
@@ -3433,6 +4367,10 @@ public:
     /// Do geo-location nearest-neighbor search
     PRecSet SearchGeoNn(const TWPt<TBase>& Base, const int& KeyId,
         const TFltPr& Loc, const int& Limit) const;
+    /// Do geo-location search inside polygon (or box, when given by two corners),
+    /// returns at most Limit records nearest to Loc
+    PRecSet SearchGeoArea(const TWPt<TBase>& Base, const int& KeyId,
+        const TFltPrV& AreaV, const TFltPr& Loc, const int& Limit) const;
 
     /// Do B-Tree linear search
     PRecSet SearchLinear(const TWPt<TBase>& Base, const int& KeyId, const TUChPr& RangeMinMax);
@@ -3453,6 +4391,34 @@ public:
     /// Do B-Tree linear search
     PRecSet SearchLinear(const TWPt<TBase>& Base, const int& KeyId, const TSFltPr& RangeMinMax);
 
+    /// Number of records matching B-Tree linear search, counting stops at MxRecs
+    int CountLinear(const int& KeyId, const TUChPr& RangeMinMax, const int& MxRecs) const {
+        return CountBTreeIndexH(BTreeIndexByteH, KeyId, RangeMinMax, MxRecs); }
+    /// Number of records matching B-Tree linear search, counting stops at MxRecs
+    int CountLinear(const int& KeyId, const TIntPr& RangeMinMax, const int& MxRecs) const {
+        return CountBTreeIndexH(BTreeIndexIntH, KeyId, RangeMinMax, MxRecs); }
+    /// Number of records matching B-Tree linear search, counting stops at MxRecs
+    int CountLinear(const int& KeyId, const TInt16Pr& RangeMinMax, const int& MxRecs) const {
+        return CountBTreeIndexH(BTreeIndexInt16H, KeyId, RangeMinMax, MxRecs); }
+    /// Number of records matching B-Tree linear search, counting stops at MxRecs
+    int CountLinear(const int& KeyId, const TInt64Pr& RangeMinMax, const int& MxRecs) const {
+        return CountBTreeIndexH(BTreeIndexInt64H, KeyId, RangeMinMax, MxRecs); }
+    /// Number of records matching B-Tree linear search, counting stops at MxRecs
+    int CountLinear(const int& KeyId, const TUIntUIntPr& RangeMinMax, const int& MxRecs) const {
+        return CountBTreeIndexH(BTreeIndexUIntH, KeyId, RangeMinMax, MxRecs); }
+    /// Number of records matching B-Tree linear search, counting stops at MxRecs
+    int CountLinear(const int& KeyId, const TUInt16Pr& RangeMinMax, const int& MxRecs) const {
+        return CountBTreeIndexH(BTreeIndexUInt16H, KeyId, RangeMinMax, MxRecs); }
+    /// Number of records matching B-Tree linear search, counting stops at MxRecs
+    int CountLinear(const int& KeyId, const TUInt64Pr& RangeMinMax, const int& MxRecs) const {
+        return CountBTreeIndexH(BTreeIndexUInt64H, KeyId, RangeMinMax, MxRecs); }
+    /// Number of records matching B-Tree linear search, counting stops at MxRecs
+    int CountLinear(const int& KeyId, const TFltPr& RangeMinMax, const int& MxRecs) const {
+        return CountBTreeIndexH(BTreeIndexFltH, KeyId, RangeMinMax, MxRecs); }
+    /// Number of records matching B-Tree linear search, counting stops at MxRecs
+    int CountLinear(const int& KeyId, const TSFltPr& RangeMinMax, const int& MxRecs) const {
+        return CountBTreeIndexH(BTreeIndexSFltH, KeyId, RangeMinMax, MxRecs); }
+
     /// Are there any existing joins from RecId using JoinKeyId
     bool HasJoin(const int& JoinKeyId, const uint64& RecId) const;
 
@@ -3603,6 +4569,14 @@ public:
 
     // retrieving input aggregate names
     virtual void GetInAggrNmV(TStrV& InAggrNmV) const { };
+    /// Does GetInAggrNmV list all the aggregates read during updates. In parallel mode
+    /// aggregates that do not declare their inputs are updated alone, after the
+    /// aggregates added before them and before the ones added after them.
+    virtual bool IsInAggrNmVDeclared() const { return false; }
+    /// Can the aggregate be updated on a worker thread, concurrently with aggregates
+    /// it does not depend on. Aggregates that forward updates to other aggregates,
+    /// write to stores or call into a scripting engine should return false.
+    virtual bool IsThreadSafe() const { return true; }
 
     /// Print latest statistics to logger
     virtual void PrintStat() const { }
@@ -3728,10 +4702,24 @@ namespace TStreamAggrOut {
 /// Stream aggregator set.
 /// Holds a set of stream aggregates and triggers them all on call.
 /// Aggregates are triggered in the same order as they are added to the set.
+/// In parallel mode the set is split into waves using the dependencies from
+/// GetInAggrNmV, and aggregates from the same wave are updated in parallel.
+/// Aggregates that are not thread safe or do not declare their inputs get a wave
+/// of their own, so they keep their place in the serial order.
+/// Each wave finishes before the next one starts and before the call returns.
 class TStreamAggrSet : public TStreamAggr {
 protected:
     /// List of aggregates triggered in step
     TVec<TWPt<TStreamAggr> > StreamAggrV;
+    /// Update independent aggregates in parallel
+    TBool ParallelP;
+    /// Positions of aggregates in StreamAggrV, grouped into waves of independent aggregates
+    TVec<TIntV> WaveV;
+
+    /// Split aggregates into waves
+    void InitWaves();
+    /// Call given function for all aggregates, in waves when in parallel mode
+    template <class TOnAggr> void ExecAggrs(const TOnAggr& OnAggr);
 
     /// Create empty aggregate base
     TStreamAggrSet(const TWPt<TBase>& _Base, const TStr& _AggrNm);
@@ -3756,6 +4744,13 @@ public:
     /// Get list of all aggregates
     TStrV GetStreamAggrNmV() const;
 
+    /// Is the set updating independent aggregates in parallel
+    bool IsParallel() const { return ParallelP; }
+    /// Enable or disable parallel updates of independent aggregates
+    void SetParallel(const bool& _ParallelP) { ParallelP = _ParallelP; }
+    /// Sets forward updates to their members
+    bool IsThreadSafe() const { return false; }
+
     /// Reset all aggregates in the set
     void Reset();
 
@@ -3825,6 +4820,8 @@ private:
     PIndex Index;
     /// Shared stora storage layer
     PBlobBs StoreBlobBs;
+    /// Serializes reads and writes to the shared store storage layer
+    mutable TCriticalSection StoreBlobBsSection;
     /// List of open stores
     TVec<PStore> StoreV;
     /// Map from store name to store
@@ -3837,12 +4834,36 @@ private:
 
     /// Name validates used for validating field, join and key names
     TNmValidator NmValidator;
+    /// Cache of query results (null when disabled)
+    PQueryCache QueryCache;
+    /// Default number of threads used to evaluate a query
+    TInt QueryThreads;
 
 private:
-    /// Invert given record set (replace with all the records from the store that are not in it)
-    PRecSet Invert(const PRecSet& RecSet);
+    /// Invert given record set (replace with all the records from the store that are not in it).
+    /// When MxRecs is not -1, only the first MxRecs records of the inverted set are returned.
+    PRecSet Invert(const PRecSet& RecSet, const int& MxRecs = -1);
+    /// Estimate number of records matched by query item, used to order operands of AND.
+    /// Returns TInt::Mx for negations and for items we cannot estimate cheaply. Ranges
+    /// are counted in the b-tree, counting stops at MxRecs.
+    int GetQueryItemRecs(const TQueryItem& QueryItem, const int& MxRecs = TInt::Mx) const;
+    /// Can range item be evaluated by checking field values of candidate records
+    bool IsQueryItemProbe(const TQueryItem& QueryItem) const;
+    /// Keep only candidate records matching the range item, checked on their field values
+    void ProbeQueryItem(const TQueryItem& QueryItem, TUInt64IntKdV& RecIdFqV) const;
     /// Execute search query. Returns results and a flag indicating if the results should be inverted.
-    TPair<TBool, PRecSet> _Search(const TQueryItem& QueryItem);
+    /// Results are taken from the query cache when possible.
+    /// Independent subordinate items and joins are evaluated using up to Threads threads.
+    /// When PlanVal is given, executed steps are added to it (requires one thread).
+    TPair<TBool, PRecSet> _Search(const TQueryItem& QueryItem, const int& Threads, const PJsonVal& PlanVal);
+    /// Execute search query without looking into the query cache.
+    TPair<TBool, PRecSet> _SearchItem(const TQueryItem& QueryItem, const int& Threads, const PJsonVal& PlanVal);
+    /// Execute subordinate items with given positions, results are stored in NotRecSetV
+    void _SearchItems(const TQueryItem& QueryItem, const TIntV& ItemNV, const int& Threads,
+        const PJsonVal& PlanVal, TVec<TPair<TBool, PRecSet> >& NotRecSetV);
+    /// Describe executed query step for the query plan
+    PJsonVal GetQueryStep(const TQueryItem& QueryItem, const TStr& StrategyStr,
+        const int& Recs, const bool& NotP, const double& MSecs) const;
 
     /// Get config name for base located on a given path
     static TStr GetConfFNm(const TStr& FPath) { return FPath + "Base.json"; }
@@ -3910,6 +4931,8 @@ public:
     PJsonVal GetStoreJson(const TWPt<TStore>& Store);
     /// Get store blob base
     const PBlobBs& GetStoreBlobBs() { return StoreBlobBs; }
+    /// Get lock guarding the store blob base
+    TCriticalSection& GetStoreBlobBsSection() const { return StoreBlobBsSection; }
 
     /// Check if base has stream aggregate with the given name
     bool IsStreamAggr(const TStr& StreamAggrNm) const;
@@ -3948,6 +4971,25 @@ public:
     PRecSet Search(const TStr& QueryStr);
     /// Searching records (default search interface)
     PRecSet Search(const PJsonVal& QueryVal);
+    /// Execute the query and describe how it was evaluated: the tree of executed steps
+    /// in execution order, each with estimated and actual number of records, strategy
+    /// (index, probe, merge or cache) and time in milliseconds. Runs on one thread.
+    PJsonVal Explain(const PQuery& Query);
+
+    /// Enable caching of query results using at most MxMemUsed bytes. Zero disables the cache.
+    void SetQueryCache(const int64& MxMemUsed);
+    /// Is query cache enabled
+    bool IsQueryCache() const { return !QueryCache.Empty(); }
+    /// Drop all cached query results
+    void ClrQueryCache() { if (!QueryCache.Empty()) { QueryCache->Clr(); } }
+    /// Query cache statistics (hits, misses, items, memory)
+    PJsonVal GetQueryCacheStats() const;
+    /// Set default number of threads used to evaluate independent parts of a query.
+    /// Queries can override it with $parallel. Only used when all stores read by
+    /// the query support concurrent reads.
+    void SetQueryThreads(const int& Threads);
+    /// Default number of threads used to evaluate a query
+    int GetQueryThreads() const { return QueryThreads; }
 
     /// Execute garbage collection on all stores.
     /// Each store is given MxTimeMSecs for the collection.
@@ -15,6 +15,57 @@ void TRecSet::FilterBy(const TFilter& Filter) {
     RecIdFqV = NewRecIdFqV;
 }
 
+template <class TVal, class TGetVal>
+void TRecSet::GetFieldValV(const int& FieldId, const TIntV& RecNV, const TGetVal& GetVal,
+        TVec<TVal>& ValV, TBoolV* NullV) const {
+
+    const int Recs = GetRecs();
+    ValV.Gen(Recs);
+    if (NullV != NULL) { NullV->Gen(Recs); }
+    // each thread reads a continuous block of records
+    const int Threads = GetReadThreads();
+    int ErrorN = Recs; PExcept ErrorExcept;
+    #pragma omp parallel for schedule(static) num_threads(Threads) if (Threads > 1)
+    for (int N = 0; N < Recs; N++) {
+        try {
+            const int RecN = RecNV.Empty() ? N : RecNV[N].Val;
+            const uint64 RecId = RecIdFqV[RecN].Key;
+            if (NullV != NULL) {
+                (*NullV)[RecN] = Store->IsFieldNull(RecId, FieldId);
+                if ((*NullV)[RecN]) { continue; }
+            }
+            ValV[RecN] = GetVal(RecId);
+        } catch (const PExcept& Except) {
+            #pragma omp critical
+            {
+                if (N < ErrorN) { ErrorN = N; ErrorExcept = Except; }
+            }
+        }
+    }
+    if (!ErrorExcept.Empty()) { throw ErrorExcept; }
+}
+
+template <class TVal, class TGetVal>
+void TRecSet::FilterByFieldVal(const int& FieldId, const TGetVal& GetVal, const TVal& MinVal, const TVal& MaxVal) {
+    // read values of all records
+    TIntV RecNV; GetRecIdOrderV(RecNV);
+    TVec<TVal> ValV; TBoolV NullV;
+    GetFieldValV(FieldId, RecNV, GetVal, ValV, &NullV);
+    // mark records to keep without branching, so the loop can be vectorized
+    const int Recs = GetRecs();
+    TVec<TUCh> KeepV(Recs);
+    for (int RecN = 0; RecN < Recs; RecN++) {
+        KeepV[RecN] = (uchar)(!NullV[RecN].Val & (MinVal <= ValV[RecN]) & (ValV[RecN] <= MaxVal));
+    }
+    // compact the records that passed the filter
+    TUInt64IntKdV NewRecIdFqV(Recs); int NewRecs = 0;
+    for (int RecN = 0; RecN < Recs; RecN++) {
+        NewRecIdFqV[NewRecs] = RecIdFqV[RecN]; NewRecs += KeepV[RecN].Val;
+    }
+    NewRecIdFqV.Trunc(NewRecs);
+    RecIdFqV = NewRecIdFqV;
+}
+
 template <class TSplitter>
 TVec<PRecSet> TRecSet::SplitBy(const TSplitter& Splitter) const {
     TRecSetV ResV;
@@ -42,26 +93,206 @@ TVec<PRecSet> TRecSet::SplitBy(const TSplitter& Splitter) const {
 ///////////////////////////////
 // B-Tree Index
 template <class TVal>
-void TBTreeIndex<TVal>::AddKey(const TVal& Val, const uint64& RecId) {
-    BTree.Add(TTreeVal(Val, RecId));
+void TBTreeIndex<TVal>::GetRecIdV(const TVec<TTreeVal>& ValRecIdV, TUInt64V& RecIdV) {
+    RecIdV.Gen(ValRecIdV.Len(), 0);
+    for (int ResN = 0; ResN < ValRecIdV.Len(); ResN++) {
+        RecIdV.Add(ValRecIdV[ResN].Val2);
+    }
 }
 
 template <class TVal>
-void TBTreeIndex<TVal>::DelKey(const TVal& Val, const uint64& RecId) {
-    BTree.Del(TTreeVal(Val, RecId));
+void TBTreeIndex<TVal>::FlushBulk() {
+    if (BulkKdV.Empty()) { return; }
+    // sorts by value and then by record id
+    BulkKdV.Sort();
+    AddKdV(BulkKdV);
+    BulkKdV.Clr();
 }
 
 template <class TVal>
-void TBTreeIndex<TVal>::SearchRange(const TPair<TVal, TVal>& RangeMinMax, TUInt64V& RecIdV) const {
+TPt<TBTreeIndex<TVal> > TBTreeIndex<TVal>::New() {
+    return new TBTreeMemIndex<TVal>();
+}
+
+template <class TVal>
+TPt<TBTreeIndex<TVal> > TBTreeIndex<TVal>::New(const TStr& FPath, const TStr& FNm) {
+    return new TBTreePgIndex<TVal>(FPath, FNm);
+}
 
+template <class TVal>
+TPt<TBTreeIndex<TVal> > TBTreeIndex<TVal>::Load(TSIn& SIn) {
+    // memory index starts with null flag of its internal store, which is always false
+    TBool PagedP = false; PagedP.Load(SIn);
+    if (PagedP) { return new TBTreePgIndex<TVal>(SIn); }
+    return new TBTreeMemIndex<TVal>(SIn);
+}
+
+///////////////////////////////
+// B-Tree Index with nodes in memory
+template <class TVal>
+void TBTreeMemIndex<TVal>::AddKdV(const TVec<TTreeKd>& KdV) {
+    if (BTree.nLevels == 1) {
+        // empty tree, build it bottom-up
+        BTree.BulkLoad(KdV);
+    } else {
+        for (int KdN = 0; KdN < KdV.Len(); KdN++) { BTree.Add(KdV[KdN].Key); }
+    }
+}
+
+template <class TVal>
+void TBTreeMemIndex<TVal>::Save(TSOut& SOut) {
+    this->FlushBulk();
+    InternalStore.Save(SOut); LeafStore.Save(SOut); BTree.Save(SOut);
+}
+
+template <class TVal>
+void TBTreeMemIndex<TVal>::AddKey(const TVal& Val, const uint64& RecId) {
+    if (this->BulkP) {
+        this->BulkKdV.Add(TTreeKd(TTreeVal(Val, RecId)));
+    } else {
+        BTree.Add(TTreeVal(Val, RecId));
+    }
+}
+
+template <class TVal>
+void TBTreeMemIndex<TVal>::DelKey(const TVal& Val, const uint64& RecId) {
+    // deleted value might still be waiting for bulk load
+    this->FlushBulk();
+    BTree.Del(TTreeVal(Val, RecId));
+}
+
+template <class TVal>
+void TBTreeMemIndex<TVal>::SearchRange(const TPair<TVal, TVal>& RangeMinMax, TUInt64V& RecIdV) const {
     TVec<TTreeVal> ResValRecIdV;
     // execute query
     BTree.RangeQuery(TTreeVal(RangeMinMax.Val1, 0), TTreeVal(RangeMinMax.Val2, TUInt64::Mx), ResValRecIdV);
     // parse out record ids
-    RecIdV.Gen(ResValRecIdV.Len(), 0);
-    for (int ResN = 0; ResN < ResValRecIdV.Len(); ResN++) {
-        RecIdV.Add(ResValRecIdV[ResN].Val2);
+    TBTreeIndex<TVal>::GetRecIdV(ResValRecIdV, RecIdV);
+}
+
+template <class TVal>
+void TBTreeMemIndex<TVal>::SearchRange(const TPair<TVal, TVal>& RangeMinMax, TVec<TTreeVal>& ValRecIdV) const {
+    BTree.RangeQuery(TTreeVal(RangeMinMax.Val1, 0), TTreeVal(RangeMinMax.Val2, TUInt64::Mx), ValRecIdV, false);
+}
+
+template <class TVal>
+int TBTreeMemIndex<TVal>::CountRange(const TPair<TVal, TVal>& RangeMinMax, const int& MxRecs) const {
+    return BTree.RangeCount(TTreeVal(RangeMinMax.Val1, 0), TTreeVal(RangeMinMax.Val2, TUInt64::Mx), MxRecs);
+}
+
+///////////////////////////////
+// B-Tree Index with nodes in paged blob files
+template <class TVal>
+void TBTreePgIndex<TVal>::AddKdV(const TVec<TTreeKd>& KdV) {
+    TLock Lock(NodeSection);
+    if (BTree.nLevels == 1) {
+        // empty tree, build it bottom-up
+        BTree.BulkLoad(KdV);
+    } else {
+        for (int KdN = 0; KdN < KdV.Len(); KdN++) { BTree.Add(KdV[KdN].Key); }
+    }
+}
+
+template <class TVal>
+void TBTreePgIndex<TVal>::Save(TSOut& SOut) {
+    this->FlushBulk();
+    TLock Lock(NodeSection);
+    TBool(true).Save(SOut); FNm.Save(SOut);
+    // saving the stores also writes all modified nodes to disk
+    InternalStore.Save(SOut); LeafStore.Save(SOut);
+    BTree.Save(SOut);
+}
+
+template <class TVal>
+void TBTreePgIndex<TVal>::Open(const TStr& FPath, const TFAccess& Access) {
+    InternalStore->Open(FPath + FNm + ".Internal", Access);
+    LeafStore->Open(FPath + FNm + ".Leaf", Access);
+}
+
+template <class TVal>
+int TBTreePgIndex<TVal>::PartialFlush(const int& WndInMsec) {
+    TLock Lock(NodeSection);
+    // leaves are modified much more often
+    const int WndInMsecInternal = WndInMsec / 4;
+    return InternalStore->PartialFlush(WndInMsecInternal) +
+        LeafStore->PartialFlush(WndInMsec - WndInMsecInternal);
+}
+
+template <class TVal>
+void TBTreePgIndex<TVal>::AddKey(const TVal& Val, const uint64& RecId) {
+    if (this->BulkP) {
+        this->BulkKdV.Add(TTreeKd(TTreeVal(Val, RecId)));
+        return;
+    }
+    TLock Lock(NodeSection);
+    BTree.Add(TTreeVal(Val, RecId));
+}
+
+template <class TVal>
+void TBTreePgIndex<TVal>::DelKey(const TVal& Val, const uint64& RecId) {
+    // deleted value might still be waiting for bulk load
+    this->FlushBulk();
+    TLock Lock(NodeSection);
+    BTree.Del(TTreeVal(Val, RecId));
+}
+
+template <class TVal>
+void TBTreePgIndex<TVal>::SearchRange(const TPair<TVal, TVal>& RangeMinMax, TUInt64V& RecIdV) const {
+    TVec<TTreeVal> ResValRecIdV;
+    {
+        TLock Lock(NodeSection);
+        BTree.RangeQuery(TTreeVal(RangeMinMax.Val1, 0), TTreeVal(RangeMinMax.Val2, TUInt64::Mx), ResValRecIdV);
     }
+    TBTreeIndex<TVal>::GetRecIdV(ResValRecIdV, RecIdV);
+}
+
+template <class TVal>
+void TBTreePgIndex<TVal>::SearchRange(const TPair<TVal, TVal>& RangeMinMax, TVec<TTreeVal>& ValRecIdV) const {
+    TLock Lock(NodeSection);
+    BTree.RangeQuery(TTreeVal(RangeMinMax.Val1, 0), TTreeVal(RangeMinMax.Val2, TUInt64::Mx), ValRecIdV, false);
+}
+
+template <class TVal>
+int TBTreePgIndex<TVal>::CountRange(const TPair<TVal, TVal>& RangeMinMax, const int& MxRecs) const {
+    TLock Lock(NodeSection);
+    return BTree.RangeCount(TTreeVal(RangeMinMax.Val1, 0), TTreeVal(RangeMinMax.Val2, TUInt64::Mx), MxRecs);
+}
+
+///////////////////////////////
+/// QMiner Index
+template <class TVal>
+TPt<TBTreeIndex<TVal> > TIndex::NewBTreeIndex(const int& KeyId) const {
+    TPt<TBTreeIndex<TVal> > BTreeIndex = IndexVoc->GetKey(KeyId).IsPaged() ?
+        TBTreeIndex<TVal>::New(IndexFPath, "Index.BTree." + TInt::GetStr(KeyId)) :
+        TBTreeIndex<TVal>::New();
+    // index created during bulk load of its key also only collects values
+    if (BulkLinearKeyIdSet.IsKey(KeyId)) { BTreeIndex->StartBulk(); }
+    return BTreeIndex;
+}
+
+template <class TVal>
+void TIndex::OpenBTreeIndexH(const THash<TInt, TPt<TBTreeIndex<TVal> > >& BTreeIndexH) const {
+    int KeyId = BTreeIndexH.FFirstKeyId();
+    while (BTreeIndexH.FNextKeyId(KeyId)) {
+        if (BTreeIndexH[KeyId]->IsPaged()) { BTreeIndexH[KeyId]->Open(IndexFPath, Access); }
+    }
+}
+
+template <class TVal>
+void TIndex::EndBTreeIndexBulkH(const THash<TInt, TPt<TBTreeIndex<TVal> > >& BTreeIndexH, const int& KeyId) {
+    if (BTreeIndexH.IsKey(KeyId)) { BTreeIndexH.GetDat(KeyId)->EndBulk(); }
+}
+
+template <class TVal>
+int TIndex::PartialFlushBTreeIndexH(const THash<TInt, TPt<TBTreeIndex<TVal> > >& BTreeIndexH,
+        const int& WndInMsec) const {
+
+    int Res = 0;
+    int KeyId = BTreeIndexH.FFirstKeyId();
+    while (BTreeIndexH.FNextKeyId(KeyId)) {
+        if (BTreeIndexH[KeyId]->IsPaged()) { Res += BTreeIndexH[KeyId]->PartialFlush(WndInMsec); }
+    }
+    return Res;
 }
 
 ///////////////////////////////
@@ -126,6 +357,28 @@ template <class TQmGixItem, class TQmGixResItem>
 void TIndex::TQmGixSumMerger<TQmGixItem, TQmGixResItem>::Intrs(
         TVec<TQmGixResItem>& MainV, const TVec<TQmGixResItem>& JoinV) const {
 
+    // when one vector is much shorter, gallop over the longer one
+    const int GallopRatio = 16;
+    if (MainV.Len() * GallopRatio < JoinV.Len() || JoinV.Len() * GallopRatio < MainV.Len()) {
+        const bool MainShortP = MainV.Len() < JoinV.Len();
+        const TVec<TQmGixResItem>& ShortV = MainShortP ? MainV : JoinV;
+        const TVec<TQmGixResItem>& LongV = MainShortP ? JoinV : MainV;
+        TVec<TQmGixResItem> ResV(ShortV.Len(), 0); int LongN = 0;
+        for (const TQmGixResItem& Val : ShortV) {
+            // double the step until we pass the value, then binary search inside last step
+            int Step = 1;
+            while (LongN + Step < LongV.Len() && LongV[LongN + Step] < Val) { LongN += Step; Step *= 2; }
+            int HiN = TInt::GetMn(LongN + Step, LongV.Len());
+            while (LongN < HiN) {
+                const int MidN = (LongN + HiN) / 2;
+                if (LongV[MidN] < Val) { LongN = MidN + 1; } else { HiN = MidN; }
+            }
+            if (LongN == LongV.Len()) { break; }
+            if (LongV[LongN] == Val) { ResV.Add(TQmGixResItem(Val.Key, Val.Dat + LongV[LongN].Dat)); LongN++; }
+        }
+        MainV = ResV;
+        return;
+    }
     TVec<TQmGixResItem> ResV; int ValN1 = 0; int ValN2 = 0;
     while ((ValN1 < MainV.Len()) && (ValN2 < JoinV.Len())) {
         const TQmGixResItem& Val1 = MainV.GetVal(ValN1);
@@ -164,3 +417,308 @@ void TIndex::TQmGixSumWithoutFqMerger<TQmGixItem, TQmGixResItem>::Def(const TQmG
         ResV.Add(TQmGixResItem(Item.Val, 1));
     }
 }
+
+///////////////////////////////
+/// Top-k cursor over records of one word
+template <class TQmGixItem>
+TIndex::TQmGixTopKCursor<TQmGixItem>::TQmGixTopKCursor(const PQmGixItemSet& _ItemSet,
+        const double& _Idf): ItemSet(_ItemSet), Idf(_Idf), ChildN(0), ItemN(0) {
+
+    // working buffer is in memory, so we can get exact bound
+    WorkMxScore = 0.0;
+    for (const TQmGixItem& Item : ItemSet->GetWorkItemV()) {
+        WorkMxScore = TFlt::GetMx(WorkMxScore, GetBm25(Idf, GetItemFq(Item)));
+    }
+    // for child vectors we use their summaries
+    MxScore = WorkMxScore;
+    for (int _ChildN = 0; _ChildN < ItemSet->GetChildVecs(); _ChildN++) {
+        MxScore = TFlt::GetMx(MxScore, GetChildMxScore(_ChildN));
+    }
+    // position on the first record
+    LoadChild(0);
+}
+
+template <class TQmGixItem>
+void TIndex::TQmGixTopKCursor<TQmGixItem>::LoadChild(const int& _ChildN) {
+    ChildN = _ChildN; ItemN = 0; ItemV.Clr(false);
+    while (ChildN <= ItemSet->GetChildVecs()) {
+        if (ChildN < ItemSet->GetChildVecs()) {
+            ItemSet->GetChildItemV(ChildN, ItemV);
+        } else {
+            ItemV = ItemSet->GetWorkItemV();
+        }
+        // deletes can leave child vectors empty
+        if (!ItemV.Empty()) { break; }
+        ChildN++;
+    }
+}
+
+template <class TQmGixItem>
+int TIndex::TQmGixTopKCursor<TQmGixItem>::FindChildN(const uint64& RecId) const {
+    const int ChildVecs = ItemSet->GetChildVecs();
+    int _ChildN = ChildN;
+    while (_ChildN < ChildVecs && GetItemRecId(ItemSet->GetChildMaxItem(_ChildN)) < RecId) { _ChildN++; }
+    if (_ChildN == ChildVecs) {
+        const TVec<TQmGixItem>& WorkItemV = ItemSet->GetWorkItemV();
+        if (WorkItemV.Empty() || GetItemRecId(WorkItemV.Last()) < RecId) { _ChildN++; }
+    }
+    return _ChildN;
+}
+
+template <class TQmGixItem>
+uint64 TIndex::TQmGixTopKCursor<TQmGixItem>::GetChildMxRecId(const int& _ChildN) const {
+    if (_ChildN < ItemSet->GetChildVecs()) {
+        return GetItemRecId(ItemSet->GetChildMaxItem(_ChildN));
+    } else if (_ChildN == ItemSet->GetChildVecs() && !ItemSet->GetWorkItemV().Empty()) {
+        return GetItemRecId(ItemSet->GetWorkItemV().Last());
+    }
+    return TUInt64::Mx;
+}
+
+template <class TQmGixItem>
+double TIndex::TQmGixTopKCursor<TQmGixItem>::GetChildMxScore(const int& _ChildN) const {
+    if (_ChildN < ItemSet->GetChildVecs()) {
+        // without frequency bounds we can only use the BM25 saturation limit
+        const int MxFq = ItemSet->GetChildMxWgt(_ChildN);
+        return (MxFq == TInt::Mx) ? Idf * (TopKBm25K1 + 1.0) : GetBm25(Idf, MxFq);
+    } else if (_ChildN == ItemSet->GetChildVecs()) {
+        return WorkMxScore;
+    }
+    return 0.0;
+}
+
+template <class TQmGixItem>
+void TIndex::TQmGixTopKCursor<TQmGixItem>::Next() {
+    ItemN++;
+    if (ItemN == ItemV.Len()) { LoadChild(ChildN + 1); }
+}
+
+template <class TQmGixItem>
+void TIndex::TQmGixTopKCursor<TQmGixItem>::NextGEq(const uint64& RecId) {
+    while (!IsEnd() && GetRecId() < RecId) {
+        // skip child vectors which end before RecId without loading them
+        const int NextChildN = FindChildN(RecId);
+        if (NextChildN != ChildN) { LoadChild(NextChildN); continue; }
+        // binary search inside current child vector
+        int MnItemN = ItemN, MxItemN = ItemV.Len();
+        while (MnItemN < MxItemN) {
+            const int MidItemN = (MnItemN + MxItemN) / 2;
+            if (GetItemRecId(ItemV[MidItemN]) < RecId) { MnItemN = MidItemN + 1; } else { MxItemN = MidItemN; }
+        }
+        if (MnItemN < ItemV.Len()) { ItemN = MnItemN; } else { LoadChild(ChildN + 1); }
+    }
+}
+
+///////////////////////////////
+/// Top-k query over one gix
+template <class TQmGixItem>
+void TIndex::DoQueryTopK(const TPt<TGix<TQmGixKey, TQmGixItem> >& Gix, const TKeyWordV& KeyWordV,
+        const bool& AllP, const uint64& Recs, const int& Limit, TUInt64IntKdV& RecIdFqV) const {
+
+    typedef TQmGixTopKCursor<TQmGixItem> TCursor;
+    RecIdFqV.Clr();
+    // without a limit the heap never fills up, so no records are skipped
+    const int TopRecs = (Limit == -1) ? TInt::Mx : Limit;
+    if (TopRecs <= 0) { return; }
+    // prepare cursors for all words
+    TVec<TCursor> CursorV;
+    for (const TKeyWord& KeyWord : KeyWordV) {
+        TPt<TGixItemSet<TQmGixKey, TQmGixItem> > ItemSet = Gix->GetItemSet(KeyWord);
+        if (!ItemSet.Empty()) { ItemSet->Def(); }
+        if (ItemSet.Empty() || ItemSet->Empty()) {
+            // when all words are required, nothing can match
+            if (AllP) { return; } else { continue; }
+        }
+        const double Df = (double)ItemSet->GetItems();
+        const double Idf = TMath::Log(1.0 + ((double)Recs - Df + 0.5) / (Df + 0.5));
+        CursorV.Add(TCursor(ItemSet, TFlt::GetMx(Idf, TFlt::EpsHalf)));
+    }
+    if (CursorV.Empty()) { return; }
+
+    // heap with current top records, lowest ranked on top; records are scored in
+    // increasing order of IDs, so a record tied with the lowest ranked one never
+    // gets in, and skipping bounds that only reach the threshold is exact
+    const TQmGixTopKCmp TopCmp;
+    THeap<TQmGixTopKItem, TQmGixTopKCmp> TopHeap(TopCmp);
+    // score threshold a record must exceed to get into the top records
+    auto GetTheta = [&]() { return (TopHeap.Len() < TopRecs) ? -1.0 : (double)TopHeap.TopHeap().Val1; };
+    auto AddTop = [&](const double& Score, const uint64& RecId, const int& Fq) {
+        const TQmGixTopKItem Item(Score, RecId, Fq);
+        if (TopHeap.Len() < TopRecs) {
+            TopHeap.PushHeap(Item);
+        } else if (TopCmp(Item, TopHeap.TopHeap())) {
+            TopHeap.PopHeap(); TopHeap.PushHeap(Item);
+        }
+    };
+    // record after the child vector that can contain RecId
+    auto GetNextRecId = [](const TCursor& Cursor, const int& ChildN) {
+        const uint64 MxRecId = Cursor.GetChildMxRecId(ChildN);
+        return (MxRecId == TUInt64::Mx) ? MxRecId : MxRecId + 1;
+    };
+
+    if (AllP) {
+        // all cursors must agree on the record (leapfrog), child vectors with
+        // too small score bounds are skipped together for all the words
+        while (true) {
+            // candidate is the largest current record
+            uint64 RecId = 0; bool EndP = false;
+            for (const TCursor& Cursor : CursorV) {
+                if (Cursor.IsEnd()) { EndP = true; break; }
+                RecId = TMath::Mx(RecId, Cursor.GetRecId());
+            }
+            if (EndP) { break; }
+            // check bounds of child vectors that can contain the candidate
+            const double Theta = GetTheta();
+            double ChildMxScore = 0.0; uint64 NextRecId = TUInt64::Mx;
+            for (const TCursor& Cursor : CursorV) {
+                const int ChildN = Cursor.FindChildN(RecId);
+                ChildMxScore += Cursor.GetChildMxScore(ChildN);
+                NextRecId = TMath::Mn(NextRecId, GetNextRecId(Cursor, ChildN));
+            }
+            if (NextRecId == TUInt64::Mx) { break; }
+            if (ChildMxScore <= Theta) {
+                // nothing before NextRecId can get into the top records
+                for (TCursor& Cursor : CursorV) { Cursor.NextGEq(NextRecId); }
+                continue;
+            }
+            // move all cursors to the candidate
+            bool MatchP = true;
+            for (TCursor& Cursor : CursorV) {
+                Cursor.NextGEq(RecId);
+                if (Cursor.IsEnd()) { EndP = true; break; }
+                if (Cursor.GetRecId() != RecId) { MatchP = false; }
+            }
+            if (EndP) { break; }
+            if (MatchP) {
+                double Score = 0.0; int Fq = 0;
+                for (const TCursor& Cursor : CursorV) { Score += Cursor.GetScore(); Fq += Cursor.GetFq(); }
+                AddTop(Score, RecId, Fq);
+                CursorV[0].Next();
+            }
+        }
+    } else {
+        // block-max WAND: cursors are ordered by their current record and pivot is the first
+        // record where sum of score bounds of preceding words exceeds the threshold
+        TIntV CursorNV; for (int CursorN = 0; CursorN < CursorV.Len(); CursorN++) { CursorNV.Add(CursorN); }
+        while (true) {
+            // drop finished cursors and order the rest by current record
+            int LiveCursors = 0;
+            for (int CursorNN = 0; CursorNN < CursorNV.Len(); CursorNN++) {
+                if (!CursorV[CursorNV[CursorNN]].IsEnd()) { CursorNV[LiveCursors++] = CursorNV[CursorNN]; }
+            }
+            if (LiveCursors == 0) { break; }
+            CursorNV.Trunc(LiveCursors);
+            for (int CursorNN = 1; CursorNN < CursorNV.Len(); CursorNN++) {
+                const int CursorN = CursorNV[CursorNN]; int InsNN = CursorNN;
+                while (InsNN > 0 && CursorV[CursorNV[InsNN - 1]].GetRecId() > CursorV[CursorN].GetRecId()) {
+                    CursorNV[InsNN] = CursorNV[InsNN - 1]; InsNN--;
+                }
+                CursorNV[InsNN] = CursorN;
+            }
+            // find pivot
+            const double Theta = GetTheta();
+            double MxScore = 0.0; int PivotNN = -1;
+            for (int CursorNN = 0; CursorNN < CursorNV.Len(); CursorNN++) {
+                MxScore += CursorV[CursorNV[CursorNN]].GetMxScore();
+                if (MxScore > Theta) { PivotNN = CursorNN; break; }
+            }
+            if (PivotNN == -1) { break; }
+            const uint64 PivotRecId = CursorV[CursorNV[PivotNN]].GetRecId();
+            while (PivotNN + 1 < CursorNV.Len() && CursorV[CursorNV[PivotNN + 1]].GetRecId() == PivotRecId) { PivotNN++; }
+            // check bounds of child vectors that can contain the pivot
+            double ChildMxScore = 0.0; uint64 NextRecId = TUInt64::Mx;
+            for (int CursorNN = 0; CursorNN <= PivotNN; CursorNN++) {
+                const TCursor& Cursor = CursorV[CursorNV[CursorNN]];
+                const int ChildN = Cursor.FindChildN(PivotRecId);
+                ChildMxScore += Cursor.GetChildMxScore(ChildN);
+                NextRecId = TMath::Mn(NextRecId, GetNextRecId(Cursor, ChildN));
+            }
+            if (PivotNN + 1 < CursorNV.Len()) {
+                NextRecId = TMath::Mn(NextRecId, CursorV[CursorNV[PivotNN + 1]].GetRecId());
+            }
+            if (ChildMxScore <= Theta) {
+                // nothing before NextRecId can get into the top records
+                for (int CursorNN = 0; CursorNN <= PivotNN; CursorNN++) { CursorV[CursorNV[CursorNN]].NextGEq(NextRecId); }
+            } else if (CursorV[CursorNV[0]].GetRecId() == PivotRecId) {
+                // all cursors up to pivot are on the pivot record, score it; words are
+                // summed in fixed order, so equal records get bit-equal scores and ties
+                // are broken by record ID no matter how the cursors got there
+                double Score = 0.0; int Fq = 0;
+                for (TCursor& Cursor : CursorV) {
+                    if (Cursor.IsEnd() || Cursor.GetRecId() != PivotRecId) { continue; }
+                    Score += Cursor.GetScore(); Fq += Cursor.GetFq(); Cursor.Next();
+                }
+                AddTop(Score, PivotRecId, Fq);
+            } else {
+                // move preceding cursors to the pivot record
+                for (int CursorNN = 0; CursorNN < PivotNN; CursorNN++) { CursorV[CursorNV[CursorNN]].NextGEq(PivotRecId); }
+            }
+        }
+    }
+
+    // return records ordered by score, same order as used by the heap
+    TVec<TQmGixTopKItem>& TopV = TopHeap();
+    TopV.SortCmp(TopCmp);
+    RecIdFqV.Gen(TopV.Len(), 0);
+    for (const TQmGixTopKItem& Top : TopV) { RecIdFqV.Add(TUInt64IntKd(Top.Val2, Top.Val3)); }
+}
+
+///////////////////////////////
+/// Join query over one gix
+template <class TQmGixItem>
+void TIndex::DoJoinQuery(const TPt<TGix<TQmGixKey, TQmGixItem> >& Gix, TCriticalSection& GixSection,
+        const int& KeyId, const TUInt64V& RecIdV, const int& Threads, TUInt64IntKdV& RecIdFqV) const {
+
+    const int Parts = TInt::GetMn(Threads, RecIdV.Len());
+    if (Parts <= 1) {
+        // temporary store for joined records
+        THash<TUInt64, TInt> RecIdFqH;
+        // lambda that goes over child vectors and updates the hash table with counts
+        auto Handler = [&RecIdFqH](const TVec<TQmGixItem>& ItemV) {
+            for (const TQmGixItem& Item : ItemV) {
+                RecIdFqH.AddDat(GetItemRecId(Item)) += GetItemFq(Item);
+            }
+        };
+        // go over all records we want to join
+        TLock Lock(GixSection);
+        for (uint64 RecId : RecIdV) {
+            Gix->GetItemV(TQmGixKey(KeyId, RecId), Handler);
+        }
+        // convert to sorted vector
+        RecIdFqH.GetKeyDatKdV(RecIdFqV);
+        RecIdFqV.Sort();
+        return;
+    }
+
+    // each part counts joined records for every Parts-th record
+    TVec<TUInt64IntKdV> PartRecIdFqVV(Parts);
+    int ErrorPartN = Parts; PExcept ErrorExcept;
+    #pragma omp parallel for schedule(static, 1) num_threads(Parts)
+    for (int PartN = 0; PartN < Parts; PartN++) {
+        try {
+            THash<TUInt64, TInt> RecIdFqH; TVec<TQmGixItem> PartItemV;
+            auto Handler = [&PartItemV](const TVec<TQmGixItem>& ItemV) { PartItemV.AddV(ItemV); };
+            for (int RecN = PartN; RecN < RecIdV.Len(); RecN += Parts) {
+                // only copy the child vectors while holding the lock
+                PartItemV.Clr(false);
+                { TLock Lock(GixSection); Gix->GetItemV(TQmGixKey(KeyId, RecIdV[RecN]), Handler); }
+                for (const TQmGixItem& Item : PartItemV) {
+                    RecIdFqH.AddDat(GetItemRecId(Item)) += GetItemFq(Item);
+                }
+            }
+            RecIdFqH.GetKeyDatKdV(PartRecIdFqVV[PartN]);
+            PartRecIdFqVV[PartN].Sort();
+        } catch (const PExcept& Except) {
+            #pragma omp critical
+            {
+                if (PartN < ErrorPartN) { ErrorPartN = PartN; ErrorExcept = Except; }
+            }
+        }
+    }
+    if (!ErrorExcept.Empty()) { throw ErrorExcept; }
+    // sum counts from all parts
+    RecIdFqV.Clr();
+    for (const TUInt64IntKdV& PartRecIdFqV : PartRecIdFqVV) {
+        SumMergerFull->Union(RecIdFqV, PartRecIdFqV);
+    }
+}
@@ -115,6 +115,15 @@ void TFtrExt::AddFullV(const TRec& Rec, TFltV& FullV, int& Offset) const {
     }
 }
 
+bool TFtrExt::UpdateRecSet(const PRecSet& RecSet, const int& Threads) {
+    bool UpdateDimP = false;
+    for (int RecN = 0; RecN < RecSet->GetRecs(); RecN++) {
+        const bool RecUpdateDimP = Update(RecSet->GetRec(RecN));
+        UpdateDimP = UpdateDimP || RecUpdateDimP;
+    }
+    return UpdateDimP;
+}
+
 void TFtrExt::ExtractStrV(const TRec& FtrRec, TStrV& StrV) const { 
     throw TQmExcept::New("ExtractStrV not implemented!"); 
 }
@@ -152,6 +161,46 @@ void TFtrSpace::Init() {
         DimV.Add(FtrExtDim); Dim += FtrExtDim;
     }   
 }
+
+int TFtrSpace::GetExtractThreads(const PRecSet& RecSet, const int& FtrExtN) const {
+    // small sets are not worth starting the threads
+    const int MnThreadRecs = 1024;
+    const int Recs = RecSet->GetRecs();
+    if (Recs < 2 * MnThreadRecs || !RecSet->GetStore()->IsConcurrentRead()) { return 1; }
+    for (int ExtN = 0; ExtN < FtrExtV.Len(); ExtN++) {
+        if (FtrExtN >= 0 && ExtN != FtrExtN) { continue; }
+        const PFtrExt& FtrExt = FtrExtV[ExtN];
+        if (!FtrExt->IsConcurrent() || !FtrExt->GetFtrStore()->IsConcurrentRead()) { return 1; }
+    }
+    return TInt::GetMx(TInt::GetMn(Base->GetQueryThreads(), Recs / MnThreadRecs), 1);
+}
+
+template <class TRecFun>
+void TFtrSpace::ExtractRecs(const PRecSet& RecSet, const int& Threads, const TRecFun& RecFun) const {
+    const int Recs = RecSet->GetRecs();
+    if (Threads <= 1) {
+        for (int RecN = 0; RecN < Recs; RecN++) {
+            if (RecN % 10000 == 0) { TEnv::Logger->OnStatusFmt("%d\r", RecN); }
+            RecFun(RecN);
+        }
+        return;
+    }
+    // each record writes only to its own place in the output
+    int ErrorRecN = Recs; PExcept ErrorExcept;
+    #pragma omp parallel for schedule(dynamic, 256) num_threads(Threads)
+    for (int RecN = 0; RecN < Recs; RecN++) {
+        try {
+            RecFun(RecN);
+        } catch (const PExcept& Except) {
+            #pragma omp critical
+            {
+                // remember the first failed record
+                if (RecN < ErrorRecN) { ErrorRecN = RecN; ErrorExcept = Except; }
+            }
+        }
+    }
+    if (!ErrorExcept.Empty()) { throw ErrorExcept; }
+}
     
 TFtrSpace::TFtrSpace(const TWPt<TBase>& _Base, const PFtrExt& FtrExt): 
     Base(_Base), FtrExtV(TFtrExtV::GetV(FtrExt)) { Init(); }
@@ -255,6 +304,21 @@ bool TFtrSpace::Update(const TRec& Rec) {
 
 bool TFtrSpace::Update(const PRecSet& RecSet) {
     TEnv::Logger->OnStatusFmt("Updating feature space with %d records", RecSet->GetRecs());
+    const int Threads = GetExtractThreads(RecSet, -1);
+    if (Threads > 1) {
+        // extractors do not share state, so each can go over all records on its own
+        bool UpdateDimP = false;
+        for (int FtrExtN = 0; FtrExtN < FtrExtV.Len(); FtrExtN++) {
+            const PFtrExt& FtrExt = FtrExtV[FtrExtN];
+            if (FtrExt->UpdateRecSet(RecSet, Threads)) {
+                const int NewDim = FtrExt->GetDim();
+                Dim = Dim - DimV[FtrExtN] + NewDim;
+                DimV[FtrExtN] = NewDim;
+                UpdateDimP = true;
+            }
+        }
+        return UpdateDimP;
+    }
     bool UpdateDimP = false;
     for (int RecN = 0; RecN < RecSet->GetRecs(); RecN++) {
         if (RecN % 10000 == 0) { TEnv::Logger->OnStatusFmt("%d\r", RecN); }
@@ -296,39 +360,63 @@ void TFtrSpace::GetFullV(const TRec& Rec, TFltV& FullV, const int& FtrExtN) cons
 
 void TFtrSpace::GetSpVV(const PRecSet& RecSet, TVec<TIntFltKdV>& SpVV, const int& FtrExtN) const {
     TEnv::Logger->OnStatusFmt("Creating sparse feature vectors from %d records", RecSet->GetRecs());
-    for (int RecN = 0; RecN < RecSet->GetRecs(); RecN++) {
-        if (RecN % 10000 == 0) { TEnv::Logger->OnStatusFmt("%d\r", RecN); }
-        SpVV.Add(TIntFltKdV()); GetSpV(RecSet->GetRec(RecN), SpVV.Last(), FtrExtN);
-    }
+    // make room for all records upfront, so they can be extracted in any order
+    const int FirstRecN = SpVV.Len(), Recs = RecSet->GetRecs();
+    SpVV.Reserve(FirstRecN + Recs, FirstRecN + Recs);
+    ExtractRecs(RecSet, GetExtractThreads(RecSet, FtrExtN), [&](const int& RecN) {
+        GetSpV(RecSet->GetRec(RecN), SpVV[FirstRecN + RecN], FtrExtN); });
+}
+
+void TFtrSpace::GetSpVV(const PRecSet& RecSet, TSparseColMatrix& SpMat, const int& FtrExtN) const {
+    // columns are extracted directly into the matrix
+    SpMat.ColSpVV.Clr(); GetSpVV(RecSet, SpMat.ColSpVV, FtrExtN);
+    SpMat.RowN = (FtrExtN < 0) ? GetDim() : GetFtrExtDim(FtrExtN);
+    SpMat.ColN = RecSet->GetRecs();
 }
 
 void TFtrSpace::GetFullVV(const PRecSet& RecSet, TVec<TFltV>& FullVV, const int& FtrExtN) const {
     TEnv::Logger->OnStatusFmt("Creating full feature vectors from %d records", RecSet->GetRecs());
-    for (int RecN = 0; RecN < RecSet->GetRecs(); RecN++) {
-        if (RecN % 10000 == 0) { TEnv::Logger->OnStatusFmt("%d\r", RecN); }
-        FullVV.Add(TFltV()); GetFullV(RecSet->GetRec(RecN), FullVV.Last(), FtrExtN);
-    }
+    // make room for all records upfront, so they can be extracted in any order
+    const int FirstRecN = FullVV.Len(), Recs = RecSet->GetRecs();
+    FullVV.Reserve(FirstRecN + Recs, FirstRecN + Recs);
+    ExtractRecs(RecSet, GetExtractThreads(RecSet, FtrExtN), [&](const int& RecN) {
+        GetFullV(RecSet->GetRec(RecN), FullVV[FirstRecN + RecN], FtrExtN); });
 }
 
 void TFtrSpace::GetFullVV(const PRecSet& RecSet, TFltVV& FullVV, const int& FtrExtN) const {
     TEnv::Logger->OnStatusFmt("Creating full feature vectors from %d records", RecSet->GetRecs());
     if (FtrExtN < 0) {
         FullVV.Gen(GetDim(), RecSet->GetRecs());
-        TFltV Temp(GetDim());
-        for (int RecN = 0; RecN < RecSet->GetRecs(); RecN++) {
-            if (RecN % 10000 == 0) { TEnv::Logger->OnStatusFmt("%d\r", RecN); }
-            GetFullV(RecSet->GetRec(RecN), Temp);
-            FullVV.SetCol(RecN, Temp);
+        // first let feature extractors which can do so fill in their rows in one pass
+        TBoolV BatchP(FtrExtV.Len()); bool AllBatchP = true;
+        int BatchOffset = 0;
+        for (int FtrExtN = 0; FtrExtN < FtrExtV.Len(); FtrExtN++) {
+            BatchP[FtrExtN] = FtrExtV[FtrExtN]->AddFullVV(RecSet, FullVV, BatchOffset);
+            AllBatchP = AllBatchP && BatchP[FtrExtN];
+            BatchOffset += DimV[FtrExtN];
         }
+        if (AllBatchP) { return; }
+        // remaining feature extractors go record by record, each record fills its own column
+        ExtractRecs(RecSet, GetExtractThreads(RecSet, -1), [&](const int& RecN) {
+            const TRec Rec = RecSet->GetRec(RecN);
+            TFltV Temp(GetDim()); int Offset = 0;
+            for (int FtrExtN = 0; FtrExtN < FtrExtV.Len(); FtrExtN++) {
+                if (BatchP[FtrExtN]) { Offset += DimV[FtrExtN]; continue; }
+                const int FtrExtOffset = Offset;
+                FtrExtV[FtrExtN]->AddFullV(Rec, Temp, Offset);
+                for (int FtrN = FtrExtOffset; FtrN < FtrExtOffset + DimV[FtrExtN]; FtrN++) {
+                    FullVV(FtrN, RecN) = Temp[FtrN];
+                }
+            }
+        });
     } else {
         EAssert(FtrExtN < FtrExtV.Len());
         FullVV.Gen(FtrExtV[FtrExtN]->GetDim(), RecSet->GetRecs());
-        TFltV Temp(FtrExtV[FtrExtN]->GetDim());
-        for (int RecN = 0; RecN < RecSet->GetRecs(); RecN++) {
-            if (RecN % 10000 == 0) { TEnv::Logger->OnStatusFmt("%d\r", RecN); }
-            GetFullV(RecSet->GetRec(RecN), Temp, FtrExtN);
+        if (FtrExtV[FtrExtN]->AddFullVV(RecSet, FullVV, 0)) { return; }
+        ExtractRecs(RecSet, GetExtractThreads(RecSet, FtrExtN), [&](const int& RecN) {
+            TFltV Temp; GetFullV(RecSet->GetRec(RecN), Temp, FtrExtN);
             FullVV.SetCol(RecN, Temp);
-        }
+        });
     }
 }
     
@@ -676,6 +764,20 @@ void TNumeric::AddFullV(const TRec& Rec, TFltV& FullV, int& Offset) const {
     FtrGen.AddFtr(GetVal(Rec), FullV, Offset);
 }
 
+bool TNumeric::AddFullVV(const PRecSet& RecSet, TFltVV& FullVV, const int& Offset) const {
+    // we can only read the column when records come from the feature store
+    const uint StoreId = RecSet->GetStoreId();
+    if (!IsStartStore(StoreId) || IsJoin(StoreId)) { return false; }
+    const TFieldColumn* Column = GetFtrStore()->GetFieldColumn(FieldId);
+    if (Column == NULL || Column->GetFieldType() == oftTm) { return false; }
+    // gather values and transform them to features
+    TFltV ValV; Column->GetNumV(RecSet->GetRecIdFqV(), ValV);
+    for (int RecN = 0; RecN < ValV.Len(); RecN++) {
+        FullVV(Offset, RecN) = FtrGen.GetFtr(ValV[RecN]);
+    }
+    return true;
+}
+
 void TNumeric::ExtractFltV(const TRec& Rec, TFltV& FltV) const {
     FltV.Add(FtrGen.GetFtr(GetVal(Rec)));   
 }
@@ -1376,26 +1478,65 @@ bool TBagOfWords::Update(const TRec& Rec) {
         // update the tick
         TmWnd.Tick(TimeMSecs);
     }
+    return UpdateFtrGen(Rec, FtrGen);
+}
+
+bool TBagOfWords::UpdateFtrGen(const TRec& Rec, TFtrGen::TBagOfWords& RecFtrGen) const {
     // get all instances
     TStrV RecStrV; GetVal(Rec, RecStrV);
     if (Mode == bowmConcat) {
         // merge into one document
-        return FtrGen.Update(TStr::GetStr(RecStrV, "\n"));
+        return RecFtrGen.Update(TStr::GetStr(RecStrV, "\n"));
     } else if (Mode == bowmCentroid) {
         bool UpdateP = false;
         // threat each as a separate document
         for (int RecStrN = 0; RecStrN < RecStrV.Len(); RecStrN++) { 
-            const bool RecUpdateP = FtrGen.Update(RecStrV[RecStrN]); 
+            const bool RecUpdateP = RecFtrGen.Update(RecStrV[RecStrN]); 
             UpdateP = UpdateP || RecUpdateP;
         }
         return UpdateP;
     } else if (Mode == bowmTokenized) {
-        return FtrGen.Update(RecStrV);
+        return RecFtrGen.Update(RecStrV);
     } else {
         throw TQmExcept::New("Unknown tokenizer mode for handling multiple instances");
     }
 }
 
+bool TBagOfWords::UpdateRecSet(const PRecSet& RecSet, const int& Threads) {
+    // forgetting depends on the order of records
+    const int Parts = TInt::GetMn(Threads, RecSet->GetRecs());
+    if (Parts <= 1 || TmWnd.IsInit() || !IsConcurrent()) { return TFtrExt::UpdateRecSet(RecSet, Threads); }
+    // each thread tokenizes consecutive part of records and collects its own statistics
+    TVec<TFtrGen::TBagOfWords> PartFtrGenV(Parts);
+    for (int PartN = 0; PartN < Parts; PartN++) { PartFtrGenV[PartN] = FtrGen.GetEmpty(); }
+    const int Recs = RecSet->GetRecs();
+    int ErrorPartN = Parts; PExcept ErrorExcept;
+    #pragma omp parallel for schedule(static, 1) num_threads(Parts)
+    for (int PartN = 0; PartN < Parts; PartN++) {
+        try {
+            const int StartRecN = (int)((int64)Recs * PartN / Parts);
+            const int EndRecN = (int)((int64)Recs * (PartN + 1) / Parts);
+            for (int RecN = StartRecN; RecN < EndRecN; RecN++) {
+                UpdateFtrGen(RecSet->GetRec(RecN), PartFtrGenV[PartN]);
+            }
+        } catch (const PExcept& Except) {
+            #pragma omp critical
+            {
+                // remember the first failed part
+                if (PartN < ErrorPartN) { ErrorPartN = PartN; ErrorExcept = Except; }
+            }
+        }
+    }
+    if (!ErrorExcept.Empty()) { throw ErrorExcept; }
+    // merging parts in order gives the same vocabulary as updating record by record
+    bool UpdateP = false;
+    for (int PartN = 0; PartN < Parts; PartN++) {
+        const bool PartUpdateP = FtrGen.Merge(PartFtrGenV[PartN]);
+        UpdateP = UpdateP || PartUpdateP;
+    }
+    return UpdateP;
+}
+
 void TBagOfWords::AddSpV(const TRec& Rec, TIntFltKdV& SpV, int& Offset) const {
     // get all instances
     TStrV RecStrV; GetVal(Rec, RecStrV);
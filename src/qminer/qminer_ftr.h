@@ -93,6 +93,17 @@ public:
     virtual void AddSpV(const TRec& Rec, TIntFltKdV& SpV, int& Offset) const = 0;
     /// Attaches features to a given full feature vectors with a given offset
     virtual void AddFullV(const TRec& Rec, TFltV& FullV, int& Offset) const;
+    /// Writes features for all records from the record set to rows starting with Offset
+    /// in the given matrix (one column per record). Returns false when extractor does not
+    /// support batch extraction for the record set, in which case caller uses AddFullV.
+    virtual bool AddFullVV(const PRecSet& RecSet, TFltVV& FullVV, const int& Offset) const { return false; }
+    /// Update the feature extractor using all records from the record set. Extractors
+    /// which support it can use up to Threads threads. Returns true if the update
+    /// changes the dimensionality.
+    virtual bool UpdateRecSet(const PRecSet& RecSet, const int& Threads);
+    /// True when features can be extracted from several threads at the same time
+    /// and when update does not depend on the thread it is called from
+    virtual bool IsConcurrent() const { return false; }
 
     // deprecated, to be removed
     virtual double __GetVal(const double& InVal) const { printf("__GetVal is DEPRECATED\n"); throw TQmExcept::New("TFtrExt::GetVal not implemented"); };
@@ -145,6 +156,14 @@ private:
     TFtrExtV FtrExtV;
     
     void Init();
+    /// Number of threads used to extract features from all records of the record set.
+    /// Larger sets from stores allowing concurrent reads use query threads of the base,
+    /// when all used feature extractors allow concurrent extraction.
+    int GetExtractThreads(const PRecSet& RecSet, const int& FtrExtN) const;
+    /// Calls RecFun for each record position from the record set, using up to Threads
+    /// threads. When a call fails, error of the first failed record is rethrown at the end.
+    template <class TRecFun>
+    void ExtractRecs(const PRecSet& RecSet, const int& Threads, const TRecFun& RecFun) const;
 
     TFtrSpace(const TWPt<TBase>& _Base, const PFtrExt& FtrExt);
     TFtrSpace(const TWPt<TBase>& _Base, const TFtrExtV& _FtrExtV);
@@ -179,6 +198,8 @@ public:
     void GetFullV(const TRec& Rec, TFltV& FullV, const int& FtrExtN = -1) const;
     /// Extracting sparse feature vectors from a record set
     void GetSpVV(const PRecSet& RecSet, TVec<TIntFltKdV>& SpVV, const int& FtrExtN = -1) const;
+    /// Extracting sparse feature vectors (columns) from a record set
+    void GetSpVV(const PRecSet& RecSet, TSparseColMatrix& SpMat, const int& FtrExtN = -1) const;
     /// Extracting full feature vectors from a record set
     void GetFullVV(const PRecSet& RecSet, TVec<TFltV>& FullVV, const int& FtrExtN = -1) const;
     /// Extracting full feature vectors (columns) from a record set
@@ -253,6 +274,7 @@ public:
     bool Update(const TRec& Rec) { return false; }
     void AddSpV(const TRec& Rec, TIntFltKdV& SpV, int& Offset) const;
     void AddFullV(const TRec& Rec, TFltV& FullV, int& Offset) const;
+    bool IsConcurrent() const { return true; }
 
     // flat feature extraction
     void ExtractFltV(const TRec& FtrRec, TFltV& FltV) const;
@@ -339,6 +361,9 @@ public:
     bool Update(const TRec& Rec);
     void AddSpV(const TRec& Rec, TIntFltKdV& SpV, int& Offset) const;
     void AddFullV(const TRec& Rec, TFltV& FullV, int& Offset) const;
+    bool IsConcurrent() const { return true; }
+    /// Reads values directly from the field column when field is kept in columnar layout
+    bool AddFullVV(const PRecSet& RecSet, TFltVV& FullVV, const int& Offset) const;
 
     PJsonVal InvertFullV(const TFltV& FtrV, const int& Offset) const;
     PJsonVal InvertFtr(const PJsonVal& FtrVal) const;
@@ -396,6 +421,7 @@ public:
     bool Update(const TRec& Rec);
     void AddSpV(const TRec& Rec, TIntFltKdV& SpV, int& Offset) const;
     void AddFullV(const TRec& Rec, TFltV& FullV, int& Offset) const;
+    bool IsConcurrent() const { return true; }
 
     // feature extractor type name 
     static TStr GetType() { return "num_sp_v"; }   
@@ -444,6 +470,7 @@ public:
     bool Update(const TRec& Rec);
     void AddSpV(const TRec& Rec, TIntFltKdV& SpV, int& Offset) const;
     void AddFullV(const TRec& Rec, TFltV& FullV, int& Offset) const;
+    bool IsConcurrent() const { return true; }
 
     PJsonVal InvertFullV(const TFltV& FtrV, const int& Offset) const;
     PJsonVal InvertFtr(const PJsonVal& FtrVal) const;
@@ -517,6 +544,7 @@ public:
     bool Update(const TRec& Rec);
     void AddSpV(const TRec& Rec, TIntFltKdV& SpV, int& Offset) const;
     void AddFullV(const TRec& Rec, TFltV& FullV, int& Offset) const;
+    bool IsConcurrent() const { return true; }
 
     // flat feature extraction
     void ExtractStrV(const TRec& Rec, TStrV& StrV) const;
@@ -554,6 +582,8 @@ private:
     TFlt ForgetFactor;            
 
     void GetVal(const TRec& Rec, TStrV& StrV) const;
+    /// Update given feature generator with the record's instances
+    bool UpdateFtrGen(const TRec& Rec, TFtrGen::TBagOfWords& RecFtrGen) const;
 
     /// Add field to the list of ID providers
     void AddField(const int& FieldId);
@@ -601,6 +631,8 @@ public:
     bool Update(const TRec& Rec);
     void AddSpV(const TRec& Rec, TIntFltKdV& SpV, int& Offset) const;
     void AddFullV(const TRec& Rec, TFltV& FullV, int& Offset) const;
+    bool UpdateRecSet(const PRecSet& RecSet, const int& Threads);
+    bool IsConcurrent() const { return FtrGen.IsConcurrent(); }
 
     // flat feature extraction
     void ExtractStrV(const TRec& Rec, TStrV& StrV) const;
@@ -645,6 +677,7 @@ public:
     // sparse vector extraction
     void AddSpV(const TRec& Rec, TIntFltKdV& SpV, int& Offset) const;
     //void AddFullV(const TRec& Rec, TFltV& FullV, int& Offset) const;
+    bool IsConcurrent() const { return true; }
 
     // flat feature extraction
     void ExtractStrV(const TRec& Rec, TStrV& StrV) const;
@@ -695,6 +728,7 @@ public:
     bool Update(const TRec& FtrRec);
     void AddSpV(const TRec& FtrRec, TIntFltKdV& SpV, int& Offset) const;
     //void AddFullV(const TRec& Rec, TFltV& FullV, int& Offset) const;
+    bool IsConcurrent() const { return FtrExt1->IsConcurrent() && FtrExt2->IsConcurrent(); }
 
     // flat feature extraction
     void ExtractStrV(const TRec& FtrRec, TStrV& StrV) const;
@@ -750,6 +784,7 @@ public:
     bool Update(const TRec& Rec);
     void AddSpV(const TRec& Rec, TIntFltKdV& SpV, int& Offset) const;
     void AddFullV(const TRec& Rec, TFltV& FullV, int& Offset) const;
+    bool IsConcurrent() const { return true; }
 
     // feature extractor type name 
     static TStr GetType() { return "dateWindow"; }
@@ -96,6 +96,8 @@ TFieldDescEx TStoreSchema::ParseFieldDescEx(const PJsonVal& FieldVal) {
             FieldDescEx.FieldStoreLoc = slMemory;
         } else if (StoreLocStr == "cache") {
             FieldDescEx.FieldStoreLoc = slDisk;
+        } else if (StoreLocStr == "column") {
+            FieldDescEx.FieldStoreLoc = slColumn;
         } else {
             throw TQmExcept::New(TStr::Fmt("Unsupported 'store' flag for field: %s", StoreLocStr.CStr()));
         }
@@ -145,6 +147,10 @@ TJoinDescEx TStoreSchema::ParseJoinDescEx(const PJsonVal& JoinVal) {
         JoinDescEx.GixType = oikgtTiny;
         JoinDescEx.RecIdFieldType = oftUInt;
         JoinDescEx.FreqFieldType = oftUndef;
+    } else if (StorageStr == "packed") {
+        JoinDescEx.GixType = oikgtPacked;
+        JoinDescEx.RecIdFieldType = oftUInt64;
+        JoinDescEx.FreqFieldType = oftInt;
     } else {
         // only field joins support more complex type combinations
         QmAssertR(JoinDescEx.JoinType == osjtField, "Invalid storage definition '" + StorageStr + "' for index join");
@@ -182,7 +188,8 @@ TJoinDescEx TStoreSchema::ParseJoinDescEx(const PJsonVal& JoinVal) {
                 throw TQmExcept::New(TStr::Fmt("Unsupported 'storage_location' flag for join: %s", StoreLocStr.CStr()));
             }
         } else {
-            JoinDescEx.FieldStoreLoc = DefaultFieldStoreLoc;
+            // join fields are indexed by the store, so they cannot go to columns
+            JoinDescEx.FieldStoreLoc = (DefaultFieldStoreLoc == slColumn) ? slMemory : DefaultFieldStoreLoc;
         }
     }
     // done
@@ -226,6 +233,13 @@ TIndexKeyEx TStoreSchema::ParseIndexKeyEx(const PJsonVal& IndexKeyVal) {
         IndexKeyEx.GixType = oikgtSmall;
     } else if (StorageStr == "tiny") {
         IndexKeyEx.GixType = oikgtTiny;
+    } else if (StorageStr == "packed") {
+        IndexKeyEx.GixType = oikgtPacked;
+    } else if (StorageStr == "paged") {
+        // b-tree nodes kept on disk, location keys index cells in such b-tree
+        QmAssertR(IndexKeyEx.IsLinear() || IndexKeyEx.IsLocation(),
+            "Paged storage only supported by linear and location keys, not for field '" + IndexKeyEx.FieldName + "'");
+        IndexKeyEx.GixType = oikgtPaged;
     } else {
         throw TQmExcept::New("Unkown gix storage type '" + StorageStr + "' for field '" + IndexKeyEx.FieldName + "'");
     }
@@ -316,6 +330,8 @@ TStoreSchema::TStoreSchema(const TWPt<TBase>& Base, const PJsonVal& StoreVal) :
     QmAssertR(StoreVal->IsObjKey("name"), "Missing store name.");
     StoreName = StoreVal->GetObjStr("name");
     BlockSizeMem = 1000;
+    WriteLogCommitMSecs = 1000;
+    WriteLogCheckpointMB = 64;
     // get additional options
     if (StoreVal->IsObjKey("options")) {
         PJsonVal options = StoreVal->GetObjKey("options");
@@ -328,12 +344,20 @@ TStoreSchema::TStoreSchema(const TWPt<TBase>& Base, const PJsonVal& StoreVal) :
                 DefaultFieldStoreLoc = slMemory;
             } else if (StoreLocStr == "cache") {
                 DefaultFieldStoreLoc = slDisk;
+            } else if (StoreLocStr == "column") {
+                DefaultFieldStoreLoc = slColumn;
             } else {
                 throw TQmExcept::New(TStr::Fmt("Unsupported 'storage_location' flag for store %s: %s", StoreName.CStr(), StoreLocStr.CStr()));
             }
         }
         // parse block size
         BlockSizeMem = MAX(1, options->GetObjInt("block_size_mem", BlockSizeMem));
+        // memory-mapped disk storage for paged stores
+        PagedMMapP = options->GetObjBool("mmap", false);
+        // write-ahead log for in-memory storage
+        WriteLogP = options->GetObjBool("write_log", false);
+        WriteLogCommitMSecs = MAX(0, options->GetObjInt("write_log_commit", WriteLogCommitMSecs));
+        WriteLogCheckpointMB = MAX(0, options->GetObjInt("write_log_checkpoint", WriteLogCheckpointMB));
     }
     // get id (optional)
     if (StoreVal->IsObjKey("id")) {
@@ -356,6 +380,14 @@ TStoreSchema::TStoreSchema(const TWPt<TBase>& Base, const PJsonVal& StoreVal) :
         FieldH.AddDat(FieldDesc.GetFieldNm(), FieldDesc);
         // prase extended field description required for serialization
         TFieldDescEx FieldDescEx = ParseFieldDescEx(FieldDef);
+        // only fixed-width non-primary fields can be stored in columns; when column
+        // is only the store default, other fields fall back to in-memory storage
+        if (FieldDescEx.FieldStoreLoc == slColumn && (FieldDesc.IsPrimary() ||
+                !TFieldColumn::IsFieldType(FieldDesc.GetFieldType()))) {
+            QmAssertR(!FieldDef->IsObjKey("store"), "Field " + FieldDesc.GetFieldNm() +
+                " in store " + StoreName + " cannot be stored in a column");
+            FieldDescEx.FieldStoreLoc = slMemory;
+        }
         FieldExH.AddDat(FieldDesc.GetFieldNm(), FieldDescEx);
     }
 
@@ -367,6 +399,11 @@ TStoreSchema::TStoreSchema(const TWPt<TBase>& Base, const PJsonVal& StoreVal) :
             PJsonVal KeyDef = KeyDefs->GetArrVal(KeyN);
             TIndexKeyEx IndexKeyDesc = ParseIndexKeyEx(KeyDef);
             IndexKeyExV.Add(IndexKeyDesc);
+            // indexer reads values from record serialization, so indexed fields stay in memory
+            if (FieldExH.IsKey(IndexKeyDesc.FieldName)) {
+                TFieldDescEx& FieldDescEx = FieldExH.GetDat(IndexKeyDesc.FieldName);
+                if (FieldDescEx.FieldStoreLoc == slColumn) { FieldDescEx.FieldStoreLoc = slMemory; }
+            }
         }
     }
 
@@ -422,6 +459,17 @@ TStoreSchema::TStoreSchema(const TWPt<TBase>& Base, const PJsonVal& StoreVal) :
         // set time duration in milliseconds
         const uint64 FactorMSecs = Maps.TimeWindowUnitMap.GetDat(UnitStr);
         WndDesc.WindowSize = WindowSize * FactorMSecs;
+        // get optional partitioning of records into time segments
+        if (TimeWindow->IsObjKey("segment")) {
+            PJsonVal Segment = TimeWindow->GetObjKey("segment");
+            QmAssertR(Segment->IsObj(), "Bad timeWindow segment parameter.");
+            QmAssertR(Segment->IsObjKey("duration"), "Missing segment duration parameter.");
+            TStr SegmentUnitStr = Segment->GetObjStr("unit", UnitStr);
+            QmAssertR(Maps.TimeWindowUnitMap.IsKey(SegmentUnitStr),
+                "Unsupported timeWindow segment length unit type: " + SegmentUnitStr);
+            SegmentMSecs = Segment->GetObjUInt64("duration") * Maps.TimeWindowUnitMap.GetDat(SegmentUnitStr);
+            QmAssertR(SegmentMSecs > 0, "Segment duration must be positive.");
+        }
         // get field giving the tact for time
         if (TimeWindow->IsObjKey("field")) {
             WndDesc.TimeFieldNm = TimeWindow->GetObjStr("field");
@@ -441,6 +489,23 @@ TStoreSchema::TStoreSchema(const TWPt<TBase>& Base, const PJsonVal& StoreVal) :
             WndDesc.InsertP = true;
         }
     }
+
+    // log restores only in-memory records and primary field map, while indexes,
+    // codebooks, columns and cached fields are saved only when closing
+    if (WriteLogP) {
+        QmAssertR(IndexKeyExV.Empty(), "Store " + StoreName + " with write_log cannot have keys");
+        for (int JoinN = 0; JoinN < JoinDescExV.Len(); JoinN++) {
+            QmAssertR(JoinDescExV[JoinN].JoinType == osjtField, "Store " + StoreName +
+                " with write_log cannot have index join " + JoinDescExV[JoinN].JoinName);
+        }
+        int FieldKeyId = FieldExH.FFirstKeyId();
+        while (FieldExH.FNextKeyId(FieldKeyId)) {
+            const TFieldDescEx& FieldDescEx = FieldExH[FieldKeyId];
+            QmAssertR(FieldDescEx.FieldStoreLoc == slMemory && !FieldDescEx.CodebookP,
+                "Field " + FieldExH.GetKey(FieldKeyId) + " in store " + StoreName +
+                " with write_log must be stored in memory without codebook");
+        }
+    }
 }
 
 void TStoreSchema::ParseSchema(const TWPt<TBase>& Base, const PJsonVal& SchemaVal, TStoreSchemaV& SchemaV) {
@@ -544,11 +609,20 @@ void TStoreSchema::ValidateSchema(const TWPt<TBase>& Base, TStoreSchemaV& Schema
 
 ///////////////////////////////
 // In-memory storage
-TInMemStorage::TInMemStorage(const TStr& _FNm, const PBlobBs& _BlobStorage, const int& _BlockSize):
-    FNm(_FNm), Access(faCreate), BlobStorage(_BlobStorage), BlockSize(_BlockSize) { }
+TInMemStorage::TInMemStorage(const TStr& _FNm, const PBlobBs& _BlobStorage, const int& _BlockSize,
+        const bool& _LogP, const int& _LogCommitMSecs, const int& LogCheckpointMB):
+    FNm(_FNm), Access(faCreate), BlobStorage(_BlobStorage), BlockSize(_BlockSize),
+    LogP(_LogP), LogCommitMSecs(_LogCommitMSecs), LogCheckpointSize((uint64)LogCheckpointMB * TInt::Mega),
+    LogSegN(0), LogCommitTmMSecs(TTm::GetCurUniMSecs()), LogCommitStopP(false) {
+
+    // segments left from an earlier storage with the same name would be replayed
+    for (int SegN = 0; TFile::Exists(GetLogFNm(SegN)); SegN++) { TFile::Del(GetLogFNm(SegN)); }
+    StartLogCommit();
+}
 
 TInMemStorage::TInMemStorage(const TStr& _FNm, const PBlobBs& _BlobStorage, const TFAccess& _FAccess,
-        const bool& LazyP): FNm(_FNm), Access(_FAccess), BlobStorage(_BlobStorage) {
+        const bool& LazyP): FNm(_FNm), Access(_FAccess), BlobStorage(_BlobStorage),
+        LogSegN(0), LogCommitTmMSecs(TTm::GetCurUniMSecs()), LogCommitStopP(false) {
 
     // load data
     TFIn FIn(FNm);
@@ -559,6 +633,12 @@ TInMemStorage::TInMemStorage(const TStr& _FNm, const PBlobBs& _BlobStorage, cons
     FirstValOffset.Load(FIn);
     FirstValOffsetMem.Load(FIn);
     BlockSize.Load(FIn);
+    // log parameters (not present in files created before write-ahead log)
+    if (!FIn.Eof()) {
+        LogP.Load(FIn);
+        LogCommitMSecs.Load(FIn);
+        LogCheckpointSize.Load(FIn);
+    }
 
     for (int64 i = 0; i < cnt; i++) {
         ValV.Add(); // empty (non-loaded) data
@@ -567,22 +647,23 @@ TInMemStorage::TInMemStorage(const TStr& _FNm, const PBlobBs& _BlobStorage, cons
     if (!LazyP) {
         LoadAll();
     }
+    if (LogP) {
+        ReplayLog();
+        StartLogCommit();
+    }
 }
 
 TInMemStorage::~TInMemStorage() {
+    StopLogCommit();
     if (Access != faRdOnly) {
-        // store dirty vectors
-        for (int i = 0; i < ValV.Len(); i++) {
-            SaveRec(i);
+        if (LogP) {
+            // changes since last flush are in the log, only make it durable
+            CommitLog(true);
+        } else {
+            // store dirty blocks
+            SaveDirtyBlocks();
         }
-        // save vector
-        TFOut FOut(FNm);
-        BlobPtV.Save(FOut);
-        // save rest
-        TInt64(ValV.Len()).Save(FOut);
-        FirstValOffset.Save(FOut);
-        FirstValOffsetMem.Save(FOut);
-        BlockSize.Save(FOut);
+        CommitMain();
     }
 }
 
@@ -590,13 +671,19 @@ TInMemStorage::~TInMemStorage() {
 void TInMemStorage::LoadRec(int64 RecN) const {
     if (DirtyV[RecN] != isdfNotLoaded) { return; }
     const int64 ii = RecN / BlockSize;
+    // block not saved yet, its values are restored from the log
+    if (ii >= BlobPtV.Len() || BlobPtV[ii].Empty()) { return; }
     TMem mem;
     TMem::LoadMem(BlobStorage->GetBlob(BlobPtV[ii]), mem);
     PSIn in = mem.GetSIn();
     for (int64 j = ii*BlockSize; j < DirtyV.Len() && j < (ii + 1)*BlockSize; j++) {
+        // values added after the block was saved are restored from the log
+        if (in->Eof()) { break; }
         if (DirtyV[j] == isdfNotLoaded) {
-            DirtyV[j] = isdfClean;
+            // mark as loaded only after the value is in place, so concurrent
+            // readers checking IsValLoaded never see a half-loaded value
             ValV[j].Load(in);
+            DirtyV[j] = isdfClean;
         } else {
             TMem mem2;
             mem2.Load(in);
@@ -604,39 +691,168 @@ void TInMemStorage::LoadRec(int64 RecN) const {
     }
 }
 
-/// Utility method for storing specific record
-int TInMemStorage::SaveRec(int RecN) {
-    int res = 0;
-    switch (DirtyV[RecN]) {
-    case isdfNew:
-    case isdfDirty:
-        {
-            res++;
-            const int ii = RecN / BlockSize;
-            TMOut mem;
-            for (int j = ii*BlockSize; j < DirtyV.Len() && j < (ii + 1)*BlockSize; j++) {
-                ValV[j].Save(mem);
-                DirtyV[j] = isdfClean;
-            }
-            while (BlobPtV.Len() <= ii) {
-                BlobPtV.Add();
-            }
-            if (BlobPtV[ii].Empty()) {
-                BlobPtV[ii] = BlobStorage->PutBlob(mem.GetSIn());
-            } else {
-                int ReleasedSize;
-                BlobPtV[ii] = BlobStorage->PutBlob(BlobPtV[ii], mem.GetSIn(), ReleasedSize);
+/// Utility method for storing specific block
+int TInMemStorage::SaveBlock(const uint64& BlockN) {
+    // skip blocks deleted in the meantime
+    if (BlockN < FirstValOffsetMem / BlockSize) { return 0; }
+    const int64 ii = (int64)(BlockN - FirstValOffsetMem / BlockSize);
+    const int64 FirstRecN = ii * BlockSize;
+    const int64 LastRecN = MIN(DirtyV.Len(), FirstRecN + BlockSize);
+    // bring in values from the old version of the block that were not loaded yet
+    for (int64 j = FirstRecN; j < LastRecN; j++) {
+        if (DirtyV[j] == isdfNotLoaded) { LoadRec(j); break; }
+    }
+    TMOut mem;
+    for (int64 j = FirstRecN; j < LastRecN; j++) {
+        ValV[j].Save(mem);
+        DirtyV[j] = isdfClean;
+    }
+    while (BlobPtV.Len() <= ii) {
+        BlobPtV.Add();
+    }
+    if (BlobPtV[ii].Empty()) {
+        BlobPtV[ii] = BlobStorage->PutBlob(mem.GetSIn());
+    } else if (LogP) {
+        // main file keeps pointing to the old block until it is saved again
+        FreeBlock(BlobPtV[ii]);
+        BlobPtV[ii] = BlobStorage->PutBlob(mem.GetSIn());
+    } else {
+        int ReleasedSize;
+        BlobPtV[ii] = BlobStorage->PutBlob(BlobPtV[ii], mem.GetSIn(), ReleasedSize);
+    }
+    return 1;
+}
+
+void TInMemStorage::SaveDirtyBlocks() {
+    TUInt64V BlockNV; DirtyBlockSet.GetKeyV(BlockNV); BlockNV.Sort();
+    for (int BlockNN = 0; BlockNN < BlockNV.Len(); BlockNN++) {
+        SaveBlock(BlockNV[BlockNN]);
+    }
+    DirtyBlockSet.Clr();
+}
+
+void TInMemStorage::SaveMain() const {
+    // save vector
+    TFOut FOut(FNm);
+    BlobPtV.Save(FOut);
+    // save rest
+    TInt64(ValV.Len()).Save(FOut);
+    FirstValOffset.Save(FOut);
+    FirstValOffsetMem.Save(FOut);
+    BlockSize.Save(FOut);
+    LogP.Save(FOut);
+    LogCommitMSecs.Save(FOut);
+    LogCheckpointSize.Save(FOut);
+}
+
+void TInMemStorage::CommitMain() {
+    SaveMain();
+    for (int BlobPtN = 0; BlobPtN < FreeBlobPtV.Len(); BlobPtN++) {
+        BlobStorage->DelBlob(FreeBlobPtV[BlobPtN]);
+    }
+    FreeBlobPtV.Clr();
+}
+
+void TInMemStorage::FreeBlock(const TBlobPt& BlobPt) {
+    if (LogP) {
+        FreeBlobPtV.Add(BlobPt);
+    } else {
+        BlobStorage->DelBlob(BlobPt);
+    }
+}
+
+void TInMemStorage::LogEntry(const char& Op, const uint64& ValId, const TMem* Val) {
+    TLock Lock(LogSection);
+    if (LogSOut.Empty()) { LogSOut = TFOut::New(GetLogFNm(LogSegN)); }
+    LogSOut->Save(Op); TUInt64(ValId).Save(*LogSOut);
+    LogSize += sizeof(char) + sizeof(uint64);
+    if (Val != NULL) {
+        Val->Save(*LogSOut);
+        LogSize += 2 * sizeof(int) + Val->Len();
+    }
+    CommitLog(false);
+}
+
+void TInMemStorage::CommitLog(const bool& ForceP) {
+    TLock Lock(LogSection);
+    if (LogSOut.Empty()) { return; }
+    const uint64 TmMSecs = TTm::GetCurUniMSecs();
+    if (ForceP || TmMSecs >= LogCommitTmMSecs + LogCommitMSecs) {
+        LogSOut->Flush();
+        LogCommitTmMSecs = TmMSecs;
+    }
+}
+
+void TInMemStorage::TLogCommitThread::Run() {
+    // wake up often, so closing the storage does not wait for a whole window
+    const int SleepMSecs = TInt::GetMn(Storage->LogCommitMSecs, 100);
+    while (!Storage->LogCommitStopP) {
+        TSysProc::Sleep(SleepMSecs);
+        Storage->CommitLog(false);
+    }
+}
+
+void TInMemStorage::StartLogCommit() {
+    // without a group-commit window every entry is committed right away
+    if (!LogP || Access == faRdOnly || LogCommitMSecs <= 0) { return; }
+    LogCommitStopP = false;
+    LogCommitThread = new TLogCommitThread(this);
+    LogCommitThread->Start();
+}
+
+void TInMemStorage::StopLogCommit() {
+    if (LogCommitThread.Empty()) { return; }
+    LogCommitStopP = true;
+    LogCommitThread->Join();
+    LogCommitThread.Clr();
+}
+
+void TInMemStorage::ReplayLog() {
+    int Entries = 0;
+    while (TFile::Exists(GetLogFNm(LogSegN))) {
+        const TStr LogFNm = GetLogFNm(LogSegN);
+        LogSize += TFile::GetSize(LogFNm);
+        LogSegN++;
+        // empty segments cannot be opened for reading
+        if (TFile::GetSize(LogFNm) == 0) { continue; }
+        TFIn FIn(LogFNm);
+        try {
+            while (!FIn.Eof()) {
+                char Op; FIn.Load(Op);
+                TUInt64 ValId(FIn);
+                if (Op == 'v') {
+                    TMem Val(FIn);
+                    if (ValId < GetFirstValId()) {
+                        // value deleted later
+                    } else if (ValId == FirstValOffsetMem + ValV.Len()) {
+                        AddValNoLog(Val);
+                    } else {
+                        QmAssertR(ValId < FirstValOffsetMem + ValV.Len(), "Invalid value ID in log " + LogFNm);
+                        SetValNoLog(ValId, Val);
+                    }
+                    LogValIdSet.AddKey(ValId);
+                } else if (Op == 'd') {
+                    if (ValId > GetFirstValId()) {
+                        DelValsNoLog((int)(ValId - GetFirstValId()));
+                    }
+                } else {
+                    throw TQmExcept::New("Invalid entry in log " + LogFNm);
+                }
+                Entries++;
             }
+        } catch (PExcept& Except) {
+            // entry was only partially written, following entries are in next segment
+            TEnv::Logger->OnStatusFmt("Stopped reading %s at incomplete entry: %s",
+                LogFNm.CStr(), Except->GetMsgStr().CStr());
         }
-        break;
-    case isdfClean:
-    case isdfNotLoaded: break;
     }
-    return res;
+    if (Entries > 0) {
+        TEnv::Logger->OnStatusFmt("Restored %d entries from log of %s", Entries, FNm.CStr());
+    }
 }
 
 void TInMemStorage::AssertReadOnly() const {
-    QmAssertR(((Access == faCreate) || (Access == faUpdate)), FNm + " opened in Read-Only mode!");
+    QmAssertR(((Access == faCreate) || (Access == faUpdate) || (Access == faRestore)), FNm + " opened in Read-Only mode!");
 }
 
 bool TInMemStorage::IsValId(const uint64& ValId) const {
@@ -645,30 +861,47 @@ bool TInMemStorage::IsValId(const uint64& ValId) const {
         (ValId < FirstValOffsetMem.Val + ValV.Len());
 }
 
+bool TInMemStorage::IsValLoaded(const uint64& ValId) const {
+    return DirtyV[ValId - FirstValOffsetMem] != isdfNotLoaded;
+}
+
 void TInMemStorage::GetVal(const uint64& ValId, TMem& Val) const {
     uint64 i = ValId - FirstValOffsetMem;
     LoadRec(i);
     Val = ValV[i];
 }
 
-uint64 TInMemStorage::AddVal(const TMem& Val) {
+uint64 TInMemStorage::AddValNoLog(const TMem& Val) {
     uint64 res = ValV.Add(Val);
     DirtyV.Add(isdfNew);
-    if (ValV.Len() % BlockSize == 1) {
+    if (BlobPtV.Len() <= (int64)res / BlockSize) {
         BlobPtV.Add();
     }
+    SetBlockDirty(res);
     return res + FirstValOffsetMem;
 }
 
-void TInMemStorage::SetVal(const uint64& ValId, const TMem& Val) {
-    AssertReadOnly();
+uint64 TInMemStorage::AddVal(const TMem& Val) {
+    const uint64 ValId = AddValNoLog(Val);
+    if (LogP) { LogEntry('v', ValId, &Val); }
+    return ValId;
+}
+
+void TInMemStorage::SetValNoLog(const uint64& ValId, const TMem& Val) {
     ValV[ValId - FirstValOffsetMem] = Val;
-    uchar& flag = DirtyV[ValId - FirstValOffsetMem];
+    TInMemDirtyFlag& flag = DirtyV[ValId - FirstValOffsetMem];
     if (flag == isdfNew) { } // new remains new
     else { flag = isdfDirty; } // set as dirty
+    SetBlockDirty(ValId - FirstValOffsetMem);
 }
 
-void TInMemStorage::DelVals(int Vals) {
+void TInMemStorage::SetVal(const uint64& ValId, const TMem& Val) {
+    AssertReadOnly();
+    SetValNoLog(ValId, Val);
+    if (LogP) { LogEntry('v', ValId, &Val); }
+}
+
+void TInMemStorage::DelValsNoLog(int Vals) {
     if (Vals > 0) {
         int ValsTrue = 0;
         for (ValsTrue = 0; ValsTrue < Vals && ValsTrue + (int64)FirstValOffset.Val<ValV.Len(); ValsTrue++) {
@@ -682,8 +915,9 @@ void TInMemStorage::DelVals(int Vals) {
             DirtyV.Del(0, vals_to_delete - 1);
             for (int i = 0; i < blocks_to_delete; i++) {
                 if (!BlobPtV[i].Empty()) {
-                    BlobStorage->DelBlob(BlobPtV[i]);
+                    FreeBlock(BlobPtV[i]);
                 }
+                DirtyBlockSet.DelIfKey(FirstValOffsetMem / BlockSize + i);
             }
             BlobPtV.Del(0, blocks_to_delete - 1);
         }
@@ -692,6 +926,11 @@ void TInMemStorage::DelVals(int Vals) {
     }
 }
 
+void TInMemStorage::DelVals(int Vals) {
+    DelValsNoLog(Vals);
+    if (LogP && Vals > 0) { LogEntry('d', GetFirstValId(), NULL); }
+}
+
 uint64 TInMemStorage::Len() const {
     return ValV.Len() - FirstValOffset;
 }
@@ -707,10 +946,18 @@ uint64 TInMemStorage::GetLastValId() const {
 int TInMemStorage::PartialFlush(int WndInMsec) {
     TTmStopWatch sw(true);
     int res = 0;
-    for (int i = 0; i< ValV.Len(); i++) {
+    TUInt64V BlockNV; DirtyBlockSet.GetKeyV(BlockNV); BlockNV.Sort();
+    for (int BlockNN = 0; BlockNN < BlockNV.Len(); BlockNN++) {
         if (sw.GetMSecInt() > WndInMsec)
             break;
-        res += SaveRec(i);
+        res += SaveBlock(BlockNV[BlockNN]);
+        DirtyBlockSet.DelKey(BlockNV[BlockNN]);
+    }
+    if (LogP) {
+        // commit the log before the main file, which must never be ahead of it
+        CommitLog(true);
+        // saved blocks replace older pointers in the main file
+        if (res > 0 || !FreeBlobPtV.Empty()) { CommitMain(); }
     }
     return res;
 }
@@ -721,6 +968,24 @@ void TInMemStorage::LoadAll() {
     }
 }
 
+bool TInMemStorage::IsCheckpointReady() const {
+    return LogP && Access != faRdOnly && DirtyBlockSet.Empty() &&
+        LogSize > 0 && LogSize >= LogCheckpointSize;
+}
+
+void TInMemStorage::Checkpoint() {
+    QmAssertR(DirtyBlockSet.Empty(), "Checkpoint of " + FNm + " with unsaved blocks");
+    CommitMain();
+    // close current segment and remove all of them
+    TLock Lock(LogSection);
+    LogSOut.Clr();
+    for (int SegN = 0; SegN <= LogSegN; SegN++) {
+        if (TFile::Exists(GetLogFNm(SegN))) { TFile::Del(GetLogFNm(SegN)); }
+    }
+    LogSegN = 0; LogSize = 0;
+    LogValIdSet.Clr();
+}
+
 ///////////////////////////////
 // Field serialization parameters
 void TRecSerializator::TFieldSerialDesc::Save(TSOut& SOut) const {
@@ -1022,6 +1287,7 @@ void TRecSerializator::SetFieldStr(char* Bf, const int& BfL,
     const TFieldSerialDesc& FieldSerialDesc, const TStr& Str) {
 
     char* bf = GetLocationFixed(Bf, BfL, FieldSerialDesc);
+    TLock Lock(CodebookSection);
     const int StrId = CodebookH.AddKey(Str);
     *((int*)bf) = StrId;
     // set the null field to false
@@ -1589,13 +1855,12 @@ void TRecSerializator::Serialize(const PJsonVal& RecVal, TMem& RecMem, const TWP
         const TFieldDesc& FieldDesc = Store->GetFieldDesc(FieldSerialDesc.FieldId);
         TStr FieldName = FieldDesc.GetFieldNm();
         // parse field value from provided JSon
-        PJsonVal FieldVal;
+        PJsonVal RecFieldVal;
         // figure out value when not provided directly
         if (!RecVal->IsObjKey(FieldName)){
             // check if the field is a surrogate for a field join
             if (!FieldSerialDesc.DefaultVal.Empty()) {
-                // use the provided default value
-                FieldVal = FieldSerialDesc.DefaultVal;
+                // use the provided default value, see below
             } else if (FieldDesc.IsNullable()) {
                 // value not provided and object is nullable, so we set it to NULL
                 SetFieldNull(FixedMem, FieldSerialDesc, true);
@@ -1609,11 +1874,12 @@ void TRecSerializator::Serialize(const PJsonVal& RecVal, TMem& RecMem, const TWP
                 // report missing field value since no other option available
                 throw TQmExcept::New("JSon data is missing field - expecting " + FieldName + ", store " + Store->GetStoreNm());
             }
+        } else {
+            RecFieldVal = RecVal->GetObjKey(FieldName);
         }
-        // load field value when default not already loaded
-        if (FieldVal.Empty()) {
-            FieldVal = RecVal->GetObjKey(FieldName);
-        }
+        // default value is referenced and not copied, since it is shared
+        // between records serialized in parallel by AddRecs
+        const PJsonVal& FieldVal = RecFieldVal.Empty() ? FieldSerialDesc.DefaultVal : RecFieldVal;
         // set the field as specified
         if (FieldVal->IsNull()) {
             // we are setting field explicitly to null
@@ -2427,6 +2693,8 @@ TStr TRecIndexer::TFieldIndexKey::GetKeyType() const {
 
 void TRecIndexer::IndexKey(const TFieldIndexKey& Key, const TMemBase& RecMem,
         const uint64& RecId, TRecSerializator& Serializator) {
+    // cached query results over the store are no longer valid
+    Store->IncVersion();
 
     // check the type of field and value to select indexing procedure
     if (Key.FieldType == oftStr && Key.IsValue()){
@@ -2501,6 +2769,8 @@ void TRecIndexer::IndexKey(const TFieldIndexKey& Key, const TMemBase& RecMem,
 
 void TRecIndexer::DeindexKey(const TFieldIndexKey& Key, const TMemBase& RecMem,
         const uint64& RecId, TRecSerializator& Serializator) {
+    // cached query results over the store are no longer valid
+    Store->IncVersion();
 
     // check the type of field and value to select deindexing procedure
     if (Key.FieldType == oftStr && Key.IsValue()) {
@@ -2575,6 +2845,8 @@ void TRecIndexer::DeindexKey(const TFieldIndexKey& Key, const TMemBase& RecMem,
 
 void TRecIndexer::UpdateKey(const TFieldIndexKey& Key, const TMemBase& OldRecMem,
     const TMemBase& NewRecMem, const uint64& RecId, TRecSerializator& Serializator) {
+    // cached query results over the store are no longer valid
+    Store->IncVersion();
 
     // check the type of field and value to select update procedure
     if (Key.FieldType == oftStr && Key.IsValue()) {
@@ -2717,8 +2989,8 @@ void TRecIndexer::ProcessKey(const TFieldIndexKey& Key, const TMemBase& OldRecMe
     }
 }
 
-TRecIndexer::TRecIndexer(const TWPt<TIndex>& _Index, const TWPt<TStore>& Store):
-        Index(_Index), IndexVoc(_Index->GetIndexVoc()) {
+TRecIndexer::TRecIndexer(const TWPt<TIndex>& _Index, const TWPt<TStore>& _Store):
+        Index(_Index), IndexVoc(_Index->GetIndexVoc()), Store(_Store), DeferRecId(TUInt64::Mx) {
 
     // go over all the fields
     for (int FieldId = 0; FieldId < Store->GetFields(); FieldId++) {
@@ -2739,6 +3011,7 @@ TRecIndexer::TRecIndexer(const TWPt<TIndex>& _Index, const TWPt<TStore>& Store):
 }
 
 void TRecIndexer::IndexRec(const TMemBase& RecMem, const uint64& RecId, TRecSerializator& Serializator) {
+    if (IsDeferredRec(RecId)) { return; }
     // go over all keys associated with the store and its fields
     for (int FieldIndexKeyN = 0; FieldIndexKeyN < FieldIndexKeyV.Len(); FieldIndexKeyN++) {
         const TFieldIndexKey& Key = FieldIndexKeyV[FieldIndexKeyN];
@@ -2751,7 +3024,99 @@ void TRecIndexer::IndexRec(const TMemBase& RecMem, const uint64& RecId, TRecSeri
     }
 }
 
+void TRecIndexer::GetKeyWordStrV(const TFieldIndexKey& Key, const TMemBase& RecMem,
+        TRecSerializator& Serializator, TStrV& WordStrV) const {
+
+    if (Key.FieldType == oftStr && Key.IsValue()) {
+        // non-tokenized string is a single word
+        WordStrV.Add(Serializator.GetFieldStr(RecMem, Key.FieldId));
+    } else if (Key.FieldType == oftStr && Key.IsText()) {
+        // tokenize string
+        TStr Str = Serializator.GetFieldStr(RecMem, Key.FieldId);
+        IndexVoc->GetTokenizer(Key.KeyId)->GetTokens(Str, WordStrV);
+    } else if (Key.FieldType == oftStrV && Key.IsValue()) {
+        // each string from array is a word
+        Serializator.GetFieldStrV(RecMem, Key.FieldId, WordStrV);
+    } else if (Key.FieldType == oftTm && Key.IsValue()) {
+        // time indexed as timestamp string
+        const uint64 TmMSecs = Serializator.GetFieldTmMSecs(RecMem, Key.FieldId);
+        WordStrV.Add(TUInt64::GetStr(TmMSecs));
+    }
+}
+
+void TRecIndexer::GetWordRecIdFqH(const TFieldIndexKey& Key, const TVec<TMem>& RecMemV,
+        const TUInt64V& RecIdV, const int& Recs, TRecSerializator& Serializator,
+        THash<TUInt64, TUInt64IntPrV>& WordRecIdFqH) {
+
+    // extract words from all records in parallel, unless the tokenizer
+    // cannot be called from several threads
+    const bool ConcurrentP = !Key.IsText() || IndexVoc->GetTokenizer(Key.KeyId)->IsConcurrent();
+    TVec<TStrV> RecWordStrVV(Recs);
+    TBoolV RecNullV(Recs);
+    #pragma omp parallel for schedule(dynamic, 64) if(ConcurrentP)
+    for (int RecN = 0; RecN < Recs; RecN++) {
+        RecNullV[RecN] = Serializator.IsFieldNull(RecMemV[RecN], Key.FieldId);
+        if (!RecNullV[RecN]) {
+            GetKeyWordStrV(Key, RecMemV[RecN], Serializator, RecWordStrVV[RecN]);
+        }
+    }
+    // map words to ids and group records by word
+    for (int RecN = 0; RecN < Recs; RecN++) {
+        if (RecNullV[RecN]) { continue; }
+        const TStrV& WordStrV = RecWordStrVV[RecN];
+        TUInt64V WordIdV;
+        if (Key.IsTokenized()) {
+            IndexVoc->AddWordIdV(Key.KeyId, WordStrV, WordIdV);
+        } else {
+            for (int WordN = 0; WordN < WordStrV.Len(); WordN++) {
+                WordIdV.Add(IndexVoc->AddWordStr(Key.KeyId, WordStrV[WordN]));
+            }
+        }
+        // aggregate by word
+        TUInt64H WordIdFqH;
+        for (int WordIdN = 0; WordIdN < WordIdV.Len(); WordIdN++) {
+            WordIdFqH.AddDat(WordIdV[WordIdN])++;
+        }
+        int WordKeyId = WordIdFqH.FFirstKeyId();
+        while (WordIdFqH.FNextKeyId(WordKeyId)) {
+            WordRecIdFqH.AddDat(WordIdFqH.GetKey(WordKeyId)).Add(
+                TUInt64IntPr(RecIdV[RecN], WordIdFqH[WordKeyId]));
+        }
+    }
+}
+
+void TRecIndexer::IndexRecs(const TVec<TMem>& RecMemV, const TUInt64V& RecIdV, TRecSerializator& Serializator) {
+    // new records come with increasing ids
+    if (RecIdV.Empty() || IsDeferredRec(RecIdV[0])) { return; }
+    // cached query results over the store are no longer valid
+    Store->IncVersion();
+    const int Recs = RecMemV.Len();
+    // go over all keys associated with the store and its fields
+    for (int FieldIndexKeyN = 0; FieldIndexKeyN < FieldIndexKeyV.Len(); FieldIndexKeyN++) {
+        const TFieldIndexKey& Key = FieldIndexKeyV[FieldIndexKeyN];
+        // check if field is handled by the serializator
+        if (!Serializator.IsFieldId(Key.FieldId)) { continue; }
+        // keys not over words are indexed record by record
+        if (!Key.IsWordKey()) {
+            for (int RecN = 0; RecN < Recs; RecN++) {
+                if (Serializator.IsFieldNull(RecMemV[RecN], Key.FieldId)) { continue; }
+                IndexKey(Key, RecMemV[RecN], RecIdV[RecN], Serializator);
+            }
+            continue;
+        }
+        // group records by word
+        THash<TUInt64, TUInt64IntPrV> WordRecIdFqH;
+        GetWordRecIdFqH(Key, RecMemV, RecIdV, Recs, Serializator, WordRecIdFqH);
+        // record ids come in increasing order, so each item set gets sorted items
+        int WordKeyId = WordRecIdFqH.FFirstKeyId();
+        while (WordRecIdFqH.FNextKeyId(WordKeyId)) {
+            Index->IndexGixV(Key.KeyId, WordRecIdFqH.GetKey(WordKeyId), WordRecIdFqH[WordKeyId]);
+        }
+    }
+}
+
 void TRecIndexer::DeindexRec(const TMemBase& RecMem, const uint64& RecId, TRecSerializator& Serializator) {
+    if (IsDeferredRec(RecId)) { return; }
     // go over all keys associated with the store and its fields
     for (int FieldIndexKeyN = 0; FieldIndexKeyN < FieldIndexKeyV.Len(); FieldIndexKeyN++) {
         const TFieldIndexKey& Key = FieldIndexKeyV[FieldIndexKeyN];
@@ -2764,9 +3129,40 @@ void TRecIndexer::DeindexRec(const TMemBase& RecMem, const uint64& RecId, TRecSe
     }
 }
 
+void TRecIndexer::DeindexRecs(const TVec<TMem>& RecMemV, const TUInt64V& RecIdV, TRecSerializator& Serializator) {
+    // records come with increasing ids, deferred ones were never indexed
+    int Recs = 0;
+    while (Recs < RecIdV.Len() && !IsDeferredRec(RecIdV[Recs])) { Recs++; }
+    if (Recs == 0) { return; }
+    // cached query results over the store are no longer valid
+    Store->IncVersion();
+    // go over all keys associated with the store and its fields
+    for (int FieldIndexKeyN = 0; FieldIndexKeyN < FieldIndexKeyV.Len(); FieldIndexKeyN++) {
+        const TFieldIndexKey& Key = FieldIndexKeyV[FieldIndexKeyN];
+        // check if field is handled by the serializator
+        if (!Serializator.IsFieldId(Key.FieldId)) { continue; }
+        // keys not over words are deindexed record by record
+        if (!Key.IsWordKey()) {
+            for (int RecN = 0; RecN < Recs; RecN++) {
+                if (Serializator.IsFieldNull(RecMemV[RecN], Key.FieldId)) { continue; }
+                DeindexKey(Key, RecMemV[RecN], RecIdV[RecN], Serializator);
+            }
+            continue;
+        }
+        // group records by word and remove them from each item set at once
+        THash<TUInt64, TUInt64IntPrV> WordRecIdFqH;
+        GetWordRecIdFqH(Key, RecMemV, RecIdV, Recs, Serializator, WordRecIdFqH);
+        int WordKeyId = WordRecIdFqH.FFirstKeyId();
+        while (WordRecIdFqH.FNextKeyId(WordKeyId)) {
+            Index->DeleteGixV(Key.KeyId, WordRecIdFqH.GetKey(WordKeyId), WordRecIdFqH[WordKeyId]);
+        }
+    }
+}
+
 void TRecIndexer::UpdateRec(const TMemBase& OldRecMem, const TMemBase& NewRecMem,
         const uint64& RecId, const int& ChangedFieldId, TRecSerializator& Serializator) {
 
+    if (IsDeferredRec(RecId)) { return; }
     // check if we have a key for the field
     if (FieldIdToKeyN.IsKey(ChangedFieldId)) {
         // get field index key
@@ -2780,6 +3176,7 @@ void TRecIndexer::UpdateRec(const TMemBase& OldRecMem, const TMemBase& NewRecMem
 void TRecIndexer::UpdateRec(const TMemBase& OldRecMem, const TMemBase& NewRecMem,
         const uint64& RecId, TIntSet& ChangedFieldIdSet, TRecSerializator& Serializator) {
 
+    if (IsDeferredRec(RecId)) { return; }
     // go over all keys associated with the store and its fields
     for (int FieldIndexKeyN = 0; FieldIndexKeyN < FieldIndexKeyV.Len(); FieldIndexKeyN++) {
         const TFieldIndexKey& Key = FieldIndexKeyV[FieldIndexKeyN];
@@ -2794,6 +3191,7 @@ void TRecIndexer::UpdateRec(const TMemBase& OldRecMem, const TMemBase& NewRecMem
 
 void TRecIndexer::DeindexRecField(const TMemBase& RecMem, const uint64& RecId, const int& FieldId, TRecSerializator& Serializator)
 {
+    if (IsDeferredRec(RecId)) { return; }
     // check if we have a key for the field
     if (FieldIdToKeyN.IsKey(FieldId)) {
         // get field index key
@@ -2806,6 +3204,7 @@ void TRecIndexer::DeindexRecField(const TMemBase& RecMem, const uint64& RecId, c
 
 void TRecIndexer::IndexRecField(const TMemBase& RecMem, const uint64& RecId, const int& FieldId, TRecSerializator& Serializator)
 {
+    if (IsDeferredRec(RecId)) { return; }
     // check if we have a key for the field
     if (FieldIdToKeyN.IsKey(FieldId)) {
         // get field index key
@@ -2816,6 +3215,20 @@ void TRecIndexer::IndexRecField(const TMemBase& RecMem, const uint64& RecId, con
     }
 }
 
+void TRecIndexer::StartLinearBulk() {
+    for (int FieldIndexKeyN = 0; FieldIndexKeyN < FieldIndexKeyV.Len(); FieldIndexKeyN++) {
+        const TFieldIndexKey& Key = FieldIndexKeyV[FieldIndexKeyN];
+        if (Key.IsLinear()) { Index->StartLinearBulk(Key.KeyId); }
+    }
+}
+
+void TRecIndexer::EndLinearBulk() {
+    for (int FieldIndexKeyN = 0; FieldIndexKeyN < FieldIndexKeyV.Len(); FieldIndexKeyN++) {
+        const TFieldIndexKey& Key = FieldIndexKeyV[FieldIndexKeyN];
+        if (Key.IsLinear()) { Index->EndLinearBulk(Key.KeyId); }
+    }
+}
+
 bool TRecIndexer::IsFieldIndexKey(const int& FieldId) const {
     // go over all keys associated with the store and its fields
     for (int i = 0; i < FieldIndexKeyV.Len(); i++) {
@@ -2860,6 +3273,8 @@ void TStoreImpl::InitFieldLocV() {
             FieldLocV.Add(slDisk);
         } else if (SerializatorMem->IsFieldId(FieldId)) {
             FieldLocV.Add(slMemory);
+        } else if (FieldId < FieldColumnV.Len() && FieldColumnV[FieldId].IsDef()) {
+            FieldLocV.Add(slColumn);
         } else {
             throw TQmExcept::New("Unknown storage location for field " +
                 GetFieldNm(FieldId) + " in store " + GetStoreNm());
@@ -2869,9 +3284,17 @@ void TStoreImpl::InitFieldLocV() {
 
 void TStoreImpl::GetRecMem(const TStoreLoc& RecLoc, const uint64& RecId, TMem& Rec) const {
     if (RecLoc == slDisk) {
+        // block cache is reordered on every read and can load from shared blob storage
+        TLock Lock(GetBase()->GetStoreBlobBsSection());
         DataCache.GetVal(RecId, Rec);
     } else if (RecLoc == slMemory)  {
-        DataMem.GetVal(RecId, Rec);
+        if (DataMem.IsValLoaded(RecId)) {
+            DataMem.GetVal(RecId, Rec);
+        } else {
+            // lazy loading reads from shared blob storage
+            TLock Lock(GetBase()->GetStoreBlobBsSection());
+            DataMem.GetVal(RecId, Rec);
+        }
     } else {
         throw TQmExcept::New("Unknown storage location");
     }
@@ -2919,6 +3342,126 @@ const TRecSerializator* TStoreImpl::GetFieldSerializator(const int &FieldId) con
     return GetSerializator(FieldLocV[FieldId]);
 }
 
+void TStoreImpl::AddColumnRec(const uint64& RecId, const PJsonVal& RecVal) {
+    // first extend all columns, so they stay aligned even if parsing fails
+    for (int FieldId = 0; FieldId < GetFields(); FieldId++) {
+        if (IsFieldColumn(FieldId)) { GetColumn(FieldId).AddRec(RecId); }
+    }
+    // set values
+    for (int FieldId = 0; FieldId < GetFields(); FieldId++) {
+        if (!IsFieldColumn(FieldId)) { continue; }
+        TFieldColumn& Column = GetColumn(FieldId);
+        const TFieldDesc& FieldDesc = GetFieldDesc(FieldId);
+        const TStr& FieldNm = FieldDesc.GetFieldNm();
+        if (RecVal->IsObjKey(FieldNm)) {
+            PJsonVal FieldVal = RecVal->GetObjKey(FieldNm);
+            QmAssertR(!FieldVal->IsNull() || FieldDesc.IsNullable(), "Non-nullable field " + FieldNm + " set to null");
+            Column.SetJsonVal(RecId, FieldNm, FieldVal);
+        } else if (!Column.GetDefaultVal().Empty()) {
+            Column.SetJsonVal(RecId, FieldNm, Column.GetDefaultVal());
+        } else if (!FieldDesc.IsNullable()) {
+            throw TQmExcept::New("JSon data is missing field - expecting " + FieldNm + ", store " + GetStoreNm());
+        }
+    }
+}
+
+void TStoreImpl::UpdateColumnRec(const uint64& RecId, const PJsonVal& RecVal) {
+    for (int FieldId = 0; FieldId < GetFields(); FieldId++) {
+        if (!IsFieldColumn(FieldId)) { continue; }
+        const TFieldDesc& FieldDesc = GetFieldDesc(FieldId);
+        const TStr& FieldNm = FieldDesc.GetFieldNm();
+        if (RecVal->IsObjKey(FieldNm)) {
+            PJsonVal FieldVal = RecVal->GetObjKey(FieldNm);
+            QmAssertR(!FieldVal->IsNull() || FieldDesc.IsNullable(), "Non-nullable field " + FieldNm + " set to null");
+            GetColumn(FieldId).SetJsonVal(RecId, FieldNm, FieldVal);
+        }
+    }
+}
+
+void TStoreImpl::LoadPrimaryIdH(TSIn& SIn) {
+    if (PrimaryFieldType == oftInt) {
+        PrimaryIntIdH.Load(SIn);
+    } else if (PrimaryFieldType == oftUInt64) {
+        PrimaryUInt64IdH.Load(SIn);
+    } else if (PrimaryFieldType == oftFlt) {
+        PrimaryFltIdH.Load(SIn);
+    } else if (PrimaryFieldType == oftTm) {
+        PrimaryTmMSecsIdH.Load(SIn);
+    } else {
+        // also used when there is no primary field, for backwards compatibility
+        PrimaryStrIdH.Load(SIn);
+    }
+}
+
+void TStoreImpl::SavePrimaryIdH(TSOut& SOut) const {
+    if (PrimaryFieldType == oftInt) {
+        PrimaryIntIdH.Save(SOut);
+    } else if (PrimaryFieldType == oftUInt64) {
+        PrimaryUInt64IdH.Save(SOut);
+    } else if (PrimaryFieldType == oftFlt) {
+        PrimaryFltIdH.Save(SOut);
+    } else if (PrimaryFieldType == oftTm) {
+        PrimaryTmMSecsIdH.Save(SOut);
+    } else {
+        PrimaryStrIdH.Save(SOut);
+    }
+}
+
+bool TStoreImpl::IsPrimaryFieldLogged() const {
+    // all changes of the primary field go through the in-memory storage
+    return DataMem.IsLog() && IsPrimaryField() && FieldLocV[PrimaryFieldId] == slMemory;
+}
+
+/// Remove entries pointing to deleted records or to records restored from the log
+template <class TKey>
+void DelLoggedPrimaryIds(THash<TKey, TUInt64>& PrimaryIdH, const TInMemStorage& DataMem) {
+    TVec<TKey> KeyV;
+    int KeyId = PrimaryIdH.FFirstKeyId();
+    while (PrimaryIdH.FNextKeyId(KeyId)) {
+        const uint64 RecId = PrimaryIdH[KeyId];
+        if (!DataMem.IsValId(RecId) || DataMem.GetLogValIdSet().IsKey(RecId)) {
+            KeyV.Add(PrimaryIdH.GetKey(KeyId));
+        }
+    }
+    for (int KeyN = 0; KeyN < KeyV.Len(); KeyN++) {
+        PrimaryIdH.DelKey(KeyV[KeyN]);
+    }
+}
+
+void TStoreImpl::LoadPrimaryFieldLog() {
+    if (TFile::Exists(StoreFNm + ".Primary")) {
+        TFIn PrimaryFIn(StoreFNm + ".Primary");
+        LoadPrimaryIdH(PrimaryFIn);
+    }
+    // map is from the last checkpoint, bring it up to date with the log
+    if (IsPrimaryFieldLogged() && DataMem.GetLogSize() > 0) {
+        if (PrimaryFieldType == oftStr) {
+            DelLoggedPrimaryIds(PrimaryStrIdH, DataMem);
+        } else if (PrimaryFieldType == oftInt) {
+            DelLoggedPrimaryIds(PrimaryIntIdH, DataMem);
+        } else if (PrimaryFieldType == oftUInt64) {
+            DelLoggedPrimaryIds(PrimaryUInt64IdH, DataMem);
+        } else if (PrimaryFieldType == oftFlt) {
+            DelLoggedPrimaryIds(PrimaryFltIdH, DataMem);
+        } else if (PrimaryFieldType == oftTm) {
+            DelLoggedPrimaryIds(PrimaryTmMSecsIdH, DataMem);
+        }
+        TUInt64V RecIdV; DataMem.GetLogValIdSet().GetKeyV(RecIdV); RecIdV.Sort();
+        for (int RecN = 0; RecN < RecIdV.Len(); RecN++) {
+            if (IsRecId(RecIdV[RecN])) { SetPrimaryField(RecIdV[RecN]); }
+        }
+    }
+}
+
+void TStoreImpl::Checkpoint() {
+    TEnv::Logger->OnStatusFmt("Checkpoint of store '%s'", GetStoreNm().CStr());
+    if (IsPrimaryFieldLogged()) {
+        TFOut PrimaryFOut(StoreFNm + ".Primary");
+        SavePrimaryIdH(PrimaryFOut);
+    }
+    DataMem.Checkpoint();
+}
+
 void TStoreImpl::SetPrimaryField(const uint64& RecId) {
     if (PrimaryFieldType == oftStr) {
         PrimaryStrIdH.AddDat(GetFieldStr(RecId, PrimaryFieldId)) = RecId;
@@ -3031,22 +3574,39 @@ void TStoreImpl::InitFromSchema(const TStoreSchema& StoreSchema) {
     // prepare serializators for disk and in-memory store
     SerializatorCache = new TRecSerializator(this, this, StoreSchema, slDisk);
     SerializatorMem = new TRecSerializator(this, this, StoreSchema, slMemory);
+    // prepare columns for fields in columnar storage
+    FieldColumnV.Gen(GetFields());
+    for (int FieldId = 0; FieldId < GetFields(); FieldId++) {
+        const TFieldDesc& FieldDesc = GetFieldDesc(FieldId);
+        const TFieldDescEx& FieldDescEx = StoreSchema.FieldExH.GetDat(FieldDesc.GetFieldNm());
+        if (FieldDescEx.FieldStoreLoc == slColumn) {
+            FieldColumnV[FieldId] = TFieldColumn(FieldDesc, FieldDescEx.DefaultVal);
+        }
+    }
     // initialize field to storage location map
     InitFieldLocV();
     // initialize record indexer
     RecIndexer = TRecIndexer(GetIndex(), this);
     // remember window parameters
     WndDesc = StoreSchema.WndDesc;
+    // remember time segment parameters
+    SegmentMSecs = StoreSchema.SegmentMSecs;
+    SegmentFieldId = IsSegmented() ? GetFieldId(WndDesc.TimeFieldNm) : -1;
 }
 
 void TStoreImpl::InitDataFlags() {
     // go over all the fields and remember if we use in-memory or cache storage
     DataCacheP = false;
     DataMemP = false;
+    DataColumnP = false;
     for (int FieldId = 0; FieldId < GetFields(); FieldId++) {
         DataCacheP = DataCacheP || (FieldLocV[FieldId] == slDisk);
         DataMemP = DataMemP || (FieldLocV[FieldId] == slMemory);
+        DataColumnP = DataColumnP || (FieldLocV[FieldId] == slColumn);
     }
+    // record IDs are maintained by row storage, so we keep (empty) in-memory
+    // records also when all the fields are stored in columns
+    if (DataColumnP && !DataCacheP) { DataMemP = true; }
     // at least one must be true, otherwise we have no fields, which is not good
     EAssert(DataCacheP || DataMemP);
 }
@@ -3056,7 +3616,8 @@ TStoreImpl::TStoreImpl(const TWPt<TBase>& Base, const uint& StoreId,
     const int64& _MxCacheSize, const int& BlockSize):
         TStore(Base, StoreId, StoreName), StoreFNm(_StoreFNm), FAccess(Base->GetFAccess()),
         DataCache(_StoreFNm + ".Cache", Base->GetStoreBlobBs(), _MxCacheSize, 1024),
-        DataMem(_StoreFNm + ".MemCache", Base->GetStoreBlobBs(), BlockSize) {
+        DataMem(_StoreFNm + ".MemCache", Base->GetStoreBlobBs(), BlockSize, StoreSchema.WriteLogP,
+            StoreSchema.WriteLogCommitMSecs, StoreSchema.WriteLogCheckpointMB) {
 
     SetStoreType("TStoreImpl");
     InitFromSchema(StoreSchema);
@@ -3078,22 +3639,14 @@ TStoreImpl::TStoreImpl(const TWPt<TBase>& Base, const TStr& _StoreFNm,
     // deduce primary field type
     if (PrimaryFieldId != -1) {
         PrimaryFieldType = GetFieldDesc(PrimaryFieldId).GetFieldType();
-        if (PrimaryFieldType == oftStr) {
-            PrimaryStrIdH.Load(FIn);
-        } else if (PrimaryFieldType == oftInt) {
-            PrimaryIntIdH.Load(FIn);
-        } else if (PrimaryFieldType == oftUInt64) {
-            PrimaryUInt64IdH.Load(FIn);
-        } else if (PrimaryFieldType == oftFlt) {
-            PrimaryFltIdH.Load(FIn);
-        } else if (PrimaryFieldType == oftTm) {
-            PrimaryTmMSecsIdH.Load(FIn);
-        } else {
+        if (PrimaryFieldType != oftStr && PrimaryFieldType != oftInt && PrimaryFieldType != oftUInt64 &&
+            PrimaryFieldType != oftFlt && PrimaryFieldType != oftTm) {
             throw TQmExcept::New("Unsupported primary field type!");
         }
-    } else {
-        // backwards compatibility
-        PrimaryStrIdH.Load(FIn);
+    }
+    // with write-ahead log the primary field map is kept in a separate file
+    if (!DataMem.IsLog()) {
+        LoadPrimaryIdH(FIn);
     }
     // load time window
     WndDesc.Load(FIn);
@@ -3102,6 +3655,19 @@ TStoreImpl::TStoreImpl(const TWPt<TBase>& Base, const TStr& _StoreFNm,
     SerializatorMem = new TRecSerializator(this);
     SerializatorCache->Load(FIn);
     SerializatorMem->Load(FIn);
+    // load columns (only stores with columnar fields have them)
+    if (TFile::Exists(StoreFNm + ".Column")) {
+        TFIn ColumnFIn(StoreFNm + ".Column");
+        FieldColumnV.Load(ColumnFIn);
+    }
+    // load time segments (only segmented stores have them)
+    SegmentFieldId = -1;
+    if (TFile::Exists(StoreFNm + ".Segment")) {
+        TFIn SegmentFIn(StoreFNm + ".Segment");
+        SegmentMSecs.Load(SegmentFIn);
+        SegmentV.Load(SegmentFIn);
+        SegmentFieldId = GetFieldId(WndDesc.TimeFieldNm);
+    }
 
     // initialize field to storage location map
     InitFieldLocV();
@@ -3110,11 +3676,21 @@ TStoreImpl::TStoreImpl(const TWPt<TBase>& Base, const TStr& _StoreFNm,
 
     // initialize data storage flags
     InitDataFlags();
+    // restore primary field map
+    if (DataMem.IsLog()) {
+        LoadPrimaryFieldLog();
+    }
+    // restore time segments
+    if (IsSegmented()) {
+        SyncSegmentV();
+    }
 }
 
 TStoreImpl::~TStoreImpl() {
     // save if necessary
     if (FAccess != faRdOnly) {
+        // records waiting for indexing are indexed before closing
+        if (RecIndexer.IsDeferred()) { IndexDeferredRecs(); }
         TEnv::Logger->OnStatus(TStr::Fmt("Saving store '%s'...", GetStoreNm().CStr()));
         // save base store
         TFOut BaseFOut(StoreFNm + ".BaseStore");
@@ -3124,22 +3700,29 @@ TStoreImpl::~TStoreImpl() {
         // save parameters about primary field
         RecNmFieldP.Save(FOut);
         PrimaryFieldId.Save(FOut);
-        if (PrimaryFieldType == oftInt) {
-            PrimaryIntIdH.Save(FOut);
-        } else if (PrimaryFieldType == oftUInt64) {
-            PrimaryUInt64IdH.Save(FOut);
-        } else if (PrimaryFieldType == oftFlt) {
-            PrimaryFltIdH.Save(FOut);
-        } else if (PrimaryFieldType == oftTm) {
-            PrimaryTmMSecsIdH.Save(FOut);
-        } else {
-            PrimaryStrIdH.Save(FOut);
+        if (!DataMem.IsLog()) {
+            SavePrimaryIdH(FOut);
+        } else if (!IsPrimaryFieldLogged()) {
+            // map cannot be restored from the log, so save it in full
+            TFOut PrimaryFOut(StoreFNm + ".Primary");
+            SavePrimaryIdH(PrimaryFOut);
         }
         // save time window
         WndDesc.Save(FOut);
         // save data
         SerializatorCache->Save(FOut);
         SerializatorMem->Save(FOut);
+        // save columns
+        if (DataColumnP) {
+            TFOut ColumnFOut(StoreFNm + ".Column");
+            FieldColumnV.Save(ColumnFOut);
+        }
+        // save time segments
+        if (IsSegmented()) {
+            TFOut SegmentFOut(StoreFNm + ".Segment");
+            SegmentMSecs.Save(SegmentFOut);
+            SegmentV.Save(SegmentFOut);
+        }
     } else {
         TEnv::Logger->OnStatus("No saving of generic store " + GetStoreNm() + " neccessary!");
     }
@@ -3194,6 +3777,61 @@ PStoreIter TStoreImpl::BackwardIter() const {
         TStoreIterVec::New(DataCache.GetLastValId(), DataCache.GetFirstValId(), false);
 }
 
+uint64 TStoreImpl::GetPrimaryRecId(const PJsonVal& RecVal) const {
+    uint64 PrimaryRecId = TUInt64::Mx;
+    // primary field cannot be nullable, so we must have it
+    const TStr& PrimaryField = GetFieldNm(PrimaryFieldId);
+    QmAssertR(RecVal->IsObjKey(PrimaryField), "Missing primary field in the record: " + PrimaryField);
+    // parse based on the field type
+    if (PrimaryFieldType == oftStr) {
+        TStr FieldVal = RecVal->GetObjStr(PrimaryField);
+        if (PrimaryStrIdH.IsKey(FieldVal)) {
+            PrimaryRecId = PrimaryStrIdH.GetDat(FieldVal);
+        }
+    } else if (PrimaryFieldType == oftInt) {
+        const int FieldVal = RecVal->GetObjInt(PrimaryField);
+        if (PrimaryIntIdH.IsKey(FieldVal)) {
+            PrimaryRecId = PrimaryIntIdH.GetDat(FieldVal);
+        }
+    } else if (PrimaryFieldType == oftUInt64) {
+        const uint64 FieldVal = RecVal->GetObjUInt64(PrimaryField);
+        if (PrimaryUInt64IdH.IsKey(FieldVal)) {
+            PrimaryRecId = PrimaryUInt64IdH.GetDat(FieldVal);
+        }
+    } else if (PrimaryFieldType == oftFlt) {
+        const double FieldVal = RecVal->GetObjNum(PrimaryField);
+        if (PrimaryFltIdH.IsKey(FieldVal)) {
+            PrimaryRecId = PrimaryFltIdH.GetDat(FieldVal);
+        }
+    } else if (PrimaryFieldType == oftTm) {
+        const uint64 FieldVal = RecVal->GetObjTmMSecs(PrimaryField);
+        if (PrimaryTmMSecsIdH.IsKey(FieldVal)) {
+            PrimaryRecId = PrimaryTmMSecsIdH.GetDat(FieldVal);
+        }
+    } else {
+        EAssertR(false, "Unsupported primary-field type");
+    }
+    return PrimaryRecId;
+}
+
+TStr TStoreImpl::GetPrimaryStr(const PJsonVal& RecVal) const {
+    const TStr& PrimaryField = GetFieldNm(PrimaryFieldId);
+    QmAssertR(RecVal->IsObjKey(PrimaryField), "Missing primary field in the record: " + PrimaryField);
+    // parse based on the field type
+    if (PrimaryFieldType == oftStr) {
+        return RecVal->GetObjStr(PrimaryField);
+    } else if (PrimaryFieldType == oftInt) {
+        return TInt::GetStr(RecVal->GetObjInt(PrimaryField));
+    } else if (PrimaryFieldType == oftUInt64) {
+        return TUInt64::GetStr(RecVal->GetObjUInt64(PrimaryField));
+    } else if (PrimaryFieldType == oftFlt) {
+        return TFlt::GetStr(RecVal->GetObjNum(PrimaryField), "%.17g");
+    } else if (PrimaryFieldType == oftTm) {
+        return TUInt64::GetStr(RecVal->GetObjTmMSecs(PrimaryField));
+    }
+    throw TQmExcept::New("Unsupported primary-field type");
+}
+
 uint64 TStoreImpl::AddRec(const PJsonVal& RecVal, const bool& TriggerEvents) {
     // check if we are given reference to existing record
     try {
@@ -3209,39 +3847,7 @@ uint64 TStoreImpl::AddRec(const PJsonVal& RecVal, const bool& TriggerEvents) {
         }
         // check if we have a primary field
         if (IsPrimaryField()) {
-            uint64 PrimaryRecId = TUInt64::Mx;
-            // primary field cannot be nullable, so we must have it
-            const TStr& PrimaryField = GetFieldNm(PrimaryFieldId);
-            QmAssertR(RecVal->IsObjKey(PrimaryField), "Missing primary field in the record: " + PrimaryField);
-            // parse based on the field type
-            if (PrimaryFieldType == oftStr) {
-                TStr FieldVal = RecVal->GetObjStr(PrimaryField);
-                if (PrimaryStrIdH.IsKey(FieldVal)) {
-                    PrimaryRecId = PrimaryStrIdH.GetDat(FieldVal);
-                }
-            } else if (PrimaryFieldType == oftInt) {
-                const int FieldVal = RecVal->GetObjInt(PrimaryField);
-                if (PrimaryIntIdH.IsKey(FieldVal)) {
-                    PrimaryRecId = PrimaryIntIdH.GetDat(FieldVal);
-                }
-            } else if (PrimaryFieldType == oftUInt64) {
-                const uint64 FieldVal = RecVal->GetObjUInt64(PrimaryField);
-                if (PrimaryUInt64IdH.IsKey(FieldVal)) {
-                    PrimaryRecId = PrimaryUInt64IdH.GetDat(FieldVal);
-                }
-            } else if (PrimaryFieldType == oftFlt) {
-                const double FieldVal = RecVal->GetObjNum(PrimaryField);
-                if (PrimaryFltIdH.IsKey(FieldVal)) {
-                    PrimaryRecId = PrimaryFltIdH.GetDat(FieldVal);
-                }
-            } else if (PrimaryFieldType == oftTm) {
-                const uint64 FieldVal = RecVal->GetObjTmMSecs(PrimaryField);
-                if (PrimaryTmMSecsIdH.IsKey(FieldVal)) {
-                    PrimaryRecId = PrimaryTmMSecsIdH.GetDat(FieldVal);
-                }
-            } else {
-                EAssertR(false, "Unsupported primary-field type");
-            }
+            const uint64 PrimaryRecId = GetPrimaryRecId(RecVal);
             // check if we found primary field with existing value
             if (PrimaryRecId != TUInt64::Mx) {
                 // check if we have anything more than primary field, which would require redirect to UpdateRec
@@ -3286,6 +3892,10 @@ uint64 TStoreImpl::AddRec(const PJsonVal& RecVal, const bool& TriggerEvents) {
     if (DataCacheP && DataMemP) {
         EAssert(CacheRecId == MemRecId);
     }
+    // store to columns
+    if (DataColumnP) { AddColumnRec(RecId, RecVal); }
+    // assign record to time segment
+    if (IsSegmented()) { AddSegmentRec(RecId); }
 
     // remember value-recordId map when primary field available
     if (IsPrimaryField()) { SetPrimaryField(RecId); }
@@ -3295,12 +3905,156 @@ uint64 TStoreImpl::AddRec(const PJsonVal& RecVal, const bool& TriggerEvents) {
     // call add triggers
     if (TriggerEvents) {
         OnAdd(RecId);
+    } else {
+        IncVersion();
     }
 
     // return record Id of the new record
     return RecId;
 }
 
+void TStoreImpl::AddRecs(const TVec<PJsonVal>& RecValV, TUInt64V& RecIdV, const bool& TriggerEvents) {
+    RecIdV.Gen(RecValV.Len(), 0);
+    // records collected for the current batch
+    TVec<PJsonVal> BatchRecValV;
+    // primary field values of the records in the current batch
+    TStrSet BatchPrimarySet;
+    for (int RecN = 0; RecN < RecValV.Len(); RecN++) {
+        const PJsonVal& RecVal = RecValV[RecN];
+        if (IsBatchRec(RecVal, BatchPrimarySet)) {
+            BatchRecValV.Add(RecVal);
+        } else {
+            // flush the batch so far to keep the order of additions
+            AddRecBatch(BatchRecValV, RecIdV, TriggerEvents);
+            BatchRecValV.Clr(); BatchPrimarySet.Clr();
+            // record might refer to an existing one, go through AddRec
+            RecIdV.Add(AddRec(RecVal, TriggerEvents));
+        }
+    }
+    AddRecBatch(BatchRecValV, RecIdV, TriggerEvents);
+}
+
+bool TStoreImpl::IsBatchRec(const PJsonVal& RecVal, TStrSet& BatchPrimarySet) const {
+    if (!RecVal->IsObj()) { return false; }
+    // references to existing records
+    if (RecVal->IsObjKey("$id") || RecVal->IsObjKey("$name")) { return false; }
+    // nested join records are added to other stores
+    for (int JoinN = 0; JoinN < GetJoins(); JoinN++) {
+        if (RecVal->IsObjKey(GetJoinDesc(JoinN).GetJoinNm())) { return false; }
+    }
+    // primary field must be new and unique within the batch
+    if (IsPrimaryField()) {
+        try {
+            if (GetPrimaryRecId(RecVal) != TUInt64::Mx) { return false; }
+            const TStr PrimaryStr = GetPrimaryStr(RecVal);
+            if (BatchPrimarySet.IsKey(PrimaryStr)) { return false; }
+            BatchPrimarySet.AddKey(PrimaryStr);
+        } catch (const PExcept& Except) {
+            // leave error reporting to AddRec
+            return false;
+        }
+    }
+    return true;
+}
+
+void TStoreImpl::AddRecBatch(const TVec<PJsonVal>& BatchRecValV, TUInt64V& RecIdV, const bool& TriggerEvents) {
+    const int Recs = BatchRecValV.Len();
+    if (Recs == 0) { return; }
+    // add system field and serialize records in parallel
+    TVec<TMem> CacheRecMemV(Recs), MemRecMemV(Recs);
+    int ErrorRecN = Recs; PExcept ErrorExcept;
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (int RecN = 0; RecN < Recs; RecN++) {
+        try {
+            const PJsonVal& RecVal = BatchRecValV[RecN];
+            RecVal->AddToObj(TStoreWndDesc::SysInsertedAtFieldName, TTm::GetCurUniTm().GetStr());
+            if (DataCacheP) { SerializatorCache->Serialize(RecVal, CacheRecMemV[RecN], this); }
+            if (DataMemP) { SerializatorMem->Serialize(RecVal, MemRecMemV[RecN], this); }
+        } catch (const PExcept& Except) {
+            #pragma omp critical
+            {
+                // remember the first failed record
+                if (RecN < ErrorRecN) { ErrorRecN = RecN; ErrorExcept = Except; }
+            }
+        }
+    }
+    // store records preceding the first failed one
+    const int StoreRecs = ErrorRecN;
+    const int FirstRecN = RecIdV.Len();
+    for (int RecN = 0; RecN < StoreRecs; RecN++) {
+        uint64 CacheRecId = TUInt64::Mx, MemRecId = TUInt64::Mx;
+        if (DataCacheP) { CacheRecId = DataCache.AddVal(CacheRecMemV[RecN]); }
+        if (DataMemP) { MemRecId = DataMem.AddVal(MemRecMemV[RecN]); }
+        // make sure we are consistent with respect to Ids!
+        if (DataCacheP && DataMemP) { EAssert(CacheRecId == MemRecId); }
+        RecIdV.Add(DataMemP ? MemRecId : CacheRecId);
+    }
+    // index new records, each key at once
+    if (StoreRecs > 0) {
+        TUInt64V BatchRecIdV; RecIdV.GetSubValV(FirstRecN, RecIdV.Len() - 1, BatchRecIdV);
+        CacheRecMemV.Trunc(StoreRecs); MemRecMemV.Trunc(StoreRecs);
+        if (DataCacheP) { RecIndexer.IndexRecs(CacheRecMemV, BatchRecIdV, *SerializatorCache); }
+        if (DataMemP) { RecIndexer.IndexRecs(MemRecMemV, BatchRecIdV, *SerializatorMem); }
+    }
+    // finish the records in the same way as AddRec
+    for (int RecN = 0; RecN < StoreRecs; RecN++) {
+        const uint64 RecId = RecIdV[FirstRecN + RecN];
+        if (DataColumnP) { AddColumnRec(RecId, BatchRecValV[RecN]); }
+        if (IsSegmented()) { AddSegmentRec(RecId); }
+        if (IsPrimaryField()) { SetPrimaryField(RecId); }
+        if (TriggerEvents) { OnAdd(RecId); } else { IncVersion(); }
+    }
+    // report the error from serialization
+    if (!ErrorExcept.Empty()) { throw ErrorExcept; }
+}
+
+uint64 TStoreImpl::GetNextRecId() const {
+    return DataMemP ? (DataMem.GetFirstValId() + DataMem.Len()) :
+        (DataCache.GetFirstValId() + DataCache.Len());
+}
+
+void TStoreImpl::SetIndexingDeferred(const bool& DeferredP) {
+    QmAssertR(FAccess != faRdOnly, "Cannot change indexing of read-only store " + GetStoreNm());
+    if (DeferredP == RecIndexer.IsDeferred()) { return; }
+    if (DeferredP) {
+        // records added from now on are not indexed
+        RecIndexer.SetDeferRecId(GetNextRecId());
+    } else {
+        IndexDeferredRecs();
+    }
+}
+
+void TStoreImpl::IndexDeferredRecs() {
+    const uint64 DeferRecId = RecIndexer.GetDeferRecId();
+    RecIndexer.SetDeferRecId(TUInt64::Mx);
+    if (Empty()) { return; }
+    // records deleted in the meantime are gone already
+    const uint64 FirstRecId = TMath::Mx(DeferRecId, GetFirstRecId());
+    const uint64 LastRecId = GetLastRecId();
+    if (FirstRecId > LastRecId) { return; }
+    TEnv::Logger->OnStatusFmt("Indexing %s records of store %s ...",
+        TUInt64::GetStr(LastRecId - FirstRecId + 1).CStr(), GetStoreNm().CStr());
+    // b-trees are built at the end from all the values, while the inverted
+    // index gets sorted items for each word from each batch
+    RecIndexer.StartLinearBulk();
+    const uint64 BatchLen = 100000;
+    for (uint64 BatchRecId = FirstRecId; BatchRecId <= LastRecId; BatchRecId += BatchLen) {
+        const uint64 BatchEndRecId = TMath::Mn(BatchRecId + BatchLen - 1, LastRecId);
+        TUInt64V RecIdV((int)(BatchEndRecId - BatchRecId + 1), 0);
+        TVec<TMem> CacheRecMemV(RecIdV.Reserved(), 0), MemRecMemV(RecIdV.Reserved(), 0);
+        for (uint64 RecId = BatchRecId; RecId <= BatchEndRecId; RecId++) {
+            if (!IsRecId(RecId)) { continue; }
+            RecIdV.Add(RecId);
+            if (DataCacheP) { DataCache.GetVal(RecId, CacheRecMemV[CacheRecMemV.Add()]); }
+            if (DataMemP) { DataMem.GetVal(RecId, MemRecMemV[MemRecMemV.Add()]); }
+        }
+        if (DataCacheP) { RecIndexer.IndexRecs(CacheRecMemV, RecIdV, *SerializatorCache); }
+        if (DataMemP) { RecIndexer.IndexRecs(MemRecMemV, RecIdV, *SerializatorMem); }
+    }
+    RecIndexer.EndLinearBulk();
+    TEnv::Logger->OnStatus("Indexing done");
+}
+
 void TStoreImpl::UpdateRec(const uint64& RecId, const PJsonVal& RecVal) {
     // figure out which storage fields are affected
     bool CacheP = false, MemP = false, PrimaryP = false;
@@ -3339,12 +4093,71 @@ void TStoreImpl::UpdateRec(const uint64& RecId, const PJsonVal& RecVal) {
         // update indexes pointing to the record
         RecIndexer.UpdateRec(MemOldRecMem, MemNewRecMem, RecId, MemChangedFieldIdSet, *SerializatorMem);
     }
+    // update columns
+    if (DataColumnP) { UpdateColumnRec(RecId, RecVal); }
+    // extend time segment when time changed
+    if (IsSegmented() && RecVal->IsObjKey(WndDesc.TimeFieldNm)) { UpdateSegmentRec(RecId, SegmentFieldId); }
     // check if primary key changed and update the mapping
     if (PrimaryP) { SetPrimaryField(RecId); }
     // call update triggers
     OnUpdate(RecId);
 }
 
+void TStoreImpl::AddSegmentRec(const uint64& RecId) {
+    const uint64 TmMSecs = GetFieldTmMSecs(RecId, SegmentFieldId);
+    if (SegmentV.Empty() || TmMSecs >= SegmentV.Last().StartMSecs + SegmentMSecs) {
+        // record starts a new segment, aligned to segment length
+        SegmentV.Add(TStoreSegment(TmMSecs - TmMSecs % SegmentMSecs, RecId, TmMSecs));
+    } else {
+        // late records stay in the last segment, since segments cover consecutive records
+        SegmentV.Last().LastRecId = RecId;
+        SegmentV.Last().AddTm(TmMSecs);
+    }
+}
+
+void TStoreImpl::UpdateSegmentRec(const uint64& RecId, const int& FieldId) {
+    if (!IsSegmented() || FieldId != SegmentFieldId) { return; }
+    const int SegmentN = TStoreSegment::GetSegmentN(SegmentV, RecId);
+    // time range of the segment only grows, so it still covers the old value
+    if (SegmentN != -1) { SegmentV[SegmentN].AddTm(GetFieldTmMSecs(RecId, FieldId)); }
+}
+
+void TStoreImpl::DelSegmentRecs() {
+    if (Empty()) { SegmentV.Clr(); return; }
+    // drop segments with all records deleted
+    const uint64 FirstRecId = GetFirstRecId();
+    int DelSegments = 0;
+    while (DelSegments < SegmentV.Len() && SegmentV[DelSegments].LastRecId < FirstRecId) { DelSegments++; }
+    if (DelSegments > 0) { SegmentV.Del(0, DelSegments - 1); }
+    // first segment might be deleted only partially
+    if (!SegmentV.Empty() && SegmentV[0].FirstRecId < FirstRecId) { SegmentV[0].FirstRecId = FirstRecId; }
+}
+
+void TStoreImpl::SyncSegmentV() {
+    DelSegmentRecs();
+    if (Empty()) { return; }
+    // drop records that were saved in segments but are not in the store
+    const uint64 LastRecId = GetLastRecId();
+    while (!SegmentV.Empty() && SegmentV.Last().FirstRecId > LastRecId) { SegmentV.DelLast(); }
+    if (!SegmentV.Empty() && SegmentV.Last().LastRecId > LastRecId) { SegmentV.Last().LastRecId = LastRecId; }
+    // add records missing from segments
+    const uint64 FirstRecId = SegmentV.Empty() ? GetFirstRecId() : SegmentV.Last().LastRecId + 1;
+    for (uint64 RecId = FirstRecId; RecId <= LastRecId; RecId++) { AddSegmentRec(RecId); }
+    // update segments of records changed since the last checkpoint
+    if (DataMem.IsLog() && DataMem.GetLogSize() > 0) {
+        TUInt64V RecIdV; DataMem.GetLogValIdSet().GetKeyV(RecIdV);
+        for (int RecN = 0; RecN < RecIdV.Len(); RecN++) {
+            if (IsRecId(RecIdV[RecN])) { UpdateSegmentRec(RecIdV[RecN], SegmentFieldId); }
+        }
+    }
+}
+
+bool TStoreImpl::GetSegmentV(const int& TmFieldId, TStoreSegmentV& _SegmentV) const {
+    if (!IsSegmented() || TmFieldId != SegmentFieldId) { return false; }
+    _SegmentV = SegmentV;
+    return true;
+}
+
 void TStoreImpl::GarbageCollect(const int& MxTimeMSecs) {
     // if no window, nothing to do here
     if (WndDesc.WindowType == swtNone) { return; }
@@ -3370,10 +4183,18 @@ void TStoreImpl::GarbageCollect(const int& MxTimeMSecs) {
         TEnv::Logger->OnStatusFmt("  window: %s - %s",
             TTm::GetTmFromMSecs(WindowStartMSecs).GetWebLogDateTimeStr(true, "T", false).CStr(),
             TTm::GetTmFromMSecs(CurMSecs).GetWebLogDateTimeStr(true, "T", false).CStr());
+        // segments entirely before the time window are expired without reading their records
+        uint64 FirstRecId = GetFirstRecId();
+        for (int SegmentN = 0; SegmentN < SegmentV.Len(); SegmentN++) {
+            const TStoreSegment& Segment = SegmentV[SegmentN];
+            if (Segment.MaxMSecs >= WindowStartMSecs) { break; }
+            for (uint64 RecId = Segment.FirstRecId; RecId <= Segment.LastRecId; RecId++) {
+                DelRecIdV.Add(RecId);
+            }
+            FirstRecId = Segment.LastRecId + 1;
+        }
         // iterate from the start until we hit the time window
-        PStoreIter Iter = GetIter();
-        while (Iter->Next()) {
-            uint64 RecId = Iter->GetRecId();
+        for (uint64 RecId = FirstRecId; RecId <= LastRecId; RecId++) {
             // get record time
             uint64 TmMSecs = GetFieldTmMSecs(RecId, TimeFieldId);
             // if we are within time window we stop
@@ -3400,6 +4221,12 @@ void TStoreImpl::GarbageCollect(const int& MxTimeMSecs) {
     TStoreImpl::DeleteRecs(DelRecIdV, MxTimeMSecs, false);
 }
 
+void TStoreImpl::DeindexRecs(const TUInt64V& RecIdV, TVec<TMem>& CacheRecMemV, TVec<TMem>& MemRecMemV) {
+    if (DataCacheP) { RecIndexer.DeindexRecs(CacheRecMemV, RecIdV, *SerializatorCache); }
+    if (DataMemP) { RecIndexer.DeindexRecs(MemRecMemV, RecIdV, *SerializatorMem); }
+    CacheRecMemV.Clr(); MemRecMemV.Clr();
+}
+
 /// Deletes all records
 void TStoreImpl::DeleteAllRecs() {
     // if no records, nothing to do here
@@ -3408,36 +4235,40 @@ void TStoreImpl::DeleteAllRecs() {
 
     // NOTE: if you change the logic bellow, be sure to also change the DeleteRecs() method
 
-    // delete records from index
-    for (uint64 DelRecId = GetFirstRecId(); DelRecId <= GetLastRecId(); DelRecId++) {
-        // executed triggers before deletion
-        OnDelete(DelRecId);
-        // delete record from name-id map
-        if (IsPrimaryField()) { DelPrimaryField(DelRecId); }
-        // delete record from indexes
-        if (DataCacheP) {
-            TMem CacheRecMem;
-            DataCache.GetVal(DelRecId, CacheRecMem);
-            RecIndexer.DeindexRec(CacheRecMem, DelRecId, *SerializatorCache);
+    // delete records from index, in chunks as in DeleteRecs()
+    TUInt64V ChunkRecIdV; TVec<TMem> CacheRecMemV, MemRecMemV;
+    const uint64 LastRecId = GetLastRecId();
+    for (uint64 ChunkRecId = GetFirstRecId(); ChunkRecId <= LastRecId; ChunkRecId += 1000) {
+        const uint64 ChunkLastRecId = TMath::Mn(ChunkRecId + 999, LastRecId);
+        for (uint64 DelRecId = ChunkRecId; DelRecId <= ChunkLastRecId; DelRecId++) {
+            // executed triggers before deletion
+            OnDelete(DelRecId);
+            // delete record from name-id map
+            if (IsPrimaryField()) { DelPrimaryField(DelRecId); }
+            // remember record for deleting from indexes
+            ChunkRecIdV.Add(DelRecId);
+            if (DataCacheP) { CacheRecMemV.Add(); DataCache.GetVal(DelRecId, CacheRecMemV.Last()); }
+            if (DataMemP) { MemRecMemV.Add(); DataMem.GetVal(DelRecId, MemRecMemV.Last()); }
         }
-        if (DataMemP) {
-            TMem MemRecMem;
-            DataMem.GetVal(DelRecId, MemRecMem);
-            RecIndexer.DeindexRec(MemRecMem, DelRecId, *SerializatorMem);
-        }
-        // delete record from joins
-        TRec Rec(this, DelRecId);
-        for (int JoinN = 0; JoinN < GetJoins(); JoinN++) {
-            TJoinDesc JoinDesc = GetJoinDesc(JoinN);
-            // execute the join
-            PRecSet JoinRecSet = Rec.DoJoin(GetBase(), JoinDesc.GetJoinId());
-            for (int JoinRecN = 0; JoinRecN < JoinRecSet->GetRecs(); JoinRecN++) {
-                // remove joins with all matched records, one by one
-                const uint64 JoinRecId = JoinRecSet->GetRecId(JoinRecN);
-                const int JoinFq = JoinRecSet->GetRecFq(JoinRecN);
-                DelJoin(JoinDesc.GetJoinId(), DelRecId, JoinRecId, JoinFq);
+        // delete chunk of records from indexes
+        DeindexRecs(ChunkRecIdV, CacheRecMemV, MemRecMemV);
+        for (int ChunkRecN = 0; ChunkRecN < ChunkRecIdV.Len(); ChunkRecN++) {
+            const uint64 DelRecId = ChunkRecIdV[ChunkRecN];
+            // delete record from joins
+            TRec Rec(this, DelRecId);
+            for (int JoinN = 0; JoinN < GetJoins(); JoinN++) {
+                TJoinDesc JoinDesc = GetJoinDesc(JoinN);
+                // execute the join
+                PRecSet JoinRecSet = Rec.DoJoin(GetBase(), JoinDesc.GetJoinId());
+                for (int JoinRecN = 0; JoinRecN < JoinRecSet->GetRecs(); JoinRecN++) {
+                    // remove joins with all matched records, one by one
+                    const uint64 JoinRecId = JoinRecSet->GetRecId(JoinRecN);
+                    const int JoinFq = JoinRecSet->GetRecFq(JoinRecN);
+                    DelJoin(JoinDesc.GetJoinId(), DelRecId, JoinRecId, JoinFq);
+                }
             }
         }
+        ChunkRecIdV.Clr();
     }
     // delete records from disk
     PrimaryStrIdH.Clr();
@@ -3447,6 +4278,10 @@ void TStoreImpl::DeleteAllRecs() {
     PrimaryTmMSecsIdH.Clr();
     DataCache.DelVals(TInt::Mx);
     DataMem.DelVals(TInt::Mx);
+    for (int FieldId = 0; FieldId < FieldColumnV.Len(); FieldId++) {
+        if (FieldColumnV[FieldId].IsDef()) { FieldColumnV[FieldId].Clr(); }
+    }
+    SegmentV.Clr();
     PartialFlush(TInt::Mx);
 }
 
@@ -3488,52 +4323,56 @@ void TStoreImpl::DeleteRecs(const TUInt64V& DelRecIdV, const int& MxTimeMSecs, c
 
     // NOTE: if you change the logic bellow, be sure to also change the DeleteAllRecs() method
 
-    // delete records from index
+    // delete records from index, records are deindexed in chunks so
+    // each inverted index item set is updated once per chunk
     TTmStopWatch StopWatch(true);
-    int DeletedRecs = 0;
-    for (int DelRecN = 0; DelRecN < DelRecIdV.Len(); DelRecN++) {
+    int DeletedRecs = 0; bool TimeOutP = false;
+    TUInt64V ChunkRecIdV; TVec<TMem> CacheRecMemV, MemRecMemV;
+    for (int ChunkRecN = 0; ChunkRecN < DelRecIdV.Len() && !TimeOutP; ChunkRecN += 1000) {
         // report progress
-        if (DelRecN > 0 && DelRecN % 1000 == 0) {
-            TEnv::Logger->OnStatusFmt("    %d\r", DelRecN);
-        }
-        // check if we still have time
-        if ((MxTimeMSecs != -1) && (StopWatch.GetMSecInt() > MxTimeMSecs)) {
-            TEnv::Logger->OnStatusFmt("Reached time limit of %d msecs in TStoreImpl::DeleteRecs");
-            break;
-        }
-        // what are we deleting now
-        const uint64 DelRecId = DelRecIdV[DelRecN];
-        // executed triggers before deletion
-        OnDelete(DelRecId);
-        // delete record from name-id map
-        if (IsPrimaryField()) {
-            DelPrimaryField(DelRecId);
-        }
-        // delete record from indexes
-        if (DataCacheP) {
-            TMem CacheRecMem;
-            DataCache.GetVal(DelRecId, CacheRecMem);
-            RecIndexer.DeindexRec(CacheRecMem, DelRecId, *SerializatorCache);
+        if (ChunkRecN > 0) {
+            TEnv::Logger->OnStatusFmt("    %d\r", ChunkRecN);
         }
-        if (DataMemP) {
-            TMem MemRecMem;
-            DataMem.GetVal(DelRecId, MemRecMem);
-            RecIndexer.DeindexRec(MemRecMem, DelRecId, *SerializatorMem);
+        const int ChunkEndRecN = TInt::GetMn(ChunkRecN + 1000, DelRecIdV.Len());
+        for (int DelRecN = ChunkRecN; DelRecN < ChunkEndRecN; DelRecN++) {
+            // check if we still have time
+            if ((MxTimeMSecs != -1) && (StopWatch.GetMSecInt() > MxTimeMSecs)) {
+                TEnv::Logger->OnStatusFmt("Reached time limit of %d msecs in TStoreImpl::DeleteRecs");
+                TimeOutP = true; break;
+            }
+            // what are we deleting now
+            const uint64 DelRecId = DelRecIdV[DelRecN];
+            // executed triggers before deletion
+            OnDelete(DelRecId);
+            // delete record from name-id map
+            if (IsPrimaryField()) {
+                DelPrimaryField(DelRecId);
+            }
+            // remember record for deleting from indexes
+            ChunkRecIdV.Add(DelRecId);
+            if (DataCacheP) { CacheRecMemV.Add(); DataCache.GetVal(DelRecId, CacheRecMemV.Last()); }
+            if (DataMemP) { MemRecMemV.Add(); DataMem.GetVal(DelRecId, MemRecMemV.Last()); }
         }
-        // delete record from joins
-        TRec Rec(this, DelRecId);
-        for (int JoinN = 0; JoinN < GetJoins(); JoinN++) {
-            TJoinDesc JoinDesc = GetJoinDesc(JoinN);
-            // execute the join
-            PRecSet JoinRecSet = Rec.DoJoin(GetBase(), JoinDesc.GetJoinId());
-            for (int JoinRecN = 0; JoinRecN < JoinRecSet->GetRecs(); JoinRecN++) {
-                // remove joins with all matched records, one by one
-                const uint64 JoinRecId = JoinRecSet->GetRecId(JoinRecN);
-                DelJoin(JoinDesc.GetJoinId(), DelRecId, JoinRecId);
+        // delete chunk of records from indexes
+        DeindexRecs(ChunkRecIdV, CacheRecMemV, MemRecMemV);
+        for (int DelRecN = 0; DelRecN < ChunkRecIdV.Len(); DelRecN++) {
+            const uint64 DelRecId = ChunkRecIdV[DelRecN];
+            // delete record from joins
+            TRec Rec(this, DelRecId);
+            for (int JoinN = 0; JoinN < GetJoins(); JoinN++) {
+                TJoinDesc JoinDesc = GetJoinDesc(JoinN);
+                // execute the join
+                PRecSet JoinRecSet = Rec.DoJoin(GetBase(), JoinDesc.GetJoinId());
+                for (int JoinRecN = 0; JoinRecN < JoinRecSet->GetRecs(); JoinRecN++) {
+                    // remove joins with all matched records, one by one
+                    const uint64 JoinRecId = JoinRecSet->GetRecId(JoinRecN);
+                    DelJoin(JoinDesc.GetJoinId(), DelRecId, JoinRecId);
+                }
             }
+            // count what we deleted
+            DeletedRecs++;
         }
-        // count what we deleted
-        DeletedRecs++;
+        ChunkRecIdV.Clr();
     }
     // delete records from disk
     if (DataCacheP) {
@@ -3543,6 +4382,15 @@ void TStoreImpl::DeleteRecs(const TUInt64V& DelRecIdV, const int& MxTimeMSecs, c
     if (DataMemP) {
         DataMem.DelVals(DeletedRecs);
     }
+    // delete records from columns
+    if (DataColumnP) {
+        for (int FieldId = 0; FieldId < FieldColumnV.Len(); FieldId++) {
+            if (FieldColumnV[FieldId].IsDef()) { FieldColumnV[FieldId].DelRecs(DeletedRecs); }
+        }
+    }
+
+    // delete records from time segments
+    if (IsSegmented()) { DelSegmentRecs(); }
 
     // report success :-)
     if (DelRecIdV.Len() > 1000) {
@@ -3551,16 +4399,19 @@ void TStoreImpl::DeleteRecs(const TUInt64V& DelRecIdV, const int& MxTimeMSecs, c
 }
 
 bool TStoreImpl::IsFieldNull(const uint64& RecId, const int& FieldId) const {
+    if (IsFieldColumn(FieldId)) { return GetColumn(FieldId).IsNull(RecId); }
     TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
     return GetFieldSerializator(FieldId)->IsFieldNull(RecMem, FieldId);
 }
 
 uchar TStoreImpl::GetFieldByte(const uint64& RecId, const int& FieldId) const {
+    if (IsFieldColumn(FieldId)) { return GetColumn(FieldId).GetByte(RecId); }
     TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
     return GetFieldSerializator(FieldId)->GetFieldByte(RecMem, FieldId);
 }
 
 int TStoreImpl::GetFieldInt(const uint64& RecId, const int& FieldId) const {
+    if (IsFieldColumn(FieldId)) { return GetColumn(FieldId).GetInt(RecId); }
     TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
     return GetFieldSerializator(FieldId)->GetFieldInt(RecMem, FieldId);
 }
@@ -3571,6 +4422,7 @@ int16 TStoreImpl::GetFieldInt16(const uint64& RecId, const int& FieldId) const {
 }
 
 int64 TStoreImpl::GetFieldInt64(const uint64& RecId, const int& FieldId) const {
+    if (IsFieldColumn(FieldId)) { return GetColumn(FieldId).GetInt64(RecId); }
     TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
     return GetFieldSerializator(FieldId)->GetFieldInt64(RecMem, FieldId);
 }
@@ -3581,16 +4433,19 @@ TStr TStoreImpl::GetFieldStr(const uint64& RecId, const int& FieldId) const {
 }
 
 bool TStoreImpl::GetFieldBool(const uint64& RecId, const int& FieldId) const {
+    if (IsFieldColumn(FieldId)) { return GetColumn(FieldId).GetBool(RecId); }
     TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
     return GetFieldSerializator(FieldId)->GetFieldBool(RecMem, FieldId);
 }
 
 double TStoreImpl::GetFieldFlt(const uint64& RecId, const int& FieldId) const {
+    if (IsFieldColumn(FieldId)) { return GetColumn(FieldId).GetFlt(RecId); }
     TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
     return GetFieldSerializator(FieldId)->GetFieldFlt(RecMem, FieldId);
 }
 
 float TStoreImpl::GetFieldSFlt(const uint64& RecId, const int& FieldId) const {
+    if (IsFieldColumn(FieldId)) { return GetColumn(FieldId).GetSFlt(RecId); }
     TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
     return GetFieldSerializator(FieldId)->GetFieldSFlt(RecMem, FieldId);
 }
@@ -3611,6 +4466,7 @@ uint16 TStoreImpl::GetFieldUInt16(const uint64& RecId, const int& FieldId) const
 }
 
 uint64 TStoreImpl::GetFieldUInt64(const uint64& RecId, const int& FieldId) const {
+    if (IsFieldColumn(FieldId)) { return GetColumn(FieldId).GetUInt64(RecId); }
     TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
     return GetFieldSerializator(FieldId)->GetFieldUInt64(RecMem, FieldId);
 }
@@ -3631,11 +4487,13 @@ void TStoreImpl::GetFieldFltV(const uint64& RecId, const int& FieldId, TFltV& Fl
 }
 
 void TStoreImpl::GetFieldTm(const uint64& RecId, const int& FieldId, TTm& Tm) const {
+    if (IsFieldColumn(FieldId)) { Tm = TTm::GetTmFromMSecs(GetColumn(FieldId).GetTmMSecs(RecId)); return; }
     TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
     GetFieldSerializator(FieldId)->GetFieldTm(RecMem, FieldId, Tm);
 }
 
 uint64 TStoreImpl::GetFieldTmMSecs(const uint64& RecId, const int& FieldId) const {
+    if (IsFieldColumn(FieldId)) { return GetColumn(FieldId).GetTmMSecs(RecId); }
     TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
     return GetFieldSerializator(FieldId)->GetFieldTmMSecs(RecMem, FieldId);
 }
@@ -3661,6 +4519,7 @@ PJsonVal TStoreImpl::GetFieldJsonVal(const uint64& RecId, const int& FieldId) co
 }
 
 void TStoreImpl::SetFieldNull(const uint64& RecId, const int& FieldId) {
+    if (IsFieldColumn(FieldId)) { GetColumn(FieldId).SetNull(RecId); return; }
     TMem InRecMem; GetRecMem(RecId, FieldId, InRecMem);
     TRecSerializator* FieldSerializator = GetFieldSerializator(FieldId);
     TMem OutRecMem; FieldSerializator->SetFieldNull(InRecMem, OutRecMem, FieldId);
@@ -3669,6 +4528,7 @@ void TStoreImpl::SetFieldNull(const uint64& RecId, const int& FieldId) {
 }
 
 void TStoreImpl::SetFieldByte(const uint64& RecId, const int& FieldId, const uchar& Byte) {
+    if (IsFieldColumn(FieldId)) { GetColumn(FieldId).SetByte(RecId, Byte); return; }
     TMem InRecMem; GetRecMem(RecId, FieldId, InRecMem);
     TRecSerializator* FieldSerializator = GetFieldSerializator(FieldId);
     TMem OutRecMem;
@@ -3678,6 +4538,7 @@ void TStoreImpl::SetFieldByte(const uint64& RecId, const int& FieldId, const uch
 }
 
 void TStoreImpl::SetFieldInt(const uint64& RecId, const int& FieldId, const int& Int) {
+    if (IsFieldColumn(FieldId)) { GetColumn(FieldId).SetInt(RecId, Int); return; }
     // special case if field is primary field
     if (FieldId == PrimaryFieldId) {
         // it is, make sure new value does not exist yet
@@ -3709,6 +4570,7 @@ void TStoreImpl::SetFieldInt16(const uint64& RecId, const int& FieldId, const in
 }
 
 void TStoreImpl::SetFieldInt64(const uint64& RecId, const int& FieldId, const int64& Int64) {
+    if (IsFieldColumn(FieldId)) { GetColumn(FieldId).SetInt64(RecId, Int64); return; }
     TMem InRecMem; GetRecMem(RecId, FieldId, InRecMem);
     TRecSerializator* FieldSerializator = GetFieldSerializator(FieldId);
     TMem OutRecMem;
@@ -3745,6 +4607,7 @@ void TStoreImpl::SetFieldUInt16(const uint64& RecId, const int& FieldId, const u
 }
 
 void TStoreImpl::SetFieldUInt64(const uint64& RecId, const int& FieldId, const uint64& UInt64) {
+    if (IsFieldColumn(FieldId)) { GetColumn(FieldId).SetUInt64(RecId, UInt64); return; }
     // special case if field is primary field
     if (FieldId == PrimaryFieldId) {
         // it is, make sure new value does not exist yet
@@ -3798,6 +4661,7 @@ void TStoreImpl::SetFieldStrV(const uint64& RecId, const int& FieldId, const TSt
 }
 
 void TStoreImpl::SetFieldBool(const uint64& RecId, const int& FieldId, const bool& Bool) {
+    if (IsFieldColumn(FieldId)) { GetColumn(FieldId).SetBool(RecId, Bool); return; }
     TMem InRecMem; GetRecMem(RecId, FieldId, InRecMem);
     TRecSerializator* FieldSerializator = GetFieldSerializator(FieldId);
     TMem OutRecMem;
@@ -3807,6 +4671,7 @@ void TStoreImpl::SetFieldBool(const uint64& RecId, const int& FieldId, const boo
 }
 
 void TStoreImpl::SetFieldFlt(const uint64& RecId, const int& FieldId, const double& Flt) {
+    if (IsFieldColumn(FieldId)) { GetColumn(FieldId).SetFlt(RecId, Flt); return; }
     // special case if field is primary field
     if (FieldId == PrimaryFieldId) {
         // it is, make sure new value does not exist yet
@@ -3828,6 +4693,7 @@ void TStoreImpl::SetFieldFlt(const uint64& RecId, const int& FieldId, const doub
     if (FieldId == PrimaryFieldId) { SetPrimaryFieldFlt(RecId, Flt); }
 }
 void TStoreImpl::SetFieldSFlt(const uint64& RecId, const int& FieldId, const float& SFlt) {
+    if (IsFieldColumn(FieldId)) { GetColumn(FieldId).SetSFlt(RecId, SFlt); return; }
     TMem InRecMem; GetRecMem(RecId, FieldId, InRecMem);
     TRecSerializator* FieldSerializator = GetFieldSerializator(FieldId);
     TMem OutRecMem;
@@ -3855,15 +4721,24 @@ void TStoreImpl::SetFieldFltV(const uint64& RecId, const int& FieldId, const TFl
 }
 
 void TStoreImpl::SetFieldTm(const uint64& RecId, const int& FieldId, const TTm& Tm) {
+    if (IsFieldColumn(FieldId)) {
+        GetColumn(FieldId).SetTmMSecs(RecId, TTm::GetMSecsFromTm(Tm));
+        UpdateSegmentRec(RecId, FieldId); return;
+    }
     TMem InRecMem; GetRecMem(RecId, FieldId, InRecMem);
     TRecSerializator* FieldSerializator = GetFieldSerializator(FieldId);
     TMem OutRecMem;
     FieldSerializator->SetFieldTm(InRecMem, OutRecMem, FieldId, Tm);
     RecIndexer.UpdateRec(InRecMem, OutRecMem, RecId, FieldId, *FieldSerializator);
     PutRecMem(RecId, FieldId, OutRecMem);
+    UpdateSegmentRec(RecId, FieldId);
 }
 
 void TStoreImpl::SetFieldTmMSecs(const uint64& RecId, const int& FieldId, const uint64& TmMSecs) {
+    if (IsFieldColumn(FieldId)) {
+        GetColumn(FieldId).SetTmMSecs(RecId, TmMSecs);
+        UpdateSegmentRec(RecId, FieldId); return;
+    }
     // special case if field is primary field
     if (FieldId == PrimaryFieldId) {
         // it is, make sure new value does not exist yet
@@ -3883,6 +4758,7 @@ void TStoreImpl::SetFieldTmMSecs(const uint64& RecId, const int& FieldId, const
     RecIndexer.UpdateRec(InRecMem, OutRecMem, RecId, FieldId, *FieldSerializator);
     PutRecMem(RecId, FieldId, OutRecMem);
     if (FieldId == PrimaryFieldId) { SetPrimaryFieldMSecs(RecId, TmMSecs); }
+    UpdateSegmentRec(RecId, FieldId);
 }
 
 void TStoreImpl::SetFieldNumSpV(const uint64& RecId, const int& FieldId, const TIntFltKdV& SpV) {
@@ -3933,6 +4809,10 @@ PJsonVal TStoreImpl::GetStoreJson(const TWPt<TBase>& Base) const {
         if (WndDesc.WindowType == TStoreWndType::swtTime) {
             WindowJson->AddToObj("timeField", WndDesc.TimeFieldNm);
         }
+        if (IsSegmented()) {
+            WindowJson->AddToObj("segmentSize", (double)SegmentMSecs);
+            WindowJson->AddToObj("segments", SegmentV.Len());
+        }
 
         Result->AddToObj("window", WindowJson);
     }
@@ -3950,6 +4830,10 @@ int TStoreImpl::PartialFlush(int WndInMsec) {
     TTmStopWatch sw(true);
     int res = DataMem.PartialFlush(slice);
     int res2 = DataCache.PartialFlush(slice);
+    // all in-memory blocks are saved and the log is large enough to be worth removing
+    if (DataMem.IsCheckpointReady()) {
+        Checkpoint();
+    }
     return res + res2;
 }
 
@@ -4077,6 +4961,8 @@ uint64 TStorePbBlob::AddRec(const PJsonVal& RecVal, const bool& TriggerEvents) {
     // call add triggers
     if (TriggerEvents) {
         OnAdd(RecId);
+    } else {
+        IncVersion();
     }
 
     // return record Id of the new record
@@ -4270,111 +5156,133 @@ void TStorePbBlob::DelPrimaryFieldMSecs(const uint64& RecId, const uint64& MSecs
 
 /// Check if the value of given field for a given record is NULL
 bool TStorePbBlob::IsFieldNull(const uint64& RecId, const int& FieldId) const {
+    TLock Lock(PgBlobSection);
     TThinMIn MIn = GetPgBf(RecId, FieldLocV[FieldId] != TStoreLoc::slDisk);
     return GetSerializator(FieldLocV[FieldId])->IsFieldNull(MIn, FieldId);
 }
 /// Get field value using field id (default implementation throws exception)
 uchar TStorePbBlob::GetFieldByte(const uint64& RecId, const int& FieldId) const {
+    TLock Lock(PgBlobSection);
     TThinMIn MIn = GetPgBf(RecId, FieldLocV[FieldId] != TStoreLoc::slDisk);
     return GetSerializator(FieldLocV[FieldId])->GetFieldByte(MIn, FieldId);
 }
 /// Get field value using field id (default implementation throws exception)
 int TStorePbBlob::GetFieldInt(const uint64& RecId, const int& FieldId) const {
+    TLock Lock(PgBlobSection);
     TThinMIn MIn = GetPgBf(RecId, FieldLocV[FieldId] != TStoreLoc::slDisk);
     return GetSerializator(FieldLocV[FieldId])->GetFieldInt(MIn, FieldId);
 }
 /// Get field value using field id (default implementation throws exception)
 int16 TStorePbBlob::GetFieldInt16(const uint64& RecId, const int& FieldId) const {
+    TLock Lock(PgBlobSection);
     TThinMIn MIn = GetPgBf(RecId, FieldLocV[FieldId] != TStoreLoc::slDisk);
     return GetSerializator(FieldLocV[FieldId])->GetFieldInt16(MIn, FieldId);
 }
 /// Get field value using field id (default implementation throws exception)
 int64 TStorePbBlob::GetFieldInt64(const uint64& RecId, const int& FieldId) const {
+    TLock Lock(PgBlobSection);
     TThinMIn MIn = GetPgBf(RecId, FieldLocV[FieldId] != TStoreLoc::slDisk);
     return GetSerializator(FieldLocV[FieldId])->GetFieldInt64(MIn, FieldId);
 }
 /// Get field value using field id (default implementation throws exception)
 void TStorePbBlob::GetFieldIntV(const uint64& RecId, const int& FieldId, TIntV& IntV) const {
+    TLock Lock(PgBlobSection);
     TThinMIn MIn = GetPgBf(RecId, FieldLocV[FieldId] != TStoreLoc::slDisk);
     GetSerializator(FieldLocV[FieldId])->GetFieldIntV(MIn, FieldId, IntV);
 }
 /// Get field value using field id (default implementation throws exception)
 uint TStorePbBlob::GetFieldUInt(const uint64& RecId, const int& FieldId) const {
+    TLock Lock(PgBlobSection);
     TThinMIn MIn = GetPgBf(RecId, FieldLocV[FieldId] != TStoreLoc::slDisk);
     return GetSerializator(FieldLocV[FieldId])->GetFieldUInt(MIn, FieldId);
 }
 /// Get field value using field id (default implementation throws exception)
 uint16 TStorePbBlob::GetFieldUInt16(const uint64& RecId, const int& FieldId) const {
+    TLock Lock(PgBlobSection);
     TThinMIn MIn = GetPgBf(RecId, FieldLocV[FieldId] != TStoreLoc::slDisk);
     return GetSerializator(FieldLocV[FieldId])->GetFieldUInt16(MIn, FieldId);
 }
 /// Get field value using field id (default implementation throws exception)
 uint64 TStorePbBlob::GetFieldUInt64(const uint64& RecId, const int& FieldId) const {
+    TLock Lock(PgBlobSection);
     TThinMIn MIn = GetPgBf(RecId, FieldLocV[FieldId] != TStoreLoc::slDisk);
     return GetSerializator(FieldLocV[FieldId])->GetFieldUInt64(MIn, FieldId);
 }
 /// Get field value using field id (default implementation throws exception)
 TStr TStorePbBlob::GetFieldStr(const uint64& RecId, const int& FieldId) const {
+    TLock Lock(PgBlobSection);
     TThinMIn MIn = GetPgBf(RecId, FieldLocV[FieldId] != TStoreLoc::slDisk);
     return GetSerializator(FieldLocV[FieldId])->GetFieldStr(MIn, FieldId);
 }
 /// Get field value using field id (default implementation throws exception)
 void TStorePbBlob::GetFieldStrV(const uint64& RecId, const int& FieldId, TStrV& StrV) const {
+    TLock Lock(PgBlobSection);
     TThinMIn MIn = GetPgBf(RecId, FieldLocV[FieldId] != TStoreLoc::slDisk);
     GetSerializator(FieldLocV[FieldId])->GetFieldStrV(MIn, FieldId, StrV);
 }
 /// Get field value using field id (default implementation throws exception)
 bool TStorePbBlob::GetFieldBool(const uint64& RecId, const int& FieldId) const {
+    TLock Lock(PgBlobSection);
     TThinMIn MIn = GetPgBf(RecId, FieldLocV[FieldId] != TStoreLoc::slDisk);
     return GetSerializator(FieldLocV[FieldId])->GetFieldBool(MIn, FieldId);
 }
 /// Get field value using field id (default implementation throws exception)
 double TStorePbBlob::GetFieldFlt(const uint64& RecId, const int& FieldId) const {
+    TLock Lock(PgBlobSection);
     TThinMIn MIn = GetPgBf(RecId, FieldLocV[FieldId] != TStoreLoc::slDisk);
     return GetSerializator(FieldLocV[FieldId])->GetFieldFlt(MIn, FieldId);
 }
 /// Get field value using field id (default implementation throws exception)
 float TStorePbBlob::GetFieldSFlt(const uint64& RecId, const int& FieldId) const {
+    TLock Lock(PgBlobSection);
     TThinMIn MIn = GetPgBf(RecId, FieldLocV[FieldId] != TStoreLoc::slDisk);
     return GetSerializator(FieldLocV[FieldId])->GetFieldSFlt(MIn, FieldId);
 }
 /// Get field value using field id (default implementation throws exception)
 TFltPr TStorePbBlob::GetFieldFltPr(const uint64& RecId, const int& FieldId) const {
+    TLock Lock(PgBlobSection);
     TThinMIn MIn = GetPgBf(RecId, FieldLocV[FieldId] != TStoreLoc::slDisk);
     return GetSerializator(FieldLocV[FieldId])->GetFieldFltPr(MIn, FieldId);
 }
 /// Get field value using field id (default implementation throws exception)
 void TStorePbBlob::GetFieldFltV(const uint64& RecId, const int& FieldId, TFltV& FltV) const {
+    TLock Lock(PgBlobSection);
     TThinMIn MIn = GetPgBf(RecId, FieldLocV[FieldId] != TStoreLoc::slDisk);
     GetSerializator(FieldLocV[FieldId])->GetFieldFltV(MIn, FieldId, FltV);
 }
 /// Get field value using field id (default implementation throws exception)
 void TStorePbBlob::GetFieldTm(const uint64& RecId, const int& FieldId, TTm& Tm) const {
+    TLock Lock(PgBlobSection);
     TThinMIn MIn = GetPgBf(RecId, FieldLocV[FieldId] != TStoreLoc::slDisk);
     GetSerializator(FieldLocV[FieldId])->GetFieldTm(MIn, FieldId, Tm);
 }
 /// Get field value using field id (default implementation throws exception)
 uint64 TStorePbBlob::GetFieldTmMSecs(const uint64& RecId, const int& FieldId) const {
+    TLock Lock(PgBlobSection);
     TThinMIn MIn = GetPgBf(RecId, FieldLocV[FieldId] != TStoreLoc::slDisk);
     return GetSerializator(FieldLocV[FieldId])->GetFieldTmMSecs(MIn, FieldId);
 }
 /// Get field value using field id (default implementation throws exception)
 void TStorePbBlob::GetFieldNumSpV(const uint64& RecId, const int& FieldId, TIntFltKdV& SpV) const {
+    TLock Lock(PgBlobSection);
     TThinMIn MIn = GetPgBf(RecId, FieldLocV[FieldId] != TStoreLoc::slDisk);
     GetSerializator(FieldLocV[FieldId])->GetFieldNumSpV(MIn, FieldId, SpV);
 }
 /// Get field value using field id (default implementation throws exception)
 void TStorePbBlob::GetFieldBowSpV(const uint64& RecId, const int& FieldId, PBowSpV& SpV) const {
+    TLock Lock(PgBlobSection);
     TThinMIn MIn = GetPgBf(RecId, FieldLocV[FieldId] != TStoreLoc::slDisk);
     GetSerializator(FieldLocV[FieldId])->GetFieldBowSpV(MIn, FieldId, SpV);
 }
 /// Get field value using field id (default implementation throws exception)
 void TStorePbBlob::GetFieldTMem(const uint64& RecId, const int& FieldId, TMem& Mem) const {
+    TLock Lock(PgBlobSection);
     TThinMIn MIn = GetPgBf(RecId, FieldLocV[FieldId] != TStoreLoc::slDisk);
     GetSerializator(FieldLocV[FieldId])->GetFieldTMem(MIn, FieldId, Mem);
 }
 /// Get field value using field id (default implementation throws exception)
 PJsonVal TStorePbBlob::GetFieldJsonVal(const uint64& RecId, const int& FieldId) const {
+    TLock Lock(PgBlobSection);
     TThinMIn MIn = GetPgBf(RecId, FieldLocV[FieldId] != TStoreLoc::slDisk);
     return GetSerializator(FieldLocV[FieldId])->GetFieldJsonVal(MIn, FieldId);
 }
@@ -5234,9 +6142,12 @@ void TStorePbBlob::InitFromSchema(const TStoreSchema& StoreSchema) {
     RecNmFieldP = false;
     PrimaryFieldId = -1;
     PrimaryFieldType = oftUndef;
+    QmAssertR(StoreSchema.SegmentMSecs == 0, "TStorePbBlob does not support time segments");
     // create fields
     for (int i = 0; i < StoreSchema.FieldH.Len(); i++) {
         const TFieldDesc& FieldDesc = StoreSchema.FieldH[i];
+        QmAssertR(StoreSchema.FieldExH.GetDat(FieldDesc.GetFieldNm()).FieldStoreLoc != slColumn,
+            "TStorePbBlob does not support column location");
         AddFieldDesc(FieldDesc);
         // check if we found a primary field
         if (FieldDesc.IsPrimary()) {
@@ -5294,7 +6205,7 @@ TStorePbBlob::TStorePbBlob(const TWPt<TBase>& Base, const uint& StoreId,
     TStore(Base, StoreId, StoreName), StoreFNm(_StoreFNm), FAccess(faCreate) {
 
     SetStoreType("TStorePbBlob");
-    DataBlob = new TPgBlob(_StoreFNm + "PgBlob", TFAccess::faCreate, _MxCacheSize);
+    DataBlob = new TPgBlob(_StoreFNm + "PgBlob", TFAccess::faCreate, _MxCacheSize, StoreSchema.PagedMMapP);
     DataMem = new TPgBlob(_StoreFNm + "PgBlobMem", TFAccess::faCreate, TUInt64::Mx);
     InitFromSchema(StoreSchema);
     InitDataFlags();
@@ -10,6 +10,7 @@
 #define QMINER_STORAGE_H
 
 #include "qminer_core.h"
+#include <atomic>
 
 namespace TQm {
 
@@ -19,7 +20,8 @@ namespace TStorage {
 /// Location to where field is serialized
 typedef enum {
     slMemory, ///< in-memory storage
-    slDisk    ///< disk storage with most-recently-used memory cache
+    slDisk,   ///< disk storage with most-recently-used memory cache
+    slColumn  ///< in-memory columnar storage (fixed-width fields only)
 } TStoreLoc;
 
 ///////////////////////////////
@@ -142,6 +144,8 @@ public:
     TBool HasStoreIdP;
     /// Window settings
     TStoreWndDesc WndDesc;
+    /// Length of time segments in milliseconds (0 when records are not segmented)
+    TUInt64 SegmentMSecs;
     /// Field descriptions
     THash<TStr, TFieldDesc> FieldH;
     /// Extended field descriptions
@@ -154,6 +158,15 @@ public:
     TInt BlockSizeMem;
     /// What is the default storage location for fields and field-joins
     TStoreLoc DefaultFieldStoreLoc;
+    /// Read disk storage of paged stores directly from memory-mapped files
+    TBool PagedMMapP;
+    /// Persist in-memory storage by appending changes to a write-ahead log.
+    /// Only for stores without keys with all fields in memory and without codebooks.
+    TBool WriteLogP;
+    /// Group-commit window of the write-ahead log in milliseconds
+    TInt WriteLogCommitMSecs;
+    /// Size of the write-ahead log in megabytes after which it is checkpointed
+    TInt WriteLogCheckpointMB;
 private:
     /// Parse field description from JSon
     TFieldDesc ParseFieldDesc(const TWPt<TBase>& Base, const PJsonVal& FieldVal);
@@ -187,6 +200,26 @@ const uchar isdfDirty = 1 << 2;
 /// Flag for entry that hasn't been loaded yet
 const uchar isdfNotLoaded = 1 << 3;
 
+///////////////////////////////
+/// Dirty flag of one TInMemStorage entry.
+/// Lazily opened storages load entries while other threads read them without
+/// a lock, so the flag is atomic. Setting it releases the loaded entry and
+/// reading it acquires it, so readers that see a loaded flag also see the value.
+class TInMemDirtyFlag {
+private:
+    std::atomic<uchar> Flag;
+public:
+    TInMemDirtyFlag(const uchar& _Flag = isdfNew): Flag(_Flag) { }
+    // copies only happen when vector of flags is resized, never concurrently
+    TInMemDirtyFlag(const TInMemDirtyFlag& DirtyFlag):
+        Flag(DirtyFlag.Flag.load(std::memory_order_relaxed)) { }
+    TInMemDirtyFlag& operator=(const TInMemDirtyFlag& DirtyFlag) {
+        Flag.store(DirtyFlag.Flag.load(std::memory_order_relaxed), std::memory_order_relaxed); return *this; }
+
+    TInMemDirtyFlag& operator=(const uchar& _Flag) { Flag.store(_Flag, std::memory_order_release); return *this; }
+    operator uchar() const { return Flag.load(std::memory_order_acquire); }
+};
+
 ///////////////////////////////
 /// In-memory storage.
 /// Wrapper around TVec of TMems.
@@ -209,21 +242,89 @@ private:
     /// Blob-pointers - locations where TMem objects are stored inside Blob storage
     TVec<TBlobPt, int64> BlobPtV;
     /// "Dirty flags" - 0 - new and not saved yet, 1 - existing and clean, 2 - existing but dirty, 3 - existing but not loaded
-    mutable TVec<uchar, int64> DirtyV;
+    mutable TVec<TInMemDirtyFlag, int64> DirtyV;
     /// Blob storage
     PBlobBs BlobStorage;
     /// How many records are packed together into block;
     TInt BlockSize;
+    /// Absolute numbers of blocks with new or changed records that need to be saved
+    THashSet<TUInt64> DirtyBlockSet;
+    /// Blocks replaced or deleted since the main file was saved. With the log they
+    /// are freed only after the main file stops pointing to them.
+    TVec<TBlobPt> FreeBlobPtV;
+
+    /// True when changes are appended to a write-ahead log and blocks
+    /// are saved only by PartialFlush, never when closing
+    TBool LogP;
+    /// Group-commit window of the log in milliseconds
+    TInt LogCommitMSecs;
+    /// Log size in bytes after which the storage is ready for checkpoint
+    TUInt64 LogCheckpointSize;
+    /// Number of the log segment to which new entries are appended
+    TInt LogSegN;
+    /// Output stream of the current log segment, opened on first entry
+    PSOut LogSOut;
+    /// Bytes written to the log since the last checkpoint
+    TUInt64 LogSize;
+    /// Time of the last group commit
+    TUInt64 LogCommitTmMSecs;
+    /// IDs of values restored from the log when opening the storage
+    THashSet<TUInt64> LogValIdSet;
+    /// Guards the log stream, which is also committed by the commit thread
+    TCriticalSection LogSection;
+
+    /// Commits log entries left pending when no new entries come in
+    class TLogCommitThread: public TThread {
+    private:
+        TInMemStorage* Storage;
+    public:
+        TLogCommitThread(TInMemStorage* _Storage): TThread(), Storage(_Storage) { }
+        void Run();
+    };
+    /// Commit thread, running while changes are logged
+    PThread LogCommitThread;
+    /// Tells the commit thread to finish
+    volatile bool LogCommitStopP;
 
     /// Utility method for loading specific record
     inline void LoadRec(int64 RecN) const;
 
-    /// Utility method for storing specific record
-    int SaveRec(int RecN);
+    /// Utility method for storing specific block
+    int SaveBlock(const uint64& BlockN);
+    /// Save all dirty blocks
+    void SaveDirtyBlocks();
+    /// Save block pointers and offsets
+    void SaveMain() const;
+    /// Save block pointers and free blocks the old main file pointed to
+    void CommitMain();
+    /// Free block now or, with the log, after the main file is saved
+    void FreeBlock(const TBlobPt& BlobPt);
+    /// Mark block holding given record as dirty
+    void SetBlockDirty(const int64& RecN) { DirtyBlockSet.AddKey((FirstValOffsetMem + RecN) / BlockSize); }
+
+    /// Change value vector without writing to the log
+    uint64 AddValNoLog(const TMem& Val);
+    void SetValNoLog(const uint64& ValId, const TMem& Val);
+    void DelValsNoLog(int Vals);
+
+    /// Name of the log segment file
+    TStr GetLogFNm(const int& SegN) const { return FNm + ".Log" + TInt::GetStr(SegN); }
+    /// Append entry to the log, opens segment when necessary. Entries are
+    /// 'v' with value ID and value, or 'd' with first value ID after delete.
+    void LogEntry(const char& Op, const uint64& ValId, const TMem* Val);
+    /// Flush the log when group-commit window passed or when forced
+    void CommitLog(const bool& ForceP);
+    /// Start the commit thread when changes are logged and can be written
+    void StartLogCommit();
+    /// Stop the commit thread and wait for it to finish
+    void StopLogCommit();
+    /// Apply all log segments to values loaded from the main file
+    void ReplayLog();
 
 public:
     TInMemStorage(const TStr& _FNm, const PBlobBs& _BlobStorage,
-        const int& _BlockSize = 1000);
+        const int& _BlockSize = 1000, const bool& _LogP = false,
+        const int& _LogCommitMSecs = 1000, const int& LogCheckpointMB = 64);
     TInMemStorage(const TStr& _FNm, const PBlobBs& _BlobStorage,
         const TFAccess& _FAccess, const bool& LazyP = false);
     ~TInMemStorage();
@@ -233,6 +334,9 @@ public:
     bool IsReadOnly() const { return Access == faRdOnly; }
 
     bool IsValId(const uint64& ValId) const;
+    /// Check if value is in memory (always true unless storage is opened lazily).
+    /// Safe to call while other threads load values.
+    bool IsValLoaded(const uint64& ValId) const;
     void GetVal(const uint64& ValId, TMem& Val) const;
     uint64 AddVal(const TMem& Val);
     void SetVal(const uint64& ValId, const TMem& Val);
@@ -245,6 +349,17 @@ public:
     int PartialFlush(int WndInMsec = 500);
     void LoadAll();
 
+    /// True when changes are persisted using write-ahead log
+    bool IsLog() const { return LogP; }
+    /// IDs of values restored from the log when opening the storage
+    const THashSet<TUInt64>& GetLogValIdSet() const { return LogValIdSet; }
+    /// Bytes written to the log since the last checkpoint
+    uint64 GetLogSize() const { return LogSize; }
+    /// True when all blocks are saved and log grew past checkpoint size
+    bool IsCheckpointReady() const;
+    /// Remove log segments, requires all blocks to be saved
+    void Checkpoint();
+
     TBlobBsStats GetBlobBsStats() { return BlobStorage->GetStats(); }
 
 #ifdef XTEST
@@ -346,6 +461,8 @@ private:
     THash<TInt, TInt> FieldIdToSerialDescIdH;
     /// Codebook for encoding strings
     TStrHash<TInt, TBigStrPool> CodebookH;
+    /// Guards codebook updates when records are serialized in parallel
+    TCriticalSection CodebookSection;
     /// Flag if TOAST should be used
     TBool UseToast;
     /// Max length of non-TOAST-ed record
@@ -737,6 +854,11 @@ private:
         bool IsLinear() const { return (KeyType & oiktLinear) > 0; }
         /// Get index type as string (value, text, location, linear)
         TStr GetKeyType() const;
+        /// Is indexed in inverted index over words derived from field value
+        bool IsWordKey() const { return (FieldType == oftStr && (IsValue() || IsText())) ||
+            ((FieldType == oftStrV || FieldType == oftTm) && IsValue()); }
+        /// Are words derived by tokenizing the field value
+        bool IsTokenized() const { return FieldType == oftStr && !IsValue() && IsText(); }
     };
 
 private:
@@ -744,14 +866,31 @@ private:
     TWPt<TIndex> Index;
     /// Index vocabulary shortcut
     TWPt<TIndexVoc> IndexVoc;
+    /// Store whose records are indexed
+    TWPt<TStore> Store;
     // list of index keys set for particular store
     TVec<TFieldIndexKey> FieldIndexKeyV;
     // map from field id to key position in FieldIndexKeyV
     TIntH FieldIdToKeyN;
+    /// Records with this or larger id are not indexed yet (TUInt64::Mx when indexing is not deferred)
+    TUInt64 DeferRecId;
+
+    /// Is indexing of the record deferred
+    bool IsDeferredRec(const uint64& RecId) const { return RecId >= DeferRecId; }
 
     /// Index a record using the given key
     void IndexKey(const TFieldIndexKey& Key, const TMemBase& RecMem,
         const uint64& RecId, TRecSerializator& Serializator);
+    /// Get words for a word key from a record. Does not touch the vocabulary,
+    /// so it is safe to call in parallel when the key's tokenizer is concurrent.
+    void GetKeyWordStrV(const TFieldIndexKey& Key, const TMemBase& RecMem,
+        TRecSerializator& Serializator, TStrV& WordStrV) const;
+    /// Group first Recs records by words of a word key, with the number of
+    /// occurrences of the word in each record. Words are extracted in parallel
+    /// when the key's tokenizer is concurrent.
+    void GetWordRecIdFqH(const TFieldIndexKey& Key, const TVec<TMem>& RecMemV,
+        const TUInt64V& RecIdV, const int& Recs, TRecSerializator& Serializator,
+        THash<TUInt64, TUInt64IntPrV>& WordRecIdFqH);
     /// Delete existing index of a record based on a given key
     void DeindexKey(const TFieldIndexKey& Key, const TMemBase& RecMem,
         const uint64& RecId, TRecSerializator& Serializator);
@@ -763,15 +902,33 @@ private:
         const TMemBase& NewRecMem, const uint64& RecId, TRecSerializator& Serializator);
 
 public:
-    TRecIndexer() { }
+    TRecIndexer(): DeferRecId(TUInt64::Mx) { }
     TRecIndexer(const TWPt<TIndex>& Index, const TWPt<TStore>& Store);
 
+    /// Skip indexing of records with given or larger id. Changes to such records
+    /// are skipped as well, since they are indexed later from their latest content.
+    void SetDeferRecId(const uint64& RecId) { DeferRecId = RecId; }
+    /// First record, which is not indexed yet
+    uint64 GetDeferRecId() const { return DeferRecId; }
+    /// Is indexing deferred
+    bool IsDeferred() const { return DeferRecId != TUInt64::Mx; }
+    /// Start bulk load of all linear keys (see TIndex::StartLinearBulk)
+    void StartLinearBulk();
+    /// End bulk load of all linear keys and build their b-trees
+    void EndLinearBulk();
+
     /// Check if given field is used for indexing
     bool IsFieldIndexKey(const int& FieldId) const;
     /// Index new record
     void IndexRec(const TMemBase& RecMem, const uint64& RecId, TRecSerializator& Serializator);
+    /// Index a batch of new records. Words are extracted in parallel and each
+    /// inverted index item set is updated only once per batch.
+    void IndexRecs(const TVec<TMem>& RecMemV, const TUInt64V& RecIdV, TRecSerializator& Serializator);
     /// Deindex existing record
     void DeindexRec(const TMemBase& RecMem, const uint64& RecId, TRecSerializator& Serializator);
+    /// Deindex a batch of existing records. Each inverted index item set
+    /// is updated only once per batch.
+    void DeindexRecs(const TVec<TMem>& RecMemV, const TUInt64V& RecIdV, TRecSerializator& Serializator);
     /// Update index for existing record
     void UpdateRec(const TMemBase& OldRecMem, const TMemBase& NewRecMem,
         const uint64& RecId, const int& ChangedFieldId, TRecSerializator& Serializator);
@@ -914,14 +1071,35 @@ private:
     TRecSerializator *SerializatorCache;
     /// Serializator to memory
     TRecSerializator *SerializatorMem;
+    /// Flag if we are using columnar store
+    TBool DataColumnP;
+    /// Columns for fields in columnar store (indexed by field ID, undefined for other fields)
+    TFieldColumnV FieldColumnV;
     /// Map from fields to storage location
     TVec<TStoreLoc> FieldLocV;
 
     // record indexer
     TRecIndexer RecIndexer;
 
+    /// Length of time segments in milliseconds (0 when records are not segmented)
+    TUInt64 SegmentMSecs;
+    /// Time field used for segmenting (-1 when records are not segmented)
+    TInt SegmentFieldId;
+    /// Time segments of records, ordered by record ids
+    TStoreSegmentV SegmentV;
+
     /// initialize field storage location map
     void InitFieldLocV();
+    /// True when field is stored in a column
+    bool IsFieldColumn(const int& FieldId) const { return FieldLocV[FieldId] == slColumn; }
+    /// Get column of a field stored in columnar store
+    TFieldColumn& GetColumn(const int& FieldId) { return FieldColumnV[FieldId]; }
+    /// Get column of a field stored in columnar store
+    const TFieldColumn& GetColumn(const int& FieldId) const { return FieldColumnV[FieldId]; }
+    /// Add new record to all columns and set values from JSon
+    void AddColumnRec(const uint64& RecId, const PJsonVal& RecVal);
+    /// Update column values for fields present in JSon
+    void UpdateColumnRec(const uint64& RecId, const PJsonVal& RecVal);
     /// Get TMem serialization of record from specified storage
     void GetRecMem(const TStoreLoc& RecLoc, const uint64& RecId, TMem& Rec) const;
     /// Get TMem serialization of record from specified where field is stored
@@ -946,6 +1124,43 @@ private:
     inline void DelRecNm(const uint64& RecId);
     /// Do we have a primary field
     bool IsPrimaryField() const { return PrimaryFieldId != -1; }
+    /// Get id of existing record with the same primary field value, TUInt64::Mx when none
+    uint64 GetPrimaryRecId(const PJsonVal& RecVal) const;
+    /// Get primary field value from JSon, normalized to string
+    TStr GetPrimaryStr(const PJsonVal& RecVal) const;
+    /// Check if record can be added as part of a batch. Records referring to existing
+    /// records, repeating primary field value from the batch or containing joins cannot.
+    bool IsBatchRec(const PJsonVal& RecVal, TStrSet& BatchPrimarySet) const;
+    /// Add batch of new records: serialization runs in parallel, indexing is grouped by key
+    void AddRecBatch(const TVec<PJsonVal>& BatchRecValV, TUInt64V& RecIdV, const bool& TriggerEvents);
+    /// Get id of the next added record
+    uint64 GetNextRecId() const;
+    /// Index records added while indexing was deferred
+    void IndexDeferredRecs();
+    /// Deindex records collected for deletion and clear their serialized values
+    void DeindexRecs(const TUInt64V& RecIdV, TVec<TMem>& CacheRecMemV, TVec<TMem>& MemRecMemV);
+    /// Are records partitioned into time segments
+    bool IsSegmented() const { return SegmentMSecs > 0; }
+    /// Add new record to the last time segment or start a new one
+    void AddSegmentRec(const uint64& RecId);
+    /// Extend time range of the segment with the record after its field was changed
+    void UpdateSegmentRec(const uint64& RecId, const int& FieldId);
+    /// Remove deleted records from time segments
+    void DelSegmentRecs();
+    /// Bring time segments up to date with records after loading (records added
+    /// or changed after the segments were saved come from write-ahead log)
+    void SyncSegmentV();
+    /// Load primary field map
+    void LoadPrimaryIdH(TSIn& SIn);
+    /// Save primary field map
+    void SavePrimaryIdH(TSOut& SOut) const;
+    /// True when primary field map can be restored from write-ahead log of in-memory
+    /// storage and is therefore saved only at checkpoints
+    bool IsPrimaryFieldLogged() const;
+    /// Load primary field map from last checkpoint and update it with logged records
+    void LoadPrimaryFieldLog();
+    /// Save primary field map and remove write-ahead log of in-memory storage
+    void Checkpoint();
     /// Set primary field map
     void SetPrimaryField(const uint64& RecId);
     /// Set primary field map for a given string value
@@ -987,6 +1202,7 @@ public:
     // need to override destructor, to clear cache
     ~TStoreImpl();
 
+    bool IsConcurrentRead() const { return true; }
     bool IsRecId(const uint64& RecId) const;
     bool HasRecNm() const { return RecNmFieldP; }
     bool IsRecNm(const TStr& RecNm) const;
@@ -1018,11 +1234,19 @@ public:
 
     /// Add new record
     uint64 AddRec(const PJsonVal& RecVal, const bool& TriggerEvents = true);
+    /// Add new records in a batch
+    void AddRecs(const TVec<PJsonVal>& RecValV, TUInt64V& RecIdV, const bool& TriggerEvents = true);
     /// Update existing record
     void UpdateRec(const uint64& RecId, const PJsonVal& RecVal);
+    /// Defer indexing of new records
+    void SetIndexingDeferred(const bool& DeferredP);
+    /// Is indexing of new records deferred
+    bool IsIndexingDeferred() const { return RecIndexer.IsDeferred(); }
 
     /// Purge records that fall out of store window (when it has one)
     void GarbageCollect(const int& MxTimeMSecs = -1);
+    /// Get time segments of records when store is partitioned over the time field
+    bool GetSegmentV(const int& TmFieldId, TStoreSegmentV& _SegmentV) const;
     /// Deletes all records
     void DeleteAllRecs();
     /// Delete the first DelRecs records (the records that were inserted first)
@@ -1139,6 +1363,9 @@ public:
     int PartialFlush(int WndInMsec = 500);
     /// Retrieve performance statistics for this store
     PJsonVal GetStats();
+    /// Get column with field values when field is kept in columnar store
+    const TFieldColumn* GetFieldColumn(const int& FieldId) const {
+        return IsFieldColumn(FieldId) ? &FieldColumnV[FieldId] : NULL; }
     /// Run verification for whole store
     void RunVerification();
     /// Run verification for single record
@@ -1195,6 +1422,9 @@ private:
     TBool DataMemP;
     /// Store for parts of records that should be in-memory
     PPgBlob DataMem;
+    /// Guards page loads for concurrent readers. Held while a field is decoded,
+    /// since the page buffer is only valid until the next page load.
+    mutable TCriticalSection PgBlobSection;
 
     /// Counter for record IDs
     TUInt64 RecIdCounter;
@@ -1279,6 +1509,8 @@ public:
 
     /// True when records have names (default is false)
     bool HasRecNm() const { return RecNmFieldP; }
+    /// Records can be read concurrently, page access is guarded
+    bool IsConcurrentRead() const { return true; }
     /// Check if given ID is valid
     bool IsRecId(const uint64& RecId) const;
     /// Check if record with given name exists
@@ -1561,7 +1793,10 @@ TWPt<TBase> NewBase(const TStr& FPath, const PJsonVal& SchemaVal, const uint64&
     const bool& InitP = true, const int& SplitLen = 1024, bool UsePaged = true);
 
 ///////////////////////////////
-/// Load base created from a schema definition
+/// Load base created from a schema definition. Base opened with faRdOnly
+/// can be shared between threads: queries (TBase::Search), field reads and
+/// record iteration can run concurrently. Other access modes still require
+/// callers to serialize writes.
 TWPt<TBase> LoadBase(const TStr& FPath, const TFAccess& FAccess, const uint64& IndexCacheSize,
     const uint64& StoreCacheSize,
     const TStrUInt64H& StoreNmCacheSizeH = TStrUInt64H(), const TStrUInt64H& IndexTypeCacheSizeH = TStrUInt64H(),
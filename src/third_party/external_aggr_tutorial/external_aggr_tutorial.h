@@ -138,6 +138,8 @@ public:
     bool IsInit() const { return true; }
     /// List of input aggregates
     void GetInAggrNmV(TStrV& InAggrNmV) const { InAggrNmV.Add(InAggr->GetAggrNm()); }
+    /// Input aggregates are listed in GetInAggrNmV
+    bool IsInAggrNmVDeclared() const { return true; }
 
 };
 
@@ -88,3 +88,167 @@ TEST(TLinAlgOperatorsDivide) {
         ASSERT_NEAR(DivV[RowN], FltV[RowN] / k, Tol);
     }
 }
+
+void InitFltVV(TFltVV& FltVV, TRnd& Rnd) {
+    for (int RowN = 0; RowN < FltVV.GetRows(); RowN++) {
+        for (int ColN = 0; ColN < FltVV.GetCols(); ColN++) {
+            FltVV(RowN, ColN) = Rnd.GetNrmDev();
+        }
+    }
+}
+
+void InitFltV(TFltV& FltV, TRnd& Rnd) {
+    for (int ValN = 0; ValN < FltV.Len(); ValN++) {
+        FltV[ValN] = Rnd.GetNrmDev();
+    }
+}
+
+TEST(TLinAlgKernelVectorOps) {
+    const TLinAlgKernel::TKernelType OrigKernelType = TLinAlgKernel::GetKernelType();
+    TRnd Rnd(1);
+    // lengths around the vector widths and unroll factors
+    const int LenV[] = { 0, 1, 3, 4, 7, 8, 15, 16, 17, 33, 101 };
+    for (int KernelType = 0; KernelType <= TLinAlgKernel::GetBestKernelType(); KernelType++) {
+        TLinAlgKernel::SetKernelType((TLinAlgKernel::TKernelType)KernelType);
+        for (const int Len : LenV) {
+            TFltV x(Len), y(Len); InitFltV(x, Rnd); InitFltV(y, Rnd);
+            double Dot = 0.0, Dist2 = 0.0;
+            for (int ValN = 0; ValN < Len; ValN++) {
+                Dot += x[ValN] * y[ValN]; Dist2 += TMath::Sqr(x[ValN] - y[ValN]);
+            }
+            ASSERT_NEAR(TLinAlg::DotProduct(x, y), Dot, Tol);
+            ASSERT_NEAR(TLinAlg::EuclDist2(x, y), Dist2, Tol);
+
+            TFltV z(Len); TLinAlg::LinComb(0.5, x, -2.0, y, z);
+            TFltV AddV = y; TLinAlg::AddVec(3.0, x, AddV);
+            TFltV ScaleV(Len); TLinAlg::MultiplyScalar(-1.5, x, ScaleV);
+            for (int ValN = 0; ValN < Len; ValN++) {
+                ASSERT_NEAR(z[ValN], (0.5 * x[ValN] - 2.0 * y[ValN]), Tol);
+                ASSERT_NEAR(AddV[ValN], (3.0 * x[ValN] + y[ValN]), Tol);
+                ASSERT_NEAR(ScaleV[ValN], (-1.5 * x[ValN]), Tol);
+            }
+
+            // sparse vector with every third index
+            TIntFltKdV SpV;
+            for (int ValN = 0; ValN < Len; ValN += 3) { SpV.Add(TIntFltKd(ValN, y[ValN])); }
+            double SpDot = 0.0;
+            for (int ElN = 0; ElN < SpV.Len(); ElN++) { SpDot += x[SpV[ElN].Key] * SpV[ElN].Dat; }
+            ASSERT_NEAR(TLinAlg::DotProduct(x, SpV), SpDot, Tol);
+        }
+    }
+    TLinAlgKernel::SetKernelType(OrigKernelType);
+}
+
+TEST(TLinAlgKernelMatrixOps) {
+    const TLinAlgKernel::TKernelType OrigKernelType = TLinAlgKernel::GetKernelType();
+    TRnd Rnd(1);
+    // odd sizes cover the fringes of the blocked multiplication
+    const int Rows = 67, Inner = 131, Cols = 45;
+    TFltVV A(Rows, Inner), B(Inner, Cols), At(Inner, Rows), Bt(Cols, Inner);
+    InitFltVV(A, Rnd); InitFltVV(B, Rnd);
+    TLinAlg::Transpose(A, At); TLinAlg::Transpose(B, Bt);
+    TFltVV Expected(Rows, Cols);
+    for (int RowN = 0; RowN < Rows; RowN++) {
+        for (int ColN = 0; ColN < Cols; ColN++) {
+            for (int ValN = 0; ValN < Inner; ValN++) {
+                Expected(RowN, ColN) += A(RowN, ValN) * B(ValN, ColN);
+            }
+        }
+    }
+    TFltV x(Inner), xt(Rows); InitFltV(x, Rnd); InitFltV(xt, Rnd);
+    TFltV Ax(Rows), Atxt(Inner);
+    for (int RowN = 0; RowN < Rows; RowN++) {
+        for (int ValN = 0; ValN < Inner; ValN++) {
+            Ax[RowN] += A(RowN, ValN) * x[ValN];
+            Atxt[ValN] += A(RowN, ValN) * xt[RowN];
+        }
+    }
+
+    for (int KernelType = 0; KernelType <= TLinAlgKernel::GetBestKernelType(); KernelType++) {
+        TLinAlgKernel::SetKernelType((TLinAlgKernel::TKernelType)KernelType);
+        // all combinations of transposed arguments
+        for (int TransA = 0; TransA < 2; TransA++) {
+            for (int TransB = 0; TransB < 2; TransB++) {
+                TFltVV C(Rows, Cols);
+                TLinAlg::Multiply(TransA ? At : A, TransB ? Bt : B, C,
+                    TransA ? TLinAlg::TLinAlgBlasTranspose::TRANS : TLinAlg::TLinAlgBlasTranspose::NOTRANS,
+                    TransB ? TLinAlg::TLinAlgBlasTranspose::TRANS : TLinAlg::TLinAlgBlasTranspose::NOTRANS);
+                for (int RowN = 0; RowN < Rows; RowN++) {
+                    for (int ColN = 0; ColN < Cols; ColN++) {
+                        ASSERT_NEAR(C(RowN, ColN), Expected(RowN, ColN), Tol);
+                    }
+                }
+            }
+        }
+        // C := A' * B with the transposed copy of A
+        TFltVV C(Rows, Cols); TLinAlg::MultiplyT(At, B, C);
+        // D := 2 * A * B - C
+        TFltVV D(Rows, Cols);
+        TLinAlg::Gemm(2.0, A, B, -1.0, C, D, TLinAlg::GEMM_NO_T);
+        for (int RowN = 0; RowN < Rows; RowN++) {
+            for (int ColN = 0; ColN < Cols; ColN++) {
+                ASSERT_NEAR(C(RowN, ColN), Expected(RowN, ColN), Tol);
+                ASSERT_NEAR(D(RowN, ColN), Expected(RowN, ColN), Tol);
+            }
+        }
+
+        TFltV y(Rows), yt(Inner);
+        TLinAlg::Multiply(A, x, y); TLinAlg::MultiplyT(A, xt, yt);
+        for (int RowN = 0; RowN < Rows; RowN++) { ASSERT_NEAR(y[RowN], Ax[RowN], Tol); }
+        for (int ValN = 0; ValN < Inner; ValN++) { ASSERT_NEAR(yt[ValN], Atxt[ValN], Tol); }
+        // y := 2 * A * x - y
+        TLinAlg::Multiply(A, x, y, TLinAlg::TLinAlgBlasTranspose::NOTRANS, 2.0, -1.0);
+        for (int RowN = 0; RowN < Rows; RowN++) { ASSERT_NEAR(y[RowN], Ax[RowN], Tol); }
+    }
+    TLinAlgKernel::SetKernelType(OrigKernelType);
+}
+
+TEST(TLinAlgKernelSparseOps) {
+    const TLinAlgKernel::TKernelType OrigKernelType = TLinAlgKernel::GetKernelType();
+    TRnd Rnd(1);
+    const int Rows = 23, Cols = 19, ColsB = 13;
+    // sparse column matrix with about a third of the elements
+    TVec<TIntFltKdV> SpA(Cols); TFltVV A(Rows, Cols);
+    for (int ColN = 0; ColN < Cols; ColN++) {
+        for (int RowN = 0; RowN < Rows; RowN++) {
+            if (Rnd.GetUniDevInt(3) == 0) {
+                A(RowN, ColN) = Rnd.GetNrmDev();
+                SpA[ColN].Add(TIntFltKd(RowN, A(RowN, ColN)));
+            }
+        }
+    }
+    TFltVV B(Cols, ColsB), Bt(Rows, ColsB), D(ColsB, Rows);
+    InitFltVV(B, Rnd); InitFltVV(Bt, Rnd); InitFltVV(D, Rnd);
+
+    for (int KernelType = 0; KernelType <= TLinAlgKernel::GetBestKernelType(); KernelType++) {
+        TLinAlgKernel::SetKernelType((TLinAlgKernel::TKernelType)KernelType);
+        TFltVV SpAB(Rows, ColsB), AB(Rows, ColsB);
+        TLinAlg::Multiply(SpA, B, SpAB, Rows); TLinAlg::Multiply(A, B, AB);
+        TFltVV SpAtB(Cols, ColsB), AtB(Cols, ColsB);
+        TLinAlg::MultiplyT(SpA, Bt, SpAtB); TLinAlg::MultiplyT(A, Bt, AtB);
+        TFltVV DSpA(ColsB, Cols), DA(ColsB, Cols);
+        TLinAlg::Multiply(D, SpA, DSpA); TLinAlg::Multiply(D, A, DA);
+        TFltVV BtSpA(ColsB, Cols), BtA(ColsB, Cols);
+        TLinAlg::MultiplyT(Bt, SpA, BtSpA); TLinAlg::MultiplyT(Bt, A, BtA);
+        for (int ValN = 0; ValN < SpAB.Get1DVec().Len(); ValN++) {
+            ASSERT_NEAR(SpAB.Get1DVec()[ValN], AB.Get1DVec()[ValN], Tol);
+        }
+        for (int ValN = 0; ValN < SpAtB.Get1DVec().Len(); ValN++) {
+            ASSERT_NEAR(SpAtB.Get1DVec()[ValN], AtB.Get1DVec()[ValN], Tol);
+        }
+        for (int ValN = 0; ValN < DSpA.Get1DVec().Len(); ValN++) {
+            ASSERT_NEAR(DSpA.Get1DVec()[ValN], DA.Get1DVec()[ValN], Tol);
+            ASSERT_NEAR(BtSpA.Get1DVec()[ValN], BtA.Get1DVec()[ValN], Tol);
+        }
+        // c := Bt' * b for a sparse column of A
+        TFltV c(ColsB), Expected(ColsB);
+        TLinAlg::MultiplyT(Bt, SpA[0], c);
+        for (int ElN = 0; ElN < SpA[0].Len(); ElN++) {
+            for (int ColN = 0; ColN < ColsB; ColN++) {
+                Expected[ColN] += Bt(SpA[0][ElN].Key, ColN) * SpA[0][ElN].Dat;
+            }
+        }
+        for (int ColN = 0; ColN < ColsB; ColN++) { ASSERT_NEAR(c[ColN], Expected[ColN], Tol); }
+    }
+    TLinAlgKernel::SetKernelType(OrigKernelType);
+}
@@ -13,4 +13,12 @@ TEST(TVecDelMemCpy) {
 
     ASSERT_EQ(14, Vec.Len());
     ASSERT_EQ(6, Vec[0]);
-}
\ No newline at end of file
+}
+
+TEST(TVecAddExt) {
+    TFlt ValT[3];
+    TFltV Vec; Vec.GenExt(ValT, 3);
+    // vector over external memory cannot grow
+    ASSERT_ANY_THROW(Vec.Add(1.0));
+    ASSERT_EQ(3, Vec.Len());
+}
@@ -19,7 +19,7 @@ describe("Kmeans test", function () {
         it("should return empty parameter values", function () {
             var KMeans = new analytics.KMeans();
             var params = KMeans.getParams();
-            assert.equal(Object.keys(params).length, 7);
+            assert.equal(Object.keys(params).length, 9);
         });
         it("should return parameter values", function () {
             var KMeans = new analytics.KMeans({ iter: 100, k: 2, verbose: false });
@@ -1066,6 +1066,29 @@ describe("Kmeans test", function () {
             assert.equal(denseKMeans.centroids.minus(expectedC).frob(), 0);
         })
 
+        it('should identify the same dense centroids with multiple threads', function () {
+            var expectedC = new la.Matrix([
+                [ 2.2, 7 ],
+                [ 3, 2.25 ]
+            ])
+
+            var denseKMeans = new analytics.KMeans({ k: 2, threads: 4, fitStart: { C: C } });
+            assert.equal(denseKMeans.getParams().threads, 4);
+            denseKMeans.fit(X);
+            assert(denseKMeans.centroids.minus(expectedC).frob() < 1e-12);
+
+            var sparseX = X.sparse();
+            var sparseKMeans = new analytics.KMeans({ k: 2, threads: 3, fitStart: { C: C } });
+            sparseKMeans.fit(sparseX);
+            assert(sparseKMeans.centroids.minus(expectedC).frob() < 1e-12);
+        })
+
+        it('should throw for a non-positive number of threads', function () {
+            assert.throws(function () {
+                new analytics.KMeans({ k: 2, threads: 0 });
+            });
+        })
+
         it('should identify correct sparse centroids', function () {
             var sparseKMeans = new analytics.KMeans({ k: 2, centroidType: 'Sparse', calcDistQual: true, fitStart: { C: C } });
             var expectedC = new la.SparseMatrix([
@@ -1159,6 +1182,61 @@ describe("Kmeans test", function () {
 
     })
 
+    describe('PartialFit Tests', function () {
+        it('should use the first examples as centroids', function () {
+            var KMeans = new analytics.KMeans({ k: 3 });
+            var X = new la.Matrix([[1, -2, -1], [1, 1, -3]]);
+            KMeans.partialFit(X);
+            assert.equal(KMeans.centroids.minus(X).frob(), 0);
+            assert.deepEqual(KMeans.idxv.toArray(), [0, 1, 2]);
+        })
+        it('should move the closest centroid to the mean of its examples', function () {
+            var KMeans = new analytics.KMeans({ k: 2 });
+            KMeans.partialFit(new la.Matrix([[0, 10], [0, 10]]));
+            KMeans.partialFit(new la.Matrix([[2, 12], [0, 8]]));
+            assert.deepEqual(KMeans.idxv.toArray(), [0, 1]);
+            var expectedC = new la.Matrix([[1, 11], [0, 9]]);
+            assert(KMeans.centroids.minus(expectedC).frob() < 1e-12);
+            // predict uses the updated centroids
+            assert.deepEqual(KMeans.predict(new la.Matrix([[-1, 9], [1, 9]])).toArray(), [0, 1]);
+        })
+        it('should forget old examples with decay', function () {
+            var KMeans = new analytics.KMeans({ k: 1, decay: 0.5 });
+            assert.equal(KMeans.getParams().decay, 0.5);
+            KMeans.partialFit(new la.Matrix([[0]]));
+            KMeans.partialFit(new la.Matrix([[3]]));
+            // the count of 1 decays to 0.5, the new example weighs 1 / 1.5
+            assert(Math.abs(KMeans.centroids.at(0, 0) - 2) < 1e-12);
+        })
+        it('should update sparse centroids with sparse examples', function () {
+            var KMeans = new analytics.KMeans({ k: 2, centroidType: 'Sparse' });
+            KMeans.partialFit(new la.SparseMatrix([[[0, 1]], [[1, 1]]]));
+            KMeans.partialFit(new la.SparseMatrix([[[0, 3]], [[1, 3], [2, 2]]]));
+            var expectedC = new la.Matrix([[2, 0], [0, 2], [0, 1]]);
+            assert(KMeans.centroids.full().minus(expectedC).frob() < 1e-12);
+        })
+        it('should throw for a decay outside (0, 1]', function () {
+            assert.throws(function () {
+                new analytics.KMeans({ k: 2, decay: 0 });
+            });
+            assert.throws(function () {
+                new analytics.KMeans({ k: 2, decay: 1.5 });
+            });
+        })
+        it('should continue after serialization', function () {
+            var KMeans = new analytics.KMeans({ k: 2, decay: 0.9 });
+            KMeans.partialFit(new la.Matrix([[0, 10], [0, 10]]));
+            var fout = require('qminer').fs.openWrite('kmeans_partial_test.bin');
+            KMeans.save(fout); fout.close();
+            var KMeans2 = new analytics.KMeans(require('qminer').fs.openRead('kmeans_partial_test.bin'));
+            assert.equal(KMeans2.getParams().decay, 0.9);
+            var X = new la.Matrix([[1, 9], [1, 9]]);
+            KMeans.partialFit(X);
+            KMeans2.partialFit(X);
+            assert.equal(KMeans.centroids.minus(KMeans2.centroids).frob(), 0);
+        })
+    });
+
     describe('Serialization Tests', function () {
         it('should serialize and deserialize', function () {
             var KMeans = new analytics.KMeans({ k: 3 });
@@ -1242,6 +1320,29 @@ describe("DpMeans test", function () {
                 assert.equal(assignV[i], expectedAssignV[i]);
             }
         })
+
+        it('DpMeans should compute the same assignment with multiple threads', function () {
+            var initC = new la.Matrix([
+                [ 1.2, 5, 9.3 ],
+                [ 1, 7.5, 4.2 ]
+            ])
+            var dpmeans = new analytics.DpMeans({
+                lambda: 2,
+                allowEmpty: false,
+                threads: 4,
+                fitStart: { C: initC }
+            })
+
+            var expectedAssignV = new la.IntVector([0, 0, 0, 0, 1, 1, 2, 2]);
+
+            dpmeans.fit(X);
+
+            var assignV = dpmeans.idxv;
+
+            for (var i = 0; i < expectedAssignV.length; i++) {
+                assert.equal(assignV[i], expectedAssignV[i]);
+            }
+        })
     })
 
     describe('testing quality measure', function () {
@@ -1932,3 +1932,58 @@ describe('Feature Space Tests', function () {
         })
     });
 })
+
+describe('Parallel Feature Extraction Tests', function () {
+    var base = undefined;
+    var store = undefined;
+    var ftrDef = [
+        { type: 'text', source: 'Doc', field: 'Text', tokenizer: { type: 'simple' } },
+        { type: 'text', source: 'Doc', field: 'Text', hashDimension: 64, tokenizer: { type: 'simple' } },
+        { type: 'categorical', source: 'Doc', field: 'Category' },
+        { type: 'numeric', source: 'Doc', field: 'Value', normalize: true }
+    ];
+    beforeEach(function () {
+        base = new qm.Base({
+            mode: 'createClean',
+            schema: [{
+                name: 'Doc',
+                fields: [
+                    { name: 'Text', type: 'string' },
+                    { name: 'Category', type: 'string' },
+                    { name: 'Value', type: 'float' }
+                ]
+            }]
+        });
+        store = base.store('Doc');
+        for (var i = 0; i < 3000; i++) {
+            store.push({ Text: 'word' + i + ' common w' + (i % 17), Category: 'c' + (i % 7), Value: i % 100 });
+        }
+    });
+    afterEach(function () {
+        base.close();
+    });
+
+    it('should build the same vocabulary with several threads', function () {
+        var ftr = new qm.FeatureSpace(base, ftrDef);
+        ftr.updateRecords(store.allRecords);
+        base.setQueryThreads(3);
+        var parFtr = new qm.FeatureSpace(base, ftrDef);
+        parFtr.updateRecords(store.allRecords);
+        assert.equal(parFtr.dim, ftr.dim);
+        for (var i = 0; i < ftr.dim; i += 97) {
+            assert.equal(parFtr.getFeature(i), ftr.getFeature(i));
+        }
+    })
+    it('should extract the same matrices with several threads', function () {
+        var ftr = new qm.FeatureSpace(base, ftrDef);
+        ftr.updateRecords(store.allRecords);
+        var spMat = ftr.extractSparseMatrix(store.allRecords);
+        var mat = ftr.extractMatrix(store.allRecords, 2);
+        base.setQueryThreads(3);
+        var parSpMat = ftr.extractSparseMatrix(store.allRecords);
+        var parMat = ftr.extractMatrix(store.allRecords, 2);
+        assert.equal(parSpMat.cols, 3000);
+        assert.eqtol(spMat.minus(parSpMat).frob(), 0);
+        assert.eqtol(mat.minus(parMat).frob(), 0);
+    })
+});
@@ -561,6 +561,46 @@ describe('Vector Tests', function () {
                 }
             })
         });
+
+        describe('AsFloat64Array Test', function () {
+            it('should share values of the vector with the returned array', function () {
+                var vec = new la.Vector([1, 2, 3]);
+                var arr = vec.asFloat64Array();
+                assert.ok(arr instanceof Float64Array);
+                assert.equal(arr.length, 3);
+                assert.equal(arr[2], 3);
+                arr[0] = 10;
+                assert.equal(vec[0], 10);
+                vec.put(1, -2);
+                assert.equal(arr[1], -2);
+                // the second view uses the same memory
+                assert.equal(vec.asFloat64Array().buffer, arr.buffer);
+            })
+            it('should adopt the memory of a Float64Array', function () {
+                var arr = new Float64Array([1, 2, 3, 4]);
+                var vec = new la.Vector(arr);
+                assert.equal(vec.length, 4);
+                assert.equal(vec[3], 4);
+                vec[0] = 5;
+                assert.equal(arr[0], 5);
+                arr[1] = 6;
+                assert.equal(vec.sum(), 5 + 6 + 3 + 4);
+            })
+            it('should stop sharing when the vector changes its length', function () {
+                var vec = new la.Vector([1, 2, 3]);
+                var arr = vec.asFloat64Array();
+                vec.push(4);
+                assert.equal(vec.length, 4);
+                vec[0] = 10;
+                assert.equal(arr[0], 1);
+                assert.equal(arr.length, 3);
+                // a new view shares the new values
+                var arr2 = vec.asFloat64Array();
+                assert.equal(arr2.length, 4);
+                arr2[3] = 7;
+                assert.equal(vec[3], 7);
+            })
+        });
     });
 });
 
@@ -1541,6 +1581,37 @@ describe('Matrix Test', function () {
                 }
             })
         });
+
+        describe('AsFloat64Array Test', function () {
+            it('should share elements of the matrix in row major order', function () {
+                var mat = new la.Matrix([[1, 2], [3, 4], [5, 6]]);
+                var arr = mat.asFloat64Array();
+                assert.equal(arr.length, 6);
+                assert.equal(arr[1], 2);
+                assert.equal(arr[2], 3);
+                arr[5] = -6;
+                assert.equal(mat.at(2, 1), -6);
+                mat.put(0, 0, 7);
+                assert.equal(arr[0], 7);
+            })
+            it('should adopt the memory of a Float64Array', function () {
+                var arr = new Float64Array([1, 2, 3, 4, 5, 6]);
+                var mat = new la.Matrix({ rows: 2, cols: 3, data: arr });
+                assert.equal(mat.rows, 2);
+                assert.equal(mat.cols, 3);
+                assert.equal(mat.at(1, 0), 4);
+                arr[4] = 10;
+                assert.equal(mat.at(1, 1), 10);
+                mat.put(0, 2, -3);
+                assert.equal(arr[2], -3);
+                assert.eqtol(mat.frob(), Math.sqrt(1 + 4 + 9 + 16 + 100 + 36));
+            })
+            it('should throw an exception for data of wrong length', function () {
+                assert.throws(function () {
+                    var mat = new la.Matrix({ rows: 2, cols: 2, data: new Float64Array(3) });
+                })
+            })
+        });
     });
 });
 
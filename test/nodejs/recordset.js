@@ -336,6 +336,12 @@ describe('Record Set Tests', function () {
                 recSet.sortByField();
             })
         })
+        it('should sort records with equal values by their ids', function () {
+            recSet5.sortByField("Tm", 1);
+            assert.deepEqual(recSet5.map(function (rec) { return rec.$id; }), [0, 1, 2, 3]);
+            recSet5.sortByField("Tm", -1);
+            assert.deepEqual(recSet5.map(function (rec) { return rec.$id; }), [3, 2, 1, 0]);
+        })
     });
 
     describe('Sort Tests', function () {
@@ -467,6 +473,11 @@ describe('Record Set Tests', function () {
                 recSet.filterByField(5.5, 5.7);
             })
         })
+        it('should handle request - sfloat', function () {
+            recSet5.filterByField("Id11", 4, 6);
+            assert.equal(recSet5.length, 1);
+            assert.equal(recSet5[0].Name, "Marko Aznur");
+        })
     });
 
     describe('Filter Tests', function () {
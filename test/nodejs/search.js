@@ -800,6 +800,12 @@ describe('Gix Tests', function () {
                 joins: [ ],
                 keys: [ { field: 'Value', type: 'value', storage: 'tiny' } ]
             });
+            var storePacked = base.createStore({
+                name: 'TestStorePacked',
+                fields: [ { 'name': 'Value', 'type': 'string' } ],
+                joins: [ ],
+                keys: [ { field: 'Value', type: 'value', storage: 'packed' } ]
+            });
         })
         it('create stores with bad parameters for value index key', function () {
             assert.throws(function() {
@@ -868,6 +874,16 @@ describe('Gix Tests', function () {
                 fields: [ { name: 'Value', type: 'string' } ],
                 keys: [ ]
             }]);
+            base.createStore([{
+                name: 'TestStorePacked1',
+                fields: [ { name: 'Value', type: 'string' } ],
+                joins: [ { name: 'Join', type: 'index', store: 'TestStore2', storage: 'packed' } ],
+                keys: [ ]
+            }, {
+                name: 'TestStorePacked2',
+                fields: [ { name: 'Value', type: 'string' } ],
+                keys: [ ]
+            }]);
         })
         it('create stores with field join', function () {
             base.createStore([{
@@ -1115,6 +1131,110 @@ describe('Gix Tests', function () {
                     Count: { $gt: 6 }
                 }).length, 0);
             })
+            it('should return correct records for and query over long posting lists', function () {
+                var store = base.createStore({
+                    name: 'TestStore',
+                    fields: [
+                        { 'name': 'Value', 'type': 'string' },
+                        { 'name': 'Tags', 'type': 'string_v' }
+                    ],
+                    joins: [ ],
+                    keys: [
+                        { field: 'Value', type: 'value', storage: gixType },
+                        { field: 'Tags', type: 'value', storage: gixType }
+                    ]
+                });
+                // rare values are clustered, frequent ones spread over all child vectors
+                for (var i = 0; i < 10000; i++) {
+                    var value = (i >= 6000 && i < 6100) || i % 1000 == 0 ? "R" : "F";
+                    store.push({ Value: value, Tags: ["t" + (i % 3), "u" + (i % 7)] });
+                }
+                store.clear(500);
+                function count(filter) {
+                    var res = 0;
+                    for (var i = 500; i < 10000; i++) {
+                        var value = (i >= 6000 && i < 6100) || i % 1000 == 0 ? "R" : "F";
+                        if (filter(value, i % 3, i % 7)) { res++; }
+                    }
+                    return res;
+                }
+                var res1 = base.search({ $from: "TestStore", Tags: "t1", Value: "R" });
+                assert.equal(res1.length, count(function (v, t, u) { return v == "R" && t == 1; }));
+                for (var i = 1; i < res1.length; i++) { assert.ok(res1[i - 1].$id < res1[i].$id); }
+                var res2 = base.search({ $from: "TestStore", Tags: ["t2", "u3"], Value: "R" });
+                assert.equal(res2.length, count(function (v, t, u) { return v == "R" && t == 2 && u == 3; }));
+                var res3 = base.search({ $from: "TestStore", Tags: "t0", Value: { $ne: "R" } });
+                assert.equal(res3.length, count(function (v, t, u) { return v != "R" && t == 0; }));
+            })
+            it('should return top records by relevance', function () {
+                var store = base.createStore({
+                    name: 'TestStore',
+                    fields: [ { 'name': 'Tags', 'type': 'string_v' } ],
+                    joins: [ ],
+                    keys: [ { field: 'Tags', type: 'value', storage: gixType } ]
+                });
+                for (var i = 0; i < 5000; i++) {
+                    var tags = ["a"];
+                    // every 100th record has tag "b1", some of them twice
+                    if (i % 100 == 0) { tags.push("b1"); if (i % 300 == 0) { tags.push("b1"); } }
+                    if (i % 7 == 0) { tags.push("c1"); }
+                    store.push({ Tags: tags });
+                }
+                // any of the matched words, records with both "b1" and "c1" are more relevant
+                var res1 = base.search({ $from: "TestStore", Tags: { $wc: "?1" }, $sort: "relevance", $limit: 3 });
+                assert.equal(res1.length, 3);
+                for (var i = 0; i < res1.length; i++) {
+                    assert.equal(res1[i].$id % 700, 0);
+                }
+                // all words required, results must match full search sorted by relevance
+                var res2 = base.search({ $from: "TestStore", Tags: "b1", $sort: "relevance", $limit: 10, $offset: 5 });
+                var res3 = base.search({ $from: "TestStore", Tags: "b1", $sort: "relevance" });
+                assert.equal(res2.length, 10);
+                assert.equal(res3.length, 50);
+                for (var i = 0; i < res2.length; i++) {
+                    assert.equal(res2[i].$fq, res3[i + 5].$fq);
+                }
+                assert.throws(function () {
+                    base.search({ $from: "TestStore", Tags: "b1", $sort: "random", $limit: 10 });
+                });
+            })
+            it('should return top records as a prefix of the full relevance ranking', function () {
+                var store = base.createStore({
+                    name: 'TestStore',
+                    fields: [ { 'name': 'Tags', 'type': 'string_v' } ],
+                    joins: [ ],
+                    keys: [ { field: 'Tags', type: 'value', storage: gixType } ]
+                });
+                // few distinct tag combinations, so most records tie on score
+                for (var i = 0; i < 3000; i++) {
+                    var tags = ["x" + (i % 3)];
+                    if (i % 5 == 0) { tags.push("y1"); }
+                    if (i % 11 == 0) { tags.push("x" + (i % 3)); }
+                    store.push({ Tags: tags });
+                }
+                var queries = [
+                    { $from: "TestStore", Tags: "x1", $sort: "relevance" },
+                    { $from: "TestStore", Tags: ["x1", "y1"], $sort: "relevance" },
+                    { $from: "TestStore", Tags: { $wc: "x*" }, $sort: "relevance" },
+                    { $from: "TestStore", Tags: { $wc: "?1" }, $sort: "relevance" }
+                ];
+                for (var q = 0; q < queries.length; q++) {
+                    var full = base.search(queries[q]);
+                    assert(full.length > 0);
+                    for (var offset = 0; offset < 40; offset += 13) {
+                        var top = base.search(Object.assign({ $limit: 20, $offset: offset }, queries[q]));
+                        assert.equal(top.length, 20);
+                        for (var i = 0; i < top.length; i++) {
+                            assert.equal(top[i].$id, full[i + offset].$id);
+                        }
+                    }
+                }
+                // with a single word, records with equal frequency tie and are ordered by record id
+                var ranked = base.search(queries[0]);
+                for (var i = 1; i < ranked.length; i++) {
+                    assert(ranked[i].$fq < ranked[i - 1].$fq || ranked[i].$id > ranked[i - 1].$id);
+                }
+            })
             it('should return correct number of records for join query', function () {
                 prepareJoinStore1();
                 assert.equal(base.store("TestStore1").length, 10);
@@ -1227,6 +1347,7 @@ describe('Gix Tests', function () {
     testGixSearch("full");
     testGixSearch("small");
     testGixSearch("tiny");
+    testGixSearch("packed");
 
     function testGixFrequency1(gixType) {
         function prepareJoinStore() {
@@ -1688,3 +1809,569 @@ describe('Gix Position Tests', function () {
 
     });
 });
+
+describe('Concurrent search tests', function () {
+    beforeEach(function () {
+        qm.delLock();
+        var base = new qm.Base({ mode: 'createClean' });
+        base.createStore({
+            name: 'TestStore',
+            fields: [
+                { name: 'Name', type: 'string', primary: true },
+                { name: 'Category', type: 'string' },
+                { name: 'Value', type: 'int' }
+            ],
+            keys: [
+                { field: 'Category', type: 'value' },
+                { field: 'Value', type: 'linear' }
+            ]
+        });
+        var store = base.store('TestStore');
+        for (var i = 0; i < 1000; i++) {
+            store.push({ Name: 'rec' + i, Category: 'cat' + (i % 10), Value: i % 100 });
+        }
+        base.close();
+    });
+
+    it('should return same results as search when running in parallel', function (done) {
+        var base = new qm.Base({ mode: 'openReadOnly' });
+        var queries = [];
+        for (var i = 0; i < 10; i++) {
+            queries.push({ $from: 'TestStore', Category: 'cat' + i });
+            queries.push({ $from: 'TestStore', Value: { $gt: i * 10, $lt: i * 10 + 4 } });
+        }
+        var pending = queries.length;
+        queries.forEach(function (query) {
+            var expected = base.search(query);
+            base.searchAsync(query, function (err, rs) {
+                try {
+                    assert.equal(err, null);
+                    assert.equal(rs.length, expected.length);
+                    for (var i = 0; i < rs.length; i++) {
+                        assert.equal(rs[i].Name, expected[i].Name);
+                    }
+                    if (--pending == 0) { base.close(); done(); }
+                } catch (e) {
+                    base.close(); done(e);
+                }
+            });
+        });
+    });
+
+    it('should reject searchAsync on writable base', function () {
+        var base = new qm.Base({ mode: 'open' });
+        assert.throws(function () {
+            base.searchAsync({ $from: 'TestStore', Category: 'cat0' }, function () { });
+        });
+        base.close();
+    });
+});
+
+describe('Value vocabulary range and wildcard tests', function () {
+    var base = undefined;
+    var store = undefined;
+    // enough distinct values to use sorted vocabulary
+    var values = [];
+    for (var i = 0; i < 3000; i++) { values.push("v" + ((i * 7919) % 3000)); }
+
+    beforeEach(function () {
+        base = new qm.Base({ mode: 'createClean' });
+        store = base.createStore({
+            name: 'VocStore',
+            fields: [
+                { name: 'Str', type: 'string' },
+                { name: 'Num', type: 'string' }
+            ],
+            joins: [],
+            keys: [
+                { field: 'Str', type: 'value', sort: 'string' },
+                { field: 'Num', type: 'value', sort: 'number' }
+            ]
+        });
+        for (var i = 0; i < values.length; i++) {
+            store.push({ Str: values[i], Num: values[i].substr(1) });
+        }
+    });
+    afterEach(function () {
+        base.close();
+    });
+
+    it('should return values lexicographically greater or less', function () {
+        var greater = 0, less = 0;
+        for (var i = 0; i < values.length; i++) {
+            if (values[i] > "v1500") { greater++; }
+            if (values[i] < "v1500") { less++; }
+        }
+        assert.equal(base.search({ $from: 'VocStore', Str: { $gt: "v1500" } }).length, greater);
+        assert.equal(base.search({ $from: 'VocStore', Str: { $lt: "v1500" } }).length, less);
+        // values added after the first query
+        store.push({ Str: "v15000", Num: "15000" });
+        assert.equal(base.search({ $from: 'VocStore', Str: { $gt: "v1500" } }).length, greater + 1);
+    })
+    it('should return values numerically greater or less', function () {
+        assert.equal(base.search({ $from: 'VocStore', Num: { $gt: "1500" } }).length, 1499);
+        assert.equal(base.search({ $from: 'VocStore', Num: { $lt: "1500" } }).length, 1500);
+        store.push({ Str: "v-1", Num: "-1" });
+        assert.equal(base.search({ $from: 'VocStore', Num: { $lt: "1500" } }).length, 1501);
+    })
+    it('should return values matching prefix wildcard', function () {
+        // v12, v120-v129 and v1200-v1299
+        assert.equal(base.search({ $from: 'VocStore', Str: { $wc: "v12*" } }).length, 111);
+        assert.equal(base.search({ $from: 'VocStore', Str: { $wc: "v12?" } }).length, 10);
+        assert.equal(base.search({ $from: 'VocStore', Str: { $wc: "*99" } }).length, 30);
+    })
+});
+
+describe('BTree Paged Search Tests', function () {
+    var base = undefined;
+
+    beforeEach(function () {
+        base = new qm.Base({ mode: 'createClean' });
+        base.createStore({
+            name: 'BTreePagedTest',
+            fields: [
+                { name: 'Value', type: 'int' },
+                { name: 'Time', type: 'datetime' }
+            ],
+            joins: [],
+            keys: [
+                { field: 'Value', type: 'linear', storage: 'paged' },
+                { field: 'Time', type: 'linear', storage: 'paged' }
+            ]
+        });
+        var store = base.store('BTreePagedTest');
+        for (var i = 0; i < 10000; i++) {
+            store.push({ Value: i % 100, Time: new Date(Date.UTC(2015, 0, 1, 0, 0, i)).toISOString() });
+        }
+    });
+    afterEach(function () {
+        base.close();
+    });
+
+    it('should return ranges', function () {
+        assert.equal(base.search({ $from: 'BTreePagedTest', Value: { $gt: 5, $lt: 6 } }).length, 200);
+        assert.equal(base.search({ $from: 'BTreePagedTest', Value: { $gt: 90 } }).length, 900);
+        var result = base.search({ $from: 'BTreePagedTest', Time: { $lt: '2015-01-01T00:00:09.000Z' } });
+        assert.equal(result.length, 10);
+    })
+    it('should return ranges after delete and reopen', function () {
+        base.store('BTreePagedTest').clear(5000);
+        assert.equal(base.search({ $from: 'BTreePagedTest', Value: { $gt: 5, $lt: 6 } }).length, 100);
+        base.partialFlush();
+        base.close();
+        base = new qm.Base({ mode: 'open' });
+        assert.equal(base.search({ $from: 'BTreePagedTest', Value: { $gt: 5, $lt: 6 } }).length, 100);
+        base.store('BTreePagedTest').push({ Value: 5, Time: '2016-01-01T00:00:00.000Z' });
+        base.close();
+        base = new qm.Base({ mode: 'openReadOnly' });
+        assert.equal(base.search({ $from: 'BTreePagedTest', Value: { $gt: 5, $lt: 6 } }).length, 101);
+    })
+    it('should reject paged storage for value keys', function () {
+        assert.throws(function () {
+            base.createStore({
+                name: 'BTreePagedWrong',
+                fields: [{ name: 'Name', type: 'string' }],
+                keys: [{ field: 'Name', type: 'value', storage: 'paged' }]
+            });
+        });
+    })
+});
+
+describe('Negation and Dense Merge Search Tests', function () {
+    this.timeout(60000);
+    var base = undefined;
+    var recs = 140000;
+
+    before(function () {
+        base = new qm.Base({ mode: 'createClean' });
+        base.createStore({
+            name: 'DenseTest',
+            fields: [
+                { name: 'Category', type: 'string' },
+                { name: 'Parity', type: 'string' }
+            ],
+            joins: [],
+            keys: [
+                { field: 'Category', type: 'value' },
+                { field: 'Parity', type: 'value' }
+            ]
+        });
+        var store = base.store('DenseTest');
+        for (var i = 0; i < recs; i++) {
+            store.push({ Category: 'c' + (i % 3), Parity: (i % 2 == 0) ? 'even' : 'odd' });
+        }
+        // deleted records should not appear in the complement
+        store.clear(1000);
+    });
+    after(function () {
+        base.close();
+    });
+
+    function count(filter) {
+        var res = 0;
+        for (var i = 1000; i < recs; i++) { if (filter(i)) { res++; } }
+        return res;
+    }
+
+    it('should return complement of category', function () {
+        var result = base.search({ $from: 'DenseTest', Category: { $ne: 'c0' } });
+        assert.equal(result.length, count(function (i) { return i % 3 != 0; }));
+        assert.equal(result[0].$id, 1000);
+    })
+    it('should return only the limited part of the complement', function () {
+        var result = base.search({ $from: 'DenseTest', Category: { $ne: 'c0' }, $limit: 4, $offset: 2 });
+        assert.equal(result.length, 4);
+        assert.deepEqual(result.map(function (rec) { return rec.$id; }), [1003, 1004, 1006, 1007]);
+    })
+    it('should combine large sets with and, or and not', function () {
+        assert.equal(base.search({ $from: 'DenseTest', Category: { $ne: 'c0' }, Parity: { $ne: 'odd' } }).length,
+            count(function (i) { return i % 3 != 0 && i % 2 == 0; }));
+        assert.equal(base.search({ $from: 'DenseTest', Category: { $ne: 'c1' }, Parity: 'odd' }).length,
+            count(function (i) { return i % 3 != 1 && i % 2 == 1; }));
+        assert.equal(base.search({ $from: 'DenseTest', $or: [{ Category: 'c1' }, { Parity: 'even' }] }).length,
+            count(function (i) { return i % 3 == 1 || i % 2 == 0; }));
+        assert.equal(base.search({ $from: 'DenseTest', $or: [{ Category: { $ne: 'c1' } }, { Parity: 'even' }] }).length,
+            count(function (i) { return i % 3 != 1 || i % 2 == 0; }));
+        assert.equal(base.search({ $from: 'DenseTest', $not: { $or: [{ Category: 'c1' }, { Parity: 'even' }] } }).length,
+            count(function (i) { return !(i % 3 == 1 || i % 2 == 0); }));
+    })
+});
+
+describe('Query Cache Tests', function () {
+    var base = undefined;
+
+    beforeEach(function () {
+        base = new qm.Base({ mode: 'createClean' });
+        base.createStore({
+            name: 'CacheTest',
+            fields: [
+                { name: 'Category', type: 'string' },
+                { name: 'Value', type: 'int' }
+            ],
+            joins: [
+                { name: 'next', type: 'index', store: 'CacheTest' }
+            ],
+            keys: [
+                { field: 'Category', type: 'value' },
+                { field: 'Value', type: 'linear' }
+            ]
+        });
+        var store = base.store('CacheTest');
+        for (var i = 0; i < 1000; i++) {
+            store.push({ Category: 'c' + (i % 4), Value: i % 100 });
+        }
+    });
+    afterEach(function () {
+        base.close();
+    });
+
+    it('should be disabled by default', function () {
+        base.search({ $from: 'CacheTest', Category: 'c1' });
+        var stats = base.getQueryCacheStats();
+        assert.equal(stats.hits, 0);
+        assert.equal(stats.misses, 0);
+    })
+    it('should answer repeated queries from the cache', function () {
+        base.setQueryCache(1024 * 1024);
+        var query = { $from: 'CacheTest', Category: 'c1', Value: { $gt: 10, $lt: 19 } };
+        assert.equal(base.search(query).length, 20);
+        var misses = base.getQueryCacheStats().misses;
+        // order of conditions does not matter
+        assert.equal(base.search({ $from: 'CacheTest', Value: { $gt: 10, $lt: 19 }, Category: 'c1' }).length, 20);
+        var stats = base.getQueryCacheStats();
+        assert.equal(stats.hits, 1);
+        assert.equal(stats.misses, misses);
+        assert(stats.items > 0);
+        assert(stats.memUsed > 0 && stats.memUsed <= stats.maxMemUsed);
+    })
+    it('should not change cached results when sorting', function () {
+        base.setQueryCache(1024 * 1024);
+        var query = { $from: 'CacheTest', Category: 'c1' };
+        var rs = base.search(query);
+        rs.sortByField('Value', false);
+        var first = base.search(query);
+        assert.equal(first[0].$id, 1);
+    })
+    it('should invalidate results when store changes', function () {
+        base.setQueryCache(1024 * 1024);
+        var store = base.store('CacheTest');
+        var query = { $from: 'CacheTest', Category: 'c1', Value: { $gt: 10, $lt: 19 } };
+        assert.equal(base.search(query).length, 20);
+        store.push({ Category: 'c1', Value: 15 });
+        assert.equal(base.search(query).length, 21);
+        store.last.Value = 50;
+        assert.equal(base.search(query).length, 20);
+        store.clear(500);
+        assert.equal(base.search(query).length, 10);
+        assert.equal(base.search({ $from: 'CacheTest', Category: { $ne: 'c1' } }).length, 375);
+    })
+    it('should stay within memory limit', function () {
+        base.setQueryCache(4096);
+        for (var i = 0; i < 100; i++) {
+            base.search({ $from: 'CacheTest', Value: i });
+        }
+        var stats = base.getQueryCacheStats();
+        assert(stats.memUsed <= 4096);
+        base.setQueryCache(0);
+        assert.equal(base.getQueryCacheStats().maxMemUsed, 0);
+    })
+    it('should not cache sampled joins', function () {
+        var store = base.store('CacheTest');
+        for (var i = 0; i + 1 < store.length; i++) {
+            store[i].$addJoin('next', i + 1);
+        }
+        base.setQueryCache(1024 * 1024);
+        var subquery = { $from: 'CacheTest', Value: { $lt: 50 } };
+        // joins without a sample are cached
+        assert.equal(base.search({ $join: { $name: 'next', $query: subquery } }).length, 500);
+        var stats = base.getQueryCacheStats();
+        // sampled join only takes its sub-query from the cache
+        var query = { $join: { $name: 'next', $query: subquery, $sample: 10 } };
+        for (var i = 0; i < 2; i++) {
+            assert.equal(base.search(query).length, 10);
+        }
+        var stats2 = base.getQueryCacheStats();
+        assert.equal(stats2.hits, stats.hits + 2);
+        assert.equal(stats2.misses, stats.misses);
+        assert.equal(stats2.items, stats.items);
+    })
+});
+
+describe('Parallel Search Tests', function () {
+    var base = undefined;
+
+    beforeEach(function () {
+        base = new qm.Base({
+            mode: 'createClean',
+            schema: [{
+                name: 'Person',
+                fields: [{ name: 'Group', type: 'string' }],
+                joins: [{ name: 'docs', type: 'index', store: 'Doc', inverse: 'author' }],
+                keys: [{ field: 'Group', type: 'value' }]
+            }, {
+                name: 'Doc',
+                fields: [
+                    { name: 'Category', type: 'string' },
+                    { name: 'Value', type: 'int' }
+                ],
+                joins: [{ name: 'author', type: 'field', store: 'Person', inverse: 'docs' }],
+                keys: [
+                    { field: 'Category', type: 'value' },
+                    { field: 'Value', type: 'linear' }
+                ]
+            }]
+        });
+        var people = base.store('Person');
+        for (var i = 0; i < 100; i++) {
+            people.push({ Group: 'g' + (i % 7) });
+        }
+        var docs = base.store('Doc');
+        for (var i = 0; i < 2000; i++) {
+            var id = docs.push({ Category: 'c' + (i % 5), Value: i % 100 });
+            docs[id].$addJoin('author', (i * 37) % 100);
+        }
+    });
+    afterEach(function () {
+        base.close();
+    });
+
+    // record ids and weights of the result
+    function getResult(rs) {
+        var res = [];
+        rs.each(function (rec) { res.push(rec.$id + ':' + rec.$fq); });
+        return res.sort();
+    }
+
+    var queries = [
+        { $from: 'Doc', $or: [{ Category: 'c1' }, { Value: { $gt: 90 } }, { Category: { $ne: 'c2' } }] },
+        { $from: 'Doc', Category: 'c1', Value: { $gt: 10, $lt: 60 }, $or: [{ Category: 'c1' }, { Category: 'c3' }] },
+        { $join: { $name: 'author', $query: { $from: 'Doc', Category: 'c1' } } },
+        { $join: { $name: 'docs', $query: { $from: 'Person', Group: 'g3' } } },
+        { $join: { $name: 'docs', $query: { $or: [
+            { $join: { $name: 'author', $query: { $from: 'Doc', Value: 5 } } },
+            { $from: 'Person', Group: 'g1' }
+        ] } } }
+    ];
+
+    it('should return same results with query parallelism', function () {
+        queries.forEach(function (query) {
+            var expected = getResult(base.search(query));
+            query.$parallel = 4;
+            assert.deepEqual(getResult(base.search(query)), expected);
+            delete query.$parallel;
+        });
+    })
+    it('should return same results with base parallelism', function () {
+        var expected = queries.map(function (query) { return getResult(base.search(query)); });
+        assert.equal(base.setQueryThreads(3), base);
+        queries.forEach(function (query, i) {
+            assert.deepEqual(getResult(base.search(query)), expected[i]);
+        });
+    })
+    it('should reject non-positive number of threads', function () {
+        assert.throws(function () {
+            base.setQueryThreads(0);
+        });
+        assert.throws(function () {
+            base.search({ $from: 'Doc', Category: 'c1', $parallel: 0 });
+        });
+    })
+});
+
+describe('Query Explain Tests', function () {
+    var base = undefined;
+
+    beforeEach(function () {
+        base = new qm.Base({
+            mode: 'createClean',
+            schema: [{
+                name: 'Doc',
+                fields: [
+                    { name: 'Category', type: 'string' },
+                    { name: 'Value', type: 'int' },
+                    { name: 'Score', type: 'float', null: true }
+                ],
+                keys: [
+                    { field: 'Category', type: 'value' },
+                    { field: 'Value', type: 'linear' },
+                    { field: 'Score', type: 'linear' }
+                ]
+            }]
+        });
+        var docs = base.store('Doc');
+        for (var i = 0; i < 5000; i++) {
+            var rec = { Category: 'c' + (i % 500), Value: i % 1000 };
+            if (i % 3 != 0) { rec.Score = (i % 100) / 10; }
+            docs.push(rec);
+        }
+    });
+    afterEach(function () {
+        base.close();
+    });
+
+    // record ids of the result
+    function getResult(rs) {
+        var res = [];
+        rs.each(function (rec) { res.push(rec.$id); });
+        return res.sort();
+    }
+
+    // record ids matching all the conditions when searched one by one
+    function getExpected(conditions) {
+        var res = null;
+        conditions.forEach(function (condition) {
+            condition.$from = 'Doc';
+            var rs = base.search(condition);
+            res = (res == null) ? rs : res.setIntersect(rs);
+        });
+        return getResult(res);
+    }
+
+    it('should probe wide ranges and return same results', function () {
+        var rs = base.search({ $from: 'Doc', Category: 'c7', Value: { $gt: 10, $lt: 900 }, Score: { $lt: 5 } });
+        var expected = getExpected([{ Category: 'c7' }, { Value: { $gt: 10, $lt: 900 } }, { Score: { $lt: 5 } }]);
+        assert.deepEqual(getResult(rs), expected);
+        assert(expected.length > 0);
+    })
+    it('should describe the executed steps', function () {
+        var explain = base.explain({ $from: 'Doc', Category: 'c7', Value: { $gt: 10, $lt: 900 } });
+        assert.equal(explain.records, base.search({ $from: 'Doc', Category: 'c7', Value: { $gt: 10, $lt: 900 } }).length);
+        assert(explain.time >= 0);
+        var plan = explain.plan;
+        assert.equal(plan.type, 'and');
+        assert.equal(plan.items.length, 2);
+        // most selective condition goes first, range is checked on its records
+        assert.equal(plan.items[0].key, 'Category');
+        assert.equal(plan.items[0].strategy, 'index');
+        assert.equal(plan.items[0].records, 10);
+        assert.equal(plan.items[1].key, 'Value');
+        assert.equal(plan.items[1].strategy, 'probe');
+        assert.equal(plan.items[1].candidates, 10);
+        assert.equal(plan.items[1].records, plan.records);
+    })
+    it('should read narrow ranges from index', function () {
+        var explain = base.explain({ $from: 'Doc', Category: 'c7', Value: { $gt: 7, $lt: 7 } });
+        assert.equal(explain.plan.items[0].key, 'Value');
+        assert.equal(explain.plan.items[0].strategy, 'index');
+        assert.equal(explain.plan.items[0].records, 5);
+        assert.equal(explain.records, 5);
+    })
+});
+
+describe('Geo Cell Index Tests', function () {
+    var base = undefined;
+
+    function ids(rs) {
+        var res = [];
+        for (var i = 0; i < rs.length; i++) { res.push(rs[i].$id); }
+        return res.sort(function (a, b) { return a - b; });
+    }
+
+    beforeEach(function () {
+        base = new qm.Base({ mode: 'createClean' });
+        base.createStore({
+            name: 'GeoTest',
+            fields: [{ name: 'Loc', type: 'float_pair' }],
+            joins: [],
+            keys: [
+                { field: 'Loc', name: 'LocMem', type: 'location' },
+                { field: 'Loc', name: 'LocCell', type: 'location', storage: 'paged' }
+            ]
+        });
+        // 20x20 grid of points, 0.01 degree apart
+        var store = base.store('GeoTest');
+        for (var i = 0; i < 20; i++) {
+            for (var j = 0; j < 20; j++) {
+                store.push({ Loc: [46 + i * 0.01, 14 + j * 0.01] });
+            }
+        }
+    });
+    afterEach(function () {
+        base.close();
+    });
+
+    it('should return same records as in-memory location index', function () {
+        var queries = [
+            { $location: [46.1, 14.1], $radius: 1200, $limit: 1000 },
+            { $location: [46.1, 14.1], $limit: 5 },
+            { $location: [46.0, 14.0], $radius: 5000, $limit: 10 },
+            { $box: [[46.045, 14.045], [46.095, 14.095]] },
+            { $polygon: [[46.005, 14.005], [46.005, 14.2], [46.2, 14.005]] }
+        ];
+        for (var i = 0; i < queries.length; i++) {
+            var mem = base.search({ $from: 'GeoTest', LocMem: queries[i] });
+            var cell = base.search({ $from: 'GeoTest', LocCell: queries[i] });
+            assert.deepEqual(ids(cell), ids(mem));
+        }
+    })
+    it('should return records inside box and polygon', function () {
+        var box = { $box: [[46.045, 14.045], [46.095, 14.095]] };
+        assert.equal(base.search({ $from: 'GeoTest', LocCell: box }).length, 25);
+        var polygon = { $polygon: [[46.005, 14.005], [46.005, 14.2], [46.2, 14.005]] };
+        assert.equal(base.search({ $from: 'GeoTest', LocCell: polygon }).length, 190);
+        polygon.$limit = 10;
+        assert.equal(base.search({ $from: 'GeoTest', LocCell: polygon }).length, 10);
+    })
+    it('should reject invalid area queries', function () {
+        assert.throws(function () {
+            base.search({ $from: 'GeoTest', LocCell: { $box: [[46.1, 14.1], [46.0, 14.0]] } });
+        });
+        assert.throws(function () {
+            base.search({ $from: 'GeoTest', LocCell: { $polygon: [[46.1, 14.1], [46.0, 14.0]] } });
+        });
+    })
+    it('should return records after delete and reopen', function () {
+        var box = { $box: [[46.045, 14.045], [46.095, 14.095]] };
+        // removes first ten rows of the grid, box starts at the sixth
+        base.store('GeoTest').clear(200);
+        assert.equal(base.search({ $from: 'GeoTest', LocCell: box }).length, 0);
+        base.partialFlush();
+        base.close();
+        base = new qm.Base({ mode: 'open' });
+        assert.equal(base.search({ $from: 'GeoTest', LocCell: { $box: [[46.0, 14.0], [47.0, 15.0]] } }).length, 200);
+        base.store('GeoTest').push({ Loc: [46.05, 14.05] });
+        base.close();
+        base = new qm.Base({ mode: 'openReadOnly' });
+        assert.equal(base.search({ $from: 'GeoTest', LocCell: box }).length, 1);
+    })
+});
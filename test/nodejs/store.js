@@ -204,6 +204,127 @@ describe('Store Tests', function () {
         })
     })
 
+    describe('PushBatch Test', function () {
+        it('should add new persons and update existing ones', function () {
+            var ids = table.base.store("People").pushBatch([
+                { "Name": "Jan Rupnik", "Gender": "Male" },
+                { "Name": "Blaz Fortuna", "Gender": "Male" },
+                { "Name": "Mojca Rupnik", "Gender": "Female" },
+                { "Name": "Jan Rupnik", "Gender": "Male" }
+            ]);
+            assert.deepEqual(ids, [2, 1, 3, 2]);
+            assert.equal(table.base.store("People").length, 4);
+            assert.equal(table.base.store("People")[3].Name, "Mojca Rupnik");
+            assert.equal(table.base.store("People")[3].Gender, "Female");
+        })
+        it('should index records the same way as push', function () {
+            var base = new qm.Base({ mode: 'createClean' });
+            var schema = function (name) {
+                return {
+                    "name": name,
+                    "fields": [
+                        { "name": "Title", "type": "string" },
+                        { "name": "Tags", "type": "string_v" },
+                        { "name": "Year", "type": "int" }
+                    ],
+                    "keys": [
+                        { "field": "Title", "type": "text" },
+                        { "field": "Tags", "type": "value" },
+                        { "field": "Year", "type": "linear" }
+                    ]
+                };
+            };
+            base.createStore([schema("Serial"), schema("Batch")]);
+            var recs = [];
+            for (var i = 0; i < 1000; i++) {
+                recs.push({ "Title": "movie " + (i % 7) + " part " + (i % 3),
+                    "Tags": ["t" + (i % 5), "t" + (i % 11)], "Year": 1900 + (i % 100) });
+            }
+            for (var i = 0; i < recs.length; i++) { base.store("Serial").push(recs[i]); }
+            var ids = base.store("Batch").pushBatch(recs);
+            assert.equal(ids.length, 1000);
+            assert.equal(ids[999], 999);
+            var queries = [
+                { "Title": "movie 3" }, { "Title": "part 2" }, { "Tags": "t4" },
+                { "Tags": ["t1", "t10"] }, { "Year": { "$gt": 1990 } }
+            ];
+            queries.forEach(function (query) {
+                query.$from = "Serial";
+                var serial = base.search(query);
+                query.$from = "Batch";
+                var batch = base.search(query);
+                assert.equal(batch.length, serial.length);
+                assert(batch.length > 0);
+                for (var i = 0; i < batch.length; i++) {
+                    assert.equal(batch[i].$id, serial[i].$id);
+                    assert.equal(batch[i].$fq, serial[i].$fq);
+                }
+            });
+            base.close();
+        })
+    })
+
+    describe('SetIndexingDeferred Test', function () {
+        it('should index deferred records the same way as push', function () {
+            var base = new qm.Base({ mode: 'createClean' });
+            var schema = function (name) {
+                return {
+                    "name": name,
+                    "fields": [
+                        { "name": "Title", "type": "string" },
+                        { "name": "Tags", "type": "string_v" },
+                        { "name": "Year", "type": "int" },
+                        { "name": "Rating", "type": "float" }
+                    ],
+                    "keys": [
+                        { "field": "Title", "type": "text" },
+                        { "field": "Tags", "type": "value" },
+                        { "field": "Year", "type": "linear" },
+                        { "field": "Rating", "type": "linear" }
+                    ]
+                };
+            };
+            base.createStore([schema("Serial"), schema("Deferred")]);
+            var recs = [];
+            for (var i = 0; i < 3000; i++) {
+                recs.push({ "Title": "movie " + i + " part " + (i % 7),
+                    "Tags": ["t" + (i % 5), "t" + (i % 11)], "Year": 1900 + (i % 100), "Rating": (i % 37) / 3 });
+            }
+            for (var i = 0; i < recs.length; i++) { base.store("Serial").push(recs[i]); }
+            var store = base.store("Deferred");
+            // first records are indexed as usual
+            for (var i = 0; i < 100; i++) { store.push(recs[i]); }
+            store.setIndexingDeferred(true);
+            for (var i = 100; i < 2000; i++) { store.push(recs[i]); }
+            store.pushBatch(recs.slice(2000));
+            // deferred records are not indexed yet
+            assert(base.search({ $from: "Deferred", "Year": { "$gt": 1950 } }).length < 100);
+            assert.equal(base.search({ $from: "Deferred", "Title": "movie 2500" }).length, 0);
+            store.setIndexingDeferred(false);
+            var queries = [
+                { "Title": "movie 3" }, { "Title": "part 2" }, { "Tags": "t4" },
+                { "Tags": ["t1", "t10"] }, { "Year": { "$gt": 1990 } },
+                { "Rating": { "$gt": 2, "$lt": 5 } }
+            ];
+            queries.forEach(function (query) {
+                query.$from = "Serial";
+                var serial = base.search(query);
+                query.$from = "Deferred";
+                var deferred = base.search(query);
+                assert.equal(deferred.length, serial.length);
+                assert(deferred.length > 0);
+                for (var i = 0; i < deferred.length; i++) {
+                    assert.equal(deferred[i].$id, serial[i].$id);
+                    assert.equal(deferred[i].$fq, serial[i].$fq);
+                }
+            });
+            // new records are indexed right away again
+            store.push(recs[0]);
+            assert.equal(base.search({ $from: "Deferred", "Title": "movie 0" }).length, 2);
+            base.close();
+        })
+    })
+
     describe('ForwardIter Test', function () {
         it('should go through the persons in store', function () {
             var PeopleIter = table.base.store("People").forwardIter;
@@ -635,6 +756,68 @@ describe("Two Store Tests", function () {
             var filename = "./sandbox/movies/movies_data.txt"
             assert.equal(table.base.store("Movies").loadJson(filename), 167);
         })
+        it('should import limited number of movies', function () {
+            var filename = "./sandbox/movies/movies_data.txt"
+            assert.equal(table.base.store("Movies").loadJson(filename, 10), 10);
+            assert.equal(table.base.store("Movies").length, 10);
+        })
+        it('should load typed values from a CSV file', function () {
+            var fout = qm.fs.openWrite("./sandbox/store_load.csv");
+            fout.writeLine("Name,Age,Skip,Weight,Alive");
+            fout.writeLine("\"Lovecraft, H. P.\",46,x,70.5,false");
+            fout.writeLine("\"Poe \"\"Edgar\"\" Allan\",40,y,,true");
+            fout.writeLine("Wilde,46,z,80,1");
+            fout.close();
+            var base = new qm.Base({ mode: 'createClean' });
+            base.createStore({
+                "name": "Writers",
+                "fields": [
+                    { "name": "Name", "type": "string" },
+                    { "name": "Age", "type": "int" },
+                    { "name": "Weight", "type": "float", "null": true },
+                    { "name": "Alive", "type": "bool" }
+                ],
+                "keys": [{ "field": "Age", "type": "linear" }]
+            });
+            var store = base.store("Writers");
+            var progress = 0;
+            var recs = store.load({ file: "./sandbox/store_load.csv", format: "csv",
+                batchSize: 2, onProgress: function (recs) { progress = recs; } });
+            assert.equal(recs, 3);
+            assert.equal(progress, 3);
+            assert.equal(store[0].Name, "Lovecraft, H. P.");
+            assert.equal(store[0].Age, 46);
+            assert.equal(store[0].Weight, 70.5);
+            assert.equal(store[0].Alive, false);
+            assert.equal(store[1].Name, "Poe \"Edgar\" Allan");
+            assert.equal(store[1].Weight, null);
+            assert.equal(store[2].Alive, true);
+            assert.equal(base.search({ $from: "Writers", Age: { $gt: 45 } }).length, 2);
+            base.close();
+        })
+        it('should report the failing line', function () {
+            var fout = qm.fs.openWrite("./sandbox/store_load.json");
+            fout.writeLine(JSON.stringify({ Title: "Good", Plot: "", Year: 2000, Rating: 1, Genres: [], Director: { Name: "X", Gender: "Male" }, Actor: [] }));
+            fout.writeLine("{ bad json");
+            fout.close();
+            assert.throws(function () {
+                table.base.store("Movies").load({ file: "./sandbox/store_load.json" });
+            }, /line 2/);
+        })
+        it('should load records asynchronously', function (done) {
+            var filename = "./sandbox/movies/movies_data.txt"
+            var store = table.base.store("Movies");
+            store.loadAsync({ file: filename, batchSize: 50 }, function (err, recs) {
+                if (err) { return done(err); }
+                try {
+                    assert.equal(recs, 167);
+                    assert.equal(store.length, 167);
+                    done();
+                } catch (e) {
+                    done(e);
+                }
+            });
+        })
     })
 
     describe('GetMatrix Test', function () {
@@ -1078,6 +1261,74 @@ describe('Schema Time Window Test', function () {
         base.close();
     });
 
+    describe('Testing timeWindow with segments (size: 4h, segment: 1h)', function () {
+        function createBase() {
+            var base = new qm.Base({ mode: 'createClean' });
+            base.createStore({
+                "name": "TestStore",
+                "fields": [
+                    { "name": "DateTime", "type": "datetime" },
+                    { "name": "Tag", "type": "string" }
+                ],
+                "keys": [
+                    { "field": "Tag", "type": "value" }
+                ],
+                timeWindow: {
+                    duration: 4,
+                    unit: "hour",
+                    field: "DateTime",
+                    segment: { duration: 1 }
+                }
+            });
+            // two records per hour, one of them arrives late
+            var start = new Date("2015-06-01T00:00:00.000Z").getTime();
+            for (var i = 0; i < 20; i++) {
+                var time = i != 10 ? start + i * 30 * 60 * 1000 : start + 60 * 60 * 1000;
+                base.store("TestStore").push({ DateTime: new Date(time).toISOString(), Tag: "t" + (i % 2) });
+            }
+            return base;
+        }
+
+        it('should filter records by time', function () {
+            var base = createBase();
+            var recs = base.store("TestStore").allRecords;
+            recs.filterByField("DateTime", "2015-06-01T01:00:00", "2015-06-01T03:59:59");
+            assert.equal(recs.length, 7);
+            base.close();
+        });
+        it('should delete records out of window with .garbageCollect()', function () {
+            var base = createBase();
+            base.garbageCollect();
+            // last record sets the end of window, so records from 05:30 on are kept
+            var store = base.store("TestStore");
+            assert.equal(store.length, 9);
+            assert.equal(store.first.DateTime.toISOString(), "2015-06-01T05:30:00.000Z");
+            assert.equal(base.search({ $from: "TestStore", Tag: "t0" }).length, 4);
+            assert.equal(base.search({ $from: "TestStore", Tag: "t1" }).length, 5);
+            base.close();
+        });
+        it('should keep segments after reopening the base', function () {
+            var base = createBase();
+            base.close();
+            base = new qm.Base({ mode: 'open' });
+            var recs = base.store("TestStore").allRecords;
+            recs.filterByField("DateTime", "2015-06-01T08:00:00", null);
+            assert.equal(recs.length, 4);
+            base.close();
+        });
+        it('should not accept segment without duration', function () {
+            var base = new qm.Base({ mode: 'createClean' });
+            assert.throws(function () {
+                base.createStore({
+                    "name": "TestStore",
+                    "fields": [{ "name": "DateTime", "type": "datetime" }],
+                    timeWindow: { duration: 4, unit: "hour", field: "DateTime", segment: { unit: "hour" } }
+                });
+            });
+            base.close();
+        });
+    });
+
     describe('Testing window garbage collection timeout', function () {
         // generate store with window 3
         base = new qm.Base({ mode: 'createClean' });
@@ -0,0 +1,150 @@
+/**
+ * Copyright (c) 2015, Jozef Stefan Institute, Quintelligence d.o.o. and contributors
+ * All rights reserved.
+ *
+ * This source code is licensed under the FreeBSD license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+var assert = require('../../src/nodejs/scripts/assert.js');     //adds assert.run function
+var qm = require('qminer');
+
+//////////////////////////////////////////////////////////////////////////////////////
+// Store creation
+
+var store_name = "test_store";
+function GetStoreTemplate() {
+    var res = {
+        "name": store_name,
+        "fields": [
+            { "name": "name", "type": "string" },
+            { "name": "val", "type": "int", "store": "column" },
+            { "name": "flt", "type": "float", "null": true },
+            { "name": "tm", "type": "datetime" },
+            { "name": "flag", "type": "bool", "default": true }
+        ],
+        "keys": [
+            { "field": "name", "type": "value" }
+        ],
+        "options": {
+            "storage_location": "column"
+        }
+    };
+    return res;
+}
+
+function FillStore(store) {
+    for (var i = 0; i < 100; i++) {
+        var rec = { name: "rec" + i, val: 100 - i, tm: 1000 * i };
+        if (i % 10 != 0) { rec.flt = i / 2; }
+        if (i % 2 == 0) { rec.flag = false; }
+        store.push(rec);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+
+describe('Columnar field-location tests ', function () {
+    it('should store and read records from columns', function () {
+        var db = new qm.Base({ mode: 'createClean' });
+        db.createStore(GetStoreTemplate());
+        var store = db.store(store_name);
+        FillStore(store);
+        assert.equal(store.length, 100);
+        assert.equal(store[5].name, "rec5");
+        assert.equal(store[5].val, 95);
+        assert.equal(store[5].flt, 2.5);
+        assert.equal(store[5].tm.getTime(), 5000);
+        assert.equal(store[5].flag, true);
+        assert.equal(store[4].flag, false);
+        assert.equal(store[10].flt, null);
+        // update
+        store.push({ name: "rec5", val: -5 });
+        assert.equal(store[5].val, -5);
+        store[6].flt = 100;
+        assert.equal(store[6].flt, 100);
+        db.close();
+    });
+    it('should reject columns for variable-width fields', function () {
+        var db = new qm.Base({ mode: 'createClean' });
+        var template = GetStoreTemplate();
+        template.fields[0].store = "column";
+        assert.throws(function () { db.createStore(template); });
+        db.close();
+    });
+    it('should filter and sort using columns', function () {
+        var db = new qm.Base({ mode: 'createClean' });
+        db.createStore(GetStoreTemplate());
+        var store = db.store(store_name);
+        FillStore(store);
+        var rs = store.allRecords;
+        rs.filterByField("val", 10, 19);
+        assert.equal(rs.length, 10);
+        rs.sortByField("val", 1);
+        assert.equal(rs[0].val, 10);
+        assert.equal(rs[9].val, 19);
+        // null values are filtered out
+        var rs2 = store.allRecords;
+        rs2.filterByField("flt", 0, 10);
+        assert.equal(rs2.length, 18);
+        // time
+        var rs3 = store.allRecords;
+        rs3.filterByField("tm", 10000, 19000);
+        assert.equal(rs3.length, 10);
+        db.close();
+    });
+    it('should reject deleted records when filtering columns', function () {
+        var db = new qm.Base({ mode: 'createClean' });
+        db.createStore(GetStoreTemplate());
+        var store = db.store(store_name);
+        FillStore(store);
+        var rs = store.allRecords;
+        store.clear(10);
+        // first ten records of the set are no longer in the column
+        assert.throws(function () { rs.filterByField("val", 0, 1000); });
+        assert.throws(function () { rs.filterByField("flt", 0, 1000); });
+        var rs2 = store.allRecords;
+        rs2.filterByField("val", 0, 1000);
+        assert.equal(rs2.length, 90);
+        db.close();
+    });
+    it('should extract features from columns', function () {
+        var db = new qm.Base({ mode: 'createClean' });
+        db.createStore(GetStoreTemplate());
+        var store = db.store(store_name);
+        FillStore(store);
+        var ftr = new qm.FeatureSpace(db, [
+            { type: "numeric", source: store_name, field: "val" },
+            { type: "categorical", source: store_name, field: "name" },
+            { type: "numeric", source: store_name, field: "flt" }
+        ]);
+        var rs = store.allRecords;
+        ftr.updateRecords(rs);
+        var mat = ftr.extractMatrix(rs);
+        assert.equal(mat.rows, ftr.dim);
+        assert.equal(mat.cols, 100);
+        for (var i = 0; i < 100; i++) {
+            var vec = ftr.extractVector(rs[i]);
+            for (var j = 0; j < ftr.dim; j++) {
+                assert.equal(mat.at(j, i), vec[j]);
+            }
+        }
+        db.close();
+    });
+    it('should save and load columns', function () {
+        var db = new qm.Base({ mode: 'createClean' });
+        db.createStore(GetStoreTemplate());
+        FillStore(db.store(store_name));
+        db.store(store_name).clear(50);
+        db.close();
+        db = new qm.Base({ mode: 'open' });
+        var store = db.store(store_name);
+        assert.equal(store.length, 50);
+        assert.equal(store.first.val, 50);
+        assert.equal(store.last.val, 1);
+        store.push({ name: "new", val: 1000, tm: 0 });
+        assert.equal(store.last.val, 1000);
+        assert.equal(store.last.flag, true);
+        db.close();
+    });
+})
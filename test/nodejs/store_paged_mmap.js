@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2015, Jozef Stefan Institute, Quintelligence d.o.o. and contributors
+ * All rights reserved.
+ *
+ * This source code is licensed under the FreeBSD license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+var assert = require('../../src/nodejs/scripts/assert.js');     //adds assert.run function
+var qm = require('qminer');
+
+//////////////////////////////////////////////////////////////////////////////////////
+// Store creation
+
+var store_name = "test_store";
+function GetStoreTemplate() {
+    var res = {
+        "name": store_name,
+        "fields": [
+            { "name": "name", "type": "string", "primary": true },
+            { "name": "val", "type": "int" },
+            { "name": "txt", "type": "string" }
+        ],
+        "keys": [
+            { "field": "val", "type": "linear" }
+        ],
+        "options": {
+            "type": "paged",
+            "mmap": true,
+            "storage_location": "cache"
+        }
+    };
+    return res;
+}
+
+function FillStore(store) {
+    for (var i = 0; i < 1000; i++) {
+        store.push({ name: "rec" + i, val: i, txt: new Array(1 + i % 50).join("x") });
+    }
+}
+
+function CheckStore(db) {
+    var store = db.store(store_name);
+    assert.equal(store.length, 1000);
+    for (var i = 0; i < 1000; i += 7) {
+        assert.equal(store[i].name, "rec" + i);
+        assert.equal(store[i].val, i);
+        assert.equal(store[i].txt.length, i % 50);
+    }
+    var rs = db.search({ $from: store_name, val: { $gt: 10, $lt: 19 } });
+    assert.equal(rs.length, 10);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+
+describe('Memory-mapped paged store tests ', function () {
+    it('should store and read records', function () {
+        var db = new qm.Base({ mode: 'createClean' });
+        db.createStore(GetStoreTemplate());
+        var store = db.store(store_name);
+        FillStore(store);
+        CheckStore(db);
+        // update
+        store[5].val = -5;
+        assert.equal(store[5].val, -5);
+        db.close();
+    });
+    it('should flush, close and reopen', function () {
+        var db = new qm.Base({ mode: 'createClean' });
+        db.createStore(GetStoreTemplate());
+        FillStore(db.store(store_name));
+        db.partialFlush();
+        db.close();
+        db = new qm.Base({ mode: 'open' });
+        CheckStore(db);
+        db.store(store_name).push({ name: "new", val: 1000, txt: "new" });
+        db.close();
+        db = new qm.Base({ mode: 'openReadOnly' });
+        var store = db.store(store_name);
+        assert.equal(store.length, 1001);
+        assert.equal(store.last.txt, "new");
+        db.close();
+    });
+})
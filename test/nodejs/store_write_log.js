@@ -0,0 +1,158 @@
+/**
+ * Copyright (c) 2015, Jozef Stefan Institute, Quintelligence d.o.o. and contributors
+ * All rights reserved.
+ *
+ * This source code is licensed under the FreeBSD license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+var assert = require('../../src/nodejs/scripts/assert.js');     //adds assert.run function
+var qm = require('qminer');
+
+//////////////////////////////////////////////////////////////////////////////////////
+// Store creation
+
+var store_name = "test_store";
+function GetStoreTemplate(checkpoint) {
+    var res = {
+        "name": store_name,
+        "fields": [
+            { "name": "name", "type": "string", "primary": true },
+            { "name": "val", "type": "int" },
+            { "name": "txt", "type": "string" }
+        ],
+        "options": {
+            "block_size_mem": 10,
+            "write_log": true,
+            "write_log_checkpoint": checkpoint
+        }
+    };
+    return res;
+}
+
+function FillStore(store, start, end) {
+    for (var i = start; i < end; i++) {
+        store.push({ name: "rec" + i, val: i, txt: new Array(1 + i % 50).join("x") });
+    }
+}
+
+function CheckStore(db, recs) {
+    var store = db.store(store_name);
+    assert.equal(store.length, recs);
+    for (var i = 0; i < recs; i += 7) {
+        assert.equal(store[i].name, "rec" + i);
+        assert.equal(store[i].txt.length, i % 50);
+        assert.equal(store.recordByName("rec" + i).$id, i);
+    }
+    assert.equal(store[3].val, -3);
+    assert.equal(store.recordByName("renamed").$id, 4);
+    assert.equal(store.recordByName("rec4"), null);
+}
+
+function UpdateStore(store) {
+    store[3].val = -3;
+    store.push({ name: "rec4", val: 4 });
+    store[4].name = "renamed";
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+
+describe('Write-ahead log store tests ', function () {
+    it('should restore records and primary keys from the log', function () {
+        var db = new qm.Base({ mode: 'createClean' });
+        db.createStore(GetStoreTemplate(64));
+        var store = db.store(store_name);
+        FillStore(store, 0, 500);
+        db.partialFlush();
+        FillStore(store, 500, 1000);
+        UpdateStore(store);
+        CheckStore(db, 1000);
+        db.close();
+        db = new qm.Base({ mode: 'open' });
+        CheckStore(db, 1000);
+        FillStore(db.store(store_name), 1000, 1010);
+        db.close();
+        db = new qm.Base({ mode: 'openReadOnly' });
+        CheckStore(db, 1010);
+        assert.equal(db.store(store_name).allRecords.length, 1010);
+        db.close();
+    });
+    it('should checkpoint and reopen', function () {
+        var db = new qm.Base({ mode: 'createClean' });
+        db.createStore(GetStoreTemplate(0));
+        var store = db.store(store_name);
+        FillStore(store, 0, 1000);
+        UpdateStore(store);
+        // all blocks fit into the flush window, so the log is removed
+        db.partialFlush();
+        FillStore(store, 1000, 1010);
+        db.close();
+        db = new qm.Base({ mode: 'open' });
+        CheckStore(db, 1010);
+        db.close();
+    });
+    it('should restore records when the base was not closed', function () {
+        var db = new qm.Base({ mode: 'createClean' });
+        var template = GetStoreTemplate(64);
+        template.options.write_log_commit = 0;
+        db.createStore(template);
+        FillStore(db.store(store_name), 0, 500);
+        db.close();
+        // another process changes the store and is killed before it closes the base
+        var script = [
+            "var qm = require(" + JSON.stringify(require.resolve('qminer')) + ");",
+            FillStore.toString(),
+            UpdateStore.toString(),
+            "var db = new qm.Base({ mode: 'open' });",
+            "var store = db.store('" + store_name + "');",
+            "FillStore(store, 500, 800);",
+            "db.partialFlush();",
+            "FillStore(store, 800, 1000);",
+            "UpdateStore(store);",
+            "process.kill(process.pid, 'SIGKILL');"
+        ].join('\n');
+        var child = require('child_process').spawnSync(process.execPath, ['-e', script]);
+        assert.equal(child.signal, 'SIGKILL');
+        db = new qm.Base({ mode: 'restore' });
+        CheckStore(db, 1000);
+        var store = db.store(store_name);
+        assert.equal(store.allRecords.length, 1000);
+        assert.equal(store.recordByName("rec999").val, 999);
+        FillStore(store, 1000, 1010);
+        db.close();
+        db = new qm.Base({ mode: 'open' });
+        CheckStore(db, 1010);
+        db.close();
+    });
+    it('should reject write_log for stores with state saved only when closing', function () {
+        var db = new qm.Base({ mode: 'createClean' });
+        var keys = GetStoreTemplate(64);
+        keys.keys = [{ "field": "val", "type": "linear" }];
+        assert.throws(function () { db.createStore(keys); });
+        var codebook = GetStoreTemplate(64);
+        codebook.fields[2].codebook = true;
+        assert.throws(function () { db.createStore(codebook); });
+        var cache = GetStoreTemplate(64);
+        cache.fields[1].store = "cache";
+        assert.throws(function () { db.createStore(cache); });
+        var column = GetStoreTemplate(64);
+        column.fields[1].store = "column";
+        assert.throws(function () { db.createStore(column); });
+        db.close();
+    });
+    it('should commit the log while the store is idle', function (done) {
+        var fs = require('fs');
+        var db = new qm.Base({ mode: 'createClean' });
+        var template = GetStoreTemplate(64);
+        template.options.write_log_commit = 100;
+        db.createStore(template);
+        FillStore(db.store(store_name), 0, 10);
+        // no more changes come in, the pending entries are committed anyway
+        setTimeout(function () {
+            var size = fs.statSync('./db/' + store_name + '.MemCache.Log0').size;
+            db.close();
+            assert(size > 0);
+            done();
+        }, 500);
+    });
+})
@@ -4281,6 +4281,149 @@ describe('Nearest Neighbor Anomaly Detection Tests', function () {
     });
 });
 
+describe('Online KMeans Tests', function () {
+    var base = undefined;
+    var store = undefined;
+    beforeEach(function () {
+        base = new qm.Base({
+            mode: 'createClean',
+            schema: [{
+                name: 'Points',
+                fields: [
+                    { name: 'X', type: 'float' },
+                    { name: 'Y', type: 'float' },
+                    { name: 'Time', type: 'datetime' }
+                ]
+            }]
+        });
+        store = base.store('Points');
+
+        var aggr = {
+            name: 'ftrSpaceAggr',
+            type: 'featureSpace',
+            update: false,
+            featureSpace: [
+                { type: 'numeric', source: 'Points', field: 'X' },
+                { type: 'numeric', source: 'Points', field: 'Y' }
+            ]
+        };
+        store.addStreamAggr(aggr);
+    });
+    afterEach(function () {
+        base.close();
+    });
+
+    describe('Constructor Tests', function () {
+        it('should create a new online KMeans aggregator', function () {
+            var aggr = {
+                name: 'kmeansAggr',
+                type: 'onlineKMeans',
+                inAggr: 'ftrSpaceAggr',
+                k: 2,
+                decay: 0.9
+            };
+            var kmeans = store.addStreamAggr(aggr);
+            assert.equal(kmeans.name, 'kmeansAggr');
+            assert(!kmeans.init);
+            assert.equal(kmeans.getInteger(), -1);
+        })
+        it('should throw an exception if the input aggregator does not return vectors', function () {
+            store.addStreamAggr({
+                name: 'tickAggr',
+                type: 'timeSeriesTick',
+                store: 'Points',
+                timestamp: 'Time',
+                value: 'X'
+            });
+            assert.throws(function () {
+                store.addStreamAggr({ name: 'kmeansAggr', type: 'onlineKMeans', inAggr: 'tickAggr', k: 2 });
+            });
+        })
+        it('should throw an exception if decay is not in (0, 1]', function () {
+            assert.throws(function () {
+                store.addStreamAggr({ name: 'kmeansAggr', type: 'onlineKMeans', inAggr: 'ftrSpaceAggr', k: 2, decay: 0 });
+            });
+        })
+    });
+    describe('Pass data through the online KMeans aggregator', function () {
+        it('should assign the records to the clusters', function () {
+            var kmeans = store.addStreamAggr({ name: 'kmeansAggr', type: 'onlineKMeans', inAggr: 'ftrSpaceAggr', k: 2 });
+
+            store.push({ X: 0, Y: 0, Time: '2016-09-07T12:00:00' });
+            assert.equal(kmeans.getInteger(), 0);
+            assert(!kmeans.init);
+            store.push({ X: 10, Y: 10, Time: '2016-09-07T12:01:00' });
+            assert.equal(kmeans.getInteger(), 1);
+            assert(kmeans.init);
+            store.push({ X: 2, Y: 0, Time: '2016-09-07T12:02:00' });
+            assert.equal(kmeans.getInteger(), 0);
+            store.push({ X: 12, Y: 8, Time: '2016-09-07T12:03:00' });
+            assert.equal(kmeans.getInteger(), 1);
+
+            var json = kmeans.saveJson();
+            assert.deepEqual(json.centroids, [[1, 0], [11, 9]]);
+            assert.deepEqual(json.counts, [2, 2]);
+            assert.equal(json.cluster, 1);
+        })
+        it('should use the records that entered the window as a batch', function () {
+            store.addStreamAggr({
+                name: 'winBufAggr',
+                type: 'timeSeriesWinBufFeatureSpace',
+                store: 'Points',
+                timestamp: 'Time',
+                winsize: 60000,
+                featureSpace: [
+                    { type: 'numeric', source: 'Points', field: 'X' },
+                    { type: 'numeric', source: 'Points', field: 'Y' }
+                ]
+            });
+            var kmeans = store.addStreamAggr({ name: 'kmeansAggr', type: 'onlineKMeans', inAggr: 'winBufAggr', k: 2 });
+
+            store.push({ X: 0, Y: 0, Time: '2016-09-07T12:00:00' });
+            store.push({ X: 10, Y: 10, Time: '2016-09-07T12:01:00' });
+            store.push({ X: 9, Y: 11, Time: '2016-09-07T12:02:00' });
+            assert.equal(kmeans.getInteger(), 1);
+            assert.deepEqual(kmeans.saveJson().centroids, [[0, 0], [9.5, 10.5]]);
+        })
+    });
+    describe('Save and load tests for the online KMeans aggregator', function () {
+        it('should save and load the online KMeans aggregator', function () {
+            var kmeans = store.addStreamAggr({ name: 'kmeansAggr', type: 'onlineKMeans', inAggr: 'ftrSpaceAggr', k: 2, decay: 0.9 });
+
+            store.push({ X: 0, Y: 0, Time: '2016-09-07T12:00:00' });
+            store.push({ X: 10, Y: 10, Time: '2016-09-07T12:01:00' });
+            store.push({ X: 1, Y: 1, Time: '2016-09-07T12:02:00' });
+            var json = kmeans.saveJson();
+
+            var fs = require('qminer').fs;
+            var fout = new fs.FOut('./onlineKMeans.bin');
+            kmeans.save(fout);
+            fout.close();
+            kmeans.reset();
+            var fin = new fs.FIn('./onlineKMeans.bin');
+            kmeans.load(fin);
+
+            assert(kmeans.init);
+            assert.equal(kmeans.getInteger(), 0);
+            assert.deepEqual(kmeans.saveJson(), json);
+        })
+    });
+    describe('Reset the online KMeans aggregator', function () {
+        it('should reset the online KMeans aggregator', function () {
+            var kmeans = store.addStreamAggr({ name: 'kmeansAggr', type: 'onlineKMeans', inAggr: 'ftrSpaceAggr', k: 2 });
+
+            store.push({ X: 0, Y: 0, Time: '2016-09-07T12:00:00' });
+            store.push({ X: 10, Y: 10, Time: '2016-09-07T12:01:00' });
+            assert(kmeans.init);
+
+            store.resetStreamAggregates();
+            assert(!kmeans.init);
+            assert.equal(kmeans.getInteger(), -1);
+            assert.deepEqual(kmeans.saveJson().centroids, []);
+        })
+    });
+});
+
 describe('Online Histogram Tests', function () {
     var base = undefined;
     var store = undefined;
@@ -6992,3 +7135,73 @@ describe('HistogramAD Tests', function () {
     });
 
 });
+
+describe('Parallel stream aggregate updates', function () {
+    var base = undefined;
+    beforeEach(function () {
+        base = new qm.Base({
+            mode: 'createClean',
+            schema: [
+                { name: 'Serial', fields: [{ name: 'Time', type: 'datetime' }, { name: 'Value', type: 'float' }] },
+                { name: 'Parallel', fields: [{ name: 'Time', type: 'datetime' }, { name: 'Value', type: 'float' }] }
+            ]
+        });
+    });
+    afterEach(function () {
+        base.close();
+    });
+    function addAggregates(store) {
+        var name = store.name;
+        var aggrs = {};
+        aggrs.tick = store.addStreamAggr({ name: name + 'Tick', type: 'timeSeriesTick', timestamp: 'Time', value: 'Value' });
+        aggrs.ema = store.addStreamAggr({ name: name + 'Ema', type: 'ema', inAggr: name + 'Tick', emaType: 'previous', interval: 3000, initWindow: 1000 });
+        aggrs.winBuf = store.addStreamAggr({ name: name + 'WinBuf', type: 'timeSeriesWinBuf', timestamp: 'Time', value: 'Value', winsize: 2000 });
+        aggrs.ma = store.addStreamAggr({ name: name + 'Ma', type: 'ma', inAggr: name + 'WinBuf' });
+        aggrs.sum = store.addStreamAggr({ name: name + 'Sum', type: 'winBufSum', inAggr: name + 'WinBuf' });
+        // javascript aggregate reads the moving average after it was updated
+        aggrs.js = store.addStreamAggr(new function () {
+            var maSum = 0;
+            this.onAdd = function (rec) { maSum += aggrs.ma.getFloat(); };
+            this.getFloat = function () { return maSum; };
+        });
+        return aggrs;
+    }
+    it('should give the same results as serial updates', function () {
+        var serial = addAggregates(base.store('Serial'));
+        var parallel = addAggregates(base.store('Parallel'));
+        base.store('Parallel').setParallelStreamAggregates(true);
+        for (var i = 0; i < 200; i++) {
+            var rec = { Time: 1000 * i, Value: Math.sin(i / 10) + i % 7 };
+            base.store('Serial').push(rec);
+            base.store('Parallel').push(rec);
+        }
+        var names = ['tick', 'ema', 'ma', 'sum', 'js'];
+        for (var i = 0; i < names.length; i++) {
+            assert.equal(parallel[names[i]].getFloat(), serial[names[i]].getFloat());
+        }
+        assert.equal(base.store('Parallel').getStreamAggrNames().length, 6);
+    });
+    it('should keep histograms on a window buffer in serial order', function () {
+        function addHistograms(store) {
+            var name = store.name;
+            var aggrs = {};
+            aggrs.winBuf = store.addStreamAggr({ name: name + 'WinBuf', type: 'timeSeriesWinBuf', timestamp: 'Time', value: 'Value', winsize: 5000 });
+            aggrs.winBufLong = store.addStreamAggr({ name: name + 'WinBufLong', type: 'timeSeriesWinBuf', timestamp: 'Time', value: 'Value', winsize: 20000 });
+            aggrs.hist = store.addStreamAggr({ name: name + 'Hist', type: 'onlineHistogram', inAggr: name + 'WinBuf', lowerBound: 0, upperBound: 10, bins: 10 });
+            aggrs.histLong = store.addStreamAggr({ name: name + 'HistLong', type: 'onlineHistogram', inAggr: name + 'WinBufLong', lowerBound: 0, upperBound: 10, bins: 10 });
+            aggrs.diff = store.addStreamAggr({ name: name + 'Diff', type: 'onlineVecDiff', storeX: name, storeY: name, inAggrX: name + 'HistLong', inAggrY: name + 'Hist' });
+            return aggrs;
+        }
+        var serial = addHistograms(base.store('Serial'));
+        var parallel = addHistograms(base.store('Parallel'));
+        base.store('Parallel').setParallelStreamAggregates(true);
+        for (var i = 0; i < 200; i++) {
+            var rec = { Time: 1000 * i, Value: (i * 7) % 11 };
+            base.store('Serial').push(rec);
+            base.store('Parallel').push(rec);
+            assert.deepEqual(parallel.hist.saveJson().counts, serial.hist.saveJson().counts);
+            assert.deepEqual(parallel.histLong.saveJson().counts, serial.histLong.saveJson().counts);
+            assert.deepEqual(parallel.diff.saveJson().diff, serial.diff.saveJson().diff);
+        }
+    });
+});